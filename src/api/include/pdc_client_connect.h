@@ -144,14 +144,16 @@ struct _pdc_get_kvtag_args {
 };
 
 struct _pdc_query_result_list {
-    uint32_t  ndim;
-    int       query_id;
-    uint64_t  nhits;
-    uint64_t *coords;
-    void *    data;
-    void **   data_arr;
-    uint64_t *data_arr_size;
-    uint64_t  recv_data_nhits;
+    uint32_t        ndim;
+    int             query_id;
+    uint64_t        nhits;
+    uint64_t *      coords;
+    void *          data;
+    void **         data_arr;
+    uint64_t *      data_arr_size;
+    uint64_t        recv_data_nhits;
+    pdc_query_agg_t agg;
+    uint64_t        n_agg_fail; // Servers that could not aggregate all of their hits
 
     struct _pdc_query_result_list *prev;
     struct _pdc_query_result_list *next;
@@ -220,13 +222,14 @@ perr_t PDC_Client_send_name_recv_id(const char *obj_name, uint64_t cont_id, pdci
 
 perr_t PDC_Client_transfer_request(void *buf, pdcid_t obj_id, uint32_t data_server_id, int obj_ndim,
                                    uint64_t *obj_dims, int remote_ndim, uint64_t *remote_offset,
-                                   uint64_t *remote_size, size_t unit, pdc_access_t access_type,
-                                   pdcid_t *metadata_id);
+                                   uint64_t *remote_size, size_t unit, pdc_var_type_t obj_type,
+                                   pdc_access_t access_type, pdcid_t *metadata_id);
 
 int PDC_Client_get_var_type_size(pdc_var_type_t dtype);
 
 perr_t PDC_Client_transfer_request_all(int n_objs, pdc_access_t access_type, uint32_t data_server_id,
-                                       char *bulk_buf, hg_size_t bulk_size, uint64_t *metadata_id);
+                                       int n_segments, char **segments, hg_size_t *segment_sizes,
+                                       hg_size_t bulk_size, uint64_t *metadata_id);
 
 perr_t PDC_Client_transfer_request_metadata_query(char *buf, uint64_t total_buf_size, int n_objs,
                                                   uint32_t metadata_server_id, uint8_t is_write,
@@ -676,6 +679,17 @@ perr_t PDC_Client_create_cont_id_mpi(const char *cont_name, pdcid_t cont_create_
  */
 perr_t PDC_Client_query_kvtag(const pdc_kvtag_t *kvtag, int *n_res, uint64_t **pdc_ids);
 
+/**
+ * Client sends a numeric range query on a kvtag to all servers
+ *
+ * \param range [IN]            Name, value type and bounds of the range
+ * \param n_res [OUT]           Number of hits
+ * \param pdc_ids [OUT]         Object ids of hits
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_query_kvtag_range(const pdc_kvtag_range_t *range, int *n_res, uint64_t **pdc_ids);
+
 #ifdef ENABLE_MPI
 /**
  * Client sends query requests to server (used by MPI mode), all clients get the same aggregated
@@ -710,13 +724,14 @@ perr_t PDC_Client_query_name_read_entire_obj_client_agg_cache_iter(int my_nobj,
  *
  * \param query [IN]            *********
  * \param get_op [IN]           *********
+ * \param obj_id [IN]           Global ID of the object reduced by PDC_QUERY_GET_AGG, 0 otherwise
  * \param nhits [IN]            *********
  * \param sel [IN]              *********
- * \param data [IN]             *********
+ * \param data [IN]             pdc_query_agg_t receiving the result of PDC_QUERY_GET_AGG
  *
  * \return Non-negative on success/Negative on failure
  */
-perr_t PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t *nhits,
+perr_t PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t obj_id, uint64_t *nhits,
                            pdc_selection_t *sel, void *data);
 
 /**
@@ -728,6 +743,15 @@ perr_t PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64
  */
 hg_return_t PDC_recv_coords(const struct hg_cb_info *callback_info);
 
+/**
+ * Receive the aggregate of a PDC_QUERY_GET_AGG query from its manager
+ *
+ * \param callback_info [IN]    Mercury callback info
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+hg_return_t PDC_recv_query_agg(const struct hg_cb_info *callback_info);
+
 /**
  * ********
  *
@@ -739,6 +763,43 @@ hg_return_t PDC_recv_coords(const struct hg_cb_info *callback_info);
  */
 perr_t PDC_Client_get_sel_data(pdcid_t obj_id, pdc_selection_t *sel, void *data);
 
+/**
+ * Evaluate a query and keep its result on the servers, to be fetched in pieces. Each server keeps the hits
+ * it found, the cursor learns how many from each of them.
+ *
+ * \param query [IN]            Query
+ * \param cursor [OUT]          Cursor on the result
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_query_cursor_open(pdc_query_t *query, pdc_query_cursor_t *cursor);
+
+/**
+ * Fetch the next hits of a cursor, as coordinates or as the data of an object. The pieces of consecutive
+ * servers are fetched from each of them in turn until max_cnt hits or buf_size bytes.
+ *
+ * \param cursor [IN/OUT]       Cursor, moved past the hits fetched
+ * \param obj_id [IN]           0 for ndim coordinates per hit, otherwise the global ID of the object to read
+ * \param max_cnt [IN]          Maximum number of hits
+ * \param buf [OUT]             Buffer of buf_size bytes, no more hits than fit are fetched
+ * \param buf_size [IN]         Size of buf
+ * \param cnt [OUT]             Number of hits fetched, 0 at the end of the result
+ * \param nbytes [OUT]          Number of bytes written to buf
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_query_cursor_fetch(pdc_query_cursor_t *cursor, uint64_t obj_id, uint64_t max_cnt, void *buf,
+                                     uint64_t buf_size, uint64_t *cnt, uint64_t *nbytes);
+
+/**
+ * Free the result of a cursor on the servers
+ *
+ * \param cursor [IN]           Cursor
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_query_cursor_close(pdc_query_cursor_t *cursor);
+
 /**
  * ********
  *
@@ -1097,6 +1158,40 @@ perr_t PDC_Client_delete_obj_ref_from_dart(dart_hash_algo_t hash_algo, char *att
 perr_t PDC_Client_insert_obj_ref_into_dart(dart_hash_algo_t hash_algo, char *attr_key, char *attr_val,
                                            dart_object_ref_type_t ref_type, uint64_t data);
 
+/**
+ * Delete the inverted mappings of n (key, value, data) triples. The triples are grouped by the servers
+ * holding them and each server gets its group in a single bulk transfer.
+ *
+ * \param hash_algo     [IN]    name of the hashing algorithm
+ * \param n             [IN]    Number of triples
+ * \param attr_keys     [IN]    Names of the attributes
+ * \param attr_vals     [IN]    Values of the attributes
+ * \param ref_type      [IN]    The reference type of the objects, e.g. PRIMARY_ID, SECONDARY_ID, SERVER_ID
+ * \param data          [IN]    Associated values along with the key-value pairs.
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_delete_obj_ref_from_dart_batch(dart_hash_algo_t hash_algo, int n, char **attr_keys,
+                                                 char **attr_vals, dart_object_ref_type_t ref_type,
+                                                 uint64_t *data);
+
+/**
+ * Insert n (key, value, data) triples into the index. The triples are grouped by the servers holding them,
+ * replicas included, and each server gets its group in a single bulk transfer and inserts it at once.
+ *
+ * \param hash_algo     [IN]    name of the hashing algorithm
+ * \param n             [IN]    Number of triples
+ * \param attr_keys     [IN]    Names of the attributes
+ * \param attr_vals     [IN]    Values of the attributes
+ * \param ref_type      [IN]    The reference type of the objects, e.g. PRIMARY_ID, SECONDARY_ID, SERVER_ID
+ * \param data          [IN]    Associated values along with the key-value pairs.
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Client_insert_obj_ref_into_dart_batch(dart_hash_algo_t hash_algo, int n, char **attr_keys,
+                                                 char **attr_vals, dart_object_ref_type_t ref_type,
+                                                 uint64_t *data);
+
 /**
  * Report the average profiling time of the server if the info is available.
  */
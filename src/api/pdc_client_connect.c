@@ -178,6 +178,8 @@ static hg_id_t send_region_storage_meta_shm_bulk_rpc_register_id_g;
 // data query
 static hg_id_t send_data_query_register_id_g;
 static hg_id_t get_sel_data_register_id_g;
+static hg_id_t query_cursor_fetch_register_id_g;
+static hg_id_t send_bulk_rpc_register_id_g;
 
 // DART index
 static hg_id_t dart_get_server_info_g;
@@ -1325,14 +1327,15 @@ drc_access_again:
 
     // Recv from server
     PDC_send_nhits_register(*hg_class);
-    PDC_send_bulk_rpc_register(*hg_class);
+    send_bulk_rpc_register_id_g = PDC_send_bulk_rpc_register(*hg_class);
 
     // Server to client RPC register
     PDC_send_client_storage_meta_rpc_register(*hg_class);
 
     // Data query
-    send_data_query_register_id_g = PDC_send_data_query_rpc_register(*hg_class);
-    get_sel_data_register_id_g    = PDC_get_sel_data_rpc_register(*hg_class);
+    send_data_query_register_id_g    = PDC_send_data_query_rpc_register(*hg_class);
+    get_sel_data_register_id_g       = PDC_get_sel_data_rpc_register(*hg_class);
+    query_cursor_fetch_register_id_g = PDC_query_cursor_fetch_rpc_register(*hg_class);
 
     // DART Index
     dart_get_server_info_g    = PDC_dart_get_server_info_register(*hg_class);
@@ -3004,8 +3007,9 @@ done:
 }
 
 perr_t
-PDC_Client_transfer_request_all(int n_objs, pdc_access_t access_type, uint32_t data_server_id, char *bulk_buf,
-                                hg_size_t bulk_size, uint64_t *metadata_id)
+PDC_Client_transfer_request_all(int n_objs, pdc_access_t access_type, uint32_t data_server_id, int n_segments,
+                                char **segments, hg_size_t *segment_sizes, hg_size_t bulk_size,
+                                uint64_t *metadata_id)
 {
     perr_t                                ret_value = SUCCEED;
     hg_return_t                           hg_ret    = HG_SUCCESS;
@@ -3044,7 +3048,8 @@ PDC_Client_transfer_request_all(int n_objs, pdc_access_t access_type, uint32_t d
                        transfer_request_all_register_id_g, &client_send_transfer_request_all_handle);
 
     // Create bulk handles
-    hg_ret = HG_Bulk_create(hg_class, 1, (void **)&bulk_buf, &bulk_size, HG_BULK_READWRITE,
+    // The server pulls the segments as one buffer of bulk_size bytes
+    hg_ret = HG_Bulk_create(hg_class, n_segments, (void **)segments, segment_sizes, HG_BULK_READWRITE,
                             &(in.local_bulk_handle));
     if (hg_ret != HG_SUCCESS)
         PGOTO_ERROR(FAIL,
@@ -3320,8 +3325,8 @@ done:
 perr_t
 PDC_Client_transfer_request(void *buf, pdcid_t obj_id, uint32_t data_server_id, int obj_ndim,
                             uint64_t *obj_dims, int remote_ndim, uint64_t *remote_offset,
-                            uint64_t *remote_size, size_t unit, pdc_access_t access_type,
-                            pdcid_t *metadata_id)
+                            uint64_t *remote_size, size_t unit, pdc_var_type_t obj_type,
+                            pdc_access_t access_type, pdcid_t *metadata_id)
 {
     perr_t                            ret_value = SUCCEED;
     hg_return_t                       hg_ret    = HG_SUCCESS;
@@ -3348,6 +3353,7 @@ PDC_Client_transfer_request(void *buf, pdcid_t obj_id, uint32_t data_server_id,
     // data_server_id);
     in.access_type = access_type;
     in.remote_unit = unit;
+    in.obj_type    = (int8_t)obj_type;
     in.obj_id      = obj_id;
     in.obj_ndim    = obj_ndim;
     if (in.obj_ndim >= 1) {
@@ -7261,8 +7267,12 @@ kvtag_query_bulk_cb(const struct hg_cb_info *hg_cb_info)
         // bulk_args->obj_ids = (uint64_t *)calloc(sizeof(uint64_t), n_meta);
         // memcpy(bulk_args->obj_ids, buf, sizeof(uint64_t) * n_meta);
     }
-    else
+    else {
+        // The results of this server are lost, it is left out of the merge
+        bulk_args->n_meta  = 0;
+        bulk_args->obj_ids = NULL;
         PGOTO_ERROR(HG_PROTOCOL_ERROR, "==PDC_CLIENT[%d]: Error with bulk handle", pdc_client_mpi_rank_g);
+    }
 
     // Free local bulk handle
     ret_value = HG_Bulk_free(local_bulk_handle);
@@ -7302,8 +7312,11 @@ kvtag_query_forward_cb(const struct hg_cb_info *callback_info)
 
     // Get output from server
     ret_value = HG_Get_output(handle, &output);
-    if (ret_value != HG_SUCCESS)
+    if (ret_value != HG_SUCCESS) {
+        // Other queries may still be in flight, count this one as done
+        hg_atomic_decr32(&bulk_todo_g);
         PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error HG_Get_output", pdc_client_mpi_rank_g);
+    }
 
     bulk_arg->server_time_elapsed       = output.server_time_elapsed;
     bulk_arg->server_memory_consumption = output.server_memory_consumption;
@@ -7337,8 +7350,11 @@ kvtag_query_forward_cb(const struct hg_cb_info *callback_info)
     ret_value =
         HG_Bulk_transfer(hg_info->context, kvtag_query_bulk_cb, bulk_arg, HG_BULK_PULL, hg_info->addr,
                          origin_bulk_handle, 0, local_bulk_handle, 0, bulk_arg->nbytes, &hg_bulk_op_id);
-    if (ret_value != HG_SUCCESS)
+    if (ret_value != HG_SUCCESS) {
+        bulk_arg->n_meta = 0;
+        hg_atomic_decr32(&bulk_todo_g);
         PGOTO_ERROR(FAIL, "Could not read bulk data");
+    }
 
 done:
     fflush(stdout);
@@ -7348,23 +7364,23 @@ done:
     FUNC_LEAVE(ret_value);
 }
 
+/*
+ * Send a kvtag query to a server without waiting for the response. The results are stored in bulk_arg by
+ * kvtag_query_forward_cb and kvtag_query_bulk_cb, which decrement bulk_todo_g once they are received.
+ */
 static perr_t
-PDC_Client_query_kvtag_server(uint32_t server_id, const pdc_kvtag_t *kvtag, int *n_res, uint64_t **out)
+PDC_Client_query_kvtag_server_forward(uint32_t server_id, const pdc_kvtag_t *kvtag,
+                                      struct bulk_args_t *bulk_arg)
 {
-    perr_t              ret_value = SUCCEED;
-    hg_return_t         hg_ret;
-    hg_handle_t         query_kvtag_server_handle;
-    pdc_kvtag_t         in;
-    struct bulk_args_t *bulk_arg;
+    perr_t      ret_value = SUCCEED;
+    hg_return_t hg_ret;
+    hg_handle_t query_kvtag_server_handle;
+    pdc_kvtag_t in;
 
     FUNC_ENTER(NULL);
 
     if (kvtag == NULL)
         PGOTO_ERROR(FAIL, "==CLIENT[%d]: %s - kvtag is NULL!", pdc_client_mpi_rank_g, __func__);
-    if (n_res == NULL)
-        PGOTO_ERROR(FAIL, "==CLIENT[%d]: %s - n_res is NULL!", pdc_client_mpi_rank_g, __func__);
-    if (out == NULL)
-        PGOTO_ERROR(FAIL, "==CLIENT[%d]: %s - out is NULL!", pdc_client_mpi_rank_g, __func__);
 
     if (kvtag->name == NULL)
         in.name = " ";
@@ -7382,40 +7398,101 @@ PDC_Client_query_kvtag_server(uint32_t server_id, const pdc_kvtag_t *kvtag, int
         in.size  = kvtag->size;
     }
 
-    *out   = NULL;
-    *n_res = 0;
-
     if (PDC_Client_try_lookup_server(server_id, 0) != SUCCEED)
         PGOTO_ERROR(FAIL, "==CLIENT[%d]: ERROR with PDC_Client_try_lookup_server", pdc_client_mpi_rank_g);
 
     hg_ret = HG_Create(send_context_g, pdc_server_info_g[server_id].addr, query_kvtag_register_id_g,
                        &query_kvtag_server_handle);
-
-    bulk_arg = (struct bulk_args_t *)calloc(1, sizeof(struct bulk_args_t));
-    if (query_kvtag_server_handle == NULL)
+    if (hg_ret != HG_SUCCESS)
         PGOTO_ERROR(FAIL, "==CLIENT[%d]: Error with query_kvtag_server_handle", pdc_client_mpi_rank_g);
 
+    bulk_arg->server_id = server_id;
+    hg_atomic_incr32(&bulk_todo_g);
     hg_ret = HG_Forward(query_kvtag_server_handle, kvtag_query_forward_cb, bulk_arg, &in);
-    if (hg_ret != HG_SUCCESS)
-        PGOTO_ERROR(FAIL, "PDC_client_list_all(): Could not start HG_Forward()");
+    if (hg_ret != HG_SUCCESS) {
+        hg_atomic_decr32(&bulk_todo_g);
+        HG_Destroy(query_kvtag_server_handle);
+        PGOTO_ERROR(FAIL, "==CLIENT[%d]: %s - could not start HG_Forward()", pdc_client_mpi_rank_g,
+                    __func__);
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Query the servers from server_start to server_end - 1. All the queries are in flight at once and the
+ * client waits once for all responses, the results are concatenated in server order.
+ */
+static perr_t
+PDC_Client_query_kvtag_servers(const pdc_kvtag_t *kvtag, int32_t server_start, int32_t server_end, int *n_res,
+                               uint64_t **pdc_ids)
+{
+    perr_t              ret_value = SUCCEED;
+    struct bulk_args_t *bulk_args = NULL;
+    int32_t             i, n_server, n_sent = 0;
+    uint32_t            server_id;
+    int                 total = 0;
+
+    FUNC_ENTER(NULL);
+
+    *n_res   = 0;
+    *pdc_ids = NULL;
+
+    n_server = server_end - server_start;
+    if (n_server <= 0)
+        PGOTO_DONE(SUCCEED);
+
+    bulk_args = (struct bulk_args_t *)calloc(n_server, sizeof(struct bulk_args_t));
+    if (bulk_args == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: %s - unable to allocate query arguments", pdc_client_mpi_rank_g,
+                    __func__);
 
     hg_atomic_set32(&bulk_transfer_done_g, 0);
+    for (i = 0; i < n_server; i++) {
+        // TODO: when there are multiple clients issuing different queries concurrently, try to balance the
+        // server workload by having different clients sending queries with a different order
+        if (PDC_Client_query_kvtag_server_forward((uint32_t)(server_start + i), kvtag, &bulk_args[i]) !=
+            SUCCEED) {
+            printf("==PDC_CLIENT[%d]: %s - error sending query to server %d\n", pdc_client_mpi_rank_g,
+                   __func__, server_start + i);
+            ret_value = FAIL;
+            break;
+        }
+        n_sent++;
+    }
 
-    // Wait for response from server
-    hg_atomic_incr32(&bulk_todo_g);
-    PDC_Client_check_bulk(send_context_g);
+    // Wait for the responses of all servers, including the ones sent before an error
+    if (n_sent > 0)
+        PDC_Client_check_bulk(send_context_g);
 
-    server_call_count_g[server_id]++;
-    server_time_total_g[server_id] += bulk_arg->server_time_elapsed;
-    server_mem_usage_g[server_id] = bulk_arg->server_memory_consumption;
+    for (i = 0; i < n_sent; i++) {
+        server_id = (uint32_t)(server_start + i);
+        server_call_count_g[server_id]++;
+        server_time_total_g[server_id] += bulk_args[i].server_time_elapsed;
+        server_mem_usage_g[server_id] = bulk_args[i].server_memory_consumption;
+        // A server whose results could not be pulled has no IDs
+        if (bulk_args[i].obj_ids == NULL)
+            bulk_args[i].n_meta = 0;
+        total += bulk_args[i].n_meta;
+    }
 
-    *n_res = bulk_arg->n_meta;
-    if (*n_res > 0)
-        *out = bulk_arg->obj_ids;
-    free(bulk_arg);
-    // TODO: need to be careful when freeing the lookup_args, as it include the results returned to user
+    if (ret_value == SUCCEED && total > 0) {
+        if (NULL == (*pdc_ids = (uint64_t *)malloc(sizeof(uint64_t) * total)))
+            ret_value = FAIL;
+        for (i = 0; ret_value == SUCCEED && i < n_sent; i++) {
+            if (bulk_args[i].n_meta == 0)
+                continue;
+            memcpy(*pdc_ids + *n_res, bulk_args[i].obj_ids, bulk_args[i].n_meta * sizeof(uint64_t));
+            *n_res += bulk_args[i].n_meta;
+        }
+    }
+
+    for (i = 0; i < n_sent; i++)
+        free(bulk_args[i].obj_ids);
 
 done:
+    free(bulk_args);
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
@@ -7424,43 +7501,37 @@ done:
 perr_t
 PDC_Client_query_kvtag(const pdc_kvtag_t *kvtag, int *n_res, uint64_t **pdc_ids)
 {
-    perr_t    ret_value = SUCCEED;
-    int32_t   i;
-    int       nmeta    = 0;
-    uint64_t *temp_ids = NULL;
-    uint32_t  server_id;
+    perr_t ret_value = SUCCEED;
 
     FUNC_ENTER(NULL);
 
-    *n_res   = 0;
-    *pdc_ids = NULL;
+    ret_value = PDC_Client_query_kvtag_servers(kvtag, 0, pdc_server_num_g, n_res, pdc_ids);
+    if (ret_value != SUCCEED)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error with PDC_Client_query_kvtag_servers",
+                    pdc_client_mpi_rank_g);
 
-    for (i = 0; i < pdc_server_num_g; i++) {
-        // TODO: when there are multiple clients issuing different queries concurrently, try to balance the
-        // server workload by having different clients sending queries with a different order
-        // server_id = (pdc_client_mpi_rank_g + i) % pdc_server_num_g;
-        // ret_value = PDC_Client_query_kvtag_server(server_id, kvtag, &nmeta, &temp_ids);
-        ret_value = PDC_Client_query_kvtag_server((uint32_t)i, kvtag, &nmeta, &temp_ids);
-        if (ret_value != SUCCEED) {
-            PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error with PDC_Client_query_kvtag_server to server %d",
-                        pdc_client_mpi_rank_g, i);
-        }
-        if (i == 0) {
-            *pdc_ids = temp_ids;
-        }
-        else if (nmeta > 0) {
-            *pdc_ids = (uint64_t *)realloc(*pdc_ids, sizeof(uint64_t) * (*n_res + nmeta));
-            memcpy(*pdc_ids + (*n_res), temp_ids, nmeta * sizeof(uint64_t));
-            free(temp_ids);
-        }
-        *n_res = *n_res + nmeta;
-    }
 done:
     memory_debug_g = 1;
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
 
+perr_t
+PDC_Client_query_kvtag_range(const pdc_kvtag_range_t *range, int *n_res, uint64_t **pdc_ids)
+{
+    perr_t      ret_value = SUCCEED;
+    pdc_kvtag_t kvtag;
+
+    FUNC_ENTER(NULL);
+
+    // The range travels in the value of a regular kvtag query, marked by PDC_KVTAG_RANGE_FLAG in its type
+    kvtag_range_encode(range, &kvtag);
+    ret_value = PDC_Client_query_kvtag(&kvtag, n_res, pdc_ids);
+    free(kvtag.value);
+
+    FUNC_LEAVE(ret_value);
+}
+
 // Delete a tag specified by a name, and whether it is from a container or an object
 static perr_t
 PDCtag_delete(pdcid_t obj_id, char *tag_name, int is_cont)
@@ -7982,8 +8053,8 @@ PDC_recv_nhits(const struct hg_cb_info *callback_info)
 }
 
 perr_t
-PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t *nhits, pdc_selection_t *sel,
-                    void *data ATTRIBUTE(unused))
+PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t obj_id, uint64_t *nhits,
+                    pdc_selection_t *sel, void *data)
 {
     perr_t                         ret_value      = SUCCEED;
     hg_return_t                    hg_ret         = 0;
@@ -8008,6 +8079,7 @@ PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t *nhi
     query_xfer->client_id    = pdc_client_mpi_rank_g;
     query_xfer->manager      = target_servers[0];
     query_xfer->get_op       = (int)get_op;
+    query_xfer->agg_obj_id   = obj_id;
 
     result           = (struct _pdc_query_result_list *)calloc(1, sizeof(struct _pdc_query_result_list));
     result->query_id = query_xfer->query_id;
@@ -8064,6 +8136,13 @@ PDC_send_data_query(pdc_query_t *query, pdc_query_get_op_t get_op, uint64_t *nhi
         sel->ndim         = result->ndim;
         sel->coords_alloc = result->nhits * result->ndim;
     }
+    if (get_op == PDC_QUERY_GET_AGG && result->n_agg_fail > 0) {
+        PDCquery_agg_free(&result->agg);
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: %" PRIu64 " servers could not aggregate all of their hits",
+                    pdc_client_mpi_rank_g, result->n_agg_fail);
+    }
+    if (get_op == PDC_QUERY_GET_AGG && data)
+        memcpy(data, &result->agg, sizeof(pdc_query_agg_t));
 
 done:
     fflush(stdout);
@@ -8142,6 +8221,64 @@ done:
     FUNC_LEAVE(ret_value);
 }
 
+hg_return_t
+PDC_recv_query_agg(const struct hg_cb_info *callback_info)
+{
+    hg_return_t                    ret_value         = HG_SUCCESS;
+    hg_bulk_t                      local_bulk_handle = callback_info->info.bulk.local_handle;
+    struct bulk_args_t *           bulk_args         = (struct bulk_args_t *)callback_info->arg;
+    struct _pdc_query_result_list *result_elt;
+    void *                         buf;
+    pdc_int_ret_t                  out;
+
+    FUNC_ENTER(NULL);
+
+    out.ret = 1;
+
+    if (callback_info->ret != HG_SUCCESS) {
+        out.ret = -1;
+        PGOTO_ERROR(HG_PROTOCOL_ERROR, "Error in callback");
+    }
+
+    DL_FOREACH(pdcquery_result_list_head_g, result_elt)
+    {
+        if (result_elt->query_id == bulk_args->query_id)
+            break;
+    }
+    if (result_elt == NULL) {
+        out.ret = -1;
+        PGOTO_ERROR(HG_OTHER_ERROR, "==PDC_CLIENT[%d]: Invalid task ID!", pdc_client_mpi_rank_g);
+    }
+
+    ret_value = HG_Bulk_access(local_bulk_handle, 0, bulk_args->nbytes, HG_BULK_READWRITE, 1, &buf, NULL,
+                               NULL);
+    if (ret_value != HG_SUCCESS ||
+        PDC_query_agg_deserialize(buf, bulk_args->nbytes, &result_elt->agg) != SUCCEED) {
+        out.ret = -1;
+        PGOTO_ERROR(HG_OTHER_ERROR, "==PDC_CLIENT[%d]: Invalid aggregate from server %d!",
+                    pdc_client_mpi_rank_g, bulk_args->origin);
+    }
+    result_elt->nhits      = result_elt->agg.count;
+    result_elt->n_agg_fail = bulk_args->total;
+
+    printf("==PDC_CLIENT[%d]: %s - received aggregate of %" PRIu64 " hits from server %d\n",
+           pdc_client_mpi_rank_g, __func__, result_elt->agg.count, bulk_args->origin);
+
+done:
+    hg_atomic_decr32(&atomic_work_todo_g);
+    HG_Bulk_free(local_bulk_handle);
+
+    ret_value = HG_Respond(bulk_args->handle, NULL, NULL, &out);
+    if (ret_value != HG_SUCCESS)
+        printf("==PDC_CLIENT[%d]: Could not respond\n", pdc_client_mpi_rank_g);
+
+    fflush(stdout);
+    HG_Destroy(bulk_args->handle);
+    free(bulk_args);
+
+    FUNC_LEAVE(ret_value);
+}
+
 void
 PDCselection_free(pdc_selection_t *sel)
 {
@@ -8232,6 +8369,204 @@ done:
     FUNC_LEAVE(ret_value);
 }
 
+static hg_return_t
+query_cursor_fetch_rpc_cb(const struct hg_cb_info *callback_info)
+{
+    hg_return_t               ret_value = HG_SUCCESS;
+    query_cursor_fetch_out_t *fetch_out = (query_cursor_fetch_out_t *)callback_info->arg;
+    query_cursor_fetch_out_t  output;
+    hg_handle_t               handle = callback_info->info.forward.handle;
+
+    FUNC_ENTER(NULL);
+
+    fetch_out->ret = -1;
+    ret_value      = HG_Get_output(handle, &output);
+    if (ret_value != HG_SUCCESS)
+        PGOTO_ERROR(ret_value, "==PDC_CLIENT[%d]: error with HG_Get_output", pdc_client_mpi_rank_g);
+
+    *fetch_out = output;
+    HG_Free_output(handle, &output);
+
+done:
+    hg_atomic_decr32(&atomic_work_todo_g);
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Send one fetch request of a cursor to a server, for the hits it found starting at offset, and wait until
+ * they are in buf. With is_close, the server frees its result instead.
+ */
+static perr_t
+PDC_Client_query_cursor_send(pdc_query_cursor_t *cursor, int server_id, int is_close, uint64_t obj_id,
+                             uint64_t offset, uint64_t max_cnt, void *buf, uint64_t buf_size,
+                             query_cursor_fetch_out_t *out)
+{
+    perr_t                  ret_value = SUCCEED;
+    hg_return_t             hg_ret;
+    hg_handle_t             handle = NULL;
+    hg_class_t *            hg_class;
+    hg_size_t               size = buf_size;
+    query_cursor_fetch_in_t in;
+
+    FUNC_ENTER(NULL);
+
+    in.query_id    = (int)cursor->query_id;
+    in.is_close    = is_close;
+    in.obj_id      = obj_id;
+    in.offset      = offset;
+    in.cnt         = max_cnt;
+    in.bulk_handle = HG_BULK_NULL;
+
+    debug_server_id_count[server_id]++;
+
+    if (PDC_Client_try_lookup_server(server_id, 0) != SUCCEED)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: ERROR with PDC_Client_try_lookup_server", pdc_client_mpi_rank_g);
+
+    if (buf != NULL && buf_size > 0) {
+        hg_class = HG_Context_get_class(send_context_g);
+        hg_ret   = HG_Bulk_create(hg_class, 1, &buf, &size, HG_BULK_WRITE_ONLY, &in.bulk_handle);
+        if (hg_ret != HG_SUCCESS)
+            PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: could not create bulk handle", pdc_client_mpi_rank_g);
+    }
+
+    HG_Create(send_context_g, pdc_server_info_g[server_id].addr, query_cursor_fetch_register_id_g, &handle);
+
+    hg_ret = HG_Forward(handle, query_cursor_fetch_rpc_cb, out, &in);
+    if (hg_ret != HG_SUCCESS)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: ERROR with HG_Forward", pdc_client_mpi_rank_g);
+
+    // The server responds once the hits are pushed, so at most one piece is in flight
+    hg_atomic_set32(&atomic_work_todo_g, 1);
+    PDC_Client_check_response(&send_context_g);
+
+    if (out->ret != 1)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: query cursor fetch from server %d failed ... ret_value = %d",
+                    pdc_client_mpi_rank_g, server_id, out->ret);
+
+    if (out->ndim > 0)
+        cursor->ndim = out->ndim;
+
+done:
+    fflush(stdout);
+    if (in.bulk_handle != HG_BULK_NULL)
+        HG_Bulk_free(in.bulk_handle);
+    if (handle)
+        HG_Destroy(handle);
+
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Client_query_cursor_open(pdc_query_t *query, pdc_query_cursor_t *cursor)
+{
+    perr_t                   ret_value = SUCCEED;
+    pdc_selection_t          sel;
+    query_cursor_fetch_out_t out;
+    uint64_t                 total = 0;
+    int                      i;
+
+    FUNC_ENTER(NULL);
+
+    memset(cursor, 0, sizeof(pdc_query_cursor_t));
+    memset(&sel, 0, sizeof(pdc_selection_t));
+
+    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_CURSOR, 0, &cursor->nhits, &sel, NULL);
+    if (ret_value != SUCCEED)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error sending query", pdc_client_mpi_rank_g);
+    cursor->query_id = sel.query_id;
+
+    // Empty fetches to learn how many hits each server found, and their number of dimensions
+    cursor->server_nhits = (uint64_t *)calloc(pdc_server_num_g, sizeof(uint64_t));
+    if (cursor->server_nhits == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error allocating cursor", pdc_client_mpi_rank_g);
+    for (i = 0; i < pdc_server_num_g; i++) {
+        memset(&out, 0, sizeof(out));
+        ret_value = PDC_Client_query_cursor_send(cursor, i, 0, 0, 0, 0, NULL, 0, &out);
+        if (ret_value != SUCCEED)
+            PGOTO_DONE(FAIL);
+        cursor->server_nhits[i] = out.nhits;
+        total += out.nhits;
+    }
+    if (total != cursor->nhits)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: servers found %" PRIu64 " of %" PRIu64 " hits",
+                    pdc_client_mpi_rank_g, total, cursor->nhits);
+
+done:
+    // Nothing can be fetched, the results are still freed by PDC_Client_query_cursor_close
+    if (ret_value != SUCCEED) {
+        free(cursor->server_nhits);
+        cursor->server_nhits = NULL;
+    }
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Client_query_cursor_fetch(pdc_query_cursor_t *cursor, uint64_t obj_id, uint64_t max_cnt, void *buf,
+                              uint64_t buf_size, uint64_t *cnt, uint64_t *nbytes)
+{
+    perr_t                   ret_value = SUCCEED;
+    query_cursor_fetch_out_t out;
+
+    FUNC_ENTER(NULL);
+
+    *cnt    = 0;
+    *nbytes = 0;
+    if (buf == NULL || cursor->server_nhits == NULL)
+        PGOTO_DONE(SUCCEED);
+
+    // The hits of a server are read from its storage regions, the pieces of several servers fill buf in turn
+    while (cursor->pos < cursor->nhits && *cnt < max_cnt && *nbytes < buf_size) {
+        if (cursor->server_pos >= cursor->server_nhits[cursor->server_id]) {
+            cursor->server_id++;
+            cursor->server_pos = 0;
+            if (cursor->server_id >= pdc_server_num_g)
+                PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: cursor is past the hits of all servers",
+                            pdc_client_mpi_rank_g);
+            continue;
+        }
+
+        memset(&out, 0, sizeof(out));
+        ret_value = PDC_Client_query_cursor_send(cursor, cursor->server_id, 0, obj_id, cursor->server_pos,
+                                                 max_cnt - *cnt, (char *)buf + *nbytes, buf_size - *nbytes,
+                                                 &out);
+        if (ret_value != SUCCEED)
+            PGOTO_DONE(FAIL);
+        // buf cannot hold one more hit
+        if (out.cnt == 0)
+            break;
+
+        cursor->pos += out.cnt;
+        cursor->server_pos += out.cnt;
+        *cnt += out.cnt;
+        *nbytes += out.nbytes;
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Client_query_cursor_close(pdc_query_cursor_t *cursor)
+{
+    perr_t                   ret_value = SUCCEED;
+    query_cursor_fetch_out_t out;
+    int                      i;
+
+    FUNC_ENTER(NULL);
+
+    // Every server that evaluated the query keeps a result, even without hits
+    for (i = 0; i < pdc_server_num_g; i++) {
+        memset(&out, 0, sizeof(out));
+        if (PDC_Client_query_cursor_send(cursor, i, 1, 0, 0, 0, NULL, 0, &out) != SUCCEED)
+            ret_value = FAIL;
+    }
+    free(cursor->server_nhits);
+    cursor->server_nhits = NULL;
+
+    FUNC_LEAVE(ret_value);
+}
+
 hg_return_t
 PDC_recv_read_coords_data(const struct hg_cb_info *callback_info)
 {
@@ -8455,6 +8790,30 @@ get_dart_g()
     return dart_g;
 }
 
+// The object IDs are pulled into the obj_ids buffer of the request, see dart_perform_one_server_on_receive_cb
+static hg_return_t
+dart_perform_one_server_bulk_cb(const struct hg_cb_info *hg_cb_info)
+{
+    hg_return_t         ret_value = HG_SUCCESS;
+    struct bulk_args_t *bulk_args = (struct bulk_args_t *)hg_cb_info->arg;
+
+    FUNC_ENTER(NULL);
+
+    if (hg_cb_info->ret != HG_SUCCESS) {
+        printf("==PDC_CLIENT[%d]: %s - error with bulk transfer from server %d\n", pdc_client_mpi_rank_g,
+               __func__, bulk_args->server_id);
+        free(bulk_args->obj_ids);
+        bulk_args->obj_ids = NULL;
+        bulk_args->n_meta  = 0;
+    }
+
+    ret_value = HG_Bulk_free(hg_cb_info->info.bulk.local_handle);
+    HG_Destroy(bulk_args->handle);
+    hg_atomic_decr32(&atomic_work_todo_g);
+
+    FUNC_LEAVE(ret_value);
+}
+
 // Bulk
 static hg_return_t
 dart_perform_one_server_on_receive_cb(const struct hg_cb_info *callback_info)
@@ -8465,6 +8824,7 @@ dart_perform_one_server_on_receive_cb(const struct hg_cb_info *callback_info)
     dart_perform_one_server_out_t output;
     uint32_t                      n_meta;
     hg_op_id_t                    hg_bulk_op_id;
+    int                           pulling = 0;
 
     hg_bulk_t             local_bulk_handle  = HG_BULK_NULL;
     hg_bulk_t             origin_bulk_handle = HG_BULK_NULL;
@@ -8536,45 +8896,38 @@ dart_perform_one_server_on_receive_cb(const struct hg_cb_info *callback_info)
     }
 
     /* Create a new bulk handle to read the data */
+    client_lookup_args->obj_ids = (uint64_t *)recv_meta;
     HG_Bulk_create(hg_info->hg_class, 1, (void **)&recv_meta, (hg_size_t *)&client_lookup_args->nbytes,
                    HG_BULK_READWRITE, &local_bulk_handle);
 
     // println("[Client_Side_Bulk]  after bulk create. rank = %d", pdc_client_mpi_rank_g);
 
-    /* Pull bulk data */
-    ret_value = HG_Bulk_transfer(hg_info->context, hg_test_bulk_transfer_cb, client_lookup_args, HG_BULK_PULL,
-                                 hg_info->addr, origin_bulk_handle, 0, local_bulk_handle, 0,
+    /* Pull bulk data, the responses of the other servers are handled in the meantime */
+    ret_value = HG_Bulk_transfer(hg_info->context, dart_perform_one_server_bulk_cb, client_lookup_args,
+                                 HG_BULK_PULL, hg_info->addr, origin_bulk_handle, 0, local_bulk_handle, 0,
                                  client_lookup_args->nbytes, &hg_bulk_op_id);
 
     // println("[Client_Side_Bulk]  after bulk transfer. rank = %d", pdc_client_mpi_rank_g);
 
     if (ret_value != HG_SUCCESS) {
         fprintf(stderr, "Could not read bulk data\n");
-        client_lookup_args->n_meta = 0;
+        HG_Bulk_free(local_bulk_handle);
+        free(recv_meta);
+        client_lookup_args->obj_ids = NULL;
+        client_lookup_args->n_meta  = 0;
         goto done;
     }
-
-    hg_atomic_init32(&(client_lookup_args->bulk_done_flag), 0);
-    hg_atomic_incr32(&bulk_todo_g);
-
-    // hg_atomic_set32(&bulk_transfer_done_g, 0);
-    // loop
-    PDC_Client_check_bulk(send_context_g);
-    // println("[Client_Side_Bulk]  after check bulk. rank = %d", pdc_client_mpi_rank_g);
-
-    while (1) {
-        if (hg_atomic_get32(&(client_lookup_args->bulk_done_flag)) == 1) {
-            break;
-        }
-    }
+    pulling = 1;
 
 done:
     // println("[Client_Side_Bulk]  finish bulk. rank = %d", pdc_client_mpi_rank_g);
-    hg_atomic_decr32(&atomic_work_todo_g);
     HG_Free_output(handle, &output);
-    // we destroy the handle here. There will be no need to clean it up in the loop from the request
-    // initiator function
-    HG_Destroy(handle);
+    // While the results are pulled, the handle is kept and the request is completed by
+    // dart_perform_one_server_bulk_cb
+    if (!pulling) {
+        hg_atomic_decr32(&atomic_work_todo_g);
+        HG_Destroy(handle);
+    }
     FUNC_LEAVE(ret_value);
 }
 
@@ -8600,10 +8953,7 @@ _dart_send_request_to_one_server(int server_id, dart_perform_one_server_in_t *da
         hg_atomic_decr32(&atomic_work_todo_g);
         return FAIL;
     }
-    // waiting for response and get the results if any.
-    // Wait for response from server
-    // hg_atomic_cas32(&atomic_work_todo_g, 0, num_requests);
-    PDC_Client_check_response(&send_context_g); // This will block until all requests are done.
+    // The response is waited for by dart_perform_on_servers, together with the other servers
 
     return SUCCEED;
 }
@@ -8645,7 +8995,8 @@ dart_perform_on_servers(index_hash_result_t **hash_result, int num_servers,
 
     stopwatch_t timer;
     timer_start(&timer);
-    // send the requests to the required servers.
+    // send the requests to the required servers, all of them are in flight at once.
+    hg_atomic_set32(&atomic_work_todo_g, 0);
     for (int i = 0; i < num_servers; i++) {
         int server_id = (*hash_result)[i].server_id;
         if (PDC_Client_try_lookup_server(server_id, 0) != SUCCEED)
@@ -8662,6 +9013,8 @@ dart_perform_on_servers(index_hash_result_t **hash_result, int num_servers,
 
         num_requests++;
     }
+    // Wait for the responses of all servers
+    PDC_Client_check_response(&send_context_g);
 
     // aggregate results when executing queries.
     if ((!is_index_write_op(op_type)) && output_set != NULL) {
@@ -8892,6 +9245,177 @@ PDC_Client_insert_obj_ref_into_dart(dart_hash_algo_t hash_algo, char *attr_key,
     return ret_value;
 }
 
+// Entries of a DART batch for one server, in the format of PDC_Server_dart_perform_batch
+typedef struct dart_batch_buf_t {
+    char *                         data;
+    uint64_t                       size;
+    uint64_t                       alloc;
+    uint64_t                       n_entry;
+    hg_bulk_t                      bulk_handle;
+    hg_handle_t                    handle;
+    struct _pdc_client_lookup_args lookup_args;
+} dart_batch_buf_t;
+
+static perr_t
+dart_batch_add(dart_batch_buf_t *buf, uint64_t obj_locator, const char *attr_key, const char *attr_val)
+{
+    uint32_t key_size = strlen(attr_key) + 1, val_size = strlen(attr_val) + 1;
+    uint64_t size = sizeof(uint64_t) + 2 * sizeof(uint32_t) + key_size + val_size;
+    char *   data;
+
+    if (buf->size + size > buf->alloc) {
+        buf->alloc = buf->alloc == 0 ? 4096 : buf->alloc;
+        while (buf->size + size > buf->alloc)
+            buf->alloc *= 2;
+        data = (char *)realloc(buf->data, buf->alloc);
+        if (data == NULL)
+            return FAIL;
+        buf->data = data;
+    }
+
+    data = buf->data + buf->size;
+    memcpy(data, &obj_locator, sizeof(uint64_t));
+    data += sizeof(uint64_t);
+    memcpy(data, &key_size, sizeof(uint32_t));
+    data += sizeof(uint32_t);
+    memcpy(data, attr_key, key_size);
+    data += key_size;
+    memcpy(data, &val_size, sizeof(uint32_t));
+    data += sizeof(uint32_t);
+    memcpy(data, attr_val, val_size);
+
+    buf->size += size;
+    buf->n_entry++;
+
+    return SUCCEED;
+}
+
+// Group the entries by the servers DART or DHT places them on, replicas included, and send each server its
+// group in one bulk transfer. All servers are sent to at once.
+static perr_t
+dart_perform_batch_on_servers(dart_op_type_t op_type, dart_hash_algo_t hash_algo, int n, char **attr_keys,
+                              char **attr_vals, uint64_t *data)
+{
+    perr_t               ret_value = SUCCEED;
+    hg_return_t          hg_ret;
+    dart_batch_buf_t *   bufs        = NULL;
+    index_hash_result_t *hash_result = NULL;
+    bulk_rpc_in_t        in;
+    hg_size_t            buf_size;
+    int                  num_servers, i, j, server_id;
+
+    FUNC_ENTER(NULL);
+
+    bufs = (dart_batch_buf_t *)calloc(pdc_server_num_g, sizeof(dart_batch_buf_t));
+    if (bufs == NULL)
+        PGOTO_ERROR(FAIL, "==CLIENT[%d]: ERROR allocating DART batch", pdc_client_mpi_rank_g);
+
+    for (i = 0; i < n; i++) {
+        num_servers = 0;
+        hash_result = NULL;
+        if (hash_algo == DART_HASH) {
+            num_servers = DART_hash(dart_g, attr_keys[i], op_type,
+                                    op_type == OP_INSERT ? dart_retrieve_server_info_cb : NULL, &hash_result);
+        }
+        else if (hash_algo == DHT_FULL_HASH) {
+            num_servers = DHT_hash(dart_g, strlen(attr_keys[i]), attr_keys[i], op_type, &hash_result);
+        }
+        else if (hash_algo == DHT_INITIAL_HASH) {
+            num_servers = DHT_hash(dart_g, 1, attr_keys[i], op_type, &hash_result);
+        }
+
+        for (j = 0; j < num_servers; j++) {
+            server_id = hash_result[j].server_id;
+            if (dart_batch_add(&bufs[server_id], data[i], hash_result[j].key, attr_vals[i]) != SUCCEED)
+                PGOTO_ERROR(FAIL, "==CLIENT[%d]: ERROR allocating DART batch", pdc_client_mpi_rank_g);
+        }
+        // The replicas of a token share its key, DHT keys are the caller's
+        for (j = 0; j < num_servers; j++) {
+            if (hash_result[j].key != attr_keys[i] &&
+                (j == 0 || hash_result[j].key != hash_result[j - 1].key))
+                free(hash_result[j].key);
+        }
+        free(hash_result);
+        hash_result = NULL;
+    }
+
+    hg_atomic_set32(&atomic_work_todo_g, 0);
+    for (server_id = 0; server_id < pdc_server_num_g; server_id++) {
+        if (bufs[server_id].n_entry == 0)
+            continue;
+        if (PDC_Client_try_lookup_server(server_id, 0) != SUCCEED) {
+            printf("==CLIENT[%d]: ERROR with PDC_Client_try_lookup_server\n", pdc_client_mpi_rank_g);
+            ret_value = FAIL;
+            break;
+        }
+
+        buf_size = bufs[server_id].size;
+        hg_ret   = HG_Bulk_create(send_class_g, 1, (void **)&bufs[server_id].data, &buf_size,
+                                HG_BULK_READ_ONLY, &bufs[server_id].bulk_handle);
+        if (hg_ret != HG_SUCCESS) {
+            printf("==CLIENT[%d]: ERROR with HG_Bulk_create\n", pdc_client_mpi_rank_g);
+            ret_value = FAIL;
+            break;
+        }
+
+        memset(&in, 0, sizeof(bulk_rpc_in_t));
+        in.cnt         = bufs[server_id].n_entry;
+        in.origin      = pdc_client_mpi_rank_g;
+        in.op_id       = op_type == OP_INSERT ? PDC_BULK_DART_INSERT : PDC_BULK_DART_DELETE;
+        in.data_type   = hash_algo;
+        in.bulk_handle = bufs[server_id].bulk_handle;
+
+        HG_Create(send_context_g, pdc_server_info_g[server_id].addr, send_bulk_rpc_register_id_g,
+                  &bufs[server_id].handle);
+        hg_ret = HG_Forward(bufs[server_id].handle, pdc_client_check_int_ret_cb, &bufs[server_id].lookup_args,
+                            &in);
+        if (hg_ret != HG_SUCCESS) {
+            printf("==CLIENT[%d]: ERROR with HG_Forward\n", pdc_client_mpi_rank_g);
+            ret_value = FAIL;
+            break;
+        }
+        hg_atomic_incr32(&atomic_work_todo_g);
+    }
+    // Wait for the responses of all servers, also after a failure since the buffers are in flight
+    PDC_Client_check_response(&send_context_g);
+
+    for (server_id = 0; server_id < pdc_server_num_g; server_id++) {
+        if (bufs[server_id].handle != NULL && bufs[server_id].lookup_args.ret != 1)
+            ret_value = FAIL;
+    }
+
+done:
+    fflush(stdout);
+    free(hash_result);
+    if (bufs != NULL) {
+        for (server_id = 0; server_id < pdc_server_num_g; server_id++) {
+            if (bufs[server_id].handle != NULL)
+                HG_Destroy(bufs[server_id].handle);
+            if (bufs[server_id].bulk_handle != HG_BULK_NULL)
+                HG_Bulk_free(bufs[server_id].bulk_handle);
+            free(bufs[server_id].data);
+        }
+        free(bufs);
+    }
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Client_delete_obj_ref_from_dart_batch(dart_hash_algo_t hash_algo, int n, char **attr_keys,
+                                          char **attr_vals, dart_object_ref_type_t ref_type ATTRIBUTE(unused),
+                                          uint64_t *data)
+{
+    return dart_perform_batch_on_servers(OP_DELETE, hash_algo, n, attr_keys, attr_vals, data);
+}
+
+perr_t
+PDC_Client_insert_obj_ref_into_dart_batch(dart_hash_algo_t hash_algo, int n, char **attr_keys,
+                                          char **attr_vals, dart_object_ref_type_t ref_type ATTRIBUTE(unused),
+                                          uint64_t *data)
+{
+    return dart_perform_batch_on_servers(OP_INSERT, hash_algo, n, attr_keys, attr_vals, data);
+}
+
 /******************** METADATA INDEX ENDS ***********************************/
 
 /******************** Collective Object Selection Query Starts *******************************/
@@ -8949,11 +9473,8 @@ PDC_assign_server(int32_t *my_server_start, int32_t *my_server_end, int32_t *my_
 perr_t
 PDC_Client_query_kvtag_col(const pdc_kvtag_t *kvtag, int *n_res, uint64_t **pdc_ids, int *query_sent)
 {
-    perr_t    ret_value = SUCCEED;
-    int32_t   my_server_start, my_server_end, my_server_count;
-    int32_t   i;
-    int       nmeta    = 0;
-    uint64_t *temp_ids = NULL;
+    perr_t  ret_value = SUCCEED;
+    int32_t my_server_start, my_server_end, my_server_count;
 
     FUNC_ENTER(NULL);
 
@@ -8962,31 +9483,16 @@ PDC_Client_query_kvtag_col(const pdc_kvtag_t *kvtag, int *n_res, uint64_t **pdc_
     *n_res      = 0;
     *pdc_ids    = NULL;
     *query_sent = 1;
-    for (i = my_server_start; i < my_server_end; i++) {
-        if (i >= pdc_server_num_g) {
-            *query_sent = 0;
-            break;
-        }
-        /* printf("==PDC_CLIENT[%d]: querying server %u\n", pdc_client_mpi_rank_g, i); */
-        temp_ids  = NULL;
-        ret_value = PDC_Client_query_kvtag_server((uint32_t)i, kvtag, &nmeta, &temp_ids);
-        if (ret_value != SUCCEED) {
-            PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error in %s querying server %u", pdc_client_mpi_rank_g,
-                        __func__, i);
-        }
-        if (i == my_server_start) {
-            *pdc_ids = temp_ids;
-        }
-        else if (nmeta > 0) {
-            *pdc_ids = (uint64_t *)realloc(*pdc_ids, sizeof(uint64_t) * (*n_res + nmeta));
-            memcpy(*pdc_ids + (*n_res), temp_ids, nmeta * sizeof(uint64_t));
-            free(temp_ids);
-        }
-        *n_res = *n_res + nmeta;
-        /* printf("==PDC_CLIENT[%d]: server %u returned %d res \n", pdc_client_mpi_rank_g, i, *n_res); */
-        *query_sent = 1;
+    if (my_server_end > pdc_server_num_g) {
+        my_server_end = pdc_server_num_g;
+        *query_sent   = 0;
     }
 
+    ret_value = PDC_Client_query_kvtag_servers(kvtag, my_server_start, my_server_end, n_res, pdc_ids);
+    if (ret_value != SUCCEED)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[%d]: error in %s querying servers %d to %d", pdc_client_mpi_rank_g,
+                    __func__, my_server_start, my_server_end - 1);
+
 done:
     memory_debug_g = 1;
     fflush(stdout);
@@ -14,10 +14,12 @@ typedef enum { PDC_OP_NONE = 0, PDC_GT = 1, PDC_LT = 2, PDC_GTE = 3, PDC_LTE = 4
 typedef enum { PDC_QUERY_NONE = 0, PDC_QUERY_AND = 1, PDC_QUERY_OR = 2 } pdc_query_combine_op_t;
 
 typedef enum {
-    PDC_QUERY_GET_NONE  = 0,
-    PDC_QUERY_GET_NHITS = 1,
-    PDC_QUERY_GET_SEL   = 2,
-    PDC_QUERY_GET_DATA  = 3
+    PDC_QUERY_GET_NONE   = 0,
+    PDC_QUERY_GET_NHITS  = 1,
+    PDC_QUERY_GET_SEL    = 2,
+    PDC_QUERY_GET_DATA   = 3,
+    PDC_QUERY_GET_CURSOR = 4,
+    PDC_QUERY_GET_AGG    = 5
 } pdc_query_get_op_t;
 
 typedef struct pdcquery_selection_t {
@@ -28,6 +30,32 @@ typedef struct pdcquery_selection_t {
     uint64_t  coords_alloc;
 } pdc_selection_t;
 
+/*
+ * Position in the result of a query that stays on the servers, so the hits can be fetched in pieces. Each
+ * server keeps the hits it found, the result is their pieces in server order.
+ */
+typedef struct pdc_query_cursor_t {
+    pdcid_t   query_id;
+    int       server_id; // Server whose hits are fetched next
+    size_t    ndim;
+    uint64_t  nhits;        // Total number of hits
+    uint64_t  pos;          // Number of hits already fetched
+    uint64_t *server_nhits; // Number of hits found by each server
+    uint64_t  server_pos;   // Number of hits already fetched from server_id
+} pdc_query_cursor_t;
+
+/*
+ * Reduction of the values of an object at the hits of a query, computed by the servers
+ */
+typedef struct pdc_query_agg_t {
+    uint64_t         count;
+    double           sum;
+    double           min; // Undefined when count is 0
+    double           max; // Undefined when count is 0
+    double           mean;
+    pdc_histogram_t *hist; // NULL when count is 0
+} pdc_query_agg_t;
+
 typedef struct pdc_query_constraint_t {
     pdcid_t          obj_id;
     pdc_query_op_t   op;
@@ -195,6 +223,75 @@ perr_t PDCquery_get_histogram(pdcid_t obj_id);
  */
 perr_t PDCquery_get_sel_data(pdc_query_t *query, pdc_selection_t *sel, void *data);
 
+/**
+ * Get the count, sum, min, max, mean and histogram of the values of an object at the hits of a query. The
+ * servers reduce the values of their storage regions and merge the partial results, only the aggregate is
+ * sent to the client.
+ *
+ * \param query [IN]             Query
+ * \param obj_id [IN]            Object ID, one of the queried objects or an object with the same region
+ *                               layout
+ * \param agg [OUT]              Aggregate, free its histogram with PDCquery_agg_free
+ *
+ * \return Non-negative on success/Negative on failure, which includes hits whose values are not stored on
+ *         the server that found them
+ */
+perr_t PDCquery_get_aggregate(pdc_query_t *query, pdcid_t obj_id, pdc_query_agg_t *agg);
+
+/**
+ * Free the histogram of an aggregate
+ *
+ * \param agg [IN]               Aggregate
+ */
+void PDCquery_agg_free(pdc_query_agg_t *agg);
+
+/**
+ * Evaluate a query and keep its result on the servers, so that the hits can be fetched a few at a time
+ * instead of all at once
+ *
+ * \param query [IN]             Query
+ * \param cursor [OUT]           Cursor on the result, cursor->nhits is the total number of hits
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDCquery_cursor_open(pdc_query_t *query, pdc_query_cursor_t *cursor);
+
+/**
+ * Fetch the coordinates of the next hits of a cursor
+ *
+ * \param cursor [IN]            Cursor
+ * \param max_hits [IN]          Maximum number of hits
+ * \param sel [IN/OUT]           Selection that receives the hits, its coordinates are reused when large
+ *                               enough, sel->nhits is 0 at the end of the result. Free it with
+ *                               PDCselection_free
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDCquery_cursor_next_sel(pdc_query_cursor_t *cursor, uint64_t max_hits, pdc_selection_t *sel);
+
+/**
+ * Fetch the data of an object at the next hits of a cursor
+ *
+ * \param cursor [IN]            Cursor
+ * \param obj_id [IN]            Object ID
+ * \param max_bytes [IN]         Size of data
+ * \param data [OUT]             Values of the object at the hits, as many as fit in max_bytes
+ * \param nbytes [OUT]           Number of bytes written to data, 0 at the end of the result
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDCquery_cursor_next_data(pdc_query_cursor_t *cursor, pdcid_t obj_id, uint64_t max_bytes, void *data,
+                                 uint64_t *nbytes);
+
+/**
+ * Free the result of a cursor on the servers
+ *
+ * \param cursor [IN]            Cursor
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDCquery_cursor_close(pdc_query_cursor_t *cursor);
+
 /**
  * ********
  *
@@ -18,6 +18,7 @@
 #include "pdc_client_connect.h"
 #include "pdc_query.h"
 #include "pdc_obj_pkg.h"
+#include "pdc_hist_pkg.h"
 
 pdc_query_t *
 PDCquery_create(pdcid_t obj_id, pdc_query_op_t op, pdc_var_type_t type, void *value)
@@ -263,13 +264,53 @@ PDCquery_get_nhits(pdc_query_t *query, uint64_t *n)
     if (query == NULL || n == NULL)
         PGOTO_ERROR(FAIL, "==PDC input NULL!");
 
-    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_NHITS, n, NULL, NULL);
+    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_NHITS, 0, n, NULL, NULL);
 
 done:
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
 
+perr_t
+PDCquery_get_aggregate(pdc_query_t *query, pdcid_t obj_id, pdc_query_agg_t *agg)
+{
+    perr_t                ret_value = SUCCEED;
+    struct _pdc_obj_info *obj_prop;
+    uint64_t              meta_id;
+
+    FUNC_ENTER(NULL);
+
+    if (query == NULL || agg == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[] input NULL!");
+
+    if (PDC_find_id(obj_id) != NULL) {
+        obj_prop = PDC_obj_get_info(obj_id);
+        meta_id  = obj_prop->obj_info_pub->meta_id;
+    }
+    else
+        meta_id = obj_id;
+
+    memset(agg, 0, sizeof(pdc_query_agg_t));
+    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_AGG, meta_id, NULL, NULL, agg);
+
+done:
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDCquery_agg_free(pdc_query_agg_t *agg)
+{
+    FUNC_ENTER(NULL);
+
+    if (agg && agg->hist) {
+        PDC_free_hist(agg->hist);
+        agg->hist = NULL;
+    }
+
+    FUNC_LEAVE_VOID;
+}
+
 perr_t
 PDCquery_get_selection(pdc_query_t *query, pdc_selection_t *sel)
 {
@@ -281,7 +322,90 @@ PDCquery_get_selection(pdc_query_t *query, pdc_selection_t *sel)
         PGOTO_ERROR(FAIL, "==PDC_CLIENT[] input NULL!");
 
     memset(sel, 0, sizeof(pdc_selection_t));
-    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_SEL, NULL, sel, NULL);
+    ret_value = PDC_send_data_query(query, PDC_QUERY_GET_SEL, 0, NULL, sel, NULL);
+
+done:
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDCquery_cursor_open(pdc_query_t *query, pdc_query_cursor_t *cursor)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    if (query == NULL || cursor == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[] input NULL!");
+
+    ret_value = PDC_Client_query_cursor_open(query, cursor);
+
+done:
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDCquery_cursor_next_sel(pdc_query_cursor_t *cursor, uint64_t max_hits, pdc_selection_t *sel)
+{
+    perr_t    ret_value = SUCCEED;
+    uint64_t  need, nhits = 0, nbytes;
+    uint64_t *coords;
+
+    FUNC_ENTER(NULL);
+
+    if (cursor == NULL || sel == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[] input NULL!");
+
+    sel->query_id = cursor->query_id;
+    sel->ndim     = cursor->ndim;
+    sel->nhits    = 0;
+    if (cursor->pos >= cursor->nhits || cursor->ndim == 0)
+        PGOTO_DONE(SUCCEED);
+
+    if (max_hits > cursor->nhits - cursor->pos)
+        max_hits = cursor->nhits - cursor->pos;
+    need = max_hits * cursor->ndim;
+    if (need > sel->coords_alloc || sel->coords == NULL) {
+        coords = (uint64_t *)realloc(sel->coords, need * sizeof(uint64_t));
+        if (coords == NULL)
+            PGOTO_ERROR(FAIL, "==PDC_CLIENT[] error allocating %" PRIu64 " hits!", max_hits);
+        sel->coords       = coords;
+        sel->coords_alloc = need;
+    }
+
+    ret_value = PDC_Client_query_cursor_fetch(cursor, 0, max_hits, sel->coords, need * sizeof(uint64_t),
+                                              &nhits, &nbytes);
+    sel->nhits = nhits;
+
+done:
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDCquery_cursor_next_data(pdc_query_cursor_t *cursor, pdcid_t obj_id, uint64_t max_bytes, void *data,
+                          uint64_t *nbytes)
+{
+    perr_t                ret_value = SUCCEED;
+    struct _pdc_obj_info *obj_prop;
+    uint64_t              meta_id, nhits;
+
+    FUNC_ENTER(NULL);
+
+    if (cursor == NULL || data == NULL || nbytes == NULL)
+        PGOTO_ERROR(FAIL, "==PDC_CLIENT[] input NULL!");
+
+    if (PDC_find_id(obj_id) != NULL) {
+        obj_prop = PDC_obj_get_info(obj_id);
+        meta_id  = obj_prop->obj_info_pub->meta_id;
+    }
+    else
+        meta_id = obj_id;
+
+    // The server knows the element size and sends no more hits than fit in data
+    ret_value = PDC_Client_query_cursor_fetch(cursor, meta_id, max_bytes, data, max_bytes, &nhits, nbytes);
 
 done:
     fflush(stdout);
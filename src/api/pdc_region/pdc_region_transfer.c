@@ -44,6 +44,10 @@
 #include "pdc_analysis_pkg.h"
 #include <mpi.h>
 
+// Data of at least this many bytes is sent by start_all from the user buffer instead of being copied into
+// the bulk buffer of its data server.
+#define PDC_REGION_TRANSFER_ZERO_COPY_MIN 65536
+
 // pdc region transfer class. Contains essential information for performing non-blocking PDC client I/O
 // perations.
 typedef struct pdc_transfer_request {
@@ -512,14 +516,51 @@ static_region_partition(char *buf, int ndim, uint64_t unit, pdc_access_t access_
     FUNC_LEAVE(ret_value);
 }
 /*
- * Pack user memory buffer into a contiguous buffer based on local region shape.
+ * Check if the local region is a single contiguous range of the user buffer, that is, it spans whole rows of
+ * every dimension after the first one that has more than one element. The row lengths of the user buffer
+ * are given by dims. On success, offset is set to the position of the range in bytes.
+ */
+static int
+region_buffer_is_contiguous(int local_ndim, uint64_t *dims, uint64_t *local_offset, uint64_t *local_size,
+                            size_t unit, uint64_t *offset)
+{
+    int i, k;
+
+    for (k = 0; k < local_ndim - 1 && local_size[k] == 1; ++k)
+        ;
+    for (i = k + 1; i < local_ndim; ++i) {
+        if (local_size[i] != dims[i])
+            return 0;
+    }
+
+    *offset = local_offset[0];
+    for (i = 1; i < local_ndim; ++i)
+        *offset = *offset * dims[i] + local_offset[i];
+    *offset *= unit;
+
+    return 1;
+}
+
+/*
+ * Row lengths of the user buffer for a transfer, matching the copies done by pack_region_buffer for a write
+ * and by release_region_buffer for a read.
+ */
+static uint64_t *
+region_buffer_dims(uint64_t *obj_dims, uint64_t *local_size, pdc_access_t access_type)
+{
+    return access_type == PDC_WRITE ? local_size : obj_dims;
+}
+
+/*
+ * Pack user memory buffer into a contiguous buffer based on local region shape. When the local region is
+ * already contiguous in the user buffer, new_buf points into the user buffer and nothing is copied.
  */
 static perr_t
 pack_region_buffer(char *buf, uint64_t *obj_dims, size_t total_data_size, int local_ndim,
                    uint64_t *local_offset, uint64_t *local_size, size_t unit, pdc_access_t access_type,
                    char **new_buf)
 {
-    uint64_t i, j;
+    uint64_t i, j, offset;
     perr_t   ret_value = SUCCEED;
     char *   ptr;
 
@@ -532,6 +573,11 @@ pack_region_buffer(char *buf, uint64_t *obj_dims, size_t total_data_size, int lo
         */
         *new_buf = buf + local_offset[0] * unit;
     }
+    else if ((local_ndim == 2 || local_ndim == 3) &&
+             region_buffer_is_contiguous(local_ndim, region_buffer_dims(obj_dims, local_size, access_type),
+                                         local_offset, local_size, unit, &offset)) {
+        *new_buf = buf + offset;
+    }
     else if (local_ndim == 2) {
         *new_buf = (char *)malloc(sizeof(char) * total_data_size);
         if (access_type == PDC_WRITE) {
@@ -1113,15 +1159,24 @@ finish_start_all_requests(pdc_transfer_request_start_all_pkg **write_transfer_re
     return 0;
 }
 
+/*
+ * Pack the requests to one data server. The bulk transfer is made of n_segments pieces of memory that the
+ * server receives as a single buffer of total_buf_size bytes. For a write, the data of a large region is sent
+ * from the user buffer as its own segment, the rest is copied into bulk_buf.
+ */
 static perr_t
 PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **transfer_requests,
                              pdc_access_t access_type, char **bulk_buf_ptr, size_t *total_buf_size_ptr,
-                             char **read_bulk_buf)
+                             char **read_bulk_buf, int *n_segments_ptr, char ***segments_ptr,
+                             hg_size_t **segment_sizes_ptr)
 {
-    perr_t ret_value = SUCCEED;
-    char * bulk_buf, *ptr, *ptr2;
-    size_t total_buf_size, obj_data_size, total_obj_data_size, unit, data_size, metadata_size;
-    int    i, j;
+    perr_t     ret_value = SUCCEED;
+    char *     bulk_buf, *ptr, *ptr2, *segment_start;
+    size_t     total_buf_size, obj_data_size, total_obj_data_size, unit, data_size, metadata_size;
+    size_t     zero_copy_size;
+    int        i, j, n_zero_copy, n_segments, obj_type;
+    char **    segments;
+    hg_size_t *segment_sizes;
 
     FUNC_ENTER(NULL);
     // Calculate how large the final buffer will be
@@ -1134,8 +1189,9 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
      *     obj_ndim: sizeof(int)
      *     remote remote_ndim: sizeof(int)
      *     unit: sizeof(size_t)
+     *     obj_type: sizeof(int)
      */
-    metadata_size = n_objs * (sizeof(pdcid_t) + sizeof(int) * 2 + sizeof(size_t));
+    metadata_size = n_objs * (sizeof(pdcid_t) + sizeof(int) * 3 + sizeof(size_t));
     // printf("checkpoint @ line %d\n", __LINE__);
     // Data size, including region offsets/length pairs and actual data for I/O.
     /*
@@ -1147,6 +1203,8 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
      */
     data_size           = 0;
     total_obj_data_size = 0;
+    zero_copy_size      = 0;
+    n_zero_copy         = 0;
     for (i = 0; i < n_objs; ++i) {
         // printf("checkpoint i = %d, remote_region_size = %lu, unit = %lu @ line %d\n", i,
         // transfer_requests[i]->remote_size[0], transfer_requests[i]->transfer_request->unit,  __LINE__);
@@ -1157,6 +1215,10 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
         if (access_type == PDC_WRITE) {
             data_size += sizeof(uint64_t) * transfer_requests[i]->transfer_request->remote_region_ndim * 3 +
                          obj_data_size;
+            if (obj_data_size >= PDC_REGION_TRANSFER_ZERO_COPY_MIN) {
+                zero_copy_size += obj_data_size;
+                n_zero_copy++;
+            }
         }
         else {
             total_obj_data_size += obj_data_size;
@@ -1177,10 +1239,16 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
     }
     // printf("checkpoint @ line %d, total_buf_size = %lu, metadata_size = %lu, data_size = %lu\n", __LINE__,
     // total_buf_size, metadata_size, data_size);
-    bulk_buf      = (char *)malloc(total_buf_size);
+    // Each region sent in place may split the bulk buffer in two
+    segments      = (char **)malloc(sizeof(char *) * (2 * n_zero_copy + 1));
+    segment_sizes = (hg_size_t *)malloc(sizeof(hg_size_t) * (2 * n_zero_copy + 1));
+    n_segments    = 0;
+
+    bulk_buf      = (char *)malloc(total_buf_size - zero_copy_size);
     *bulk_buf_ptr = bulk_buf;
     ptr           = bulk_buf;
     ptr2          = bulk_buf;
+    segment_start = bulk_buf;
     // Pack metadata
 #define MEMCPY_INC(a, b)                                                                                     \
     {                                                                                                        \
@@ -1194,6 +1262,8 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
         MEMCPY_INC(&(transfer_requests[i]->transfer_request->obj_ndim), sizeof(int));
         MEMCPY_INC(&(transfer_requests[i]->transfer_request->remote_region_ndim), sizeof(int));
         MEMCPY_INC(&unit, sizeof(size_t));
+        obj_type = (int)transfer_requests[i]->transfer_request->mem_type;
+        MEMCPY_INC(&obj_type, sizeof(int));
     }
 
     // printf("checkpoint @ line %d\n", __LINE__);
@@ -1217,10 +1287,32 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
         MEMCPY_INC(transfer_requests[i]->transfer_request->obj_dims,
                    sizeof(uint64_t) * transfer_requests[i]->transfer_request->obj_ndim);
         // Note buf is undefined for PDC_READ
-        if (access_type == PDC_WRITE) {
+        if (access_type == PDC_WRITE && obj_data_size >= PDC_REGION_TRANSFER_ZERO_COPY_MIN) {
+            segments[n_segments]      = segment_start;
+            segment_sizes[n_segments] = ptr - segment_start;
+            n_segments++;
+            segments[n_segments]      = transfer_requests[i]->buf;
+            segment_sizes[n_segments] = obj_data_size;
+            n_segments++;
+            segment_start = ptr;
+        }
+        else if (access_type == PDC_WRITE) {
             MEMCPY_INC(transfer_requests[i]->buf, obj_data_size);
         }
     }
+    if (access_type == PDC_READ) {
+        segments[n_segments]      = bulk_buf;
+        segment_sizes[n_segments] = total_buf_size;
+        n_segments++;
+    }
+    else if (ptr > segment_start) {
+        segments[n_segments]      = segment_start;
+        segment_sizes[n_segments] = ptr - segment_start;
+        n_segments++;
+    }
+    *n_segments_ptr     = n_segments;
+    *segments_ptr       = segments;
+    *segment_sizes_ptr  = segment_sizes;
     *total_buf_size_ptr = total_buf_size;
     fflush(stdout);
     FUNC_LEAVE(ret_value);
@@ -1229,14 +1321,17 @@ PDC_Client_pack_all_requests(int n_objs, pdc_transfer_request_start_all_pkg **tr
 static perr_t
 PDC_Client_start_all_requests(pdc_transfer_request_start_all_pkg **transfer_requests, int size)
 {
-    perr_t    ret_value = SUCCEED;
-    int       index, i, j;
-    int       n_objs;
-    uint64_t *metadata_id;
-    char **   read_bulk_buf;
-    char *    bulk_buf;
-    size_t    bulk_buf_size;
-    int *     bulk_buf_ref;
+    perr_t     ret_value = SUCCEED;
+    int        index, i, j;
+    int        n_objs;
+    uint64_t * metadata_id;
+    char **    read_bulk_buf;
+    char *     bulk_buf;
+    size_t     bulk_buf_size;
+    int *      bulk_buf_ref;
+    int        n_segments;
+    char **    segments;
+    hg_size_t *segment_sizes;
 
     FUNC_ENTER(NULL);
     metadata_id   = (uint64_t *)malloc(sizeof(uint64_t) * size);
@@ -1248,14 +1343,17 @@ PDC_Client_start_all_requests(pdc_transfer_request_start_all_pkg **transfer_requ
             n_objs = i - index;
             PDC_Client_pack_all_requests(n_objs, transfer_requests + index,
                                          transfer_requests[index]->transfer_request->access_type, &bulk_buf,
-                                         &bulk_buf_size, read_bulk_buf + index);
+                                         &bulk_buf_size, read_bulk_buf + index, &n_segments, &segments,
+                                         &segment_sizes);
             bulk_buf_ref    = (int *)malloc(sizeof(int));
             bulk_buf_ref[0] = n_objs;
             // printf("checkpoint @ line %d, index = %d, dataserver_id = %d, n_objs = %d\n", __LINE__, index,
             // transfer_requests[index]->data_server_id, n_objs);
             PDC_Client_transfer_request_all(n_objs, transfer_requests[index]->transfer_request->access_type,
-                                            transfer_requests[index]->data_server_id, bulk_buf, bulk_buf_size,
-                                            metadata_id + index);
+                                            transfer_requests[index]->data_server_id, n_segments, segments,
+                                            segment_sizes, bulk_buf_size, metadata_id + index);
+            free(segments);
+            free(segment_sizes);
             // printf("transfer request towards data server %d\n", transfer_requests[index]->data_server_id);
             for (j = index; j < i; ++j) {
                 // All requests share the same bulk buffer, reference counter is also shared among all
@@ -1282,15 +1380,18 @@ PDC_Client_start_all_requests(pdc_transfer_request_start_all_pkg **transfer_requ
         // printf("checkpoint @ line %d\n", __LINE__);
         PDC_Client_pack_all_requests(n_objs, transfer_requests + index,
                                      transfer_requests[index]->transfer_request->access_type, &bulk_buf,
-                                     &bulk_buf_size, read_bulk_buf + index);
+                                     &bulk_buf_size, read_bulk_buf + index, &n_segments, &segments,
+                                     &segment_sizes);
         // printf("checkpoint @ line %d\n", __LINE__);
         bulk_buf_ref    = (int *)malloc(sizeof(int));
         bulk_buf_ref[0] = n_objs;
         // printf("checkpoint @ line %d, index = %d, dataserver_id = %d, n_objs = %d\n", __LINE__, index,
         // transfer_requests[index]->data_server_id, n_objs);
         PDC_Client_transfer_request_all(n_objs, transfer_requests[index]->transfer_request->access_type,
-                                        transfer_requests[index]->data_server_id, bulk_buf, bulk_buf_size,
-                                        metadata_id + index);
+                                        transfer_requests[index]->data_server_id, n_segments, segments,
+                                        segment_sizes, bulk_buf_size, metadata_id + index);
+        free(segments);
+        free(segment_sizes);
         // printf("transfer request towards data server %d\n", transfer_requests[index]->data_server_id);
         for (j = index; j < size; ++j) {
             // All requests share the same bulk buffer, reference counter is also shared among all
@@ -1495,7 +1596,7 @@ PDCregion_transfer_start(pdcid_t transfer_request_id)
                 transfer_request->output_buf[i], transfer_request->obj_id, transfer_request->obj_servers[i],
                 transfer_request->obj_ndim, transfer_request->obj_dims, transfer_request->remote_region_ndim,
                 transfer_request->output_offsets[i], transfer_request->output_sizes[i], unit,
-                transfer_request->access_type, transfer_request->metadata_id + i);
+                transfer_request->mem_type, transfer_request->access_type, transfer_request->metadata_id + i);
         }
     }
     else if (transfer_request->region_partition == PDC_OBJ_STATIC) {
@@ -1514,7 +1615,7 @@ PDCregion_transfer_start(pdcid_t transfer_request_id)
             transfer_request->new_buf, transfer_request->obj_id, transfer_request->data_server_id,
             transfer_request->obj_ndim, transfer_request->obj_dims, transfer_request->remote_region_ndim,
             transfer_request->remote_region_offset, transfer_request->remote_region_size, unit,
-            transfer_request->access_type, transfer_request->metadata_id);
+            transfer_request->mem_type, transfer_request->access_type, transfer_request->metadata_id);
     }
 
     // For POSIX consistency, we block here until the data is received by the server
@@ -1532,13 +1633,19 @@ release_region_buffer(char *buf, uint64_t *obj_dims, int local_ndim, uint64_t *l
                       uint64_t *local_size, size_t unit, pdc_access_t access_type, int bulk_buf_size,
                       char *new_buf, char **bulk_buf, int **bulk_buf_ref, char **read_bulk_buf)
 {
-    uint64_t i, j;
-    int      k;
+    uint64_t i, j, offset;
+    int      k, in_place = 0;
 
     perr_t ret_value = SUCCEED;
     char * ptr;
     FUNC_ENTER(NULL);
-    if (local_ndim == 2) {
+    // A buffer packed in place is the user buffer itself, see pack_region_buffer
+    if (local_ndim > 1 && new_buf &&
+        region_buffer_is_contiguous(local_ndim, region_buffer_dims(obj_dims, local_size, access_type),
+                                    local_offset, local_size, unit, &offset))
+        in_place = new_buf == buf + offset;
+
+    if (local_ndim == 2 && !in_place) {
         if (access_type == PDC_READ) {
             ptr = new_buf;
             for (i = 0; i < local_size[0]; ++i) {
@@ -1548,7 +1655,7 @@ release_region_buffer(char *buf, uint64_t *obj_dims, int local_ndim, uint64_t *l
             }
         }
     }
-    else if (local_ndim == 3) {
+    else if (local_ndim == 3 && !in_place) {
         if (access_type == PDC_READ) {
             ptr = new_buf;
             for (i = 0; i < local_size[0]; ++i) {
@@ -1575,7 +1682,7 @@ release_region_buffer(char *buf, uint64_t *obj_dims, int local_ndim, uint64_t *l
         free(bulk_buf_ref);
         free(bulk_buf);
     }
-    if (local_ndim > 1 && new_buf) {
+    if (local_ndim > 1 && new_buf && !in_place) {
         free(new_buf);
     }
     if (read_bulk_buf) {
@@ -1665,7 +1772,9 @@ PDCregion_transfer_status(pdcid_t transfer_request_id, pdc_transfer_status_t *co
                         }
                         printf("\n");
             */
-            if (transfer_request->access_type == PDC_READ) {
+            // A single start reads directly into new_buf
+            if (transfer_request->access_type == PDC_READ &&
+                transfer_request->new_buf != transfer_request->read_bulk_buf[0]) {
                 // printf("copy %lu bytes of data\n", transfer_request->total_data_size);
                 memcpy(transfer_request->new_buf, transfer_request->read_bulk_buf[0],
                        transfer_request->total_data_size);
@@ -1857,7 +1966,8 @@ PDCregion_transfer_wait_all(pdcid_t *transfer_request_id, int size)
         unit             = transfer_request->unit;
 
         if (transfer_request->region_partition == PDC_OBJ_STATIC &&
-            transfer_request->access_type == PDC_READ) {
+            transfer_request->access_type == PDC_READ &&
+            transfer_request->new_buf != transfer_request->read_bulk_buf[0]) {
             memcpy(transfer_request->new_buf, transfer_request->read_bulk_buf[0],
                    transfer_request->total_data_size);
         }
@@ -1977,7 +2087,9 @@ PDCregion_transfer_wait(pdcid_t transfer_request_id)
                         }
                         printf("\n");
             */
-            if (transfer_request->access_type == PDC_READ) {
+            // A single start reads directly into new_buf
+            if (transfer_request->access_type == PDC_READ &&
+                transfer_request->new_buf != transfer_request->read_bulk_buf[0]) {
                 // printf("copy %lu bytes of data\n", transfer_request->total_data_size);
                 memcpy(transfer_request->new_buf, transfer_request->read_bulk_buf[0],
                        transfer_request->total_data_size);
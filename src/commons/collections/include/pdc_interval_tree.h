@@ -0,0 +1,84 @@
+#ifndef PDC_INTERVAL_TREE_H
+#define PDC_INTERVAL_TREE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * An augmented AVL tree of half-open intervals [start, end).
+ * Every node keeps the largest end point of its subtree, so stabbing and overlap queries
+ * only descend into subtrees that can contain a hit. Duplicate intervals are allowed as
+ * long as they carry different data pointers.
+ */
+typedef struct pdc_interval_node_t {
+    uint64_t                    start;
+    uint64_t                    end;
+    uint64_t                    max_end; // Largest end point in this subtree.
+    void *                      data;
+    int                         height;
+    struct pdc_interval_node_t *left;
+    struct pdc_interval_node_t *right;
+} pdc_interval_node_t;
+
+typedef struct {
+    pdc_interval_node_t *root;
+    size_t               count;
+} pdc_interval_tree_t;
+
+/**
+ * Callback invoked for every interval that overlaps a query.
+ * Return 0 to continue the search, nonzero to stop it.
+ */
+typedef int (*pdc_interval_visit_func)(uint64_t start, uint64_t end, void *data, void *arg);
+
+/**
+ * Creates an empty interval tree.
+ * @return A pointer to the new tree, NULL on allocation failure.
+ */
+pdc_interval_tree_t *pdc_interval_tree_new();
+
+/**
+ * Frees the tree and all of its nodes. The data pointers are not freed.
+ * @param tree The tree to free.
+ */
+void pdc_interval_tree_free(pdc_interval_tree_t *tree);
+
+/**
+ * Removes every interval from the tree, leaving it empty.
+ * @param tree The tree to clear.
+ */
+void pdc_interval_tree_clear(pdc_interval_tree_t *tree);
+
+/**
+ * Inserts [start, end) with its data pointer.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_interval_tree_insert(pdc_interval_tree_t *tree, uint64_t start, uint64_t end, void *data);
+
+/**
+ * Removes the interval [start, end) that carries the given data pointer.
+ * @return 0 if it was found and removed, -1 otherwise.
+ */
+int pdc_interval_tree_remove(pdc_interval_tree_t *tree, uint64_t start, uint64_t end, void *data);
+
+/**
+ * Visits all intervals overlapping [start, end) in ascending order of their start points.
+ * @return Number of intervals visited.
+ */
+size_t pdc_interval_tree_search(pdc_interval_tree_t *tree, uint64_t start, uint64_t end,
+                                pdc_interval_visit_func func, void *arg);
+
+/**
+ * @return Number of intervals in the tree.
+ */
+size_t pdc_interval_tree_size(pdc_interval_tree_t *tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PDC_INTERVAL_TREE_H */
@@ -0,0 +1,77 @@
+#ifndef PDC_REGION_INDEX_H
+#define PDC_REGION_INDEX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "pdc_interval_tree.h"
+#include "pdc_rtree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Spatial index over PDC regions described by offset/size arrays.
+ * 1D regions are kept in an interval tree, N-D regions in an R-tree.
+ */
+typedef struct {
+    int ndim;
+    union {
+        pdc_interval_tree_t *itree;
+        pdc_rtree_t *        rtree;
+    } impl;
+} pdc_region_index_t;
+
+/**
+ * Callback invoked for every indexed region overlapping a query region.
+ * Return 0 to continue the search, nonzero to stop it.
+ */
+typedef int (*pdc_region_index_visit_func)(void *data, void *arg);
+
+/**
+ * Creates an empty index for regions of ndim dimensions.
+ * @return A pointer to the new index, NULL on failure.
+ */
+pdc_region_index_t *pdc_region_index_new(int ndim);
+
+/**
+ * Frees the index. The data pointers are not freed.
+ */
+void pdc_region_index_free(pdc_region_index_t *index);
+
+/**
+ * Removes every region from the index.
+ */
+void pdc_region_index_clear(pdc_region_index_t *index);
+
+/**
+ * Adds a region with its data pointer.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_region_index_insert(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size,
+                            void *data);
+
+/**
+ * Removes the region with exactly this offset/size and data pointer.
+ * @return 0 on success, -1 if it was not indexed.
+ */
+int pdc_region_index_remove(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size,
+                            void *data);
+
+/**
+ * Visits every indexed region that overlaps the query region.
+ * @return Number of regions visited.
+ */
+size_t pdc_region_index_search(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size,
+                               pdc_region_index_visit_func func, void *arg);
+
+/**
+ * @return Number of indexed regions.
+ */
+size_t pdc_region_index_size(pdc_region_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PDC_REGION_INDEX_H */
@@ -0,0 +1,150 @@
+#ifndef PDC_ROARING_H
+#define PDC_ROARING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compressed bitmap of 64-bit values, in the style of roaring bitmaps.
+ * Values are split in chunks of 65536 by their high bits. A chunk with few values is stored as a sorted
+ * array of the low 16 bits, a dense chunk as a 1024-word bitset.
+ */
+#define PDC_ROARING_CHUNK_BITS 16
+#define PDC_ROARING_CHUNK_SIZE (1 << PDC_ROARING_CHUNK_BITS)
+#define PDC_ROARING_BITSET_WORDS (PDC_ROARING_CHUNK_SIZE / 64)
+#define PDC_ROARING_ARRAY_MAX 4096
+
+typedef struct {
+    uint64_t  key;   /* value >> PDC_ROARING_CHUNK_BITS */
+    uint32_t  card;  /* number of values in the chunk */
+    uint32_t  alloc; /* capacity of array */
+    uint16_t *array; /* sorted low bits, when card <= PDC_ROARING_ARRAY_MAX */
+    uint64_t *bits;  /* bitset, otherwise */
+} pdc_roaring_container_t;
+
+typedef struct {
+    pdc_roaring_container_t *containers; /* sorted by key */
+    size_t                   n;
+    size_t                   alloc;
+    uint64_t                 card;
+} pdc_roaring_t;
+
+/**
+ * Position of an iteration over the values of a bitmap.
+ */
+typedef struct {
+    const pdc_roaring_t *r;
+    size_t               container;
+    uint32_t             pos;
+} pdc_roaring_iter_t;
+
+/**
+ * Creates an empty bitmap.
+ * @return A pointer to the new bitmap, NULL on failure.
+ */
+pdc_roaring_t *pdc_roaring_new(void);
+
+/**
+ * Frees the bitmap.
+ */
+void pdc_roaring_free(pdc_roaring_t *r);
+
+/**
+ * Removes every value from the bitmap.
+ */
+void pdc_roaring_clear(pdc_roaring_t *r);
+
+/**
+ * Adds a value.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_roaring_add(pdc_roaring_t *r, uint64_t value);
+
+/**
+ * Adds the values i in [0, n) whose bit i % 64 of word mask[i / 64] is set.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_roaring_add_mask(pdc_roaring_t *r, const uint64_t *mask, uint64_t n);
+
+/**
+ * @return 1 if the value is in the bitmap, 0 otherwise.
+ */
+int pdc_roaring_contains(const pdc_roaring_t *r, uint64_t value);
+
+/**
+ * @return Number of values in the bitmap.
+ */
+uint64_t pdc_roaring_cardinality(const pdc_roaring_t *r);
+
+/**
+ * @return Number of bytes used by the bitmap.
+ */
+size_t pdc_roaring_size_in_bytes(const pdc_roaring_t *r);
+
+/**
+ * Sets dst to the union of dst and src.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_roaring_or(pdc_roaring_t *dst, const pdc_roaring_t *src);
+
+/**
+ * Sets dst to the intersection of dst and src.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_roaring_and(pdc_roaring_t *dst, const pdc_roaring_t *src);
+
+/**
+ * Removes the values of src from dst, which is the complement of src within dst.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_roaring_andnot(pdc_roaring_t *dst, const pdc_roaring_t *src);
+
+/**
+ * Sets bit i % 64 of word mask[i / 64] for every value i < n of the bitmap, the other bits are unchanged.
+ */
+void pdc_roaring_or_into_mask(const pdc_roaring_t *r, uint64_t *mask, uint64_t n);
+
+/**
+ * @return Number of bytes written by pdc_roaring_serialize.
+ */
+size_t pdc_roaring_serialized_size(const pdc_roaring_t *r);
+
+/**
+ * Writes the bitmap to buf, which holds at least pdc_roaring_serialized_size bytes.
+ * @return Number of bytes written.
+ */
+size_t pdc_roaring_serialize(const pdc_roaring_t *r, char *buf);
+
+/**
+ * Reads a bitmap written by pdc_roaring_serialize from the size bytes of buf.
+ * @return A pointer to the new bitmap, NULL if buf is malformed or on failure. The number of bytes read is
+ * stored in *used.
+ */
+pdc_roaring_t *pdc_roaring_deserialize(const char *buf, size_t size, size_t *used);
+
+/**
+ * Starts an iteration over the values of the bitmap in ascending order.
+ */
+void pdc_roaring_iter_init(const pdc_roaring_t *r, pdc_roaring_iter_t *iter);
+
+/**
+ * Reads the next values of an iteration.
+ * @return Number of values written to buf, at most n, 0 at the end of the bitmap.
+ */
+size_t pdc_roaring_iter_read(pdc_roaring_iter_t *iter, uint64_t *buf, size_t n);
+
+/**
+ * Skips the next values of an iteration, whole chunks are skipped by their cardinality.
+ * @return Number of values skipped, less than n only at the end of the bitmap.
+ */
+uint64_t pdc_roaring_iter_skip(pdc_roaring_iter_t *iter, uint64_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PDC_ROARING_H */
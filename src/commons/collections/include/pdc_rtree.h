@@ -0,0 +1,99 @@
+#ifndef PDC_RTREE_H
+#define PDC_RTREE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PDC_RTREE_MAX_DIM     4
+#define PDC_RTREE_MAX_ENTRIES 8
+#define PDC_RTREE_MIN_ENTRIES 3
+
+/**
+ * Axis-aligned box, lo inclusive and hi exclusive in every dimension.
+ */
+typedef struct {
+    uint64_t lo[PDC_RTREE_MAX_DIM];
+    uint64_t hi[PDC_RTREE_MAX_DIM];
+} pdc_rtree_rect_t;
+
+/**
+ * A node holds up to PDC_RTREE_MAX_ENTRIES entries. Leaf entries point to user data, internal
+ * entries point to child nodes. One extra slot is reserved for the entry that triggers a split.
+ */
+typedef struct pdc_rtree_node_t {
+    int                      leaf;
+    int                      count;
+    pdc_rtree_rect_t         rect[PDC_RTREE_MAX_ENTRIES + 1];
+    void *                   child[PDC_RTREE_MAX_ENTRIES + 1];
+    struct pdc_rtree_node_t *parent;
+} pdc_rtree_node_t;
+
+/**
+ * Guttman R-tree with quadratic split for indexing N-D regions (ndim <= PDC_RTREE_MAX_DIM).
+ */
+typedef struct {
+    int               ndim;
+    size_t            count;
+    pdc_rtree_node_t *root;
+} pdc_rtree_t;
+
+/**
+ * Callback invoked for every box that overlaps a query.
+ * Return 0 to continue the search, nonzero to stop it.
+ */
+typedef int (*pdc_rtree_visit_func)(const pdc_rtree_rect_t *rect, void *data, void *arg);
+
+/**
+ * Creates an empty R-tree for boxes of ndim dimensions.
+ * @return A pointer to the new tree, NULL if ndim is out of range or allocation fails.
+ */
+pdc_rtree_t *pdc_rtree_new(int ndim);
+
+/**
+ * Frees the tree and all of its nodes. The data pointers are not freed.
+ */
+void pdc_rtree_free(pdc_rtree_t *tree);
+
+/**
+ * Removes every box from the tree, leaving it empty.
+ */
+void pdc_rtree_clear(pdc_rtree_t *tree);
+
+/**
+ * Builds a box from an offset/size pair as used by PDC regions.
+ */
+void pdc_rtree_rect_set(pdc_rtree_rect_t *rect, int ndim, const uint64_t *offset, const uint64_t *size);
+
+/**
+ * Inserts a box and its data pointer.
+ * @return 0 on success, -1 on failure.
+ */
+int pdc_rtree_insert(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, void *data);
+
+/**
+ * Removes the entry with exactly this box and data pointer.
+ * @return 0 if it was found and removed, -1 otherwise.
+ */
+int pdc_rtree_remove(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, void *data);
+
+/**
+ * Visits all boxes that overlap the query box.
+ * @return Number of boxes visited.
+ */
+size_t pdc_rtree_search(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, pdc_rtree_visit_func func,
+                        void *arg);
+
+/**
+ * @return Number of boxes in the tree.
+ */
+size_t pdc_rtree_size(pdc_rtree_t *tree);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PDC_RTREE_H */
@@ -0,0 +1,237 @@
+#include "pdc_interval_tree.h"
+
+static int
+node_height(pdc_interval_node_t *node)
+{
+    return node == NULL ? 0 : node->height;
+}
+
+static void
+node_update(pdc_interval_node_t *node)
+{
+    int lh = node_height(node->left), rh = node_height(node->right);
+
+    node->height  = (lh > rh ? lh : rh) + 1;
+    node->max_end = node->end;
+    if (node->left != NULL && node->left->max_end > node->max_end)
+        node->max_end = node->left->max_end;
+    if (node->right != NULL && node->right->max_end > node->max_end)
+        node->max_end = node->right->max_end;
+}
+
+static pdc_interval_node_t *
+rotate_right(pdc_interval_node_t *node)
+{
+    pdc_interval_node_t *pivot = node->left;
+
+    node->left   = pivot->right;
+    pivot->right = node;
+    node_update(node);
+    node_update(pivot);
+    return pivot;
+}
+
+static pdc_interval_node_t *
+rotate_left(pdc_interval_node_t *node)
+{
+    pdc_interval_node_t *pivot = node->right;
+
+    node->right = pivot->left;
+    pivot->left = node;
+    node_update(node);
+    node_update(pivot);
+    return pivot;
+}
+
+static pdc_interval_node_t *
+rebalance(pdc_interval_node_t *node)
+{
+    int balance;
+
+    node_update(node);
+    balance = node_height(node->left) - node_height(node->right);
+    if (balance > 1) {
+        if (node_height(node->left->left) < node_height(node->left->right))
+            node->left = rotate_left(node->left);
+        return rotate_right(node);
+    }
+    if (balance < -1) {
+        if (node_height(node->right->right) < node_height(node->right->left))
+            node->right = rotate_right(node->right);
+        return rotate_left(node);
+    }
+    return node;
+}
+
+// Total order on (start, end, data) so that identical intervals with different payloads coexist.
+static int
+key_compare(uint64_t start, uint64_t end, void *data, pdc_interval_node_t *node)
+{
+    if (start != node->start)
+        return start < node->start ? -1 : 1;
+    if (end != node->end)
+        return end < node->end ? -1 : 1;
+    if (data != node->data)
+        return (uintptr_t)data < (uintptr_t)node->data ? -1 : 1;
+    return 0;
+}
+
+static pdc_interval_node_t *
+node_insert(pdc_interval_node_t *node, pdc_interval_node_t *new_node)
+{
+    if (node == NULL)
+        return new_node;
+    if (key_compare(new_node->start, new_node->end, new_node->data, node) < 0)
+        node->left = node_insert(node->left, new_node);
+    else
+        node->right = node_insert(node->right, new_node);
+    return rebalance(node);
+}
+
+static pdc_interval_node_t *
+node_remove_min(pdc_interval_node_t *node, pdc_interval_node_t **min)
+{
+    if (node->left == NULL) {
+        *min = node;
+        return node->right;
+    }
+    node->left = node_remove_min(node->left, min);
+    return rebalance(node);
+}
+
+static pdc_interval_node_t *
+node_remove(pdc_interval_node_t *node, uint64_t start, uint64_t end, void *data, int *found)
+{
+    pdc_interval_node_t *min, *ret;
+    int                  cmp;
+
+    if (node == NULL)
+        return NULL;
+    cmp = key_compare(start, end, data, node);
+    if (cmp < 0) {
+        node->left = node_remove(node->left, start, end, data, found);
+    }
+    else if (cmp > 0) {
+        node->right = node_remove(node->right, start, end, data, found);
+    }
+    else {
+        *found = 1;
+        if (node->left == NULL || node->right == NULL) {
+            ret = node->left != NULL ? node->left : node->right;
+            free(node);
+            return ret;
+        }
+        node->right = node_remove_min(node->right, &min);
+        min->left   = node->left;
+        min->right  = node->right;
+        free(node);
+        return rebalance(min);
+    }
+    return rebalance(node);
+}
+
+static void
+node_free(pdc_interval_node_t *node)
+{
+    if (node == NULL)
+        return;
+    node_free(node->left);
+    node_free(node->right);
+    free(node);
+}
+
+// Returns nonzero when the callback asked to stop.
+static int
+node_search(pdc_interval_node_t *node, uint64_t start, uint64_t end, pdc_interval_visit_func func, void *arg,
+            size_t *nvisit)
+{
+    if (node == NULL || node->max_end <= start)
+        return 0;
+    if (node_search(node->left, start, end, func, arg, nvisit))
+        return 1;
+    // Nodes on the right all start at or after this node, so nothing more can overlap.
+    if (node->start >= end)
+        return 0;
+    if (node->end > start) {
+        (*nvisit)++;
+        if (func != NULL && func(node->start, node->end, node->data, arg))
+            return 1;
+    }
+    return node_search(node->right, start, end, func, arg, nvisit);
+}
+
+pdc_interval_tree_t *
+pdc_interval_tree_new()
+{
+    return (pdc_interval_tree_t *)calloc(1, sizeof(pdc_interval_tree_t));
+}
+
+void
+pdc_interval_tree_free(pdc_interval_tree_t *tree)
+{
+    if (tree == NULL)
+        return;
+    node_free(tree->root);
+    free(tree);
+}
+
+void
+pdc_interval_tree_clear(pdc_interval_tree_t *tree)
+{
+    node_free(tree->root);
+    tree->root  = NULL;
+    tree->count = 0;
+}
+
+int
+pdc_interval_tree_insert(pdc_interval_tree_t *tree, uint64_t start, uint64_t end, void *data)
+{
+    pdc_interval_node_t *node;
+
+    if (tree == NULL || end < start)
+        return -1;
+    node = (pdc_interval_node_t *)calloc(1, sizeof(pdc_interval_node_t));
+    if (node == NULL)
+        return -1;
+    node->start   = start;
+    node->end     = end;
+    node->max_end = end;
+    node->data    = data;
+    node->height  = 1;
+
+    tree->root = node_insert(tree->root, node);
+    tree->count++;
+    return 0;
+}
+
+int
+pdc_interval_tree_remove(pdc_interval_tree_t *tree, uint64_t start, uint64_t end, void *data)
+{
+    int found = 0;
+
+    if (tree == NULL)
+        return -1;
+    tree->root = node_remove(tree->root, start, end, data, &found);
+    if (!found)
+        return -1;
+    tree->count--;
+    return 0;
+}
+
+size_t
+pdc_interval_tree_search(pdc_interval_tree_t *tree, uint64_t start, uint64_t end,
+                         pdc_interval_visit_func func, void *arg)
+{
+    size_t nvisit = 0;
+
+    if (tree == NULL || end <= start)
+        return 0;
+    node_search(tree->root, start, end, func, arg, &nvisit);
+    return nvisit;
+}
+
+size_t
+pdc_interval_tree_size(pdc_interval_tree_t *tree)
+{
+    return tree == NULL ? 0 : tree->count;
+}
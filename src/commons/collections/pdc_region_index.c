@@ -0,0 +1,130 @@
+#include "pdc_region_index.h"
+
+typedef struct {
+    pdc_region_index_visit_func func;
+    void *                      arg;
+} region_index_visit_t;
+
+static int
+interval_visit(uint64_t start, uint64_t end, void *data, void *arg)
+{
+    region_index_visit_t *visit = (region_index_visit_t *)arg;
+
+    (void)start;
+    (void)end;
+    return visit->func == NULL ? 0 : visit->func(data, visit->arg);
+}
+
+static int
+rtree_visit(const pdc_rtree_rect_t *rect, void *data, void *arg)
+{
+    region_index_visit_t *visit = (region_index_visit_t *)arg;
+
+    (void)rect;
+    return visit->func == NULL ? 0 : visit->func(data, visit->arg);
+}
+
+pdc_region_index_t *
+pdc_region_index_new(int ndim)
+{
+    pdc_region_index_t *index;
+
+    if (ndim <= 0 || ndim > PDC_RTREE_MAX_DIM)
+        return NULL;
+    index = (pdc_region_index_t *)calloc(1, sizeof(pdc_region_index_t));
+    if (index == NULL)
+        return NULL;
+    index->ndim = ndim;
+    if (ndim == 1) {
+        index->impl.itree = pdc_interval_tree_new();
+        if (index->impl.itree == NULL)
+            goto fail;
+    }
+    else {
+        index->impl.rtree = pdc_rtree_new(ndim);
+        if (index->impl.rtree == NULL)
+            goto fail;
+    }
+    return index;
+
+fail:
+    free(index);
+    return NULL;
+}
+
+void
+pdc_region_index_free(pdc_region_index_t *index)
+{
+    if (index == NULL)
+        return;
+    if (index->ndim == 1)
+        pdc_interval_tree_free(index->impl.itree);
+    else
+        pdc_rtree_free(index->impl.rtree);
+    free(index);
+}
+
+void
+pdc_region_index_clear(pdc_region_index_t *index)
+{
+    if (index == NULL)
+        return;
+    if (index->ndim == 1)
+        pdc_interval_tree_clear(index->impl.itree);
+    else
+        pdc_rtree_clear(index->impl.rtree);
+}
+
+int
+pdc_region_index_insert(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size, void *data)
+{
+    pdc_rtree_rect_t rect;
+
+    if (index == NULL)
+        return -1;
+    if (index->ndim == 1)
+        return pdc_interval_tree_insert(index->impl.itree, offset[0], offset[0] + size[0], data);
+    pdc_rtree_rect_set(&rect, index->ndim, offset, size);
+    return pdc_rtree_insert(index->impl.rtree, &rect, data);
+}
+
+int
+pdc_region_index_remove(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size, void *data)
+{
+    pdc_rtree_rect_t rect;
+
+    if (index == NULL)
+        return -1;
+    if (index->ndim == 1)
+        return pdc_interval_tree_remove(index->impl.itree, offset[0], offset[0] + size[0], data);
+    pdc_rtree_rect_set(&rect, index->ndim, offset, size);
+    return pdc_rtree_remove(index->impl.rtree, &rect, data);
+}
+
+size_t
+pdc_region_index_search(pdc_region_index_t *index, const uint64_t *offset, const uint64_t *size,
+                        pdc_region_index_visit_func func, void *arg)
+{
+    region_index_visit_t visit;
+    pdc_rtree_rect_t     rect;
+
+    if (index == NULL)
+        return 0;
+    visit.func = func;
+    visit.arg  = arg;
+    if (index->ndim == 1)
+        return pdc_interval_tree_search(index->impl.itree, offset[0], offset[0] + size[0], interval_visit,
+                                        &visit);
+    pdc_rtree_rect_set(&rect, index->ndim, offset, size);
+    return pdc_rtree_search(index->impl.rtree, &rect, rtree_visit, &visit);
+}
+
+size_t
+pdc_region_index_size(pdc_region_index_t *index)
+{
+    if (index == NULL)
+        return 0;
+    if (index->ndim == 1)
+        return pdc_interval_tree_size(index->impl.itree);
+    return pdc_rtree_size(index->impl.rtree);
+}
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+#include "pdc_region_index.h"
+
+#define NREGION 2000
+#define NQUERY  500
+
+typedef struct {
+    uint64_t offset[3];
+    uint64_t size[3];
+    int      indexed;
+} test_region_t;
+
+static test_region_t regions[NREGION];
+
+static int
+count_visit(void *data, void *arg)
+{
+    int *seen = (int *)arg;
+
+    seen[(test_region_t *)data - regions]++;
+    return 0;
+}
+
+static int
+overlaps(int ndim, test_region_t *r, uint64_t *offset, uint64_t *size)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        if (r->offset[i] >= offset[i] + size[i] || offset[i] >= r->offset[i] + r->size[i])
+            return 0;
+    }
+    return 1;
+}
+
+static void
+random_box(int ndim, uint64_t *offset, uint64_t *size)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        offset[i] = rand() % 1000;
+        size[i]   = 1 + rand() % 50;
+    }
+}
+
+static int
+run_test(int ndim)
+{
+    pdc_region_index_t *index = pdc_region_index_new(ndim);
+    uint64_t            offset[3], size[3];
+    int                 seen[NREGION];
+    int                 i, j, round, nerror = 0;
+
+    memset(regions, 0, sizeof(regions));
+    for (round = 0; round < 3; round++) {
+        // Insert the regions that are not indexed, then drop every third one.
+        for (i = 0; i < NREGION; i++) {
+            if (!regions[i].indexed) {
+                random_box(ndim, regions[i].offset, regions[i].size);
+                pdc_region_index_insert(index, regions[i].offset, regions[i].size, &regions[i]);
+                regions[i].indexed = 1;
+            }
+        }
+        for (i = round; i < NREGION; i += 3) {
+            if (pdc_region_index_remove(index, regions[i].offset, regions[i].size, &regions[i]) != 0) {
+                printf("ndim %d: failed to remove region %d\n", ndim, i);
+                nerror++;
+            }
+            regions[i].indexed = 0;
+        }
+
+        for (j = 0; j < NQUERY; j++) {
+            random_box(ndim, offset, size);
+            memset(seen, 0, sizeof(seen));
+            pdc_region_index_search(index, offset, size, count_visit, seen);
+            for (i = 0; i < NREGION; i++) {
+                if (seen[i] != (regions[i].indexed && overlaps(ndim, &regions[i], offset, size))) {
+                    printf("ndim %d: region %d seen %d times\n", ndim, i, seen[i]);
+                    nerror++;
+                }
+            }
+        }
+    }
+    pdc_region_index_free(index);
+    return nerror;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ndim, nerror = 0;
+
+    (void)argc;
+    (void)argv;
+    srand(1234);
+    for (ndim = 1; ndim <= 3; ndim++)
+        nerror += run_test(ndim);
+
+    printf("pdc_region_index_test: %s\n", nerror == 0 ? "passed" : "FAILED");
+    return nerror == 0 ? 0 : 1;
+}
@@ -0,0 +1,791 @@
+#include <string.h>
+#include "pdc_roaring.h"
+
+#define CHUNK_MASK (PDC_ROARING_CHUNK_SIZE - 1)
+
+static uint32_t
+bitset_count(const uint64_t *words)
+{
+    uint32_t count = 0;
+    int      i;
+
+    for (i = 0; i < PDC_ROARING_BITSET_WORDS; i++)
+        count += __builtin_popcountll(words[i]);
+    return count;
+}
+
+static void
+container_free(pdc_roaring_container_t *c)
+{
+    free(c->array);
+    free(c->bits);
+    c->array = NULL;
+    c->bits  = NULL;
+    c->card  = 0;
+    c->alloc = 0;
+}
+
+static int
+container_contains(const pdc_roaring_container_t *c, uint16_t low)
+{
+    uint32_t lo = 0, hi = c->card, mid;
+
+    if (c->bits != NULL)
+        return (c->bits[low / 64] >> (low % 64)) & 1;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (c->array[mid] < low)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < c->card && c->array[lo] == low;
+}
+
+static void
+container_to_bitset(const pdc_roaring_container_t *c, uint64_t *words)
+{
+    uint32_t i;
+
+    if (c->bits != NULL) {
+        memcpy(words, c->bits, PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+        return;
+    }
+    memset(words, 0, PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+    for (i = 0; i < c->card; i++)
+        words[c->array[i] / 64] |= 1ULL << (c->array[i] % 64);
+}
+
+/*
+ * Replace the content of a container with a bitset, kept as an array when it is sparse. A dense *words is
+ * adopted by the container and set to NULL.
+ */
+static int
+container_from_bitset(pdc_roaring_container_t *c, uint64_t **words)
+{
+    uint32_t  card = bitset_count(*words), n = 0, i;
+    uint64_t  word;
+    uint16_t *array;
+
+    if (card > PDC_ROARING_ARRAY_MAX) {
+        container_free(c);
+        c->bits = *words;
+        c->card = card;
+        *words  = NULL;
+        return 0;
+    }
+
+    array = NULL;
+    if (card > 0) {
+        array = (uint16_t *)malloc(card * sizeof(uint16_t));
+        if (array == NULL)
+            return -1;
+        for (i = 0; i < PDC_ROARING_BITSET_WORDS; i++) {
+            word = (*words)[i];
+            while (word != 0) {
+                array[n++] = (uint16_t)(i * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+    container_free(c);
+    c->array = array;
+    c->card  = card;
+    c->alloc = card;
+    return 0;
+}
+
+static int
+container_copy(pdc_roaring_container_t *dst, const pdc_roaring_container_t *src)
+{
+    memset(dst, 0, sizeof(pdc_roaring_container_t));
+    dst->key  = src->key;
+    dst->card = src->card;
+    if (src->bits != NULL) {
+        dst->bits = (uint64_t *)malloc(PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+        if (dst->bits == NULL)
+            return -1;
+        memcpy(dst->bits, src->bits, PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+    }
+    else if (src->card > 0) {
+        dst->array = (uint16_t *)malloc(src->card * sizeof(uint16_t));
+        if (dst->array == NULL)
+            return -1;
+        memcpy(dst->array, src->array, src->card * sizeof(uint16_t));
+        dst->alloc = src->card;
+    }
+    return 0;
+}
+
+static int
+container_or(pdc_roaring_container_t *a, const pdc_roaring_container_t *b)
+{
+    uint64_t *words;
+    uint16_t *array;
+    uint32_t  i = 0, j = 0, n = 0, alloc = a->card + b->card + 1;
+    int       ret;
+
+    if (a->bits == NULL && b->bits == NULL && a->card + b->card <= PDC_ROARING_ARRAY_MAX) {
+        array = (uint16_t *)malloc(alloc * sizeof(uint16_t));
+        if (array == NULL)
+            return -1;
+        while (i < a->card || j < b->card) {
+            if (j == b->card || (i < a->card && a->array[i] < b->array[j]))
+                array[n++] = a->array[i++];
+            else if (i == a->card || b->array[j] < a->array[i])
+                array[n++] = b->array[j++];
+            else {
+                array[n++] = a->array[i++];
+                j++;
+            }
+        }
+        free(a->array);
+        a->array = array;
+        a->card  = n;
+        a->alloc = alloc;
+        return 0;
+    }
+
+    words = (uint64_t *)malloc(PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+    if (words == NULL)
+        return -1;
+    container_to_bitset(a, words);
+    if (b->bits != NULL) {
+        for (i = 0; i < PDC_ROARING_BITSET_WORDS; i++)
+            words[i] |= b->bits[i];
+    }
+    else {
+        for (i = 0; i < b->card; i++)
+            words[b->array[i] / 64] |= 1ULL << (b->array[i] % 64);
+    }
+    ret = container_from_bitset(a, &words);
+    free(words);
+    return ret;
+}
+
+/*
+ * Keep the values of a that are (keep_common = 1) or are not (keep_common = 0) in b
+ */
+static int
+container_filter(pdc_roaring_container_t *a, const pdc_roaring_container_t *b, int keep_common)
+{
+    uint64_t *words;
+    uint16_t *array;
+    uint32_t  i, n = 0;
+    int       ret;
+
+    if (a->bits == NULL) {
+        for (i = 0; i < a->card; i++) {
+            if (container_contains(b, a->array[i]) == keep_common)
+                a->array[n++] = a->array[i];
+        }
+        a->card = n;
+        return 0;
+    }
+
+    // The intersection of a bitset with an array is an array
+    if (keep_common && b->bits == NULL) {
+        array = (uint16_t *)malloc((b->card + 1) * sizeof(uint16_t));
+        if (array == NULL)
+            return -1;
+        for (i = 0; i < b->card; i++) {
+            if (container_contains(a, b->array[i]))
+                array[n++] = b->array[i];
+        }
+        container_free(a);
+        a->array = array;
+        a->card  = n;
+        a->alloc = b->card + 1;
+        return 0;
+    }
+
+    words = a->bits;
+    if (b->bits != NULL) {
+        for (i = 0; i < PDC_ROARING_BITSET_WORDS; i++)
+            words[i] &= keep_common ? b->bits[i] : ~b->bits[i];
+    }
+    else {
+        for (i = 0; i < b->card; i++)
+            words[b->array[i] / 64] &= ~(1ULL << (b->array[i] % 64));
+    }
+    a->bits = NULL;
+    ret     = container_from_bitset(a, &words);
+    if (ret != 0) {
+        a->bits = words;
+        a->card = bitset_count(words);
+        return ret;
+    }
+    free(words);
+    return ret;
+}
+
+/*
+ * Index of the container with a key, or of the first container with a larger key
+ */
+static size_t
+roaring_find(const pdc_roaring_t *r, uint64_t key)
+{
+    size_t lo = 0, hi = r->n, mid;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (r->containers[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static pdc_roaring_container_t *
+roaring_get_container(pdc_roaring_t *r, uint64_t key)
+{
+    pdc_roaring_container_t *containers;
+    size_t                   idx = roaring_find(r, key), alloc;
+
+    if (idx < r->n && r->containers[idx].key == key)
+        return &r->containers[idx];
+
+    if (r->n == r->alloc) {
+        alloc = r->alloc == 0 ? 8 : r->alloc * 2;
+        containers =
+            (pdc_roaring_container_t *)realloc(r->containers, alloc * sizeof(pdc_roaring_container_t));
+        if (containers == NULL)
+            return NULL;
+        r->containers = containers;
+        r->alloc      = alloc;
+    }
+    memmove(&r->containers[idx + 1], &r->containers[idx], (r->n - idx) * sizeof(pdc_roaring_container_t));
+    memset(&r->containers[idx], 0, sizeof(pdc_roaring_container_t));
+    r->containers[idx].key = key;
+    r->n++;
+    return &r->containers[idx];
+}
+
+/*
+ * Drop the empty containers and recount the values
+ */
+static void
+roaring_compact(pdc_roaring_t *r)
+{
+    size_t i, n = 0;
+
+    r->card = 0;
+    for (i = 0; i < r->n; i++) {
+        if (r->containers[i].card == 0) {
+            container_free(&r->containers[i]);
+            continue;
+        }
+        r->card += r->containers[i].card;
+        r->containers[n++] = r->containers[i];
+    }
+    r->n = n;
+}
+
+pdc_roaring_t *
+pdc_roaring_new(void)
+{
+    return (pdc_roaring_t *)calloc(1, sizeof(pdc_roaring_t));
+}
+
+void
+pdc_roaring_free(pdc_roaring_t *r)
+{
+    if (r == NULL)
+        return;
+    pdc_roaring_clear(r);
+    free(r->containers);
+    free(r);
+}
+
+void
+pdc_roaring_clear(pdc_roaring_t *r)
+{
+    size_t i;
+
+    if (r == NULL)
+        return;
+    for (i = 0; i < r->n; i++)
+        container_free(&r->containers[i]);
+    r->n    = 0;
+    r->card = 0;
+}
+
+int
+pdc_roaring_add(pdc_roaring_t *r, uint64_t value)
+{
+    pdc_roaring_container_t *c;
+    uint16_t                 low = (uint16_t)(value & CHUNK_MASK), *array;
+    uint64_t *               words;
+    uint32_t                 i;
+    int                      ret;
+
+    if (r == NULL)
+        return -1;
+    c = roaring_get_container(r, value >> PDC_ROARING_CHUNK_BITS);
+    if (c == NULL)
+        return -1;
+    if (container_contains(c, low))
+        return 0;
+
+    if (c->bits != NULL) {
+        c->bits[low / 64] |= 1ULL << (low % 64);
+    }
+    else if (c->card < PDC_ROARING_ARRAY_MAX) {
+        if (c->card == c->alloc) {
+            array = (uint16_t *)realloc(c->array, (c->alloc == 0 ? 4 : c->alloc * 2) * sizeof(uint16_t));
+            if (array == NULL)
+                return -1;
+            c->array = array;
+            c->alloc = c->alloc == 0 ? 4 : c->alloc * 2;
+        }
+        for (i = c->card; i > 0 && c->array[i - 1] > low; i--)
+            c->array[i] = c->array[i - 1];
+        c->array[i] = low;
+    }
+    else {
+        words = (uint64_t *)malloc(PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+        if (words == NULL)
+            return -1;
+        container_to_bitset(c, words);
+        words[low / 64] |= 1ULL << (low % 64);
+        ret = container_from_bitset(c, &words);
+        free(words);
+        r->card++;
+        return ret;
+    }
+    c->card++;
+    r->card++;
+    return 0;
+}
+
+int
+pdc_roaring_add_mask(pdc_roaring_t *r, const uint64_t *mask, uint64_t n)
+{
+    pdc_roaring_container_t *c;
+    uint64_t *               words = NULL, start, nword, i, nset;
+    int                      ret   = 0;
+
+    if (r == NULL || (mask == NULL && n > 0))
+        return -1;
+
+    for (start = 0; start < n; start += PDC_ROARING_CHUNK_SIZE) {
+        nword = (n - start + 63) / 64;
+        if (nword > PDC_ROARING_BITSET_WORDS)
+            nword = PDC_ROARING_BITSET_WORDS;
+
+        nset = 0;
+        for (i = 0; i < nword; i++)
+            nset |= mask[start / 64 + i];
+        if (nset == 0)
+            continue;
+
+        if (words == NULL) {
+            words = (uint64_t *)malloc(PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+            if (words == NULL) {
+                ret = -1;
+                break;
+            }
+        }
+        c = roaring_get_container(r, start >> PDC_ROARING_CHUNK_BITS);
+        if (c == NULL) {
+            ret = -1;
+            break;
+        }
+        container_to_bitset(c, words);
+        for (i = 0; i < nword; i++)
+            words[i] |= mask[start / 64 + i];
+        // Ignore the bits past n in the last word
+        if (start + nword * 64 > n)
+            words[nword - 1] &= ~0ULL >> (start + nword * 64 - n);
+        if (container_from_bitset(c, &words) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+
+    free(words);
+    roaring_compact(r);
+    return ret;
+}
+
+int
+pdc_roaring_contains(const pdc_roaring_t *r, uint64_t value)
+{
+    size_t idx;
+
+    if (r == NULL)
+        return 0;
+    idx = roaring_find(r, value >> PDC_ROARING_CHUNK_BITS);
+    if (idx == r->n || r->containers[idx].key != value >> PDC_ROARING_CHUNK_BITS)
+        return 0;
+    return container_contains(&r->containers[idx], (uint16_t)(value & CHUNK_MASK));
+}
+
+uint64_t
+pdc_roaring_cardinality(const pdc_roaring_t *r)
+{
+    return r == NULL ? 0 : r->card;
+}
+
+size_t
+pdc_roaring_size_in_bytes(const pdc_roaring_t *r)
+{
+    size_t size, i;
+
+    if (r == NULL)
+        return 0;
+    size = sizeof(pdc_roaring_t) + r->alloc * sizeof(pdc_roaring_container_t);
+    for (i = 0; i < r->n; i++) {
+        if (r->containers[i].bits != NULL)
+            size += PDC_ROARING_BITSET_WORDS * sizeof(uint64_t);
+        else
+            size += r->containers[i].alloc * sizeof(uint16_t);
+    }
+    return size;
+}
+
+int
+pdc_roaring_or(pdc_roaring_t *dst, const pdc_roaring_t *src)
+{
+    pdc_roaring_container_t *containers;
+    size_t                   i = 0, j = 0, n = 0, alloc;
+
+    if (dst == NULL || src == NULL)
+        return -1;
+    if (src->n == 0)
+        return 0;
+
+    alloc      = dst->n + src->n;
+    containers = (pdc_roaring_container_t *)malloc(alloc * sizeof(pdc_roaring_container_t));
+    if (containers == NULL)
+        return -1;
+
+    while (i < dst->n || j < src->n) {
+        if (j == src->n || (i < dst->n && dst->containers[i].key < src->containers[j].key)) {
+            containers[n++] = dst->containers[i++];
+        }
+        else if (i == dst->n || src->containers[j].key < dst->containers[i].key) {
+            if (container_copy(&containers[n], &src->containers[j]) != 0)
+                break;
+            n++;
+            j++;
+        }
+        else {
+            containers[n] = dst->containers[i++];
+            if (container_or(&containers[n], &src->containers[j++]) != 0) {
+                n++;
+                break;
+            }
+            n++;
+        }
+    }
+
+    // On failure dst keeps the values merged so far, the remaining containers are moved back
+    while (i < dst->n)
+        containers[n++] = dst->containers[i++];
+
+    free(dst->containers);
+    dst->containers = containers;
+    dst->n          = n;
+    dst->alloc      = alloc;
+    roaring_compact(dst);
+    return j == src->n ? 0 : -1;
+}
+
+static int
+roaring_filter(pdc_roaring_t *dst, const pdc_roaring_t *src, int keep_common)
+{
+    size_t i, j = 0;
+    int    ret = 0;
+
+    if (dst == NULL || src == NULL)
+        return -1;
+
+    for (i = 0; i < dst->n; i++) {
+        while (j < src->n && src->containers[j].key < dst->containers[i].key)
+            j++;
+        if (j < src->n && src->containers[j].key == dst->containers[i].key) {
+            if (container_filter(&dst->containers[i], &src->containers[j], keep_common) != 0)
+                ret = -1;
+        }
+        else if (keep_common) {
+            container_free(&dst->containers[i]);
+        }
+    }
+    roaring_compact(dst);
+    return ret;
+}
+
+int
+pdc_roaring_and(pdc_roaring_t *dst, const pdc_roaring_t *src)
+{
+    return roaring_filter(dst, src, 1);
+}
+
+int
+pdc_roaring_andnot(pdc_roaring_t *dst, const pdc_roaring_t *src)
+{
+    return roaring_filter(dst, src, 0);
+}
+
+void
+pdc_roaring_or_into_mask(const pdc_roaring_t *r, uint64_t *mask, uint64_t n)
+{
+    const pdc_roaring_container_t *c;
+    uint64_t                       base, value, nword, i;
+    size_t                         k;
+    uint32_t                       j;
+
+    if (r == NULL)
+        return;
+    for (k = 0; k < r->n; k++) {
+        c    = &r->containers[k];
+        base = c->key << PDC_ROARING_CHUNK_BITS;
+        if (base >= n)
+            break;
+        if (c->bits == NULL) {
+            for (j = 0; j < c->card; j++) {
+                value = base | c->array[j];
+                if (value >= n)
+                    break;
+                mask[value / 64] |= 1ULL << (value % 64);
+            }
+            continue;
+        }
+        // Chunks start on a word boundary
+        nword = (n - base + 63) / 64;
+        if (nword > PDC_ROARING_BITSET_WORDS)
+            nword = PDC_ROARING_BITSET_WORDS;
+        for (i = 0; i < nword; i++)
+            mask[base / 64 + i] |= c->bits[i];
+        if (base + nword * 64 > n)
+            mask[base / 64 + nword - 1] &= ~0ULL >> (base + nword * 64 - n);
+    }
+}
+
+/*
+ * Each container is stored as its key, its cardinality, whether it is a bitset, then the sorted low bits
+ * or the bitset words
+ */
+size_t
+pdc_roaring_serialized_size(const pdc_roaring_t *r)
+{
+    size_t size = sizeof(uint64_t), k;
+
+    if (r == NULL)
+        return size;
+    for (k = 0; k < r->n; k++) {
+        size += sizeof(uint64_t) + 2 * sizeof(uint32_t);
+        if (r->containers[k].bits != NULL)
+            size += PDC_ROARING_BITSET_WORDS * sizeof(uint64_t);
+        else
+            size += r->containers[k].card * sizeof(uint16_t);
+    }
+    return size;
+}
+
+size_t
+pdc_roaring_serialize(const pdc_roaring_t *r, char *buf)
+{
+    const pdc_roaring_container_t *c;
+    char *                         p = buf;
+    uint64_t                       n = r == NULL ? 0 : r->n;
+    uint32_t                       is_bitset;
+    size_t                         k;
+
+    memcpy(p, &n, sizeof(uint64_t));
+    p += sizeof(uint64_t);
+    for (k = 0; k < n; k++) {
+        c         = &r->containers[k];
+        is_bitset = c->bits != NULL;
+        memcpy(p, &c->key, sizeof(uint64_t));
+        p += sizeof(uint64_t);
+        memcpy(p, &c->card, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        memcpy(p, &is_bitset, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        if (is_bitset) {
+            memcpy(p, c->bits, PDC_ROARING_BITSET_WORDS * sizeof(uint64_t));
+            p += PDC_ROARING_BITSET_WORDS * sizeof(uint64_t);
+        }
+        else {
+            memcpy(p, c->array, c->card * sizeof(uint16_t));
+            p += c->card * sizeof(uint16_t);
+        }
+    }
+    return p - buf;
+}
+
+pdc_roaring_t *
+pdc_roaring_deserialize(const char *buf, size_t size, size_t *used)
+{
+    pdc_roaring_t *          r;
+    pdc_roaring_container_t *c;
+    const char *             p = buf;
+    uint64_t                 n, k, key, prev_key = 0;
+    uint32_t                 card, is_bitset, i;
+    size_t                   data_size;
+
+    if (size < sizeof(uint64_t))
+        return NULL;
+    memcpy(&n, p, sizeof(uint64_t));
+    p += sizeof(uint64_t);
+    if (n > (size - sizeof(uint64_t)) / (sizeof(uint64_t) + 2 * sizeof(uint32_t)))
+        return NULL;
+
+    r = pdc_roaring_new();
+    if (r == NULL)
+        return NULL;
+    if (n > 0) {
+        r->containers = (pdc_roaring_container_t *)calloc(n, sizeof(pdc_roaring_container_t));
+        if (r->containers == NULL)
+            goto error;
+        r->alloc = n;
+    }
+
+    for (k = 0; k < n; k++) {
+        if ((size_t)(p - buf) + sizeof(uint64_t) + 2 * sizeof(uint32_t) > size)
+            goto error;
+        memcpy(&key, p, sizeof(uint64_t));
+        p += sizeof(uint64_t);
+        memcpy(&card, p, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        memcpy(&is_bitset, p, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        // Same invariants as the containers built in memory
+        if ((k > 0 && key <= prev_key) || card == 0 || card > PDC_ROARING_CHUNK_SIZE ||
+            (is_bitset != 0) != (card > PDC_ROARING_ARRAY_MAX))
+            goto error;
+        prev_key = key;
+
+        data_size = is_bitset ? PDC_ROARING_BITSET_WORDS * sizeof(uint64_t) : card * sizeof(uint16_t);
+        if ((size_t)(p - buf) + data_size > size)
+            goto error;
+
+        c      = &r->containers[r->n++];
+        c->key = key;
+        if (is_bitset) {
+            c->bits = (uint64_t *)malloc(data_size);
+            if (c->bits == NULL)
+                goto error;
+            memcpy(c->bits, p, data_size);
+            if (bitset_count(c->bits) != card)
+                goto error;
+        }
+        else {
+            c->array = (uint16_t *)malloc(data_size);
+            if (c->array == NULL)
+                goto error;
+            memcpy(c->array, p, data_size);
+            c->alloc = card;
+            for (i = 1; i < card; i++) {
+                if (c->array[i] <= c->array[i - 1])
+                    goto error;
+            }
+        }
+        c->card = card;
+        r->card += card;
+        p += data_size;
+    }
+
+    if (used != NULL)
+        *used = p - buf;
+    return r;
+
+error:
+    pdc_roaring_free(r);
+    return NULL;
+}
+
+void
+pdc_roaring_iter_init(const pdc_roaring_t *r, pdc_roaring_iter_t *iter)
+{
+    iter->r         = r;
+    iter->container = 0;
+    iter->pos       = 0;
+}
+
+size_t
+pdc_roaring_iter_read(pdc_roaring_iter_t *iter, uint64_t *buf, size_t n)
+{
+    const pdc_roaring_container_t *c;
+    uint64_t                       base, word;
+    size_t                         count = 0;
+
+    if (iter->r == NULL)
+        return 0;
+
+    while (count < n && iter->container < iter->r->n) {
+        c    = &iter->r->containers[iter->container];
+        base = c->key << PDC_ROARING_CHUNK_BITS;
+        if (c->bits == NULL) {
+            while (count < n && iter->pos < c->card)
+                buf[count++] = base | c->array[iter->pos++];
+            if (iter->pos < c->card)
+                break;
+        }
+        else {
+            while (count < n && iter->pos < PDC_ROARING_CHUNK_SIZE) {
+                word = c->bits[iter->pos / 64] >> (iter->pos % 64);
+                if (word == 0) {
+                    iter->pos = (iter->pos / 64 + 1) * 64;
+                    continue;
+                }
+                iter->pos += __builtin_ctzll(word);
+                buf[count++] = base | iter->pos;
+                iter->pos++;
+            }
+            if (iter->pos < PDC_ROARING_CHUNK_SIZE)
+                break;
+        }
+        iter->container++;
+        iter->pos = 0;
+    }
+    return count;
+}
+
+uint64_t
+pdc_roaring_iter_skip(pdc_roaring_iter_t *iter, uint64_t n)
+{
+    const pdc_roaring_container_t *c;
+    uint64_t                       count = 0, word, left;
+
+    if (iter->r == NULL)
+        return 0;
+
+    while (count < n && iter->container < iter->r->n) {
+        c    = &iter->r->containers[iter->container];
+        left = n - count;
+        if (c->bits == NULL) {
+            if (c->card - iter->pos > left) {
+                iter->pos += (uint32_t)left;
+                return n;
+            }
+            count += c->card - iter->pos;
+        }
+        else if (iter->pos == 0 && c->card <= left) {
+            count += c->card;
+        }
+        else {
+            while (iter->pos < PDC_ROARING_CHUNK_SIZE) {
+                word = c->bits[iter->pos / 64] >> (iter->pos % 64);
+                if ((uint64_t)__builtin_popcountll(word) > left) {
+                    // The value to stop at is in this word
+                    for (; left > 0; left--) {
+                        iter->pos += __builtin_ctzll(word) + 1;
+                        word = c->bits[iter->pos / 64] >> (iter->pos % 64);
+                    }
+                    return n;
+                }
+                left -= __builtin_popcountll(word);
+                count += __builtin_popcountll(word);
+                iter->pos = (iter->pos / 64 + 1) * 64;
+            }
+        }
+        iter->container++;
+        iter->pos = 0;
+    }
+    return count;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include "pdc_roaring.h"
+
+#define NVALUE (5 * PDC_ROARING_CHUNK_SIZE + 1234)
+#define NWORD  ((NVALUE + 63) / 64)
+
+static uint64_t ref_a[NWORD], ref_b[NWORD], ref[NWORD], mask[NWORD];
+
+/*
+ * Fill a mask with a density that changes per chunk, so both sparse and dense containers are exercised
+ */
+static void
+random_mask(uint64_t *mask)
+{
+    uint64_t i;
+    int      density, offset = rand();
+
+    memset(mask, 0, NWORD * sizeof(uint64_t));
+    for (i = 0; i < NVALUE; i++) {
+        density = (int)((i / PDC_ROARING_CHUNK_SIZE + offset) % 4);
+        if ((density == 1 && rand() % 100 == 0) || (density == 2 && rand() % 3 == 0) ||
+            (density == 3 && rand() % 10 != 0))
+            mask[i / 64] |= 1ULL << (i % 64);
+    }
+}
+
+static int
+check(const char *name, pdc_roaring_t *r, const uint64_t *expected)
+{
+    pdc_roaring_iter_t iter;
+    uint64_t           buf[1000], card = 0, next = 0, skip = 0, i;
+    size_t             n;
+    int                nerror = 0;
+
+    for (i = 0; i < NVALUE; i++) {
+        if (((expected[i / 64] >> (i % 64)) & 1) != (uint64_t)pdc_roaring_contains(r, i))
+            nerror++;
+        card += (expected[i / 64] >> (i % 64)) & 1;
+    }
+    if (card != pdc_roaring_cardinality(r))
+        nerror++;
+
+    // The iteration returns the values in ascending order
+    pdc_roaring_iter_init(r, &iter);
+    while ((n = pdc_roaring_iter_read(&iter, buf, sizeof(buf) / sizeof(buf[0]))) > 0) {
+        for (i = 0; i < n; i++) {
+            if (buf[i] < next || ((expected[buf[i] / 64] >> (buf[i] % 64)) & 1) == 0)
+                nerror++;
+            next = buf[i] + 1;
+        }
+        card -= n;
+    }
+    if (card != 0)
+        nerror++;
+
+    // Skipping and reading in turn visits the same values as reading only
+    pdc_roaring_iter_init(r, &iter);
+    for (i = 0; i < NVALUE; i++) {
+        if (((expected[i / 64] >> (i % 64)) & 1) == 0)
+            continue;
+        card++;
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        if (pdc_roaring_iter_read(&iter, buf, 1) != 1 || buf[0] != i)
+            nerror++;
+        skip = rand() % 3 == 0 ? rand() % 100000 : rand() % 100;
+        card -= pdc_roaring_iter_skip(&iter, skip) + 1;
+    }
+    // Past the end, nothing is left to skip
+    if (card != 0 || pdc_roaring_iter_skip(&iter, 1) != 0)
+        nerror++;
+
+    if (nerror > 0)
+        printf("%s: %d errors\n", name, nerror);
+    return nerror;
+}
+
+static int
+check_serialize(pdc_roaring_t *r, const uint64_t *expected)
+{
+    pdc_roaring_t *copy;
+    size_t         size = pdc_roaring_serialized_size(r), used = 0;
+    char *         buf  = (char *)malloc(size);
+    int            nerror = 0;
+
+    if (pdc_roaring_serialize(r, buf) != size)
+        nerror++;
+    copy = pdc_roaring_deserialize(buf, size, &used);
+    if (copy == NULL || used != size)
+        nerror++;
+    else
+        nerror += check("serialize", copy, expected);
+
+    // A truncated buffer is rejected
+    if (size > sizeof(uint64_t) && pdc_roaring_deserialize(buf, size - 1, &used) != NULL)
+        nerror++;
+
+    pdc_roaring_free(copy);
+    free(buf);
+    return nerror;
+}
+
+int
+main(int argc, char *argv[])
+{
+    pdc_roaring_t *a, *b, *r;
+    uint64_t       i;
+    int            round, nerror = 0;
+
+    (void)argc;
+    (void)argv;
+    srand(1234);
+    for (round = 0; round < 4; round++) {
+        random_mask(ref_a);
+        random_mask(ref_b);
+
+        a = pdc_roaring_new();
+        b = pdc_roaring_new();
+        pdc_roaring_add_mask(a, ref_a, NVALUE);
+        for (i = 0; i < NVALUE; i++) {
+            if ((ref_b[i / 64] >> (i % 64)) & 1)
+                pdc_roaring_add(b, i);
+        }
+        nerror += check("add_mask", a, ref_a);
+        nerror += check("add", b, ref_b);
+
+        r = pdc_roaring_new();
+        pdc_roaring_or(r, a);
+        pdc_roaring_or(r, b);
+        for (i = 0; i < NWORD; i++)
+            ref[i] = ref_a[i] | ref_b[i];
+        nerror += check("or", r, ref);
+
+        pdc_roaring_clear(r);
+        pdc_roaring_or(r, a);
+        pdc_roaring_and(r, b);
+        for (i = 0; i < NWORD; i++)
+            ref[i] = ref_a[i] & ref_b[i];
+        nerror += check("and", r, ref);
+
+        pdc_roaring_clear(r);
+        pdc_roaring_or(r, a);
+        pdc_roaring_andnot(r, b);
+        for (i = 0; i < NWORD; i++)
+            ref[i] = ref_a[i] & ~ref_b[i];
+        nerror += check("andnot", r, ref);
+
+        // Round trip through the serialized form
+        nerror += check_serialize(r, ref);
+
+        // Setting the bits of a bitmap in a mask
+        memcpy(mask, ref_b, sizeof(mask));
+        pdc_roaring_or_into_mask(a, mask, NVALUE);
+        for (i = 0; i < NWORD; i++) {
+            if (mask[i] != (ref_a[i] | ref_b[i]))
+                nerror++;
+        }
+
+        // Adding a mask on top of existing values is a union
+        pdc_roaring_add_mask(b, ref_a, NVALUE);
+        for (i = 0; i < NWORD; i++)
+            ref[i] = ref_a[i] | ref_b[i];
+        nerror += check("add_mask union", b, ref);
+
+        pdc_roaring_free(a);
+        pdc_roaring_free(b);
+        pdc_roaring_free(r);
+    }
+
+    printf("pdc_roaring_test: %s\n", nerror == 0 ? "passed" : "FAILED");
+    return nerror == 0 ? 0 : 1;
+}
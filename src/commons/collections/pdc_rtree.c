@@ -0,0 +1,494 @@
+#include <string.h>
+#include "pdc_rtree.h"
+
+static double
+rect_volume(int ndim, const pdc_rtree_rect_t *r)
+{
+    double v = 1.0;
+    int    i;
+
+    for (i = 0; i < ndim; i++)
+        v *= (double)(r->hi[i] - r->lo[i]);
+    return v;
+}
+
+static void
+rect_union(int ndim, const pdc_rtree_rect_t *a, const pdc_rtree_rect_t *b, pdc_rtree_rect_t *out)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        out->lo[i] = a->lo[i] < b->lo[i] ? a->lo[i] : b->lo[i];
+        out->hi[i] = a->hi[i] > b->hi[i] ? a->hi[i] : b->hi[i];
+    }
+}
+
+static double
+rect_enlargement(int ndim, const pdc_rtree_rect_t *r, const pdc_rtree_rect_t *add)
+{
+    pdc_rtree_rect_t u;
+
+    rect_union(ndim, r, add, &u);
+    return rect_volume(ndim, &u) - rect_volume(ndim, r);
+}
+
+static int
+rect_overlap(int ndim, const pdc_rtree_rect_t *a, const pdc_rtree_rect_t *b)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        if (a->lo[i] >= b->hi[i] || b->lo[i] >= a->hi[i])
+            return 0;
+    }
+    return 1;
+}
+
+static int
+rect_contains(int ndim, const pdc_rtree_rect_t *outer, const pdc_rtree_rect_t *inner)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        if (inner->lo[i] < outer->lo[i] || inner->hi[i] > outer->hi[i])
+            return 0;
+    }
+    return 1;
+}
+
+static int
+rect_equal(int ndim, const pdc_rtree_rect_t *a, const pdc_rtree_rect_t *b)
+{
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        if (a->lo[i] != b->lo[i] || a->hi[i] != b->hi[i])
+            return 0;
+    }
+    return 1;
+}
+
+static void
+node_cover(int ndim, pdc_rtree_node_t *node, pdc_rtree_rect_t *out)
+{
+    int i;
+
+    *out = node->rect[0];
+    for (i = 1; i < node->count; i++)
+        rect_union(ndim, out, &node->rect[i], out);
+}
+
+static pdc_rtree_node_t *
+node_new(int leaf)
+{
+    pdc_rtree_node_t *node = (pdc_rtree_node_t *)calloc(1, sizeof(pdc_rtree_node_t));
+
+    if (node != NULL)
+        node->leaf = leaf;
+    return node;
+}
+
+static void
+node_free(pdc_rtree_node_t *node)
+{
+    int i;
+
+    if (node == NULL)
+        return;
+    if (!node->leaf) {
+        for (i = 0; i < node->count; i++)
+            node_free((pdc_rtree_node_t *)node->child[i]);
+    }
+    free(node);
+}
+
+static int
+node_index_in_parent(pdc_rtree_node_t *node)
+{
+    int i;
+
+    for (i = 0; i < node->parent->count; i++) {
+        if (node->parent->child[i] == node)
+            return i;
+    }
+    return -1;
+}
+
+static void
+node_add_entry(pdc_rtree_node_t *node, const pdc_rtree_rect_t *rect, void *child)
+{
+    node->rect[node->count]  = *rect;
+    node->child[node->count] = child;
+    if (!node->leaf)
+        ((pdc_rtree_node_t *)child)->parent = node;
+    node->count++;
+}
+
+/*
+ * Quadratic split. The overfull node keeps the first group and the returned sibling gets the second.
+ */
+static pdc_rtree_node_t *
+node_split(int ndim, pdc_rtree_node_t *node)
+{
+    pdc_rtree_rect_t  rect[PDC_RTREE_MAX_ENTRIES + 1], cover[2], u;
+    void *            child[PDC_RTREE_MAX_ENTRIES + 1];
+    int               assigned[PDC_RTREE_MAX_ENTRIES + 1];
+    int               n = node->count, i, j, seed1 = 0, seed2 = 1, remaining, pick, group;
+    double            waste, best, d1, d2, diff;
+    pdc_rtree_node_t *sibling, *target;
+
+    sibling = node_new(node->leaf);
+    if (sibling == NULL)
+        return NULL;
+
+    memcpy(rect, node->rect, sizeof(pdc_rtree_rect_t) * n);
+    memcpy(child, node->child, sizeof(void *) * n);
+    memset(assigned, 0, sizeof(assigned));
+
+    best = -1.0;
+    for (i = 0; i < n; i++) {
+        for (j = i + 1; j < n; j++) {
+            rect_union(ndim, &rect[i], &rect[j], &u);
+            waste = rect_volume(ndim, &u) - rect_volume(ndim, &rect[i]) - rect_volume(ndim, &rect[j]);
+            if (waste > best) {
+                best  = waste;
+                seed1 = i;
+                seed2 = j;
+            }
+        }
+    }
+
+    node->count = 0;
+    node_add_entry(node, &rect[seed1], child[seed1]);
+    node_add_entry(sibling, &rect[seed2], child[seed2]);
+    cover[0]        = rect[seed1];
+    cover[1]        = rect[seed2];
+    assigned[seed1] = 1;
+    assigned[seed2] = 1;
+    remaining       = n - 2;
+
+    while (remaining > 0) {
+        // Make sure both groups end up with at least the minimum number of entries.
+        if (node->count + remaining == PDC_RTREE_MIN_ENTRIES ||
+            sibling->count + remaining == PDC_RTREE_MIN_ENTRIES) {
+            target = node->count + remaining == PDC_RTREE_MIN_ENTRIES ? node : sibling;
+            for (i = 0; i < n; i++) {
+                if (!assigned[i]) {
+                    node_add_entry(target, &rect[i], child[i]);
+                    assigned[i] = 1;
+                }
+            }
+            break;
+        }
+
+        pick = -1;
+        best = -1.0;
+        for (i = 0; i < n; i++) {
+            if (assigned[i])
+                continue;
+            d1   = rect_enlargement(ndim, &cover[0], &rect[i]);
+            d2   = rect_enlargement(ndim, &cover[1], &rect[i]);
+            diff = d1 > d2 ? d1 - d2 : d2 - d1;
+            if (diff > best) {
+                best = diff;
+                pick = i;
+            }
+        }
+
+        d1 = rect_enlargement(ndim, &cover[0], &rect[pick]);
+        d2 = rect_enlargement(ndim, &cover[1], &rect[pick]);
+        if (d1 != d2)
+            group = d1 < d2 ? 0 : 1;
+        else if (rect_volume(ndim, &cover[0]) != rect_volume(ndim, &cover[1]))
+            group = rect_volume(ndim, &cover[0]) < rect_volume(ndim, &cover[1]) ? 0 : 1;
+        else
+            group = node->count <= sibling->count ? 0 : 1;
+
+        node_add_entry(group == 0 ? node : sibling, &rect[pick], child[pick]);
+        rect_union(ndim, &cover[group], &rect[pick], &cover[group]);
+        assigned[pick] = 1;
+        remaining--;
+    }
+    return sibling;
+}
+
+static pdc_rtree_node_t *
+choose_leaf(int ndim, pdc_rtree_node_t *node, const pdc_rtree_rect_t *rect)
+{
+    int    i, best_idx;
+    double enlarge, best_enlarge, vol, best_vol;
+
+    while (!node->leaf) {
+        best_idx     = 0;
+        best_enlarge = rect_enlargement(ndim, &node->rect[0], rect);
+        best_vol     = rect_volume(ndim, &node->rect[0]);
+        for (i = 1; i < node->count; i++) {
+            enlarge = rect_enlargement(ndim, &node->rect[i], rect);
+            vol     = rect_volume(ndim, &node->rect[i]);
+            if (enlarge < best_enlarge || (enlarge == best_enlarge && vol < best_vol)) {
+                best_idx     = i;
+                best_enlarge = enlarge;
+                best_vol     = vol;
+            }
+        }
+        node = (pdc_rtree_node_t *)node->child[best_idx];
+    }
+    return node;
+}
+
+// Walk from a modified node to the root, fixing bounding boxes and splitting overfull parents.
+static int
+adjust_tree(pdc_rtree_t *tree, pdc_rtree_node_t *node, pdc_rtree_node_t *sibling)
+{
+    pdc_rtree_node_t *parent, *new_root;
+    pdc_rtree_rect_t  r;
+    int               idx;
+
+    while (node != tree->root) {
+        parent = node->parent;
+        idx    = node_index_in_parent(node);
+        node_cover(tree->ndim, node, &parent->rect[idx]);
+        if (sibling != NULL) {
+            node_cover(tree->ndim, sibling, &r);
+            node_add_entry(parent, &r, sibling);
+            sibling = NULL;
+            if (parent->count > PDC_RTREE_MAX_ENTRIES) {
+                sibling = node_split(tree->ndim, parent);
+                if (sibling == NULL)
+                    return -1;
+            }
+        }
+        node = parent;
+    }
+
+    if (sibling != NULL) {
+        new_root = node_new(0);
+        if (new_root == NULL)
+            return -1;
+        node_cover(tree->ndim, node, &r);
+        node_add_entry(new_root, &r, node);
+        node_cover(tree->ndim, sibling, &r);
+        node_add_entry(new_root, &r, sibling);
+        new_root->parent = NULL;
+        tree->root       = new_root;
+    }
+    return 0;
+}
+
+static int
+rtree_insert_entry(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, void *data)
+{
+    pdc_rtree_node_t *leaf, *sibling = NULL;
+
+    leaf = choose_leaf(tree->ndim, tree->root, rect);
+    node_add_entry(leaf, rect, data);
+    if (leaf->count > PDC_RTREE_MAX_ENTRIES) {
+        sibling = node_split(tree->ndim, leaf);
+        if (sibling == NULL)
+            return -1;
+    }
+    return adjust_tree(tree, leaf, sibling);
+}
+
+static pdc_rtree_node_t *
+find_leaf(int ndim, pdc_rtree_node_t *node, const pdc_rtree_rect_t *rect, void *data, int *entry_idx)
+{
+    pdc_rtree_node_t *found;
+    int               i;
+
+    for (i = 0; i < node->count; i++) {
+        if (node->leaf) {
+            if (node->child[i] == data && rect_equal(ndim, &node->rect[i], rect)) {
+                *entry_idx = i;
+                return node;
+            }
+        }
+        else if (rect_contains(ndim, &node->rect[i], rect)) {
+            found = find_leaf(ndim, (pdc_rtree_node_t *)node->child[i], rect, data, entry_idx);
+            if (found != NULL)
+                return found;
+        }
+    }
+    return NULL;
+}
+
+static void
+node_remove_entry(pdc_rtree_node_t *node, int idx)
+{
+    node->count--;
+    if (idx != node->count) {
+        node->rect[idx]  = node->rect[node->count];
+        node->child[idx] = node->child[node->count];
+    }
+}
+
+// Move all leaf entries below node into the orphan leaf, then free the subtree.
+static void
+collect_orphans(pdc_rtree_node_t *node, pdc_rtree_rect_t **rects, void ***datas, size_t *n, size_t *cap)
+{
+    int i;
+
+    for (i = 0; i < node->count; i++) {
+        if (node->leaf) {
+            if (*n == *cap) {
+                *cap   = *cap == 0 ? 16 : *cap * 2;
+                *rects = (pdc_rtree_rect_t *)realloc(*rects, sizeof(pdc_rtree_rect_t) * (*cap));
+                *datas = (void **)realloc(*datas, sizeof(void *) * (*cap));
+            }
+            (*rects)[*n] = node->rect[i];
+            (*datas)[*n] = node->child[i];
+            (*n)++;
+        }
+        else {
+            collect_orphans((pdc_rtree_node_t *)node->child[i], rects, datas, n, cap);
+        }
+    }
+    free(node);
+}
+
+pdc_rtree_t *
+pdc_rtree_new(int ndim)
+{
+    pdc_rtree_t *tree;
+
+    if (ndim <= 0 || ndim > PDC_RTREE_MAX_DIM)
+        return NULL;
+    tree = (pdc_rtree_t *)calloc(1, sizeof(pdc_rtree_t));
+    if (tree == NULL)
+        return NULL;
+    tree->ndim = ndim;
+    tree->root = node_new(1);
+    if (tree->root == NULL) {
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+void
+pdc_rtree_free(pdc_rtree_t *tree)
+{
+    if (tree == NULL)
+        return;
+    node_free(tree->root);
+    free(tree);
+}
+
+void
+pdc_rtree_clear(pdc_rtree_t *tree)
+{
+    node_free(tree->root);
+    tree->root  = node_new(1);
+    tree->count = 0;
+}
+
+void
+pdc_rtree_rect_set(pdc_rtree_rect_t *rect, int ndim, const uint64_t *offset, const uint64_t *size)
+{
+    int i;
+
+    memset(rect, 0, sizeof(pdc_rtree_rect_t));
+    for (i = 0; i < ndim && i < PDC_RTREE_MAX_DIM; i++) {
+        rect->lo[i] = offset[i];
+        rect->hi[i] = offset[i] + size[i];
+    }
+}
+
+int
+pdc_rtree_insert(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, void *data)
+{
+    if (tree == NULL || rect == NULL)
+        return -1;
+    if (rtree_insert_entry(tree, rect, data) != 0)
+        return -1;
+    tree->count++;
+    return 0;
+}
+
+int
+pdc_rtree_remove(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, void *data)
+{
+    pdc_rtree_node_t *leaf, *node, *parent, *child;
+    pdc_rtree_rect_t *orphan_rects = NULL;
+    void **           orphan_datas = NULL;
+    size_t            norphan = 0, cap = 0, i;
+    int               idx;
+
+    if (tree == NULL || rect == NULL)
+        return -1;
+    leaf = find_leaf(tree->ndim, tree->root, rect, data, &idx);
+    if (leaf == NULL)
+        return -1;
+    node_remove_entry(leaf, idx);
+    tree->count--;
+
+    // Condense: drop underfull nodes on the way up and remember their entries for reinsertion.
+    node = leaf;
+    while (node != tree->root) {
+        parent = node->parent;
+        idx    = node_index_in_parent(node);
+        if (node->count < PDC_RTREE_MIN_ENTRIES) {
+            node_remove_entry(parent, idx);
+            collect_orphans(node, &orphan_rects, &orphan_datas, &norphan, &cap);
+        }
+        else {
+            node_cover(tree->ndim, node, &parent->rect[idx]);
+        }
+        node = parent;
+    }
+
+    // Shorten the tree when the root is left with a single child.
+    while (!tree->root->leaf && tree->root->count == 1) {
+        child         = (pdc_rtree_node_t *)tree->root->child[0];
+        child->parent = NULL;
+        free(tree->root);
+        tree->root = child;
+    }
+    if (!tree->root->leaf && tree->root->count == 0)
+        tree->root->leaf = 1;
+
+    for (i = 0; i < norphan; i++)
+        rtree_insert_entry(tree, &orphan_rects[i], orphan_datas[i]);
+    free(orphan_rects);
+    free(orphan_datas);
+    return 0;
+}
+
+// Returns nonzero when the callback asked to stop.
+static int
+node_search(int ndim, pdc_rtree_node_t *node, const pdc_rtree_rect_t *rect, pdc_rtree_visit_func func,
+            void *arg, size_t *nvisit)
+{
+    int i;
+
+    for (i = 0; i < node->count; i++) {
+        if (!rect_overlap(ndim, &node->rect[i], rect))
+            continue;
+        if (node->leaf) {
+            (*nvisit)++;
+            if (func != NULL && func(&node->rect[i], node->child[i], arg))
+                return 1;
+        }
+        else if (node_search(ndim, (pdc_rtree_node_t *)node->child[i], rect, func, arg, nvisit)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+size_t
+pdc_rtree_search(pdc_rtree_t *tree, const pdc_rtree_rect_t *rect, pdc_rtree_visit_func func, void *arg)
+{
+    size_t nvisit = 0;
+
+    if (tree == NULL || rect == NULL)
+        return 0;
+    node_search(tree->ndim, tree->root, rect, func, arg, &nvisit);
+    return nvisit;
+}
+
+size_t
+pdc_rtree_size(pdc_rtree_t *tree)
+{
+    return tree == NULL ? 0 : tree->count;
+}
@@ -52,6 +52,29 @@ typedef struct pdc_kvtag_t {
     void *   value;
 } pdc_kvtag_t;
 
+/* Comparison of a numeric kvtag value against one bound of a pdc_kvtag_range_t */
+typedef enum {
+    PDC_KVTAG_OP_NONE = 0, /* the bound is not used */
+    PDC_KVTAG_OP_GT   = 1,
+    PDC_KVTAG_OP_GTE  = 2,
+    PDC_KVTAG_OP_LT   = 3,
+    PDC_KVTAG_OP_LTE  = 4
+} pdc_kvtag_op_t;
+
+/*
+ * Range predicate on the numeric values of a kvtag, e.g. lo_op = PDC_KVTAG_OP_GTE and hi_op = PDC_KVTAG_OP_LT
+ * select the objects with lo <= value < hi. lo and hi point to size bytes of the given type.
+ */
+typedef struct pdc_kvtag_range_t {
+    char *         name;
+    int8_t         type;
+    uint32_t       size;
+    pdc_kvtag_op_t lo_op;
+    void *         lo;
+    pdc_kvtag_op_t hi_op;
+    void *         hi;
+} pdc_kvtag_range_t;
+
 typedef enum { PDC_PERSIST, PDC_TRANSIENT } pdc_lifetime_t;
 
 typedef enum { PDC_SERVER_DEFAULT = 0, PDC_SERVER_PER_CLIENT = 1 } pdc_server_selection_t;
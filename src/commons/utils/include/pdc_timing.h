@@ -113,6 +113,9 @@ typedef struct pdc_server_timing {
     double PDCcache_read;
     double PDCcache_flush;
     double PDCcache_clean;
+    double PDCcache_evict;
+    double PDCcache_evict_count;
+    double PDCcache_evict_bytes;
     double PDCdata_server_write_posix;
     double PDCdata_server_read_posix;
 
@@ -117,4 +117,51 @@ int is_value_match_p(const char *tagslist, const char *tagname, const char *patt
  */
 int is_value_in_range(const char *tagslist, const char *tagname, int from, int to);
 
+/**
+ * Set in pdc_kvtag_t.type when the kvtag carries an encoded pdc_kvtag_range_t instead of a value
+ */
+#define PDC_KVTAG_RANGE_FLAG 0x40
+
+/**
+ * Encode a range predicate into a kvtag, so it can be sent with the kvtag query RPC.
+ * The value of the kvtag is allocated and has to be freed by the caller.
+ * @param range
+ * @param kvtag
+ */
+void kvtag_range_encode(const pdc_kvtag_range_t *range, pdc_kvtag_t *kvtag);
+/**
+ * Decode a range predicate from a kvtag. The bounds of the range point into the value of the kvtag.
+ * @param kvtag
+ * @param range
+ * @return 1 if the kvtag carries a range predicate, 0 otherwise
+ */
+int kvtag_range_decode(const pdc_kvtag_t *kvtag, pdc_kvtag_range_t *range);
+/**
+ * Map a numeric value to an unsigned 64-bit key that sorts in the same order as the value.
+ * Integer types of 1, 2, 4 and 8 bytes, float and double are supported.
+ * @param type
+ * @param value
+ * @param size
+ * @param key
+ * @return 1 on success, 0 if the type cannot be ordered
+ */
+int kvtag_value_ordered_key(int8_t type, const void *value, uint32_t size, uint64_t *key);
+/**
+ * Get the inclusive ordered key bounds [lo, hi] of a range predicate.
+ * @param range
+ * @param lo
+ * @param hi
+ * @return 1 if the range can match a value, 0 if it is empty or its type cannot be ordered
+ */
+int kvtag_range_ordered_bounds(const pdc_kvtag_range_t *range, uint64_t *lo, uint64_t *hi);
+/**
+ * To test if a value of the given type is in a range
+ * @param range
+ * @param type
+ * @param value
+ * @param size
+ * @return 1 if it is, 0 otherwise
+ */
+int kvtag_range_matches(const pdc_kvtag_range_t *range, int8_t type, const void *value, uint32_t size);
+
 #endif // PDC_QUERY_UTILS_H
@@ -482,6 +482,9 @@ PDC_server_timing_report()
     fprintf(stream, "PDCcache_read, %lf\n", pdc_server_timings->PDCcache_read);
     fprintf(stream, "PDCcache_flush, %lf\n", pdc_server_timings->PDCcache_flush);
     fprintf(stream, "PDCcache_clean, %lf\n", pdc_server_timings->PDCcache_clean);
+    fprintf(stream, "PDCcache_evict, %lf\n", pdc_server_timings->PDCcache_evict);
+    fprintf(stream, "PDCcache_evict_count, %lf\n", pdc_server_timings->PDCcache_evict_count);
+    fprintf(stream, "PDCcache_evict_bytes, %lf\n", pdc_server_timings->PDCcache_evict_bytes);
     fprintf(stream, "PDCdata_server_write_posix, %lf\n", pdc_server_timings->PDCdata_server_write_posix);
     fprintf(stream, "PDCdata_server_read_posix, %lf\n", pdc_server_timings->PDCdata_server_read_posix);
 
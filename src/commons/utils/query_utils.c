@@ -344,3 +344,145 @@ is_value_in_range(const char *tagslist, const char *tagname, int from, int to)
     int         v          = atoi(value);
     return (v >= from && v <= to);
 }
+
+void
+kvtag_range_encode(const pdc_kvtag_range_t *range, pdc_kvtag_t *kvtag)
+{
+    char *buf;
+
+    // [lo_op][hi_op][lo][hi], a missing bound is sent as zeros
+    kvtag->name = range->name;
+    kvtag->type = (int8_t)(range->type | PDC_KVTAG_RANGE_FLAG);
+    kvtag->size = 2 + 2 * range->size;
+    buf         = (char *)calloc(kvtag->size, 1);
+    buf[0]      = (char)range->lo_op;
+    buf[1]      = (char)range->hi_op;
+    if (range->lo_op != PDC_KVTAG_OP_NONE)
+        memcpy(buf + 2, range->lo, range->size);
+    if (range->hi_op != PDC_KVTAG_OP_NONE)
+        memcpy(buf + 2 + range->size, range->hi, range->size);
+    kvtag->value = buf;
+}
+
+int
+kvtag_range_decode(const pdc_kvtag_t *kvtag, pdc_kvtag_range_t *range)
+{
+    char *buf = (char *)kvtag->value;
+
+    // A negative type, PDC_UNKNOWN included, has every bit set and is not a range
+    if (kvtag->type < 0 || !(kvtag->type & PDC_KVTAG_RANGE_FLAG) ||
+        (kvtag->type & ~PDC_KVTAG_RANGE_FLAG) >= PDC_TYPE_COUNT || kvtag->size < 2 || kvtag->size % 2 != 0)
+        return 0;
+
+    range->name  = kvtag->name;
+    range->type  = (int8_t)(kvtag->type & ~PDC_KVTAG_RANGE_FLAG);
+    range->size  = (kvtag->size - 2) / 2;
+    range->lo_op = (pdc_kvtag_op_t)buf[0];
+    range->hi_op = (pdc_kvtag_op_t)buf[1];
+    range->lo    = buf + 2;
+    range->hi    = buf + 2 + range->size;
+    return 1;
+}
+
+int
+kvtag_value_ordered_key(int8_t type, const void *value, uint32_t size, uint64_t *key)
+{
+    int64_t  i64;
+    uint64_t u64;
+    double   d;
+
+    switch (type) {
+        case PDC_FLOAT:
+        case PDC_DOUBLE:
+            if (size == sizeof(float))
+                d = *(const float *)value;
+            else if (size == sizeof(double))
+                d = *(const double *)value;
+            else
+                return 0;
+            // Positive doubles sort by their bits, negative ones in the reverse order
+            memcpy(&u64, &d, sizeof(u64));
+            *key = (u64 >> 63) ? ~u64 : u64 ^ (1ULL << 63);
+            return 1;
+        case PDC_INT:
+        case PDC_CHAR:
+        case PDC_SHORT:
+        case PDC_INT64:
+        case PDC_INT16:
+        case PDC_INT8:
+        case PDC_INT32:
+        case PDC_LONG:
+            if (size == 1)
+                i64 = *(const int8_t *)value;
+            else if (size == 2)
+                i64 = *(const int16_t *)value;
+            else if (size == 4)
+                i64 = *(const int32_t *)value;
+            else if (size == 8)
+                i64 = *(const int64_t *)value;
+            else
+                return 0;
+            *key = (uint64_t)i64 ^ (1ULL << 63);
+            return 1;
+        case PDC_BOOLEAN:
+        case PDC_UINT:
+        case PDC_UINT64:
+        case PDC_UINT8:
+        case PDC_UINT16:
+        case PDC_UINT32:
+        case PDC_SIZE_T:
+            if (size == 1)
+                u64 = *(const uint8_t *)value;
+            else if (size == 2)
+                u64 = *(const uint16_t *)value;
+            else if (size == 4)
+                u64 = *(const uint32_t *)value;
+            else if (size == 8)
+                u64 = *(const uint64_t *)value;
+            else
+                return 0;
+            *key = u64;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int
+kvtag_range_ordered_bounds(const pdc_kvtag_range_t *range, uint64_t *lo, uint64_t *hi)
+{
+    *lo = 0;
+    *hi = UINT64_MAX;
+
+    if (range->lo_op != PDC_KVTAG_OP_NONE) {
+        if (!kvtag_value_ordered_key(range->type, range->lo, range->size, lo))
+            return 0;
+        if (range->lo_op == PDC_KVTAG_OP_GT) {
+            if (*lo == UINT64_MAX)
+                return 0;
+            (*lo)++;
+        }
+    }
+    if (range->hi_op != PDC_KVTAG_OP_NONE) {
+        if (!kvtag_value_ordered_key(range->type, range->hi, range->size, hi))
+            return 0;
+        if (range->hi_op == PDC_KVTAG_OP_LT) {
+            if (*hi == 0)
+                return 0;
+            (*hi)--;
+        }
+    }
+    return *lo <= *hi;
+}
+
+int
+kvtag_range_matches(const pdc_kvtag_range_t *range, int8_t type, const void *value, uint32_t size)
+{
+    uint64_t key, lo, hi;
+
+    if (type != range->type || !kvtag_value_ordered_key(type, value, size, &key))
+        return 0;
+    if (!kvtag_range_ordered_bounds(range, &lo, &hi))
+        return 0;
+    return key >= lo && key <= hi;
+}
@@ -117,7 +117,10 @@ typedef enum {
     PDC_BULK_QUERY_COORDS    = 1,
     PDC_BULK_READ_COORDS     = 2,
     PDC_BULK_SEND_QUERY_DATA = 3,
-    PDC_BULK_QUERY_METADATA  = 4
+    PDC_BULK_QUERY_METADATA  = 4,
+    PDC_BULK_QUERY_AGG       = 5,
+    PDC_BULK_DART_INSERT     = 6,
+    PDC_BULK_DART_DELETE     = 7
 } _pdc_bulk_op_t;
 
 typedef struct pdc_metadata_t pdc_metadata_t;
@@ -166,6 +169,7 @@ typedef struct region_list_t {
     char                  shm_addr[ADDR_MAX];
     int                   shm_fd;
     pdc_histogram_t *     region_hist;
+    void *                bitmap_idx; // pdc_bitmap_index_t, see pdc_server_bitmap_index.h
     char *                buf;
     _pdc_data_loc_t       data_loc_type;
     char                  storage_location[ADDR_MAX];
@@ -785,6 +789,7 @@ typedef struct {
     uint64_t               obj_dim1;
     uint64_t               obj_dim2;
     size_t                 remote_unit;
+    int8_t                 obj_type;
     int32_t                obj_ndim;
     uint32_t               meta_server_id;
 
@@ -1105,6 +1110,7 @@ typedef struct pdc_query_xfer_t {
     int                     get_op;
     int                     next_server_id;
     int                     prev_server_id;
+    uint64_t                agg_obj_id; // Object reduced by PDC_QUERY_GET_AGG
     pdc_query_constraint_t *constraints;
     region_info_transfer_t  region;
 } pdc_query_xfer_t;
@@ -1122,6 +1128,25 @@ typedef struct send_nhits_t {
     uint64_t nhits;
 } send_nhits_t;
 
+/* Define query_cursor_fetch_in_t */
+typedef struct query_cursor_fetch_in_t {
+    int       query_id;
+    int       is_close;    // Free the result of the query instead of fetching
+    uint64_t  obj_id;      // 0 to fetch coordinates, otherwise the data of this object at the hits
+    uint64_t  offset;      // Index of the first hit among the hits found by the server
+    uint64_t  cnt;         // Maximum number of hits, also limited by the bulk size
+    hg_bulk_t bulk_handle; // Client buffer the hits are pushed to
+} query_cursor_fetch_in_t;
+
+/* Define query_cursor_fetch_out_t */
+typedef struct query_cursor_fetch_out_t {
+    int32_t  ret;
+    int32_t  ndim;
+    uint64_t nhits;  // Number of hits found by the server, 0 if it did not evaluate the query
+    uint64_t cnt;    // Number of hits pushed
+    uint64_t nbytes; // Number of bytes pushed
+} query_cursor_fetch_out_t;
+
 /* Define query_storage_region_transfer_t */
 typedef struct query_storage_region_transfer_t {
     int                    origin;
@@ -2667,6 +2692,11 @@ hg_proc_transfer_request_in_t(hg_proc_t proc, void *data)
         // HG_LOG_ERROR("Proc error");
         return ret;
     }
+    ret = hg_proc_int8_t(proc, &struct_data->obj_type);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
     ret = hg_proc_int32_t(proc, &struct_data->obj_ndim);
     if (ret != HG_SUCCESS) {
         // HG_LOG_ERROR("Proc error");
@@ -3718,6 +3748,81 @@ hg_proc_send_nhits_t(hg_proc_t proc, void *data)
     return ret;
 }
 
+/* Define hg_proc_query_cursor_fetch_in_t */
+static HG_INLINE hg_return_t
+hg_proc_query_cursor_fetch_in_t(hg_proc_t proc, void *data)
+{
+    hg_return_t              ret;
+    query_cursor_fetch_in_t *struct_data = (query_cursor_fetch_in_t *)data;
+
+    ret = hg_proc_int32_t(proc, &struct_data->query_id);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_int32_t(proc, &struct_data->is_close);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->obj_id);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->offset);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->cnt);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_hg_bulk_t(proc, &struct_data->bulk_handle);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    return ret;
+}
+
+/* Define hg_proc_query_cursor_fetch_out_t */
+static HG_INLINE hg_return_t
+hg_proc_query_cursor_fetch_out_t(hg_proc_t proc, void *data)
+{
+    hg_return_t               ret;
+    query_cursor_fetch_out_t *struct_data = (query_cursor_fetch_out_t *)data;
+
+    ret = hg_proc_int32_t(proc, &struct_data->ret);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_int32_t(proc, &struct_data->ndim);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->nhits);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->cnt);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    ret = hg_proc_uint64_t(proc, &struct_data->nbytes);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
+    return ret;
+}
+
 /* Define hg_proc_query_storage_region_transfer_t */
 static HG_INLINE hg_return_t
 hg_proc_query_storage_region_transfer_t(hg_proc_t proc, void *data)
@@ -4085,17 +4190,20 @@ struct transfer_request_all_local_bulk_args {
     transfer_request_all_in_t in;
     uint64_t *                transfer_request_id;
     void *                    data_buf;
+    transfer_request_all_data request_data;
 #ifdef PDC_TIMING
     double start_time;
 #endif
 };
 
 struct transfer_request_all_local_bulk_args2 {
-    hg_handle_t               handle;
-    transfer_request_all_data request_data;
-    hg_bulk_t                 bulk_handle;
-    uint64_t *                transfer_request_id;
-    void *                    data_buf;
+    hg_handle_t                                  handle;
+    transfer_request_all_data                    request_data;
+    hg_bulk_t                                    bulk_handle;
+    uint64_t *                                   transfer_request_id;
+    void *                                       data_buf;
+    uint64_t                                     total_mem_size;
+    struct transfer_request_all_local_bulk_args *args;
 #ifdef PDC_TIMING
     double start_time;
 #endif
@@ -4121,12 +4229,14 @@ struct transfer_request_metadata_query2_local_bulk_args {
 };
 
 struct transfer_request_local_bulk_args {
-    hg_handle_t           handle;
-    hg_bulk_t             bulk_handle;
-    transfer_request_in_t in;
-    uint64_t              transfer_request_id;
-    void *                data_buf;
-    size_t                total_mem_size;
+    hg_handle_t             handle;
+    hg_bulk_t               bulk_handle;
+    transfer_request_in_t   in;
+    uint64_t                transfer_request_id;
+    void *                  data_buf;
+    size_t                  total_mem_size;
+    struct pdc_region_info *remote_reg_info;
+    uint64_t                obj_dims[3];
 
 #ifdef PDC_TIMING
     double start_time;
@@ -4280,6 +4390,7 @@ hg_id_t PDC_data_server_read_register(hg_class_t *hg_class);
 hg_id_t PDC_send_nhits_register(hg_class_t *hg_class);
 hg_id_t PDC_send_bulk_rpc_register(hg_class_t *hg_class);
 hg_id_t PDC_get_sel_data_rpc_register(hg_class_t *hg_class);
+hg_id_t PDC_query_cursor_fetch_rpc_register(hg_class_t *hg_class);
 
 // Data query
 hg_id_t PDC_send_data_query_rpc_register(hg_class_t *hg_class);
@@ -4821,6 +4932,37 @@ pdc_query_t *PDC_deserialize_query(pdc_query_xfer_t *query_xfer);
  */
 void PDC_query_xfer_free(pdc_query_xfer_t *query_xfer);
 
+/**
+ * Merge a partial aggregate into another, the histograms are merged with PDC_merge_hist
+ *
+ * \param to [IN/OUT]           Aggregate
+ * \param from [IN]             Partial aggregate, left as is
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_query_agg_merge(pdc_query_agg_t *to, pdc_query_agg_t *from);
+
+/**
+ * Pack an aggregate and its histogram into a new buffer, to be sent with the bulk RPC
+ *
+ * \param agg [IN]              Aggregate
+ * \param size [OUT]            Size of the buffer
+ *
+ * \return Pointer to the buffer/NULL on failure
+ */
+void *PDC_query_agg_serialize(pdc_query_agg_t *agg, uint64_t *size);
+
+/**
+ * Unpack an aggregate written by PDC_query_agg_serialize
+ *
+ * \param buf [IN]              Buffer
+ * \param size [IN]             Size of the buffer
+ * \param agg [OUT]             Aggregate, with a new histogram
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_query_agg_deserialize(void *buf, uint64_t size, pdc_query_agg_t *agg);
+
 /**
  * *********
  *
@@ -4832,6 +4974,6 @@ hg_return_t PDC_Client_recv_nhits(const struct hg_cb_info *callback_info);
 
 perr_t PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
                                       struct pdc_region_info *region_info, void *buf, size_t unit,
-                                      int is_write);
+                                      pdc_var_type_t data_type, int is_write);
 
 #endif /* PDC_CLIENT_SERVER_COMMON_H */
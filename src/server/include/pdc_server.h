@@ -98,6 +98,7 @@ hg_thread_mutex_t pdc_server_task_mutex_g;
 
 extern int      n_bloom_total_g;
 extern int      n_bloom_maybe_g;
+extern int      n_bloom_false_g;
 extern double   server_bloom_check_time_g;
 extern double   server_bloom_insert_time_g;
 extern double   server_insert_time_g;
@@ -136,14 +137,14 @@ perr_t PDC_Server_lookup_client(uint32_t client_id);
 perr_t PDC_Server_set_close(void);
 
 /**
- * ***********
+ * Write the metadata of this server to its checkpoint file and drop the metadata log it includes
  *
  * \return Non-negative on success/Negative on failure
  */
 perr_t PDC_Server_checkpoint();
 
 /**
- * ***********
+ * Load the metadata of this server from its checkpoint file and the metadata log written after it
  *
  * \param filename [IN]         File name
  *
@@ -0,0 +1,84 @@
+#ifndef PDC_SERVER_BLOOM_H
+#define PDC_SERVER_BLOOM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Blocked bloom filter.
+ *
+ * The bits are split in blocks of one cache line. A key sets and tests PDC_BLOOM_NHASH bits of a single
+ * block, all derived from one 128-bit hash, so a lookup costs at most one cache miss. Keys cannot be
+ * removed: the owner rebuilds the filter from its live keys once PDC_bloom_is_full reports that more keys
+ * were added than it was sized for, which also drops the bits of the removed keys.
+ */
+
+// Bytes of a block, one cache line
+#define PDC_BLOOM_BLOCK_SIZE 64
+// Bits set per key
+#define PDC_BLOOM_NHASH 8
+// Bits per key at capacity, about 1% false positives
+#define PDC_BLOOM_BITS_PER_KEY 10
+
+typedef struct pdc_bloom_t {
+    uint64_t *blocks;
+    uint64_t  n_block;
+    uint64_t  capacity;
+    uint64_t  n_key;
+} pdc_bloom_t;
+
+/**
+ * Create an empty filter
+ *
+ * \param capacity [IN]         Number of keys it is sized for
+ *
+ * \return Filter, NULL on allocation failure
+ */
+pdc_bloom_t *PDC_bloom_new(uint64_t capacity);
+
+/**
+ * Free a filter
+ *
+ * \param bloom [IN]            Filter
+ */
+void PDC_bloom_free(pdc_bloom_t *bloom);
+
+/**
+ * Add a key
+ *
+ * \param bloom [IN]            Filter
+ * \param key [IN]              Key
+ * \param len [IN]              Length of the key
+ */
+void PDC_bloom_add(pdc_bloom_t *bloom, const void *key, size_t len);
+
+/**
+ * Test a key
+ *
+ * \param bloom [IN]            Filter
+ * \param key [IN]              Key
+ * \param len [IN]              Length of the key
+ *
+ * \return 1 if the key may have been added, 0 if it was not
+ */
+int PDC_bloom_check(const pdc_bloom_t *bloom, const void *key, size_t len);
+
+/**
+ * Check if the filter holds more keys than its capacity
+ *
+ * \param bloom [IN]            Filter
+ *
+ * \return 1 if it should be rebuilt larger, 0 otherwise
+ */
+int PDC_bloom_is_full(const pdc_bloom_t *bloom);
+
+/**
+ * Get the memory used by a filter
+ *
+ * \param bloom [IN]            Filter, can be NULL
+ *
+ * \return Number of bytes
+ */
+uint64_t PDC_bloom_bytes(const pdc_bloom_t *bloom);
+
+#endif /* PDC_SERVER_BLOOM_H */
@@ -0,0 +1,211 @@
+#ifndef PDC_SERVER_CHECKPOINT_H
+#define PDC_SERVER_CHECKPOINT_H
+
+#include <stddef.h>
+#include "pdc_client_server_common.h"
+#include "pdc_server_metadata.h"
+
+/*
+ * Checkpoint file of the metadata of a server.
+ *
+ * The file starts with a pdc_checkpoint_header_t giving the offset and length of each section. Sections are
+ * arrays of fixed-size records without pointers: records refer to strings and arrays in the pool by their
+ * offset in it, and to records of another section by their index. The file can thus be mapped at any
+ * address and read in place, and the objects of different hash buckets can be rebuilt independently.
+ *
+ * The objects of a hash bucket are contiguous in the object section, as are the kvtags and the regions of
+ * an object. Files written before this layout have no header and are read by PDC_Server_restart.
+ *
+ * Version 2 adds the DART index, in the format of PDC_Server_dart_serialize. Version 1 files have a shorter
+ * header and restart with an empty index.
+ */
+
+#define PDC_CHECKPOINT_MAGIC   "PDCCKPT"
+#define PDC_CHECKPOINT_VERSION 2
+// Index of a missing record
+#define PDC_CHECKPOINT_NONE UINT64_MAX
+
+// Default number of threads rebuilding the metadata at restart, can be changed with the
+// PDC_RESTART_NTHREAD environment variable, 0 rebuilds it on the calling thread.
+#define PDC_RESTART_NTHREAD 8
+
+typedef struct pdc_checkpoint_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    // Sequence number of the last metadata log record in the file
+    uint64_t wal_lsn;
+
+    uint64_t cont_off, n_cont;
+    uint64_t bucket_off, n_bucket;
+    uint64_t obj_off, n_obj;
+    uint64_t kvtag_off, n_kvtag;
+    uint64_t region_off, n_region;
+    uint64_t hist_off, n_hist;
+    uint64_t data_obj_off, n_data_obj;
+    uint64_t pool_off, pool_size;
+    uint64_t transfer_off, transfer_size;
+    // Since version 2
+    uint64_t dart_off, dart_size;
+} pdc_checkpoint_header_t;
+
+// Header size of version 1 files
+#define PDC_CHECKPOINT_HEADER_SIZE_V1 offsetof(pdc_checkpoint_header_t, dart_off)
+
+typedef struct pdc_checkpoint_cont_t {
+    uint64_t cont_id;
+    uint64_t name;    // Pool offset
+    uint64_t tags;    // Pool offset
+    uint64_t obj_ids; // Pool offset of n_obj IDs
+    uint64_t first_kvtag;
+    uint32_t n_kvtag;
+    uint32_t hash_key;
+    int32_t  n_obj;
+    int32_t  n_deleted;
+} pdc_checkpoint_cont_t;
+
+typedef struct pdc_checkpoint_bucket_t {
+    uint64_t first_obj;
+    uint32_t n_obj;
+    uint32_t hash_key;
+} pdc_checkpoint_bucket_t;
+
+typedef struct pdc_checkpoint_obj_t {
+    uint64_t                    obj_id;
+    uint64_t                    cont_id;
+    int64_t                     create_time;
+    int64_t                     last_modified_time;
+    uint64_t                    app_name;      // Pool offset
+    uint64_t                    obj_name;      // Pool offset
+    uint64_t                    tags;          // Pool offset
+    uint64_t                    data_location; // Pool offset
+    uint64_t                    ndim;
+    uint64_t                    dims[DIM_MAX];
+    uint64_t                    first_kvtag;
+    uint64_t                    first_region;
+    uint32_t                    n_kvtag;
+    uint32_t                    n_region;
+    int32_t                     user_id;
+    int32_t                     time_step;
+    int32_t                     data_type;
+    uint32_t                    data_server_id;
+    uint8_t                     region_partition;
+    uint8_t                     consistency;
+    int32_t                     transform_state;
+    struct _pdc_transform_state current_state;
+} pdc_checkpoint_obj_t;
+
+typedef struct pdc_checkpoint_kvtag_t {
+    uint64_t name;  // Pool offset
+    uint64_t value; // Pool offset
+    uint32_t size;
+    int32_t  type;
+} pdc_checkpoint_kvtag_t;
+
+typedef struct pdc_checkpoint_region_t {
+    uint64_t ndim;
+    uint64_t start[DIM_MAX];
+    uint64_t count[DIM_MAX];
+    uint64_t data_size;
+    uint64_t unit_size;
+    uint64_t offset;
+    uint64_t storage_location; // Pool offset
+    uint64_t hist;             // Index of the histogram, PDC_CHECKPOINT_NONE without one
+    int32_t  data_loc_type;
+    int32_t  reserved;
+} pdc_checkpoint_region_t;
+
+typedef struct pdc_checkpoint_hist_t {
+    uint64_t range; // Pool offset of 2 * nbin doubles
+    uint64_t bin;   // Pool offset of nbin counts
+    double   incr;
+    int32_t  dtype;
+    int32_t  nbin;
+} pdc_checkpoint_hist_t;
+
+// Storage regions kept by a data server for one object
+typedef struct pdc_checkpoint_data_obj_t {
+    uint64_t obj_id;
+    uint64_t first_region;
+    uint64_t n_region;
+} pdc_checkpoint_data_obj_t;
+
+// Copy of the metadata of a server, written to a checkpoint file without touching the server state
+typedef struct pdc_checkpoint_image_t pdc_checkpoint_image_t;
+
+/**
+ * Copy the metadata of this server into an image. The metadata must not change meanwhile.
+ *
+ * \param transfer_checkpoint [IN]  Output of transfer_request_metadata_query_checkpoint, not copied, it must
+ *                                  outlive the image
+ * \param transfer_size [IN]        Size of transfer_checkpoint
+ * \param wal_lsn [IN]              Sequence number of the last metadata log record in the checkpoint
+ * \param image [OUT]               Image, to free with PDC_Server_checkpoint_image_free
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_checkpoint_image_create(char *transfer_checkpoint, uint64_t transfer_size, uint64_t wal_lsn,
+                                          pdc_checkpoint_image_t **image);
+
+/**
+ * Write an image to a checkpoint file. The file is written under a temporary name and renamed once
+ * complete, so a crash while writing leaves the previous checkpoint intact. Only the image is read, so it
+ * can run on another thread while the server keeps changing its metadata.
+ *
+ * \param image [IN]                Output of PDC_Server_checkpoint_image_create
+ * \param filename [IN]             Checkpoint file name
+ * \param n_obj [OUT]               Number of objects written
+ * \param n_region [OUT]            Number of regions written
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_checkpoint_image_write(pdc_checkpoint_image_t *image, const char *filename, int *n_obj,
+                                         int *n_region);
+
+/**
+ * Free an image
+ *
+ * \param image [IN]                Output of PDC_Server_checkpoint_image_create, may be NULL
+ */
+void PDC_Server_checkpoint_image_free(pdc_checkpoint_image_t *image);
+
+/**
+ * Write the metadata of this server to a checkpoint file, see PDC_Server_checkpoint_image_write.
+ *
+ * \param filename [IN]             Checkpoint file name
+ * \param transfer_checkpoint [IN]  Output of transfer_request_metadata_query_checkpoint
+ * \param transfer_size [IN]        Size of transfer_checkpoint
+ * \param wal_lsn [IN]              Sequence number of the last metadata log record in the checkpoint
+ * \param n_obj [OUT]               Number of objects written
+ * \param n_region [OUT]            Number of regions written
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_checkpoint_save(const char *filename, char *transfer_checkpoint, uint64_t transfer_size,
+                                  uint64_t wal_lsn, int *n_obj, int *n_region);
+
+/**
+ * Get the layout version of a checkpoint file
+ *
+ * \param filename [IN]             Checkpoint file name
+ *
+ * \return Version, 0 for a file written before the versioned layout, -1 if it cannot be read
+ */
+int PDC_Server_checkpoint_version(const char *filename);
+
+/**
+ * Map a checkpoint file and rebuild the metadata of this server from it, in parallel on
+ * PDC_RESTART_NTHREAD threads. The hash tables and the DART index must be initialized.
+ *
+ * \param filename [IN]             Checkpoint file name
+ * \param wal_lsn [OUT]             Sequence number of the last metadata log record in the checkpoint
+ * \param n_cont [OUT]              Number of containers loaded
+ * \param n_obj [OUT]               Number of objects loaded
+ * \param n_region [OUT]            Number of regions loaded
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_checkpoint_load(const char *filename, uint64_t *wal_lsn, int *n_cont, int *n_obj,
+                                  int *n_region);
+
+#endif /* PDC_SERVER_CHECKPOINT_H */
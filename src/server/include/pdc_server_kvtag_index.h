@@ -0,0 +1,109 @@
+#ifndef PDC_SERVER_KVTAG_INDEX_H
+#define PDC_SERVER_KVTAG_INDEX_H
+
+#include "pdc_client_server_common.h"
+#include "art.h"
+#include "query_utils.h"
+
+/*
+ * Inverted index of the object kvtags kept by the SoMeta backend.
+ *
+ * Tag names are stored in an ART, every name points to a second ART of the values seen with that name.
+ * A value leaf holds the sorted list of IDs of the objects tagged with this name and value, so a query only
+ * touches the postings of the names and values it matches instead of every kvtag of every object.
+ * Numeric values are also kept per type in an array sorted by kvtag_value_ordered_key, which serves range
+ * queries with two binary searches.
+ */
+
+/*
+ * Object IDs that carry one name and value pair, sorted in ascending order.
+ */
+typedef struct pdc_kvtag_posting_t {
+    uint64_t *obj_ids;
+    uint64_t  n_obj;
+    uint64_t  alloc;
+} pdc_kvtag_posting_t;
+
+/*
+ * Postings of the numeric values of one type, sorted by the ordered key of the value.
+ */
+typedef struct pdc_kvtag_sorted_values_t {
+    uint64_t *            keys;
+    pdc_kvtag_posting_t **postings;
+    uint64_t              n_value;
+    uint64_t              alloc;
+} pdc_kvtag_sorted_values_t;
+
+/*
+ * All values indexed under one tag name.
+ */
+typedef struct pdc_kvtag_index_name_t {
+    art_tree                   values;
+    uint64_t                   n_posting;
+    pdc_kvtag_sorted_values_t *numeric[PDC_TYPE_COUNT];
+} pdc_kvtag_index_name_t;
+
+/**
+ * Initialize the kvtag index
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_init();
+
+/**
+ * Free the kvtag index and all of its postings
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_finalize();
+
+/**
+ * Add an object ID to the posting of a kvtag
+ *
+ * \param obj_id [IN]           Object ID
+ * \param kvtag [IN]            Tag of the object
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_insert(uint64_t obj_id, pdc_kvtag_t *kvtag);
+
+/**
+ * Remove an object ID from the posting of a kvtag
+ *
+ * \param obj_id [IN]           Object ID
+ * \param kvtag [IN]            Tag of the object, with the value it was inserted with
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_remove(uint64_t obj_id, pdc_kvtag_t *kvtag);
+
+/**
+ * Get the IDs of all objects with a kvtag matching the query. The name, and the value for PDC_STRING
+ * queries, can be an exact string, a prefix ("abc*"), a suffix ("*abc") or an infix ("*abc*") pattern.
+ * Other value types are matched exactly.
+ *
+ * \param in [IN]               Query kvtag
+ * \param n_meta [OUT]          Number of object IDs found
+ * \param obj_ids [IN/OUT]      Result buffer of alloc_size IDs, reallocated when it is too small
+ * \param alloc_size [IN]       Number of IDs *obj_ids can hold
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_query(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_ids,
+                                    uint64_t alloc_size);
+
+/**
+ * Get the IDs of all objects with a numeric kvtag value in a range. The name can be a pattern as in
+ * PDC_Server_kvtag_index_query, only values of the same type as the range are matched.
+ *
+ * \param range [IN]            Range predicate
+ * \param n_meta [OUT]          Number of object IDs found
+ * \param obj_ids [IN/OUT]      Result buffer of alloc_size IDs, reallocated when it is too small
+ * \param alloc_size [IN]       Number of IDs *obj_ids can hold
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_kvtag_index_query_range(pdc_kvtag_range_t *range, uint32_t *n_meta, uint64_t **obj_ids,
+                                          uint64_t alloc_size);
+
+#endif /* PDC_SERVER_KVTAG_INDEX_H */
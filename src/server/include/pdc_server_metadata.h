@@ -40,7 +40,10 @@
 
 #include "pdc_malloc.h"
 
+// Lists of at least this many objects are checked against the bloom filter first
 #define CREATE_BLOOM_THRESHOLD 64
+// Objects the bloom filter is first sized for, it doubles with the object count
+#define BLOOM_INIT_CAPACITY 65536
 
 /*****************************/
 /* Library-private Variables */
@@ -51,6 +54,7 @@ extern char          pdc_server_tmp_dir_g[TMP_DIR_STRING_LEN];
 extern uint32_t      n_metadata_g;
 extern HashTable *   metadata_hash_table_g;
 extern HashTable *   container_hash_table_g;
+extern HashTable *   metadata_id_hash_table_g;
 extern hg_class_t *  hg_class_g;
 extern hg_context_t *hg_context_g;
 extern int           is_debug_g;
@@ -70,7 +74,6 @@ extern int                       use_sqlite3_g;
 /****************************/
 typedef struct pdc_hash_table_entry_head {
     int             n_obj;
-    void *          bloom;
     pdc_metadata_t *metadata;
 } pdc_hash_table_entry_head;
 
@@ -297,6 +300,13 @@ perr_t PDC_Server_print_all_containers();
  */
 perr_t PDC_Server_metadata_duplicate_check();
 
+/**
+ * Print the memory used by the bloom filters and their observed false positive rate, then free them
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_bloom_finalize();
+
 /**
  * Init the hash table for metadata storage
  *
@@ -325,7 +335,7 @@ perr_t PDC_Server_hash_table_list_init(pdc_hash_table_entry_head *entry, uint32_
 perr_t PDC_Server_hash_table_list_insert(pdc_hash_table_entry_head *head, pdc_metadata_t *new);
 
 /**
- * Get the metadata with the specified object ID by iteration of all metadata in the hash table
+ * Get the metadata with the specified object ID from the object ID index
  *
  * \param obj_id [IN]           Object ID
  *
@@ -81,4 +81,56 @@ perr_t PDC_Server_dart_perform_one_server(dart_perform_one_server_in_t * in,
                                           dart_perform_one_server_out_t *out, uint64_t *n_obj_ids_ptr,
                                           uint64_t **buf_ptrs);
 
+/**
+ * @brief Insert or delete a batch of entries under a single acquisition of the index lock. Each entry is
+ *   uint64_t obj_locator, uint32_t key_size, key, uint32_t value_size, value
+ * where the sizes include the null terminators of the strings.
+ * @param op_type [IN] OP_INSERT or OP_DELETE
+ * @param hash_algo [IN] Hash algorithm the client used to place the entries
+ * @param buf [IN] Entries
+ * @param size [IN] Size of the buffer
+ * @param n_entry [IN] Number of entries in the buffer
+ * @param n_done [OUT] Number of entries applied
+ * @return perr_t SUCCESS on success, FAIL if the buffer is invalid or an entry cannot be logged
+ */
+perr_t PDC_Server_dart_perform_batch(dart_op_type_t op_type, dart_hash_algo_t hash_algo, const char *buf,
+                                     uint64_t size, uint64_t n_entry, uint64_t *n_done);
+
+/**
+ * @brief Bulk callback of a batch sent by PDC_Client_insert_obj_ref_into_dart_batch or
+ * PDC_Client_delete_obj_ref_from_dart_batch, applies it and responds to the client
+ * @param callback_info [IN] Bulk transfer of the entries
+ * @return hg_return_t HG_SUCCESS on success
+ */
+hg_return_t PDC_Server_dart_recv_batch(const struct hg_cb_info *callback_info);
+
+/**
+ * @brief Serialize the ART index for a checkpoint. Only the attribute keys of the prefix tree are saved, each
+ * with its values and the object IDs indexed under them:
+ *   uint64_t n_key, then per key: uint32_t key_len, key, uint32_t n_value,
+ *   then per value: uint32_t value_len, value, uint32_t n_obj, uint64_t obj_ids[n_obj]
+ * Strings are not null terminated. The inner nodes and the suffix trees are rebuilt by inserting them again.
+ * @param buf [OUT] Allocated buffer, to be freed by the caller
+ * @param size [OUT] Size of the buffer
+ * @return perr_t SUCCESS on success, FAIL on failure
+ */
+perr_t PDC_Server_dart_serialize(char **buf, uint64_t *size);
+
+/**
+ * @brief Hold back the changes to the index, so it can be serialized while requests are served on other
+ * threads
+ * @return 0 when the lock was taken
+ */
+int  PDC_Server_dart_trylock();
+void PDC_Server_dart_unlock();
+
+/**
+ * @brief Insert the entries of a serialized ART index into the index
+ * @param buf [IN] Output of PDC_Server_dart_serialize
+ * @param size [IN] Size of the buffer
+ * @param n_entry [OUT] Number of (key, value, object ID) entries inserted
+ * @return perr_t SUCCESS on success, FAIL if the buffer is truncated
+ */
+perr_t PDC_Server_dart_deserialize(const char *buf, uint64_t size, uint64_t *n_entry);
+
 #endif /* PDC_SERVER_METADATA_INDEX_H */
\ No newline at end of file
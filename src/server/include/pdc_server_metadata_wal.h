@@ -0,0 +1,130 @@
+#ifndef PDC_SERVER_METADATA_WAL_H
+#define PDC_SERVER_METADATA_WAL_H
+
+#include "pdc_client_server_common.h"
+#include "pdc_server_metadata.h"
+
+/*
+ * Write-ahead log of the metadata of a server.
+ *
+ * Every change to the in-memory metadata is appended to the log as one record before the RPC that made it
+ * returns, so a crash loses nothing that was acknowledged. Records carry a sequence number; a snapshot
+ * written by PDC_Server_checkpoint stores the sequence number of the last record it includes, and
+ * PDC_Server_wal_replay skips the records up to that number. Once the log grows too large it is sealed and
+ * folded into a new snapshot in the background, see PDC_Server_checkpoint.
+ *
+ * A record is a pdc_wal_record_header_t followed by size bytes of payload. A record whose checksum does not
+ * match ends the log, the bytes after it are dropped.
+ */
+
+// Write the log with fdatasync after every record, can be changed with the PDC_WAL_FSYNC environment
+// variable. Without it, a record survives a crash of the server but not of the node.
+#define PDC_WAL_FSYNC 0
+
+typedef enum {
+    PDC_WAL_CONT_CREATE  = 1, // hash_key, cont_id, cont_name
+    PDC_WAL_OBJ_PUT      = 2, // hash_key, pdc_metadata_t, creates the object or updates its fields
+    PDC_WAL_OBJ_DELETE   = 3, // obj_id of an object or container
+    PDC_WAL_KVTAG_ADD    = 4, // hash_key, obj_id, type, size, name, value
+    PDC_WAL_KVTAG_DEL    = 5, // hash_key, obj_id, name
+    PDC_WAL_META_REGION  = 6, // obj_id, pdc_wal_region_t, storage region kept by the metadata server
+    PDC_WAL_DATA_REGION  = 7, // obj_id, pdc_wal_region_t, storage region kept by the data server
+    PDC_WAL_REGION_PLACE = 8, // obj_id, data_server_id, ndim, offset[ndim], size[ndim], region transfer
+    PDC_WAL_DART_INSERT  = 9, // obj_locator, attr_key, attr_val, entry of the DART index
+    PDC_WAL_DART_DELETE  = 10 // obj_locator, attr_key, attr_val
+} pdc_wal_record_type_t;
+
+typedef struct pdc_wal_record_header_t {
+    uint32_t type;
+    uint32_t size;
+    uint64_t lsn;
+    uint64_t checksum; // Of the three fields above and the payload
+} pdc_wal_record_header_t;
+
+/*
+ * Persistent part of a region_list_t
+ */
+typedef struct pdc_wal_region_t {
+    uint64_t ndim;
+    uint64_t start[DIM_MAX];
+    uint64_t count[DIM_MAX];
+    uint64_t unit_size;
+    uint64_t data_size;
+    uint64_t offset;
+    char     storage_location[ADDR_MAX];
+} pdc_wal_region_t;
+
+/**
+ * Open the log for appending, following records get sequence numbers after lsn
+ *
+ * \param path [IN]             Log file name
+ * \param lsn [IN]              Sequence number of the last record already in the log or a snapshot
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_wal_open(const char *path, uint64_t lsn);
+
+/**
+ * Close the log, records are not appended anymore
+ */
+void PDC_Server_wal_close();
+
+/**
+ * Check if the log is open
+ *
+ * \return 1 if records are appended, 0 otherwise
+ */
+int PDC_Server_wal_is_open();
+
+/**
+ * Get the size of the log
+ *
+ * \return Number of bytes appended since the log was opened or sealed
+ */
+uint64_t PDC_Server_wal_size();
+
+/**
+ * Get the sequence number of the last appended record
+ *
+ * \return Sequence number, 0 if no record was ever appended
+ */
+uint64_t PDC_Server_wal_lsn();
+
+/**
+ * Move the records of the log to another file and continue with an empty log. If the file already exists,
+ * from a seal whose snapshot failed, the records are appended to it.
+ *
+ * \param sealed_path [IN]      File that receives the records
+ * \param lsn [OUT]             Sequence number of the last sealed record
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_wal_seal(const char *sealed_path, uint64_t *lsn);
+
+/**
+ * Apply the records of a log to the in-memory metadata. The file is cut after the last valid record.
+ *
+ * \param path [IN]             Log file name, a missing file has no record
+ * \param after_lsn [IN]        Records up to this sequence number are already in the snapshot and skipped
+ * \param last_lsn [IN/OUT]     Raised to the sequence number of the last valid record
+ * \param n_record [OUT]        Number of applied records
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_wal_replay(const char *path, uint64_t after_lsn, uint64_t *last_lsn, uint64_t *n_record);
+
+/*
+ * Append one record per metadata change. They return SUCCEED without writing when the log is not open.
+ */
+perr_t PDC_Server_wal_log_cont_create(uint32_t hash_key, pdc_cont_hash_table_entry_t *cont);
+perr_t PDC_Server_wal_log_obj_put(uint32_t hash_key, pdc_metadata_t *meta);
+perr_t PDC_Server_wal_log_obj_delete(uint64_t obj_id);
+perr_t PDC_Server_wal_log_kvtag_add(uint32_t hash_key, uint64_t obj_id, pdc_kvtag_t *kvtag);
+perr_t PDC_Server_wal_log_kvtag_del(uint32_t hash_key, uint64_t obj_id, const char *name);
+perr_t PDC_Server_wal_log_region(pdc_wal_record_type_t type, uint64_t obj_id, region_list_t *region);
+perr_t PDC_Server_wal_log_region_place(uint64_t obj_id, uint32_t data_server_id, int ndim,
+                                       const uint64_t *reg_offset, const uint64_t *reg_size);
+perr_t PDC_Server_wal_log_dart(pdc_wal_record_type_t type, const char *attr_key, const char *attr_val,
+                               uint64_t obj_locator);
+
+#endif /* PDC_SERVER_METADATA_WAL_H */
@@ -51,6 +51,7 @@
 #include <sys/mman.h>
 #include "pdc_timing.h"
 #include "pdc_server_region_cache.h"
+#include "pdc_server_region_io.h"
 
 #ifdef ENABLE_MULTITHREAD
 hg_thread_mutex_t insert_metadata_mutex_g = HG_THREAD_MUTEX_INITIALIZER;
@@ -111,6 +112,11 @@ hg_proc_pdc_query_xfer_t(hg_proc_t proc, void *data)
         // HG_LOG_ERROR("Proc error");
         return ret;
     }
+    ret = hg_proc_uint64_t(proc, &struct_data->agg_obj_id);
+    if (ret != HG_SUCCESS) {
+        // HG_LOG_ERROR("Proc error");
+        return ret;
+    }
     ret = hg_proc_int32_t(proc, &struct_data->n_constraints);
     if (ret != HG_SUCCESS) {
         // HG_LOG_ERROR("Proc error");
@@ -1214,7 +1220,7 @@ PDC_Server_release_lock_request(uint64_t obj_id                ATTRIBUTE(unused)
 perr_t
 PDC_Server_data_write_out(uint64_t obj_id                     ATTRIBUTE(unused),
                           struct pdc_region_info *region_info ATTRIBUTE(unused), void *buf ATTRIBUTE(unused),
-                          size_t unit ATTRIBUTE(unused))
+                          size_t unit ATTRIBUTE(unused), pdc_var_type_t data_type ATTRIBUTE(unused))
 {
     return SUCCEED;
 }
@@ -1485,6 +1491,12 @@ PDC_Server_recv_get_sel_data(const struct hg_cb_info *callback_info ATTRIBUTE(un
 {
     return HG_SUCCESS;
 }
+hg_return_t
+PDC_Server_query_cursor_fetch(hg_handle_t handle ATTRIBUTE(unused),
+                              query_cursor_fetch_in_t *in ATTRIBUTE(unused))
+{
+    return HG_SUCCESS;
+}
 perr_t
 PDC_Server_dart_get_server_info(dart_get_server_info_in_t *in   ATTRIBUTE(unused),
                                 dart_get_server_info_out_t *out ATTRIBUTE(unused))
@@ -1499,6 +1511,11 @@ PDC_Server_dart_perform_one_server(dart_perform_one_server_in_t *in   ATTRIBUTE(
 {
     return SUCCEED;
 }
+hg_return_t
+PDC_Server_dart_recv_batch(const struct hg_cb_info *callback_info ATTRIBUTE(unused))
+{
+    return HG_SUCCESS;
+}
 
 #else
 hg_return_t
@@ -2079,9 +2096,7 @@ HG_TEST_RPC_CB(flush_obj, handle)
     HG_Destroy(handle);
 
 #ifdef PDC_SERVER_CACHE
-    pthread_mutex_lock(&pdc_obj_cache_list_mutex);
     PDC_region_cache_flush(obj_id);
-    pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
 #endif
 
 done:
@@ -2145,7 +2160,7 @@ pdc_region_write_out_progress(void *arg)
     }
 
     PDC_Server_data_write_out(bulk_args->remote_obj_id, remote_reg_info, bulk_args->data_buf,
-                              (bulk_args->in).data_unit);
+                              (bulk_args->in).data_unit, (pdc_var_type_t)(bulk_args->in).data_type);
 
     // Perform lock release function
     PDC_Data_Server_region_release(&(bulk_args->in), &out);
@@ -2436,7 +2451,8 @@ transform_and_region_release_bulk_transfer_cb(const struct hg_cb_info *hg_cb_inf
     else
         (remote_reg_info->size)[0] = (bulk_args->remote_region).count_0;
 
-    PDC_Server_data_write_out(bulk_args->remote_obj_id, remote_reg_info, bulk_args->data_buf, unit);
+    PDC_Server_data_write_out(bulk_args->remote_obj_id, remote_reg_info, bulk_args->data_buf, unit,
+                              PDC_UNKNOWN);
     PDC_Data_Server_region_release((region_lock_in_t *)&bulk_args->in, &out);
 
     PDC_Server_release_lock_request(bulk_args->remote_obj_id, remote_reg_info);
@@ -2569,7 +2585,8 @@ analysis_and_region_release_bulk_transfer_cb(const struct hg_cb_info *hg_cb_info
     }
 
     /* Write the analysis results... */
-    PDC_Server_data_write_out(bulk_args->remote_obj_id, remote_reg_info, data_buf, (size_t)type_extent);
+    PDC_Server_data_write_out(bulk_args->remote_obj_id, remote_reg_info, data_buf, (size_t)type_extent,
+                              PDC_UNKNOWN);
 #ifdef ENABLE_MPI
     end_t = MPI_Wtime();
     io_t  = end_t - start_t;
@@ -2728,10 +2745,11 @@ buf_map_region_release_bulk_transfer_cb(const struct hg_cb_info *hg_cb_info)
 */
 #ifdef PDC_SERVER_CACHE
     PDC_transfer_request_data_write_out(bulk_args->remote_obj_id, 0, NULL, remote_reg_info,
-                                        (void *)bulk_args->data_buf, (bulk_args->in).data_unit);
+                                        (void *)bulk_args->data_buf, (bulk_args->in).data_unit,
+                                        (pdc_var_type_t)(bulk_args->in).data_type);
 #else
     PDC_Server_transfer_request_io(bulk_args->remote_obj_id, 0, NULL, remote_reg_info, bulk_args->data_buf,
-                                   (bulk_args->in).data_unit, 1);
+                                   (bulk_args->in).data_unit, (pdc_var_type_t)(bulk_args->in).data_type, 1);
 #endif
 
     // Perform lock release function
@@ -3108,7 +3126,8 @@ HG_TEST_RPC_CB(region_release, handle)
                                                             remote_reg_info, data_buf, in.data_unit);
 #else
                         PDC_Server_transfer_request_io(obj_map_bulk_args->remote_obj_id, 0, NULL,
-                                                       remote_reg_info, data_buf, in.data_unit, 0);
+                                                       remote_reg_info, data_buf, in.data_unit, PDC_UNKNOWN,
+                                                       0);
 #endif
                         size  = HG_Bulk_get_size(eltt2->local_bulk_handle);
                         size2 = HG_Bulk_get_size(remote_bulk_handle);
@@ -6325,6 +6344,29 @@ HG_TEST_RPC_CB(get_sel_data_rpc, handle)
     FUNC_LEAVE(ret_value);
 }
 
+/* query_cursor_fetch_rpc_cb(hg_handle_t handle) */
+HG_TEST_RPC_CB(query_cursor_fetch_rpc, handle)
+{
+    hg_return_t             ret_value = HG_SUCCESS;
+    query_cursor_fetch_in_t in, fetch_in;
+
+    FUNC_ENTER(NULL);
+
+    HG_Get_input(handle, &in);
+
+    // The fetch may destroy the handle before it returns, so the input is freed first and the fetch gets
+    // a copy holding its own reference on the client bulk
+    fetch_in = in;
+    if (fetch_in.bulk_handle != HG_BULK_NULL)
+        HG_Bulk_ref_incr(fetch_in.bulk_handle);
+    HG_Free_input(handle, &in);
+
+    // Responds and destroys the handle once the hits are pushed to the client
+    ret_value = PDC_Server_query_cursor_fetch(handle, &fetch_in);
+
+    FUNC_LEAVE(ret_value);
+}
+
 // Generic bulk transfer
 /* send_bulk_rpc_cb(hg_handle_t handle) */
 HG_TEST_RPC_CB(send_bulk_rpc, handle)
@@ -6371,6 +6413,12 @@ HG_TEST_RPC_CB(send_bulk_rpc, handle)
     else if (in_struct.op_id == PDC_BULK_QUERY_METADATA) {
         func_ptr = &PDC_recv_query_metadata_bulk;
     }
+    else if (in_struct.op_id == PDC_BULK_QUERY_AGG) {
+        func_ptr = &PDC_recv_query_agg;
+    }
+    else if (in_struct.op_id == PDC_BULK_DART_INSERT || in_struct.op_id == PDC_BULK_DART_DELETE) {
+        func_ptr = &PDC_Server_dart_recv_batch;
+    }
     else
         PGOTO_ERROR(HG_OTHER_ERROR, "== Invalid bulk op ID!");
 
@@ -6432,6 +6480,7 @@ HG_TEST_RPC_CB(dart_perform_one_server, handle)
     hg_return_t                   hg_ret = HG_SUCCESS;
     dart_perform_one_server_in_t  in;
     dart_perform_one_server_out_t out;
+    perr_t                        perform_ret;
 
     hg_bulk_t  bulk_handle = HG_BULK_NULL;
     uint64_t * n_obj_ids_ptr;
@@ -6450,7 +6499,7 @@ HG_TEST_RPC_CB(dart_perform_one_server, handle)
     stopwatch_t server_timer;
     timer_start(&server_timer);
 
-    PDC_Server_dart_perform_one_server(&in, &out, n_obj_ids_ptr, buf_ptrs);
+    perform_ret = PDC_Server_dart_perform_one_server(&in, &out, n_obj_ids_ptr, buf_ptrs);
 
     timer_pause(&server_timer);
     out.server_time_elapsed       = (int64_t)timer_delta_us(&server_timer);
@@ -6462,7 +6511,7 @@ HG_TEST_RPC_CB(dart_perform_one_server, handle)
     // No result found
     if (*n_obj_ids_ptr == 0) {
         out.bulk_handle = HG_BULK_NULL;
-        out.ret         = 0;
+        out.ret         = perform_ret == SUCCEED ? 0 : -1;
         // printf("No object ids returned for the query\n");
         ret = HG_Respond(handle, NULL, NULL, &out);
         goto done;
@@ -6567,6 +6616,7 @@ HG_TEST_THREAD_CB(send_data_query_rpc)
 HG_TEST_THREAD_CB(send_nhits)
 HG_TEST_THREAD_CB(send_bulk_rpc)
 HG_TEST_THREAD_CB(get_sel_data_rpc)
+HG_TEST_THREAD_CB(query_cursor_fetch_rpc)
 HG_TEST_THREAD_CB(send_read_sel_obj_id_rpc)
 
 PDC_FUNC_DECLARE_REGISTER(gen_obj_id)
@@ -6635,6 +6685,7 @@ PDC_FUNC_DECLARE_REGISTER_IN_OUT(send_data_query_rpc, pdc_query_xfer_t, pdc_int_
 PDC_FUNC_DECLARE_REGISTER_IN_OUT(send_nhits, send_nhits_t, pdc_int_ret_t)
 PDC_FUNC_DECLARE_REGISTER_IN_OUT(send_bulk_rpc, bulk_rpc_in_t, pdc_int_ret_t)
 PDC_FUNC_DECLARE_REGISTER_IN_OUT(get_sel_data_rpc, get_sel_data_rpc_in_t, pdc_int_ret_t)
+PDC_FUNC_DECLARE_REGISTER_IN_OUT(query_cursor_fetch_rpc, query_cursor_fetch_in_t, query_cursor_fetch_out_t)
 PDC_FUNC_DECLARE_REGISTER_IN_OUT(send_read_sel_obj_id_rpc, get_sel_data_rpc_in_t, pdc_int_ret_t)
 // DART Index
 PDC_FUNC_DECLARE_REGISTER(dart_get_server_info)
@@ -7330,6 +7381,153 @@ PDC_query_xfer_free(pdc_query_xfer_t *query_xfer)
     FUNC_LEAVE_VOID;
 }
 
+/*
+ * Fixed part of a serialized aggregate, followed by nbin * 2 range values and nbin bin counts
+ */
+typedef struct pdc_query_agg_xfer_t {
+    uint64_t count;
+    double   sum;
+    double   min;
+    double   max;
+    double   incr;
+    int32_t  dtype;
+    int32_t  nbin; // 0 without histogram
+} pdc_query_agg_xfer_t;
+
+perr_t
+PDC_query_agg_merge(pdc_query_agg_t *to, pdc_query_agg_t *from)
+{
+    perr_t           ret_value = SUCCEED;
+    pdc_histogram_t *hists[2], *merged;
+
+    FUNC_ENTER(NULL);
+
+    if (NULL == to || NULL == from)
+        PGOTO_ERROR(FAIL, "NULL input");
+
+    if (from->count == 0)
+        PGOTO_DONE(SUCCEED);
+
+    if (to->count == 0) {
+        to->min = from->min;
+        to->max = from->max;
+    }
+    else {
+        if (from->min < to->min)
+            to->min = from->min;
+        if (from->max > to->max)
+            to->max = from->max;
+    }
+    to->count += from->count;
+    to->sum += from->sum;
+    to->mean = to->sum / to->count;
+
+    if (NULL == from->hist)
+        PGOTO_DONE(SUCCEED);
+    if (NULL == to->hist) {
+        to->hist = PDC_dup_hist(from->hist);
+        PGOTO_DONE(SUCCEED);
+    }
+
+    hists[0] = to->hist;
+    hists[1] = from->hist;
+    merged   = PDC_merge_hist(2, hists);
+    if (NULL == merged)
+        PGOTO_ERROR(FAIL, "== error with PDC_merge_hist!");
+    PDC_free_hist(to->hist);
+    to->hist = merged;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+void *
+PDC_query_agg_serialize(pdc_query_agg_t *agg, uint64_t *size)
+{
+    void *                ret_value = NULL;
+    pdc_query_agg_xfer_t *xfer;
+    int                   nbin;
+    char *                buf;
+
+    FUNC_ENTER(NULL);
+
+    if (NULL == agg || NULL == size)
+        PGOTO_ERROR(NULL, "NULL input");
+
+    nbin  = agg->hist == NULL ? 0 : agg->hist->nbin;
+    *size = sizeof(pdc_query_agg_xfer_t) + nbin * (2 * sizeof(double) + sizeof(uint64_t));
+    buf   = (char *)calloc(1, *size);
+    if (NULL == buf)
+        PGOTO_ERROR(NULL, "== error with calloc!");
+
+    xfer        = (pdc_query_agg_xfer_t *)buf;
+    xfer->count = agg->count;
+    xfer->sum   = agg->sum;
+    xfer->min   = agg->min;
+    xfer->max   = agg->max;
+    xfer->nbin  = nbin;
+    if (nbin > 0) {
+        xfer->incr  = agg->hist->incr;
+        xfer->dtype = (int32_t)agg->hist->dtype;
+        memcpy(buf + sizeof(pdc_query_agg_xfer_t), agg->hist->range, nbin * 2 * sizeof(double));
+        memcpy(buf + sizeof(pdc_query_agg_xfer_t) + nbin * 2 * sizeof(double), agg->hist->bin,
+               nbin * sizeof(uint64_t));
+    }
+
+    ret_value = buf;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_query_agg_deserialize(void *buf, uint64_t size, pdc_query_agg_t *agg)
+{
+    perr_t                ret_value = SUCCEED;
+    pdc_query_agg_xfer_t *xfer      = (pdc_query_agg_xfer_t *)buf;
+    pdc_histogram_t *     hist;
+    int                   nbin;
+
+    FUNC_ENTER(NULL);
+
+    if (NULL == buf || NULL == agg || size < sizeof(pdc_query_agg_xfer_t))
+        PGOTO_ERROR(FAIL, "== invalid aggregate buffer!");
+
+    nbin = xfer->nbin;
+    if (nbin < 0 || size < sizeof(pdc_query_agg_xfer_t) + nbin * (2 * sizeof(double) + sizeof(uint64_t)))
+        PGOTO_ERROR(FAIL, "== invalid aggregate histogram size!");
+
+    memset(agg, 0, sizeof(pdc_query_agg_t));
+    agg->count = xfer->count;
+    agg->sum   = xfer->sum;
+    agg->min   = xfer->min;
+    agg->max   = xfer->max;
+    if (agg->count > 0)
+        agg->mean = agg->sum / agg->count;
+    if (nbin == 0)
+        PGOTO_DONE(SUCCEED);
+
+    hist = (pdc_histogram_t *)calloc(1, sizeof(pdc_histogram_t));
+    if (NULL == hist)
+        PGOTO_ERROR(FAIL, "== error with calloc!");
+    hist->range = (double *)malloc(nbin * 2 * sizeof(double));
+    hist->bin   = (uint64_t *)malloc(nbin * sizeof(uint64_t));
+    if (NULL == hist->range || NULL == hist->bin) {
+        PDC_free_hist(hist);
+        PGOTO_ERROR(FAIL, "== error with malloc!");
+    }
+    hist->dtype = (pdc_var_type_t)xfer->dtype;
+    hist->nbin  = nbin;
+    hist->incr  = xfer->incr;
+    memcpy(hist->range, (char *)buf + sizeof(pdc_query_agg_xfer_t), nbin * 2 * sizeof(double));
+    memcpy(hist->bin, (char *)buf + sizeof(pdc_query_agg_xfer_t) + nbin * 2 * sizeof(double),
+           nbin * sizeof(uint64_t));
+    agg->hist = hist;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
 void
 PDCregion_free(struct pdc_region_info *region)
 {
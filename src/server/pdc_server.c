@@ -38,6 +38,7 @@
 
 #include <sys/shm.h>
 #include <sys/mman.h>
+#include <pthread.h>
 
 #include "mercury.h"
 #include "mercury_macros.h"
@@ -53,9 +54,14 @@
 #include "pdc_transforms_common.h"
 #include "pdc_server.h"
 #include "pdc_server_metadata.h"
+#include "pdc_server_kvtag_index.h"
+#include "pdc_server_metadata_wal.h"
+#include "pdc_server_checkpoint.h"
 #include "pdc_server_data.h"
 #include "pdc_timing.h"
 #include "pdc_server_region_cache.h"
+#include "pdc_server_region_io.h"
+#include "pdc_server_query_pool.h"
 #include "pdc_server_region_transfer_metadata_query.h"
 
 #ifdef PDC_HAS_CRAY_DRC
@@ -72,10 +78,9 @@ rocksdb_t *rocksdb_g;
 sqlite3 *sqlite3_db_g;
 #endif
 
-// Check how long PDC has run every OP_INTERVAL operations
-#define PDC_CHECKPOINT_CHK_OP_INTERVAL 2000
-// Checkpoint every INTERVAL_SEC second and at least OP_INTERVAL operations
-#define PDC_CHECKPOINT_MIN_INTERVAL_SEC 1800
+// Fold the metadata log into a new checkpoint once it has grown past this many MB, can be changed with the
+// PDC_WAL_COMPACT_MB environment variable
+#define PDC_WAL_COMPACT_MB 256
 
 // Global debug variable to control debug printfs
 int is_debug_g       = 0;
@@ -142,6 +147,9 @@ int               read_from_bb_size_g          = 0;
 int               gen_hist_g                   = 0;
 int               gen_fastbit_idx_g            = 0;
 int               use_fastbit_idx_g            = 0;
+int               use_bitmap_sel_g             = 0;
+int               gen_bitmap_idx_g             = 0;
+int               use_bitmap_idx_g             = 0;
 int               use_rocksdb_g                = 0;
 int               use_sqlite3_g                = 0;
 char *            gBinningOption               = NULL;
@@ -167,6 +175,22 @@ pdc_data_server_io_list_t *  pdc_data_server_write_list_head_g   = NULL;
 update_storage_meta_list_t * pdc_update_storage_meta_list_head_g = NULL;
 extern data_server_region_t *dataserver_region_g;
 
+// Metadata log compaction
+typedef struct pdc_wal_compact_t {
+    pdc_checkpoint_image_t *image;
+    char *                  transfer_checkpoint;
+    char                    checkpoint_file[ADDR_MAX];
+    perr_t                  ret_value;
+    int                     has_thread;
+    hg_atomic_int32_t       done;
+} pdc_wal_compact_t;
+
+static uint64_t           wal_compact_size_g = (uint64_t)PDC_WAL_COMPACT_MB * 1048576;
+static pdc_wal_compact_t *wal_compact_g      = NULL;
+static pthread_t          wal_compact_thread_g;
+
+static perr_t PDC_Server_wal_start(uint64_t lsn);
+
 /*
  * Init the remote server info structure
  *
@@ -728,6 +752,7 @@ PDC_Server_set_close(void)
         else {
             PDC_Server_checkpoint();
         }
+        PDC_Server_wal_close();
 #ifdef PDC_TIMING
         pdc_server_timings->PDCserver_checkpoint += MPI_Wtime() - start;
 #endif
@@ -960,6 +985,9 @@ drc_access_again:
         printf("==PDC_SERVER[%d]: Read cache enabled!\n", pdc_server_rank_g);
 #endif
 
+    // Initialize DART, before a restart fills it
+    PDC_Server_dart_init();
+
     // TODO: support restart with different number of servers than previous run
     char checkpoint_file[ADDR_MAX + sizeof(int) + 1];
     if (is_restart_g == 1) {
@@ -983,6 +1011,9 @@ drc_access_again:
                 goto done;
             }
         }
+        if (PDC_Server_wal_start(0) != SUCCEED)
+            printf("==PDC_SERVER[%d]: cannot open the metadata log, changes are only saved at checkpoints\n",
+                   pdc_server_rank_g);
     }
 
     // Data server related init
@@ -997,11 +1028,9 @@ drc_access_again:
 
     n_metadata_g = 0;
 
-    // Initialize DART
-    PDC_Server_dart_init();
-
     // PDC transfer_request infrastructures
     PDC_server_transfer_request_init();
+    PDC_Server_query_pool_init();
 #ifdef PDC_SERVER_CACHE
     PDC_region_server_cache_init();
 #endif
@@ -1080,6 +1109,10 @@ PDC_Server_finalize()
         io_elt->region_list_head = NULL;
     }
     // Free hash table
+    PDC_Server_bloom_finalize();
+    PDC_Server_kvtag_index_finalize();
+    if (metadata_id_hash_table_g != NULL)
+        hash_table_free(metadata_id_hash_table_g);
     if (metadata_hash_table_g != NULL)
         hash_table_free(metadata_hash_table_g);
 
@@ -1165,6 +1198,7 @@ PDC_Server_finalize()
     PDC_Server_clear_obj_region();
 
     PDC_server_transfer_request_finalize();
+    PDC_Server_query_pool_finalize();
 
     if (pdc_server_rank_g == 0)
         PDC_Server_rm_config_file();
@@ -1209,31 +1243,268 @@ PDC_Server_checkpoint_cb()
 }
 
 /*
- * Checkpoint in-memory metadata to persistant storage, each server writes to one file
+ * Read the histogram of a region from a checkpoint without a version, NULL if the region has no histogram
+ * or it is corrupted
+ */
+static pdc_histogram_t *
+PDC_Server_restart_region_hist(FILE *file)
+{
+    pdc_histogram_t *hist;
+    int              has_hist = 0, dtype, nbin;
+
+    if (fread(&has_hist, sizeof(int), 1, file) != 1) {
+        printf("Read failed for has_hist\n");
+        return NULL;
+    }
+    if (has_hist != 1)
+        return NULL;
+
+    if (fread(&dtype, sizeof(int), 1, file) != 1 || fread(&nbin, sizeof(int), 1, file) != 1) {
+        printf("Read failed for region_hist\n");
+        return NULL;
+    }
+    if (nbin < 0) {
+        printf("==PDC_SERVER[%d]: %s -  Checkpoint file histogram size is %d!\n", pdc_server_rank_g, __func__,
+               nbin);
+        return NULL;
+    }
+
+    hist        = (pdc_histogram_t *)malloc(sizeof(pdc_histogram_t));
+    hist->dtype = (pdc_var_type_t)dtype;
+    hist->nbin  = nbin;
+    hist->range = (double *)malloc(sizeof(double) * nbin * 2);
+    hist->bin   = (uint64_t *)malloc(sizeof(uint64_t) * nbin);
+    if (fread(hist->range, sizeof(double), nbin * 2, file) != (size_t)nbin * 2 ||
+        fread(hist->bin, sizeof(uint64_t), nbin, file) != (size_t)nbin ||
+        fread(&hist->incr, sizeof(double), 1, file) != 1) {
+        printf("Read failed for region_hist\n");
+        PDC_free_hist(hist);
+        return NULL;
+    }
+    // An empty histogram prunes nothing
+    if (nbin == 0) {
+        PDC_free_hist(hist);
+        return NULL;
+    }
+
+    return hist;
+}
+
+/*
+ * Name of a metadata persistence file of this server, $PDC_TMPDIR/<rank>/<name>.<rank>
+ */
+static void
+PDC_Server_metadata_file(char *path, const char *name)
+{
+    snprintf(path, ADDR_MAX, "%s/%d/%s.%d", pdc_server_tmp_dir_g, pdc_server_rank_g, name, pdc_server_rank_g);
+}
+
+/*
+ * Join the thread writing a metadata snapshot. The sealed metadata log is dropped once the snapshot is
+ * complete, it is kept for the next snapshot otherwise.
  *
- * \param  filename[IN]     Checkpoint file name
+ * \param  wait[IN]         1 to wait for the thread, 0 to return while it is running
+ *
+ * \return 1 if the thread is still running, 0 otherwise
+ */
+static int
+PDC_Server_wal_compact_reap(int wait)
+{
+    char sealed_file[ADDR_MAX];
+
+    if (wal_compact_g == NULL)
+        return 0;
+    if (wait == 0 && hg_atomic_get32(&wal_compact_g->done) == 0)
+        return 1;
+
+    if (wal_compact_g->has_thread)
+        pthread_join(wal_compact_thread_g, NULL);
+    PDC_Server_metadata_file(sealed_file, "metadata_wal_sealed");
+    if (wal_compact_g->ret_value == SUCCEED)
+        unlink(sealed_file);
+    else
+        printf("==PDC_SERVER[%d]: %s - metadata snapshot failed, keeping its log\n", pdc_server_rank_g,
+               __func__);
+    PDC_Server_checkpoint_image_free(wal_compact_g->image);
+    free(wal_compact_g->transfer_checkpoint);
+    free(wal_compact_g);
+    wal_compact_g = NULL;
+
+    return 0;
+}
+
+#ifdef PDC_ENABLE_CHECKPOINT
+/*
+ * Write a metadata snapshot copied by PDC_Server_wal_compact_progress, off the server loop
+ */
+static void *
+PDC_Server_wal_compact_thread(void *arg)
+{
+    pdc_wal_compact_t *compact = (pdc_wal_compact_t *)arg;
+    int                n_obj, n_region;
+
+    compact->ret_value =
+        PDC_Server_checkpoint_image_write(compact->image, compact->checkpoint_file, &n_obj, &n_region);
+    hg_atomic_set32(&compact->done, 1);
+
+    return NULL;
+}
+
+/*
+ * Fold the metadata log into a new checkpoint once it has grown past PDC_WAL_COMPACT_MB. The log is sealed
+ * and the metadata is copied to memory, then a thread writes the copy while requests keep being served.
+ * Called from the server loop.
+ *
+ * Nothing may change the metadata from the seal to the end of the copy, so the snapshot holds exactly the
+ * sealed records. The I/O workers and the cache flusher change the storage regions off this thread, the log
+ * is only sealed once no I/O job is outstanding and the flusher is held back. With ENABLE_MULTITHREAD the
+ * requests are handled on other threads as well, the object, kvtag, container and DART tables are locked.
+ * The locks are only tried after the first one, so no lock order is imposed on the handlers. Otherwise this
+ * is retried on the next loop iteration.
+ */
+static void
+PDC_Server_wal_compact_progress()
+{
+    char               sealed_file[ADDR_MAX];
+    pdc_wal_compact_t *compact = NULL;
+    uint64_t           checkpoint_size, wal_lsn;
+    int                dart_locked = 0;
+#ifdef ENABLE_MULTITHREAD
+    int cont_locked = 0;
+#endif
+#ifdef PDC_SERVER_CACHE
+    int cache_locked = 0;
+#endif
+
+    if (PDC_Server_wal_compact_reap(0) == 1)
+        return;
+    if (PDC_Server_wal_is_open() == 0 || PDC_Server_wal_size() < wal_compact_size_g)
+        return;
+    // No job can be submitted until this returns, jobs are only submitted from this thread
+    if (PDC_Server_io_pending() > 0)
+        return;
+
+#ifdef ENABLE_MULTITHREAD
+    // Objects and their kvtags
+    hg_thread_mutex_lock(&pdc_metadata_hash_table_mutex_g);
+    if (hg_thread_mutex_try_lock(&pdc_container_hash_table_mutex_g) != HG_UTIL_SUCCESS)
+        goto done;
+    cont_locked = 1;
+#endif
+    if (PDC_Server_dart_trylock() != 0)
+        goto done;
+    dart_locked = 1;
+#ifdef PDC_SERVER_CACHE
+    if (PDC_region_cache_io_trylock() != 0)
+        goto done;
+    cache_locked = 1;
+#endif
+
+    PDC_Server_metadata_file(sealed_file, "metadata_wal_sealed");
+    if (PDC_Server_wal_seal(sealed_file, &wal_lsn) != SUCCEED) {
+        // Do not retry on every loop iteration
+        wal_compact_size_g *= 2;
+        goto done;
+    }
+
+    compact = (pdc_wal_compact_t *)calloc(1, sizeof(pdc_wal_compact_t));
+    PDC_Server_metadata_file(compact->checkpoint_file, "metadata_checkpoint");
+    transfer_request_metadata_query_checkpoint(&compact->transfer_checkpoint, &checkpoint_size);
+    if (PDC_Server_checkpoint_image_create(compact->transfer_checkpoint, checkpoint_size, wal_lsn,
+                                           &compact->image) != SUCCEED) {
+        // The sealed log goes into the next snapshot
+        free(compact->transfer_checkpoint);
+        free(compact);
+        compact = NULL;
+    }
+
+done:
+#ifdef PDC_SERVER_CACHE
+    if (cache_locked)
+        PDC_region_cache_io_unlock();
+#endif
+    if (dart_locked)
+        PDC_Server_dart_unlock();
+#ifdef ENABLE_MULTITHREAD
+    if (cont_locked)
+        hg_thread_mutex_unlock(&pdc_container_hash_table_mutex_g);
+    hg_thread_mutex_unlock(&pdc_metadata_hash_table_mutex_g);
+#endif
+    if (compact == NULL)
+        return;
+
+    hg_atomic_init32(&compact->done, 0);
+    wal_compact_g = compact;
+    if (pthread_create(&wal_compact_thread_g, NULL, PDC_Server_wal_compact_thread, compact) == 0)
+        compact->has_thread = 1;
+    else {
+        // Write the snapshot on this thread
+        PDC_Server_wal_compact_thread(compact);
+        PDC_Server_wal_compact_reap(1);
+    }
+}
+#endif
+
+/*
+ * Start appending metadata changes to the log, unless checkpointing is disabled.
+ * A new session removes the checkpoint and log of the previous one.
+ *
+ * \param  lsn[IN]          Sequence number of the last record restored
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+static perr_t
+PDC_Server_wal_start(uint64_t lsn)
+{
+    perr_t ret_value = SUCCEED;
+#ifdef PDC_ENABLE_CHECKPOINT
+    char  wal_file[ADDR_MAX], sealed_file[ADDR_MAX], checkpoint_file[ADDR_MAX];
+    char *env_char;
+
+    FUNC_ENTER(NULL);
+
+    env_char = getenv("PDC_DISABLE_CHECKPOINT");
+    if (env_char != NULL && strcmp(env_char, "TRUE") == 0)
+        goto done;
+
+    env_char = getenv("PDC_WAL_COMPACT_MB");
+    if (env_char != NULL && atoi(env_char) > 0)
+        wal_compact_size_g = (uint64_t)atoi(env_char) * 1048576;
+
+    PDC_Server_metadata_file(wal_file, "metadata_wal");
+    PDC_Server_metadata_file(sealed_file, "metadata_wal_sealed");
+    PDC_Server_metadata_file(checkpoint_file, "metadata_checkpoint");
+    PDC_mkdir(wal_file);
+    if (is_restart_g == 0) {
+        unlink(wal_file);
+        unlink(sealed_file);
+        unlink(checkpoint_file);
+    }
+
+    ret_value = PDC_Server_wal_open(wal_file, lsn);
+
+done:
+    FUNC_LEAVE(ret_value);
+#else
+    (void)lsn;
+    return ret_value;
+#endif
+}
+
+/*
+ * Checkpoint in-memory metadata to persistant storage, each server writes to one file.
+ * The metadata log is sealed first, and dropped once the checkpoint is written.
  *
  * \return Non-negative on success/Negative on failure
  */
 perr_t
 PDC_Server_checkpoint()
 {
-    perr_t                       ret_value = SUCCEED;
-    pdc_metadata_t *             elt;
-    region_list_t *              region_elt;
-    pdc_kvtag_list_t *           kvlist_elt;
-    pdc_hash_table_entry_head *  head;
-    pdc_cont_hash_table_entry_t *cont_head;
-    int n_entry, metadata_size = 0, region_count = 0, n_region, n_objs, n_write_region = 0, n_kvtag, key_len;
-    uint32_t          hash_key;
-    HashTablePair     pair;
-    char              checkpoint_file[ADDR_MAX], checkpoint_file_local[ADDR_MAX], cmd[4096];
-    HashTableIterator hash_table_iter;
-    char *            checkpoint;
-    char *            env_char;
-    uint64_t          checkpoint_size;
-    bool              use_tmpfs = false;
-    FILE *            file;
+    perr_t   ret_value     = SUCCEED;
+    int      metadata_size = 0, region_count = 0, sealed = 0;
+    char     checkpoint_file[ADDR_MAX], sealed_file[ADDR_MAX], cmd[4096];
+    char *   checkpoint;
+    uint64_t checkpoint_size, wal_lsn;
 
     FUNC_ENTER(NULL);
 
@@ -1246,9 +1517,8 @@ PDC_Server_checkpoint()
     gettimeofday(&pdc_timer_start, 0);
 #endif
 
-    env_char = getenv("PDC_CHECKPOINT_TMPFS");
-    if (env_char && atoi(env_char) != 0)
-        use_tmpfs = true;
+    // A snapshot written in the background would race with this one
+    PDC_Server_wal_compact_reap(1);
 
     snprintf(cmd, 4096, "mkdir -p %s/%d", pdc_server_tmp_dir_g, pdc_server_rank_g);
     system(cmd);
@@ -1257,153 +1527,23 @@ PDC_Server_checkpoint()
              pdc_server_tmp_dir_g, pdc_server_rank_g);
     system(cmd);
 #endif
-    snprintf(checkpoint_file, ADDR_MAX, "%s/%d/metadata_checkpoint.%d", pdc_server_tmp_dir_g,
-             pdc_server_rank_g, pdc_server_rank_g);
-    snprintf(checkpoint_file_local, ADDR_MAX, "/tmp/metadata_checkpoint.%d", pdc_server_rank_g);
+    PDC_Server_metadata_file(checkpoint_file, "metadata_checkpoint");
+    PDC_Server_metadata_file(sealed_file, "metadata_wal_sealed");
     if (pdc_server_rank_g == 0) {
         printf("==PDC_SERVER[%4d]: Checkpoint file [%s]\n", pdc_server_rank_g, checkpoint_file);
         fflush(stdout);
     }
 
-    if (use_tmpfs)
-        file = fopen(checkpoint_file_local, "w+");
-    else
-        file = fopen(checkpoint_file, "w+");
-
-    if (file == NULL) {
-        printf("==PDC_SERVER[%d]: %s - Checkpoint file open error", pdc_server_rank_g, __func__);
-        ret_value = FAIL;
-        goto done;
-    }
-
-    // Checkpoint containers
-    n_entry = hash_table_num_entries(container_hash_table_g);
-    fwrite(&n_entry, sizeof(int), 1, file);
-
-    hash_table_iterate(container_hash_table_g, &hash_table_iter);
-    while (n_entry != 0 && hash_table_iter_has_more(&hash_table_iter)) {
-        pair      = hash_table_iter_next(&hash_table_iter);
-        cont_head = pair.value;
-
-        hash_key = PDC_get_hash_by_name(cont_head->cont_name);
-        fwrite(&hash_key, sizeof(uint32_t), 1, file);
-        fwrite(cont_head, sizeof(pdc_cont_hash_table_entry_t), 1, file);
-    }
-
-    // DHT
-    n_entry = hash_table_num_entries(metadata_hash_table_g);
-    fwrite(&n_entry, sizeof(int), 1, file);
-
-    hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
-
-    while (n_entry != 0 && hash_table_iter_has_more(&hash_table_iter)) {
-        pair = hash_table_iter_next(&hash_table_iter);
-        head = pair.value;
-
-        fwrite(&head->n_obj, sizeof(int), 1, file);
-        hash_key = PDC_get_hash_by_name(head->metadata->obj_name);
-        fwrite(&hash_key, sizeof(uint32_t), 1, file);
-
-        // Iterate every metadata structure in current entry
-        DL_FOREACH(head->metadata, elt)
-        {
-            // Write entire metadata structure
-            fwrite(elt, sizeof(pdc_metadata_t), 1, file);
-
-            // Write kv tags
-            DL_COUNT(elt->kvtag_list_head, kvlist_elt, n_kvtag);
-            fwrite(&n_kvtag, sizeof(int), 1, file);
-            DL_FOREACH(elt->kvtag_list_head, kvlist_elt)
-            {
-                key_len = strlen(kvlist_elt->kvtag->name) + 1;
-                fwrite(&key_len, sizeof(int), 1, file);
-                fwrite(kvlist_elt->kvtag->name, key_len, 1, file);
-                fwrite(&kvlist_elt->kvtag->size, sizeof(uint32_t), 1, file);
-                fwrite(&kvlist_elt->kvtag->type, sizeof(int8_t), 1, file);
-                fwrite(kvlist_elt->kvtag->value, kvlist_elt->kvtag->size, 1, file);
-            }
-
-            // Write region info
-            n_region = 0;
-            DL_COUNT(elt->storage_region_list_head, region_elt, n_region);
-            fwrite(&n_region, sizeof(int), 1, file);
-            if (n_region > 0) {
-                n_write_region = 0;
-                DL_FOREACH(elt->storage_region_list_head, region_elt)
-                {
-                    fwrite(region_elt, sizeof(region_list_t), 1, file);
-                    n_write_region++;
-                    int has_hist = 0;
-                    if (region_elt->region_hist != NULL)
-                        has_hist = 1;
-                    fwrite(&has_hist, sizeof(int), 1, file);
-                    if (has_hist == 1) {
-                        fwrite(&region_elt->region_hist->dtype, sizeof(int), 1, file);
-                        fwrite(&region_elt->region_hist->nbin, sizeof(int), 1, file);
-                        fwrite(region_elt->region_hist->range, sizeof(double),
-                               region_elt->region_hist->nbin * 2, file);
-                        fwrite(region_elt->region_hist->bin, sizeof(uint64_t), region_elt->region_hist->nbin,
-                               file);
-                        fwrite(&region_elt->region_hist->incr, sizeof(double), 1, file);
-                    }
-                }
-
-                if (n_write_region != n_region)
-                    fprintf(stderr, "==PDC_SERVER[%d]: %s - ERROR with number of regions", pdc_server_rank_g,
-                            __func__);
-            }
-#if 0
-            // Write storage region info
-            data_server_region_t *region = NULL;
-            region                       = PDC_Server_get_obj_region(elt->obj_id);
-            if (region) {
-                DL_COUNT(region->region_storage_head, region_elt, n_region);
-                fwrite(&n_region, sizeof(int), 1, file);
-                DL_FOREACH(region->region_storage_head, region_elt)
-                {
-                    fwrite(region_elt, sizeof(region_list_t), 1, file);
-                }
-            }
-            else {
-                fwrite(&n_region, sizeof(int), 1, file);
-            }
-#endif
-            metadata_size++;
-            region_count += n_region;
-        } // End for metadata entry linked list
-    }     // End for hash table metadata entry
-
-    // Note data server region are managed by data server instead of metadata server
-    data_server_region_t *region = NULL;
-    DL_COUNT(dataserver_region_g, region, n_objs);
-    fwrite(&n_objs, sizeof(int), 1, file);
-    DL_FOREACH(dataserver_region_g, region)
-    {
-        fwrite(&region->obj_id, sizeof(uint64_t), 1, file);
-        DL_COUNT(region->region_storage_head, region_elt, n_region);
-        fwrite(&n_region, sizeof(int), 1, file);
-        DL_FOREACH(region->region_storage_head, region_elt)
-        {
-            fwrite(region_elt, sizeof(region_list_t), 1, file);
-        }
-    }
+    wal_lsn = PDC_Server_wal_lsn();
+    if (PDC_Server_wal_is_open() == 1 && PDC_Server_wal_seal(sealed_file, &wal_lsn) == SUCCEED)
+        sealed = 1;
 
     transfer_request_metadata_query_checkpoint(&checkpoint, &checkpoint_size);
-    fwrite(&checkpoint_size, sizeof(uint64_t), 1, file);
-    fwrite(checkpoint, checkpoint_size, 1, file);
-
-    fclose(file);
-
-    if (use_tmpfs) {
-#ifdef PDC_TIMING
-        gettimeofday(&pdc_timer_end_rank, 0);
-        checkpoint_time = PDC_get_elapsed_time_double(&pdc_timer_start, &pdc_timer_end_rank);
-        printf("==PDC_SERVER[%4d]: write to tmpfs took %7.2fs\n", pdc_server_rank_g, checkpoint_time);
-#endif
-        // Copy from /tmp to target under $PDC_TMPDIR
-        snprintf(cmd, 4096, "mv %s %s", checkpoint_file_local, checkpoint_file);
-        system(cmd);
-    }
+    ret_value = PDC_Server_checkpoint_save(checkpoint_file, checkpoint, checkpoint_size, wal_lsn,
+                                           &metadata_size, &region_count);
+    free(checkpoint);
+    if (ret_value == SUCCEED && sealed == 1)
+        unlink(sealed_file);
 
 #ifdef PDC_TIMING
     gettimeofday(&pdc_timer_end_rank, 0);
@@ -1437,7 +1577,6 @@ PDC_Server_checkpoint()
         fflush(stdout);
     }
 
-done:
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 } // End Checkpoint
@@ -1450,7 +1589,7 @@ region_cmp(region_list_t *a, region_list_t *b)
 }
 
 /*
- * Load metadata from checkpoint file in persistant storage
+ * Load metadata from checkpoint file in persistant storage, then apply the metadata log written after it
  *
  * \param  filename[IN]     Checkpoint file name
  *
@@ -1469,8 +1608,12 @@ PDC_Server_restart(char *filename)
     pdc_cont_hash_table_entry_t *cont_entry;
     uint32_t *                   hash_key;
     unsigned                     idx;
-    uint64_t                     checkpoint_size;
+    uint64_t                     checkpoint_size, snapshot_lsn = 0, wal_lsn = 0, n_record = 0, n_sealed = 0;
     char *                       checkpoint_buf;
+    char                         wal_file[ADDR_MAX], sealed_file[ADDR_MAX];
+    FILE *                       file;
+    struct timeval               restart_start, restart_end;
+    double                       restart_time, all_restart_time;
 #ifdef PDC_TIMING
     double start = MPI_Wtime();
 #endif
@@ -1485,12 +1628,34 @@ PDC_Server_restart(char *filename)
         goto done;
     }
 
-    FILE *file = fopen(filename, "r");
+    PDC_Server_metadata_file(wal_file, "metadata_wal");
+    PDC_Server_metadata_file(sealed_file, "metadata_wal_sealed");
+    gettimeofday(&restart_start, 0);
+
+    all_cont = 0;
+    if (PDC_Server_checkpoint_version(filename) > 0) {
+        ret_value = PDC_Server_checkpoint_load(filename, &snapshot_lsn, &all_cont, &nobj, &total_region);
+        if (ret_value != SUCCEED) {
+            printf("==PDC_SERVER[%d]: %s - cannot load checkpoint [%s]\n", pdc_server_rank_g, __func__,
+                   filename);
+            goto done;
+        }
+        wal_lsn = snapshot_lsn;
+        goto replay;
+    }
+
+    // A checkpoint without a version is read record by record
+    file = fopen(filename, "r");
     if (file == NULL) {
-        printf("==PDC_SERVER[%d]: %s -  Checkpoint file open FAILED [%s]!", pdc_server_rank_g, __func__,
-               filename);
-        ret_value = FAIL;
-        goto done;
+        // A session that crashed before its first checkpoint only has a log
+        if (access(wal_file, F_OK) != 0 && access(sealed_file, F_OK) != 0) {
+            printf("==PDC_SERVER[%d]: %s -  Checkpoint file open FAILED [%s]!", pdc_server_rank_g, __func__,
+                   filename);
+            ret_value = FAIL;
+            goto done;
+        }
+        transfer_request_metadata_query_init(pdc_server_size_g, NULL);
+        goto replay;
     }
 
     char *slurm_jobid = getenv("SLURM_JOB_ID");
@@ -1515,6 +1680,14 @@ PDC_Server_restart(char *filename)
         if (fread(cont_entry, sizeof(pdc_cont_hash_table_entry_t), 1, file) != 1) {
             printf("Read failed for cont_entry\n");
         }
+        if (cont_entry->cont_id >= pdc_id_seq_g)
+            pdc_id_seq_g = cont_entry->cont_id + 1;
+        // This layout saved the addresses of the object IDs and kvtags, not their values
+        cont_entry->n_obj           = 0;
+        cont_entry->n_deleted       = 0;
+        cont_entry->n_allocated     = 0;
+        cont_entry->obj_ids         = NULL;
+        cont_entry->kvtag_list_head = NULL;
 
 #ifdef ENABLE_MULTITHREAD
         hg_thread_mutex_lock(&pdc_container_hash_table_mutex_g);
@@ -1547,9 +1720,8 @@ PDC_Server_restart(char *filename)
         // Reconstruct hash table
         entry           = (pdc_hash_table_entry_head *)malloc(sizeof(pdc_hash_table_entry_head));
         entry->n_obj    = 0;
-        entry->bloom    = NULL;
         entry->metadata = NULL;
-        // Init hash table metadata (w/ bloom) with first obj
+        // Init hash table metadata with first obj
         PDC_Server_hash_table_list_init(entry, hash_key);
 
         metadata = (pdc_metadata_t *)calloc(sizeof(pdc_metadata_t), count);
@@ -1557,6 +1729,9 @@ PDC_Server_restart(char *filename)
             if (fread(metadata + i, sizeof(pdc_metadata_t), 1, file) != 1) {
                 printf("Read failed for metadata\n");
             }
+            // New objects must not reuse a restored ID
+            if ((metadata + i)->obj_id >= pdc_id_seq_g)
+                pdc_id_seq_g = (metadata + i)->obj_id + 1;
 
             (metadata + i)->storage_region_list_head       = NULL;
             (metadata + i)->region_lock_head               = NULL;
@@ -1616,40 +1791,8 @@ PDC_Server_restart(char *filename)
                     printf("Read failed for region_list\n");
                 }
 
-                int has_hist = 0;
-                if (fread(&has_hist, sizeof(int), 1, file) != 1) {
-                    printf("Read failed for has_list\n");
-                }
-                if (has_hist == 1) {
-                    region_list->region_hist = (pdc_histogram_t *)malloc(sizeof(pdc_histogram_t));
-                    if (fread(&region_list->region_hist->dtype, sizeof(int), 1, file) != 1) {
-                        printf("Read failed for region_list->region_hist->dtype\n");
-                    }
-                    if (fread(&region_list->region_hist->nbin, sizeof(int), 1, file) != 1) {
-                        printf("Read failed for region_list->region_hist->nbin\n");
-                    }
-                    if (region_list->region_hist->nbin == 0) {
-                        printf("==PDC_SERVER[%d]: %s -  Checkpoint file histogram size is 0!",
-                               pdc_server_rank_g, __func__);
-                    }
-
-                    region_list->region_hist->range =
-                        (double *)malloc(sizeof(double) * region_list->region_hist->nbin * 2);
-                    region_list->region_hist->bin =
-                        (uint64_t *)malloc(sizeof(uint64_t) * region_list->region_hist->nbin);
-
-                    if (fread(region_list->region_hist->range, sizeof(double),
-                              region_list->region_hist->nbin * 2, file) != 1) {
-                        printf("Read failed for region_list->region_hist->range\n");
-                    }
-                    if (fread(region_list->region_hist->bin, sizeof(uint64_t), region_list->region_hist->nbin,
-                              file) != 1) {
-                        printf("Read failed for region_list->region_hist->bin\n");
-                    }
-                    if (fread(&region_list->region_hist->incr, sizeof(double), 1, file) != 1) {
-                        printf("Read failed for region_list->region_hist->incr\n");
-                    }
-                }
+                region_list->region_hist = PDC_Server_restart_region_hist(file);
+                region_list->bitmap_idx  = NULL;
 
                 region_list->buf       = NULL;
                 region_list->data_size = 1;
@@ -1732,6 +1875,12 @@ PDC_Server_restart(char *filename)
             if (fread(new_region_list, sizeof(region_list_t), 1, file) != 1) {
                 printf("Read failed for new_region_list\n");
             }
+            new_region_list->region_hist     = PDC_Server_restart_region_hist(file);
+            new_region_list->bitmap_idx      = NULL;
+            new_region_list->buf             = NULL;
+            new_region_list->io_cache_region = NULL;
+            new_region_list->prev            = NULL;
+            new_region_list->next            = NULL;
             DL_APPEND(new_obj_reg->region_storage_head, new_region_list);
         }
     }
@@ -1747,21 +1896,45 @@ PDC_Server_restart(char *filename)
     transfer_request_metadata_query_init(pdc_server_size_g, checkpoint_buf);
     free(checkpoint_buf);
 
+    // Checkpoints written before the metadata log have no sequence number
+    if (fread(&snapshot_lsn, sizeof(uint64_t), 1, file) != 1)
+        snapshot_lsn = 0;
+    wal_lsn = snapshot_lsn;
+
     fclose(file);
     file = NULL;
 
+replay:
+    // The sealed log of a snapshot that did not complete is older than the current log
+    if (PDC_Server_wal_replay(sealed_file, snapshot_lsn, &wal_lsn, &n_sealed) != SUCCEED ||
+        PDC_Server_wal_replay(wal_file, snapshot_lsn, &wal_lsn, &n_record) != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - error replaying the metadata log\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+    }
+    n_record += n_sealed;
+    if (n_record > 0)
+        printf("==PDC_SERVER[%d]: replayed %" PRIu64 " metadata log records\n", pdc_server_rank_g, n_record);
+    if (PDC_Server_wal_start(wal_lsn) != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - cannot open the metadata log\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+    }
+    gettimeofday(&restart_end, 0);
+    restart_time = PDC_get_elapsed_time_double(&restart_start, &restart_end);
+
 #ifdef ENABLE_MPI
     MPI_Reduce(&nobj, &all_nobj, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
     MPI_Reduce(&total_region, &all_n_region, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&restart_time, &all_restart_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 #else
     all_nobj          = nobj;
     all_n_region      = total_region;
+    all_restart_time  = restart_time;
 #endif
 
     if (pdc_server_rank_g == 0) {
         printf("==PDC_SERVER[0]: Server restarted from saved session, "
-               "successfully loaded %d containers, %d objects, %d regions...\n",
-               all_cont, all_nobj, all_n_region);
+               "successfully loaded %d containers, %d objects, %d regions in %.3fs\n",
+               all_cont, all_nobj, all_n_region, all_restart_time);
     }
 
 done:
@@ -1825,6 +1998,10 @@ PDC_Server_multithread_loop(hg_context_t *context)
             break;
 
         ret = HG_Trigger(context, 0, 1, NULL);
+        PDC_Server_io_progress();
+#ifdef PDC_ENABLE_CHECKPOINT
+        PDC_Server_wal_compact_progress();
+#endif
     } while (ret == HG_SUCCESS || ret == HG_TIMEOUT);
 
     hg_thread_join(progress_thread);
@@ -1848,28 +2025,14 @@ PDC_Server_loop(hg_context_t *hg_context)
     perr_t       ret_value = SUCCEED;
     hg_return_t  hg_ret;
     unsigned int actual_count;
-#ifdef PDC_ENABLE_CHECKPOINT
-    int     checkpoint_interval  = 1;
-    clock_t last_checkpoint_time = 0, cur_time;
-#endif
+
     FUNC_ENTER(NULL);
 
     /* Poke progress engine and check for events */
     do {
 #ifdef PDC_ENABLE_CHECKPOINT
-        checkpoint_interval++;
-        // Avoid calling clock() every operation
-        if (checkpoint_interval % PDC_CHECKPOINT_CHK_OP_INTERVAL == 0) {
-            cur_time            = clock();
-            double elapsed_time = ((double)(cur_time - last_checkpoint_time)) / CLOCKS_PER_SEC;
-            /* fprintf(stderr, "PDC_SERVER: loop elapsed time %.2f\n", elapsed_time); */
-            // Do not checkpoint too often, has a min time interval between checkpoints
-            if (elapsed_time > PDC_CHECKPOINT_MIN_INTERVAL_SEC) {
-                PDC_Server_checkpoint();
-                last_checkpoint_time = clock();
-                checkpoint_interval  = 1;
-            }
-        }
+        // Fold a large metadata log into a new checkpoint
+        PDC_Server_wal_compact_progress();
 #endif
 
         actual_count = 0;
@@ -1877,10 +2040,14 @@ PDC_Server_loop(hg_context_t *hg_context)
             hg_ret = HG_Trigger(hg_context, 0 /* timeout */, 1 /* max count */, &actual_count);
         } while ((hg_ret == HG_SUCCESS) && actual_count);
 
+        /* Complete storage jobs finished by the I/O workers */
+        PDC_Server_io_progress();
+
         /* Do not try to make progress anymore if we're done */
         if (hg_atomic_cas32(&close_server_g, 1, 1))
             break;
-        hg_ret = HG_Progress(hg_context, 1000);
+        // Do not block for long while I/O jobs are outstanding, their completions are polled above
+        hg_ret = HG_Progress(hg_context, PDC_Server_io_pending() ? 1 : 1000);
 
     } while (hg_ret == HG_SUCCESS || hg_ret == HG_TIMEOUT);
 
@@ -2038,6 +2205,7 @@ PDC_Server_mercury_register()
 
     PDC_send_data_query_rpc_register(hg_class_g);
     PDC_get_sel_data_rpc_register(hg_class_g);
+    PDC_query_cursor_fetch_rpc_register(hg_class_g);
 
     // Analysis and Transforms
     PDC_set_execution_locus(SERVER_MEMORY);
@@ -2166,6 +2334,24 @@ PDC_Server_get_env()
         printf("==PDC_SERVER[%d]: using FastBit for data indexing and querying\n");
     }
 
+    tmp_env_char = getenv("PDC_QUERY_BITMAP_SEL");
+    if (tmp_env_char != NULL && strcmp(tmp_env_char, "1") == 0) {
+        use_bitmap_sel_g = 1;
+        if (pdc_server_rank_g == 0)
+            printf("==PDC_SERVER[%d]: keeping query selections as bitmaps\n", pdc_server_rank_g);
+    }
+
+    tmp_env_char = getenv("PDC_GEN_BITMAP_IDX");
+    if (tmp_env_char != NULL && strcmp(tmp_env_char, "1") == 0)
+        gen_bitmap_idx_g = 1;
+
+    tmp_env_char = getenv("PDC_USE_BITMAP_IDX");
+    if (tmp_env_char != NULL && strcmp(tmp_env_char, "1") == 0) {
+        use_bitmap_idx_g = 1;
+        if (pdc_server_rank_g == 0)
+            printf("==PDC_SERVER[%d]: using bitmap indexes for data queries\n", pdc_server_rank_g);
+    }
+
     tmp_env_char = getenv("PDC_USE_ROCKSDB");
     if (tmp_env_char != NULL && strcmp(tmp_env_char, "1") == 0) {
         use_rocksdb_g = 1;
@@ -2316,6 +2502,19 @@ server_run(int argc, char *argv[])
                      &errMessage);
         if (errMessage)
             printf("==PDC_SERVER[%d]: error from SQLite %s!\n", pdc_server_rank_g, errMessage);
+        // Range queries filter on the name and the value together
+        sqlite3_exec(sqlite3_db_g, "CREATE INDEX index_name_value_int ON objects(name, value_int);", 0, 0,
+                     &errMessage);
+        if (errMessage)
+            printf("==PDC_SERVER[%d]: error from SQLite %s!\n", pdc_server_rank_g, errMessage);
+        sqlite3_exec(sqlite3_db_g, "CREATE INDEX index_name_value_float ON objects(name, value_float);", 0, 0,
+                     &errMessage);
+        if (errMessage)
+            printf("==PDC_SERVER[%d]: error from SQLite %s!\n", pdc_server_rank_g, errMessage);
+        sqlite3_exec(sqlite3_db_g, "CREATE INDEX index_name_value_double ON objects(name, value_double);", 0,
+                     0, &errMessage);
+        if (errMessage)
+            printf("==PDC_SERVER[%d]: error from SQLite %s!\n", pdc_server_rank_g, errMessage);
     }
 #endif
 
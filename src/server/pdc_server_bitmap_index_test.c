@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "pdc_server_bitmap_index.h"
+#include "pdc_server_query_kernel.h"
+
+#define N      100003
+#define NQUERY 200
+
+static pdc_query_op_t ops[] = {PDC_GT, PDC_GTE, PDC_LT, PDC_LTE, PDC_EQ};
+
+/*
+ * A constraint value close to the data, in the element type
+ */
+static void
+pick_value(pdc_var_type_t type, void *data, void *value)
+{
+    uint64_t i = rand() % N;
+
+    switch (type) {
+        case PDC_FLOAT:
+            *(float *)value = rand() % 4 == 0 ? ((float *)data)[i] : (float)(rand() % 2200 - 100);
+            break;
+        case PDC_DOUBLE:
+            *(double *)value = rand() % 4 == 0 ? ((double *)data)[i] : (double)(rand() % 2200 - 100);
+            break;
+        case PDC_INT:
+            *(int *)value = rand() % 4 == 0 ? ((int *)data)[i] : rand() % 2200 - 100;
+            break;
+        case PDC_UINT64:
+            *(uint64_t *)value = rand() % 4 == 0 ? ((uint64_t *)data)[i] : (uint64_t)(rand() % 2200);
+            break;
+        default:
+            break;
+    }
+}
+
+static void
+check_query(pdc_bitmap_index_t *idx, void *data, pdc_query_op_t lo_op, void *lo, pdc_query_op_t hi_op,
+            void *hi)
+{
+    uint64_t nword = (N + 63) / 64, nmatch, nmatch_idx;
+    uint64_t mask[(N + 63) / 64], mask_idx[(N + 63) / 64];
+
+    assert(PDC_Server_query_kernel_scan(idx->dtype, data, N, lo_op, lo, hi_op, hi, mask, &nmatch) == SUCCEED);
+    assert(PDC_Server_bitmap_index_scan(idx, data, lo_op, lo, hi_op, hi, mask_idx, &nmatch_idx) == SUCCEED);
+    assert(nmatch == nmatch_idx);
+    assert(memcmp(mask, mask_idx, nword * sizeof(uint64_t)) == 0);
+
+    // Without the data, the index must give the same answer alone
+    if (PDC_Server_bitmap_index_needs_data(idx, lo_op, lo, hi_op, hi) == 0) {
+        assert(PDC_Server_bitmap_index_scan(idx, NULL, lo_op, lo, hi_op, hi, mask_idx, &nmatch_idx) ==
+               SUCCEED);
+        assert(nmatch == nmatch_idx);
+    }
+}
+
+static void
+test_type(pdc_var_type_t type, void *data, const char *name)
+{
+    pdc_bitmap_index_t *idx, *idx_read;
+    uint64_t            lo, hi;
+    char                path[64];
+    int                 q, nbin;
+
+    idx = PDC_Server_bitmap_index_build(type, data, N, PDC_BITMAP_INDEX_NBIN);
+    assert(idx != NULL);
+    nbin = idx->nbin;
+
+    for (q = 0; q < NQUERY; q++) {
+        pick_value(type, data, &lo);
+        pick_value(type, data, &hi);
+        check_query(idx, data, ops[rand() % 5], &lo, PDC_OP_NONE, NULL);
+        check_query(idx, data, ops[rand() % 2], &lo, ops[2 + rand() % 2], &hi);
+        check_query(idx, data, ops[2 + rand() % 2], &hi, ops[rand() % 2], &lo);
+    }
+
+    sprintf(path, "./pdc_bitmap_index_test.%d.idx", (int)getpid());
+    assert(PDC_Server_bitmap_index_write(idx, path) == SUCCEED);
+    PDC_Server_bitmap_index_free(idx);
+    idx_read = PDC_Server_bitmap_index_read(path);
+    unlink(path);
+    assert(idx_read != NULL && idx_read->nbin == nbin && idx_read->n == N);
+
+    for (q = 0; q < NQUERY; q++) {
+        pick_value(type, data, &lo);
+        pick_value(type, data, &hi);
+        check_query(idx_read, data, ops[rand() % 2], &lo, ops[2 + rand() % 2], &hi);
+    }
+
+    printf("%s: %d bins, %zu bytes for %d elements\n", name, nbin,
+           PDC_Server_bitmap_index_size_in_bytes(idx_read), N);
+    PDC_Server_bitmap_index_free(idx_read);
+}
+
+int
+main(int argc, char *argv[])
+{
+    float *   fdata   = (float *)malloc(N * sizeof(float));
+    double *  ddata   = (double *)malloc(N * sizeof(double));
+    int *     idata   = (int *)malloc(N * sizeof(int));
+    uint64_t *u64data = (uint64_t *)malloc(N * sizeof(uint64_t));
+    uint64_t  i;
+
+    srand(7);
+    for (i = 0; i < N; i++) {
+        fdata[i]   = (float)(rand() % 200000) / 100.0f;
+        ddata[i]   = (double)(i % 1000) + 0.5;
+        idata[i]   = rand() % 10;
+        u64data[i] = (uint64_t)rand() % 2000;
+    }
+    // NaN matches no constraint
+    fdata[17]   = NAN;
+    fdata[5000] = NAN;
+
+    test_type(PDC_FLOAT, fdata, "float");
+    test_type(PDC_DOUBLE, ddata, "double");
+    test_type(PDC_INT, idata, "int");
+    test_type(PDC_UINT64, u64data, "uint64");
+
+    // Types without kernels have no index
+    assert(PDC_Server_bitmap_index_build(PDC_CHAR, idata, N, PDC_BITMAP_INDEX_NBIN) == NULL);
+
+    free(fdata);
+    free(ddata);
+    free(idata);
+    free(u64data);
+
+    printf("Bitmap index test passed\n");
+    return 0;
+}
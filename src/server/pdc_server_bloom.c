@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <string.h>
+#include "pdc_server_bloom.h"
+#include "pdc_murmur.h"
+
+#define PDC_BLOOM_SEED       0x9747b28c
+#define PDC_BLOOM_BLOCK_BITS (PDC_BLOOM_BLOCK_SIZE * 8)
+#define PDC_BLOOM_BLOCK_WORD (PDC_BLOOM_BLOCK_SIZE / sizeof(uint64_t))
+
+/*
+ * Hash a key to its block and the two seeds of its bit positions in the block
+ */
+static uint64_t *
+pdc_bloom_block(const pdc_bloom_t *bloom, const void *key, size_t len, uint32_t *h1, uint32_t *h2)
+{
+    uint64_t hash[2];
+
+    MurmurHash3_x64_128(key, (int)len, PDC_BLOOM_SEED, hash);
+    *h1 = (uint32_t)hash[1];
+    // Odd, so the positions do not repeat
+    *h2 = (uint32_t)(hash[1] >> 32) | 1;
+
+    return bloom->blocks + (hash[0] % bloom->n_block) * PDC_BLOOM_BLOCK_WORD;
+}
+
+pdc_bloom_t *
+PDC_bloom_new(uint64_t capacity)
+{
+    pdc_bloom_t *bloom;
+    uint64_t     n_block;
+    void *       blocks = NULL;
+
+    n_block = (capacity * PDC_BLOOM_BITS_PER_KEY + PDC_BLOOM_BLOCK_BITS - 1) / PDC_BLOOM_BLOCK_BITS;
+    if (n_block == 0)
+        n_block = 1;
+    if (posix_memalign(&blocks, PDC_BLOOM_BLOCK_SIZE, n_block * PDC_BLOOM_BLOCK_SIZE) != 0)
+        return NULL;
+
+    bloom = (pdc_bloom_t *)calloc(1, sizeof(pdc_bloom_t));
+    if (bloom == NULL) {
+        free(blocks);
+        return NULL;
+    }
+    memset(blocks, 0, n_block * PDC_BLOOM_BLOCK_SIZE);
+    bloom->blocks   = (uint64_t *)blocks;
+    bloom->n_block  = n_block;
+    bloom->capacity = capacity;
+
+    return bloom;
+}
+
+void
+PDC_bloom_free(pdc_bloom_t *bloom)
+{
+    if (bloom == NULL)
+        return;
+    free(bloom->blocks);
+    free(bloom);
+}
+
+void
+PDC_bloom_add(pdc_bloom_t *bloom, const void *key, size_t len)
+{
+    uint64_t *block;
+    uint32_t  h1, h2, bit;
+    int       i;
+
+    block = pdc_bloom_block(bloom, key, len, &h1, &h2);
+    for (i = 0; i < PDC_BLOOM_NHASH; i++) {
+        bit = (h1 + i * h2) % PDC_BLOOM_BLOCK_BITS;
+        block[bit / 64] |= 1ULL << (bit % 64);
+    }
+    bloom->n_key++;
+}
+
+int
+PDC_bloom_check(const pdc_bloom_t *bloom, const void *key, size_t len)
+{
+    uint64_t *block;
+    uint32_t  h1, h2, bit;
+    int       i;
+
+    block = pdc_bloom_block(bloom, key, len, &h1, &h2);
+    for (i = 0; i < PDC_BLOOM_NHASH; i++) {
+        bit = (h1 + i * h2) % PDC_BLOOM_BLOCK_BITS;
+        if ((block[bit / 64] & (1ULL << (bit % 64))) == 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+int
+PDC_bloom_is_full(const pdc_bloom_t *bloom)
+{
+    return bloom->n_key > bloom->capacity;
+}
+
+uint64_t
+PDC_bloom_bytes(const pdc_bloom_t *bloom)
+{
+    if (bloom == NULL)
+        return 0;
+    return sizeof(pdc_bloom_t) + bloom->n_block * PDC_BLOOM_BLOCK_SIZE;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include "pdc_server_bloom.h"
+
+#define N_KEY 100000
+
+int
+main()
+{
+    pdc_bloom_t *bloom;
+    char         key[64];
+    uint64_t     i, n_false = 0;
+
+    bloom = PDC_bloom_new(N_KEY);
+    assert(bloom != NULL);
+    assert(PDC_bloom_bytes(bloom) >= N_KEY * PDC_BLOOM_BITS_PER_KEY / 8);
+
+    for (i = 0; i < N_KEY; i++) {
+        sprintf(key, "obj_%" PRIu64 "0", i);
+        PDC_bloom_add(bloom, key, strlen(key));
+    }
+    assert(!PDC_bloom_is_full(bloom));
+
+    // No false negatives
+    for (i = 0; i < N_KEY; i++) {
+        sprintf(key, "obj_%" PRIu64 "0", i);
+        assert(PDC_bloom_check(bloom, key, strlen(key)) == 1);
+    }
+
+    for (i = 0; i < N_KEY; i++) {
+        sprintf(key, "obj_%" PRIu64 "1", i);
+        n_false += PDC_bloom_check(bloom, key, strlen(key));
+    }
+    printf("%" PRIu64 " bytes for %d keys, %" PRIu64 " false positives out of %d\n", PDC_bloom_bytes(bloom),
+           N_KEY, n_false, N_KEY);
+    assert(n_false < N_KEY / 50);
+
+    PDC_bloom_add(bloom, key, strlen(key));
+    assert(PDC_bloom_is_full(bloom));
+    PDC_bloom_free(bloom);
+
+    return 0;
+}
@@ -0,0 +1,1023 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pdc_utlist.h"
+#include "pdc_server.h"
+#include "pdc_server_checkpoint.h"
+#include "pdc_server_data.h"
+#include "pdc_server_region_transfer_metadata_query.h"
+#include "pdc_server_metadata_index.h"
+#include "thpool.h"
+
+// Number of jobs per restart thread, so a thread with large buckets does not hold up the others
+#define PDC_RESTART_JOBS_PER_THREAD 4
+
+extern data_server_region_t *dataserver_region_g;
+
+/*
+ * Growable section of a checkpoint being written
+ */
+typedef struct pdc_checkpoint_buf_t {
+    char *   data;
+    uint64_t size;
+    uint64_t alloc;
+} pdc_checkpoint_buf_t;
+
+typedef struct pdc_checkpoint_writer_t {
+    pdc_checkpoint_buf_t cont, bucket, obj, kvtag, region, hist, data_obj, pool;
+    int                  failed;
+} pdc_checkpoint_writer_t;
+
+struct pdc_checkpoint_image_t {
+    pdc_checkpoint_writer_t w;
+    char *                  dart;
+    uint64_t                dart_size;
+    char *                  transfer; // Not owned
+    uint64_t                transfer_size;
+    uint64_t                wal_lsn;
+};
+
+/*
+ * Mapped checkpoint, the section pointers are into the mapping
+ */
+typedef struct pdc_checkpoint_map_t {
+    char *                     base;
+    uint64_t                   size;
+    pdc_checkpoint_header_t *  header;
+    pdc_checkpoint_cont_t *    cont;
+    pdc_checkpoint_bucket_t *  bucket;
+    pdc_checkpoint_obj_t *     obj;
+    pdc_checkpoint_kvtag_t *   kvtag;
+    pdc_checkpoint_region_t *  region;
+    pdc_checkpoint_hist_t *    hist;
+    pdc_checkpoint_data_obj_t *data_obj;
+    char *                     pool;
+    char *                     dart; // NULL in version 1 files
+    uint64_t                   dart_size;
+} pdc_checkpoint_map_t;
+
+/*
+ * State shared by the restart jobs, each job fills its own range of the output arrays
+ */
+typedef struct pdc_checkpoint_restore_t {
+    pdc_checkpoint_map_t *       map;
+    pdc_hash_table_entry_head ** heads;
+    pdc_metadata_t **            bucket_meta;
+    data_server_region_t **      data_objs;
+} pdc_checkpoint_restore_t;
+
+typedef struct pdc_checkpoint_job_t {
+    pdc_checkpoint_restore_t *restore;
+    uint64_t                  first;
+    uint64_t                  n;
+    int                       is_data_obj;
+    perr_t                    ret_value;
+} pdc_checkpoint_job_t;
+
+static uint64_t
+pdc_checkpoint_align(uint64_t size)
+{
+    return (size + 7) & ~(uint64_t)7;
+}
+
+/*
+ * Append size bytes to a section, aligned to 8 bytes, and return their offset in it
+ */
+static uint64_t
+pdc_checkpoint_buf_add(pdc_checkpoint_writer_t *w, pdc_checkpoint_buf_t *buf, const void *p, uint64_t size)
+{
+    uint64_t off = pdc_checkpoint_align(buf->size), alloc;
+    char *   data;
+
+    if (off + size > buf->alloc) {
+        alloc = buf->alloc == 0 ? 65536 : buf->alloc;
+        while (alloc < off + size)
+            alloc *= 2;
+        data = (char *)realloc(buf->data, alloc);
+        if (data == NULL) {
+            w->failed = 1;
+            return 0;
+        }
+        buf->data  = data;
+        buf->alloc = alloc;
+    }
+    memset(buf->data + buf->size, 0, off - buf->size);
+    if (size > 0)
+        memcpy(buf->data + off, p, size);
+    buf->size = off + size;
+
+    return off;
+}
+
+static uint64_t
+pdc_checkpoint_pool_str(pdc_checkpoint_writer_t *w, const char *str)
+{
+    return pdc_checkpoint_buf_add(w, &w->pool, str, strlen(str) + 1);
+}
+
+/*
+ * Append a kvtag record and return its index
+ */
+static uint64_t
+pdc_checkpoint_add_kvtag(pdc_checkpoint_writer_t *w, pdc_kvtag_t *kvtag)
+{
+    pdc_checkpoint_kvtag_t rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.name  = pdc_checkpoint_pool_str(w, kvtag->name);
+    rec.value = pdc_checkpoint_buf_add(w, &w->pool, kvtag->value, kvtag->size);
+    rec.size  = kvtag->size;
+    rec.type  = (int32_t)kvtag->type;
+    pdc_checkpoint_buf_add(w, &w->kvtag, &rec, sizeof(rec));
+
+    return w->kvtag.size / sizeof(rec) - 1;
+}
+
+static uint64_t
+pdc_checkpoint_add_hist(pdc_checkpoint_writer_t *w, pdc_histogram_t *hist)
+{
+    pdc_checkpoint_hist_t rec;
+
+    if (hist == NULL || hist->nbin <= 0)
+        return PDC_CHECKPOINT_NONE;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.range = pdc_checkpoint_buf_add(w, &w->pool, hist->range, sizeof(double) * hist->nbin * 2);
+    rec.bin   = pdc_checkpoint_buf_add(w, &w->pool, hist->bin, sizeof(uint64_t) * hist->nbin);
+    rec.incr  = hist->incr;
+    rec.dtype = (int32_t)hist->dtype;
+    rec.nbin  = hist->nbin;
+    pdc_checkpoint_buf_add(w, &w->hist, &rec, sizeof(rec));
+
+    return w->hist.size / sizeof(rec) - 1;
+}
+
+/*
+ * Append a region record and return its index
+ */
+static uint64_t
+pdc_checkpoint_add_region(pdc_checkpoint_writer_t *w, region_list_t *region)
+{
+    pdc_checkpoint_region_t rec;
+    size_t                  i;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.ndim = region->ndim;
+    for (i = 0; i < region->ndim && i < DIM_MAX; i++) {
+        rec.start[i] = region->start[i];
+        rec.count[i] = region->count[i];
+    }
+    rec.data_size        = region->data_size;
+    rec.unit_size        = region->unit_size;
+    rec.offset           = region->offset;
+    rec.storage_location = pdc_checkpoint_pool_str(w, region->storage_location);
+    rec.hist             = pdc_checkpoint_add_hist(w, region->region_hist);
+    rec.data_loc_type    = (int32_t)region->data_loc_type;
+    pdc_checkpoint_buf_add(w, &w->region, &rec, sizeof(rec));
+
+    return w->region.size / sizeof(rec) - 1;
+}
+
+static void
+pdc_checkpoint_add_cont(pdc_checkpoint_writer_t *w, pdc_cont_hash_table_entry_t *cont)
+{
+    pdc_checkpoint_cont_t rec;
+    pdc_kvtag_list_t *    kvlist_elt;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.cont_id     = cont->cont_id;
+    rec.name        = pdc_checkpoint_pool_str(w, cont->cont_name);
+    rec.tags        = pdc_checkpoint_pool_str(w, cont->tags);
+    rec.hash_key    = PDC_get_hash_by_name(cont->cont_name);
+    rec.first_kvtag = w->kvtag.size / sizeof(pdc_checkpoint_kvtag_t);
+    if (cont->obj_ids != NULL && cont->n_obj > 0) {
+        rec.obj_ids   = pdc_checkpoint_buf_add(w, &w->pool, cont->obj_ids, sizeof(uint64_t) * cont->n_obj);
+        rec.n_obj     = cont->n_obj;
+        rec.n_deleted = cont->n_deleted;
+    }
+    DL_FOREACH(cont->kvtag_list_head, kvlist_elt)
+    {
+        pdc_checkpoint_add_kvtag(w, kvlist_elt->kvtag);
+        rec.n_kvtag++;
+    }
+    pdc_checkpoint_buf_add(w, &w->cont, &rec, sizeof(rec));
+}
+
+static void
+pdc_checkpoint_add_obj(pdc_checkpoint_writer_t *w, pdc_metadata_t *meta)
+{
+    pdc_checkpoint_obj_t rec;
+    pdc_kvtag_list_t *   kvlist_elt;
+    region_list_t *      region_elt;
+    size_t               i;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.obj_id             = meta->obj_id;
+    rec.cont_id            = meta->cont_id;
+    rec.create_time        = (int64_t)meta->create_time;
+    rec.last_modified_time = (int64_t)meta->last_modified_time;
+    rec.app_name           = pdc_checkpoint_pool_str(w, meta->app_name);
+    rec.obj_name           = pdc_checkpoint_pool_str(w, meta->obj_name);
+    rec.tags               = pdc_checkpoint_pool_str(w, meta->tags);
+    rec.data_location      = pdc_checkpoint_pool_str(w, meta->data_location);
+    rec.ndim               = meta->ndim;
+    for (i = 0; i < meta->ndim && i < DIM_MAX; i++)
+        rec.dims[i] = meta->dims[i];
+    rec.user_id          = meta->user_id;
+    rec.time_step        = meta->time_step;
+    rec.data_type        = (int32_t)meta->data_type;
+    rec.data_server_id   = meta->data_server_id;
+    rec.region_partition = meta->region_partition;
+    rec.consistency      = meta->consistency;
+    rec.transform_state  = meta->transform_state;
+    rec.current_state    = meta->current_state;
+
+    rec.first_kvtag = w->kvtag.size / sizeof(pdc_checkpoint_kvtag_t);
+    DL_FOREACH(meta->kvtag_list_head, kvlist_elt)
+    {
+        pdc_checkpoint_add_kvtag(w, kvlist_elt->kvtag);
+        rec.n_kvtag++;
+    }
+    rec.first_region = w->region.size / sizeof(pdc_checkpoint_region_t);
+    DL_FOREACH(meta->storage_region_list_head, region_elt)
+    {
+        pdc_checkpoint_add_region(w, region_elt);
+        rec.n_region++;
+    }
+    pdc_checkpoint_buf_add(w, &w->obj, &rec, sizeof(rec));
+}
+
+static void
+pdc_checkpoint_writer_free(pdc_checkpoint_writer_t *w)
+{
+    free(w->cont.data);
+    free(w->bucket.data);
+    free(w->obj.data);
+    free(w->kvtag.data);
+    free(w->region.data);
+    free(w->hist.data);
+    free(w->data_obj.data);
+    free(w->pool.data);
+}
+
+/*
+ * Write a section at its 8-byte aligned offset and return the offset
+ */
+static uint64_t
+pdc_checkpoint_write_section(FILE *file, uint64_t *pos, const void *data, uint64_t size)
+{
+    static const char zero[8] = {0};
+    uint64_t          off     = pdc_checkpoint_align(*pos);
+
+    fwrite(zero, 1, off - *pos, file);
+    if (size > 0)
+        fwrite(data, 1, size, file);
+    *pos = off + size;
+
+    return off;
+}
+
+perr_t
+PDC_Server_checkpoint_image_create(char *transfer_checkpoint, uint64_t transfer_size, uint64_t wal_lsn,
+                                   pdc_checkpoint_image_t **image)
+{
+    perr_t                       ret_value = SUCCEED;
+    pdc_checkpoint_image_t *     img;
+    pdc_checkpoint_writer_t *    w;
+    pdc_checkpoint_bucket_t      bucket;
+    pdc_checkpoint_data_obj_t    data_obj;
+    pdc_hash_table_entry_head *  head;
+    pdc_cont_hash_table_entry_t *cont_head;
+    pdc_metadata_t *             elt;
+    data_server_region_t *       region;
+    region_list_t *              region_elt;
+    HashTablePair                pair;
+    HashTableIterator            hash_table_iter;
+
+    FUNC_ENTER(NULL);
+
+    *image = NULL;
+    img    = (pdc_checkpoint_image_t *)calloc(1, sizeof(pdc_checkpoint_image_t));
+    if (img == NULL) {
+        printf("==PDC_SERVER[%d]: %s - cannot allocate the checkpoint\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    img->transfer      = transfer_checkpoint;
+    img->transfer_size = transfer_size;
+    img->wal_lsn       = wal_lsn;
+    w                  = &img->w;
+
+    // Containers
+    if (container_hash_table_g != NULL) {
+        hash_table_iterate(container_hash_table_g, &hash_table_iter);
+        while (hash_table_iter_has_more(&hash_table_iter)) {
+            pair      = hash_table_iter_next(&hash_table_iter);
+            cont_head = pair.value;
+            pdc_checkpoint_add_cont(w, cont_head);
+        }
+    }
+
+    // Objects, grouped by hash bucket
+    if (metadata_hash_table_g != NULL) {
+        hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
+        while (hash_table_iter_has_more(&hash_table_iter)) {
+            pair = hash_table_iter_next(&hash_table_iter);
+            head = pair.value;
+            // All objects of the bucket were deleted
+            if (head->metadata == NULL)
+                continue;
+
+            memset(&bucket, 0, sizeof(bucket));
+            bucket.first_obj = w->obj.size / sizeof(pdc_checkpoint_obj_t);
+            bucket.hash_key  = *(uint32_t *)pair.key;
+            DL_FOREACH(head->metadata, elt)
+            {
+                pdc_checkpoint_add_obj(w, elt);
+                bucket.n_obj++;
+            }
+            pdc_checkpoint_buf_add(w, &w->bucket, &bucket, sizeof(bucket));
+        }
+    }
+
+    // Note data server region are managed by data server instead of metadata server
+    DL_FOREACH(dataserver_region_g, region)
+    {
+        memset(&data_obj, 0, sizeof(data_obj));
+        data_obj.obj_id       = region->obj_id;
+        data_obj.first_region = w->region.size / sizeof(pdc_checkpoint_region_t);
+        DL_FOREACH(region->region_storage_head, region_elt)
+        {
+            pdc_checkpoint_add_region(w, region_elt);
+            data_obj.n_region++;
+        }
+        pdc_checkpoint_buf_add(w, &w->data_obj, &data_obj, sizeof(data_obj));
+    }
+
+    if (PDC_Server_dart_serialize(&img->dart, &img->dart_size) != SUCCEED)
+        w->failed = 1;
+
+    if (w->failed) {
+        printf("==PDC_SERVER[%d]: %s - cannot allocate the checkpoint\n", pdc_server_rank_g, __func__);
+        PDC_Server_checkpoint_image_free(img);
+        ret_value = FAIL;
+        goto done;
+    }
+    *image = img;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_checkpoint_image_write(pdc_checkpoint_image_t *image, const char *filename, int *n_obj,
+                                  int *n_region)
+{
+    perr_t                   ret_value = SUCCEED;
+    pdc_checkpoint_writer_t *w         = &image->w;
+    pdc_checkpoint_header_t  header;
+    char                     tmp_file[ADDR_MAX], cmd[4096];
+    char *                   env_char;
+    uint64_t                 pos;
+    FILE *                   file = NULL;
+
+    FUNC_ENTER(NULL);
+
+    memset(&header, 0, sizeof(header));
+
+    env_char = getenv("PDC_CHECKPOINT_TMPFS");
+    if (env_char != NULL && atoi(env_char) != 0)
+        snprintf(tmp_file, ADDR_MAX, "/tmp/metadata_checkpoint.%d", pdc_server_rank_g);
+    else
+        snprintf(tmp_file, ADDR_MAX, "%s.tmp", filename);
+
+    file = fopen(tmp_file, "w+");
+    if (file == NULL) {
+        printf("==PDC_SERVER[%d]: %s - Checkpoint file open error\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    memcpy(header.magic, PDC_CHECKPOINT_MAGIC, sizeof(PDC_CHECKPOINT_MAGIC));
+    header.version     = PDC_CHECKPOINT_VERSION;
+    header.header_size = sizeof(header);
+    header.wal_lsn     = image->wal_lsn;
+    header.n_cont      = w->cont.size / sizeof(pdc_checkpoint_cont_t);
+    header.n_bucket    = w->bucket.size / sizeof(pdc_checkpoint_bucket_t);
+    header.n_obj       = w->obj.size / sizeof(pdc_checkpoint_obj_t);
+    header.n_kvtag     = w->kvtag.size / sizeof(pdc_checkpoint_kvtag_t);
+    header.n_region    = w->region.size / sizeof(pdc_checkpoint_region_t);
+    header.n_hist      = w->hist.size / sizeof(pdc_checkpoint_hist_t);
+    header.n_data_obj  = w->data_obj.size / sizeof(pdc_checkpoint_data_obj_t);
+
+    // The header is written again once the offsets are known
+    fwrite(&header, sizeof(header), 1, file);
+    pos                  = sizeof(header);
+    header.cont_off      = pdc_checkpoint_write_section(file, &pos, w->cont.data, w->cont.size);
+    header.bucket_off    = pdc_checkpoint_write_section(file, &pos, w->bucket.data, w->bucket.size);
+    header.obj_off       = pdc_checkpoint_write_section(file, &pos, w->obj.data, w->obj.size);
+    header.kvtag_off     = pdc_checkpoint_write_section(file, &pos, w->kvtag.data, w->kvtag.size);
+    header.region_off    = pdc_checkpoint_write_section(file, &pos, w->region.data, w->region.size);
+    header.hist_off      = pdc_checkpoint_write_section(file, &pos, w->hist.data, w->hist.size);
+    header.data_obj_off  = pdc_checkpoint_write_section(file, &pos, w->data_obj.data, w->data_obj.size);
+    header.pool_off      = pdc_checkpoint_write_section(file, &pos, w->pool.data, w->pool.size);
+    header.pool_size     = w->pool.size;
+    header.transfer_off  = pdc_checkpoint_write_section(file, &pos, image->transfer, image->transfer_size);
+    header.transfer_size = image->transfer_size;
+    header.dart_off      = pdc_checkpoint_write_section(file, &pos, image->dart, image->dart_size);
+    header.dart_size     = image->dart_size;
+
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1 ||
+        fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        printf("==PDC_SERVER[%d]: %s - Checkpoint file write error\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+    }
+    fclose(file);
+    if (ret_value != SUCCEED)
+        goto done;
+
+    if (rename(tmp_file, filename) != 0) {
+        // Copy from /tmp to target under $PDC_TMPDIR
+        snprintf(cmd, 4096, "mv %s %s", tmp_file, filename);
+        if (system(cmd) != 0) {
+            printf("==PDC_SERVER[%d]: %s - cannot move checkpoint to %s\n", pdc_server_rank_g, __func__,
+                   filename);
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+
+    *n_obj    = (int)header.n_obj;
+    *n_region = (int)header.n_region;
+
+done:
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDC_Server_checkpoint_image_free(pdc_checkpoint_image_t *image)
+{
+    if (image == NULL)
+        return;
+    pdc_checkpoint_writer_free(&image->w);
+    free(image->dart);
+    free(image);
+}
+
+perr_t
+PDC_Server_checkpoint_save(const char *filename, char *transfer_checkpoint, uint64_t transfer_size,
+                           uint64_t wal_lsn, int *n_obj, int *n_region)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_checkpoint_image_t *image     = NULL;
+
+    FUNC_ENTER(NULL);
+
+    ret_value = PDC_Server_checkpoint_image_create(transfer_checkpoint, transfer_size, wal_lsn, &image);
+    if (ret_value != SUCCEED)
+        goto done;
+    ret_value = PDC_Server_checkpoint_image_write(image, filename, n_obj, n_region);
+
+done:
+    PDC_Server_checkpoint_image_free(image);
+    FUNC_LEAVE(ret_value);
+}
+
+int
+PDC_Server_checkpoint_version(const char *filename)
+{
+    pdc_checkpoint_header_t header;
+    FILE *                  file;
+    int                     version = 0;
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+        return -1;
+    if (fread(&header, PDC_CHECKPOINT_HEADER_SIZE_V1, 1, file) == 1 &&
+        memcmp(header.magic, PDC_CHECKPOINT_MAGIC, sizeof(PDC_CHECKPOINT_MAGIC)) == 0)
+        version = (int)header.version;
+    fclose(file);
+
+    return version;
+}
+
+/*
+ * Check that n records of rec_size bytes at off are inside the file
+ */
+static int
+pdc_checkpoint_in_file(pdc_checkpoint_map_t *map, uint64_t off, uint64_t n, uint64_t rec_size)
+{
+    if (n == 0)
+        return 1;
+    if (off > map->size || n > (map->size - off) / rec_size)
+        return 0;
+    return 1;
+}
+
+/*
+ * Check that records [first, first + n) are in a section of total records
+ */
+static int
+pdc_checkpoint_range_ok(uint64_t first, uint64_t n, uint64_t total)
+{
+    return first <= total && n <= total - first;
+}
+
+/*
+ * Pointer to size bytes of the pool, NULL if they are out of it
+ */
+static const char *
+pdc_checkpoint_pool(pdc_checkpoint_map_t *map, uint64_t off, uint64_t size)
+{
+    if (off > map->header->pool_size || size > map->header->pool_size - off)
+        return NULL;
+    return map->pool + off;
+}
+
+/*
+ * Copy a pool string to a fixed-size buffer
+ */
+static void
+pdc_checkpoint_copy_str(pdc_checkpoint_map_t *map, uint64_t off, char *dst, size_t dst_size)
+{
+    const char *str = pdc_checkpoint_pool(map, off, 0);
+    size_t      len;
+
+    dst[0] = '\0';
+    if (str == NULL)
+        return;
+    len = strnlen(str, map->header->pool_size - off);
+    if (len >= dst_size)
+        len = dst_size - 1;
+    memcpy(dst, str, len);
+    dst[len] = '\0';
+}
+
+static pdc_kvtag_list_t *
+pdc_checkpoint_restore_kvtags(pdc_checkpoint_map_t *map, uint64_t first, uint32_t n)
+{
+    pdc_kvtag_list_t *      head = NULL, *kvtag_list;
+    pdc_checkpoint_kvtag_t *rec;
+    const char *            name, *value;
+    uint32_t                i;
+
+    for (i = 0; i < n; i++) {
+        rec   = map->kvtag + first + i;
+        name  = pdc_checkpoint_pool(map, rec->name, 1);
+        value = pdc_checkpoint_pool(map, rec->value, rec->size);
+        if (name == NULL || value == NULL)
+            continue;
+
+        kvtag_list              = (pdc_kvtag_list_t *)calloc(1, sizeof(pdc_kvtag_list_t));
+        kvtag_list->kvtag       = (pdc_kvtag_t *)malloc(sizeof(pdc_kvtag_t));
+        kvtag_list->kvtag->name = strndup(name, map->header->pool_size - rec->name);
+        kvtag_list->kvtag->size = rec->size;
+        kvtag_list->kvtag->type = (int8_t)rec->type;
+        kvtag_list->kvtag->value = malloc(rec->size == 0 ? 1 : rec->size);
+        memcpy(kvtag_list->kvtag->value, value, rec->size);
+        DL_APPEND(head, kvtag_list);
+    }
+
+    return head;
+}
+
+static pdc_histogram_t *
+pdc_checkpoint_restore_hist(pdc_checkpoint_map_t *map, uint64_t idx)
+{
+    pdc_checkpoint_hist_t *rec;
+    pdc_histogram_t *      hist;
+    const char *           range, *bin;
+
+    if (idx >= map->header->n_hist)
+        return NULL;
+
+    rec   = map->hist + idx;
+    range = pdc_checkpoint_pool(map, rec->range, sizeof(double) * rec->nbin * 2);
+    bin   = pdc_checkpoint_pool(map, rec->bin, sizeof(uint64_t) * rec->nbin);
+    if (rec->nbin <= 0 || range == NULL || bin == NULL)
+        return NULL;
+
+    hist        = (pdc_histogram_t *)malloc(sizeof(pdc_histogram_t));
+    hist->dtype = (pdc_var_type_t)rec->dtype;
+    hist->nbin  = rec->nbin;
+    hist->incr  = rec->incr;
+    hist->range = (double *)malloc(sizeof(double) * rec->nbin * 2);
+    hist->bin   = (uint64_t *)malloc(sizeof(uint64_t) * rec->nbin);
+    memcpy(hist->range, range, sizeof(double) * rec->nbin * 2);
+    memcpy(hist->bin, bin, sizeof(uint64_t) * rec->nbin);
+
+    return hist;
+}
+
+static int
+pdc_checkpoint_region_cmp(region_list_t *a, region_list_t *b)
+{
+    return memcmp(a->start, b->start, a->ndim * sizeof(uint64_t));
+}
+
+static region_list_t *
+pdc_checkpoint_restore_regions(pdc_checkpoint_map_t *map, uint64_t first, uint64_t n, uint64_t obj_id,
+                               pdc_metadata_t *meta)
+{
+    region_list_t *          head = NULL, *region;
+    pdc_checkpoint_region_t *rec;
+    uint64_t                 i;
+    size_t                   j;
+
+    for (i = 0; i < n; i++) {
+        rec    = map->region + first + i;
+        region = (region_list_t *)malloc(sizeof(region_list_t));
+        PDC_init_region_list(region);
+
+        region->ndim = rec->ndim > DIM_MAX ? DIM_MAX : rec->ndim;
+        for (j = 0; j < region->ndim; j++) {
+            region->start[j] = rec->start[j];
+            region->count[j] = rec->count[j];
+        }
+        region->data_size     = rec->data_size;
+        region->unit_size     = rec->unit_size;
+        region->offset        = rec->offset;
+        region->data_loc_type = (_pdc_data_loc_t)rec->data_loc_type;
+        region->region_hist   = pdc_checkpoint_restore_hist(map, rec->hist);
+        region->obj_id        = obj_id;
+        region->meta          = meta;
+        pdc_checkpoint_copy_str(map, rec->storage_location, region->storage_location, ADDR_MAX);
+        DL_APPEND(head, region);
+    }
+
+    return head;
+}
+
+static void
+pdc_checkpoint_restore_obj(pdc_checkpoint_map_t *map, pdc_checkpoint_obj_t *rec, pdc_metadata_t *meta)
+{
+    size_t i;
+
+    meta->obj_id             = rec->obj_id;
+    meta->cont_id            = rec->cont_id;
+    meta->create_time        = (time_t)rec->create_time;
+    meta->last_modified_time = (time_t)rec->last_modified_time;
+    meta->user_id            = rec->user_id;
+    meta->time_step          = rec->time_step;
+    meta->data_type          = (pdc_var_type_t)rec->data_type;
+    meta->data_server_id     = rec->data_server_id;
+    meta->region_partition   = rec->region_partition;
+    meta->consistency        = rec->consistency;
+    meta->transform_state    = rec->transform_state;
+    meta->current_state      = rec->current_state;
+    meta->ndim               = rec->ndim > DIM_MAX ? DIM_MAX : rec->ndim;
+    for (i = 0; i < meta->ndim; i++)
+        meta->dims[i] = rec->dims[i];
+    pdc_checkpoint_copy_str(map, rec->app_name, meta->app_name, OBJ_NAME_MAX);
+    pdc_checkpoint_copy_str(map, rec->obj_name, meta->obj_name, OBJ_NAME_MAX);
+    pdc_checkpoint_copy_str(map, rec->tags, meta->tags, TAG_LEN_MAX);
+    pdc_checkpoint_copy_str(map, rec->data_location, meta->data_location, ADDR_MAX);
+
+    meta->kvtag_list_head = pdc_checkpoint_restore_kvtags(map, rec->first_kvtag, rec->n_kvtag);
+    meta->storage_region_list_head =
+        pdc_checkpoint_restore_regions(map, rec->first_region, rec->n_region, rec->obj_id, meta);
+    DL_SORT(meta->storage_region_list_head, pdc_checkpoint_region_cmp);
+}
+
+/*
+ * Check that the records an object refers to are in the file
+ */
+static int
+pdc_checkpoint_obj_valid(pdc_checkpoint_map_t *map, pdc_checkpoint_obj_t *rec)
+{
+    return pdc_checkpoint_range_ok(rec->first_kvtag, rec->n_kvtag, map->header->n_kvtag) &&
+           pdc_checkpoint_range_ok(rec->first_region, rec->n_region, map->header->n_region);
+}
+
+/*
+ * Rebuild the objects of a range of hash buckets, or the storage regions of a range of data server objects.
+ * Nothing shared is modified, the results are linked into the server on the calling thread.
+ */
+static void
+pdc_checkpoint_restore_job(void *arg)
+{
+    pdc_checkpoint_job_t *     job     = (pdc_checkpoint_job_t *)arg;
+    pdc_checkpoint_restore_t * restore = job->restore;
+    pdc_checkpoint_map_t *     map     = restore->map;
+    pdc_checkpoint_bucket_t *  bucket;
+    pdc_checkpoint_data_obj_t *data_obj;
+    pdc_metadata_t *           meta;
+    data_server_region_t *     obj_reg;
+    uint64_t                   b, i;
+
+    job->ret_value = SUCCEED;
+    for (b = job->first; b < job->first + job->n; b++) {
+        if (job->is_data_obj) {
+            data_obj = map->data_obj + b;
+            if (!pdc_checkpoint_range_ok(data_obj->first_region, data_obj->n_region, map->header->n_region)) {
+                job->ret_value = FAIL;
+                continue;
+            }
+            obj_reg                      = (data_server_region_t *)calloc(1, sizeof(data_server_region_t));
+            obj_reg->fd                  = -1;
+            obj_reg->storage_location    = (char *)malloc(sizeof(char) * ADDR_MAX);
+            obj_reg->obj_id              = data_obj->obj_id;
+            obj_reg->region_storage_head = pdc_checkpoint_restore_regions(
+                map, data_obj->first_region, data_obj->n_region, data_obj->obj_id, NULL);
+            restore->data_objs[b] = obj_reg;
+            continue;
+        }
+
+        bucket = map->bucket + b;
+        if (bucket->n_obj == 0 ||
+            !pdc_checkpoint_range_ok(bucket->first_obj, bucket->n_obj, map->header->n_obj)) {
+            job->ret_value = FAIL;
+            continue;
+        }
+        meta = (pdc_metadata_t *)calloc(bucket->n_obj, sizeof(pdc_metadata_t));
+        for (i = 0; i < bucket->n_obj; i++) {
+            if (!pdc_checkpoint_obj_valid(map, map->obj + bucket->first_obj + i)) {
+                job->ret_value = FAIL;
+                break;
+            }
+            pdc_checkpoint_restore_obj(map, map->obj + bucket->first_obj + i, meta + i);
+        }
+        if (i < bucket->n_obj) {
+            free(meta);
+            continue;
+        }
+        restore->bucket_meta[b] = meta;
+        restore->heads[b]       = (pdc_hash_table_entry_head *)calloc(1, sizeof(pdc_hash_table_entry_head));
+    }
+}
+
+/*
+ * Run the restart jobs on a pool of threads, or on the calling thread
+ */
+static perr_t
+pdc_checkpoint_run_jobs(pdc_checkpoint_restore_t *restore, int nthread)
+{
+    perr_t                ret_value = SUCCEED;
+    pdc_checkpoint_job_t *jobs;
+    threadpool            pool = NULL;
+    uint64_t              n_bucket, n_data_obj, chunk, first;
+    int                   n_job = 0, i;
+
+    n_bucket   = restore->map->header->n_bucket;
+    n_data_obj = restore->map->header->n_data_obj;
+    if (nthread > 0)
+        pool = thpool_init(nthread);
+    if (pool == NULL)
+        nthread = 1;
+
+    chunk = (n_bucket + n_data_obj) / (nthread * PDC_RESTART_JOBS_PER_THREAD) + 1;
+    jobs  = (pdc_checkpoint_job_t *)calloc((n_bucket + chunk - 1) / chunk + (n_data_obj + chunk - 1) / chunk,
+                                          sizeof(pdc_checkpoint_job_t));
+    for (first = 0; first < n_bucket; first += chunk, n_job++) {
+        jobs[n_job].restore = restore;
+        jobs[n_job].first   = first;
+        jobs[n_job].n       = first + chunk > n_bucket ? n_bucket - first : chunk;
+    }
+    for (first = 0; first < n_data_obj; first += chunk, n_job++) {
+        jobs[n_job].restore     = restore;
+        jobs[n_job].first       = first;
+        jobs[n_job].n           = first + chunk > n_data_obj ? n_data_obj - first : chunk;
+        jobs[n_job].is_data_obj = 1;
+    }
+
+    for (i = 0; i < n_job; i++) {
+        if (pool == NULL || thpool_add_work(pool, pdc_checkpoint_restore_job, jobs + i) != 0)
+            pdc_checkpoint_restore_job(jobs + i);
+    }
+    if (pool != NULL) {
+        thpool_wait(pool);
+        thpool_destroy(pool);
+    }
+
+    for (i = 0; i < n_job; i++) {
+        if (jobs[i].ret_value != SUCCEED)
+            ret_value = FAIL;
+    }
+    free(jobs);
+
+    return ret_value;
+}
+
+static perr_t
+pdc_checkpoint_restore_conts(pdc_checkpoint_map_t *map)
+{
+    perr_t                       ret_value = SUCCEED;
+    pdc_checkpoint_cont_t *      rec;
+    pdc_cont_hash_table_entry_t *cont_entry;
+    const char *                 obj_ids;
+    uint32_t *                   hash_key;
+    uint64_t                     c;
+
+    for (c = 0; c < map->header->n_cont; c++) {
+        rec = map->cont + c;
+        if (!pdc_checkpoint_range_ok(rec->first_kvtag, rec->n_kvtag, map->header->n_kvtag)) {
+            ret_value = FAIL;
+            continue;
+        }
+
+        cont_entry          = (pdc_cont_hash_table_entry_t *)calloc(1, sizeof(pdc_cont_hash_table_entry_t));
+        cont_entry->cont_id = rec->cont_id;
+        pdc_checkpoint_copy_str(map, rec->name, cont_entry->cont_name, ADDR_MAX);
+        pdc_checkpoint_copy_str(map, rec->tags, cont_entry->tags, TAG_LEN_MAX);
+        obj_ids = pdc_checkpoint_pool(map, rec->obj_ids, sizeof(uint64_t) * rec->n_obj);
+        if (rec->n_obj > 0 && obj_ids != NULL) {
+            cont_entry->obj_ids = (uint64_t *)malloc(sizeof(uint64_t) * rec->n_obj);
+            memcpy(cont_entry->obj_ids, obj_ids, sizeof(uint64_t) * rec->n_obj);
+            cont_entry->n_obj       = rec->n_obj;
+            cont_entry->n_deleted   = rec->n_deleted;
+            cont_entry->n_allocated = rec->n_obj;
+            total_mem_usage_g += sizeof(uint64_t) * rec->n_obj;
+        }
+        cont_entry->kvtag_list_head = pdc_checkpoint_restore_kvtags(map, rec->first_kvtag, rec->n_kvtag);
+        if (cont_entry->cont_id >= pdc_id_seq_g)
+            pdc_id_seq_g = cont_entry->cont_id + 1;
+
+        hash_key  = (uint32_t *)malloc(sizeof(uint32_t));
+        *hash_key = rec->hash_key;
+        total_mem_usage_g += sizeof(uint32_t) + sizeof(pdc_cont_hash_table_entry_t);
+
+#ifdef ENABLE_MULTITHREAD
+        hg_thread_mutex_lock(&pdc_container_hash_table_mutex_g);
+#endif
+        if (hash_table_insert(container_hash_table_g, hash_key, cont_entry) != 1) {
+            printf("==PDC_SERVER[%d]: %s - hash table insert failed\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+        }
+#ifdef ENABLE_MULTITHREAD
+        hg_thread_mutex_unlock(&pdc_container_hash_table_mutex_g);
+#endif
+    }
+
+    return ret_value;
+}
+
+/*
+ * Map a checkpoint file and locate its sections
+ */
+static perr_t
+pdc_checkpoint_map(const char *filename, pdc_checkpoint_map_t *map)
+{
+    perr_t                   ret_value = SUCCEED;
+    pdc_checkpoint_header_t *h;
+    struct stat              st;
+    uint64_t                 header_size;
+    int                      fd;
+
+    FUNC_ENTER(NULL);
+
+    memset(map, 0, sizeof(*map));
+    fd = open(filename, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || (uint64_t)st.st_size < PDC_CHECKPOINT_HEADER_SIZE_V1) {
+        printf("==PDC_SERVER[%d]: %s - cannot open %s\n", pdc_server_rank_g, __func__, filename);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    map->size = (uint64_t)st.st_size;
+    map->base = (char *)mmap(NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map->base == MAP_FAILED) {
+        printf("==PDC_SERVER[%d]: %s - cannot map %s\n", pdc_server_rank_g, __func__, filename);
+        map->base = NULL;
+        ret_value = FAIL;
+        goto done;
+    }
+    // The whole file is read, let the kernel read ahead
+    madvise(map->base, map->size, MADV_WILLNEED);
+
+    h           = (pdc_checkpoint_header_t *)map->base;
+    map->header = h;
+    header_size = h->version == 1 ? PDC_CHECKPOINT_HEADER_SIZE_V1 : sizeof(pdc_checkpoint_header_t);
+    if (memcmp(h->magic, PDC_CHECKPOINT_MAGIC, sizeof(PDC_CHECKPOINT_MAGIC)) != 0 || h->version < 1 ||
+        h->version > PDC_CHECKPOINT_VERSION || h->header_size != header_size ||
+        (h->version > 1 && !pdc_checkpoint_in_file(map, h->dart_off, h->dart_size, 1)) ||
+        !pdc_checkpoint_in_file(map, h->cont_off, h->n_cont, sizeof(pdc_checkpoint_cont_t)) ||
+        !pdc_checkpoint_in_file(map, h->bucket_off, h->n_bucket, sizeof(pdc_checkpoint_bucket_t)) ||
+        !pdc_checkpoint_in_file(map, h->obj_off, h->n_obj, sizeof(pdc_checkpoint_obj_t)) ||
+        !pdc_checkpoint_in_file(map, h->kvtag_off, h->n_kvtag, sizeof(pdc_checkpoint_kvtag_t)) ||
+        !pdc_checkpoint_in_file(map, h->region_off, h->n_region, sizeof(pdc_checkpoint_region_t)) ||
+        !pdc_checkpoint_in_file(map, h->hist_off, h->n_hist, sizeof(pdc_checkpoint_hist_t)) ||
+        !pdc_checkpoint_in_file(map, h->data_obj_off, h->n_data_obj, sizeof(pdc_checkpoint_data_obj_t)) ||
+        !pdc_checkpoint_in_file(map, h->pool_off, h->pool_size, 1) ||
+        !pdc_checkpoint_in_file(map, h->transfer_off, h->transfer_size, 1)) {
+        printf("==PDC_SERVER[%d]: %s - %s is not a valid checkpoint\n", pdc_server_rank_g, __func__,
+               filename);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    map->cont     = (pdc_checkpoint_cont_t *)(map->base + h->cont_off);
+    map->bucket   = (pdc_checkpoint_bucket_t *)(map->base + h->bucket_off);
+    map->obj      = (pdc_checkpoint_obj_t *)(map->base + h->obj_off);
+    map->kvtag    = (pdc_checkpoint_kvtag_t *)(map->base + h->kvtag_off);
+    map->region   = (pdc_checkpoint_region_t *)(map->base + h->region_off);
+    map->hist     = (pdc_checkpoint_hist_t *)(map->base + h->hist_off);
+    map->data_obj = (pdc_checkpoint_data_obj_t *)(map->base + h->data_obj_off);
+    map->pool     = map->base + h->pool_off;
+    if (h->version > 1 && h->dart_size > 0) {
+        map->dart      = map->base + h->dart_off;
+        map->dart_size = h->dart_size;
+    }
+
+done:
+    if (fd >= 0)
+        close(fd);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_checkpoint_load(const char *filename, uint64_t *wal_lsn, int *n_cont, int *n_obj, int *n_region)
+{
+    perr_t                   ret_value = SUCCEED;
+    pdc_checkpoint_map_t     map;
+    pdc_checkpoint_restore_t restore;
+    pdc_checkpoint_bucket_t *bucket;
+    pdc_metadata_t *         meta;
+    uint32_t *               hash_key;
+    uint64_t                 b, i, n_dart = 0;
+    char *                   env_char;
+    int                      nthread;
+
+    FUNC_ENTER(NULL);
+
+    memset(&restore, 0, sizeof(restore));
+    if (pdc_checkpoint_map(filename, &map) != SUCCEED) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    nthread  = PDC_RESTART_NTHREAD;
+    env_char = getenv("PDC_RESTART_NTHREAD");
+    if (env_char != NULL)
+        nthread = atoi(env_char);
+
+    ret_value = pdc_checkpoint_restore_conts(&map);
+    if (ret_value != SUCCEED)
+        goto done;
+
+    restore.map         = &map;
+    restore.heads       = (pdc_hash_table_entry_head **)calloc(map.header->n_bucket + 1, sizeof(void *));
+    restore.bucket_meta = (pdc_metadata_t **)calloc(map.header->n_bucket + 1, sizeof(void *));
+    restore.data_objs   = (data_server_region_t **)calloc(map.header->n_data_obj + 1, sizeof(void *));
+    ret_value           = pdc_checkpoint_run_jobs(&restore, nthread);
+    if (ret_value != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - %s has records out of range\n", pdc_server_rank_g, __func__, filename);
+        goto done;
+    }
+
+    // The hash tables are not thread safe, link the rebuilt objects into them here
+    *n_region = 0;
+    for (b = 0; b < map.header->n_bucket; b++) {
+        bucket    = map.bucket + b;
+        meta      = restore.bucket_meta[b];
+        hash_key  = (uint32_t *)malloc(sizeof(uint32_t));
+        *hash_key = bucket->hash_key;
+        ret_value = PDC_Server_hash_table_list_init(restore.heads[b], hash_key);
+        if (ret_value != SUCCEED)
+            goto done;
+        for (i = 0; i < bucket->n_obj; i++) {
+            // New objects must not reuse a restored ID
+            if (meta[i].obj_id >= pdc_id_seq_g)
+                pdc_id_seq_g = meta[i].obj_id + 1;
+            *n_region += map.obj[bucket->first_obj + i].n_region;
+            ret_value = PDC_Server_hash_table_list_insert(restore.heads[b], meta + i);
+            if (ret_value != SUCCEED) {
+                printf("==PDC_SERVER: error with hash table recovering from checkpoint file\n");
+                goto done;
+            }
+        }
+        total_mem_usage_g += sizeof(uint32_t) + sizeof(pdc_hash_table_entry_head);
+        total_mem_usage_g += sizeof(pdc_metadata_t) * bucket->n_obj;
+    }
+    for (b = 0; b < map.header->n_data_obj; b++)
+        DL_APPEND(dataserver_region_g, restore.data_objs[b]);
+
+    // The transfer metadata is copied out of the mapping
+    transfer_request_metadata_query_init(pdc_server_size_g,
+                                         map.header->transfer_size > 0 ? map.base + map.header->transfer_off
+                                                                       : NULL);
+
+    // The index is rebuilt from its entries, the object IDs it refers to need not be on this server
+    if (map.dart != NULL && PDC_Server_dart_deserialize(map.dart, map.dart_size, &n_dart) != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - DART index of %s is incomplete\n", pdc_server_rank_g, __func__,
+               filename);
+
+    *wal_lsn = map.header->wal_lsn;
+    *n_cont  = (int)map.header->n_cont;
+    *n_obj   = (int)map.header->n_obj;
+
+done:
+    free(restore.heads);
+    free(restore.bucket_meta);
+    free(restore.data_objs);
+    if (map.base != NULL)
+        munmap(map.base, map.size);
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
@@ -0,0 +1,532 @@
+#include "pdc_server_kvtag_index.h"
+#include "string_utils.h"
+
+// Tag name -> pdc_kvtag_index_name_t
+static art_tree *kvtag_name_tree_g = NULL;
+
+typedef struct pdc_kvtag_index_query_t {
+    pdc_kvtag_t *      in;
+    pdc_kvtag_range_t *range;
+    uint32_t           n_meta;
+    uint64_t **        obj_ids;
+    uint64_t           alloc_size;
+} pdc_kvtag_index_query_t;
+
+/*
+ * Build the key of a value in the value tree of a tag name.
+ * String values are stored as type, characters and the terminating 0, so they can be searched by prefix.
+ * Other values are stored as type, big-endian size and raw bytes, so no key is a prefix of another one.
+ *
+ * \param  type[IN]         Value type
+ * \param  value[IN]        Value
+ * \param  size[IN]         Value size in bytes
+ * \param  key_len[OUT]     Length of the key
+ *
+ * \return Key allocated with malloc
+ */
+static unsigned char *
+pdc_kvtag_index_value_key(int8_t type, const void *value, uint32_t size, int *key_len)
+{
+    unsigned char *key;
+    size_t         len;
+
+    if (type == (int8_t)PDC_STRING) {
+        len    = value == NULL ? 0 : strnlen((const char *)value, size);
+        key    = (unsigned char *)malloc(len + 2);
+        key[0] = (unsigned char)type;
+        memcpy(key + 1, value, len);
+        key[len + 1] = 0;
+        *key_len     = (int)len + 2;
+    }
+    else {
+        key    = (unsigned char *)malloc(size + 5);
+        key[0] = (unsigned char)type;
+        key[1] = (unsigned char)(size >> 24);
+        key[2] = (unsigned char)(size >> 16);
+        key[3] = (unsigned char)(size >> 8);
+        key[4] = (unsigned char)size;
+        if (size > 0)
+            memcpy(key + 5, value, size);
+        *key_len = (int)size + 5;
+    }
+
+    return key;
+}
+
+/*
+ * Return the index of the first object ID in the posting that is greater than obj_id
+ */
+static uint64_t
+pdc_kvtag_posting_upper_bound(pdc_kvtag_posting_t *posting, uint64_t obj_id)
+{
+    uint64_t lo = 0, hi = posting->n_obj, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (posting->obj_ids[mid] <= obj_id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Return the index of the first value in the sorted array whose key is not less than key
+ */
+static uint64_t
+pdc_kvtag_sorted_values_lower_bound(pdc_kvtag_sorted_values_t *sorted, uint64_t key)
+{
+    uint64_t lo = 0, hi = sorted->n_value, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (sorted->keys[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/*
+ * Add a new posting of a numeric value to the sorted array of its type
+ */
+static void
+pdc_kvtag_sorted_values_insert(pdc_kvtag_index_name_t *name_entry, pdc_kvtag_t *kvtag,
+                               pdc_kvtag_posting_t *posting)
+{
+    pdc_kvtag_sorted_values_t *sorted;
+    uint64_t                   key, pos;
+
+    if (kvtag->type < 0 || kvtag->type >= PDC_TYPE_COUNT ||
+        !kvtag_value_ordered_key(kvtag->type, kvtag->value, kvtag->size, &key))
+        return;
+
+    sorted = name_entry->numeric[kvtag->type];
+    if (sorted == NULL) {
+        sorted                           = (pdc_kvtag_sorted_values_t *)calloc(1, sizeof(*sorted));
+        name_entry->numeric[kvtag->type] = sorted;
+    }
+    if (sorted->n_value == sorted->alloc) {
+        sorted->alloc    = sorted->alloc == 0 ? 8 : sorted->alloc * 2;
+        sorted->keys     = (uint64_t *)realloc(sorted->keys, sorted->alloc * sizeof(uint64_t));
+        sorted->postings = (pdc_kvtag_posting_t **)realloc(sorted->postings,
+                                                            sorted->alloc * sizeof(pdc_kvtag_posting_t *));
+    }
+
+    pos = pdc_kvtag_sorted_values_lower_bound(sorted, key);
+    if (pos < sorted->n_value) {
+        memmove(sorted->keys + pos + 1, sorted->keys + pos, (sorted->n_value - pos) * sizeof(uint64_t));
+        memmove(sorted->postings + pos + 1, sorted->postings + pos,
+                (sorted->n_value - pos) * sizeof(pdc_kvtag_posting_t *));
+    }
+    sorted->keys[pos]     = key;
+    sorted->postings[pos] = posting;
+    sorted->n_value++;
+}
+
+/*
+ * Remove the posting of a numeric value from the sorted array of its type
+ */
+static void
+pdc_kvtag_sorted_values_remove(pdc_kvtag_index_name_t *name_entry, pdc_kvtag_t *kvtag,
+                               pdc_kvtag_posting_t *posting)
+{
+    pdc_kvtag_sorted_values_t *sorted;
+    uint64_t                   key, pos;
+
+    if (kvtag->type < 0 || kvtag->type >= PDC_TYPE_COUNT ||
+        !kvtag_value_ordered_key(kvtag->type, kvtag->value, kvtag->size, &key))
+        return;
+
+    sorted = name_entry->numeric[kvtag->type];
+    if (sorted == NULL)
+        return;
+
+    // Values of different sizes can share a key, look for the posting itself
+    for (pos = pdc_kvtag_sorted_values_lower_bound(sorted, key);
+         pos < sorted->n_value && sorted->keys[pos] == key; pos++) {
+        if (sorted->postings[pos] == posting) {
+            memmove(sorted->keys + pos, sorted->keys + pos + 1,
+                    (sorted->n_value - pos - 1) * sizeof(uint64_t));
+            memmove(sorted->postings + pos, sorted->postings + pos + 1,
+                    (sorted->n_value - pos - 1) * sizeof(pdc_kvtag_posting_t *));
+            sorted->n_value--;
+            break;
+        }
+    }
+}
+
+perr_t
+PDC_Server_kvtag_index_init()
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    if (kvtag_name_tree_g != NULL)
+        goto done;
+
+    kvtag_name_tree_g = (art_tree *)calloc(1, sizeof(art_tree));
+    if (kvtag_name_tree_g == NULL || art_tree_init(kvtag_name_tree_g) != 0) {
+        printf("==PDC_SERVER[%d]: %s - kvtag index init error!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+static int
+pdc_kvtag_index_free_posting(void *data ATTRIBUTE(unused), const unsigned char *key ATTRIBUTE(unused),
+                             uint32_t key_len ATTRIBUTE(unused), void *value)
+{
+    pdc_kvtag_posting_t *posting = (pdc_kvtag_posting_t *)value;
+
+    free(posting->obj_ids);
+    free(posting);
+    return 0;
+}
+
+static int
+pdc_kvtag_index_free_name(void *data ATTRIBUTE(unused), const unsigned char *key ATTRIBUTE(unused),
+                          uint32_t key_len ATTRIBUTE(unused), void *value)
+{
+    pdc_kvtag_index_name_t *name_entry = (pdc_kvtag_index_name_t *)value;
+    int                     i;
+
+    art_iter(&name_entry->values, pdc_kvtag_index_free_posting, NULL);
+    art_tree_destroy(&name_entry->values);
+    for (i = 0; i < PDC_TYPE_COUNT; i++) {
+        if (name_entry->numeric[i] != NULL) {
+            free(name_entry->numeric[i]->keys);
+            free(name_entry->numeric[i]->postings);
+            free(name_entry->numeric[i]);
+        }
+    }
+    free(name_entry);
+    return 0;
+}
+
+perr_t
+PDC_Server_kvtag_index_finalize()
+{
+    FUNC_ENTER(NULL);
+
+    if (kvtag_name_tree_g != NULL) {
+        art_iter(kvtag_name_tree_g, pdc_kvtag_index_free_name, NULL);
+        art_tree_destroy(kvtag_name_tree_g);
+        free(kvtag_name_tree_g);
+        kvtag_name_tree_g = NULL;
+    }
+
+    FUNC_LEAVE(SUCCEED);
+}
+
+perr_t
+PDC_Server_kvtag_index_insert(uint64_t obj_id, pdc_kvtag_t *kvtag)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_kvtag_index_name_t *name_entry;
+    pdc_kvtag_posting_t *   posting;
+    unsigned char *         value_key = NULL;
+    int                     value_key_len;
+    uint64_t                pos;
+
+    FUNC_ENTER(NULL);
+
+    if (kvtag_name_tree_g == NULL || kvtag == NULL || kvtag->name == NULL) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    name_entry = art_search(kvtag_name_tree_g, (unsigned char *)kvtag->name, strlen(kvtag->name) + 1);
+    if (name_entry == NULL) {
+        name_entry = (pdc_kvtag_index_name_t *)calloc(1, sizeof(pdc_kvtag_index_name_t));
+        art_tree_init(&name_entry->values);
+        art_insert(kvtag_name_tree_g, (unsigned char *)kvtag->name, strlen(kvtag->name) + 1, name_entry);
+    }
+
+    value_key = pdc_kvtag_index_value_key(kvtag->type, kvtag->value, kvtag->size, &value_key_len);
+    posting   = art_search(&name_entry->values, value_key, value_key_len);
+    if (posting == NULL) {
+        posting          = (pdc_kvtag_posting_t *)calloc(1, sizeof(pdc_kvtag_posting_t));
+        posting->alloc   = 4;
+        posting->obj_ids = (uint64_t *)malloc(posting->alloc * sizeof(uint64_t));
+        art_insert(&name_entry->values, value_key, value_key_len, posting);
+        pdc_kvtag_sorted_values_insert(name_entry, kvtag, posting);
+        name_entry->n_posting++;
+    }
+
+    if (posting->n_obj == posting->alloc) {
+        posting->alloc *= 2;
+        posting->obj_ids = (uint64_t *)realloc(posting->obj_ids, posting->alloc * sizeof(uint64_t));
+    }
+    // Object IDs mostly grow, so this is usually an append
+    pos = pdc_kvtag_posting_upper_bound(posting, obj_id);
+    if (pos < posting->n_obj)
+        memmove(posting->obj_ids + pos + 1, posting->obj_ids + pos,
+                (posting->n_obj - pos) * sizeof(uint64_t));
+    posting->obj_ids[pos] = obj_id;
+    posting->n_obj++;
+
+done:
+    free(value_key);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_kvtag_index_remove(uint64_t obj_id, pdc_kvtag_t *kvtag)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_kvtag_index_name_t *name_entry;
+    pdc_kvtag_posting_t *   posting;
+    unsigned char *         value_key = NULL;
+    int                     value_key_len;
+    uint64_t                pos;
+
+    FUNC_ENTER(NULL);
+
+    if (kvtag_name_tree_g == NULL || kvtag == NULL || kvtag->name == NULL) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    name_entry = art_search(kvtag_name_tree_g, (unsigned char *)kvtag->name, strlen(kvtag->name) + 1);
+    if (name_entry == NULL) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    value_key = pdc_kvtag_index_value_key(kvtag->type, kvtag->value, kvtag->size, &value_key_len);
+    posting   = art_search(&name_entry->values, value_key, value_key_len);
+    if (posting == NULL) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    pos = pdc_kvtag_posting_upper_bound(posting, obj_id);
+    if (pos == 0 || posting->obj_ids[pos - 1] != obj_id) {
+        ret_value = FAIL;
+        goto done;
+    }
+    memmove(posting->obj_ids + pos - 1, posting->obj_ids + pos, (posting->n_obj - pos) * sizeof(uint64_t));
+    posting->n_obj--;
+
+    if (posting->n_obj == 0) {
+        art_delete(&name_entry->values, value_key, value_key_len);
+        pdc_kvtag_sorted_values_remove(name_entry, kvtag, posting);
+        pdc_kvtag_index_free_posting(NULL, NULL, 0, posting);
+        name_entry->n_posting--;
+    }
+    if (name_entry->n_posting == 0) {
+        art_delete(kvtag_name_tree_g, (unsigned char *)kvtag->name, strlen(kvtag->name) + 1);
+        pdc_kvtag_index_free_name(NULL, NULL, 0, name_entry);
+    }
+
+done:
+    free(value_key);
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Append all object IDs of a posting to the query result
+ */
+static void
+pdc_kvtag_index_collect(pdc_kvtag_index_query_t *query, pdc_kvtag_posting_t *posting)
+{
+    if (posting == NULL || posting->n_obj == 0)
+        return;
+
+    if (query->n_meta + posting->n_obj > query->alloc_size) {
+        while (query->n_meta + posting->n_obj > query->alloc_size)
+            query->alloc_size *= 2;
+        *query->obj_ids = (void *)realloc(*query->obj_ids, query->alloc_size * sizeof(uint64_t));
+    }
+    memcpy(*query->obj_ids + query->n_meta, posting->obj_ids, posting->n_obj * sizeof(uint64_t));
+    query->n_meta += posting->n_obj;
+}
+
+static int
+pdc_kvtag_index_collect_cb(void *data, const unsigned char *key ATTRIBUTE(unused),
+                           uint32_t key_len ATTRIBUTE(unused), void *value)
+{
+    pdc_kvtag_index_collect((pdc_kvtag_index_query_t *)data, (pdc_kvtag_posting_t *)value);
+    return 0;
+}
+
+static int
+pdc_kvtag_index_match_value_cb(void *data, const unsigned char *key, uint32_t key_len ATTRIBUTE(unused),
+                               void *value)
+{
+    pdc_kvtag_index_query_t *query = (pdc_kvtag_index_query_t *)data;
+
+    // Skip the type byte, the rest of a string value key is 0 terminated
+    if (simple_matches((const char *)key + 1, (const char *)query->in->value))
+        pdc_kvtag_index_collect(query, (pdc_kvtag_posting_t *)value);
+    return 0;
+}
+
+/*
+ * Collect the postings of the numeric values of one tag name that are in the query range
+ */
+static void
+pdc_kvtag_index_query_range_values(pdc_kvtag_index_query_t *query, pdc_kvtag_index_name_t *name_entry)
+{
+    pdc_kvtag_range_t *        range = query->range;
+    pdc_kvtag_sorted_values_t *sorted;
+    uint64_t                   lo, hi, pos;
+
+    if (range->type < 0 || range->type >= PDC_TYPE_COUNT)
+        return;
+    sorted = name_entry->numeric[range->type];
+    if (sorted == NULL || !kvtag_range_ordered_bounds(range, &lo, &hi))
+        return;
+
+    pos = pdc_kvtag_sorted_values_lower_bound(sorted, lo);
+    for (; pos < sorted->n_value && sorted->keys[pos] <= hi; pos++)
+        pdc_kvtag_index_collect(query, sorted->postings[pos]);
+}
+
+/*
+ * Collect the postings of the values of one tag name that match the query value
+ */
+static void
+pdc_kvtag_index_query_values(pdc_kvtag_index_query_t *query, pdc_kvtag_index_name_t *name_entry)
+{
+    pdc_kvtag_t *  in = query->in;
+    unsigned char *value_key;
+    int            value_key_len;
+
+    if (query->range != NULL) {
+        pdc_kvtag_index_query_range_values(query, name_entry);
+    }
+    else if (in->type == (int8_t)PDC_STRING) {
+        switch (determine_pattern_type((const char *)in->value)) {
+            case PATTERN_EXACT:
+                value_key = pdc_kvtag_index_value_key(in->type, in->value, in->size, &value_key_len);
+                pdc_kvtag_index_collect(query, art_search(&name_entry->values, value_key, value_key_len));
+                free(value_key);
+                break;
+            case PATTERN_PREFIX:
+                // Drop the trailing '*' and the terminating 0, every key starting with the rest matches
+                value_key = pdc_kvtag_index_value_key(in->type, in->value, in->size, &value_key_len);
+                art_iter_prefix(&name_entry->values, value_key, value_key_len - 2, pdc_kvtag_index_collect_cb,
+                                query);
+                free(value_key);
+                break;
+            default:
+                // Suffix and infix patterns have to check every string value of this name
+                value_key = (unsigned char *)&in->type;
+                art_iter_prefix(&name_entry->values, value_key, 1, pdc_kvtag_index_match_value_cb, query);
+                break;
+        }
+    }
+    else {
+        value_key = pdc_kvtag_index_value_key(in->type, in->value, in->size, &value_key_len);
+        pdc_kvtag_index_collect(query, art_search(&name_entry->values, value_key, value_key_len));
+        free(value_key);
+    }
+}
+
+static int
+pdc_kvtag_index_query_name_cb(void *data, const unsigned char *key ATTRIBUTE(unused),
+                              uint32_t key_len ATTRIBUTE(unused), void *value)
+{
+    pdc_kvtag_index_query_values((pdc_kvtag_index_query_t *)data, (pdc_kvtag_index_name_t *)value);
+    return 0;
+}
+
+static int
+pdc_kvtag_index_match_name_cb(void *data, const unsigned char *key, uint32_t key_len ATTRIBUTE(unused),
+                              void *value)
+{
+    pdc_kvtag_index_query_t *query = (pdc_kvtag_index_query_t *)data;
+
+    if (simple_matches((const char *)key, query->range != NULL ? query->range->name : query->in->name))
+        pdc_kvtag_index_query_values(query, (pdc_kvtag_index_name_t *)value);
+    return 0;
+}
+
+/*
+ * Run a query over all tag names that match its name
+ */
+static void
+pdc_kvtag_index_query_names(pdc_kvtag_index_query_t *query, const char *name)
+{
+    pdc_kvtag_index_name_t *name_entry;
+
+    switch (determine_pattern_type(name)) {
+        case PATTERN_EXACT:
+            name_entry = art_search(kvtag_name_tree_g, (unsigned char *)name, strlen(name) + 1);
+            if (name_entry != NULL)
+                pdc_kvtag_index_query_values(query, name_entry);
+            break;
+        case PATTERN_PREFIX:
+            art_iter_prefix(kvtag_name_tree_g, (unsigned char *)name, strlen(name) - 1,
+                            pdc_kvtag_index_query_name_cb, query);
+            break;
+        default:
+            art_iter(kvtag_name_tree_g, pdc_kvtag_index_match_name_cb, query);
+            break;
+    }
+}
+
+perr_t
+PDC_Server_kvtag_index_query(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_ids, uint64_t alloc_size)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_kvtag_index_query_t query;
+
+    FUNC_ENTER(NULL);
+
+    *n_meta = 0;
+    if (kvtag_name_tree_g == NULL || in == NULL || in->name == NULL) {
+        printf("==PDC_SERVER[%d]: %s - kvtag index not initialized!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    query.in         = in;
+    query.range      = NULL;
+    query.n_meta     = 0;
+    query.obj_ids    = obj_ids;
+    query.alloc_size = alloc_size;
+    pdc_kvtag_index_query_names(&query, in->name);
+
+    *n_meta = query.n_meta;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_kvtag_index_query_range(pdc_kvtag_range_t *range, uint32_t *n_meta, uint64_t **obj_ids,
+                                   uint64_t alloc_size)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_kvtag_index_query_t query;
+
+    FUNC_ENTER(NULL);
+
+    *n_meta = 0;
+    if (kvtag_name_tree_g == NULL || range == NULL || range->name == NULL) {
+        printf("==PDC_SERVER[%d]: %s - kvtag index not initialized!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    query.in         = NULL;
+    query.range      = range;
+    query.n_meta     = 0;
+    query.obj_ids    = obj_ids;
+    query.alloc_size = alloc_size;
+    pdc_kvtag_index_query_names(&query, range->name);
+
+    *n_meta = query.n_meta;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "pdc_server_kvtag_index.h"
+
+void
+add_string_tag(uint64_t obj_id, char *name, char *value)
+{
+    pdc_kvtag_t kvtag;
+
+    kvtag.name  = name;
+    kvtag.type  = PDC_STRING;
+    kvtag.value = value;
+    kvtag.size  = strlen(value) + 1;
+    assert(PDC_Server_kvtag_index_insert(obj_id, &kvtag) == SUCCEED);
+}
+
+void
+add_int_tag(uint64_t obj_id, char *name, int value)
+{
+    pdc_kvtag_t kvtag;
+
+    kvtag.name  = name;
+    kvtag.type  = PDC_INT;
+    kvtag.value = &value;
+    kvtag.size  = sizeof(int);
+    assert(PDC_Server_kvtag_index_insert(obj_id, &kvtag) == SUCCEED);
+}
+
+uint32_t
+query_count(char *name, int8_t type, void *value, uint32_t size)
+{
+    pdc_kvtag_t kvtag;
+    uint32_t    n_meta  = 0;
+    uint64_t *  obj_ids = (uint64_t *)calloc(2, sizeof(uint64_t));
+
+    kvtag.name  = name;
+    kvtag.type  = type;
+    kvtag.value = value;
+    kvtag.size  = size;
+    assert(PDC_Server_kvtag_index_query(&kvtag, &n_meta, &obj_ids, 2) == SUCCEED);
+    printf("Query %s: %u results\n", name, n_meta);
+    free(obj_ids);
+
+    return n_meta;
+}
+
+uint32_t
+query_string_count(char *name, char *value)
+{
+    return query_count(name, PDC_STRING, value, strlen(value) + 1);
+}
+
+uint32_t
+query_int_range_count(char *name, pdc_kvtag_op_t lo_op, int lo, pdc_kvtag_op_t hi_op, int hi)
+{
+    pdc_kvtag_range_t range;
+    uint32_t          n_meta  = 0;
+    uint64_t *        obj_ids = (uint64_t *)calloc(2, sizeof(uint64_t));
+
+    range.name  = name;
+    range.type  = PDC_INT;
+    range.size  = sizeof(int);
+    range.lo_op = lo_op;
+    range.lo    = &lo;
+    range.hi_op = hi_op;
+    range.hi    = &hi;
+    assert(PDC_Server_kvtag_index_query_range(&range, &n_meta, &obj_ids, 2) == SUCCEED);
+    printf("Range query %s: %u results\n", name, n_meta);
+    free(obj_ids);
+
+    return n_meta;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t    i;
+    int         v;
+    pdc_kvtag_t kvtag;
+
+    assert(PDC_Server_kvtag_index_init() == SUCCEED);
+
+    for (i = 0; i < 100; i++) {
+        add_string_tag(i, "experiment", i % 2 == 0 ? "run_even" : "run_odd");
+        add_int_tag(i, "timestep", (int)(i % 10));
+        add_int_tag(i, "temperature", (int)i - 50);
+    }
+    add_string_tag(1000, "exposure", "long");
+
+    assert(query_string_count("experiment", "run_even") == 50);
+    assert(query_string_count("experiment", "run_*") == 100);
+    assert(query_string_count("experiment", "*odd") == 50);
+    assert(query_string_count("experiment", "*un_*") == 100);
+    assert(query_string_count("exp*", "long") == 1);
+    assert(query_string_count("*ment", "run_odd") == 50);
+    assert(query_string_count("experiment", "missing") == 0);
+    assert(query_string_count("missing", "run_odd") == 0);
+
+    v = 3;
+    assert(query_count("timestep", PDC_INT, &v, sizeof(int)) == 10);
+
+    assert(query_int_range_count("timestep", PDC_KVTAG_OP_GTE, 3, PDC_KVTAG_OP_LT, 5) == 20);
+    assert(query_int_range_count("timestep", PDC_KVTAG_OP_GT, 3, PDC_KVTAG_OP_LTE, 5) == 20);
+    assert(query_int_range_count("timestep", PDC_KVTAG_OP_GT, 8, PDC_KVTAG_OP_NONE, 0) == 10);
+    assert(query_int_range_count("timestep", PDC_KVTAG_OP_GT, 5, PDC_KVTAG_OP_LT, 5) == 0);
+    assert(query_int_range_count("temperature", PDC_KVTAG_OP_NONE, 0, PDC_KVTAG_OP_LT, -40) == 10);
+    assert(query_int_range_count("temperature", PDC_KVTAG_OP_GTE, -5, PDC_KVTAG_OP_LTE, 4) == 10);
+    assert(query_int_range_count("t*", PDC_KVTAG_OP_GTE, 0, PDC_KVTAG_OP_LTE, 0) == 11);
+
+    // Remove the even runs
+    for (i = 0; i < 100; i += 2) {
+        kvtag.name  = "experiment";
+        kvtag.type  = PDC_STRING;
+        kvtag.value = "run_even";
+        kvtag.size  = strlen("run_even") + 1;
+        assert(PDC_Server_kvtag_index_remove(i, &kvtag) == SUCCEED);
+    }
+    assert(PDC_Server_kvtag_index_remove(0, &kvtag) == FAIL);
+    assert(query_string_count("experiment", "run_*") == 50);
+    assert(query_string_count("experiment", "run_even") == 0);
+
+    // Removing a numeric value also drops it from the range index
+    for (i = 0; i < 100; i++) {
+        v           = (int)i - 50;
+        kvtag.name  = "temperature";
+        kvtag.type  = PDC_INT;
+        kvtag.value = &v;
+        kvtag.size  = sizeof(int);
+        if (v < 0)
+            assert(PDC_Server_kvtag_index_remove(i, &kvtag) == SUCCEED);
+    }
+    assert(query_int_range_count("temperature", PDC_KVTAG_OP_NONE, 0, PDC_KVTAG_OP_LT, 10) == 10);
+
+    assert(PDC_Server_kvtag_index_finalize() == SUCCEED);
+    printf("All kvtag index tests passed\n");
+
+    return 0;
+}
@@ -43,29 +43,31 @@
 
 #include "pdc_utlist.h"
 #include "pdc_hash-table.h"
-#include "pdc_dablooms.h"
+#include "pdc_server_bloom.h"
 #include "pdc_interface.h"
 #include "pdc_client_server_common.h"
 #include "pdc_server_metadata.h"
+#include "pdc_server_kvtag_index.h"
+#include "pdc_server_metadata_wal.h"
 #include "pdc_server.h"
 #include "mercury_hash_table.h"
 #include "pdc_malloc.h"
 #include "string_utils.h"
 
-#define BLOOM_TYPE_T counting_bloom_t
-#define BLOOM_NEW    new_counting_bloom
-#define BLOOM_CHECK  counting_bloom_check
-#define BLOOM_ADD    counting_bloom_add
-#define BLOOM_REMOVE counting_bloom_remove
-#define BLOOM_FREE   free_counting_bloom
-
 // Global hash table for storing metadata
 HashTable *metadata_hash_table_g  = NULL;
 HashTable *container_hash_table_g = NULL;
 
+// Secondary index of the metadata in metadata_hash_table_g, keyed by object ID
+HashTable *metadata_id_hash_table_g = NULL;
+
+// Bloom filter of the name and time step of all objects in metadata_hash_table_g
+static pdc_bloom_t *metadata_bloom_g = NULL;
+
 // Debug statistics var
 int      n_bloom_total_g            = 0;
 int      n_bloom_maybe_g            = 0;
+int      n_bloom_false_g            = 0;
 double   server_bloom_check_time_g  = 0.0;
 double   server_bloom_insert_time_g = 0.0;
 double   server_insert_time_g       = 0.0;
@@ -132,6 +134,35 @@ PDC_Server_metadata_int_hash(void *vlocation)
     return *((uint32_t *)vlocation);
 }
 
+/*
+ * Get the location of an object ID key in the ID hash table
+ *
+ * \param vlocation [IN]        Hash table key
+ *
+ * \return the location of hash key in the table
+ */
+static unsigned int
+PDC_Server_metadata_id_hash(void *vlocation)
+{
+    uint64_t obj_id = *((uint64_t *)vlocation);
+
+    return (unsigned int)(obj_id ^ (obj_id >> 32));
+}
+
+/*
+ * Check if two object ID keys are equal
+ *
+ * \param vlocation1 [IN]       Hash table key
+ * \param vlocation2 [IN]       Hash table key
+ *
+ * \return 1 if two keys are equal, 0 otherwise
+ */
+static int
+PDC_Server_metadata_id_equal(void *vlocation1, void *vlocation2)
+{
+    return *((uint64_t *)vlocation1) == *((uint64_t *)vlocation2);
+}
+
 /*
  * Free the hash key
  *
@@ -162,11 +193,6 @@ PDC_Server_metadata_hash_value_free(void *value)
 
     head = (pdc_hash_table_entry_head *)value;
 
-    // Free bloom filter
-    if (head->bloom != NULL) {
-        BLOOM_FREE(head->bloom);
-    }
-
     // Free metadata list
     if (is_restart_g == 0) {
         DL_FOREACH_SAFE(head->metadata, elt, tmp)
@@ -282,35 +308,15 @@ done:
 pdc_metadata_t *
 find_metadata_by_id(uint64_t obj_id)
 {
-    pdc_metadata_t *           ret_value = NULL;
-    pdc_hash_table_entry_head *head;
-    pdc_metadata_t *           elt;
-    HashTableIterator          hash_table_iter;
-    HashTablePair              pair;
-    int                        n_entry;
+    pdc_metadata_t *ret_value = NULL;
 
     FUNC_ENTER(NULL);
 
-    if (metadata_hash_table_g != NULL) {
-        // Since we only have the obj id, need to iterate the entire hash table
-        n_entry = hash_table_num_entries(metadata_hash_table_g);
-        hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
-
-        while (n_entry != 0 && hash_table_iter_has_more(&hash_table_iter)) {
-
-            pair = hash_table_iter_next(&hash_table_iter);
-            head = pair.value;
-            // Now iterate the list under this entry
-            DL_FOREACH(head->metadata, elt)
-            {
-                if (elt->obj_id == obj_id) {
-                    return elt;
-                }
-            }
-        }
-    } // if (metadata_hash_table_g != NULL)
+    if (metadata_id_hash_table_g != NULL) {
+        ret_value = hash_table_lookup(metadata_id_hash_table_g, &obj_id);
+    }
     else {
-        printf("==PDC_SERVER: metadata_hash_table_g not initialized!\n");
+        printf("==PDC_SERVER: metadata_id_hash_table_g not initialized!\n");
         goto done;
     }
 
@@ -350,16 +356,15 @@ static pdc_metadata_t *
 find_identical_metadata(pdc_hash_table_entry_head *entry, pdc_metadata_t *a)
 {
     pdc_metadata_t *ret_value = NULL;
-    BLOOM_TYPE_T *  bloom;
     int             bloom_check;
     char            combined_string[TAG_LEN_MAX];
     pdc_metadata_t *elt;
 
     FUNC_ENTER(NULL);
 
-    // Use bloom filter to quick check if current metadata is in the list
-    if (entry->bloom != NULL && a->user_id != 0 && a->app_name[0] != 0) {
-        bloom = entry->bloom;
+    // Use bloom filter to quick check if current metadata is in a long list
+    if (metadata_bloom_g != NULL && entry->n_obj >= CREATE_BLOOM_THRESHOLD && a->user_id != 0 &&
+        a->app_name[0] != 0) {
         combine_obj_info_to_string(a, combined_string);
 
 #ifdef ENABLE_TIMING
@@ -370,7 +375,14 @@ find_identical_metadata(pdc_hash_table_entry_head *entry, pdc_metadata_t *a)
         gettimeofday(&pdc_timer_start, 0);
 #endif
 
-        bloom_check = BLOOM_CHECK(bloom, combined_string, strlen(combined_string));
+#ifdef ENABLE_MULTITHREAD
+        // The filter is replaced when it is rebuilt
+        hg_thread_mutex_lock(&insert_hash_table_mutex_g);
+#endif
+        bloom_check = PDC_bloom_check(metadata_bloom_g, combined_string, strlen(combined_string));
+#ifdef ENABLE_MULTITHREAD
+        hg_thread_mutex_unlock(&insert_hash_table_mutex_g);
+#endif
 
 #ifdef ENABLE_TIMING
         gettimeofday(&pdc_timer_end, 0);
@@ -404,6 +416,7 @@ find_identical_metadata(pdc_hash_table_entry_head *entry, pdc_metadata_t *a)
                     goto done;
                 }
             }
+            n_bloom_false_g++;
         }
     }
     else {
@@ -462,6 +475,17 @@ PDC_Server_init_hash_table()
     hash_table_register_free_functions(metadata_hash_table_g, PDC_Server_metadata_int_hash_key_free,
                                        PDC_Server_metadata_hash_value_free);
 
+    // Object ID index, the keys point to the obj_id of the metadata, which is owned by metadata_hash_table_g
+    metadata_id_hash_table_g = hash_table_new(PDC_Server_metadata_id_hash, PDC_Server_metadata_id_equal);
+    if (metadata_id_hash_table_g == NULL) {
+        printf("==PDC_SERVER: metadata_id_hash_table_g init error! Exit...\n");
+        goto done;
+    }
+
+    // Inverted index of object kvtags
+    if (PDC_Server_kvtag_index_init() != SUCCEED)
+        goto done;
+
     // Container hash table
     container_hash_table_g = hash_table_new(PDC_Server_metadata_int_hash, PDC_Server_metadata_int_equal);
     if (container_hash_table_g == NULL) {
@@ -478,163 +502,153 @@ done:
 }
 
 /*
- * Remove a metadata from bloom filter
- *
- * \param  metadata[IN]     Metadata pointer of the remove target
- * \param  bloom[IN]        Bloom filter's pointer
+ * Size the bloom filter for twice the objects of this server and add all of them to it
  *
  * \return Non-negative on success/Negative on failure
  */
 static perr_t
-PDC_Server_remove_from_bloom(pdc_metadata_t *metadata, BLOOM_TYPE_T *bloom)
+PDC_Server_bloom_rebuild()
 {
-    perr_t ret_value = SUCCEED;
+    perr_t                     ret_value = SUCCEED;
+    uint64_t                   n_obj     = 0;
+    pdc_bloom_t *              bloom;
+    HashTableIterator          hash_table_iter;
+    HashTablePair              pair;
+    pdc_hash_table_entry_head *head;
+    pdc_metadata_t *           elt;
+    char                       combined_string[TAG_LEN_MAX];
 
     FUNC_ENTER(NULL);
 
+#ifdef ENABLE_TIMING
+    // Timing
+    struct timeval pdc_timer_start;
+    struct timeval pdc_timer_end;
+    double         ht_total_sec;
+
+    gettimeofday(&pdc_timer_start, 0);
+#endif
+
+    hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
+    while (hash_table_iter_has_more(&hash_table_iter)) {
+        pair = hash_table_iter_next(&hash_table_iter);
+        head = pair.value;
+        n_obj += head->n_obj;
+    }
+
+    bloom = PDC_bloom_new(n_obj * 2 > BLOOM_INIT_CAPACITY ? n_obj * 2 : BLOOM_INIT_CAPACITY);
     if (bloom == NULL) {
-        printf("==PDC_SERVER: PDC_Server_remove_from_bloom(): bloom pointer is NULL\n");
+        printf("==PDC_SERVER[%d]: %s - unable to allocate a bloom filter for %" PRIu64 " objects\n",
+               pdc_server_rank_g, __func__, n_obj);
         ret_value = FAIL;
         goto done;
     }
 
-    char combined_string[TAG_LEN_MAX];
-    combine_obj_info_to_string(metadata, combined_string);
-
-    ret_value = BLOOM_REMOVE(bloom, combined_string, strlen(combined_string));
-    if (ret_value != SUCCEED) {
-        printf("==PDC_SERVER[%d]: PDC_Server_remove_from_bloom() - error\n", pdc_server_rank_g);
-        goto done;
+    hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
+    while (hash_table_iter_has_more(&hash_table_iter)) {
+        pair = hash_table_iter_next(&hash_table_iter);
+        head = pair.value;
+        DL_FOREACH(head->metadata, elt)
+        {
+            combine_obj_info_to_string(elt, combined_string);
+            PDC_bloom_add(bloom, combined_string, strlen(combined_string));
+        }
     }
 
+    PDC_bloom_free(metadata_bloom_g);
+    metadata_bloom_g = bloom;
+
+#ifdef ENABLE_TIMING
+    // Timing
+    gettimeofday(&pdc_timer_end, 0);
+    ht_total_sec = PDC_get_elapsed_time_double(&pdc_timer_start, &pdc_timer_end);
+
+    server_bloom_init_time_g += ht_total_sec;
+#endif
+
 done:
     FUNC_LEAVE(ret_value);
 }
 
 /*
- * Add a metadata to bloom filter
+ * Add a metadata to the bloom filter, which is rebuilt larger once it is full. Removed objects are left in
+ * the filter until then.
  *
- * \param  metadata[IN]     Metadata pointer of the target
- * \param  bloom[IN]        Bloom filter's pointer
+ * \param  metadata[IN]     Metadata pointer of the target, already in metadata_hash_table_g
  *
  * \return Non-negative on success/Negative on failure
  */
 static perr_t
-PDC_Server_add_to_bloom(pdc_metadata_t *metadata, BLOOM_TYPE_T *bloom)
+PDC_Server_add_to_bloom(pdc_metadata_t *metadata)
 {
     perr_t ret_value = SUCCEED;
     char   combined_string[TAG_LEN_MAX];
 
     FUNC_ENTER(NULL);
 
-    if (bloom == NULL) {
-        goto done;
+    if (metadata_bloom_g == NULL || PDC_bloom_is_full(metadata_bloom_g)) {
+        // The rebuilt filter already holds the new object
+        ret_value = PDC_Server_bloom_rebuild();
+        if (ret_value == SUCCEED || metadata_bloom_g == NULL)
+            goto done;
+        // Keep the full filter, it only gets more false positives
+        ret_value = SUCCEED;
     }
 
     combine_obj_info_to_string(metadata, combined_string);
-
-    ret_value = BLOOM_ADD(bloom, combined_string, strlen(combined_string));
-    if (ret_value != SUCCEED) {
-        printf("==PDC_SERVER[%d]: PDC_Server_add_to_bloom() - error \n", pdc_server_rank_g);
-        goto done;
-    }
+    PDC_bloom_add(metadata_bloom_g, combined_string, strlen(combined_string));
 
 done:
     FUNC_LEAVE(ret_value);
 }
 
 /*
- * Init a bloom filter
+ * Remove all kvtags of an object from the kvtag index
  *
- * \param  entry[IN]     Entry of the metadata hash table
+ * \param  metadata[IN]     Metadata of the object
  *
- * \return Non-negative on success/Negative on failure
+ * \return void
  */
-static perr_t
-PDC_Server_bloom_init(pdc_hash_table_entry_head *entry)
+static void
+PDC_Server_kvtag_index_remove_obj(pdc_metadata_t *metadata)
 {
-    perr_t ret_value  = 0;
-    int    capacity   = 500000;
-    double error_rate = 0.05;
-
-    FUNC_ENTER(NULL);
-
-    // Init bloom filter
-    n_bloom_maybe_g = 0;
-    n_bloom_total_g = 0;
-
-#ifdef ENABLE_TIMING
-    // Timing
-    struct timeval pdc_timer_start;
-    struct timeval pdc_timer_end;
-    double         ht_total_sec;
-
-    gettimeofday(&pdc_timer_start, 0);
-#endif
+    pdc_kvtag_list_t *kvtag_elt;
 
-    entry->bloom = (BLOOM_TYPE_T *)BLOOM_NEW(capacity, error_rate);
-    if (!entry->bloom) {
-        fprintf(stderr, "ERROR: Could not create bloom filter\n");
-        ret_value = -1;
-        goto done;
+    DL_FOREACH(metadata->kvtag_list_head, kvtag_elt)
+    {
+        PDC_Server_kvtag_index_remove(metadata->obj_id, kvtag_elt->kvtag);
     }
-
-#ifdef ENABLE_TIMING
-    // Timing
-    gettimeofday(&pdc_timer_end, 0);
-    ht_total_sec = PDC_get_elapsed_time_double(&pdc_timer_start, &pdc_timer_end);
-
-    server_bloom_init_time_g += ht_total_sec;
-#endif
-
-done:
-    FUNC_LEAVE(ret_value);
 }
 
 perr_t
 PDC_Server_hash_table_list_insert(pdc_hash_table_entry_head *head, pdc_metadata_t *new)
 {
-    perr_t          ret_value = SUCCEED;
-    pdc_metadata_t *elt;
+    perr_t            ret_value = SUCCEED;
+    pdc_kvtag_list_t *kvtag_elt;
 
     FUNC_ENTER(NULL);
 
-    // add to bloom filter
-    if (head->n_obj == CREATE_BLOOM_THRESHOLD) {
-        PDC_Server_bloom_init(head);
-        DL_FOREACH(head->metadata, elt)
-        {
-            PDC_Server_add_to_bloom(elt, head->bloom);
-        }
-        ret_value = PDC_Server_add_to_bloom(new, head->bloom);
-        if (ret_value != SUCCEED) {
-            printf("==PDC_SERVER[%d]: PDC_Server_hash_table_list_insert() - error add to bloom\n",
-                   pdc_server_rank_g);
-            goto done;
-        }
-    }
-    else if (head->n_obj >= CREATE_BLOOM_THRESHOLD || head->bloom != NULL) {
-        ret_value = PDC_Server_add_to_bloom(new, head->bloom);
-        if (ret_value != SUCCEED) {
-            printf("==PDC_SERVER[%d]: PDC_Server_hash_table_list_insert() - error add to bloom\n",
-                   pdc_server_rank_g);
-            goto done;
-        }
-    }
-
 #ifdef ENABLE_MULTITHREAD
     hg_thread_mutex_lock(&insert_hash_table_mutex_g);
 #endif
     // Currently $metadata is unique, insert to linked list
     DL_APPEND(head->metadata, new);
     head->n_obj++;
+    hash_table_insert(metadata_id_hash_table_g, &new->obj_id, new);
+    // Objects restored from a checkpoint already carry their kvtags
+    DL_FOREACH(new->kvtag_list_head, kvtag_elt)
+    {
+        PDC_Server_kvtag_index_insert(new->obj_id, kvtag_elt->kvtag);
+    }
+    // Without a filter, lookups walk the lists
+    if (PDC_Server_add_to_bloom(new) != SUCCEED)
+        printf("==PDC_SERVER[%d]: PDC_Server_hash_table_list_insert() - error add to bloom\n",
+               pdc_server_rank_g);
 
 #ifdef ENABLE_MULTITHREAD
     hg_thread_mutex_unlock(&insert_hash_table_mutex_g);
 #endif
 
-done:
-
     FUNC_LEAVE(ret_value);
 }
 
@@ -682,6 +696,7 @@ PDC_Server_add_tag_metadata(metadata_add_tag_in_t *in, metadata_add_tag_out_t *o
 
     perr_t    ret_value = SUCCEED;
     uint32_t *hash_key  = NULL;
+    size_t    tags_len;
 #ifdef ENABLE_MULTITHREAD
     int unlocked = 0;
 #endif
@@ -729,11 +744,19 @@ PDC_Server_add_tag_metadata(metadata_add_tag_in_t *in, metadata_add_tag_out_t *o
                 // obj_name change is done through client with delete and add operation.
                 if (in->new_tag != NULL && in->new_tag[0] != 0 &&
                     !(in->new_tag[0] == ' ' && in->new_tag[1] == 0)) {
+                    tags_len = strlen(target->tags);
                     // add a ',' to separate different tags
                     target->tags[strlen(target->tags) + 1] = 0;
                     target->tags[strlen(target->tags)]     = ',';
                     strcat(target->tags, in->new_tag);
-                    out->ret = 1;
+                    if (PDC_Server_wal_log_obj_put(*hash_key, target) != SUCCEED) {
+                        // The tag would be lost on restart
+                        target->tags[tags_len] = 0;
+                        ret_value              = FAIL;
+                        out->ret               = -1;
+                    }
+                    else
+                        out->ret = 1;
                 }
                 else
                     out->ret = -1;
@@ -805,6 +828,7 @@ PDC_Server_update_metadata(metadata_update_in_t *in, metadata_update_out_t *out)
     pdc_hash_table_entry_head *lookup_value;
     uint32_t *                 hash_key = NULL;
     pdc_metadata_t *           target;
+    pdc_metadata_t             prev_metadata;
 
     FUNC_ENTER(NULL);
 
@@ -844,6 +868,8 @@ PDC_Server_update_metadata(metadata_update_in_t *in, metadata_update_out_t *out)
                 // Check and find valid update fields
                 // Currently user_id, obj_name are not supported to be updated in this way
                 // obj_name change is done through client with delete and add operation.
+                // Restored if the update cannot be logged
+                memcpy(&prev_metadata, target, sizeof(pdc_metadata_t));
                 if (in->new_metadata.time_step != -1)
                     target->time_step = in->new_metadata.time_step;
                 if (in->new_metadata.app_name[0] != 0 &&
@@ -869,7 +895,13 @@ PDC_Server_update_metadata(metadata_update_in_t *in, metadata_update_out_t *out)
                     target->current_state.dims[3]    = in->new_metadata.t_dims3;
                     target->current_state.meta_index = in->new_metadata.t_meta_index;
                 }
-                out->ret = 1;
+                if (PDC_Server_wal_log_obj_put(*hash_key, target) != SUCCEED) {
+                    memcpy(target, &prev_metadata, sizeof(pdc_metadata_t));
+                    ret_value = FAIL;
+                    out->ret  = -1;
+                }
+                else
+                    out->ret = 1;
             } // if (lookup_value != NULL)
             else {
                 // Object not found for deletion request
@@ -969,6 +1001,11 @@ PDC_Server_delete_metadata_by_id(metadata_delete_by_id_in_t *in, metadata_delete
                 continue;
 
             if (cont_entry->cont_id == target_obj_id) {
+                // The container is only removed once the deletion is logged
+                if (PDC_Server_wal_log_obj_delete(target_obj_id) != SUCCEED) {
+                    ret_value = FAIL;
+                    goto done;
+                }
                 hash_table_remove(container_hash_table_g, pair.key);
                 out->ret  = 1;
                 ret_value = SUCCEED;
@@ -977,45 +1014,35 @@ PDC_Server_delete_metadata_by_id(metadata_delete_by_id_in_t *in, metadata_delete
         }
     }
     if (out->ret == -1 && metadata_hash_table_g != NULL) {
-
-        // Since we only have the obj id, need to iterate the entire hash table
         pdc_hash_table_entry_head *head;
+        uint32_t                   hash_key;
 
-        n_entry = hash_table_num_entries(metadata_hash_table_g);
-        hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
-
-        while (n_entry != 0 && hash_table_iter_has_more(&hash_table_iter)) {
-
-            pair = hash_table_iter_next(&hash_table_iter);
-            head = pair.value;
-            // Now iterate the list under this entry
-            DL_FOREACH(head->metadata, elt)
-            {
-
-                if (elt->obj_id == target_obj_id) {
-                    // We found the delete target
-                    // Check if there are more objects in this list
-                    if (head->n_obj > 1) {
-                        // Remove from bloom filter
-                        if (head->bloom != NULL) {
-                            PDC_Server_remove_from_bloom(elt, head->bloom);
-                        }
-
-                        // Remove from linked list
-                        DL_DELETE(head->metadata, elt);
-                        head->n_obj--;
-                    }
-                    else {
-                        // This is the last item under the current entry, remove the hash entry
-                        uint32_t hash_key = PDC_get_hash_by_name(elt->obj_name);
-                        hash_table_remove(metadata_hash_table_g, &hash_key);
-                    }
-                    out->ret  = 1;
-                    ret_value = SUCCEED;
-                }
-            } // DL_FOREACH
-        }     // while
-    }         // if (metadata_hash_table_g != NULL)
+        elt = find_metadata_by_id(target_obj_id);
+        // The object is only removed once the deletion is logged
+        if (elt != NULL && PDC_Server_wal_log_obj_delete(target_obj_id) != SUCCEED) {
+            ret_value = FAIL;
+            goto done;
+        }
+        if (elt != NULL) {
+            hash_key = PDC_get_hash_by_name(elt->obj_name);
+            head     = hash_table_lookup(metadata_hash_table_g, &hash_key);
+            hash_table_remove(metadata_id_hash_table_g, &elt->obj_id);
+            PDC_Server_kvtag_index_remove_obj(elt);
+            // We found the delete target
+            // Check if there are more objects in this list
+            if (head->n_obj > 1) {
+                // Remove from linked list, the bloom filter keeps it until it is rebuilt
+                DL_DELETE(head->metadata, elt);
+                head->n_obj--;
+            }
+            else {
+                // This is the last item under the current entry, remove the hash entry
+                hash_table_remove(metadata_hash_table_g, &hash_key);
+            }
+            out->ret  = 1;
+            ret_value = SUCCEED;
+        }
+    } // if (metadata_hash_table_g != NULL)
     else {
         printf("==PDC_SERVER: metadata_hash_table_g not initialized!\n");
         ret_value = FAIL;
@@ -1113,14 +1140,16 @@ PDC_delete_metadata_from_hash_table(metadata_delete_in_t *in, metadata_delete_ou
         if (lookup_value != NULL) {
             // Check if there exist metadata identical to current one
             target = find_identical_metadata(lookup_value, &metadata);
-            if (target != NULL) {
+            // The object is only removed once the deletion is logged
+            if (target != NULL && PDC_Server_wal_log_obj_delete(target->obj_id) != SUCCEED) {
+                ret_value = FAIL;
+                out->ret  = -1;
+            }
+            else if (target != NULL) {
+                hash_table_remove(metadata_id_hash_table_g, &target->obj_id);
+                PDC_Server_kvtag_index_remove_obj(target);
                 if (lookup_value->n_obj > 1) {
-                    // Remove from bloom filter
-                    if (lookup_value->bloom != NULL) {
-                        PDC_Server_remove_from_bloom(target, lookup_value->bloom);
-                    }
-
-                    // Remove from linked list
+                    // Remove from linked list, the bloom filter keeps it until it is rebuilt
                     DL_DELETE(lookup_value->metadata, target);
                     lookup_value->n_obj--;
                 }
@@ -1291,10 +1320,21 @@ PDC_insert_metadata_to_hash_table(gen_obj_id_in_t *in, gen_obj_id_out_t *out)
                 free(metadata);
                 goto done;
             }
-            else {
-                PDC_Server_hash_table_list_insert(lookup_value, metadata);
-            }
         }
+
+        // Generate object id (uint64_t), the object is only inserted once it is logged
+        metadata->obj_id = PDC_Server_gen_obj_id();
+        if (PDC_Server_wal_log_obj_put(*hash_key, metadata) != SUCCEED) {
+            printf("==PDC_SERVER[%d]: %s - cannot log object %s\n", pdc_server_rank_g, __func__,
+                   metadata->obj_name);
+            out->obj_id = 0;
+            free(metadata);
+            free(hash_key);
+            ret_value = FAIL;
+            goto done;
+        }
+        if (lookup_value != NULL)
+            PDC_Server_hash_table_list_insert(lookup_value, metadata);
         else {
             // First entry for current hasy_key, init linked list, and insert to hash table
             if (debug_flag == 1) {
@@ -1304,7 +1344,6 @@ PDC_insert_metadata_to_hash_table(gen_obj_id_in_t *in, gen_obj_id_out_t *out)
 
             pdc_hash_table_entry_head *entry =
                 (pdc_hash_table_entry_head *)PDC_malloc(sizeof(pdc_hash_table_entry_head));
-            entry->bloom    = NULL;
             entry->metadata = NULL;
             entry->n_obj    = 0;
             total_mem_usage_g += sizeof(pdc_hash_table_entry_head);
@@ -1318,9 +1357,6 @@ PDC_insert_metadata_to_hash_table(gen_obj_id_in_t *in, gen_obj_id_out_t *out)
         goto done;
     }
 
-    // Generate object id (uint64_t)
-    metadata->obj_id = PDC_Server_gen_obj_id();
-
 #ifdef ENABLE_MULTITHREAD
     // ^ Release hash table lock
     hg_thread_mutex_unlock(&pdc_metadata_hash_table_mutex_g);
@@ -1490,6 +1526,41 @@ done:
     FUNC_LEAVE(ret_value);
 }
 
+perr_t
+PDC_Server_bloom_finalize()
+{
+    perr_t   ret_value = SUCCEED;
+    uint64_t bytes, all_bytes;
+    int      all_false, all_negative, n_negative;
+
+    FUNC_ENTER(NULL);
+
+    bytes = PDC_bloom_bytes(metadata_bloom_g);
+    // Lookups of objects that do not exist, the filter should have rejected all of them
+    n_negative = n_bloom_total_g - n_bloom_maybe_g + n_bloom_false_g;
+
+#ifdef ENABLE_MPI
+    MPI_Reduce(&bytes, &all_bytes, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&n_bloom_false_g, &all_false, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&n_negative, &all_negative, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+#else
+    all_bytes    = bytes;
+    all_false    = n_bloom_false_g;
+    all_negative = n_negative;
+#endif
+
+    if (pdc_server_rank_g == 0) {
+        printf("==PDC_SERVER: Bloom filters use %" PRIu64 " bytes, %d false positives out of %d lookups of "
+               "missing objects (%.4f)\n",
+               all_bytes, all_false, all_negative, all_negative > 0 ? (double)all_false / all_negative : 0.0);
+    }
+
+    PDC_bloom_free(metadata_bloom_g);
+    metadata_bloom_g = NULL;
+
+    FUNC_LEAVE(ret_value);
+}
+
 /*
  * Check if the metadata satisfies the constraint received from client
  *
@@ -1596,13 +1667,18 @@ done:
 pbool_t
 _is_matching_kvtag(pdc_kvtag_t *in, pdc_kvtag_t *kvtag)
 {
-    pbool_t ret_value = TRUE;
+    pbool_t           ret_value = TRUE;
+    pdc_kvtag_range_t range;
     FUNC_ENTER(NULL);
     // match attribute name
     if (!simple_matches(kvtag->name, in->name)) {
         return FALSE;
     }
 
+    // numeric range query
+    if (kvtag_range_decode(in, &range))
+        return kvtag_range_matches(&range, kvtag->type, kvtag->value, kvtag->size) ? TRUE : FALSE;
+
     // test attribute type
     if (in->type != kvtag->type) {
         return FALSE;
@@ -1615,7 +1691,7 @@ _is_matching_kvtag(pdc_kvtag_t *in, pdc_kvtag_t *kvtag)
         }
     }
     else { // FIXME: for all numeric types, we use memcmp to compare, for exact value query, but we also
-           // have to support range query.
+           // use a range query to compare values by order.
         if (memcmp(in->value, kvtag->value, in->size) != 0)
             return FALSE;
     }
@@ -1648,6 +1724,72 @@ sqlite_query_kvtag_callback(void *data, int argc, char **argv, char **colName)
 }
 #endif
 
+#ifdef ENABLE_ROCKSDB
+// Bytes a range key adds to the tag name: '~', the name terminator, the type and two 8-byte integers
+#define PDC_ROCKSDB_RANGE_KEY_EXTRA 19
+
+/*
+ * Build the range key of a numeric tag: '~' name '\0' type ordered_key obj_id, with both integers stored
+ * big-endian, so that the keys of one name and type sort by value. Return the length of the key.
+ */
+static size_t
+PDC_Server_rocksdb_range_key(char *buf, const char *name, int8_t type, uint64_t ordered_key, uint64_t obj_id)
+{
+    size_t len = 0;
+    int    i;
+
+    buf[len++] = '~';
+    strcpy(buf + len, name);
+    len += strlen(name) + 1;
+    buf[len++] = (char)type;
+    for (i = 7; i >= 0; i--)
+        buf[len++] = (char)(ordered_key >> (i * 8));
+    for (i = 7; i >= 0; i--)
+        buf[len++] = (char)(obj_id >> (i * 8));
+
+    return len;
+}
+
+/*
+ * Delete the range keys of the value currently stored under rocksdb_key. The type of the value is not
+ * stored, so the range key it would have under every numeric type of its size is deleted.
+ */
+static perr_t
+PDC_Server_rocksdb_del_range_keys(rocksdb_writeoptions_t *writeoptions, const char *rocksdb_key,
+                                  const char *name, uint64_t obj_id)
+{
+    perr_t                 ret_value   = SUCCEED;
+    rocksdb_readoptions_t *readoptions = rocksdb_readoptions_create();
+    char                   range_key[TAG_LEN_MAX + PDC_ROCKSDB_RANGE_KEY_EXTRA];
+    char *                 value, *err = NULL;
+    size_t                 value_len, range_key_len;
+    uint64_t               ordered_key;
+    int                    type;
+
+    value = rocksdb_get(rocksdb_g, readoptions, rocksdb_key, strlen(rocksdb_key) + 1, &value_len, &err);
+    if (err == NULL && value != NULL) {
+        for (type = 0; type < PDC_TYPE_COUNT; type++) {
+            if (!kvtag_value_ordered_key(type, value, value_len, &ordered_key))
+                continue;
+            range_key_len = PDC_Server_rocksdb_range_key(range_key, name, type, ordered_key, obj_id);
+            rocksdb_delete(rocksdb_g, writeoptions, range_key, range_key_len, &err);
+            if (err != NULL)
+                break;
+        }
+        rocksdb_free(value);
+    }
+    rocksdb_readoptions_destroy(readoptions);
+
+    if (err != NULL) {
+        printf("==PDC_SERVER[%d]: error with rocksdb range key of [%s], [%s]!\n", pdc_server_rank_g, name,
+               err);
+        ret_value = FAIL;
+    }
+
+    return ret_value;
+}
+#endif
+
 static perr_t
 PDC_Server_query_kvtag_rocksdb(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_ids, uint64_t alloc_size)
 {
@@ -1667,6 +1809,9 @@ PDC_Server_query_kvtag_rocksdb(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj
     // Iterate over all rocksdb kv
     while (rocksdb_iter_valid(rocksdb_iter)) {
         rocksdb_key = rocksdb_iter_key(rocksdb_iter, &len);
+        // Range keys start with '~' and sort after all object keys
+        if (len > 0 && rocksdb_key[0] == '~')
+            break;
         /* sprintf(rocksdb_key, "%lu`%s", obj_id, in->kvtag.name); */
         sscanf(rocksdb_key, "%lu`%s", &obj_id, name);
         tmp.name  = name;
@@ -1807,63 +1952,178 @@ PDC_Server_query_kvtag_sqlite(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_
 }
 
 static perr_t
-PDC_Server_query_kvtag_someta(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_ids, uint64_t alloc_size)
+PDC_Server_query_kvtag_range_rocksdb(pdc_kvtag_range_t *range, uint32_t *n_meta, uint64_t **obj_ids,
+                                     uint64_t alloc_size)
 {
-    perr_t                     ret_value = SUCCEED;
-    uint32_t                   iter      = 0;
-    pdc_hash_table_entry_head *head;
-    pdc_metadata_t *           elt;
-    pdc_kvtag_list_t *         kvtag_list_elt;
-    HashTableIterator          hash_table_iter;
-    int                        n_entry, is_name_match, is_value_match;
-    HashTablePair              pair;
+    perr_t ret_value = SUCCEED;
+#ifdef ENABLE_ROCKSDB
+    char                   seek_key[TAG_LEN_MAX + PDC_ROCKSDB_RANGE_KEY_EXTRA];
+    const char *           rocksdb_key, *name, *pos;
+    size_t                 len, seek_len, name_len;
+    uint64_t               lo, hi, ordered_key, obj_id;
+    uint32_t               iter = 0;
+    int                    exact, i;
+    rocksdb_readoptions_t *readoptions;
+    rocksdb_iterator_t *   rocksdb_iter;
+
+    *n_meta = 0;
+    if (!kvtag_range_ordered_bounds(range, &lo, &hi))
+        goto done;
 
-    if (metadata_hash_table_g != NULL) {
+    // With an exact name, the keys of the name and type are contiguous and sorted by value
+    exact = determine_pattern_type(range->name) == PATTERN_EXACT;
+    if (exact) {
+        seek_len = PDC_Server_rocksdb_range_key(seek_key, range->name, range->type, lo, 0);
+    }
+    else {
+        seek_key[0] = '~';
+        seek_len    = 1;
+    }
 
-        n_entry = hash_table_num_entries(metadata_hash_table_g);
-        hash_table_iterate(metadata_hash_table_g, &hash_table_iter);
+    readoptions  = rocksdb_readoptions_create();
+    rocksdb_iter = rocksdb_create_iterator(rocksdb_g, readoptions);
+    rocksdb_iter_seek(rocksdb_iter, seek_key, seek_len);
 
-        while (n_entry != 0 && hash_table_iter_has_more(&hash_table_iter)) {
-            pair = hash_table_iter_next(&hash_table_iter);
-            head = pair.value;
-            DL_FOREACH(head->metadata, elt)
-            {
-#ifdef PDC_DEBUG_OUTPUT
-                printf("==PDC_SERVER: Matching kvtag [\"%s\":\"%s\"] of object %s on condition in->key: "
-                       "%s, in->value: %s ",
-                       (char *)kvtag_list_elt->kvtag->name, (char *)kvtag_list_elt->kvtag->value,
-                       elt->obj_name, in->name, in->value);
-#endif
-                DL_FOREACH(elt->kvtag_list_head, kvtag_list_elt)
-                {
-                    if (_is_matching_kvtag(in, kvtag_list_elt->kvtag) == TRUE) {
-#ifdef PDC_DEBUG_OUTPUT
-                        println("[Found]");
-#endif
-                        if (iter >= alloc_size) {
-                            alloc_size *= 2;
-                            *obj_ids = (void *)realloc(*obj_ids, alloc_size * sizeof(uint64_t));
-                        }
-                        (*obj_ids)[iter++] = elt->obj_id;
-                        // break; // FIXME: shall we break here? or continue to check other kvtags?
-                    }
-                    else {
-#ifdef PDC_DEBUG_OUTPUT
-                        println("[NOT FOUND]");
-#endif
-                    }
-                } // End for each kvtag in list
-            }     // End for each metadata from hash table entry
-        }         // End looping metadata hash table
-        *n_meta = iter;
-#ifdef PDC_DEBUG_OUTPUT
-        printf("==PDC_SERVER[%d]: found %d objids \n", pdc_server_rank_g, iter);
+    while (rocksdb_iter_valid(rocksdb_iter)) {
+        rocksdb_key = rocksdb_iter_key(rocksdb_iter, &len);
+        if (len == 0 || rocksdb_key[0] != '~')
+            break;
+
+        name     = rocksdb_key + 1;
+        name_len = strnlen(name, len - 1);
+        if (len != name_len + PDC_ROCKSDB_RANGE_KEY_EXTRA) {
+            rocksdb_iter_next(rocksdb_iter);
+            continue;
+        }
+        pos         = name + name_len + 1;
+        ordered_key = 0;
+        obj_id      = 0;
+        for (i = 0; i < 8; i++) {
+            ordered_key = (ordered_key << 8) | (uint8_t)pos[1 + i];
+            obj_id      = (obj_id << 8) | (uint8_t)pos[9 + i];
+        }
+
+        if (exact) {
+            if ((int8_t)pos[0] != range->type || ordered_key > hi || strcmp(name, range->name) != 0)
+                break;
+        }
+        else if ((int8_t)pos[0] != range->type || ordered_key < lo || ordered_key > hi ||
+                 !simple_matches(name, range->name)) {
+            rocksdb_iter_next(rocksdb_iter);
+            continue;
+        }
+
+        if (iter >= alloc_size) {
+            alloc_size *= 2;
+            *obj_ids = (void *)realloc(*obj_ids, alloc_size * sizeof(uint64_t));
+        }
+        (*obj_ids)[iter++] = obj_id;
+        rocksdb_iter_next(rocksdb_iter);
+    }
+
+    *n_meta = iter;
+
+    rocksdb_iter_destroy(rocksdb_iter);
+    rocksdb_readoptions_destroy(readoptions);
+
+done:
+#else
+    printf("==PDC_SERVER[%d]: enabled rocksdb but PDC is not compiled with it!\n", pdc_server_rank_g);
+    ret_value = FAIL;
 #endif
-    } // if (metadata_hash_table_g != NULL)
+    return ret_value;
+}
+
+static perr_t
+PDC_Server_query_kvtag_range_sqlite(pdc_kvtag_range_t *range, uint32_t *n_meta, uint64_t **obj_ids,
+                                    uint64_t alloc_size)
+{
+    perr_t ret_value = SUCCEED;
+#ifdef ENABLE_SQLITE3
+    char                sql[TAG_LEN_MAX + 256], lo_str[64], hi_str[64];
+    char *              errMessage = NULL;
+    char *              tmp_name, *current_pos;
+    const char *        column, *lo_cmp, *hi_cmp;
+    pdc_sqlite3_query_t query_data;
+
+    *n_meta = 0;
+    if (range->type == PDC_INT && range->size == sizeof(int)) {
+        column = "value_int";
+        if (range->lo_op != PDC_KVTAG_OP_NONE)
+            sprintf(lo_str, "%d", *((int *)range->lo));
+        if (range->hi_op != PDC_KVTAG_OP_NONE)
+            sprintf(hi_str, "%d", *((int *)range->hi));
+    }
+    else if (range->type == PDC_FLOAT && range->size == sizeof(float)) {
+        column = "value_float";
+        if (range->lo_op != PDC_KVTAG_OP_NONE)
+            sprintf(lo_str, "%.9g", *((float *)range->lo));
+        if (range->hi_op != PDC_KVTAG_OP_NONE)
+            sprintf(hi_str, "%.9g", *((float *)range->hi));
+    }
+    else if (range->type == PDC_DOUBLE && range->size == sizeof(double)) {
+        column = "value_double";
+        if (range->lo_op != PDC_KVTAG_OP_NONE)
+            sprintf(lo_str, "%.17g", *((double *)range->lo));
+        if (range->hi_op != PDC_KVTAG_OP_NONE)
+            sprintf(hi_str, "%.17g", *((double *)range->hi));
+    }
     else {
-        printf("==PDC_SERVER: metadata_hash_table_g not initialized!\n");
+        printf("==PDC_SERVER[%d]: datatype not supported %d!\n", pdc_server_rank_g, range->type);
         ret_value = FAIL;
+        goto done;
+    }
+
+    tmp_name = strdup(range->name);
+    // replace * with % for sqlite3
+    current_pos = strchr(tmp_name, '*');
+    while (current_pos) {
+        *current_pos = '%';
+        current_pos  = strchr(current_pos, '*');
+    }
+
+    // The (name, value) indexes serve both the name match and the value range
+    sprintf(sql, "SELECT objid FROM objects WHERE name %s \'%s\' AND %s IS NOT NULL",
+            NULL == strstr(range->name, "*") ? "=" : "LIKE", tmp_name, column);
+    if (range->lo_op != PDC_KVTAG_OP_NONE) {
+        lo_cmp = range->lo_op == PDC_KVTAG_OP_GT ? ">" : ">=";
+        sprintf(sql + strlen(sql), " AND %s %s %s", column, lo_cmp, lo_str);
     }
+    if (range->hi_op != PDC_KVTAG_OP_NONE) {
+        hi_cmp = range->hi_op == PDC_KVTAG_OP_LT ? "<" : "<=";
+        sprintf(sql + strlen(sql), " AND %s %s %s", column, hi_cmp, hi_str);
+    }
+    strcat(sql, ";");
+    free(tmp_name);
+
+    query_data.nobj    = 0;
+    query_data.nalloc  = alloc_size;
+    query_data.obj_ids = obj_ids;
+
+    sqlite3_exec(sqlite3_db_g, sql, sqlite_query_kvtag_callback, &query_data, &errMessage);
+    if (errMessage)
+        printf("==PDC_SERVER[%d]: error from SQLite %s!\n", pdc_server_rank_g, errMessage);
+
+    *n_meta = query_data.nobj;
+
+done:
+#else
+    printf("==PDC_SERVER[%d]: enabled SQLite3 but PDC is not compiled with it!\n", pdc_server_rank_g);
+    ret_value = FAIL;
+#endif
+    return ret_value;
+}
+
+static perr_t
+PDC_Server_query_kvtag_someta(pdc_kvtag_t *in, uint32_t *n_meta, uint64_t **obj_ids, uint64_t alloc_size)
+{
+    perr_t ret_value = SUCCEED;
+
+    // Only the postings of the matching names and values are visited
+    ret_value = PDC_Server_kvtag_index_query(in, n_meta, obj_ids, alloc_size);
+#ifdef PDC_DEBUG_OUTPUT
+    printf("==PDC_SERVER[%d]: found %d objids \n", pdc_server_rank_g, *n_meta);
+#endif
 
     return ret_value;
 }
@@ -1874,22 +2134,31 @@ PDC_Server_get_kvtag_query_result(pdc_kvtag_t *in /*FIXME: query input should be
 {
     perr_t ret_value = SUCCEED;
 
-    uint32_t alloc_size = 128;
+    uint32_t          alloc_size = 128;
+    pdc_kvtag_range_t range;
+    int               is_range;
 
     FUNC_ENTER(NULL);
 
     *n_meta  = 0;
     *obj_ids = (void *)calloc(alloc_size, sizeof(uint64_t));
+    is_range = kvtag_range_decode(in, &range);
 
     if (use_rocksdb_g == 1) {
-        ret_value = PDC_Server_query_kvtag_rocksdb(in, n_meta, obj_ids, alloc_size);
+        if (is_range)
+            ret_value = PDC_Server_query_kvtag_range_rocksdb(&range, n_meta, obj_ids, alloc_size);
+        else
+            ret_value = PDC_Server_query_kvtag_rocksdb(in, n_meta, obj_ids, alloc_size);
         if (ret_value != SUCCEED) {
             printf("==PDC_SERVER[%d]: Error with PDC_Server_query_kvtag_rocksdb!\n", pdc_server_rank_g);
             goto done;
         }
     }
     else if (use_sqlite3_g) {
-        ret_value = PDC_Server_query_kvtag_sqlite(in, n_meta, obj_ids, alloc_size);
+        if (is_range)
+            ret_value = PDC_Server_query_kvtag_range_sqlite(&range, n_meta, obj_ids, alloc_size);
+        else
+            ret_value = PDC_Server_query_kvtag_sqlite(in, n_meta, obj_ids, alloc_size);
         if (ret_value != SUCCEED) {
             printf("==PDC_SERVER[%d]: Error with PDC_Server_query_kvtag_sqlite!\n", pdc_server_rank_g);
             goto done;
@@ -1897,7 +2166,10 @@ PDC_Server_get_kvtag_query_result(pdc_kvtag_t *in /*FIXME: query input should be
     } // End if SQLite3
     else {
         // SoMeta backend
-        ret_value = PDC_Server_query_kvtag_someta(in, n_meta, obj_ids, alloc_size);
+        if (is_range)
+            ret_value = PDC_Server_kvtag_index_query_range(&range, n_meta, obj_ids, alloc_size);
+        else
+            ret_value = PDC_Server_query_kvtag_someta(in, n_meta, obj_ids, alloc_size);
         if (ret_value != SUCCEED) {
             printf("==PDC_SERVER[%d]: Error with PDC_Server_query_kvtag_someta!\n", pdc_server_rank_g);
             goto done;
@@ -2238,8 +2510,16 @@ PDC_Server_create_container(gen_cont_id_in_t *in, gen_cont_id_out_t *out)
 #ifdef ENABLE_MULTITHREAD
             hg_thread_mutex_unlock(&total_mem_usage_mutex_g);
 #endif
+            // The container is only inserted once it is logged
+            if (PDC_Server_wal_log_cont_create(*hash_key, entry) != SUCCEED) {
+                printf("==PDC_SERVER[%d]: %s - cannot log container %s\n", pdc_server_rank_g, __func__,
+                       entry->cont_name);
+                free(entry);
+                free(hash_key);
+                ret_value = FAIL;
+            }
             // Insert to hash table
-            if (hash_table_insert(container_hash_table_g, hash_key, entry) != 1) {
+            else if (hash_table_insert(container_hash_table_g, hash_key, entry) != 1) {
                 printf("==PDC_SERVER[%d]: %s - hash table insert failed\n", pdc_server_rank_g, __func__);
                 ret_value = FAIL;
             }
@@ -2750,26 +3030,38 @@ PDC_free_cont_hash_table()
 }
 
 /*
- * Add the kvtag received from one client to the corresponding metadata structure
+ * Add the kvtag received from one client to the corresponding metadata structure. A tag with the same
+ * name gets the new value, so adding a tag again, as a replay of the metadata log does, keeps one copy.
  *
- * \param  in[IN]       Input structure received from client
- * \param  out[OUT]     Output structure to be sent back to the client
+ * \param  list_head[IN/OUT]    Tag list of the object or container
+ * \param  tag[IN]              Tag to add
+ * \param  old_tag[OUT]         Replaced tag, to be freed by the caller, NULL if the name was new
  *
  * \return Non-negative on success/Negative on failure
  */
 static perr_t
-PDC_add_kvtag_to_list(pdc_kvtag_list_t **list_head, pdc_kvtag_t *tag)
+PDC_add_kvtag_to_list(pdc_kvtag_list_t **list_head, pdc_kvtag_t *tag, pdc_kvtag_t **old_tag)
 {
     perr_t            ret_value = SUCCEED;
-    pdc_kvtag_list_t *new_list_item;
+    pdc_kvtag_list_t *new_list_item, *elt;
     pdc_kvtag_t *     newtag;
     FUNC_ENTER(NULL);
 
     PDC_kvtag_dup(tag, &newtag);
+    *old_tag = NULL;
+    DL_FOREACH(*list_head, elt)
+    {
+        if (strcmp(elt->kvtag->name, tag->name) == 0) {
+            *old_tag   = elt->kvtag;
+            elt->kvtag = newtag;
+            goto done;
+        }
+    }
     new_list_item        = (pdc_kvtag_list_t *)PDC_calloc(1, sizeof(pdc_kvtag_list_t));
     new_list_item->kvtag = newtag;
     DL_APPEND(*list_head, new_list_item);
 
+done:
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
@@ -2781,8 +3073,17 @@ PDC_Server_add_kvtag_rocksdb(metadata_add_kvtag_in_t *in, metadata_add_tag_out_t
 #ifdef ENABLE_ROCKSDB
     rocksdb_writeoptions_t *writeoptions             = rocksdb_writeoptions_create();
     char                    rocksdb_key[TAG_LEN_MAX] = {0};
+    char                    range_key[TAG_LEN_MAX + PDC_ROCKSDB_RANGE_KEY_EXTRA];
+    size_t                  range_key_len;
+    uint64_t                ordered_key;
     sprintf(rocksdb_key, "%lu`%s", in->obj_id, in->kvtag.name);
     char *err = NULL;
+
+    // Drop the range key of the value this put replaces
+    if (PDC_Server_rocksdb_del_range_keys(writeoptions, rocksdb_key, in->kvtag.name, in->obj_id) != SUCCEED) {
+        ret_value = FAIL;
+        goto done;
+    }
     // Debug
     /* printf("Put [%s] [%d], len%lu\n", in->kvtag.name, *((int*)in->kvtag.value), in->kvtag.size); */
     rocksdb_put(rocksdb_g, writeoptions, rocksdb_key, strlen(rocksdb_key) + 1, in->kvtag.value,
@@ -2791,9 +3092,25 @@ PDC_Server_add_kvtag_rocksdb(metadata_add_kvtag_in_t *in, metadata_add_tag_out_t
         printf("==PDC_SERVER[%d]: error with rocksdb_put %s, [%s]!\n", pdc_server_rank_g, in->kvtag.name,
                err);
         ret_value = FAIL;
+        goto done;
     }
-    else
-        out->ret = 1;
+
+    // Numeric values also get a range key ordered by value
+    if (kvtag_value_ordered_key(in->kvtag.type, in->kvtag.value, in->kvtag.size, &ordered_key)) {
+        range_key_len = PDC_Server_rocksdb_range_key(range_key, in->kvtag.name, in->kvtag.type, ordered_key,
+                                                     in->obj_id);
+        rocksdb_put(rocksdb_g, writeoptions, range_key, range_key_len, "", 0, &err);
+        if (err != NULL) {
+            printf("==PDC_SERVER[%d]: error with rocksdb_put range key %s, [%s]!\n", pdc_server_rank_g,
+                   in->kvtag.name, err);
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+    out->ret = 1;
+
+done:
+    rocksdb_writeoptions_destroy(writeoptions);
 #else
     printf("==PDC_SERVER[%d]: enabled rocksdb but PDC is not compiled with it!\n", pdc_server_rank_g);
     ret_value = FAIL;
@@ -2855,6 +3172,7 @@ PDC_Server_add_kvtag_someta(metadata_add_kvtag_in_t *in, metadata_add_tag_out_t
     perr_t                       ret_value = SUCCEED;
     pdc_hash_table_entry_head *  lookup_value;
     pdc_cont_hash_table_entry_t *cont_lookup_value;
+    pdc_kvtag_t *                old_tag;
     uint32_t                     hash_key;
 
     hash_key = in->hash_value;
@@ -2863,8 +3181,18 @@ PDC_Server_add_kvtag_someta(metadata_add_kvtag_in_t *in, metadata_add_tag_out_t
     if (lookup_value != NULL) {
         pdc_metadata_t *target;
         target = find_metadata_by_id_from_list(lookup_value->metadata, in->obj_id);
-        if (target != NULL) {
-            PDC_add_kvtag_to_list(&target->kvtag_list_head, &in->kvtag);
+        // The tag is only added once it is logged
+        if (target != NULL && PDC_Server_wal_log_kvtag_add(hash_key, in->obj_id, &in->kvtag) != SUCCEED) {
+            ret_value = FAIL;
+            out->ret  = -1;
+        }
+        else if (target != NULL) {
+            PDC_add_kvtag_to_list(&target->kvtag_list_head, &in->kvtag, &old_tag);
+            if (old_tag != NULL) {
+                PDC_Server_kvtag_index_remove(target->obj_id, old_tag);
+                PDC_free_kvtag(&old_tag);
+            }
+            PDC_Server_kvtag_index_insert(target->obj_id, &in->kvtag);
             out->ret = 1;
         } // if (lookup_value != NULL)
         else {
@@ -2875,8 +3203,15 @@ PDC_Server_add_kvtag_someta(metadata_add_kvtag_in_t *in, metadata_add_tag_out_t
     }      // if lookup_value != NULL
     else { // look for containers
         cont_lookup_value = hash_table_lookup(container_hash_table_g, &hash_key);
-        if (cont_lookup_value != NULL) {
-            PDC_add_kvtag_to_list(&cont_lookup_value->kvtag_list_head, &in->kvtag);
+        if (cont_lookup_value != NULL &&
+            PDC_Server_wal_log_kvtag_add(hash_key, in->obj_id, &in->kvtag) != SUCCEED) {
+            ret_value = FAIL;
+            out->ret  = -1;
+        }
+        else if (cont_lookup_value != NULL) {
+            PDC_add_kvtag_to_list(&cont_lookup_value->kvtag_list_head, &in->kvtag, &old_tag);
+            if (old_tag != NULL)
+                PDC_free_kvtag(&old_tag);
             out->ret = 1;
         }
         else {
@@ -3260,6 +3595,11 @@ PDC_Server_del_kvtag_rocksdb(metadata_get_kvtag_in_t *in, metadata_add_tag_out_t
     rocksdb_writeoptions_t *writeoptions             = rocksdb_writeoptions_create();
 
     sprintf(rocksdb_key, "%lu`%s", in->obj_id, in->key);
+    if (PDC_Server_rocksdb_del_range_keys(writeoptions, rocksdb_key, in->key, in->obj_id) != SUCCEED) {
+        ret_value = FAIL;
+        goto done;
+    }
+
     rocksdb_delete(rocksdb_g, writeoptions, rocksdb_key, strlen(rocksdb_key) + 1, &err);
     if (err != NULL) {
         printf("==PDC_SERVER[%d]: error with rocksdb_delete [%s], [%s]!\n", pdc_server_rank_g, in->key, err);
@@ -3267,6 +3607,9 @@ PDC_Server_del_kvtag_rocksdb(metadata_get_kvtag_in_t *in, metadata_add_tag_out_t
     }
     else
         out->ret = 1;
+
+done:
+    rocksdb_writeoptions_destroy(writeoptions);
 #else
     printf("==PDC_SERVER[%d]: enabled rocksdb but PDC is not compiled with it!\n", pdc_server_rank_g);
     ret_value = FAIL;
@@ -3317,7 +3660,20 @@ PDC_Server_del_kvtag_someta(metadata_get_kvtag_in_t *in, metadata_add_tag_out_t
     if (lookup_value != NULL) {
         pdc_metadata_t *target;
         target = find_metadata_by_id_from_list(lookup_value->metadata, obj_id);
-        if (target != NULL) {
+        // The tag is only deleted once the deletion is logged
+        if (target != NULL && PDC_Server_wal_log_kvtag_del(hash_key, obj_id, in->key) != SUCCEED) {
+            ret_value = FAIL;
+            out->ret  = -1;
+        }
+        else if (target != NULL) {
+            pdc_kvtag_list_t *kvtag_elt;
+            DL_FOREACH(target->kvtag_list_head, kvtag_elt)
+            {
+                if (strcmp(kvtag_elt->kvtag->name, in->key) == 0) {
+                    PDC_Server_kvtag_index_remove(obj_id, kvtag_elt->kvtag);
+                    break;
+                }
+            }
             ret_value = PDC_del_kvtag_value_from_list(&target->kvtag_list_head, in->key);
             out->ret  = 1;
         }
@@ -3330,7 +3686,12 @@ PDC_Server_del_kvtag_someta(metadata_get_kvtag_in_t *in, metadata_add_tag_out_t
     }
     else {
         cont_lookup_value = hash_table_lookup(container_hash_table_g, &hash_key);
-        if (cont_lookup_value != NULL) {
+        if (cont_lookup_value != NULL &&
+            PDC_Server_wal_log_kvtag_del(hash_key, obj_id, in->key) != SUCCEED) {
+            ret_value = FAIL;
+            out->ret  = -1;
+        }
+        else if (cont_lookup_value != NULL) {
             PDC_del_kvtag_value_from_list(&cont_lookup_value->kvtag_list_head, in->key);
             out->ret = 1;
         }
@@ -1,4 +1,7 @@
+#include <inttypes.h>
+#include <pthread.h>
 #include "pdc_server_metadata_index.h"
+#include "pdc_server_metadata_wal.h"
 
 #define DART_SERVER_DEBUG 0
 
@@ -10,6 +13,9 @@ double    unit_time_to_update_request = 5000.0; // ms.
 art_tree *art_key_prefix_tree_g       = NULL;
 art_tree *art_key_suffix_tree_g       = NULL;
 
+// Serializes the changes and searches of the index, a batch holds it once for all its entries
+static pthread_mutex_t dart_index_mutex_g = PTHREAD_MUTEX_INITIALIZER;
+
 // void
 // create_hash_table_for_keyword(char *keyword, char *value, size_t len, void *data)
 // {
@@ -712,11 +718,17 @@ PDC_Server_dart_perform_one_server(dart_perform_one_server_in_t *in, dart_perfor
     }
     out->has_bulk = 0;
     // printf("Respond to: in->op_type=%d\n", in->op_type );
+    pthread_mutex_lock(&dart_index_mutex_g);
+    // The index is only changed once the change is logged
     if (op_type == OP_INSERT) {
-        metadata_index_create(attr_key, attr_val, obj_locator, hash_algo);
+        result = PDC_Server_wal_log_dart(PDC_WAL_DART_INSERT, attr_key, attr_val, obj_locator);
+        if (result == SUCCEED)
+            metadata_index_create(attr_key, attr_val, obj_locator, hash_algo);
     }
     else if (op_type == OP_DELETE) {
-        metadata_index_delete(attr_key, attr_val, obj_locator, hash_algo);
+        result = PDC_Server_wal_log_dart(PDC_WAL_DART_DELETE, attr_key, attr_val, obj_locator);
+        if (result == SUCCEED)
+            metadata_index_delete(attr_key, attr_val, obj_locator, hash_algo);
     }
     else {
         char *query  = (char *)in->attr_key;
@@ -726,5 +738,329 @@ PDC_Server_dart_perform_one_server(dart_perform_one_server_in_t *in, dart_perfor
             out->has_bulk = 1;
         }
     }
+    pthread_mutex_unlock(&dart_index_mutex_g);
     return result;
-}
\ No newline at end of file
+}
+
+/****************************/
+/* Batched insert and delete */
+/****************************/
+
+// Read a null terminated string of a batch entry, NULL if the buffer ends before it
+static char *
+dart_batch_read_str(const char *buf, uint64_t size, uint64_t *pos)
+{
+    uint32_t len;
+    char *   str;
+
+    if (size - *pos < sizeof(uint32_t))
+        return NULL;
+    memcpy(&len, buf + *pos, sizeof(uint32_t));
+    *pos += sizeof(uint32_t);
+    if (len == 0 || size - *pos < len)
+        return NULL;
+    str = (char *)buf + *pos;
+    if (str[len - 1] != '\0')
+        return NULL;
+    *pos += len;
+
+    return str;
+}
+
+perr_t
+PDC_Server_dart_perform_batch(dart_op_type_t op_type, dart_hash_algo_t hash_algo, const char *buf,
+                              uint64_t size, uint64_t n_entry, uint64_t *n_done)
+{
+    perr_t   ret_value = SUCCEED;
+    uint64_t pos = 0, i, obj_locator;
+    char *   attr_key, *attr_val;
+
+    FUNC_ENTER(NULL);
+
+    *n_done = 0;
+    if (op_type != OP_INSERT && op_type != OP_DELETE)
+        PGOTO_DONE(FAIL);
+
+    pthread_mutex_lock(&dart_index_mutex_g);
+    for (i = 0; i < n_entry; i++) {
+        if (size - pos < sizeof(uint64_t)) {
+            ret_value = FAIL;
+            break;
+        }
+        memcpy(&obj_locator, buf + pos, sizeof(uint64_t));
+        pos += sizeof(uint64_t);
+        attr_key = dart_batch_read_str(buf, size, &pos);
+        attr_val = attr_key == NULL ? NULL : dart_batch_read_str(buf, size, &pos);
+        if (attr_val == NULL) {
+            ret_value = FAIL;
+            break;
+        }
+
+        // The index is only changed once the change is logged
+        if (PDC_Server_wal_log_dart(op_type == OP_INSERT ? PDC_WAL_DART_INSERT : PDC_WAL_DART_DELETE,
+                                    attr_key, attr_val, obj_locator) != SUCCEED) {
+            ret_value = FAIL;
+            break;
+        }
+        if (op_type == OP_INSERT)
+            metadata_index_create(attr_key, attr_val, obj_locator, hash_algo);
+        else
+            metadata_index_delete(attr_key, attr_val, obj_locator, hash_algo);
+        (*n_done)++;
+    }
+    pthread_mutex_unlock(&dart_index_mutex_g);
+
+done:
+    if (ret_value != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - DART batch failed after %" PRIu64 " of %" PRIu64 " entries\n",
+               pdc_server_rank_g, __func__, *n_done, n_entry);
+    FUNC_LEAVE(ret_value);
+}
+
+hg_return_t
+PDC_Server_dart_recv_batch(const struct hg_cb_info *callback_info)
+{
+    hg_return_t         ret               = HG_SUCCESS;
+    hg_bulk_t           local_bulk_handle = callback_info->info.bulk.local_handle;
+    struct bulk_args_t *bulk_args         = (struct bulk_args_t *)callback_info->arg;
+    dart_op_type_t      op_type;
+    pdc_int_ret_t       out;
+    uint64_t            n_done;
+    void *              buf;
+
+    out.ret = 1;
+
+    if (callback_info->ret != HG_SUCCESS) {
+        ret     = HG_PROTOCOL_ERROR;
+        out.ret = -1;
+        goto done;
+    }
+
+    op_type = bulk_args->op == PDC_BULK_DART_INSERT ? OP_INSERT : OP_DELETE;
+
+    ret = HG_Bulk_access(local_bulk_handle, 0, bulk_args->nbytes, HG_BULK_READWRITE, 1, &buf, NULL, NULL);
+    if (ret != HG_SUCCESS ||
+        PDC_Server_dart_perform_batch(op_type, (dart_hash_algo_t)bulk_args->data_type, (const char *)buf,
+                                      bulk_args->nbytes, bulk_args->cnt, &n_done) != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - DART batch from client %d failed!\n", pdc_server_rank_g, __func__,
+               bulk_args->origin);
+        out.ret = -1;
+    }
+
+done:
+    fflush(stdout);
+    HG_Bulk_free(local_bulk_handle);
+
+    ret = HG_Respond(bulk_args->handle, NULL, NULL, &out);
+    if (ret != HG_SUCCESS)
+        fprintf(stderr, "Could not respond\n");
+
+    ret = HG_Destroy(bulk_args->handle);
+    if (ret != HG_SUCCESS)
+        fprintf(stderr, "Could not destroy handle\n");
+
+    free(bulk_args);
+
+    return ret;
+}
+
+/****************************/
+/* Checkpoint DART */
+/****************************/
+
+typedef struct dart_checkpoint_buf_t {
+    char *   data;
+    uint64_t size;
+    uint64_t alloc;
+    uint64_t n_key;
+    uint32_t n_value;
+    int      failed;
+} dart_checkpoint_buf_t;
+
+static void
+dart_checkpoint_add(dart_checkpoint_buf_t *buf, const void *p, uint64_t size)
+{
+    char *data;
+
+    if (buf->failed)
+        return;
+    if (buf->size + size > buf->alloc) {
+        buf->alloc = buf->alloc == 0 ? 65536 : buf->alloc;
+        while (buf->size + size > buf->alloc)
+            buf->alloc *= 2;
+        data = (char *)realloc(buf->data, buf->alloc);
+        if (data == NULL) {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = data;
+    }
+    memcpy(buf->data + buf->size, p, size);
+    buf->size += size;
+}
+
+static int
+dart_checkpoint_value_cb(void *data, const unsigned char *key, uint32_t key_len, void *value)
+{
+    dart_checkpoint_buf_t *buf        = (dart_checkpoint_buf_t *)data;
+    Set *                  obj_id_set = (Set *)value;
+    SetIterator            iter;
+    uint32_t               n_obj;
+
+    if (obj_id_set == NULL || set_num_entries(obj_id_set) == 0)
+        return 0;
+
+    n_obj = set_num_entries(obj_id_set);
+    dart_checkpoint_add(buf, &key_len, sizeof(uint32_t));
+    dart_checkpoint_add(buf, key, key_len);
+    dart_checkpoint_add(buf, &n_obj, sizeof(uint32_t));
+    set_iterate(obj_id_set, &iter);
+    while (set_iter_has_more(&iter))
+        dart_checkpoint_add(buf, set_iter_next(&iter), sizeof(uint64_t));
+    buf->n_value++;
+
+    return buf->failed;
+}
+
+static int
+dart_checkpoint_key_cb(void *data, const unsigned char *key, uint32_t key_len, void *value)
+{
+    dart_checkpoint_buf_t * buf     = (dart_checkpoint_buf_t *)data;
+    key_index_leaf_content *leafcnt = (key_index_leaf_content *)value;
+    uint64_t                n_value_pos;
+
+    if (leafcnt == NULL || leafcnt->extra_prefix_index == NULL)
+        return 0;
+
+    dart_checkpoint_add(buf, &key_len, sizeof(uint32_t));
+    dart_checkpoint_add(buf, key, key_len);
+    // Filled once the values are counted
+    n_value_pos  = buf->size;
+    buf->n_value = 0;
+    dart_checkpoint_add(buf, &buf->n_value, sizeof(uint32_t));
+    art_iter((art_tree *)leafcnt->extra_prefix_index, dart_checkpoint_value_cb, buf);
+    if (!buf->failed)
+        memcpy(buf->data + n_value_pos, &buf->n_value, sizeof(uint32_t));
+    buf->n_key++;
+
+    return buf->failed;
+}
+
+int
+PDC_Server_dart_trylock()
+{
+    return pthread_mutex_trylock(&dart_index_mutex_g);
+}
+
+void
+PDC_Server_dart_unlock()
+{
+    pthread_mutex_unlock(&dart_index_mutex_g);
+}
+
+perr_t
+PDC_Server_dart_serialize(char **buf, uint64_t *size)
+{
+    perr_t                ret_value = SUCCEED;
+    dart_checkpoint_buf_t ckpt;
+
+    FUNC_ENTER(NULL);
+
+    memset(&ckpt, 0, sizeof(ckpt));
+    // Filled once the keys are counted
+    dart_checkpoint_add(&ckpt, &ckpt.n_key, sizeof(uint64_t));
+    if (art_key_prefix_tree_g != NULL)
+        art_iter(art_key_prefix_tree_g, dart_checkpoint_key_cb, &ckpt);
+
+    if (ckpt.failed) {
+        printf("==PDC_SERVER[%d]: %s - cannot allocate the DART checkpoint\n", pdc_server_rank_g, __func__);
+        free(ckpt.data);
+        *buf      = NULL;
+        *size     = 0;
+        ret_value = FAIL;
+        goto done;
+    }
+    memcpy(ckpt.data, &ckpt.n_key, sizeof(uint64_t));
+    *buf  = ckpt.data;
+    *size = ckpt.size;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Read a length-prefixed string of the serialized index into a null-terminated copy
+ */
+static char *
+dart_checkpoint_read_str(const char *buf, uint64_t size, uint64_t *pos)
+{
+    uint32_t len;
+    char *   str;
+
+    if (size - *pos < sizeof(uint32_t))
+        return NULL;
+    memcpy(&len, buf + *pos, sizeof(uint32_t));
+    *pos += sizeof(uint32_t);
+    if (size - *pos < len)
+        return NULL;
+    str = (char *)malloc(len + 1);
+    memcpy(str, buf + *pos, len);
+    str[len] = '\0';
+    *pos += len;
+
+    return str;
+}
+
+perr_t
+PDC_Server_dart_deserialize(const char *buf, uint64_t size, uint64_t *n_entry)
+{
+    perr_t   ret_value = SUCCEED;
+    uint64_t pos = 0, n_key, k, obj_id;
+    uint32_t n_value, n_obj, v, i;
+    char *   attr_key = NULL, *attr_val = NULL;
+
+    FUNC_ENTER(NULL);
+
+    *n_entry = 0;
+    if (size < sizeof(uint64_t))
+        PGOTO_DONE(FAIL);
+    memcpy(&n_key, buf, sizeof(uint64_t));
+    pos = sizeof(uint64_t);
+
+    for (k = 0; k < n_key; k++) {
+        attr_key = dart_checkpoint_read_str(buf, size, &pos);
+        if (attr_key == NULL || size - pos < sizeof(uint32_t))
+            PGOTO_DONE(FAIL);
+        memcpy(&n_value, buf + pos, sizeof(uint32_t));
+        pos += sizeof(uint32_t);
+
+        for (v = 0; v < n_value; v++) {
+            attr_val = dart_checkpoint_read_str(buf, size, &pos);
+            if (attr_val == NULL || size - pos < sizeof(uint32_t))
+                PGOTO_DONE(FAIL);
+            memcpy(&n_obj, buf + pos, sizeof(uint32_t));
+            pos += sizeof(uint32_t);
+            if ((size - pos) / sizeof(uint64_t) < n_obj)
+                PGOTO_DONE(FAIL);
+
+            for (i = 0; i < n_obj; i++) {
+                memcpy(&obj_id, buf + pos, sizeof(uint64_t));
+                pos += sizeof(uint64_t);
+                metadata_index_create(attr_key, attr_val, obj_id, DART_HASH);
+                (*n_entry)++;
+            }
+            free(attr_val);
+            attr_val = NULL;
+        }
+        free(attr_key);
+        attr_key = NULL;
+    }
+
+done:
+    if (ret_value != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - DART checkpoint is truncated after %" PRIu64 " entries\n",
+               pdc_server_rank_g, __func__, *n_entry);
+    free(attr_key);
+    free(attr_val);
+    FUNC_LEAVE(ret_value);
+}
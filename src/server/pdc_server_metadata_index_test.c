@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include "pdc_server_metadata_index.h"
 
 void
@@ -40,6 +41,20 @@ query_result_from_kvtag(char *key_value_query, int8_t op_type)
     printf("\n\n");
 }
 
+uint64_t
+count_result_from_kvtag(char *key_value_query, int8_t op_type)
+{
+    dart_perform_one_server_in_t  input;
+    dart_perform_one_server_out_t output;
+    uint64_t                      n_obj_ids = 0;
+    uint64_t *                    buf_ptr   = NULL;
+    input.op_type                           = op_type;
+    input.attr_key                          = key_value_query;
+    assert(PDC_Server_dart_perform_one_server(&input, &output, &n_obj_ids, &buf_ptr) == SUCCEED);
+    free(buf_ptr);
+    return n_obj_ids;
+}
+
 void
 test_PDC_Server_dart_perform_one_server()
 {
@@ -66,9 +81,80 @@ test_PDC_Server_dart_perform_one_server()
     query_result_from_kvtag("*9*=*9*", OP_INFIX_QUERY);
 }
 
+void
+test_PDC_Server_dart_serialize()
+{
+    char *   buf = NULL;
+    uint64_t size, n_entry;
+    uint64_t n_exact  = count_result_from_kvtag("key000key=val000val", OP_EXACT_QUERY);
+    uint64_t n_prefix = count_result_from_kvtag("key01*=val01*", OP_PREFIX_QUERY);
+    uint64_t n_suffix = count_result_from_kvtag("*3key=*3val", OP_SUFFIX_QUERY);
+    uint64_t n_infix  = count_result_from_kvtag("*9*=*9*", OP_INFIX_QUERY);
+
+    assert(PDC_Server_dart_serialize(&buf, &size) == SUCCEED);
+
+    // Restart with an empty index
+    PDC_Server_dart_init();
+    assert(count_result_from_kvtag("key000key=val000val", OP_EXACT_QUERY) == 0);
+
+    assert(PDC_Server_dart_deserialize(buf, size, &n_entry) == SUCCEED);
+    assert(n_entry > 0);
+    assert(count_result_from_kvtag("key000key=val000val", OP_EXACT_QUERY) == n_exact);
+    assert(count_result_from_kvtag("key01*=val01*", OP_PREFIX_QUERY) == n_prefix);
+    assert(count_result_from_kvtag("*3key=*3val", OP_SUFFIX_QUERY) == n_suffix);
+    assert(count_result_from_kvtag("*9*=*9*", OP_INFIX_QUERY) == n_infix);
+    printf("Index restored from %" PRIu64 " bytes, %" PRIu64 " entries\n", size, n_entry);
+
+    // A truncated index is reported
+    PDC_Server_dart_init();
+    assert(PDC_Server_dart_deserialize(buf, size - 1, &n_entry) == FAIL);
+    free(buf);
+}
+
+void
+test_PDC_Server_dart_perform_batch()
+{
+    char     buf[64 * 100], key[32], val[32];
+    uint64_t size = 0, n_done, obj_id;
+    uint32_t len;
+    int      i;
+
+    // Entries in the format sent by PDC_Client_insert_obj_ref_into_dart_batch
+    for (i = 0; i < 100; i++) {
+        obj_id = 500000 + i;
+        sprintf(key, "batchkey%03d", i % 10);
+        sprintf(val, "batchval%03d", i % 10);
+        memcpy(buf + size, &obj_id, sizeof(uint64_t));
+        size += sizeof(uint64_t);
+        len = strlen(key) + 1;
+        memcpy(buf + size, &len, sizeof(uint32_t));
+        memcpy(buf + size + sizeof(uint32_t), key, len);
+        size += sizeof(uint32_t) + len;
+        len = strlen(val) + 1;
+        memcpy(buf + size, &len, sizeof(uint32_t));
+        memcpy(buf + size + sizeof(uint32_t), val, len);
+        size += sizeof(uint32_t) + len;
+    }
+
+    assert(PDC_Server_dart_perform_batch(OP_INSERT, DART_HASH, buf, size, 100, &n_done) == SUCCEED);
+    assert(n_done == 100);
+    assert(count_result_from_kvtag("batchkey003=batchval003", OP_EXACT_QUERY) == 10);
+    assert(count_result_from_kvtag("batchkey*=batchval*", OP_PREFIX_QUERY) == 100);
+
+    // A truncated batch applies the entries before the cut
+    assert(PDC_Server_dart_perform_batch(OP_DELETE, DART_HASH, buf, size - 1, 100, &n_done) == FAIL);
+    assert(n_done == 99);
+    assert(count_result_from_kvtag("batchkey*=batchval*", OP_PREFIX_QUERY) == 1);
+
+    assert(PDC_Server_dart_perform_batch(OP_DELETE, DART_HASH, buf, size, 100, &n_done) == SUCCEED);
+    assert(count_result_from_kvtag("batchkey*=batchval*", OP_PREFIX_QUERY) == 0);
+}
+
 int
 main()
 {
     test_PDC_Server_dart_perform_one_server();
+    test_PDC_Server_dart_serialize();
+    test_PDC_Server_dart_perform_batch();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,788 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include "pdc_utlist.h"
+#include "pdc_server_metadata_wal.h"
+#include "pdc_server_data.h"
+#include "pdc_server_region_transfer_metadata_query.h"
+#include "pdc_server_metadata_index.h"
+
+#define PDC_WAL_MAX_IOV 6
+
+static int             wal_fd_g    = -1;
+static char            wal_path_g[ADDR_MAX];
+static uint64_t        wal_lsn_g   = 0;
+static uint64_t        wal_size_g  = 0;
+static int             wal_fsync_g = PDC_WAL_FSYNC;
+static pthread_mutex_t wal_mutex_g = PTHREAD_MUTEX_INITIALIZER;
+
+extern data_server_region_t *dataserver_region_g;
+
+/*
+ * FNV-1a hash of the header fields and the payload of a record
+ */
+static uint64_t
+pdc_wal_checksum(const pdc_wal_record_header_t *header, const struct iovec *iov, int n_iov)
+{
+    uint64_t             h = 14695981039346656037ULL;
+    const unsigned char *p;
+    size_t               i;
+    int                  k;
+
+    p = (const unsigned char *)header;
+    for (i = 0; i < offsetof(pdc_wal_record_header_t, checksum); i++)
+        h = (h ^ p[i]) * 1099511628211ULL;
+    for (k = 0; k < n_iov; k++) {
+        p = (const unsigned char *)iov[k].iov_base;
+        for (i = 0; i < iov[k].iov_len; i++)
+            h = (h ^ p[i]) * 1099511628211ULL;
+    }
+
+    return h;
+}
+
+/*
+ * Append a record made of the payload pieces in iov[1..n_iov-1], iov[0] is filled with the header
+ */
+static perr_t
+pdc_wal_append(pdc_wal_record_type_t type, struct iovec *iov, int n_iov)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_wal_record_header_t header;
+    size_t                  total;
+    ssize_t                 written;
+    int                     k;
+
+    header.type = (uint32_t)type;
+    header.size = 0;
+    for (k = 1; k < n_iov; k++)
+        header.size += (uint32_t)iov[k].iov_len;
+    total           = sizeof(header) + header.size;
+    iov[0].iov_base = &header;
+    iov[0].iov_len  = sizeof(header);
+
+    pthread_mutex_lock(&wal_mutex_g);
+    if (wal_fd_g < 0)
+        goto done;
+
+    header.lsn      = wal_lsn_g + 1;
+    header.checksum = pdc_wal_checksum(&header, iov + 1, n_iov - 1);
+
+    written = writev(wal_fd_g, iov, n_iov);
+    if (written != (ssize_t)total) {
+        printf("==PDC_SERVER[%d]: %s - write to metadata log failed, %s\n", pdc_server_rank_g, __func__,
+               strerror(errno));
+        // Do not leave a partial record in front of the next one
+        if (written > 0 && ftruncate(wal_fd_g, (off_t)wal_size_g) != 0)
+            printf("==PDC_SERVER[%d]: %s - cannot drop partial record\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    if (wal_fsync_g == 1)
+        fdatasync(wal_fd_g);
+
+    wal_lsn_g = header.lsn;
+    wal_size_g += total;
+
+done:
+    pthread_mutex_unlock(&wal_mutex_g);
+    return ret_value;
+}
+
+perr_t
+PDC_Server_wal_open(const char *path, uint64_t lsn)
+{
+    perr_t ret_value = SUCCEED;
+    char * p;
+
+    FUNC_ENTER(NULL);
+
+    p = getenv("PDC_WAL_FSYNC");
+    if (p != NULL)
+        wal_fsync_g = atoi(p) != 0 ? 1 : 0;
+
+    pthread_mutex_lock(&wal_mutex_g);
+    if (wal_fd_g >= 0)
+        close(wal_fd_g);
+
+    snprintf(wal_path_g, ADDR_MAX, "%s", path);
+    wal_fd_g = open(wal_path_g, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (wal_fd_g < 0) {
+        printf("==PDC_SERVER[%d]: %s - cannot open metadata log [%s], %s\n", pdc_server_rank_g, __func__,
+               wal_path_g, strerror(errno));
+        ret_value = FAIL;
+        goto done;
+    }
+    wal_size_g = (uint64_t)lseek(wal_fd_g, 0, SEEK_END);
+    wal_lsn_g  = lsn;
+
+done:
+    pthread_mutex_unlock(&wal_mutex_g);
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDC_Server_wal_close()
+{
+    pthread_mutex_lock(&wal_mutex_g);
+    if (wal_fd_g >= 0) {
+        fsync(wal_fd_g);
+        close(wal_fd_g);
+    }
+    wal_fd_g = -1;
+    pthread_mutex_unlock(&wal_mutex_g);
+}
+
+int
+PDC_Server_wal_is_open()
+{
+    return wal_fd_g >= 0 ? 1 : 0;
+}
+
+uint64_t
+PDC_Server_wal_size()
+{
+    return wal_size_g;
+}
+
+uint64_t
+PDC_Server_wal_lsn()
+{
+    uint64_t lsn;
+
+    pthread_mutex_lock(&wal_mutex_g);
+    lsn = wal_lsn_g;
+    pthread_mutex_unlock(&wal_mutex_g);
+
+    return lsn;
+}
+
+/*
+ * Copy the records of the open log to the end of an existing file
+ */
+static perr_t
+pdc_wal_copy_to(const char *sealed_path)
+{
+    perr_t  ret_value = SUCCEED;
+    char    buf[65536];
+    int     in_fd = -1, out_fd = -1;
+    ssize_t n;
+
+    in_fd  = open(wal_path_g, O_RDONLY);
+    out_fd = open(sealed_path, O_WRONLY | O_APPEND);
+    if (in_fd < 0 || out_fd < 0) {
+        ret_value = FAIL;
+        goto done;
+    }
+    while ((n = read(in_fd, buf, sizeof(buf))) > 0) {
+        if (write(out_fd, buf, n) != n) {
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+    if (n < 0 || fsync(out_fd) != 0)
+        ret_value = FAIL;
+
+done:
+    if (in_fd >= 0)
+        close(in_fd);
+    if (out_fd >= 0)
+        close(out_fd);
+    return ret_value;
+}
+
+perr_t
+PDC_Server_wal_seal(const char *sealed_path, uint64_t *lsn)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    pthread_mutex_lock(&wal_mutex_g);
+    if (wal_fd_g < 0) {
+        ret_value = FAIL;
+        goto done;
+    }
+    *lsn = wal_lsn_g;
+
+    fsync(wal_fd_g);
+    if (access(sealed_path, F_OK) != 0) {
+        if (rename(wal_path_g, sealed_path) != 0) {
+            printf("==PDC_SERVER[%d]: %s - cannot seal metadata log, %s\n", pdc_server_rank_g, __func__,
+                   strerror(errno));
+            ret_value = FAIL;
+            goto done;
+        }
+        close(wal_fd_g);
+        wal_fd_g = open(wal_path_g, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0666);
+        if (wal_fd_g < 0) {
+            printf("==PDC_SERVER[%d]: %s - cannot reopen metadata log, %s\n", pdc_server_rank_g, __func__,
+                   strerror(errno));
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+    else {
+        // The previous snapshot failed, its records have to go into the next one
+        if (pdc_wal_copy_to(sealed_path) != SUCCEED || ftruncate(wal_fd_g, 0) != 0) {
+            printf("==PDC_SERVER[%d]: %s - cannot append metadata log to %s\n", pdc_server_rank_g, __func__,
+                   sealed_path);
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+    wal_size_g = 0;
+
+done:
+    pthread_mutex_unlock(&wal_mutex_g);
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Raise the object ID generator above an ID restored from the log, so new objects do not reuse it
+ */
+static void
+pdc_wal_bump_id(uint64_t obj_id)
+{
+    if (obj_id >= pdc_id_seq_g)
+        pdc_id_seq_g = obj_id + 1;
+}
+
+static perr_t
+pdc_wal_replay_cont_create(char *buf, uint32_t size)
+{
+    pdc_cont_hash_table_entry_t *entry;
+    uint32_t                     hash_key, *key;
+    uint64_t                     cont_id;
+
+    if (size < sizeof(uint32_t) + sizeof(uint64_t) + 1)
+        return FAIL;
+    memcpy(&hash_key, buf, sizeof(uint32_t));
+    memcpy(&cont_id, buf + sizeof(uint32_t), sizeof(uint64_t));
+    pdc_wal_bump_id(cont_id);
+
+    if (hash_table_lookup(container_hash_table_g, &hash_key) != NULL)
+        return SUCCEED;
+
+    key    = (uint32_t *)malloc(sizeof(uint32_t));
+    *key   = hash_key;
+    entry  = (pdc_cont_hash_table_entry_t *)calloc(1, sizeof(pdc_cont_hash_table_entry_t));
+    snprintf(entry->cont_name, ADDR_MAX, "%s", buf + sizeof(uint32_t) + sizeof(uint64_t));
+    entry->cont_id = cont_id;
+    total_mem_usage_g += sizeof(uint32_t) + sizeof(pdc_cont_hash_table_entry_t);
+
+    if (hash_table_insert(container_hash_table_g, key, entry) != 1)
+        return FAIL;
+
+    return SUCCEED;
+}
+
+static perr_t
+pdc_wal_replay_obj_put(char *buf, uint32_t size)
+{
+    pdc_hash_table_entry_head *head;
+    pdc_metadata_t *           meta, *target;
+    uint32_t                   hash_key, *key;
+
+    if (size != sizeof(uint32_t) + sizeof(pdc_metadata_t))
+        return FAIL;
+    memcpy(&hash_key, buf, sizeof(uint32_t));
+    meta = (pdc_metadata_t *)PDC_malloc(sizeof(pdc_metadata_t));
+    memcpy(meta, buf + sizeof(uint32_t), sizeof(pdc_metadata_t));
+    pdc_wal_bump_id(meta->obj_id);
+
+    target = find_metadata_by_id(meta->obj_id);
+    if (target != NULL) {
+        // Update of an existing object, the name and the lists stay
+        target->user_id            = meta->user_id;
+        target->time_step          = meta->time_step;
+        target->data_type          = meta->data_type;
+        target->cont_id            = meta->cont_id;
+        target->create_time        = meta->create_time;
+        target->last_modified_time = meta->last_modified_time;
+        target->data_server_id     = meta->data_server_id;
+        target->region_partition   = meta->region_partition;
+        target->consistency        = meta->consistency;
+        target->ndim               = meta->ndim;
+        target->transform_state    = meta->transform_state;
+        target->current_state      = meta->current_state;
+        memcpy(target->app_name, meta->app_name, OBJ_NAME_MAX);
+        memcpy(target->tags, meta->tags, TAG_LEN_MAX);
+        memcpy(target->data_location, meta->data_location, ADDR_MAX);
+        memcpy(target->dims, meta->dims, sizeof(uint64_t) * DIM_MAX);
+        free(meta);
+        return SUCCEED;
+    }
+
+    meta->kvtag_list_head                = NULL;
+    meta->storage_region_list_head       = NULL;
+    meta->all_storage_region_distributed = 0;
+    meta->region_lock_head               = NULL;
+    meta->region_map_head                = NULL;
+    meta->region_buf_map_head            = NULL;
+    meta->obj_hist                       = NULL;
+    meta->prev                           = NULL;
+    meta->next                           = NULL;
+    meta->bloom                          = NULL;
+    total_mem_usage_g += sizeof(pdc_metadata_t);
+
+    head = hash_table_lookup(metadata_hash_table_g, &hash_key);
+    if (head == NULL) {
+        head           = (pdc_hash_table_entry_head *)PDC_malloc(sizeof(pdc_hash_table_entry_head));
+        head->metadata = NULL;
+        head->n_obj    = 0;
+        key            = (uint32_t *)PDC_malloc(sizeof(uint32_t));
+        *key           = hash_key;
+        total_mem_usage_g += sizeof(pdc_hash_table_entry_head) + sizeof(uint32_t);
+        if (PDC_Server_hash_table_list_init(head, key) != SUCCEED)
+            return FAIL;
+    }
+    if (PDC_Server_hash_table_list_insert(head, meta) != SUCCEED)
+        return FAIL;
+    n_metadata_g++;
+
+    return SUCCEED;
+}
+
+static perr_t
+pdc_wal_replay_obj_delete(char *buf, uint32_t size)
+{
+    metadata_delete_by_id_in_t  in;
+    metadata_delete_by_id_out_t out;
+
+    if (size != sizeof(uint64_t))
+        return FAIL;
+    memcpy(&in.obj_id, buf, sizeof(uint64_t));
+
+    // A delete of an object that is not there was already applied by the snapshot
+    PDC_Server_delete_metadata_by_id(&in, &out);
+
+    return SUCCEED;
+}
+
+static perr_t
+pdc_wal_replay_kvtag_add(char *buf, uint32_t size)
+{
+    metadata_add_kvtag_in_t in;
+    metadata_add_tag_out_t  out;
+    size_t                  pos, name_len;
+
+    pos = sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int8_t) + sizeof(uint32_t);
+    if (size <= pos)
+        return FAIL;
+    memcpy(&in.hash_value, buf, sizeof(uint32_t));
+    memcpy(&in.obj_id, buf + sizeof(uint32_t), sizeof(uint64_t));
+    memcpy(&in.kvtag.type, buf + sizeof(uint32_t) + sizeof(uint64_t), sizeof(int8_t));
+    memcpy(&in.kvtag.size, buf + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int8_t), sizeof(uint32_t));
+    in.kvtag.name = buf + pos;
+    name_len      = strnlen(in.kvtag.name, size - pos);
+    if (pos + name_len + 1 + in.kvtag.size != size)
+        return FAIL;
+    in.kvtag.value = buf + pos + name_len + 1;
+
+    PDC_Server_add_kvtag(&in, &out);
+
+    return SUCCEED;
+}
+
+static perr_t
+pdc_wal_replay_kvtag_del(char *buf, uint32_t size)
+{
+    metadata_get_kvtag_in_t in;
+    metadata_add_tag_out_t  out;
+    size_t                  pos;
+
+    pos = sizeof(uint32_t) + sizeof(uint64_t);
+    if (size <= pos || buf[size - 1] != 0)
+        return FAIL;
+    memcpy(&in.hash_value, buf, sizeof(uint32_t));
+    memcpy(&in.obj_id, buf + sizeof(uint32_t), sizeof(uint64_t));
+    in.key = buf + pos;
+
+    PDC_Server_del_kvtag(&in, &out);
+
+    return SUCCEED;
+}
+
+static void
+pdc_wal_region_to_list(pdc_wal_region_t *from, uint64_t obj_id, region_list_t *to)
+{
+    PDC_init_region_list(to);
+    to->ndim = from->ndim;
+    memcpy(to->start, from->start, sizeof(uint64_t) * DIM_MAX);
+    memcpy(to->count, from->count, sizeof(uint64_t) * DIM_MAX);
+    to->unit_size = from->unit_size;
+    to->data_size = from->data_size;
+    to->offset    = from->offset;
+    to->obj_id    = obj_id;
+    memcpy(to->storage_location, from->storage_location, ADDR_MAX);
+    to->storage_location[ADDR_MAX - 1] = 0;
+}
+
+static perr_t
+pdc_wal_replay_meta_region(char *buf, uint32_t size)
+{
+    pdc_wal_region_t wal_region;
+    region_list_t    region;
+    uint64_t         obj_id;
+
+    if (size != sizeof(uint64_t) + sizeof(pdc_wal_region_t))
+        return FAIL;
+    memcpy(&obj_id, buf, sizeof(uint64_t));
+    memcpy(&wal_region, buf + sizeof(uint64_t), sizeof(pdc_wal_region_t));
+    pdc_wal_region_to_list(&wal_region, obj_id, &region);
+
+    // Updates the region with the same shape or adds it
+    return PDC_Server_update_local_region_storage_loc(&region, obj_id, PDC_UPDATE_STORAGE);
+}
+
+static perr_t
+pdc_wal_replay_data_region(char *buf, uint32_t size)
+{
+    pdc_wal_region_t      wal_region;
+    data_server_region_t *obj_reg;
+    region_list_t *       region, *elt;
+    uint64_t              obj_id;
+
+    if (size != sizeof(uint64_t) + sizeof(pdc_wal_region_t))
+        return FAIL;
+    memcpy(&obj_id, buf, sizeof(uint64_t));
+    memcpy(&wal_region, buf + sizeof(uint64_t), sizeof(pdc_wal_region_t));
+
+    obj_reg = PDC_Server_get_obj_region(obj_id);
+    if (obj_reg == NULL) {
+        // The data file is opened on the first access, as after a restart from a checkpoint
+        obj_reg                   = (data_server_region_t *)calloc(1, sizeof(data_server_region_t));
+        obj_reg->obj_id           = obj_id;
+        obj_reg->fd               = -1;
+        obj_reg->storage_location = (char *)malloc(sizeof(char) * ADDR_MAX);
+        memcpy(obj_reg->storage_location, wal_region.storage_location, ADDR_MAX);
+        DL_APPEND(dataserver_region_g, obj_reg);
+    }
+
+    DL_FOREACH(obj_reg->region_storage_head, elt)
+    {
+        if (elt->offset == wal_region.offset && elt->ndim == wal_region.ndim &&
+            memcmp(elt->start, wal_region.start, sizeof(uint64_t) * elt->ndim) == 0 &&
+            memcmp(elt->count, wal_region.count, sizeof(uint64_t) * elt->ndim) == 0)
+            return SUCCEED;
+    }
+
+    region = (region_list_t *)malloc(sizeof(region_list_t));
+    pdc_wal_region_to_list(&wal_region, obj_id, region);
+    DL_APPEND(obj_reg->region_storage_head, region);
+
+    return SUCCEED;
+}
+
+static perr_t
+pdc_wal_replay_region_place(char *buf, uint32_t size)
+{
+    uint64_t obj_id, reg[2 * DIM_MAX];
+    uint32_t data_server_id;
+    int32_t  ndim;
+    size_t   pos;
+
+    pos = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(int32_t);
+    if (size < pos)
+        return FAIL;
+    memcpy(&obj_id, buf, sizeof(uint64_t));
+    memcpy(&data_server_id, buf + sizeof(uint64_t), sizeof(uint32_t));
+    memcpy(&ndim, buf + sizeof(uint64_t) + sizeof(uint32_t), sizeof(int32_t));
+    if (ndim < 0 || ndim > DIM_MAX || size != pos + sizeof(uint64_t) * 2 * ndim)
+        return FAIL;
+    memcpy(reg, buf + pos, sizeof(uint64_t) * 2 * ndim);
+
+    return transfer_request_metadata_query_restore(obj_id, ndim, reg, reg + ndim, data_server_id);
+}
+
+static perr_t
+pdc_wal_replay_dart(pdc_wal_record_type_t type, char *buf, uint32_t size)
+{
+    dart_perform_one_server_in_t  in;
+    dart_perform_one_server_out_t out;
+    size_t                        key_len;
+
+    if (size <= sizeof(uint64_t) || buf[size - 1] != 0)
+        return FAIL;
+    memset(&in, 0, sizeof(in));
+    memcpy(&in.obj_primary_ref, buf, sizeof(uint64_t));
+    in.attr_key = buf + sizeof(uint64_t);
+    key_len     = strlen(in.attr_key);
+    if (sizeof(uint64_t) + key_len + 1 >= size)
+        return FAIL;
+    in.attr_val     = in.attr_key + key_len + 1;
+    in.op_type      = type == PDC_WAL_DART_INSERT ? OP_INSERT : OP_DELETE;
+    in.hash_algo    = DART_HASH;
+    in.obj_ref_type = REF_PRIMARY_ID;
+
+    return PDC_Server_dart_perform_one_server(&in, &out, NULL, NULL);
+}
+
+perr_t
+PDC_Server_wal_replay(const char *path, uint64_t after_lsn, uint64_t *last_lsn, uint64_t *n_record)
+{
+    perr_t                  ret_value = SUCCEED;
+    pdc_wal_record_header_t header;
+    struct iovec            iov;
+    FILE *                  file;
+    char *                  buf      = NULL;
+    size_t                  buf_size = 0;
+    long                    valid    = 0;
+    perr_t                  applied;
+
+    FUNC_ENTER(NULL);
+
+    *n_record = 0;
+    file      = fopen(path, "r");
+    if (file == NULL)
+        goto done;
+
+    while (fread(&header, sizeof(header), 1, file) == 1) {
+        if (header.size > buf_size) {
+            buf_size = header.size;
+            buf      = (char *)realloc(buf, buf_size);
+        }
+        if (header.size > 0 && fread(buf, header.size, 1, file) != 1)
+            break;
+        iov.iov_base = buf;
+        iov.iov_len  = header.size;
+        if (pdc_wal_checksum(&header, &iov, 1) != header.checksum)
+            break;
+        valid = ftell(file);
+        if (header.lsn > *last_lsn)
+            *last_lsn = header.lsn;
+        if (header.lsn <= after_lsn)
+            continue;
+
+        switch (header.type) {
+            case PDC_WAL_CONT_CREATE:
+                applied = pdc_wal_replay_cont_create(buf, header.size);
+                break;
+            case PDC_WAL_OBJ_PUT:
+                applied = pdc_wal_replay_obj_put(buf, header.size);
+                break;
+            case PDC_WAL_OBJ_DELETE:
+                applied = pdc_wal_replay_obj_delete(buf, header.size);
+                break;
+            case PDC_WAL_KVTAG_ADD:
+                applied = pdc_wal_replay_kvtag_add(buf, header.size);
+                break;
+            case PDC_WAL_KVTAG_DEL:
+                applied = pdc_wal_replay_kvtag_del(buf, header.size);
+                break;
+            case PDC_WAL_META_REGION:
+                applied = pdc_wal_replay_meta_region(buf, header.size);
+                break;
+            case PDC_WAL_DATA_REGION:
+                applied = pdc_wal_replay_data_region(buf, header.size);
+                break;
+            case PDC_WAL_REGION_PLACE:
+                applied = pdc_wal_replay_region_place(buf, header.size);
+                break;
+            case PDC_WAL_DART_INSERT:
+            case PDC_WAL_DART_DELETE:
+                applied = pdc_wal_replay_dart((pdc_wal_record_type_t)header.type, buf, header.size);
+                break;
+            default:
+                applied = FAIL;
+                break;
+        }
+        if (applied != SUCCEED)
+            printf("==PDC_SERVER[%d]: %s - cannot apply record %" PRIu64 " of type %u in %s\n",
+                   pdc_server_rank_g, __func__, header.lsn, header.type, path);
+        else
+            (*n_record)++;
+    }
+    fclose(file);
+
+    // Drop a record torn by a crash, so new records are not appended after it
+    if (truncate(path, valid) != 0) {
+        printf("==PDC_SERVER[%d]: %s - cannot truncate %s, %s\n", pdc_server_rank_g, __func__, path,
+               strerror(errno));
+        ret_value = FAIL;
+    }
+
+done:
+    free(buf);
+    fflush(stdout);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_wal_log_cont_create(uint32_t hash_key, pdc_cont_hash_table_entry_t *cont)
+{
+    struct iovec iov[4];
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &hash_key;
+    iov[1].iov_len  = sizeof(uint32_t);
+    iov[2].iov_base = &cont->cont_id;
+    iov[2].iov_len  = sizeof(uint64_t);
+    iov[3].iov_base = cont->cont_name;
+    iov[3].iov_len  = strnlen(cont->cont_name, ADDR_MAX - 1) + 1;
+
+    return pdc_wal_append(PDC_WAL_CONT_CREATE, iov, 4);
+}
+
+perr_t
+PDC_Server_wal_log_obj_put(uint32_t hash_key, pdc_metadata_t *meta)
+{
+    struct iovec iov[3];
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &hash_key;
+    iov[1].iov_len  = sizeof(uint32_t);
+    iov[2].iov_base = meta;
+    iov[2].iov_len  = sizeof(pdc_metadata_t);
+
+    return pdc_wal_append(PDC_WAL_OBJ_PUT, iov, 3);
+}
+
+perr_t
+PDC_Server_wal_log_obj_delete(uint64_t obj_id)
+{
+    struct iovec iov[2];
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &obj_id;
+    iov[1].iov_len  = sizeof(uint64_t);
+
+    return pdc_wal_append(PDC_WAL_OBJ_DELETE, iov, 2);
+}
+
+perr_t
+PDC_Server_wal_log_kvtag_add(uint32_t hash_key, uint64_t obj_id, pdc_kvtag_t *kvtag)
+{
+    perr_t       ret_value;
+    struct iovec iov[PDC_WAL_MAX_IOV];
+    size_t       name_len;
+    char *       name_value;
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    // Name and value are written in one piece, a record has at most PDC_WAL_MAX_IOV pieces
+    name_len   = strlen(kvtag->name) + 1;
+    name_value = (char *)malloc(name_len + kvtag->size);
+    memcpy(name_value, kvtag->name, name_len);
+    if (kvtag->size > 0)
+        memcpy(name_value + name_len, kvtag->value, kvtag->size);
+
+    iov[1].iov_base = &hash_key;
+    iov[1].iov_len  = sizeof(uint32_t);
+    iov[2].iov_base = &obj_id;
+    iov[2].iov_len  = sizeof(uint64_t);
+    iov[3].iov_base = &kvtag->type;
+    iov[3].iov_len  = sizeof(int8_t);
+    iov[4].iov_base = &kvtag->size;
+    iov[4].iov_len  = sizeof(uint32_t);
+    iov[5].iov_base = name_value;
+    iov[5].iov_len  = name_len + kvtag->size;
+
+    ret_value = pdc_wal_append(PDC_WAL_KVTAG_ADD, iov, 6);
+    free(name_value);
+
+    return ret_value;
+}
+
+perr_t
+PDC_Server_wal_log_kvtag_del(uint32_t hash_key, uint64_t obj_id, const char *name)
+{
+    struct iovec iov[4];
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &hash_key;
+    iov[1].iov_len  = sizeof(uint32_t);
+    iov[2].iov_base = &obj_id;
+    iov[2].iov_len  = sizeof(uint64_t);
+    iov[3].iov_base = (void *)name;
+    iov[3].iov_len  = strlen(name) + 1;
+
+    return pdc_wal_append(PDC_WAL_KVTAG_DEL, iov, 4);
+}
+
+perr_t
+PDC_Server_wal_log_region(pdc_wal_record_type_t type, uint64_t obj_id, region_list_t *region)
+{
+    struct iovec     iov[3];
+    pdc_wal_region_t wal_region;
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    memset(&wal_region, 0, sizeof(pdc_wal_region_t));
+    wal_region.ndim = region->ndim;
+    memcpy(wal_region.start, region->start, sizeof(uint64_t) * DIM_MAX);
+    memcpy(wal_region.count, region->count, sizeof(uint64_t) * DIM_MAX);
+    wal_region.unit_size = region->unit_size;
+    wal_region.data_size = region->data_size;
+    wal_region.offset    = region->offset;
+    snprintf(wal_region.storage_location, ADDR_MAX, "%s", region->storage_location);
+
+    iov[1].iov_base = &obj_id;
+    iov[1].iov_len  = sizeof(uint64_t);
+    iov[2].iov_base = &wal_region;
+    iov[2].iov_len  = sizeof(pdc_wal_region_t);
+
+    return pdc_wal_append(type, iov, 3);
+}
+
+perr_t
+PDC_Server_wal_log_region_place(uint64_t obj_id, uint32_t data_server_id, int ndim,
+                                const uint64_t *reg_offset, const uint64_t *reg_size)
+{
+    struct iovec iov[PDC_WAL_MAX_IOV];
+    int32_t      ndim32 = ndim;
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &obj_id;
+    iov[1].iov_len  = sizeof(uint64_t);
+    iov[2].iov_base = &data_server_id;
+    iov[2].iov_len  = sizeof(uint32_t);
+    iov[3].iov_base = &ndim32;
+    iov[3].iov_len  = sizeof(int32_t);
+    iov[4].iov_base = (void *)reg_offset;
+    iov[4].iov_len  = sizeof(uint64_t) * ndim;
+    iov[5].iov_base = (void *)reg_size;
+    iov[5].iov_len  = sizeof(uint64_t) * ndim;
+
+    return pdc_wal_append(PDC_WAL_REGION_PLACE, iov, 6);
+}
+
+perr_t
+PDC_Server_wal_log_dart(pdc_wal_record_type_t type, const char *attr_key, const char *attr_val,
+                        uint64_t obj_locator)
+{
+    struct iovec iov[4];
+
+    if (wal_fd_g < 0)
+        return SUCCEED;
+
+    iov[1].iov_base = &obj_locator;
+    iov[1].iov_len  = sizeof(uint64_t);
+    iov[2].iov_base = (void *)attr_key;
+    iov[2].iov_len  = strlen(attr_key) + 1;
+    iov[3].iov_base = (void *)attr_val;
+    iov[3].iov_len  = strlen(attr_val) + 1;
+
+    return pdc_wal_append(type, iov, 4);
+}
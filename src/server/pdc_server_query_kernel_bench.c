@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pdc_server_query_kernel.h"
+#include "pdc_server_query_bitmap.h"
+
+/*
+ * Compare the query scan kernels with a per-element evaluation that dispatches on the operator for every
+ * element and grows the selection one hit at a time, over VPIC-like particle data. The kernels are run
+ * with both the coordinate and the bitmap selection.
+ *
+ * Usage: pdc_server_query_kernel_bench [n_particles] [file]
+ *   file: raw float32 array of one VPIC variable, e.g. Energy. Random energies are generated without it.
+ */
+
+static double
+elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, 0);
+    return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+static uint64_t
+reference_scan(const float *data, uint64_t n, pdc_query_op_t lo_op, float lo, pdc_query_op_t hi_op, float hi,
+               pdc_selection_t *sel)
+{
+    uint64_t i;
+    int      is_good;
+
+    for (i = 0; i < n; i++) {
+        is_good = 0;
+        switch (lo_op) {
+            case PDC_GT:
+                is_good = data[i] > lo;
+                break;
+            case PDC_GTE:
+                is_good = data[i] >= lo;
+                break;
+            case PDC_LT:
+                is_good = data[i] < lo;
+                break;
+            case PDC_LTE:
+                is_good = data[i] <= lo;
+                break;
+            default:
+                is_good = data[i] == lo;
+                break;
+        }
+        if (is_good && hi_op == PDC_LT)
+            is_good = data[i] < hi;
+        else if (is_good && hi_op == PDC_LTE)
+            is_good = data[i] <= hi;
+
+        if (is_good) {
+            if (sel->nhits + 1 > sel->coords_alloc) {
+                sel->coords_alloc *= 2;
+                sel->coords = (uint64_t *)realloc(sel->coords, sel->coords_alloc * sizeof(uint64_t));
+            }
+            sel->coords[sel->nhits++] = i;
+        }
+    }
+    return sel->nhits;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t                n = 64 * 1024 * 1024, i, n_ref, n_kernel, n_bitmap;
+    float *                 data, lo, hi;
+    FILE *                  file;
+    region_list_t           region;
+    pdc_selection_t         sel;
+    pdc_query_bitmap_sel_t *bsel;
+    struct timeval          start;
+    double                  t_ref, t_kernel, t_bitmap;
+    size_t                  bitmap_size;
+    int                     q, nerr = 0;
+
+    struct {
+        const char *   desc;
+        pdc_query_op_t lo_op;
+        float          lo;
+        pdc_query_op_t hi_op;
+        float          hi;
+    } queries[] = {{"Energy > 2.0", PDC_GT, 2.0, PDC_OP_NONE, 0},
+                   {"Energy > 1.2", PDC_GT, 1.2, PDC_OP_NONE, 0},
+                   {"1.3 <= Energy < 1.4", PDC_GTE, 1.3, PDC_LT, 1.4},
+                   {"0.1 < Energy <= 3.0", PDC_GT, 0.1, PDC_LTE, 3.0}};
+
+    if (argc > 1)
+        n = strtoull(argv[1], NULL, 10);
+
+    data = (float *)malloc(n * sizeof(float));
+    if (argc > 2) {
+        file = fopen(argv[2], "rb");
+        if (file == NULL) {
+            printf("Cannot open %s\n", argv[2]);
+            return 1;
+        }
+        n = fread(data, sizeof(float), n, file);
+        fclose(file);
+    }
+    else {
+        // Exponential-like energy spectrum with most particles at low energy
+        srand(123);
+        for (i = 0; i < n; i++)
+            data[i] = -0.5 * logf(((float)rand() + 1) / ((float)RAND_MAX + 2));
+    }
+
+    memset(&region, 0, sizeof(region_list_t));
+    region.ndim     = 1;
+    region.start[0] = 0;
+    region.count[0] = n * sizeof(float);
+
+    printf("Scanning %" PRIu64 " elements\n", n);
+    for (q = 0; q < (int)(sizeof(queries) / sizeof(queries[0])); q++) {
+        lo = queries[q].lo;
+        hi = queries[q].hi;
+
+        sel.nhits        = 0;
+        sel.coords_alloc = 128;
+        sel.coords       = (uint64_t *)malloc(sel.coords_alloc * sizeof(uint64_t));
+        gettimeofday(&start, 0);
+        n_ref = reference_scan(data, n, queries[q].lo_op, lo, queries[q].hi_op, hi, &sel);
+        t_ref = elapsed(&start);
+        free(sel.coords);
+
+        sel.nhits        = 0;
+        sel.coords_alloc = 128;
+        sel.coords       = (uint64_t *)malloc(sel.coords_alloc * sizeof(uint64_t));
+        gettimeofday(&start, 0);
+        if (PDC_Server_query_kernel_evaluate(PDC_FLOAT, data, n, &region, sizeof(float), queries[q].lo_op,
+                                             &lo, queries[q].hi_op, &hi, NULL, PDC_QUERY_NONE,
+                                             &sel) != SUCCEED)
+            nerr++;
+        t_kernel = elapsed(&start);
+        n_kernel = sel.nhits;
+        free(sel.coords);
+
+        bsel = PDC_Server_query_bitmap_sel_create();
+        gettimeofday(&start, 0);
+        PDC_Server_query_bitmap_sel_begin(bsel);
+        if (PDC_Server_query_bitmap_sel_evaluate(PDC_FLOAT, data, n, &region, sizeof(float), queries[q].lo_op,
+                                                 &lo, queries[q].hi_op, &hi, NULL, PDC_QUERY_NONE,
+                                                 bsel) != SUCCEED)
+            nerr++;
+        PDC_Server_query_bitmap_sel_end(bsel, PDC_QUERY_NONE);
+        t_bitmap    = elapsed(&start);
+        n_bitmap    = bsel->nhits;
+        bitmap_size = bsel->n_region > 0 ? pdc_roaring_size_in_bytes(bsel->regions[0].bits) : 0;
+        PDC_Server_query_bitmap_sel_free(bsel);
+
+        printf("%-22s hits %12" PRIu64 "  per-element %8.4fs  kernel %8.4fs  speedup %5.2fx\n",
+               queries[q].desc, n_kernel, t_ref, t_kernel, t_ref / t_kernel);
+        printf("%-22s bitmap %8.4fs, %10.2f MB instead of %10.2f MB of coords\n", "", t_bitmap,
+               bitmap_size / 1048576.0, n_kernel * sizeof(uint64_t) / 1048576.0);
+        if (n_ref != n_kernel || n_ref != n_bitmap) {
+            printf("Mismatch: per-element found %" PRIu64 " hits, bitmap %" PRIu64 "\n", n_ref, n_bitmap);
+            nerr++;
+        }
+    }
+
+    free(data);
+    return nerr == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include "pdc_server_query_kernel.h"
+
+/*
+ * Check the query scan kernels against a per-element evaluation, for int and double data in 1D, 2D and 3D
+ * storage regions, with and without a region constraint, and with a second constraint combined by AND.
+ * Element i of a region has coordinate i % count[0] in dimension 0, dimension 0 varies fastest.
+ */
+
+#define NTYPE 2
+
+typedef struct constraint_t {
+    pdc_query_op_t lo_op;
+    double         lo;
+    pdc_query_op_t hi_op;
+    double         hi;
+} constraint_t;
+
+static const constraint_t constraints[] = {
+    {PDC_GT, 10, PDC_OP_NONE, 0},  {PDC_GTE, 10, PDC_OP_NONE, 0}, {PDC_LT, -20, PDC_OP_NONE, 0},
+    {PDC_LTE, -20, PDC_OP_NONE, 0}, {PDC_EQ, 7, PDC_OP_NONE, 0},   {PDC_GT, -50, PDC_LT, 50},
+    {PDC_GTE, -50, PDC_LTE, 50},    {PDC_GT, 0, PDC_LTE, 30},      {PDC_GTE, -30, PDC_LT, 0},
+    {PDC_LT, 60, PDC_GT, -60},      {PDC_LTE, 5, PDC_GTE, 5},      {PDC_GT, 100, PDC_LT, -100}};
+
+#define NCONSTRAINT (sizeof(constraints) / sizeof(constraints[0]))
+
+static int
+match_op(pdc_query_op_t op, double value, double bound)
+{
+    switch (op) {
+        case PDC_GT:
+            return value > bound;
+        case PDC_GTE:
+            return value >= bound;
+        case PDC_LT:
+            return value < bound;
+        case PDC_LTE:
+            return value <= bound;
+        case PDC_EQ:
+            return value == bound;
+        default:
+            return 1;
+    }
+}
+
+static int
+match_constraint(const constraint_t *c, double value)
+{
+    return match_op(c->lo_op, value, c->lo) && match_op(c->hi_op, value, c->hi);
+}
+
+static double
+element_value(pdc_var_type_t type, const void *data, uint64_t i)
+{
+    if (type == PDC_INT)
+        return ((const int *)data)[i];
+    return ((const double *)data)[i];
+}
+
+// Pass a bound in the element type
+static const void *
+bound_value(pdc_var_type_t type, double bound, int *ival, double *dval)
+{
+    *ival = (int)bound;
+    *dval = bound;
+    return type == PDC_INT ? (const void *)ival : (const void *)dval;
+}
+
+// Coordinates of element i of a region, in elements
+static void
+element_coords(region_list_t *region, size_t unit, uint64_t i, uint64_t *coords)
+{
+    size_t d;
+    for (d = 0; d < region->ndim; d++) {
+        coords[d] = region->start[d] / unit + i % (region->count[d] / unit);
+        i /= region->count[d] / unit;
+    }
+}
+
+// The upper bound of a region constraint is inclusive, both bounds are in bytes
+static int
+in_constraint(region_list_t *constraint, size_t unit, const uint64_t *coords, size_t ndim)
+{
+    size_t d;
+
+    if (constraint == NULL)
+        return 1;
+    for (d = 0; d < ndim; d++) {
+        if (coords[d] * unit < constraint->start[d] ||
+            coords[d] * unit > constraint->start[d] + constraint->count[d])
+            return 0;
+    }
+    return 1;
+}
+
+static void
+make_region(region_list_t *region, size_t ndim, const uint64_t *start, const uint64_t *count, size_t unit)
+{
+    size_t d;
+
+    memset(region, 0, sizeof(region_list_t));
+    region->ndim = ndim;
+    for (d = 0; d < ndim; d++) {
+        region->start[d] = start[d] * unit;
+        region->count[d] = count[d] * unit;
+    }
+}
+
+// Evaluate c over the region with the kernels and compare with the elements that match it and the constraint
+static void
+check_constraint(pdc_var_type_t type, const void *data, uint64_t n, region_list_t *region, size_t unit,
+                 const constraint_t *c, region_list_t *region_constraint)
+{
+    pdc_selection_t sel;
+    uint64_t        i, nhits = 0, coords[DIM_MAX], mask_match;
+    uint64_t *      mask;
+    int             ilo, ihi;
+    double          dlo, dhi;
+    const void *    lo, *hi;
+
+    lo = bound_value(type, c->lo, &ilo, &dlo);
+    hi = bound_value(type, c->hi, &ihi, &dhi);
+
+    memset(&sel, 0, sizeof(pdc_selection_t));
+    assert(PDC_Server_query_kernel_evaluate(type, data, n, region, unit, c->lo_op, lo, c->hi_op, hi,
+                                            region_constraint, PDC_QUERY_NONE, &sel) == SUCCEED);
+    for (i = 0; i < n; i++) {
+        element_coords(region, unit, i, coords);
+        if (!match_constraint(c, element_value(type, data, i)) ||
+            !in_constraint(region_constraint, unit, coords, region->ndim))
+            continue;
+        assert(nhits < sel.nhits);
+        assert(memcmp(sel.coords + nhits * region->ndim, coords, region->ndim * sizeof(uint64_t)) == 0);
+        nhits++;
+    }
+    assert(nhits == sel.nhits);
+
+    // The mask of the scan alone holds the value matches
+    mask = (uint64_t *)malloc((n + 63) / 64 * sizeof(uint64_t));
+    assert(PDC_Server_query_kernel_scan(type, data, n, c->lo_op, lo, c->hi_op, hi, mask, &mask_match) ==
+           SUCCEED);
+    for (i = 0; i < n; i++)
+        assert((int)((mask[i / 64] >> (i % 64)) & 1) == match_constraint(c, element_value(type, data, i)));
+
+    free(mask);
+    free(sel.coords);
+}
+
+// Evaluate c1, then c2 combined by AND, and compare with the elements that match both
+static void
+check_and(pdc_var_type_t type, const void *data, uint64_t n, region_list_t *region, size_t unit,
+          const constraint_t *c1, const constraint_t *c2, region_list_t *region_constraint)
+{
+    pdc_selection_t sel;
+    uint64_t        i, nhits = 0, coords[DIM_MAX];
+    int             ilo, ihi;
+    double          dlo, dhi, value;
+    const void *    lo, *hi;
+
+    memset(&sel, 0, sizeof(pdc_selection_t));
+    lo = bound_value(type, c1->lo, &ilo, &dlo);
+    hi = bound_value(type, c1->hi, &ihi, &dhi);
+    assert(PDC_Server_query_kernel_evaluate(type, data, n, region, unit, c1->lo_op, lo, c1->hi_op, hi,
+                                            region_constraint, PDC_QUERY_NONE, &sel) == SUCCEED);
+    lo = bound_value(type, c2->lo, &ilo, &dlo);
+    hi = bound_value(type, c2->hi, &ihi, &dhi);
+    assert(PDC_Server_query_kernel_evaluate(type, data, n, region, unit, c2->lo_op, lo, c2->hi_op, hi,
+                                            region_constraint, PDC_QUERY_AND, &sel) == SUCCEED);
+
+    for (i = 0; i < n; i++) {
+        value = element_value(type, data, i);
+        element_coords(region, unit, i, coords);
+        if (!match_constraint(c1, value) || !match_constraint(c2, value) ||
+            !in_constraint(region_constraint, unit, coords, region->ndim))
+            continue;
+        assert(nhits < sel.nhits);
+        assert(memcmp(sel.coords + nhits * region->ndim, coords, region->ndim * sizeof(uint64_t)) == 0);
+        nhits++;
+    }
+    assert(nhits == sel.nhits);
+
+    free(sel.coords);
+}
+
+static void
+check_region(pdc_var_type_t type, size_t ndim, const uint64_t *start, const uint64_t *count,
+             const uint64_t *cons_start, const uint64_t *cons_count)
+{
+    region_list_t region, region_constraint;
+    size_t        unit = type == PDC_INT ? sizeof(int) : sizeof(double);
+    uint64_t      i, n = 1, seed = 12345;
+    size_t        d, j, k;
+    void *        data;
+
+    for (d = 0; d < ndim; d++)
+        n *= count[d];
+    // Values in [-128, 127], doubles with a fractional part, so every operator sees equal elements
+    data = malloc(n * unit);
+    for (i = 0; i < n; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if (type == PDC_INT)
+            ((int *)data)[i] = (int)(seed >> 56) - 128;
+        else
+            ((double *)data)[i] = (double)((int)(seed >> 56) - 128) + ((seed >> 40) & 1) * 0.5;
+    }
+    make_region(&region, ndim, start, count, unit);
+    make_region(&region_constraint, ndim, cons_start, cons_count, unit);
+
+    for (j = 0; j < NCONSTRAINT; j++) {
+        check_constraint(type, data, n, &region, unit, &constraints[j], NULL);
+        check_constraint(type, data, n, &region, unit, &constraints[j], &region_constraint);
+        for (k = 0; k < NCONSTRAINT; k++) {
+            check_and(type, data, n, &region, unit, &constraints[j], &constraints[k], NULL);
+            check_and(type, data, n, &region, unit, &constraints[j], &constraints[k], &region_constraint);
+        }
+    }
+    printf("%s %zuD region of %" PRIu64 " elements ok\n", type == PDC_INT ? "int" : "double", ndim, n);
+
+    free(data);
+}
+
+int
+main()
+{
+    pdc_var_type_t types[NTYPE] = {PDC_INT, PDC_DOUBLE};
+    int            t;
+
+    // Sizes that are not multiples of 64, so rows and the mask end in partial words
+    uint64_t start1[1] = {100}, count1[1] = {1000}, cons_start1[1] = {350}, cons_count1[1] = {301};
+    uint64_t start2[2] = {5, 3}, count2[2] = {37, 23}, cons_start2[2] = {10, 0}, cons_count2[2] = {20, 11};
+    uint64_t start3[3] = {2, 4, 6}, count3[3] = {11, 7, 13}, cons_start3[3] = {4, 6, 0},
+             cons_count3[3] = {5, 3, 10};
+
+    for (t = 0; t < NTYPE; t++) {
+        check_region(types[t], 1, start1, count1, cons_start1, cons_count1);
+        check_region(types[t], 2, start2, count2, cons_start2, cons_count2);
+        check_region(types[t], 3, start3, count3, cons_start3, cons_count3);
+    }
+
+    return 0;
+}
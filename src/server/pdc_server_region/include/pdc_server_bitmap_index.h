@@ -0,0 +1,110 @@
+#ifndef PDC_SERVER_BITMAP_INDEX_H
+#define PDC_SERVER_BITMAP_INDEX_H
+
+#include "pdc_client_server_common.h"
+#include "pdc_query.h"
+#include "pdc_roaring.h"
+
+/*
+ * Binned bitmap index of the data of one storage region.
+ *
+ * The values of the region are split in bins whose boundaries are quantiles of a sample of the data, or the
+ * distinct values themselves when there are few of them. Each bin keeps the elements it holds as a roaring
+ * bitmap over their linear index in the region, and the smallest and largest value it holds. A constraint
+ * takes the bins whose values all match without reading the data, skips the bins whose values all fail,
+ * and only checks the elements of the remaining bins against the data.
+ *
+ * The index is built when a region is written and stored next to the region data, see
+ * PDC_GEN_BITMAP_IDX and PDC_USE_BITMAP_IDX.
+ */
+
+#define PDC_BITMAP_INDEX_NBIN 64
+
+typedef struct pdc_bitmap_index_t {
+    pdc_var_type_t  dtype;
+    size_t          type_size;
+    uint64_t        n;       // Number of elements in the region
+    int             nbin;
+    char *          bin_min; // nbin values of dtype
+    char *          bin_max; // nbin values of dtype
+    pdc_roaring_t **bins;
+} pdc_bitmap_index_t;
+
+/**
+ * Build the index of the data of a region
+ *
+ * \param dtype [IN]            Type of the elements
+ * \param data [IN]             Data of the region
+ * \param n [IN]                Number of elements
+ * \param nbin [IN]             Maximum number of bins
+ *
+ * \return Pointer to the index/NULL if the type is not supported or on failure
+ */
+pdc_bitmap_index_t *PDC_Server_bitmap_index_build(pdc_var_type_t dtype, const void *data, uint64_t n,
+                                                  int nbin);
+
+/**
+ * Free an index
+ *
+ * \param idx [IN]              Index
+ */
+void PDC_Server_bitmap_index_free(pdc_bitmap_index_t *idx);
+
+/**
+ * Write an index to a file
+ *
+ * \param idx [IN]              Index
+ * \param path [IN]             File name
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_bitmap_index_write(pdc_bitmap_index_t *idx, const char *path);
+
+/**
+ * Read an index written by PDC_Server_bitmap_index_write
+ *
+ * \param path [IN]             File name
+ *
+ * \return Pointer to the index/NULL if there is no valid index in the file
+ */
+pdc_bitmap_index_t *PDC_Server_bitmap_index_read(const char *path);
+
+/**
+ * Check if the data of the region is needed to evaluate a constraint with the index, that is some bin
+ * holds both matching and non-matching values. Operators and values are passed as to
+ * PDC_Server_query_kernel_scan.
+ *
+ * \return 1 if the data is needed, 0 otherwise
+ */
+int PDC_Server_bitmap_index_needs_data(pdc_bitmap_index_t *idx, pdc_query_op_t lo_op, const void *lo,
+                                       pdc_query_op_t hi_op, const void *hi);
+
+/**
+ * Evaluate the match mask of a constraint with the index, the result is the same as with
+ * PDC_Server_query_kernel_scan over the data of the region.
+ *
+ * \param idx [IN]              Index
+ * \param data [IN]             Data of the region, can be NULL if PDC_Server_bitmap_index_needs_data is 0
+ * \param lo_op [IN]            First operator
+ * \param lo [IN]               Value of the first operator, of the element type
+ * \param hi_op [IN]            Second operator of a range, PDC_OP_NONE otherwise
+ * \param hi [IN]               Value of the second operator, of the element type
+ * \param mask [OUT]            (n + 63) / 64 words, bit i of word i / 64 is set if element i matches
+ * \param nmatch [OUT]          Number of matching elements
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_bitmap_index_scan(pdc_bitmap_index_t *idx, const void *data, pdc_query_op_t lo_op,
+                                    const void *lo, pdc_query_op_t hi_op, const void *hi, uint64_t *mask,
+                                    uint64_t *nmatch);
+
+/**
+ * Get the memory used by an index
+ *
+ * \param idx [IN]              Index
+ *
+ * \return Number of bytes
+ */
+size_t PDC_Server_bitmap_index_size_in_bytes(pdc_bitmap_index_t *idx);
+
+#endif /* PDC_SERVER_BITMAP_INDEX_H */
@@ -29,6 +29,7 @@
 #include "pdc_client_server_common.h"
 #include "pdc_region.h"
 #include "pdc_query.h"
+#include "pdc_server_query_bitmap.h"
 #include <sys/time.h>
 #include <pthread.h>
 
@@ -210,12 +211,19 @@ typedef struct query_task_t {
     int                next_server_id;
 
     // Result
-    int        is_done;
-    int        n_recv;
-    uint64_t   nhits;
-    uint64_t * coords;
-    uint64_t **coords_arr;
-    uint64_t * n_hits_from_server;
+    int                       is_done;
+    int                       n_recv;
+    uint64_t                  nhits;
+    uint64_t *                coords;
+    uint64_t **               coords_arr;
+    uint64_t *                n_hits_from_server;
+    pdc_query_bitmap_sel_t *  bitmap_sel;
+    pdc_query_bitmap_cursor_t cursor; // Next hit of bitmap_sel to fetch, see PDC_Server_query_cursor_fetch
+    uint64_t                  agg_obj_id;  // Object reduced by PDC_QUERY_GET_AGG
+    pdc_query_agg_t           agg;         // Merged aggregate of all servers
+    pdc_query_agg_t           my_agg;      // Aggregate of the hits of this server
+    int                       my_agg_fail; // 1 if this server could not aggregate all of its hits
+    uint64_t                  n_agg_fail;  // Servers in agg that could not aggregate all of their hits
 
     // Data read
     int       n_read_data_region;
@@ -312,6 +320,9 @@ extern hg_id_t send_bulk_rpc_register_id_g;
 extern char *  gBinningOption;
 extern int     gen_fastbit_idx_g;
 extern int     use_fastbit_idx_g;
+extern int     use_bitmap_sel_g;
+extern int     gen_bitmap_idx_g;
+extern int     use_bitmap_idx_g;
 
 /***************************************/
 /* Library-private Function Prototypes */
@@ -476,11 +487,13 @@ hg_return_t PDC_Server_count_write_check_update_storage_meta_cb(const struct hg_
  * \param region_info [IN]      Region information
  * \param buf [IN]              Data staring address
  * \param unit [IN]             Size of data type
+ * \param data_type [IN]        Data type, PDC_UNKNOWN if not known. The zone map and bitmap index of the
+ *                              written regions are built only when it is known.
  *
  * \return Non-negative on success/Negative on failure
  */
 perr_t PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info, void *buf,
-                                 size_t unit);
+                                 size_t unit, pdc_var_type_t data_type);
 
 /**
  * Read data from desired storage
@@ -781,6 +794,33 @@ perr_t PDC_sample_min_max(pdc_var_type_t dtype, uint64_t n, void *data, double s
  */
 pdc_histogram_t *PDC_gen_hist(pdc_var_type_t dtype, uint64_t n, void *data);
 
+/**
+ * Build the zone map of a storage region for query pruning. Its outer bounds are the exact minimum and
+ * maximum of the data, with PDC_GEN_HIST it also has the bins of a full histogram, otherwise a single bin.
+ *
+ * \param dtype [IN]            Data type
+ * \param n [IN]                Number of elements
+ * \param data [IN]             Data of the region
+ *
+ * \return Pointer to the histogram/NULL if the type is not supported or the data has NaN
+ */
+pdc_histogram_t *PDC_Server_gen_region_hist(pdc_var_type_t dtype, uint64_t n, void *data);
+
+/**
+ * Replace the zone map of a storage region, and with PDC_GEN_BITMAP_IDX its bitmap index, with ones built
+ * from its current data. They are dropped if the type is not known or there is no data. The bitmap index is
+ * written next to the region data, or removed from there, so the storage location and offset must be set.
+ * Safe while query workers evaluate the region.
+ *
+ * \param region [IN/OUT]       Storage region
+ * \param dtype [IN]            Data type, PDC_UNKNOWN if not known
+ * \param n [IN]                Number of elements
+ * \param data [IN]             Data of the region, NULL if not at hand
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_set_region_index(region_list_t *region, pdc_var_type_t dtype, uint64_t n, void *data);
+
 /**
  * ******
  *
@@ -866,6 +906,16 @@ hg_return_t PDC_recv_nhits(const struct hg_cb_info *callback_info);
  */
 hg_return_t PDC_recv_coords(const struct hg_cb_info *callback_info);
 
+/**
+ * Merge the partial aggregate of a worker into the aggregate of a query, and send it to the client once all
+ * workers have sent theirs
+ *
+ * \param callback_info [IN]    Mercury callback info
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+hg_return_t PDC_recv_query_agg(const struct hg_cb_info *callback_info);
+
 /**
  * ********
  *
@@ -884,6 +934,20 @@ hg_return_t PDC_recv_query_metadata_bulk(const struct hg_cb_info *callback_info)
  */
 hg_return_t PDC_Server_recv_get_sel_data(const struct hg_cb_info *callback_info);
 
+/**
+ * Push the next hits found by this server for a query to the client that opened a cursor on it, or free the
+ * result when the cursor is closed. Each server serves its own hits and their data, the client streams the
+ * pieces of all servers in server order. The handle is responded to and destroyed once the hits are
+ * transferred.
+ *
+ * \param handle [IN]           Handle of the fetch RPC
+ * \param in [IN]               Fetch request, copied out of the RPC input; its bulk handle holds a reference
+ *                              that is released with the handle
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+hg_return_t PDC_Server_query_cursor_fetch(hg_handle_t handle, query_cursor_fetch_in_t *in);
+
 /**
  * ********
  *
@@ -0,0 +1,196 @@
+#ifndef PDC_SERVER_QUERY_BITMAP_H
+#define PDC_SERVER_QUERY_BITMAP_H
+
+#include "pdc_client_server_common.h"
+#include "pdc_query.h"
+#include "pdc_roaring.h"
+
+/*
+ * Query selection kept as compressed bitmaps.
+ *
+ * Instead of ndim coordinates per hit, the selection holds one roaring bitmap per storage region over the
+ * linear index of the elements in the region, with dimension 0 varying fastest. The constraints of a query
+ * are combined region by region with bitmap AND/OR, which needs the queried objects to share their region
+ * layout. Coordinates are only built when the selection or the data of the hits is requested.
+ */
+
+/*
+ * Hits in one storage region
+ */
+typedef struct pdc_query_bitmap_region_t {
+    uint64_t       start[DIM_MAX]; // In elements
+    uint64_t       count[DIM_MAX]; // In elements
+    int            is_evaluated;
+    pdc_roaring_t *bits;
+} pdc_query_bitmap_region_t;
+
+typedef struct pdc_query_bitmap_sel_t {
+    int                        ndim;
+    int                        n_region;
+    int                        alloc;
+    int                        hint;
+    uint64_t                   nhits;
+    pdc_query_bitmap_region_t *regions;
+} pdc_query_bitmap_sel_t;
+
+/*
+ * Position in the hits of a selection, in region order
+ */
+typedef struct pdc_query_bitmap_cursor_t {
+    int                region; // Region of the next hit
+    uint64_t           pos;    // Index of the next hit in the selection
+    pdc_roaring_iter_t iter;   // Next hit in the region
+} pdc_query_bitmap_cursor_t;
+
+/**
+ * Create an empty bitmap selection
+ *
+ * \return Pointer to the selection/NULL on failure
+ */
+pdc_query_bitmap_sel_t *PDC_Server_query_bitmap_sel_create();
+
+/**
+ * Free a bitmap selection and its bitmaps
+ *
+ * \param bsel [IN]             Selection
+ */
+void PDC_Server_query_bitmap_sel_free(pdc_query_bitmap_sel_t *bsel);
+
+/**
+ * Check if the storage regions of an object can be combined with the selection, that is every region
+ * either has the same start and count as a region of the selection or overlaps none of them.
+ *
+ * \param bsel [IN]             Selection
+ * \param region_list_head [IN] Storage regions of the object, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ *
+ * \return 1 if aligned, 0 otherwise
+ */
+int PDC_Server_query_bitmap_sel_is_aligned(pdc_query_bitmap_sel_t *bsel, region_list_t *region_list_head,
+                                           size_t unit_size);
+
+/**
+ * Start the evaluation of a constraint
+ *
+ * \param bsel [IN]             Selection
+ */
+void PDC_Server_query_bitmap_sel_begin(pdc_query_bitmap_sel_t *bsel);
+
+/**
+ * Evaluate a constraint over the data of one storage region and combine the matches with the selection.
+ * With PDC_QUERY_NONE or PDC_QUERY_OR they are added to the bitmap of the region, with PDC_QUERY_AND the
+ * bitmap of the region is intersected with them, a region without hits is not scanned.
+ *
+ * \param type [IN]             Type of the elements
+ * \param data [IN]             Data of the region
+ * \param n [IN]                Number of elements in data
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param lo_op [IN]            First operator
+ * \param lo [IN]               Value of the first operator
+ * \param hi_op [IN]            Second operator of a range, PDC_OP_NONE otherwise
+ * \param hi [IN]               Value of the second operator
+ * \param region_constraint [IN] Region constraint of the query in bytes, or NULL
+ * \param combine_op [IN]       How the result is combined with the selection
+ * \param bsel [IN/OUT]         Selection
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_bitmap_sel_evaluate(pdc_var_type_t type, const void *data, uint64_t n,
+                                            region_list_t *region, size_t unit_size, pdc_query_op_t lo_op,
+                                            const void *lo, pdc_query_op_t hi_op, const void *hi,
+                                            region_list_t *region_constraint,
+                                            pdc_query_combine_op_t combine_op, pdc_query_bitmap_sel_t *bsel);
+
+/**
+ * Combine the match mask of a constraint over one storage region with the selection, as
+ * PDC_Server_query_bitmap_sel_evaluate does.
+ *
+ * \param mask [IN/OUT]         Match mask as written by PDC_Server_query_kernel_scan, bits outside of the
+ *                              region constraint are cleared
+ * \param n [IN]                Number of elements in the region
+ * \param nmatch [IN]           Number of bits set in mask
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param region_constraint [IN] Region constraint of the query in bytes, or NULL
+ * \param combine_op [IN]       How the result is combined with the selection
+ * \param bsel [IN/OUT]         Selection
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_bitmap_sel_combine(uint64_t *mask, uint64_t n, uint64_t nmatch, region_list_t *region,
+                                           size_t unit_size, region_list_t *region_constraint,
+                                           pdc_query_combine_op_t combine_op, pdc_query_bitmap_sel_t *bsel);
+
+/**
+ * Finish the evaluation of a constraint. With PDC_QUERY_AND, the hits of the regions that were not
+ * evaluated are dropped as the constraint has no match there.
+ *
+ * \param bsel [IN/OUT]         Selection
+ * \param combine_op [IN]       How the constraint was combined with the selection
+ */
+void PDC_Server_query_bitmap_sel_end(pdc_query_bitmap_sel_t *bsel, pdc_query_combine_op_t combine_op);
+
+/**
+ * Write the coordinates of all hits of the selection
+ *
+ * \param bsel [IN]             Selection
+ * \param sel [OUT]             Selection with ndim coordinates per hit, reallocated as needed
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_bitmap_sel_to_coords(pdc_query_bitmap_sel_t *bsel, pdc_selection_t *sel);
+
+/**
+ * Move a cursor to a hit of the selection, in the order PDC_Server_query_bitmap_sel_to_coords writes them
+ *
+ * \param bsel [IN]             Selection
+ * \param cursor [OUT]          Cursor
+ * \param pos [IN]              Index of the hit, the cursor is at the end if pos >= nhits
+ */
+void PDC_Server_query_bitmap_sel_seek(pdc_query_bitmap_sel_t *bsel, pdc_query_bitmap_cursor_t *cursor,
+                                      uint64_t pos);
+
+/**
+ * Write the coordinates of the next hits of a cursor and move it past them, so a large selection can be
+ * sent in pieces without building all its coordinates
+ *
+ * \param bsel [IN]             Selection
+ * \param cursor [IN/OUT]       Cursor set by PDC_Server_query_bitmap_sel_seek
+ * \param n [IN]                Maximum number of hits
+ * \param coords [OUT]          Room for n * ndim coordinates
+ *
+ * \return Number of hits written, 0 at the end of the selection
+ */
+uint64_t PDC_Server_query_bitmap_sel_read_coords(pdc_query_bitmap_sel_t *   bsel,
+                                                 pdc_query_bitmap_cursor_t *cursor, uint64_t n,
+                                                 uint64_t *coords);
+
+/**
+ * Get the hits of the selection in a storage region, which can belong to another object with the same
+ * region layout as the queried ones
+ *
+ * \param bsel [IN]             Selection
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ *
+ * \return Bitmap over the linear index of the elements in the region/NULL if the selection has no such
+ *         region
+ */
+pdc_roaring_t *PDC_Server_query_bitmap_sel_region_bits(pdc_query_bitmap_sel_t *bsel, region_list_t *region,
+                                                       size_t unit_size);
+
+/**
+ * Copy the elements of the data of a region at the hits of a bitmap next to each other
+ *
+ * \param bits [IN]             Hits, as returned by PDC_Server_query_bitmap_sel_region_bits
+ * \param data [IN]             Data of the region
+ * \param unit_size [IN]        Size of one element
+ * \param out [OUT]             Room for the cardinality of bits elements
+ *
+ * \return Number of elements copied
+ */
+uint64_t PDC_Server_query_bitmap_gather(const pdc_roaring_t *bits, const void *data, size_t unit_size,
+                                        void *out);
+
+#endif /* PDC_SERVER_QUERY_BITMAP_H */
@@ -0,0 +1,149 @@
+#ifndef PDC_SERVER_QUERY_KERNEL_H
+#define PDC_SERVER_QUERY_KERNEL_H
+
+#include "pdc_client_server_common.h"
+#include "pdc_query.h"
+
+/*
+ * Scan kernels for the server side query evaluation.
+ *
+ * A region is evaluated in two passes. The first pass runs a kernel specialized for the data type and the
+ * operator(s) of the constraint, it compares 64 elements at a time without branches and writes one bit per
+ * element into a match mask. Float and double kernels use AVX-512 or AVX2 when the server is built for
+ * such a target (see PDC_ENABLE_NATIVE_SIMD), the other types use a scalar loop the compiler can
+ * vectorize. The second pass walks the set bits of the mask and appends their coordinates to the
+ * selection, which is grown once per region.
+ */
+
+/**
+ * Evaluate a match mask over n elements of data.
+ * A single operator constraint is passed as lo_op/lo with hi_op = PDC_OP_NONE, a range constraint uses
+ * both bounds, one lower (PDC_GT/PDC_GTE) and one upper (PDC_LT/PDC_LTE) operator in any order.
+ *
+ * \param type [IN]             Type of the elements
+ * \param data [IN]             Elements
+ * \param n [IN]                Number of elements
+ * \param lo_op [IN]            First operator
+ * \param lo [IN]               Value of the first operator, of the element type
+ * \param hi_op [IN]            Second operator of a range, PDC_OP_NONE otherwise
+ * \param hi [IN]               Value of the second operator, of the element type
+ * \param mask [OUT]            (n + 63) / 64 words, bit i of word i / 64 is set if element i matches
+ * \param nmatch [OUT]          Number of matching elements
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_kernel_scan(pdc_var_type_t type, const void *data, uint64_t n, pdc_query_op_t lo_op,
+                                    const void *lo, pdc_query_op_t hi_op, const void *hi, uint64_t *mask,
+                                    uint64_t *nmatch);
+
+/**
+ * Clear the bits of a match mask for the elements outside of the region constraint, whose upper bound is
+ * inclusive.
+ *
+ * \param mask [IN/OUT]         Match mask of the elements of the region
+ * \param n [IN]                Number of elements in the region
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param constraint [IN]       Region constraint of the query in bytes
+ *
+ * \return Number of bits left in the mask
+ */
+uint64_t PDC_Server_query_kernel_constrain(uint64_t *mask, uint64_t n, region_list_t *region,
+                                           size_t unit_size, region_list_t *constraint);
+
+/**
+ * Evaluate a match mask over the data of one storage region, as PDC_Server_query_kernel_scan, and clear the
+ * bits of the elements outside of the region constraint.
+ *
+ * \param type [IN]             Type of the elements
+ * \param data [IN]             Data of the region
+ * \param n [IN]                Number of elements in data
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param lo_op [IN]            First operator
+ * \param lo [IN]               Value of the first operator
+ * \param hi_op [IN]            Second operator of a range, PDC_OP_NONE otherwise
+ * \param hi [IN]               Value of the second operator
+ * \param region_constraint [IN] Region constraint of the query in bytes, or NULL
+ * \param mask [OUT]            (n + 63) / 64 words, bit i of word i / 64 is set if element i matches
+ * \param nmatch [OUT]          Number of matching elements
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_kernel_scan_region(pdc_var_type_t type, const void *data, uint64_t n,
+                                           region_list_t *region, size_t unit_size, pdc_query_op_t lo_op,
+                                           const void *lo, pdc_query_op_t hi_op, const void *hi,
+                                           region_list_t *region_constraint, uint64_t *mask,
+                                           uint64_t *nmatch);
+
+/**
+ * Write the coordinates of the set bits of a match mask, in element order
+ *
+ * \param mask [IN]             Match mask of the elements of the region
+ * \param nword [IN]            Number of words in mask
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param coords [OUT]          ndim coordinates per set bit
+ */
+void PDC_Server_query_kernel_mask_to_coords(const uint64_t *mask, uint64_t nword, region_list_t *region,
+                                            size_t unit_size, uint64_t *coords);
+
+/**
+ * Grow the coordinates of a selection to hold nhits hits, it grows at least twofold to amortize appends
+ *
+ * \param sel [IN/OUT]          Selection
+ * \param nhits [IN]            Number of hits
+ * \param ndim [IN]             Number of dimensions
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_kernel_reserve_coords(pdc_selection_t *sel, uint64_t nhits, int ndim);
+
+/**
+ * Combine the match mask of a constraint over one storage region with the selection, as
+ * PDC_Server_query_kernel_evaluate does.
+ *
+ * \param mask [IN/OUT]         Match mask as written by PDC_Server_query_kernel_scan, bits outside of the
+ *                              region constraint are cleared
+ * \param n [IN]                Number of elements in the region
+ * \param nmatch [IN]           Number of bits set in mask
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param region_constraint [IN] Region constraint of the query in bytes, or NULL
+ * \param combine_op [IN]       How the result is combined with the selection
+ * \param sel [IN/OUT]          Selection
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_kernel_combine(uint64_t *mask, uint64_t n, uint64_t nmatch, region_list_t *region,
+                                       size_t unit_size, region_list_t *region_constraint,
+                                       pdc_query_combine_op_t combine_op, pdc_selection_t *sel);
+
+/**
+ * Evaluate a constraint over the data of one storage region and combine the result with the selection.
+ * With PDC_QUERY_NONE or PDC_QUERY_OR, the coordinates of the matching elements inside the region constraint
+ * are appended to the selection. With PDC_QUERY_AND, the coordinates of the selection that fall in the
+ * region and do not match are removed.
+ *
+ * \param type [IN]             Type of the elements
+ * \param data [IN]             Data of the region
+ * \param n [IN]                Number of elements in data
+ * \param region [IN]           Storage region, start and count in bytes
+ * \param unit_size [IN]        Size of one element
+ * \param lo_op [IN]            First operator
+ * \param lo [IN]               Value of the first operator
+ * \param hi_op [IN]            Second operator of a range, PDC_OP_NONE otherwise
+ * \param hi [IN]               Value of the second operator
+ * \param region_constraint [IN] Region constraint of the query in bytes, or NULL
+ * \param combine_op [IN]       How the result is combined with the selection
+ * \param sel [IN/OUT]          Selection
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+perr_t PDC_Server_query_kernel_evaluate(pdc_var_type_t type, const void *data, uint64_t n,
+                                        region_list_t *region, size_t unit_size, pdc_query_op_t lo_op,
+                                        const void *lo, pdc_query_op_t hi_op, const void *hi,
+                                        region_list_t *region_constraint, pdc_query_combine_op_t combine_op,
+                                        pdc_selection_t *sel);
+
+#endif /* PDC_SERVER_QUERY_KERNEL_H */
@@ -0,0 +1,42 @@
+#ifndef PDC_SERVER_QUERY_POOL_H
+#define PDC_SERVER_QUERY_POOL_H
+
+#include "pdc_client_server_common.h"
+
+/*
+ * Worker pool for query evaluation on a data server.
+ *
+ * The storage regions of a constraint are independent, each worker reads the data of a region and scans it
+ * into a match mask, so the read of one region overlaps with the scan of the others. The masks are then
+ * combined with the selection in region order on the calling thread, and the coordinates of the hits are
+ * written in parallel again.
+ */
+
+// Default number of query worker threads, can be changed with the PDC_SERVER_QUERY_NTHREAD environment
+// variable, 0 evaluates queries on the calling thread.
+#define PDC_SERVER_QUERY_NTHREAD 4
+
+typedef void (*pdc_server_query_job_func)(void *arg);
+
+/*
+ * Start the query workers.
+ */
+perr_t PDC_Server_query_pool_init();
+
+/*
+ * Wait for outstanding jobs and stop the query workers.
+ */
+perr_t PDC_Server_query_pool_finalize();
+
+/*
+ * Return the number of query workers, 0 if jobs run on the calling thread.
+ */
+int PDC_Server_query_pool_nthread();
+
+/*
+ * Run func on n arguments stored arg_size bytes apart from args, and wait until all calls returned.
+ * Without workers, the calls are made in order on the calling thread.
+ */
+void PDC_Server_query_pool_run(pdc_server_query_job_func func, void *args, size_t n, size_t arg_size);
+
+#endif /* PDC_SERVER_QUERY_POOL_H */
@@ -18,23 +18,27 @@
 #define PDC_MERGE_FAILED           4
 #define PDC_MERGE_SUCCESS          5
 
-pthread_mutex_t pdc_obj_cache_list_mutex;
-
 int   PDC_region_server_cache_init();
 int   PDC_region_server_cache_finalize();
 int   PDC_region_cache_flush_all();
 int   PDC_region_cache_flush(uint64_t obj_id);
+int   PDC_region_cache_free();
 int   PDC_region_fetch(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
                        struct pdc_region_info *region_info, void *buf, size_t unit);
 int   PDC_region_cache_register(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims, const char *buf,
                                 size_t buf_size, const uint64_t *offset, const uint64_t *size, int ndim,
                                 size_t unit);
 void *PDC_region_cache_clock_cycle(void *ptr);
+// Hold back the storage I/O of the cache, which changes the storage regions and appends to the metadata log.
+// trylock returns 0 when the lock was taken.
+int  PDC_region_cache_io_trylock();
+void PDC_region_cache_io_unlock();
 
 perr_t PDC_transfer_request_data_read_from(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
                                            struct pdc_region_info *region_info, void *buf, size_t unit);
 perr_t PDC_transfer_request_data_write_out(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
-                                           struct pdc_region_info *region_info, void *buf, size_t unit);
+                                           struct pdc_region_info *region_info, void *buf, size_t unit,
+                                           pdc_var_type_t data_type);
 
 #endif
 
@@ -0,0 +1,112 @@
+#ifndef PDC_SERVER_REGION_IO_H
+#define PDC_SERVER_REGION_IO_H
+
+#include "pdc_client_server_common.h"
+
+/*
+ * Storage backend used by PDC_Server_transfer_request_io for the flattened file layout, and by
+ * PDC_Server_data_write_out / PDC_Server_data_read_from for the part of a request that overlaps a stored
+ * region without covering whole rows of it.
+ * PDC_SERVER_IO_POSIX is the original lseek + read/write per row path.
+ * PDC_SERVER_IO_VECTOR turns a region into file extents, fuses the ones that are adjacent in both the file
+ * and the buffer and submits every run of nearby extents with a single preadv/pwritev call.
+ * The backend can be selected with the PDC_SERVER_IO_BACKEND environment variable ("posix" or "vector").
+ */
+typedef enum { PDC_SERVER_IO_POSIX = 0, PDC_SERVER_IO_VECTOR = 1 } pdc_server_io_backend_t;
+
+// Number of slots in the file descriptor cache.
+#define PDC_SERVER_IO_FD_CACHE_SIZE 256
+
+// Extents separated by at most this many bytes go in one preadv/pwritev call, the gap is transferred too.
+#define PDC_SERVER_IO_SIEVE_GAP 4096
+// Largest file range of such a call, a write reads the range first to write the gaps back unchanged.
+#define PDC_SERVER_IO_SIEVE_SPAN (16 * 1048576)
+
+/*
+ * A contiguous piece of a region in the file and its location in the user buffer.
+ */
+typedef struct pdc_server_io_extent {
+    uint64_t file_offset;
+    uint64_t length;
+    char *   buf;
+} pdc_server_io_extent;
+
+// Default number of I/O worker threads, can be changed with the PDC_SERVER_IO_NTHREAD environment variable.
+#define PDC_SERVER_IO_NTHREAD 4
+
+/*
+ * A storage job handed to the I/O workers. run is called on a worker thread, complete is called later on the
+ * Mercury progress thread by PDC_Server_io_progress, so it can issue HG_Bulk_transfer and HG_Respond.
+ */
+typedef void (*pdc_server_io_job_func)(void *arg);
+
+/*
+ * Select the backend, initialize the file descriptor cache and start the I/O workers.
+ */
+perr_t PDC_Server_io_init();
+
+/*
+ * Wait for outstanding jobs, stop the I/O workers and close all cached file descriptors.
+ */
+perr_t PDC_Server_io_finalize();
+
+/*
+ * Queue a storage job. Without workers, or without the server cache, the job runs and completes inline.
+ */
+perr_t PDC_Server_io_submit(pdc_server_io_job_func run, pdc_server_io_job_func complete, void *arg);
+
+/*
+ * Call the completion functions of finished jobs. Must be called from the Mercury progress thread.
+ * Return the number of completed jobs.
+ */
+int PDC_Server_io_progress();
+
+/*
+ * Return the number of submitted jobs that have not completed yet.
+ */
+int PDC_Server_io_pending();
+
+/*
+ * Return the backend selected at init time.
+ */
+pdc_server_io_backend_t PDC_Server_io_backend();
+
+/*
+ * Get a file descriptor for the data file of an object. Descriptors are cached per object, so repeated
+ * transfers to one object do not reopen the file. Every successful call must be paired with
+ * PDC_Server_io_fd_release.
+ * Return -1 if the file cannot be opened.
+ */
+int PDC_Server_io_fd_get(uint64_t obj_id, const char *path);
+
+/*
+ * Release a file descriptor returned by PDC_Server_io_fd_get.
+ */
+void PDC_Server_io_fd_release(uint64_t obj_id, int fd);
+
+/*
+ * Split a box into file extents. The file at file_offset holds the block starting at file_start with
+ * file_count elements per dimension, buf holds the block starting at buf_start with buf_count elements per
+ * dimension, both in row-major order, and both contain the box. Rows that are contiguous in both the file
+ * and buf are fused into one extent.
+ * Return the number of extents, sorted by file offset, *extents must be freed by the caller.
+ */
+size_t PDC_Server_io_box_extents(int ndim, uint64_t file_offset, const uint64_t *file_start,
+                                 const uint64_t *file_count, char *buf, const uint64_t *buf_start,
+                                 const uint64_t *buf_count, const uint64_t *box_offset,
+                                 const uint64_t *box_size, size_t unit, pdc_server_io_extent **extents);
+
+/*
+ * Split a region of an object stored in row-major order into file extents, buf holds the region.
+ * Return the number of extents, *extents must be freed by the caller.
+ */
+size_t PDC_Server_io_region_extents(int obj_ndim, const uint64_t *obj_dims, struct pdc_region_info *region_info,
+                                    char *buf, size_t unit, pdc_server_io_extent **extents);
+
+/*
+ * Read or write extents sorted by file offset. Extents that are adjacent in the file, or separated by at most
+ * PDC_SERVER_IO_SIEVE_GAP bytes, are submitted together with one preadv/pwritev call.
+ */
+perr_t PDC_Server_io_extents(int fd, pdc_server_io_extent *extents, size_t n_extents, int is_write);
+
+#endif /* PDC_SERVER_REGION_IO_H */
@@ -1,15 +1,16 @@
 #include "pdc_region.h"
 
 typedef struct transfer_request_all_data {
-    uint64_t **obj_dims;
-    uint64_t **remote_offset;
-    uint64_t **remote_length;
-    pdcid_t *  obj_id;
-    int *      obj_ndim;
-    size_t *   unit;
-    int *      remote_ndim;
-    char **    data_buf;
-    int        n_objs;
+    uint64_t **     obj_dims;
+    uint64_t **     remote_offset;
+    uint64_t **     remote_length;
+    pdcid_t *       obj_id;
+    int *           obj_ndim;
+    size_t *        unit;
+    pdc_var_type_t *obj_type;
+    int *           remote_ndim;
+    char **         data_buf;
+    int             n_objs;
 } transfer_request_all_data;
 
 typedef struct pdc_transfer_request_status {
@@ -76,7 +77,7 @@ pdcid_t PDC_transfer_request_id_register();
 
 perr_t PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
                                       struct pdc_region_info *region_info, void *buf, size_t unit,
-                                      int is_write);
+                                      pdc_var_type_t data_type, int is_write);
 
 int clean_write_bulk_data(transfer_request_all_data *request_data);
 
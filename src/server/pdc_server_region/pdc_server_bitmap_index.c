@@ -0,0 +1,484 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pdc_server_bitmap_index.h"
+
+#define PDC_BITMAP_INDEX_MAGIC      "PDCBMIDX"
+#define PDC_BITMAP_INDEX_VERSION    1
+#define PDC_BITMAP_INDEX_SAMPLE     16384
+#define PDC_BITMAP_INDEX_READ_BATCH 1024
+
+#define PDC_BITMAP_INDEX_NONE    0
+#define PDC_BITMAP_INDEX_ALL     1
+#define PDC_BITMAP_INDEX_PARTIAL 2
+
+#define PDC_BITMAP_INDEX_OP(v, op, b)                                                                        \
+    ((op) == PDC_GT    ? (v) > (b)                                                                           \
+     : (op) == PDC_GTE ? (v) >= (b)                                                                          \
+     : (op) == PDC_LT  ? (v) < (b)                                                                           \
+     : (op) == PDC_LTE ? (v) <= (b)                                                                          \
+                       : (v) == (b))
+
+#define PDC_BITMAP_INDEX_MATCH(v, lo_op, lo, hi_op, hi)                                                      \
+    (PDC_BITMAP_INDEX_OP(v, lo_op, lo) && ((hi_op) == PDC_OP_NONE || PDC_BITMAP_INDEX_OP(v, hi_op, hi)))
+
+// True if no value in [min, max] passes the operator, also with a NaN bound
+#define PDC_BITMAP_INDEX_FAILS(min, max, op, b)                                                              \
+    ((op) == PDC_GT    ? !((max) > (b))                                                                      \
+     : (op) == PDC_GTE ? !((max) >= (b))                                                                     \
+     : (op) == PDC_LT  ? !((min) < (b))                                                                      \
+     : (op) == PDC_LTE ? !((min) <= (b))                                                                     \
+                       : !((min) <= (b) && (b) <= (max)))
+
+typedef struct pdc_bitmap_index_funcs_t {
+    int (*cmp)(const void *a, const void *b);
+    int (*assign)(pdc_bitmap_index_t *idx, const void *data, const void *bounds, int nbound);
+    int (*classify)(const void *min, const void *max, pdc_query_op_t lo_op, const void *lo,
+                    pdc_query_op_t hi_op, const void *hi);
+    uint64_t (*refine)(const pdc_roaring_t *bin, const void *data, pdc_query_op_t lo_op, const void *lo,
+                       pdc_query_op_t hi_op, const void *hi, uint64_t *mask);
+} pdc_bitmap_index_funcs_t;
+
+/*
+ * Per type functions. NaN values are in no bin, like the scan kernels never match them.
+ */
+#define PDC_BITMAP_INDEX_FUNCS(TYPE, NAME)                                                                   \
+    static int pdc_bitmap_index_cmp_##NAME(const void *a, const void *b)                                     \
+    {                                                                                                        \
+        TYPE x = *(const TYPE *)a, y = *(const TYPE *)b;                                                     \
+        return (x > y) - (x < y);                                                                            \
+    }                                                                                                        \
+                                                                                                             \
+    static int pdc_bitmap_index_assign_##NAME(pdc_bitmap_index_t *idx, const void *data, const void *bounds, \
+                                              int nbound)                                                    \
+    {                                                                                                        \
+        const TYPE *d = (const TYPE *)data, *b = (const TYPE *)bounds;                                       \
+        TYPE *      bin_min = (TYPE *)idx->bin_min, *bin_max = (TYPE *)idx->bin_max, v;                      \
+        uint64_t    i;                                                                                       \
+        int         lo, hi, mid;                                                                             \
+                                                                                                             \
+        for (i = 0; i < idx->n; i++) {                                                                       \
+            v = d[i];                                                                                        \
+            if (v != v)                                                                                      \
+                continue;                                                                                    \
+            lo = 0;                                                                                          \
+            hi = nbound;                                                                                     \
+            while (lo < hi) {                                                                                \
+                mid = (lo + hi) / 2;                                                                         \
+                if (b[mid] <= v)                                                                             \
+                    lo = mid + 1;                                                                            \
+                else                                                                                         \
+                    hi = mid;                                                                                \
+            }                                                                                                \
+            if (pdc_roaring_cardinality(idx->bins[lo]) == 0) {                                               \
+                bin_min[lo] = v;                                                                             \
+                bin_max[lo] = v;                                                                             \
+            }                                                                                                \
+            else if (v < bin_min[lo])                                                                        \
+                bin_min[lo] = v;                                                                             \
+            else if (v > bin_max[lo])                                                                        \
+                bin_max[lo] = v;                                                                             \
+            if (pdc_roaring_add(idx->bins[lo], i) != 0)                                                      \
+                return -1;                                                                                   \
+        }                                                                                                    \
+        return 0;                                                                                            \
+    }                                                                                                        \
+                                                                                                             \
+    static int pdc_bitmap_index_classify_##NAME(const void *min, const void *max, pdc_query_op_t lo_op,      \
+                                                const void *lo, pdc_query_op_t hi_op, const void *hi)        \
+    {                                                                                                        \
+        TYPE mn = *(const TYPE *)min, mx = *(const TYPE *)max, l = *(const TYPE *)lo;                        \
+        TYPE h = hi_op == PDC_OP_NONE ? l : *(const TYPE *)hi;                                               \
+                                                                                                             \
+        /* The constraint selects an interval, so it holds for all values between two that match */        \
+        if (PDC_BITMAP_INDEX_MATCH(mn, lo_op, l, hi_op, h) &&                                                \
+            PDC_BITMAP_INDEX_MATCH(mx, lo_op, l, hi_op, h))                                                  \
+            return PDC_BITMAP_INDEX_ALL;                                                                     \
+        if (PDC_BITMAP_INDEX_FAILS(mn, mx, lo_op, l) ||                                                      \
+            (hi_op != PDC_OP_NONE && PDC_BITMAP_INDEX_FAILS(mn, mx, hi_op, h)))                              \
+            return PDC_BITMAP_INDEX_NONE;                                                                    \
+        return PDC_BITMAP_INDEX_PARTIAL;                                                                     \
+    }                                                                                                        \
+                                                                                                             \
+    static uint64_t pdc_bitmap_index_refine_##NAME(const pdc_roaring_t *bin, const void *data,               \
+                                                   pdc_query_op_t lo_op, const void *lo,                     \
+                                                   pdc_query_op_t hi_op, const void *hi, uint64_t *mask)     \
+    {                                                                                                        \
+        const TYPE *       d = (const TYPE *)data;                                                           \
+        TYPE               l = *(const TYPE *)lo, h = hi_op == PDC_OP_NONE ? l : *(const TYPE *)hi;          \
+        pdc_roaring_iter_t iter;                                                                             \
+        uint64_t           buf[PDC_BITMAP_INDEX_READ_BATCH], nmatch = 0;                                     \
+        size_t             nread, k;                                                                         \
+                                                                                                             \
+        pdc_roaring_iter_init(bin, &iter);                                                                   \
+        while ((nread = pdc_roaring_iter_read(&iter, buf, PDC_BITMAP_INDEX_READ_BATCH)) > 0) {               \
+            for (k = 0; k < nread; k++) {                                                                    \
+                if (PDC_BITMAP_INDEX_MATCH(d[buf[k]], lo_op, l, hi_op, h)) {                                 \
+                    mask[buf[k] / 64] |= 1ULL << (buf[k] % 64);                                              \
+                    nmatch++;                                                                                \
+                }                                                                                            \
+            }                                                                                                \
+        }                                                                                                    \
+        return nmatch;                                                                                       \
+    }                                                                                                        \
+                                                                                                             \
+    static const pdc_bitmap_index_funcs_t pdc_bitmap_index_##NAME = {                                        \
+        pdc_bitmap_index_cmp_##NAME, pdc_bitmap_index_assign_##NAME, pdc_bitmap_index_classify_##NAME,      \
+        pdc_bitmap_index_refine_##NAME};
+
+PDC_BITMAP_INDEX_FUNCS(float, float)
+PDC_BITMAP_INDEX_FUNCS(double, double)
+PDC_BITMAP_INDEX_FUNCS(int, int)
+PDC_BITMAP_INDEX_FUNCS(uint32_t, uint)
+PDC_BITMAP_INDEX_FUNCS(int64_t, int64)
+PDC_BITMAP_INDEX_FUNCS(uint64_t, uint64)
+
+static const pdc_bitmap_index_funcs_t *
+pdc_bitmap_index_funcs(pdc_var_type_t type)
+{
+    switch (type) {
+        case PDC_FLOAT:
+            return &pdc_bitmap_index_float;
+        case PDC_DOUBLE:
+            return &pdc_bitmap_index_double;
+        case PDC_INT:
+            return &pdc_bitmap_index_int;
+        case PDC_UINT:
+            return &pdc_bitmap_index_uint;
+        case PDC_INT64:
+            return &pdc_bitmap_index_int64;
+        case PDC_UINT64:
+            return &pdc_bitmap_index_uint64;
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * The bounds of a range can come in either order, return 0 if the kernels do not support the operators
+ */
+static int
+pdc_bitmap_index_normalize(pdc_query_op_t *lo_op, const void **lo, pdc_query_op_t *hi_op, const void **hi)
+{
+    pdc_query_op_t tmp_op;
+    const void *   tmp;
+
+    if (*hi_op == PDC_OP_NONE)
+        return *lo_op >= PDC_GT && *lo_op <= PDC_EQ;
+
+    if (*lo_op == PDC_LT || *lo_op == PDC_LTE) {
+        tmp_op = *lo_op;
+        *lo_op = *hi_op;
+        *hi_op = tmp_op;
+        tmp    = *lo;
+        *lo    = *hi;
+        *hi    = tmp;
+    }
+    return (*lo_op == PDC_GT || *lo_op == PDC_GTE) && (*hi_op == PDC_LT || *hi_op == PDC_LTE);
+}
+
+static pdc_bitmap_index_t *
+pdc_bitmap_index_alloc(pdc_var_type_t dtype, uint64_t n, int nbin)
+{
+    pdc_bitmap_index_t *idx;
+    int                 i;
+
+    idx = (pdc_bitmap_index_t *)calloc(1, sizeof(pdc_bitmap_index_t));
+    if (idx == NULL)
+        return NULL;
+    idx->dtype     = dtype;
+    idx->type_size = PDC_get_var_type_size(dtype);
+    idx->n         = n;
+    idx->nbin      = nbin;
+    idx->bin_min   = (char *)calloc(nbin, idx->type_size);
+    idx->bin_max   = (char *)calloc(nbin, idx->type_size);
+    idx->bins      = (pdc_roaring_t **)calloc(nbin, sizeof(pdc_roaring_t *));
+    if (idx->bin_min == NULL || idx->bin_max == NULL || idx->bins == NULL) {
+        PDC_Server_bitmap_index_free(idx);
+        return NULL;
+    }
+    for (i = 0; i < nbin; i++) {
+        idx->bins[i] = pdc_roaring_new();
+        if (idx->bins[i] == NULL) {
+            PDC_Server_bitmap_index_free(idx);
+            return NULL;
+        }
+    }
+    return idx;
+}
+
+pdc_bitmap_index_t *
+PDC_Server_bitmap_index_build(pdc_var_type_t dtype, const void *data, uint64_t n, int nbin)
+{
+    const pdc_bitmap_index_funcs_t *funcs = pdc_bitmap_index_funcs(dtype);
+    pdc_bitmap_index_t *            idx   = NULL;
+    char *                          sample = NULL, *bounds = NULL;
+    size_t                          type_size;
+    uint64_t                        nsample = 0, i, step;
+    int                             nbound = 0, ndistinct, j;
+
+    if (funcs == NULL || data == NULL || n == 0 || nbin < 1)
+        return NULL;
+    type_size = PDC_get_var_type_size(dtype);
+
+    // Bin boundaries are taken from an evenly spaced sample of the values
+    step   = n > PDC_BITMAP_INDEX_SAMPLE ? n / PDC_BITMAP_INDEX_SAMPLE : 1;
+    sample = (char *)malloc(PDC_BITMAP_INDEX_SAMPLE * type_size);
+    bounds = (char *)malloc(nbin * type_size);
+    if (sample == NULL || bounds == NULL)
+        goto done;
+    for (i = 0; i < n && nsample < PDC_BITMAP_INDEX_SAMPLE; i += step) {
+        // NaN is in no bin and would break the ordering of the sample
+        if (dtype == PDC_FLOAT && *((const float *)data + i) != *((const float *)data + i))
+            continue;
+        if (dtype == PDC_DOUBLE && *((const double *)data + i) != *((const double *)data + i))
+            continue;
+        memcpy(sample + nsample * type_size, (const char *)data + i * type_size, type_size);
+        nsample++;
+    }
+    qsort(sample, nsample, type_size, funcs->cmp);
+
+    // Few distinct values get a bin each, otherwise the boundaries are quantiles of the sample
+    ndistinct = nsample > 0 ? 1 : 0;
+    for (i = 1; i < nsample && ndistinct <= nbin; i++) {
+        if (funcs->cmp(sample + i * type_size, sample + (i - 1) * type_size) != 0)
+            ndistinct++;
+    }
+    if (ndistinct <= nbin) {
+        for (i = 1; i < nsample; i++) {
+            if (funcs->cmp(sample + i * type_size, sample + (i - 1) * type_size) != 0)
+                memcpy(bounds + (nbound++) * type_size, sample + i * type_size, type_size);
+        }
+    }
+    else {
+        for (j = 1; j < nbin; j++) {
+            i = (uint64_t)j * nsample / nbin;
+            if (nbound > 0 && funcs->cmp(sample + i * type_size, bounds + (nbound - 1) * type_size) <= 0)
+                continue;
+            memcpy(bounds + (nbound++) * type_size, sample + i * type_size, type_size);
+        }
+    }
+
+    idx = pdc_bitmap_index_alloc(dtype, n, nbound + 1);
+    if (idx == NULL)
+        goto done;
+    if (funcs->assign(idx, data, bounds, nbound) != 0) {
+        PDC_Server_bitmap_index_free(idx);
+        idx = NULL;
+    }
+
+done:
+    free(sample);
+    free(bounds);
+    return idx;
+}
+
+void
+PDC_Server_bitmap_index_free(pdc_bitmap_index_t *idx)
+{
+    int i;
+
+    if (idx == NULL)
+        return;
+    if (idx->bins != NULL) {
+        for (i = 0; i < idx->nbin; i++)
+            pdc_roaring_free(idx->bins[i]);
+    }
+    free(idx->bins);
+    free(idx->bin_min);
+    free(idx->bin_max);
+    free(idx);
+}
+
+/*
+ * File layout: magic, version, type, number of elements, number of bins, the bin minima and maxima, then
+ * the size and the serialized bitmap of each bin
+ */
+perr_t
+PDC_Server_bitmap_index_write(pdc_bitmap_index_t *idx, const char *path)
+{
+    perr_t   ret_value = SUCCEED;
+    FILE *   fp        = NULL;
+    char *   buf       = NULL;
+    uint64_t size, alloc = 0;
+    int32_t  version = PDC_BITMAP_INDEX_VERSION, dtype = idx->dtype, nbin = idx->nbin;
+    int      i;
+
+    FUNC_ENTER(NULL);
+
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        printf("==PDC_SERVER[%d]: %s - unable to open file [%s]\n", pdc_server_rank_g, __func__, path);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    if (fwrite(PDC_BITMAP_INDEX_MAGIC, 1, 8, fp) != 8 || fwrite(&version, sizeof(int32_t), 1, fp) != 1 ||
+        fwrite(&dtype, sizeof(int32_t), 1, fp) != 1 || fwrite(&idx->n, sizeof(uint64_t), 1, fp) != 1 ||
+        fwrite(&nbin, sizeof(int32_t), 1, fp) != 1 ||
+        fwrite(idx->bin_min, idx->type_size, nbin, fp) != (size_t)nbin ||
+        fwrite(idx->bin_max, idx->type_size, nbin, fp) != (size_t)nbin) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    for (i = 0; i < nbin; i++) {
+        size = pdc_roaring_serialized_size(idx->bins[i]);
+        if (size > alloc) {
+            free(buf);
+            alloc = size;
+            buf   = (char *)malloc(alloc);
+            if (buf == NULL) {
+                ret_value = FAIL;
+                goto done;
+            }
+        }
+        pdc_roaring_serialize(idx->bins[i], buf);
+        if (fwrite(&size, sizeof(uint64_t), 1, fp) != 1 || fwrite(buf, 1, size, fp) != size) {
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+
+done:
+    if (fp != NULL && fclose(fp) != 0)
+        ret_value = FAIL;
+    if (ret_value != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - error writing [%s]\n", pdc_server_rank_g, __func__, path);
+    free(buf);
+    FUNC_LEAVE(ret_value);
+}
+
+pdc_bitmap_index_t *
+PDC_Server_bitmap_index_read(const char *path)
+{
+    pdc_bitmap_index_t *idx = NULL;
+    FILE *              fp;
+    char                magic[8], *buf = NULL;
+    uint64_t            n, size, alloc = 0;
+    int32_t             version, dtype, nbin;
+    size_t              used;
+    int                 i;
+
+    fp = fopen(path, "r");
+    if (fp == NULL)
+        return NULL;
+
+    if (fread(magic, 1, 8, fp) != 8 || memcmp(magic, PDC_BITMAP_INDEX_MAGIC, 8) != 0 ||
+        fread(&version, sizeof(int32_t), 1, fp) != 1 || version != PDC_BITMAP_INDEX_VERSION ||
+        fread(&dtype, sizeof(int32_t), 1, fp) != 1 || pdc_bitmap_index_funcs(dtype) == NULL ||
+        fread(&n, sizeof(uint64_t), 1, fp) != 1 || fread(&nbin, sizeof(int32_t), 1, fp) != 1 || nbin < 1 ||
+        nbin > 1 << 20)
+        goto error;
+
+    idx = pdc_bitmap_index_alloc(dtype, n, nbin);
+    if (idx == NULL)
+        goto error;
+    if (fread(idx->bin_min, idx->type_size, nbin, fp) != (size_t)nbin ||
+        fread(idx->bin_max, idx->type_size, nbin, fp) != (size_t)nbin)
+        goto error;
+
+    for (i = 0; i < nbin; i++) {
+        if (fread(&size, sizeof(uint64_t), 1, fp) != 1 || size > n * sizeof(uint64_t) + (1 << 20))
+            goto error;
+        if (size > alloc) {
+            free(buf);
+            alloc = size;
+            buf   = (char *)malloc(alloc);
+            if (buf == NULL)
+                goto error;
+        }
+        if (fread(buf, 1, size, fp) != size)
+            goto error;
+        pdc_roaring_free(idx->bins[i]);
+        idx->bins[i] = pdc_roaring_deserialize(buf, size, &used);
+        if (idx->bins[i] == NULL || used != size)
+            goto error;
+    }
+
+    fclose(fp);
+    free(buf);
+    return idx;
+
+error:
+    printf("==PDC_SERVER[%d]: %s - invalid index file [%s]\n", pdc_server_rank_g, __func__, path);
+    fclose(fp);
+    free(buf);
+    PDC_Server_bitmap_index_free(idx);
+    return NULL;
+}
+
+int
+PDC_Server_bitmap_index_needs_data(pdc_bitmap_index_t *idx, pdc_query_op_t lo_op, const void *lo,
+                                   pdc_query_op_t hi_op, const void *hi)
+{
+    const pdc_bitmap_index_funcs_t *funcs = pdc_bitmap_index_funcs(idx->dtype);
+    int                             i;
+
+    if (funcs == NULL || !pdc_bitmap_index_normalize(&lo_op, &lo, &hi_op, &hi))
+        return 1;
+    for (i = 0; i < idx->nbin; i++) {
+        if (pdc_roaring_cardinality(idx->bins[i]) == 0)
+            continue;
+        if (funcs->classify(idx->bin_min + i * idx->type_size, idx->bin_max + i * idx->type_size, lo_op, lo,
+                            hi_op, hi) == PDC_BITMAP_INDEX_PARTIAL)
+            return 1;
+    }
+    return 0;
+}
+
+perr_t
+PDC_Server_bitmap_index_scan(pdc_bitmap_index_t *idx, const void *data, pdc_query_op_t lo_op, const void *lo,
+                             pdc_query_op_t hi_op, const void *hi, uint64_t *mask, uint64_t *nmatch)
+{
+    perr_t                          ret_value = SUCCEED;
+    const pdc_bitmap_index_funcs_t *funcs     = pdc_bitmap_index_funcs(idx->dtype);
+    int                             i, kind;
+
+    FUNC_ENTER(NULL);
+
+    *nmatch = 0;
+    if (funcs == NULL || !pdc_bitmap_index_normalize(&lo_op, &lo, &hi_op, &hi)) {
+        printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    memset(mask, 0, (idx->n + 63) / 64 * sizeof(uint64_t));
+    for (i = 0; i < idx->nbin; i++) {
+        if (pdc_roaring_cardinality(idx->bins[i]) == 0)
+            continue;
+        kind = funcs->classify(idx->bin_min + i * idx->type_size, idx->bin_max + i * idx->type_size, lo_op,
+                               lo, hi_op, hi);
+        if (kind == PDC_BITMAP_INDEX_ALL) {
+            pdc_roaring_or_into_mask(idx->bins[i], mask, idx->n);
+            *nmatch += pdc_roaring_cardinality(idx->bins[i]);
+        }
+        else if (kind == PDC_BITMAP_INDEX_PARTIAL) {
+            if (data == NULL) {
+                printf("==PDC_SERVER[%d]: %s - data needed to evaluate the index!\n", pdc_server_rank_g,
+                       __func__);
+                ret_value = FAIL;
+                goto done;
+            }
+            *nmatch += funcs->refine(idx->bins[i], data, lo_op, lo, hi_op, hi, mask);
+        }
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+size_t
+PDC_Server_bitmap_index_size_in_bytes(pdc_bitmap_index_t *idx)
+{
+    size_t size;
+    int    i;
+
+    if (idx == NULL)
+        return 0;
+    size = sizeof(pdc_bitmap_index_t) + 2 * idx->nbin * idx->type_size + idx->nbin * sizeof(pdc_roaring_t *);
+    for (i = 0; i < idx->nbin; i++)
+        size += pdc_roaring_size_in_bytes(idx->bins[i]);
+    return size;
+}
@@ -50,7 +50,12 @@
 #include "pdc_region.h"
 #include "pdc_client_server_common.h"
 #include "pdc_server_data.h"
+#include "pdc_server_query_kernel.h"
+#include "pdc_server_bitmap_index.h"
+#include "pdc_server_query_pool.h"
+#include "pdc_server_region_io.h"
 #include "pdc_server_metadata.h"
+#include "pdc_server_metadata_wal.h"
 #include "pdc_server.h"
 #include "pdc_hist_pkg.h"
 #include "pdc_timing.h"
@@ -80,6 +85,10 @@ char     pdc_cache_file_path_g[ADDR_MAX];
 query_task_t *          query_task_list_head_g      = NULL;
 cache_storage_region_t *cache_storage_region_head_g = NULL;
 
+// Guards the zone maps and bitmap indexes of storage regions, write_out replaces them while query workers
+// read them
+static pthread_rwlock_t region_index_rwlock_g = PTHREAD_RWLOCK_INITIALIZER;
+
 static int
 fill_storage_path(char *storage_location, pdcid_t obj_id)
 {
@@ -3351,6 +3360,15 @@ PDC_Server_update_local_region_storage_loc(region_list_t *region, uint64_t obj_i
         goto done;
     }
 
+    // A storage location is only recorded once it is logged
+    if (type == PDC_UPDATE_STORAGE &&
+        PDC_Server_wal_log_region(PDC_WAL_META_REGION, obj_id, region) != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - cannot log a region of obj %" PRIu64 "\n", pdc_server_rank_g, __func__,
+               obj_id);
+        ret_value = FAIL;
+        goto done;
+    }
+
     // Find if there is the same region already stored in the metadata and update it
     DL_FOREACH(target_meta->storage_region_list_head, region_elt)
     {
@@ -3682,6 +3700,14 @@ PDC_Server_update_region_storage_meta_bulk_local(update_region_storage_meta_bulk
 
         new_region->meta   = target_meta;
         new_region->obj_id = target_meta->obj_id;
+        // The region is only recorded once it is logged
+        if (PDC_Server_wal_log_region(PDC_WAL_META_REGION, obj_id, new_region) != SUCCEED) {
+            printf("==PDC_SERVER[%d]: %s - cannot log a region of obj %" PRIu64 "\n", pdc_server_rank_g,
+                   __func__, obj_id);
+            free(new_region);
+            ret_value = FAIL;
+            goto done;
+        }
 
         // Check if we can insert without duplicate check
         if (i == 1 && target_meta->storage_region_list_head == NULL)
@@ -4569,12 +4595,6 @@ PDC_Server_posix_one_file_io(region_list_t *region_list_head)
             }
 #endif
 
-            // Generate histogram
-            if (gen_hist_g == 1) {
-                uint64_t nelem = region_elt->data_size / PDC_get_var_type_size(region_elt->meta->data_type);
-                region_elt->region_hist = PDC_gen_hist(region_elt->meta->data_type, nelem, region_elt->buf);
-            }
-
             if (is_debug_g == 1) {
                 printf("Write data offset: %" PRIu64 ", size %" PRIu64 ", to [%s]\n", offset,
                        region_elt->data_size, region_elt->storage_location);
@@ -4582,6 +4602,10 @@ PDC_Server_posix_one_file_io(region_list_t *region_list_head)
             region_elt->is_data_ready = 1;
             region_elt->offset        = offset;
 
+            // Generate the zone map, and the histogram with PDC_GEN_HIST
+            uint64_t nelem = region_elt->data_size / PDC_get_var_type_size(region_elt->meta->data_type);
+            PDC_Server_set_region_index(region_elt, region_elt->meta->data_type, nelem, region_elt->buf);
+
             ret_value = PDC_Server_update_region_storagelocation_offset(region_elt, PDC_UPDATE_STORAGE);
             if (ret_value != SUCCEED) {
                 printf("==PDC_SERVER[%d]: failed to update region storage info!\n", pdc_server_rank_g);
@@ -4717,9 +4741,55 @@ done:
     FUNC_LEAVE(ret_value);
 }
 
+/*
+ * Transfer the part of a request that overlaps a stored region with the vectored backend. The rows of the
+ * overlap are gathered from or scattered to the request buffer directly, without a temporary buffer.
+ *
+ * \param  fd[IN]                File of the stored region
+ * \param  storage_region[IN]    Stored region
+ * \param  region_info[IN]       Request region
+ * \param  buf[IN/OUT]           Request buffer
+ * \param  overlap_offset[IN]    Start of the overlap
+ * \param  overlap_size[IN]      Size of the overlap
+ * \param  unit[IN]              Element size
+ * \param  is_write[IN]          1 to write the overlap, 0 to read it
+ *
+ * \return Non-negative on success/Negative on failure
+ */
+static perr_t
+PDC_Server_io_overlap(int fd, region_list_t *storage_region, struct pdc_region_info *region_info, void *buf,
+                      uint64_t *overlap_offset, uint64_t *overlap_size, size_t unit, int is_write)
+{
+    perr_t                ret_value = SUCCEED;
+    pdc_server_io_extent *extents;
+    size_t                n_extents;
+#ifdef PDC_TIMING
+    double start_posix = MPI_Wtime();
+#endif
+
+    FUNC_ENTER(NULL);
+
+    n_extents = PDC_Server_io_box_extents((int)region_info->ndim, storage_region->offset,
+                                          storage_region->start, storage_region->count, (char *)buf,
+                                          region_info->offset, region_info->size, overlap_offset,
+                                          overlap_size, unit, &extents);
+    ret_value = PDC_Server_io_extents(fd, extents, n_extents, is_write);
+    free(extents);
+
+#ifdef PDC_TIMING
+    if (is_write)
+        pdc_server_timings->PDCdata_server_write_posix += MPI_Wtime() - start_posix;
+    else
+        pdc_server_timings->PDCdata_server_read_posix += MPI_Wtime() - start_posix;
+#endif
+
+    FUNC_LEAVE(ret_value);
+}
+
 // No PDC_SERVER_CACHE
 perr_t
-PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info, void *buf, size_t unit)
+PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info, void *buf, size_t unit,
+                          pdc_var_type_t data_type)
 {
     perr_t                ret_value      = SUCCEED;
     data_server_region_t *region         = NULL;
@@ -4728,6 +4798,7 @@ PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info,
     uint64_t              i, j, pos;
     uint64_t *            overlap_offset, *overlap_size;
     char *                tmp_buf;
+    char *                region_buf;
 #if 0
     size_t                total_write_size = 0, local_write_size;
     int is_overlap;
@@ -4850,7 +4921,21 @@ PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info,
                         ret_value = FAIL;
                         goto done;
                     }
+                    // The whole region is at hand, rebuild its zone map and index from it
+                    PDC_Server_set_region_index(overlap_region, data_type, overlap_region->data_size / unit,
+                                                tmp_buf);
                     free(tmp_buf);
+                    free(overlap_offset);
+                    continue;
+                }
+                else if (PDC_Server_io_backend() == PDC_SERVER_IO_VECTOR) {
+                    ret_value = PDC_Server_io_overlap(region->fd, overlap_region, region_info, buf,
+                                                      overlap_offset, overlap_size, unit, 1);
+                    if (ret_value != SUCCEED) {
+                        printf("==PDC_SERVER[%d]: PDC_Server_io_overlap FAILED!\n", pdc_server_rank_g);
+                        ret_value = FAIL;
+                        goto done;
+                    }
                 }
                 else {
                     if (region_info->ndim == 2) {
@@ -5008,6 +5093,23 @@ PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info,
                 }
             }
             free(overlap_offset);
+
+            // The zone map and index of the overwritten region are stale, rebuild them from its new data, or
+            // drop them when the type is not known
+            region_buf = NULL;
+            if (data_type != PDC_UNKNOWN) {
+                region_buf = (char *)malloc(overlap_region->data_size);
+                if (region_buf != NULL &&
+                    pread(region->fd, region_buf, overlap_region->data_size, overlap_region->offset) !=
+                        (ssize_t)overlap_region->data_size) {
+                    printf("==PDC_SERVER[%d]: pread failed to read enough bytes\n", pdc_server_rank_g);
+                    free(region_buf);
+                    region_buf = NULL;
+                }
+            }
+            PDC_Server_set_region_index(overlap_region, data_type, overlap_region->data_size / unit,
+                                        region_buf);
+            free(region_buf);
         }
     }
     if (is_contained == 0) {
@@ -5026,8 +5128,18 @@ PDC_Server_data_write_out(uint64_t obj_id, struct pdc_region_info *region_info,
             goto done;
         }
 
-        // Store storage information
+        // Store storage information, with the zone map and index of the new region when its type is known.
+        // The region is only stored once it is logged, otherwise its data is left unreferenced in the file.
         request_region->data_size = write_size;
+        if (PDC_Server_wal_log_region(PDC_WAL_DATA_REGION, obj_id, request_region) != SUCCEED) {
+            printf("==PDC_SERVER[%d]: %s - cannot log a region of obj %" PRIu64 "\n", pdc_server_rank_g,
+                   __func__, obj_id);
+            PDC_Server_unregister_obj_region_by_pointer(region, 0);
+            free(request_region);
+            ret_value = FAIL;
+            goto done;
+        }
+        PDC_Server_set_region_index(request_region, data_type, write_size / unit, buf);
         DL_APPEND(region->region_storage_head, request_region);
         PDC_Server_unregister_obj_region_by_pointer(region, 0);
     }
@@ -5150,6 +5262,15 @@ PDC_Server_data_read_from(uint64_t obj_id, struct pdc_region_info *region_info,
 
                     free(tmp_buf);
                 }
+                else if (PDC_Server_io_backend() == PDC_SERVER_IO_VECTOR) {
+                    ret_value = PDC_Server_io_overlap(region->fd, overlap_region, region_info, buf,
+                                                      overlap_offset, overlap_size, unit, 0);
+                    if (ret_value != SUCCEED) {
+                        printf("==PDC_SERVER[%d]: PDC_Server_io_overlap FAILED!\n", pdc_server_rank_g);
+                        ret_value = FAIL;
+                        goto done;
+                    }
+                }
                 else {
                     if (region_info->ndim == 2) {
                         if (overlap_offset[1] == overlap_region->start[1] &&
@@ -5915,6 +6036,9 @@ PDC_Server_free_query_task(query_task_t *task)
         free(task->data_arr);
     if (task->n_hits_from_server)
         free(task->n_hits_from_server);
+    PDC_Server_query_bitmap_sel_free(task->bitmap_sel);
+    PDC_free_hist(task->agg.hist);
+    PDC_free_hist(task->my_agg.hist);
 
     free(task);
 }
@@ -6059,99 +6183,419 @@ PDC_Server_data_read_to_buf(region_list_t *region_list_head)
     return ret_value;
 }
 
-static int
-PDC_region_has_hits_from_hist(pdc_query_constraint_t *constraint, pdc_histogram_t *region_hist)
+#define PDC_REGION_MIN_MAX(TYPE, n, data, min, max)                                                          \
+    do {                                                                                                     \
+        uint64_t _i;                                                                                         \
+        TYPE *   _ldata = (TYPE *)(data);                                                                    \
+        TYPE     _lmin = _ldata[0], _lmax = _ldata[0];                                                       \
+        for (_i = 1; _i < (n); _i++) {                                                                       \
+            if (_ldata[_i] < _lmin)                                                                          \
+                _lmin = _ldata[_i];                                                                          \
+            if (_ldata[_i] > _lmax)                                                                          \
+                _lmax = _ldata[_i];                                                                          \
+        }                                                                                                    \
+        (min) = (double)_lmin;                                                                               \
+        (max) = (double)_lmax;                                                                               \
+    } while (0)
+
+/*
+ * Histogram of n values within [min, max], binned as by PDC_gen_hist when with_bins is 1 and the bounds
+ * differ, a single bin holding all values otherwise
+ */
+static pdc_histogram_t *
+PDC_Server_create_hist(pdc_var_type_t dtype, uint64_t n, void *data, double min, double max, int with_bins)
+{
+    pdc_histogram_t *hist = NULL;
+
+    // Equal bounds give an empty bin width, a zone map covers them
+    if (with_bins == 1 && max > min) {
+        hist = PDC_create_hist(dtype, 50, min, max);
+        if (hist != NULL && PDC_hist_incr_all(hist, dtype, n, data) == SUCCEED)
+            return hist;
+        PDC_free_hist(hist);
+    }
+
+    hist        = (pdc_histogram_t *)malloc(sizeof(pdc_histogram_t));
+    hist->dtype = dtype;
+    hist->nbin  = 1;
+    hist->incr  = 0;
+    hist->range = (double *)malloc(2 * sizeof(double));
+    hist->bin   = (uint64_t *)malloc(sizeof(uint64_t));
+    if (hist->range == NULL || hist->bin == NULL) {
+        PDC_free_hist(hist);
+        return NULL;
+    }
+    hist->range[0] = min;
+    hist->range[1] = max;
+    hist->bin[0]   = n;
+
+    return hist;
+}
+
+pdc_histogram_t *
+PDC_Server_gen_region_hist(pdc_var_type_t dtype, uint64_t n, void *data)
 {
-    pdc_query_op_t lop;
-    double         value, value2;
+    double min, max;
 
-    if (constraint == NULL || region_hist == NULL) {
-        printf("==PDC_SERVER[%d]: %s -  NULL input!\n", pdc_server_rank_g, __func__);
-        return -1;
+    if (n == 0 || data == NULL)
+        return NULL;
+
+    switch (dtype) {
+        case PDC_FLOAT:
+            PDC_REGION_MIN_MAX(float, n, data, min, max);
+            break;
+        case PDC_DOUBLE:
+            PDC_REGION_MIN_MAX(double, n, data, min, max);
+            break;
+        case PDC_INT:
+            PDC_REGION_MIN_MAX(int, n, data, min, max);
+            break;
+        case PDC_UINT:
+            PDC_REGION_MIN_MAX(uint32_t, n, data, min, max);
+            break;
+        case PDC_INT64:
+            PDC_REGION_MIN_MAX(int64_t, n, data, min, max);
+            break;
+        case PDC_UINT64:
+            PDC_REGION_MIN_MAX(uint64_t, n, data, min, max);
+            break;
+        default:
+            return NULL;
     }
-    /*
-        switch (constraint->type) {
-            case PDC_FLOAT:
-                value  = (double)(*((float *)&constraint->value));
-                value2 = (double)(*((float *)&constraint->value2));
-                break;
-            case PDC_DOUBLE:
-                value  = (double)(*((double *)&constraint->value));
-                value2 = (double)(*((double *)&constraint->value2));
-                break;
-            case PDC_INT:
-                value  = (double)(*((int *)&constraint->value));
-                value2 = (double)(*((int *)&constraint->value2));
-                break;
-            case PDC_UINT:
-                value  = (double)(*((uint32_t *)&constraint->value));
-                value2 = (double)(*((uint32_t *)&constraint->value2));
-                break;
-            case PDC_INT64:
-                value  = (double)(*((int64_t *)&constraint->value));
-                value2 = (double)(*((int64_t *)&constraint->value2));
-                break;
-            case PDC_UINT64:
-                value  = (double)(*((uint64_t *)&constraint->value));
-                value2 = (double)(*((uint64_t *)&constraint->value2));
-                break;
-            default:
-                printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
-                return -1;
-        }
-    */
+
+    // NaN makes the bounds meaningless, such a region is never pruned
+    if (min != min || max != max)
+        return NULL;
+
+    return PDC_Server_create_hist(dtype, n, data, min, max, gen_hist_g);
+}
+
+/*
+ * The bitmap index of a storage region is stored next to its data
+ */
+static void
+PDC_Server_region_bitmap_idx_path(region_list_t *region, char *path)
+{
+    snprintf(path, ADDR_MAX + 32, "%s.%" PRIu64 ".idx", region->storage_location, region->offset);
+}
+
+perr_t
+PDC_Server_set_region_index(region_list_t *region, pdc_var_type_t dtype, uint64_t n, void *data)
+{
+    perr_t              ret_value = SUCCEED;
+    pdc_histogram_t *   hist = NULL, *old_hist;
+    pdc_bitmap_index_t *idx = NULL, *old_idx;
+    char                path[ADDR_MAX + 32];
+
+    FUNC_ENTER(NULL);
+
+    // Build outside the lock, queries on other regions go on meanwhile
+    if (dtype != PDC_UNKNOWN && data != NULL) {
+        hist = PDC_Server_gen_region_hist(dtype, n, data);
+        if (gen_bitmap_idx_g == 1)
+            idx = PDC_Server_bitmap_index_build(dtype, data, n, PDC_BITMAP_INDEX_NBIN);
+    }
+
+    // The index file is replaced under the lock too, so a query never loads a stale or partial one
+    pthread_rwlock_wrlock(&region_index_rwlock_g);
+    old_hist            = region->region_hist;
+    old_idx             = (pdc_bitmap_index_t *)region->bitmap_idx;
+    region->region_hist = hist;
+    region->bitmap_idx  = idx;
+    if (region->storage_location[0] != 0) {
+        PDC_Server_region_bitmap_idx_path(region, path);
+        if (idx != NULL)
+            ret_value = PDC_Server_bitmap_index_write(idx, path);
+        else
+            unlink(path);
+    }
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+
+    PDC_free_hist(old_hist);
+    PDC_Server_bitmap_index_free(old_idx);
+
+    if (is_debug_g == 1 && idx != NULL)
+        printf("==PDC_SERVER[%d]: %s - %d bins, %zu bytes for %" PRIu64 " elements\n", pdc_server_rank_g,
+               __func__, idx->nbin, PDC_Server_bitmap_index_size_in_bytes(idx), n);
+
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * With PDC_USE_BITMAP_IDX, read the bitmap index of a storage region from disk if it is not in memory, as
+ * after a restart
+ */
+static void
+PDC_Server_load_region_bitmap_idx(region_list_t *region)
+{
+    char path[ADDR_MAX + 32];
+    int  is_loaded;
+
+    if (use_bitmap_idx_g == 0 || region->storage_location[0] == 0)
+        return;
+
+    pthread_rwlock_rdlock(&region_index_rwlock_g);
+    is_loaded = region->bitmap_idx != NULL;
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+    if (is_loaded)
+        return;
+
+    pthread_rwlock_wrlock(&region_index_rwlock_g);
+    if (region->bitmap_idx == NULL) {
+        PDC_Server_region_bitmap_idx_path(region, path);
+        region->bitmap_idx = PDC_Server_bitmap_index_read(path);
+    }
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+}
+
+/*
+ * Bitmap index of a storage region with PDC_USE_BITMAP_IDX, NULL if the region has none or it does not match
+ * the queried type. The caller holds region_index_rwlock_g.
+ */
+static pdc_bitmap_index_t *
+PDC_Server_get_region_bitmap_idx(region_list_t *region, pdc_var_type_t dtype, uint64_t n)
+{
+    pdc_bitmap_index_t *idx;
+
+    if (use_bitmap_idx_g == 0)
+        return NULL;
+
+    idx = (pdc_bitmap_index_t *)region->bitmap_idx;
+    if (idx == NULL || idx->dtype != dtype || idx->n != n)
+        return NULL;
+    return idx;
+}
+
+/*
+ * Operands of a constraint as PDC_Server_query_evaluate_merge_opt passes them to the scan kernels, lo and hi
+ * hold a value of the constraint type. Return 0 if the type is not supported.
+ */
+static int
+PDC_constraint_kernel_operands(pdc_query_constraint_t *constraint, pdc_query_op_t *lo_op, uint64_t *lo,
+                               pdc_query_op_t *hi_op, uint64_t *hi)
+{
+    if (constraint->is_range != 1) {
+        *lo_op = constraint->op;
+        *hi_op = PDC_OP_NONE;
+        memcpy(lo, &constraint->value, sizeof(uint64_t));
+        return 1;
+    }
+
+    *lo_op = constraint->op;
+    *hi_op = constraint->op2;
     switch (constraint->type) {
         case PDC_FLOAT:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(float *)lo = (float)constraint->value;
+            *(float *)hi = (float)constraint->value2;
             break;
         case PDC_DOUBLE:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(double *)lo = constraint->value;
+            *(double *)hi = constraint->value2;
             break;
         case PDC_INT:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(int *)lo = (int)constraint->value;
+            *(int *)hi = (int)constraint->value2;
             break;
         case PDC_UINT:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(uint32_t *)lo = (uint32_t)constraint->value;
+            *(uint32_t *)hi = (uint32_t)constraint->value2;
             break;
-
         case PDC_INT64:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(int64_t *)lo = (int64_t)constraint->value;
+            *(int64_t *)hi = (int64_t)constraint->value2;
             break;
         case PDC_UINT64:
-            value  = (double)constraint->value;
-            value2 = (double)constraint->value2;
+            *(uint64_t *)lo = (uint64_t)constraint->value;
+            *(uint64_t *)hi = (uint64_t)constraint->value2;
             break;
         default:
-            printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
-            return -1;
+            return 0;
     }
+    return 1;
+}
 
-    lop = constraint->op;
+/*
+ * Check if the data of a storage region is needed to evaluate a constraint, it is not when the bitmap index
+ * of the region answers it alone
+ */
+static int
+PDC_region_needs_data(pdc_query_constraint_t *constraint, region_list_t *region, size_t unit_size)
+{
+    pdc_bitmap_index_t *idx;
+    pdc_query_op_t      lo_op, hi_op;
+    uint64_t            lo, hi, nelem;
+    size_t              i;
+    int                 ret = 1;
 
-    if (constraint->is_range == 1) {
-        if (value > region_hist->range[region_hist->nbin * 2 - 1] || value2 < region_hist->range[0]) {
+    if (use_bitmap_idx_g == 0 || unit_size == 0 || region->ndim == 0)
+        return 1;
+
+    nelem = region->count[0] / unit_size;
+    for (i = 1; i < region->ndim; i++)
+        nelem *= region->count[i] / unit_size;
+
+    PDC_Server_load_region_bitmap_idx(region);
+    pthread_rwlock_rdlock(&region_index_rwlock_g);
+    idx = PDC_Server_get_region_bitmap_idx(region, constraint->type, nelem);
+    if (idx != NULL && PDC_constraint_kernel_operands(constraint, &lo_op, &lo, &hi_op, &hi) == 1)
+        ret = PDC_Server_bitmap_index_needs_data(idx, lo_op, &lo, hi_op, &hi);
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+
+    return ret;
+}
+
+/*
+ * Value of a constraint operand, decoded the same way as the evaluation in
+ * PDC_Server_query_evaluate_merge_opt does it
+ */
+static double
+PDC_constraint_operand(pdc_var_type_t type, double *value, int is_range)
+{
+    switch (type) {
+        case PDC_FLOAT:
+            return is_range ? (double)(float)*value : (double)*((float *)value);
+        case PDC_DOUBLE:
+            return *value;
+        case PDC_INT:
+            return is_range ? (double)(int)*value : (double)*((int *)value);
+        case PDC_UINT:
+            return is_range ? (double)(uint32_t)*value : (double)*((uint32_t *)value);
+        case PDC_INT64:
+            return is_range ? (double)(int64_t)*value : (double)*((int64_t *)value);
+        case PDC_UINT64:
+            return is_range ? (double)(uint64_t)*value : (double)*((uint64_t *)value);
+        default:
             return 0;
-        }
     }
-    else {
-        // one sided
+}
 
-        if (lop == PDC_LT || lop == PDC_LTE) {
-            if (value < region_hist->range[0])
-                return 0;
+/*
+ * Check if [lo, hi] and the values selected by a constraint interval intersect
+ */
+static int
+PDC_constraint_interval_overlap(double qlo, int qlo_open, double qhi, int qhi_open, double lo, double hi)
+{
+    if (qlo > hi || (qlo == hi && qlo_open))
+        return 0;
+    if (qhi < lo || (qhi == lo && qhi_open))
+        return 0;
+    return 1;
+}
+
+/*
+ * Check the zone map and histogram of a region against a constraint. The outer bounds of the histogram
+ * are the exact minimum and maximum of the region, a bin without values rules out the part of the
+ * query that falls in it. Returns 0 only if the region has no hit for sure.
+ */
+static int
+PDC_region_has_hits_from_hist(pdc_query_constraint_t *constraint, pdc_histogram_t *region_hist)
+{
+    pdc_query_op_t ops[2];
+    double         values[2], value, qlo = -HUGE_VAL, qhi = HUGE_VAL;
+    int            nop, is_exact, qlo_open = 0, qhi_open = 0, first, last, i, k;
+
+    if (constraint == NULL || region_hist == NULL || region_hist->nbin <= 0 ||
+        region_hist->dtype != constraint->type)
+        return 1;
+    if (constraint->type != PDC_FLOAT && constraint->type != PDC_DOUBLE && constraint->type != PDC_INT &&
+        constraint->type != PDC_UINT && constraint->type != PDC_INT64 && constraint->type != PDC_UINT64)
+        return 1;
+
+    // 64-bit integers are rounded when converted to double, only closed comparisons stay safe
+    is_exact = constraint->type != PDC_INT64 && constraint->type != PDC_UINT64;
+
+    nop       = 1;
+    ops[0]    = constraint->op;
+    values[0] = PDC_constraint_operand(constraint->type, &constraint->value, constraint->is_range == 1);
+    if (constraint->is_range == 1) {
+        nop       = 2;
+        ops[1]    = constraint->op2;
+        values[1] = PDC_constraint_operand(constraint->type, &constraint->value2, 1);
+    }
+
+    for (k = 0; k < nop; k++) {
+        value = values[k];
+        switch (ops[k]) {
+            case PDC_GT:
+            case PDC_GTE:
+                if (value > qlo || (value == qlo && ops[k] == PDC_GT)) {
+                    qlo      = value;
+                    qlo_open = is_exact && ops[k] == PDC_GT;
+                }
+                break;
+            case PDC_LT:
+            case PDC_LTE:
+                if (value < qhi || (value == qhi && ops[k] == PDC_LT)) {
+                    qhi      = value;
+                    qhi_open = is_exact && ops[k] == PDC_LT;
+                }
+                break;
+            case PDC_EQ:
+                if (value > qlo) {
+                    qlo      = value;
+                    qlo_open = 0;
+                }
+                if (value < qhi) {
+                    qhi      = value;
+                    qhi_open = 0;
+                }
+                break;
+            default:
+                return 1;
         }
-        else if (lop == PDC_GT || lop == PDC_GTE) {
-            if (value > region_hist->range[region_hist->nbin * 2 - 1])
-                return 0;
+    }
+
+    if (qlo > qhi || (qlo == qhi && (qlo_open || qhi_open)))
+        return 0;
+
+    // Zone map
+    if (!PDC_constraint_interval_overlap(qlo, qlo_open, qhi, qhi_open, region_hist->range[0],
+                                         region_hist->range[region_hist->nbin * 2 - 1]))
+        return 0;
+
+    if (region_hist->nbin == 1)
+        return 1;
+
+    // Bins the query interval touches, widened by one as values close to a bin edge may be counted in the
+    // next bin after rounding
+    first = -1;
+    last  = -1;
+    for (i = 0; i < region_hist->nbin; i++) {
+        if (PDC_constraint_interval_overlap(qlo, 0, qhi, 0, region_hist->range[i * 2],
+                                            region_hist->range[i * 2 + 1])) {
+            if (first < 0)
+                first = i;
+            last = i;
         }
     }
+    if (first < 0)
+        return 1;
+    first = first > 0 ? first - 1 : 0;
+    last  = last < region_hist->nbin - 1 ? last + 1 : last;
 
-    return 1;
+    for (i = first; i <= last; i++) {
+        if (region_hist->bin[i] > 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * PDC_region_has_hits_from_hist on the zone map of a storage region, which write_out may replace meanwhile.
+ * Returns 1 if the region has none.
+ */
+static int
+PDC_region_has_hits(pdc_query_constraint_t *constraint, region_list_t *region)
+{
+    int ret = 1;
+
+    pthread_rwlock_rdlock(&region_index_rwlock_g);
+    if (region->region_hist != NULL)
+        ret = PDC_region_has_hits_from_hist(constraint, region->region_hist);
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+
+    return ret;
 }
 
 /*
@@ -6263,6 +6707,16 @@ done:
 }
 */
 
+/*
+ * With query workers, the data of a storage region is read by the worker that evaluates it rather than all
+ * regions up front. FastBit index generation keeps the serial path.
+ */
+static int
+PDC_Server_query_defers_read()
+{
+    return PDC_Server_query_pool_nthread() > 0 && gen_fastbit_idx_g == 0;
+}
+
 static perr_t
 PDC_Server_load_query_data(query_task_t *task, pdc_query_t *query, pdc_query_combine_op_t combine_op)
 {
@@ -6350,18 +6804,13 @@ PDC_Server_load_query_data(query_task_t *task, pdc_query_t *query, pdc_query_com
                 continue;
         }
 
-        // use histogram to see if we need to read this region
-        if (gen_hist_g == 1) {
-
-            if (req_region->region_hist->nbin == 0) {
-                printf("==PDC_SERVER[%d]: %s -  ERROR histogram is empty!\n", pdc_server_rank_g, __func__);
-                fflush(stdout);
-            }
-
-            if (PDC_region_has_hits_from_hist(constraint, req_region->region_hist) == 0) {
-                /* printf("==PDC_SERVER[%d]: Region [%" PRIu64 ", %" PRIu64 "], skipped by histogram\n", */
-                /*         pdc_server_rank_g, req_region->start[0], req_region->count[0]); */
+        // use the zone map and histogram to see if we need to read this region
+        if (PDC_region_has_hits(constraint, req_region) == 0) {
+            /* printf("==PDC_SERVER[%d]: Region [%" PRIu64 ", %" PRIu64 "], skipped by histogram\n", */
+            /*         pdc_server_rank_g, req_region->start[0], req_region->count[0]); */
 
+            // The selection has no hits left there unless a later constraint is ORed
+            if (combine_op != PDC_QUERY_OR) {
                 if (task->invalid_region_ids == NULL)
                     task->invalid_region_ids = (int *)calloc(count, sizeof(int));
 
@@ -6376,10 +6825,14 @@ PDC_Server_load_query_data(query_task_t *task, pdc_query_t *query, pdc_query_com
                     task->invalid_region_ids[task->ninvalid_region] = iter;
                     task->ninvalid_region++;
                 }
-                continue;
             }
+            continue;
         }
 
+        // A bitmap index that answers the constraint alone saves reading the region
+        if (PDC_region_needs_data(constraint, req_region, PDC_get_var_type_size(constraint->type)) == 0)
+            continue;
+
         is_same_region = 0;
         DL_FOREACH(io_list_target->region_list_head, region_tmp)
         {
@@ -6409,6 +6862,10 @@ PDC_Server_load_query_data(query_task_t *task, pdc_query_t *query, pdc_query_com
         }
     } // Ened DL_FOREACH
 
+    // Query workers read each region as they evaluate it, so reads overlap with the scans
+    if (PDC_Server_query_defers_read())
+        goto done;
+
     // Currently reads all regions of a query constraint together
     // TODO: potential optimization: aggregate all I/O requests
     ret_value = PDC_Server_data_read_to_buf(io_list_target->region_list_head);
@@ -6474,53 +6931,10 @@ coord_to_region_index(size_t ndim, uint64_t *coord, region_list_t *region, int u
     return off;
 }
 
-static int
-is_coord_within_region(int ndim, uint64_t *coords, region_list_t *region_constraint, int unit_size)
+int
+compare_coords_1d(const void *a, const void *b)
 {
-    int      i;
-    uint64_t coord[3];
-
-    if (coords == NULL || region_constraint == NULL || ndim > 3)
-        return -1;
-
-    for (i = 0; i < ndim; i++) {
-        coord[i] = coords[i];
-        coord[i] *= unit_size;
-        if (coord[i] < region_constraint->start[i] ||
-            coord[i] > region_constraint->start[i] + region_constraint->count[i]) {
-            return -1;
-        }
-    }
-    return 1;
-}
-
-static int
-is_idx_within_region(uint64_t idx, region_list_t *region, region_list_t *region_constraint, int unit_size)
-{
-    size_t   i, ndim;
-    uint64_t coord[DIM_MAX];
-
-    if (region == NULL || region_constraint == NULL)
-        return -1;
-
-    ndim = region->ndim;
-    region_index_to_coord(ndim, idx, region->count, (uint64_t *)&coord);
-
-    for (i = 0; i < ndim; i++) {
-        coord[i] *= unit_size;
-        coord[i] += region->start[i];
-        if (coord[i] < region_constraint->start[i] ||
-            coord[i] > region_constraint->start[i] + region_constraint->count[i]) {
-            return -1;
-        }
-    }
-    return 1;
-}
-
-int
-compare_coords_1d(const void *a, const void *b)
-{
-    return (memcmp(a, b, sizeof(uint64_t)));
+    return (memcmp(a, b, sizeof(uint64_t)));
 }
 
 int
@@ -6535,295 +6949,6 @@ compare_coords_3d(const void *a, const void *b)
     return (memcmp(a, b, sizeof(uint64_t) * 3));
 }
 
-/* perr_t QUERY_EVALUATE_SCAN_OPT(uint64_t _n, float *_data, pdc_query_op_t _op, void *_value, */
-/*                                pdc_selection_t *_sel, region_list_t *_region, int _unit_size, */
-/*                                region_list_t *_region_constraint, pdc_query_combine_op_t _combine_op) */
-/* { */
-/*     perr_t ret_value; */
-#define MACRO_QUERY_EVALUATE_SCAN_OPT(TYPE, _n, _data, _op, _value, _sel, _region, _unit_size,               \
-                                      _region_constraint, _combine_op)                                       \
-    ({                                                                                                       \
-        uint64_t idx, iii, jjj, ttt, cur_count = 0, istart, has_dup;                                         \
-        int      is_good, _ndim;                                                                             \
-        TYPE *   edata = (TYPE *)(_data);                                                                    \
-        _ndim          = (_region)->ndim;                                                                    \
-        istart         = (_sel)->nhits * _ndim;                                                              \
-        if (_ndim > 3) {                                                                                     \
-            printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);    \
-            ret_value = FAIL;                                                                                \
-            goto done;                                                                                       \
-        }                                                                                                    \
-        if ((_combine_op) == PDC_QUERY_NONE || (_combine_op) == PDC_QUERY_OR) {                              \
-            for (iii = 0; iii < (_n); iii++) {                                                               \
-                is_good = 0;                                                                                 \
-                if ((_region_constraint) &&                                                                  \
-                    is_idx_within_region(iii, (_region), (_region_constraint), (_unit_size)) != 1)           \
-                    continue;                                                                                \
-                switch (_op) {                                                                               \
-                    case PDC_GT:                                                                             \
-                        if (edata[iii] > *((TYPE *)(_value)))                                                \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_LT:                                                                             \
-                        if (edata[iii] < *((TYPE *)(_value)))                                                \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_GTE:                                                                            \
-                        if (edata[iii] >= *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_LTE:                                                                            \
-                        if (edata[iii] <= *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_EQ:                                                                             \
-                        if (edata[iii] == *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    default:                                                                                 \
-                        printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g,      \
-                               __func__);                                                                    \
-                        ret_value = FAIL;                                                                    \
-                        goto done;                                                                           \
-                }                                                                                            \
-                if (is_good == 1) {                                                                          \
-                    if ((istart + cur_count + 1) * _ndim > ((_sel)->coords_alloc)) {                         \
-                        ((_sel)->coords_alloc) *= 2;                                                         \
-                        ((_sel)->coords) =                                                                   \
-                            (uint64_t *)realloc(((_sel)->coords), (_sel)->coords_alloc * sizeof(uint64_t));  \
-                        if (NULL == ((_sel)->coords)) {                                                      \
-                            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g,         \
-                                   __func__);                                                                \
-                            ret_value = FAIL;                                                                \
-                            goto done;                                                                       \
-                        }                                                                                    \
-                    }                                                                                        \
-                    ttt = iii;                                                                               \
-                    if (_ndim == 3) {                                                                        \
-                        (_sel)->coords[istart + cur_count * _ndim + 2] =                                     \
-                            ttt / ((_region)->count[1] / (_unit_size)) *                                     \
-                                ((_region)->count[0] / (_unit_size)) +                                       \
-                            (_region)->start[2] / (_unit_size);                                              \
-                        ttt -= (_sel)->coords[istart + cur_count * _ndim + 2] *                              \
-                               ((_region)->count[1] / (_unit_size)) * ((_region)->count[0] / (_unit_size));  \
-                    }                                                                                        \
-                    if (_ndim == 2) {                                                                        \
-                        (_sel)->coords[istart + cur_count * _ndim + 1] =                                     \
-                            ttt / ((_region)->count[0] / (_unit_size)) + (_region)->start[1] / (_unit_size); \
-                        ttt -= (_sel)->coords[istart + cur_count * _ndim + 1] *                              \
-                               ((_region)->count[0] / (_unit_size));                                         \
-                    }                                                                                        \
-                    (_sel)->coords[istart + cur_count * _ndim] = ttt + (_region)->start[0] / (_unit_size);   \
-                    cur_count++;                                                                             \
-                }                                                                                            \
-            }                                                                                                \
-            ((_sel)->nhits) += cur_count;                                                                    \
-        }                                                                                                    \
-        else if ((_combine_op) == PDC_QUERY_AND) {                                                           \
-            has_dup = 0;                                                                                     \
-            for (idx = 0; idx < (_sel)->nhits; idx++) {                                                      \
-                if ((_sel)->coords[idx * (_ndim)] == ULLONG_MAX) {                                           \
-                    continue;                                                                                \
-                }                                                                                            \
-                if (is_coord_within_region(_ndim, &(_sel)->coords[idx * (_ndim)], _region, _unit_size) !=    \
-                    1) {                                                                                     \
-                    continue;                                                                                \
-                }                                                                                            \
-                iii     = coord_to_region_index(_ndim, &(_sel)->coords[idx * (_ndim)], _region, _unit_size); \
-                is_good = 0;                                                                                 \
-                /* No need to check for region constraint as a query has one region constraint only */       \
-                switch (_op) {                                                                               \
-                    case PDC_GT:                                                                             \
-                        if (edata[iii] > *((TYPE *)(_value)))                                                \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_LT:                                                                             \
-                        if (edata[iii] < *((TYPE *)(_value)))                                                \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_GTE:                                                                            \
-                        if (edata[iii] >= *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_LTE:                                                                            \
-                        if (edata[iii] <= *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    case PDC_EQ:                                                                             \
-                        if (edata[iii] == *((TYPE *)(_value)))                                               \
-                            is_good = 1;                                                                     \
-                        break;                                                                               \
-                    default:                                                                                 \
-                        printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g,      \
-                               __func__);                                                                    \
-                        ret_value = FAIL;                                                                    \
-                        goto done;                                                                           \
-                }                                                                                            \
-                if (is_good != 1) {                                                                          \
-                    /* Invalidate the coord by setting it to max value */                                    \
-                    (_sel)->coords[idx * (_ndim)] = ULLONG_MAX;                                              \
-                    has_dup++;                                                                               \
-                }                                                                                            \
-            }                                                                                                \
-            /* Now get rid of the invalidated elements */                                                    \
-            iii = jjj = 0;                                                                                   \
-            if (has_dup > 0) {                                                                               \
-                for (idx = 0; idx < (_sel)->nhits; idx++) {                                                  \
-                    while ((_sel)->coords[idx * (_ndim)] == ULLONG_MAX && idx < (_sel)->nhits) {             \
-                        iii++;                                                                               \
-                        idx++;                                                                               \
-                    }                                                                                        \
-                    if (idx != jjj && idx < (_sel)->nhits) {                                                 \
-                        memcpy(&(_sel)->coords[jjj * (_ndim)], &(_sel)->coords[idx * (_ndim)],               \
-                               _ndim * sizeof(uint64_t));                                                    \
-                    }                                                                                        \
-                    jjj++;                                                                                   \
-                }                                                                                            \
-                if (iii > (_sel)->nhits)                                                                     \
-                    printf("==PDC_SERVER[%d]: ERROR! invalidated more elements than total\n",                \
-                           pdc_server_rank_g);                                                               \
-                else                                                                                         \
-                    ((_sel)->nhits) -= iii;                                                                  \
-            }                                                                                                \
-        }                                                                                                    \
-    })
-
-#define MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(TYPE, _n, _data, _lo_op, _lo, _hi_op, _hi, _sel, _region,        \
-                                            _unit_size, _region_constraint, _combine_op)                     \
-    ({                                                                                                       \
-        uint64_t idx, iii, jjj, ttt, cur_count = 0, istart, has_dup;                                         \
-        int      is_good, _ndim;                                                                             \
-        TYPE *   edata = (TYPE *)(_data);                                                                    \
-        _ndim          = (_region)->ndim;                                                                    \
-        istart         = (_sel)->nhits * _ndim;                                                              \
-        if (_ndim > 3) {                                                                                     \
-            printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);    \
-            ret_value = FAIL;                                                                                \
-            goto done;                                                                                       \
-        }                                                                                                    \
-        if ((_combine_op) == PDC_QUERY_NONE || (_combine_op) == PDC_QUERY_OR) {                              \
-            for (iii = 0; iii < (_n); iii++) {                                                               \
-                is_good = 0;                                                                                 \
-                if ((_region_constraint) &&                                                                  \
-                    is_idx_within_region(iii, (_region), (_region_constraint), (_unit_size)) != 1)           \
-                    continue;                                                                                \
-                if ((_lo_op) == PDC_GT && (_hi_op) == PDC_LT) {                                              \
-                    if (edata[iii] > (_lo) && edata[iii] < (_hi))                                            \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GTE && (_hi_op) == PDC_LT) {                                        \
-                    if (edata[iii] >= (_lo) && edata[iii] < (_hi))                                           \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GT && (_hi_op) == PDC_LTE) {                                        \
-                    if (edata[iii] > (_lo) && edata[iii] <= (_hi))                                           \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GTE && (_hi_op) == PDC_LTE) {                                       \
-                    if (edata[iii] >= (_lo) && edata[iii] <= (_hi))                                          \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else {                                                                                       \
-                    printf("==PDC_SERVER[%d]: %s - error with range op! \n", pdc_server_rank_g, __func__);   \
-                    ret_value = FAIL;                                                                        \
-                    goto done;                                                                               \
-                }                                                                                            \
-                if (is_good == 1) {                                                                          \
-                    if ((istart + cur_count + 1) * _ndim > ((_sel)->coords_alloc)) {                         \
-                        ((_sel)->coords_alloc) *= 2;                                                         \
-                        ((_sel)->coords) =                                                                   \
-                            (uint64_t *)realloc(((_sel)->coords), (_sel)->coords_alloc * sizeof(uint64_t));  \
-                        if (NULL == ((_sel)->coords)) {                                                      \
-                            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g,         \
-                                   __func__);                                                                \
-                            ret_value = FAIL;                                                                \
-                            goto done;                                                                       \
-                        }                                                                                    \
-                    }                                                                                        \
-                    ttt = iii;                                                                               \
-                    if (_ndim == 3) {                                                                        \
-                        (_sel)->coords[istart + cur_count * _ndim + 2] =                                     \
-                            ttt / ((_region)->count[1] / (_unit_size)) *                                     \
-                                ((_region)->count[0] / (_unit_size)) +                                       \
-                            (_region)->start[2] / (_unit_size);                                              \
-                        ttt -= (_sel)->coords[istart + cur_count * _ndim + 2] *                              \
-                               ((_region)->count[1] / (_unit_size)) * ((_region)->count[0] / (_unit_size));  \
-                    }                                                                                        \
-                    if (_ndim == 2) {                                                                        \
-                        (_sel)->coords[istart + cur_count * _ndim + 1] =                                     \
-                            ttt / ((_region)->count[0] / (_unit_size)) + (_region)->start[1] / (_unit_size); \
-                        ttt -= (_sel)->coords[istart + cur_count * _ndim + 1] *                              \
-                               ((_region)->count[0] / (_unit_size));                                         \
-                    }                                                                                        \
-                    (_sel)->coords[istart + cur_count * _ndim] = ttt + (_region)->start[0] / (_unit_size);   \
-                    cur_count++;                                                                             \
-                }                                                                                            \
-            }                                                                                                \
-            ((_sel)->nhits) += cur_count;                                                                    \
-        } /* End if left is NULL */                                                                          \
-        else if ((_combine_op) == PDC_QUERY_AND) {                                                           \
-            has_dup = 0;                                                                                     \
-            for (idx = 0; idx < (_sel)->nhits; idx++) {                                                      \
-                if ((_sel)->coords[idx * (_ndim)] == ULLONG_MAX) {                                           \
-                    continue;                                                                                \
-                }                                                                                            \
-                if (is_coord_within_region(_ndim, &(_sel)->coords[idx * (_ndim)], _region, _unit_size) !=    \
-                    1) {                                                                                     \
-                    continue;                                                                                \
-                }                                                                                            \
-                iii     = coord_to_region_index(_ndim, &(_sel)->coords[idx * (_ndim)], _region, _unit_size); \
-                is_good = 0;                                                                                 \
-                /* No need to check for region constraint as a query has one region constraint only */       \
-                if ((_lo_op) == PDC_GT && (_hi_op) == PDC_LT) {                                              \
-                    if (edata[iii] > (_lo) && edata[iii] < (_hi))                                            \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GTE && (_hi_op) == PDC_LT) {                                        \
-                    if (edata[iii] >= (_lo) && edata[iii] < (_hi))                                           \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GT && (_hi_op) == PDC_LTE) {                                        \
-                    if (edata[iii] > (_lo) && edata[iii] <= (_hi))                                           \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else if ((_lo_op) == PDC_GTE && (_hi_op) == PDC_LTE) {                                       \
-                    if (edata[iii] >= (_lo) && edata[iii] <= (_hi))                                          \
-                        is_good = 1;                                                                         \
-                }                                                                                            \
-                else {                                                                                       \
-                    printf("==PDC_SERVER[%d]: %s - error with range op! \n", pdc_server_rank_g, __func__);   \
-                    ret_value = FAIL;                                                                        \
-                    goto done;                                                                               \
-                }                                                                                            \
-                if (is_good != 1) {                                                                          \
-                    /* Invalidate the coord by setting it to max value */                                    \
-                    (_sel)->coords[idx * (_ndim)] = ULLONG_MAX;                                              \
-                    has_dup++;                                                                               \
-                }                                                                                            \
-            }                                                                                                \
-            /* Now get rid of the invalidated elements */                                                    \
-            iii = jjj = 0;                                                                                   \
-            if (has_dup > 0) {                                                                               \
-                for (idx = 0; idx < (_sel)->nhits; idx++) {                                                  \
-                    while ((_sel)->coords[idx * (_ndim)] == ULLONG_MAX && idx < (_sel)->nhits) {             \
-                        iii++;                                                                               \
-                        idx++;                                                                               \
-                    }                                                                                        \
-                    if (idx != jjj && idx < (_sel)->nhits) {                                                 \
-                        memcpy(&(_sel)->coords[jjj * (_ndim)], &(_sel)->coords[idx * (_ndim)],               \
-                               (_ndim) * sizeof(uint64_t));                                                  \
-                    }                                                                                        \
-                    jjj++;                                                                                   \
-                }                                                                                            \
-                if (iii > (_sel)->nhits)                                                                     \
-                    printf("==PDC_SERVER[%d]: ERROR! invalidated more elements than total\n",                \
-                           pdc_server_rank_g);                                                               \
-                else                                                                                         \
-                    ((_sel)->nhits) -= iii;                                                                  \
-            }                                                                                                \
-        }                                                                                                    \
-    })
-
 #ifdef ENABLE_FASTBIT
 void
 PDC_gen_fastbit_idx_name(char *out, char *prefix, uint64_t obj_id, int timestep, int ndim, uint64_t *start,
@@ -7243,6 +7368,109 @@ done:
 
 #endif
 
+/*
+ * Constraint evaluation shared by the storage regions of an object
+ */
+typedef struct pdc_query_eval_t {
+    pdc_var_type_t   type;
+    pdc_query_op_t   lo_op;
+    void *           lo;
+    pdc_query_op_t   hi_op;
+    void *           hi;
+    size_t           unit_size;
+    region_list_t *  region_constraint; // In bytes, NULL if the hits must not be constrained
+    pdc_selection_t *sel;
+} pdc_query_eval_t;
+
+/*
+ * Evaluation of one storage region by a query worker
+ */
+typedef struct pdc_query_region_job_t {
+    pdc_query_eval_t *eval;
+    region_list_t *   region;       // Storage region
+    region_list_t *   cache_region; // Region whose buffer holds the data once read
+    int               is_data_needed;
+    uint64_t          nelem;
+    uint64_t *        mask; // NULL if the region was not evaluated
+    uint64_t          nmatch;
+    uint64_t          coord_offset; // Index of the first hit of the region in the selection
+    perr_t            ret;
+} pdc_query_region_job_t;
+
+/*
+ * Read the data of a region if it is needed and scan it, or its bitmap index, into a match mask
+ */
+static void
+PDC_Server_query_region_scan(void *arg)
+{
+    pdc_query_region_job_t *job    = (pdc_query_region_job_t *)arg;
+    pdc_query_eval_t *      eval   = job->eval;
+    region_list_t *         region = job->region;
+    pdc_bitmap_index_t *    bitmap_idx;
+    void *                  buf = NULL;
+
+    job->ret = SUCCEED;
+    if (job->nelem == 0)
+        return;
+
+    // A region that cannot be read is skipped, as when it is not read at load time
+    if (job->is_data_needed == 1) {
+        if (job->cache_region->is_data_ready != 1 &&
+            PDC_Server_data_read_to_buf_1_region(job->cache_region) != SUCCEED)
+            return;
+        buf = job->cache_region->buf;
+    }
+
+    job->mask = (uint64_t *)malloc((job->nelem + 63) / 64 * sizeof(uint64_t));
+    if (NULL == job->mask) {
+        printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+        job->ret = FAIL;
+        return;
+    }
+
+    // The index is scanned under the lock, write_out swaps it when the region is overwritten
+    PDC_Server_load_region_bitmap_idx(region);
+    pthread_rwlock_rdlock(&region_index_rwlock_g);
+    bitmap_idx = PDC_Server_get_region_bitmap_idx(region, eval->type, job->nelem);
+    if (bitmap_idx != NULL)
+        job->ret = PDC_Server_bitmap_index_scan(bitmap_idx, buf, eval->lo_op, eval->lo, eval->hi_op, eval->hi,
+                                                job->mask, &job->nmatch);
+    pthread_rwlock_unlock(&region_index_rwlock_g);
+
+    // An overwrite dropped the index since it was found to answer the constraint alone, read the data now
+    if (bitmap_idx == NULL && buf == NULL) {
+        if (job->cache_region->is_data_ready != 1 &&
+            PDC_Server_data_read_to_buf_1_region(job->cache_region) != SUCCEED) {
+            free(job->mask);
+            job->mask = NULL;
+            return;
+        }
+        buf = job->cache_region->buf;
+    }
+    if (bitmap_idx == NULL)
+        job->ret = PDC_Server_query_kernel_scan(eval->type, buf, job->nelem, eval->lo_op, eval->lo,
+                                                eval->hi_op, eval->hi, job->mask, &job->nmatch);
+
+    if (job->ret == SUCCEED && eval->region_constraint != NULL && job->nmatch > 0)
+        job->nmatch = PDC_Server_query_kernel_constrain(job->mask, job->nelem, region, eval->unit_size,
+                                                        eval->region_constraint);
+}
+
+/*
+ * Write the coordinates of the hits of a region at its place in the selection
+ */
+static void
+PDC_Server_query_region_coords(void *arg)
+{
+    pdc_query_region_job_t *job  = (pdc_query_region_job_t *)arg;
+    pdc_query_eval_t *      eval = job->eval;
+
+    if (job->mask == NULL || job->nmatch == 0 || job->ret != SUCCEED)
+        return;
+    PDC_Server_query_kernel_mask_to_coords(job->mask, (job->nelem + 63) / 64, job->region, eval->unit_size,
+                                           eval->sel->coords + job->coord_offset * job->region->ndim);
+}
+
 static perr_t
 PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_query_t *left,
                                     pdc_query_combine_op_t combine_op)
@@ -7250,7 +7478,6 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
     perr_t           ret_value = SUCCEED;
     region_list_t *  region_elt, *region_list_head, *cache_region, tmp_region, *region_constraint = NULL;
     pdc_selection_t *sel = query->sel;
-    uint64_t         nelem;
     size_t           i, j, unit_size;
     // FIXME: need to check the types of these 'op's. I think they should be of the following (or don't even
     // need to be initilized):
@@ -7262,8 +7489,12 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
     uint32_t ulo = 0, uhi = 0;
     int64_t  i64lo = 0, i64hi = 0;
     uint64_t ui64lo = 0, ui64hi = 0;
-    void *   value = NULL, *buf = NULL;
-    int      n_eval_region = 0, can_skip, region_iter = 0;
+    void *   value = NULL, *lo = NULL, *hi = NULL;
+    int      n_eval_region = 0, can_skip, region_iter = 0, is_data_needed, defer_read, njob = 0;
+    uint64_t nhits;
+
+    pdc_query_eval_t        eval;
+    pdc_query_region_job_t *jobs = NULL;
 
     printf("==PDC_SERVER[%d]: %s - start query evaluation!\n", pdc_server_rank_g, __func__);
     fflush(stdout);
@@ -7365,26 +7596,38 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
             case PDC_FLOAT:
                 flo = (float)query->constraint->value;
                 fhi = (float)query->constraint->value2;
+                lo = &flo;
+                hi = &fhi;
                 break;
             case PDC_DOUBLE:
                 dlo = (double)query->constraint->value;
                 dhi = (double)query->constraint->value2;
+                lo = &dlo;
+                hi = &dhi;
                 break;
             case PDC_INT:
                 ilo = (int)query->constraint->value;
                 ihi = (int)query->constraint->value2;
+                lo = &ilo;
+                hi = &ihi;
                 break;
             case PDC_UINT:
                 ulo = (uint32_t)query->constraint->value;
                 uhi = (uint32_t)query->constraint->value2;
+                lo = &ulo;
+                hi = &uhi;
                 break;
             case PDC_INT64:
                 i64lo = (int64_t)query->constraint->value;
                 i64hi = (int64_t)query->constraint->value2;
+                lo = &i64lo;
+                hi = &i64hi;
                 break;
             case PDC_UINT64:
                 ui64lo = (uint64_t)query->constraint->value;
                 ui64hi = (uint64_t)query->constraint->value2;
+                lo = &ui64lo;
+                hi = &ui64hi;
                 break;
             default:
                 printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
@@ -7427,9 +7670,9 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
                     continue;
             }
 
-            // Skip region based on histogram
-            if (gen_hist_g == 1) {
-                if (PDC_region_has_hits_from_hist(query->constraint, region_elt->region_hist) == 0) {
+            // Skip region based on its zone map and histogram
+            if (PDC_region_has_hits(query->constraint, region_elt) == 0) {
+                if (combine_op != PDC_QUERY_OR) {
                     if (task->invalid_region_ids == NULL)
                         task->invalid_region_ids = (int *)calloc(count, sizeof(int));
 
@@ -7444,8 +7687,8 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
                         task->invalid_region_ids[task->ninvalid_region] = region_iter;
                         task->ninvalid_region++;
                     }
-                    continue;
                 }
+                continue;
             }
 
             uint64_t idx_nhits = 0, *idx_coords = NULL, tmp_coord[DIM_MAX];
@@ -7489,11 +7732,44 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
 #endif
     } // End if use fastbit
     else {
+        // The bitmaps of the selection are per storage region, fall back to coordinates when this object is
+        // split into different regions than the ones evaluated before
+        if (task->bitmap_sel != NULL &&
+            PDC_Server_query_bitmap_sel_is_aligned(task->bitmap_sel, region_list_head, unit_size) != 1) {
+            printf("==PDC_SERVER[%d]: %s - regions of %" PRIu64 " not aligned, using coords selection\n",
+                   pdc_server_rank_g, __func__, query->constraint->obj_id);
+            ret_value = PDC_Server_query_bitmap_sel_to_coords(task->bitmap_sel, sel);
+            PDC_Server_query_bitmap_sel_free(task->bitmap_sel);
+            task->bitmap_sel = NULL;
+            if (ret_value != SUCCEED)
+                goto done;
+        }
+        if (task->bitmap_sel != NULL)
+            PDC_Server_query_bitmap_sel_begin(task->bitmap_sel);
+
         // Load data
         printf("==PDC_SERVER[%d]: %s - start loading data!\n", pdc_server_rank_g, __func__);
         fflush(stdout);
         PDC_Server_load_query_data(task, query, combine_op);
 
+        eval.type      = query->constraint->type;
+        eval.lo_op     = query->constraint->is_range == 1 ? lop : op;
+        eval.lo        = query->constraint->is_range == 1 ? lo : value;
+        eval.hi_op     = query->constraint->is_range == 1 ? rop : PDC_OP_NONE;
+        eval.hi        = query->constraint->is_range == 1 ? hi : NULL;
+        eval.unit_size = unit_size;
+        eval.sel       = sel;
+        // A query has one region constraint, the hits already in the selection are within it
+        eval.region_constraint = combine_op == PDC_QUERY_AND ? NULL : region_constraint;
+
+        defer_read = PDC_Server_query_defers_read();
+        jobs       = (pdc_query_region_job_t *)calloc(count > 0 ? count : 1, sizeof(pdc_query_region_job_t));
+        if (NULL == jobs) {
+            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+
         region_iter = -1;
         DL_FOREACH(region_list_head, region_elt)
         {
@@ -7522,13 +7798,16 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
             if (cache_region->io_cache_region != NULL)
                 cache_region = cache_region->io_cache_region;
 
-            // Skip regions that has no data (skipped at data load phase when we know it has no hits)
-            if (cache_region->is_data_ready != 1)
+            // Skip regions that has no data (skipped at data load phase when we know it has no hits), unless
+            // their bitmap index does not need it or a worker reads them
+            is_data_needed = PDC_region_needs_data(query->constraint, region_elt, unit_size);
+            if (is_data_needed == 1 && cache_region->is_data_ready != 1 &&
+                (defer_read == 0 || region_elt->io_cache_region == NULL))
                 continue;
 
-            // Skip region based on histogram
-            if (gen_hist_g == 1) {
-                if (PDC_region_has_hits_from_hist(query->constraint, region_elt->region_hist) == 0) {
+            // Skip region based on its zone map and histogram
+            if (PDC_region_has_hits(query->constraint, region_elt) == 0) {
+                if (combine_op != PDC_QUERY_OR) {
                     if (task->invalid_region_ids == NULL)
                         task->invalid_region_ids = (int *)calloc(count, sizeof(int));
 
@@ -7543,100 +7822,79 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
                         task->invalid_region_ids[task->ninvalid_region] = region_iter;
                         task->ninvalid_region++;
                     }
-                    continue;
                 }
+                continue;
             }
 
 #ifdef ENABLE_FASTBIT
-            if (gen_fastbit_idx_g == 1) {
+            if (gen_fastbit_idx_g == 1 && is_data_needed == 1) {
                 PDC_gen_fastbit_idx(cache_region, query->constraint->type);
             }
 #endif
 
-            buf   = cache_region->buf;
-            nelem = cache_region->count[0];
-            for (i = 1; i < cache_region->ndim; i++)
-                nelem *= cache_region->count[i];
-            nelem /= unit_size;
+            if (region_elt->ndim == 0 || region_elt->ndim > 3) {
+                printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);
+                ret_value = FAIL;
+                goto done;
+            }
 
-            switch (query->constraint->type) {
-                case PDC_FLOAT:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(float, nelem, buf, lop, flo, rop, fhi, sel,
-                                                            region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(float, nelem, buf, op, value, sel, region_elt,
-                                                      unit_size, region_constraint, combine_op);
-                    }
-                    break;
-                case PDC_DOUBLE:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(double, nelem, buf, lop, dlo, rop, dhi, sel,
-                                                            region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(double, nelem, buf, op, value, sel, region_elt,
-                                                      unit_size, region_constraint, combine_op);
-                    }
-                    break;
-                case PDC_INT:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(int, nelem, buf, lop, ilo, rop, ihi, sel,
-                                                            region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(int, nelem, buf, op, value, sel, region_elt, unit_size,
-                                                      region_constraint, combine_op);
-                    }
-                    break;
-                case PDC_UINT:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(uint32_t, nelem, buf, lop, ulo, rop, uhi, sel,
-                                                            region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(uint32_t, nelem, buf, op, value, sel, region_elt,
-                                                      unit_size, region_constraint, combine_op);
-                    }
-                    break;
-                case PDC_INT64:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(int64_t, nelem, buf, lop, i64lo, rop, i64hi, sel,
-                                                            region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(int64_t, nelem, buf, op, value, sel, region_elt,
-                                                      unit_size, region_constraint, combine_op);
-                    }
-                    break;
-                case PDC_UINT64:
-                    if (query->constraint->is_range == 1) {
-                        MACRO_QUERY_RANGE_EVALUATE_SCAN_OPT(uint64_t, nelem, buf, lop, ui64lo, rop, ui64hi,
-                                                            sel, region_elt, unit_size, region_constraint,
-                                                            combine_op);
-                    }
-                    else {
-                        MACRO_QUERY_EVALUATE_SCAN_OPT(uint64_t, nelem, buf, op, value, sel, region_elt,
-                                                      unit_size, region_constraint, combine_op);
-                    }
-                    break;
-                default:
-                    printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
-                    ret_value = FAIL;
-                    goto done;
-            } // End switch
+            jobs[njob].eval           = &eval;
+            jobs[njob].region         = region_elt;
+            jobs[njob].cache_region   = cache_region;
+            jobs[njob].is_data_needed = is_data_needed;
+            jobs[njob].nelem          = region_elt->count[0] / unit_size;
+            for (i = 1; i < region_elt->ndim; i++)
+                jobs[njob].nelem *= region_elt->count[i] / unit_size;
+            njob++;
+        } // End DL_FOREACH
+
+        // Workers read and scan the regions, the masks are then combined with the selection in region order
+        PDC_Server_query_pool_run(PDC_Server_query_region_scan, jobs, njob, sizeof(pdc_query_region_job_t));
 
+        nhits = sel->nhits;
+        for (j = 0; j < (size_t)njob; j++) {
+            if (jobs[j].ret != SUCCEED) {
+                ret_value = FAIL;
+                goto done;
+            }
+            if (jobs[j].mask == NULL)
+                continue;
             n_eval_region++;
-        } // End DL_FOREACH
-    }     // End not use fastbit
 
-    if (n_eval_region == 0 && combine_op == PDC_QUERY_AND) {
+            if (task->bitmap_sel != NULL) {
+                ret_value = PDC_Server_query_bitmap_sel_combine(jobs[j].mask, jobs[j].nelem, jobs[j].nmatch,
+                                                                jobs[j].region, unit_size, NULL, combine_op,
+                                                                task->bitmap_sel);
+            }
+            else if (combine_op == PDC_QUERY_AND) {
+                ret_value = PDC_Server_query_kernel_combine(jobs[j].mask, jobs[j].nelem, jobs[j].nmatch,
+                                                            jobs[j].region, unit_size, NULL, combine_op, sel);
+            }
+            else {
+                jobs[j].coord_offset = nhits;
+                nhits += jobs[j].nmatch;
+            }
+            if (ret_value != SUCCEED)
+                goto done;
+        }
+
+        // Appended hits are written in place by the workers, one region each
+        if (nhits > sel->nhits) {
+            ret_value = PDC_Server_query_kernel_reserve_coords(sel, nhits, ndim);
+            if (ret_value != SUCCEED)
+                goto done;
+            PDC_Server_query_pool_run(PDC_Server_query_region_coords, jobs, njob,
+                                      sizeof(pdc_query_region_job_t));
+            sel->nhits = nhits;
+        }
+
+        if (task->bitmap_sel != NULL) {
+            PDC_Server_query_bitmap_sel_end(task->bitmap_sel, combine_op);
+            sel->nhits = task->bitmap_sel->nhits;
+        }
+    } // End not use fastbit
+
+    if (n_eval_region == 0 && combine_op == PDC_QUERY_AND && task->bitmap_sel == NULL) {
         if (sel->nhits > 0) {
             sel->nhits = 0;
             free(sel->coords);
@@ -7650,8 +7908,8 @@ PDC_Server_query_evaluate_merge_opt(pdc_query_t *query, query_task_t *task, pdc_
         gettimeofday(&pdc_timer_start1, 0);
 #endif
 
-    // Remove duplicates
-    if (combine_op == PDC_QUERY_OR && sel->nhits > 1 &&
+    // Remove duplicates, a union of bitmaps has none
+    if (combine_op == PDC_QUERY_OR && sel->nhits > 1 && task->bitmap_sel == NULL &&
         left->constraint->obj_id != query->constraint->obj_id) {
         if (ndim == 1) {
             qsort(sel->coords, sel->nhits, sizeof(uint64_t), compare_coords_1d);
@@ -7693,6 +7951,12 @@ done:
            query_eval_time);
 #endif
 
+    if (jobs != NULL) {
+        for (i = 0; i < (size_t)njob; i++)
+            free(jobs[i].mask);
+        free(jobs);
+    }
+
     fflush(stdout);
     return ret_value;
 }
@@ -7814,6 +8078,26 @@ attach_local_storage_region_to_query(pdc_query_t *query)
     return SUCCEED;
 }
 
+/*
+ * Build the coordinates of the hits of a task that keeps its selection as bitmaps, right before they are
+ * sent or used to read data. The bitmaps stay with the task, so the coordinates can be freed after use.
+ */
+static perr_t
+PDC_Server_query_materialize_sel(query_task_t *task)
+{
+    perr_t ret_value = SUCCEED;
+
+    if (task->bitmap_sel == NULL || task->query == NULL || task->query->sel == NULL)
+        goto done;
+
+    ret_value = PDC_Server_query_bitmap_sel_to_coords(task->bitmap_sel, task->query->sel);
+    if (ret_value != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - error converting selection to coords!\n", pdc_server_rank_g, __func__);
+
+done:
+    return ret_value;
+}
+
 static perr_t
 PDC_Server_send_nhits_to_server(query_task_t *task)
 {
@@ -8004,6 +8288,9 @@ PDC_Server_send_coords_to_client(query_task_t *task)
     }
 
     if (pdc_server_size_g == 1) {
+        ret_value = PDC_Server_query_materialize_sel(task);
+        if (ret_value != SUCCEED)
+            goto done;
         buf       = task->query->sel->coords;
         buf_sizes = task->query->sel->nhits * sizeof(uint64_t) * task->ndim;
         in.ndim   = task->ndim;
@@ -8089,6 +8376,10 @@ PDC_Server_send_coords_to_server(query_task_t *task)
         }
     }
 
+    ret_value = PDC_Server_query_materialize_sel(task);
+    if (ret_value != SUCCEED)
+        goto done;
+
     if (task->query->sel->nhits > 0) {
         buf       = task->query->sel->coords;
         buf_sizes = task->query->sel->nhits * sizeof(uint64_t) * task->ndim;
@@ -8141,7 +8432,7 @@ PDC_Server_get_constraint_from_query(pdc_query_t *query, uint64_t obj_id)
     if (constraint != NULL)
         return constraint;
 
-    constraint = PDC_Server_get_constraint_from_query(query->left, obj_id);
+    constraint = PDC_Server_get_constraint_from_query(query->right, obj_id);
     if (constraint != NULL)
         return constraint;
 
@@ -8267,15 +8558,49 @@ done:
 }
 
 // Receive coords from other servers
+/*
+ * Copy the elements at n coordinates from the storage regions holding them, the regions are read as needed.
+ * The element of a coordinate outside of all regions is left as is in buf. Return the number of coordinates
+ * found in the regions.
+ */
+static uint64_t
+PDC_Server_read_coords_to_buf(region_list_t *storage_region_head, size_t ndim, size_t unit_size,
+                              uint64_t *coords, uint64_t n, void *buf)
+{
+    region_list_t *region_elt, *cache_region;
+    uint64_t       i, *coord, buf_off, nfound = 0;
+
+    for (i = 0; i < n; i++) {
+        coord = &(coords[i * ndim]);
+        DL_FOREACH(storage_region_head, region_elt)
+        {
+            if (is_coord_in_region(ndim, coord, unit_size, region_elt) == 1) {
+                buf_off      = coord_to_offset(ndim, coord, region_elt->start, region_elt->count, unit_size);
+                cache_region = region_elt;
+                if (region_elt->io_cache_region != NULL)
+                    cache_region = region_elt->io_cache_region;
+                if (cache_region->is_io_done != 1) {
+                    PDC_Server_data_read_to_buf_1_region(cache_region);
+                }
+                memcpy(buf + i * unit_size, cache_region->buf + buf_off, unit_size);
+                nfound++;
+                break;
+            }
+        }
+    }
+
+    return nfound;
+}
+
 hg_return_t
 PDC_Server_read_coords(const struct hg_cb_info *callback_info)
 {
     hg_return_t             ret  = HG_SUCCESS;
     query_task_t *          task = (query_task_t *)callback_info->arg;
     pdc_query_constraint_t *constraint;
-    region_list_t *         storage_region_head, *region_elt, *cache_region;
+    region_list_t *         storage_region_head;
     size_t                  ndim, unit_size;
-    uint64_t                i, *coord, data_off, buf_off, my_size;
+    uint64_t                my_size;
 
     // We will read task->my_read_coords, from task->my_read_obj_id
     constraint = PDC_Server_get_constraint_from_query(task->query, task->my_read_obj_id);
@@ -8292,27 +8617,8 @@ PDC_Server_read_coords(const struct hg_cb_info *callback_info)
             goto done;
         }
 
-        data_off = 0;
-        for (i = 0; i < task->my_nread_coords; i++) {
-            coord = &(task->my_read_coords[i * ndim]);
-            DL_FOREACH(storage_region_head, region_elt)
-            {
-                if (is_coord_in_region(ndim, coord, unit_size, region_elt) == 1) {
-                    buf_off = coord_to_offset(ndim, coord, region_elt->start, region_elt->count, unit_size);
-                    cache_region = region_elt;
-                    if (region_elt->io_cache_region != NULL)
-                        cache_region = region_elt->io_cache_region;
-
-                    if (cache_region->is_io_done != 1) {
-                        PDC_Server_data_read_to_buf_1_region(cache_region);
-                    }
-                    /* float *tmp = cache_region->buf + buf_off; */
-                    memcpy(task->my_data + data_off, cache_region->buf + buf_off, unit_size);
-                    data_off += unit_size;
-                    break;
-                }
-            }
-        } // End for
+        PDC_Server_read_coords_to_buf(storage_region_head, ndim, unit_size, task->my_read_coords,
+                                      task->my_nread_coords, task->my_data);
 
         PDC_send_data_to_client(task->client_id, task->my_data, ndim, unit_size, task->my_nread_coords,
                                 task->query_id, task->client_seq_id);
@@ -8510,7 +8816,10 @@ PDC_recv_coords(const struct hg_cb_info *callback_info)
 
             printf("==PDC_SERVER[%d]: received all %d query results, send to client!\n", pdc_server_rank_g,
                    task_elt->n_recv);
-            PDC_Server_send_coords_to_client(task_elt);
+            if (task_elt->get_op == PDC_QUERY_GET_CURSOR)
+                PDC_Server_send_nhits_to_client(task_elt);
+            else
+                PDC_Server_send_coords_to_client(task_elt);
         }
     } // End else
 
@@ -8537,6 +8846,445 @@ done:
     return ret;
 }
 
+/*
+ * Storage regions and element type of an object, from the constraints of the query or from the regions
+ * cached for it
+ */
+static region_list_t *
+PDC_Server_query_obj_region(query_task_t *task, uint64_t obj_id, pdc_var_type_t *dtype)
+{
+    pdc_query_constraint_t *constraint;
+    cache_storage_region_t *cache_region_elt;
+
+    constraint = PDC_Server_get_constraint_from_query(task->query, obj_id);
+    if (constraint != NULL && constraint->storage_region_list_head != NULL) {
+        *dtype = constraint->type;
+        return (region_list_t *)constraint->storage_region_list_head;
+    }
+
+    DL_FOREACH(cache_storage_region_head_g, cache_region_elt)
+    {
+        if (cache_region_elt->obj_id == obj_id) {
+            *dtype = (pdc_var_type_t)cache_region_elt->data_type;
+            return cache_region_elt->storage_region_head;
+        }
+    }
+
+    return NULL;
+}
+
+#define PDC_REGION_SUM(TYPE, n, data, sum)                                                                   \
+    do {                                                                                                     \
+        uint64_t _i;                                                                                         \
+        TYPE *   _ldata = (TYPE *)(data);                                                                    \
+        double   _lsum  = 0;                                                                                 \
+        for (_i = 0; _i < (n); _i++)                                                                         \
+            _lsum += _ldata[_i];                                                                             \
+        (sum) = _lsum;                                                                                       \
+    } while (0)
+
+/*
+ * Count, sum, bounds and histogram of n values
+ */
+static perr_t
+PDC_Server_query_agg_values(pdc_var_type_t dtype, uint64_t n, void *data, pdc_query_agg_t *agg)
+{
+    double min, max, sum;
+
+    memset(agg, 0, sizeof(pdc_query_agg_t));
+    if (n == 0)
+        return SUCCEED;
+
+    switch (dtype) {
+        case PDC_FLOAT:
+            PDC_REGION_MIN_MAX(float, n, data, min, max);
+            PDC_REGION_SUM(float, n, data, sum);
+            break;
+        case PDC_DOUBLE:
+            PDC_REGION_MIN_MAX(double, n, data, min, max);
+            PDC_REGION_SUM(double, n, data, sum);
+            break;
+        case PDC_INT:
+            PDC_REGION_MIN_MAX(int, n, data, min, max);
+            PDC_REGION_SUM(int, n, data, sum);
+            break;
+        case PDC_UINT:
+            PDC_REGION_MIN_MAX(uint32_t, n, data, min, max);
+            PDC_REGION_SUM(uint32_t, n, data, sum);
+            break;
+        case PDC_INT64:
+            PDC_REGION_MIN_MAX(int64_t, n, data, min, max);
+            PDC_REGION_SUM(int64_t, n, data, sum);
+            break;
+        case PDC_UINT64:
+            PDC_REGION_MIN_MAX(uint64_t, n, data, min, max);
+            PDC_REGION_SUM(uint64_t, n, data, sum);
+            break;
+        default:
+            printf("==PDC_SERVER[%d]: %s - cannot aggregate values of type %d\n", pdc_server_rank_g, __func__,
+                   dtype);
+            return FAIL;
+    }
+
+    agg->count = n;
+    agg->sum   = sum;
+    agg->min   = min;
+    agg->max   = max;
+    agg->mean  = sum / n;
+
+    // NaN values make the bin bounds meaningless
+    if (min == min && max == max)
+        agg->hist = PDC_Server_create_hist(dtype, n, data, min, max, 1);
+
+    return SUCCEED;
+}
+
+/*
+ * Reduction of the values of one storage region at its hits by a query worker
+ */
+typedef struct pdc_query_agg_job_t {
+    region_list_t * cache_region; // Region whose buffer holds the data once read
+    pdc_roaring_t * bits;         // Hits in the region
+    pdc_var_type_t  type;
+    size_t          unit_size;
+    pdc_query_agg_t agg;
+    perr_t          ret;
+} pdc_query_agg_job_t;
+
+static void
+PDC_Server_query_region_agg(void *arg)
+{
+    pdc_query_agg_job_t *job = (pdc_query_agg_job_t *)arg;
+    uint64_t             n;
+    void *               values;
+
+    job->ret = FAIL;
+    if (job->cache_region->is_data_ready != 1 &&
+        PDC_Server_data_read_to_buf_1_region(job->cache_region) != SUCCEED)
+        return;
+
+    // Only the values at the hits are reduced, they are gathered first
+    n      = pdc_roaring_cardinality(job->bits);
+    values = malloc(n * job->unit_size);
+    if (NULL == values) {
+        printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+        return;
+    }
+    PDC_Server_query_bitmap_gather(job->bits, job->cache_region->buf, job->unit_size, values);
+    job->ret = PDC_Server_query_agg_values(job->type, n, values, &job->agg);
+    free(values);
+}
+
+/*
+ * Reduce the values of the aggregated object at the hits of a task into task->my_agg. With a bitmap selection
+ * over the same region layout, the workers reduce one storage region each and the partial aggregates are
+ * merged in region order, otherwise the values are read at the coordinates of the hits. Fails when some hits
+ * are outside of the storage regions of the object on this server, as their values cannot be read here.
+ */
+static perr_t
+PDC_Server_query_aggregate(query_task_t *task)
+{
+    perr_t               ret_value = SUCCEED;
+    region_list_t *      storage_region_head, *region_elt;
+    pdc_query_agg_job_t *jobs = NULL;
+    pdc_roaring_t *      bits;
+    pdc_var_type_t       dtype;
+    pdc_selection_t *    sel;
+    size_t               unit_size;
+    int                  i, nregion, njob = 0;
+    uint64_t             nfound = 0;
+    void *               values;
+
+    FUNC_ENTER(NULL);
+
+    PDC_free_hist(task->my_agg.hist);
+    memset(&task->my_agg, 0, sizeof(pdc_query_agg_t));
+
+    sel = task->query == NULL ? NULL : task->query->sel;
+    if (sel == NULL || sel->nhits == 0)
+        goto done;
+
+    storage_region_head = PDC_Server_query_obj_region(task, task->agg_obj_id, &dtype);
+    unit_size           = PDC_get_var_type_size(dtype);
+    if (storage_region_head == NULL || unit_size == 0) {
+        printf("==PDC_SERVER[%d]: %s - cannot find storage region of obj %" PRIu64 "\n", pdc_server_rank_g,
+               __func__, task->agg_obj_id);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    if (task->bitmap_sel != NULL &&
+        PDC_Server_query_bitmap_sel_is_aligned(task->bitmap_sel, storage_region_head, unit_size) == 1) {
+        DL_COUNT(storage_region_head, region_elt, nregion);
+        jobs = (pdc_query_agg_job_t *)calloc(nregion, sizeof(pdc_query_agg_job_t));
+        if (NULL == jobs) {
+            printf("==PDC_SERVER[%d]: %s - error with calloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+
+        DL_FOREACH(storage_region_head, region_elt)
+        {
+            bits = PDC_Server_query_bitmap_sel_region_bits(task->bitmap_sel, region_elt, unit_size);
+            if (bits == NULL || pdc_roaring_cardinality(bits) == 0)
+                continue;
+            jobs[njob].cache_region = region_elt;
+            if (region_elt->io_cache_region != NULL)
+                jobs[njob].cache_region = region_elt->io_cache_region;
+            jobs[njob].bits      = bits;
+            jobs[njob].type      = dtype;
+            jobs[njob].unit_size = unit_size;
+            nfound += pdc_roaring_cardinality(bits);
+            njob++;
+        }
+
+        PDC_Server_query_pool_run(PDC_Server_query_region_agg, jobs, njob, sizeof(pdc_query_agg_job_t));
+
+        for (i = 0; i < njob; i++) {
+            if (jobs[i].ret == SUCCEED && ret_value == SUCCEED)
+                ret_value = PDC_query_agg_merge(&task->my_agg, &jobs[i].agg);
+            else
+                ret_value = FAIL;
+            PDC_free_hist(jobs[i].agg.hist);
+        }
+    }
+    else {
+        ret_value = PDC_Server_query_materialize_sel(task);
+        if (ret_value != SUCCEED)
+            goto done;
+
+        values = malloc(sel->nhits * unit_size);
+        if (NULL == values) {
+            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+        nfound = PDC_Server_read_coords_to_buf(storage_region_head, task->ndim, unit_size, sel->coords,
+                                               sel->nhits, values);
+        ret_value = PDC_Server_query_agg_values(dtype, sel->nhits, values, &task->my_agg);
+        free(values);
+    }
+
+    if (ret_value == SUCCEED && nfound != sel->nhits) {
+        printf("==PDC_SERVER[%d]: %s - %" PRIu64 " hits of obj %" PRIu64 " are on other servers\n",
+               pdc_server_rank_g, __func__, sel->nhits - nfound, task->agg_obj_id);
+        ret_value = FAIL;
+    }
+
+    if (ret_value != SUCCEED)
+        printf("==PDC_SERVER[%d]: %s - error aggregating obj %" PRIu64 "\n", pdc_server_rank_g, __func__,
+               task->agg_obj_id);
+
+done:
+    if (jobs)
+        free(jobs);
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * A serialized aggregate waiting to be pulled by its receiver
+ */
+typedef struct pdc_query_agg_send_args_t {
+    hg_bulk_t bulk_handle;
+    void *    buf;
+} pdc_query_agg_send_args_t;
+
+static hg_return_t
+PDC_Server_send_query_agg_cb(const struct hg_cb_info *callback_info)
+{
+    pdc_query_agg_send_args_t *args = (pdc_query_agg_send_args_t *)callback_info->arg;
+
+    HG_Bulk_free(args->bulk_handle);
+    free(args->buf);
+    free(args);
+
+    return HG_SUCCESS;
+}
+
+/*
+ * Send the aggregate of this server to the manager, or the final aggregate to the client. The number of
+ * servers that could not aggregate all of their hits goes along in the total field of the bulk RPC.
+ */
+static perr_t
+PDC_Server_send_query_agg(query_task_t *task, int to_client)
+{
+    perr_t                     ret_value = SUCCEED;
+    hg_return_t                hg_ret;
+    hg_handle_t                handle = NULL;
+    hg_addr_t                  addr;
+    bulk_rpc_in_t              in;
+    hg_size_t                  buf_size;
+    uint64_t                   size, n_fail;
+    pdc_query_agg_t *          agg;
+    pdc_query_agg_send_args_t *args = NULL;
+
+    FUNC_ENTER(NULL);
+
+    // The manager merges the aggregates of all servers, its own included, into task->agg
+    if (to_client == 1 && pdc_server_size_g > 1) {
+        agg    = &task->agg;
+        n_fail = task->n_agg_fail;
+    }
+    else {
+        agg    = &task->my_agg;
+        n_fail = task->my_agg_fail;
+    }
+
+    if (to_client == 1) {
+        if (task->client_id >= pdc_client_num_g || pdc_client_info_g == NULL) {
+            printf("==PDC_SERVER[%d]: %s - client_id %d invalid!\n", pdc_server_rank_g, __func__,
+                   task->client_id);
+            ret_value = FAIL;
+            goto done;
+        }
+        if (pdc_client_info_g[task->client_id].addr_valid == 0 &&
+            PDC_Server_lookup_client(task->client_id) != SUCCEED) {
+            ret_value = FAIL;
+            goto done;
+        }
+        addr = pdc_client_info_g[task->client_id].addr;
+    }
+    else {
+        if (task->manager >= pdc_server_size_g || pdc_remote_server_info_g == NULL) {
+            printf("==PDC_SERVER[%d]: %s - server_id %d invalid!\n", pdc_server_rank_g, __func__,
+                   task->manager);
+            ret_value = FAIL;
+            goto done;
+        }
+        if (pdc_remote_server_info_g[task->manager].addr_valid == 0 &&
+            PDC_Server_lookup_server_id(task->manager) != SUCCEED) {
+            ret_value = FAIL;
+            goto done;
+        }
+        addr = pdc_remote_server_info_g[task->manager].addr;
+    }
+
+    args = (pdc_query_agg_send_args_t *)calloc(1, sizeof(pdc_query_agg_send_args_t));
+    if (NULL == args) {
+        ret_value = FAIL;
+        goto done;
+    }
+    args->buf = PDC_query_agg_serialize(agg, &size);
+    if (NULL == args->buf) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    buf_size = size;
+    hg_ret   = HG_Bulk_create(hg_class_g, 1, &args->buf, &buf_size, HG_BULK_READ_ONLY, &args->bulk_handle);
+    if (hg_ret != HG_SUCCESS) {
+        fprintf(stderr, "Could not create bulk data handle\n");
+        ret_value = FAIL;
+        goto done;
+    }
+
+    memset(&in, 0, sizeof(bulk_rpc_in_t));
+    in.cnt         = 1;
+    in.total       = n_fail;
+    in.seq_id      = task->query_id;
+    in.origin      = pdc_server_rank_g;
+    in.op_id       = PDC_BULK_QUERY_AGG;
+    in.ndim        = task->ndim;
+    in.obj_id      = task->agg_obj_id;
+    in.bulk_handle = args->bulk_handle;
+
+    hg_ret = HG_Create(hg_context_g, addr, send_bulk_rpc_register_id_g, &handle);
+    if (hg_ret != HG_SUCCESS) {
+        ret_value = FAIL;
+        goto done;
+    }
+
+    // The buffer is freed once the receiver has pulled it and responded
+    hg_ret = HG_Forward(handle, PDC_Server_send_query_agg_cb, args, &in);
+    if (hg_ret != HG_SUCCESS) {
+        fprintf(stderr, "==PDC_SERVER[%d]: %s - HG_Forward failed!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    args = NULL;
+
+done:
+    if (args) {
+        if (args->bulk_handle != HG_BULK_NULL)
+            HG_Bulk_free(args->bulk_handle);
+        if (args->buf)
+            free(args->buf);
+        free(args);
+    }
+    if (handle)
+        HG_Destroy(handle);
+
+    FUNC_LEAVE(ret_value);
+}
+
+hg_return_t
+PDC_recv_query_agg(const struct hg_cb_info *callback_info)
+{
+    hg_return_t         ret               = HG_SUCCESS;
+    hg_bulk_t           local_bulk_handle = callback_info->info.bulk.local_handle;
+    struct bulk_args_t *bulk_args         = (struct bulk_args_t *)callback_info->arg;
+    query_task_t *      task_elt;
+    pdc_query_agg_t     agg;
+    pdc_int_ret_t       out;
+    void *              buf;
+
+    out.ret = 1;
+
+    if (callback_info->ret != HG_SUCCESS) {
+        ret     = HG_PROTOCOL_ERROR;
+        out.ret = -1;
+        goto done;
+    }
+
+    ret = HG_Bulk_access(local_bulk_handle, 0, bulk_args->nbytes, HG_BULK_READWRITE, 1, &buf, NULL, NULL);
+    if (ret != HG_SUCCESS || PDC_query_agg_deserialize(buf, bulk_args->nbytes, &agg) != SUCCEED) {
+        printf("==PDC_SERVER[%d]: %s - invalid aggregate from server %d!\n", pdc_server_rank_g, __func__,
+               bulk_args->origin);
+        out.ret = -1;
+        goto done;
+    }
+
+    DL_FOREACH(query_task_list_head_g, task_elt)
+    {
+        if (task_elt->query_id == bulk_args->query_id)
+            break;
+    }
+    if (task_elt == NULL) {
+        task_elt           = (query_task_t *)calloc(1, sizeof(query_task_t));
+        task_elt->query_id = bulk_args->query_id;
+        DL_APPEND(query_task_list_head_g, task_elt);
+    }
+
+    PDC_query_agg_merge(&task_elt->agg, &agg);
+    PDC_free_hist(agg.hist);
+    task_elt->nhits += agg.count;
+    task_elt->n_agg_fail += bulk_args->total;
+    task_elt->n_recv++;
+
+    // When received all results from the working servers, send the aggregated result back to client
+    if (task_elt->n_recv == task_elt->n_sent_server) {
+        printf("==PDC_SERVER[%d]: received all %d partial aggregates, send to client!\n", pdc_server_rank_g,
+               task_elt->n_recv);
+        PDC_Server_send_query_agg(task_elt, 1);
+    }
+
+done:
+    fflush(stdout);
+    HG_Bulk_free(local_bulk_handle);
+
+    ret = HG_Respond(bulk_args->handle, NULL, NULL, &out);
+    if (ret != HG_SUCCESS)
+        fprintf(stderr, "Could not respond\n");
+
+    ret = HG_Destroy(bulk_args->handle);
+    if (ret != HG_SUCCESS)
+        fprintf(stderr, "Could not destroy handle\n");
+
+    free(bulk_args);
+
+    return ret;
+}
+
 static perr_t
 PDC_Server_send_query_result_to_client(query_task_t *task)
 {
@@ -8550,6 +9298,13 @@ PDC_Server_send_query_result_to_client(query_task_t *task)
     }
     else if (task->get_op == PDC_QUERY_GET_DATA) {
     }
+    else if (task->get_op == PDC_QUERY_GET_CURSOR) {
+        // The client fetches the hits in pieces, see PDC_Server_query_cursor_fetch
+        ret_value = PDC_Server_send_nhits_to_client(task);
+    }
+    else if (task->get_op == PDC_QUERY_GET_AGG) {
+        ret_value = PDC_Server_send_query_agg(task, 1);
+    }
     else {
         printf("==PDC_SERVER[%d]: %s - Invalid get_op type!\n", pdc_server_rank_g, __func__);
         ret_value = FAIL;
@@ -8578,7 +9333,7 @@ PDC_Server_send_query_result_to_manager(query_task_t *task)
             goto done;
         }
     }
-    else if (task->get_op == PDC_QUERY_GET_SEL) {
+    else if (task->get_op == PDC_QUERY_GET_SEL || task->get_op == PDC_QUERY_GET_CURSOR) {
         ret_value = PDC_Server_send_coords_to_server(task);
         if (ret_value != SUCCEED) {
             printf("==PDC_SERVER[%d]: %s - error with PDC_Server_send_coords_to_server!\n", pdc_server_rank_g,
@@ -8586,6 +9341,15 @@ PDC_Server_send_query_result_to_manager(query_task_t *task)
             goto done;
         }
     }
+    else if (task->get_op == PDC_QUERY_GET_AGG) {
+        // Only the partial aggregate crosses the network, the manager merges them
+        ret_value = PDC_Server_send_query_agg(task, 0);
+        if (ret_value != SUCCEED) {
+            printf("==PDC_SERVER[%d]: %s - error with PDC_Server_send_query_agg!\n", pdc_server_rank_g,
+                   __func__);
+            goto done;
+        }
+    }
     else {
         printf("==PDC_SERVER[%d]: %s - Invalid get_op type!\n", pdc_server_rank_g, __func__);
         ret_value = FAIL;
@@ -8618,8 +9382,14 @@ PDC_Server_do_query(query_task_t *task)
     // Evaluate query
     PDC_query_visit(task->query, PDC_Server_query_evaluate_merge_opt, task, NULL, PDC_QUERY_NONE);
 
-    // No need to store the coords for nhits
-    if (task->get_op == PDC_QUERY_GET_NHITS) {
+    // Reduce where the data is, before the selection is sent anywhere
+    if (task->get_op == PDC_QUERY_GET_AGG) {
+        ret_value         = PDC_Server_query_aggregate(task);
+        task->my_agg_fail = ret_value != SUCCEED;
+    }
+
+    // No need to store the coords for nhits or aggregates
+    if (task->get_op == PDC_QUERY_GET_NHITS || task->get_op == PDC_QUERY_GET_AGG) {
         if (task->query && task->query->sel && task->query->sel->coords_alloc > 0 &&
             task->query->sel->coords) {
             free(task->query->sel->coords);
@@ -9214,10 +9984,17 @@ PDC_Server_recv_data_query(const struct hg_cb_info *callback_info)
     new_task->n_unique_obj      = query_xfer->n_unique_obj;
     new_task->obj_ids           = (uint64_t *)calloc(query_xfer->n_unique_obj, sizeof(uint64_t));
     new_task->get_op            = query_xfer->get_op;
+    new_task->agg_obj_id        = query_xfer->agg_obj_id;
     new_task->region_constraint = (region_list_t *)query->region_constraint;
     new_task->next_server_id    = query_xfer->next_server_id;
     new_task->prev_server_id    = query_xfer->prev_server_id;
 
+    // FastBit evaluates a region into coordinates, only the scan kernels fill a bitmap selection
+    if (use_bitmap_sel_g == 1 && use_fastbit_idx_g == 0) {
+        PDC_Server_query_bitmap_sel_free(new_task->bitmap_sel);
+        new_task->bitmap_sel = PDC_Server_query_bitmap_sel_create();
+    }
+
     if (is_debug_g == 1) {
         printf("==PDC_SERVER[%d]: %s - appended new query task %d to list head\n", pdc_server_rank_g,
                __func__, new_task->query_id);
@@ -9231,6 +10008,7 @@ PDC_Server_recv_data_query(const struct hg_cb_info *callback_info)
         PDC_query_visit_leaf_with_cb(query, attach_local_storage_region_to_query);
 
         PDC_Server_do_query(new_task);
+        new_task->nhits = query->sel->nhits;
 
         PDC_Server_send_query_result_to_client(new_task);
     }
@@ -9393,10 +10171,10 @@ PDC_Server_recv_read_sel_obj_data(const struct hg_cb_info *callback_info)
     hg_return_t             ret = HG_SUCCESS;
     get_sel_data_rpc_in_t * in  = (get_sel_data_rpc_in_t *)callback_info->arg;
     query_task_t *          task_elt, *task = NULL;
-    uint64_t                nhits, *coord, *coords = NULL, obj_id, buf_off, my_size, data_off, i;
+    uint64_t                nhits, *coords = NULL, obj_id, my_size;
     size_t                  ndim, unit_size;
     cache_storage_region_t *cache_region_elt;
-    region_list_t *         storage_region_head = NULL, *cache_region, *region_elt;
+    region_list_t *         storage_region_head = NULL;
     pdc_var_type_t          data_type;
 
     // find task
@@ -9413,6 +10191,8 @@ PDC_Server_recv_read_sel_obj_data(const struct hg_cb_info *callback_info)
                __func__, in->query_id, in->obj_id);
         goto done;
     }
+    if (PDC_Server_query_materialize_sel(task) != SUCCEED)
+        goto done;
     coords = task->query->sel->coords;
     nhits  = task->query->sel->nhits;
     ndim   = task->ndim;
@@ -9450,25 +10230,7 @@ PDC_Server_recv_read_sel_obj_data(const struct hg_cb_info *callback_info)
     }
 
     // We will read task->coords, from obj_id
-    data_off = 0;
-    for (i = 0; i < nhits; i++) {
-        coord = &(coords[i * ndim]);
-        DL_FOREACH(storage_region_head, region_elt)
-        {
-            if (is_coord_in_region(ndim, coord, unit_size, region_elt) == 1) {
-                buf_off      = coord_to_offset(ndim, coord, region_elt->start, region_elt->count, unit_size);
-                cache_region = region_elt;
-                if (region_elt->io_cache_region != NULL)
-                    cache_region = region_elt->io_cache_region;
-                if (cache_region->is_io_done != 1) {
-                    PDC_Server_data_read_to_buf_1_region(cache_region);
-                }
-                memcpy(task->my_data + data_off, cache_region->buf + buf_off, unit_size);
-                data_off += unit_size;
-                break;
-            }
-        }
-    } // End for
+    PDC_Server_read_coords_to_buf(storage_region_head, ndim, unit_size, coords, nhits, task->my_data);
 
     // Send read data back to client
     PDC_send_data_to_client(task->client_id, task->my_data, ndim, unit_size, nhits, task->query_id,
@@ -9540,3 +10302,229 @@ done:
         free(in);
     return ret;
 }
+
+/*
+ * A cursor fetch waiting for its hits to be pushed to the client
+ */
+typedef struct pdc_query_cursor_fetch_args_t {
+    hg_handle_t              handle;
+    hg_bulk_t                bulk_handle;
+    hg_bulk_t                client_bulk; // Reference on the bulk of the fetch input, freed with the args
+    void *                   buf;         // Freed after the transfer, NULL if the hits are sent from the task
+    query_cursor_fetch_out_t out;
+} pdc_query_cursor_fetch_args_t;
+
+static hg_return_t
+PDC_Server_query_cursor_fetch_cb(const struct hg_cb_info *callback_info)
+{
+    hg_return_t                    ret;
+    pdc_query_cursor_fetch_args_t *args = (pdc_query_cursor_fetch_args_t *)callback_info->arg;
+
+    if (callback_info->ret != HG_SUCCESS) {
+        printf("==PDC_SERVER[%d]: %s - error pushing query hits to client!\n", pdc_server_rank_g, __func__);
+        args->out.ret    = -1;
+        args->out.cnt    = 0;
+        args->out.nbytes = 0;
+    }
+
+    ret = HG_Respond(args->handle, NULL, NULL, &args->out);
+    if (ret != HG_SUCCESS)
+        printf("==PDC_SERVER[%d]: %s - error with HG_Respond!\n", pdc_server_rank_g, __func__);
+
+    HG_Bulk_free(args->bulk_handle);
+    HG_Bulk_free(args->client_bulk);
+    HG_Destroy(args->handle);
+    if (args->buf)
+        free(args->buf);
+    free(args);
+
+    return ret;
+}
+
+/*
+ * Coordinates of the hits [offset, offset + cnt) found by this server for a query. A task without bitmap
+ * selection holds their coordinates, otherwise they are built from the bitmap selection into a new buffer
+ * returned in alloc, so the whole selection is never materialized. Fetches that continue where the previous
+ * one stopped resume from the cursor of the task.
+ */
+static uint64_t *
+PDC_Server_query_cursor_coords(query_task_t *task, uint64_t offset, uint64_t cnt, uint64_t **alloc)
+{
+    *alloc = NULL;
+
+    if (task->bitmap_sel == NULL)
+        return task->query->sel->coords + offset * task->ndim;
+
+    if (task->cursor.pos != offset || task->cursor.iter.r == NULL)
+        PDC_Server_query_bitmap_sel_seek(task->bitmap_sel, &task->cursor, offset);
+
+    *alloc = (uint64_t *)malloc(cnt * task->ndim * sizeof(uint64_t));
+    if (*alloc == NULL)
+        return NULL;
+    if (PDC_Server_query_bitmap_sel_read_coords(task->bitmap_sel, &task->cursor, cnt, *alloc) != cnt) {
+        free(*alloc);
+        *alloc = NULL;
+    }
+
+    return *alloc;
+}
+
+hg_return_t
+PDC_Server_query_cursor_fetch(hg_handle_t handle, query_cursor_fetch_in_t *in)
+{
+    hg_return_t                    ret = HG_SUCCESS;
+    query_task_t *                 task_elt, *task = NULL;
+    pdc_query_cursor_fetch_args_t *args;
+    region_list_t *                storage_region_head;
+    pdc_var_type_t                 dtype;
+    const struct hg_info *         hg_info;
+    uint64_t                       cnt, nfound, *coords, *coords_alloc = NULL;
+    hg_size_t                      buf_size;
+    size_t                         unit_size;
+    uint64_t                       nhits;
+    void *                         buf;
+
+    args = (pdc_query_cursor_fetch_args_t *)calloc(1, sizeof(pdc_query_cursor_fetch_args_t));
+    if (args == NULL) {
+        printf("==PDC_SERVER[%d]: %s - error with calloc!\n", pdc_server_rank_g, __func__);
+        ret = HG_NOMEM_ERROR;
+        if (in->bulk_handle != HG_BULK_NULL)
+            HG_Bulk_free(in->bulk_handle);
+        HG_Destroy(handle);
+        goto done;
+    }
+    args->handle      = handle;
+    args->client_bulk = in->bulk_handle;
+    args->out.ret     = 1;
+
+    DL_FOREACH(query_task_list_head_g, task_elt)
+    {
+        if (task_elt->query_id == in->query_id) {
+            task = task_elt;
+            break;
+        }
+    }
+
+    // A server that has no storage region of the queried objects did not evaluate the query, it has no hits
+    if (NULL == task || task->query == NULL) {
+        if (in->is_close != 1 && in->cnt > 0) {
+            printf("==PDC_SERVER[%d]: %s - cannot find query task id=%d\n", pdc_server_rank_g, __func__,
+                   in->query_id);
+            args->out.ret = -1;
+        }
+        goto respond;
+    }
+
+    if (in->is_close == 1) {
+        DL_DELETE(query_task_list_head_g, task);
+        PDC_Server_free_query_task(task);
+        goto respond;
+    }
+
+    // The manager also holds the hits gathered from all servers, only the ones found here are served
+    nhits           = task->query->sel == NULL ? 0 : task->query->sel->nhits;
+    args->out.ndim  = task->ndim;
+    args->out.nhits = nhits;
+    if (in->offset >= nhits || in->cnt == 0 || in->bulk_handle == HG_BULK_NULL)
+        goto respond;
+
+    // Element size of what is pushed for each hit
+    storage_region_head = NULL;
+    if (in->obj_id == 0)
+        unit_size = task->ndim * sizeof(uint64_t);
+    else {
+        storage_region_head = PDC_Server_query_obj_region(task, in->obj_id, &dtype);
+        if (storage_region_head == NULL) {
+            printf("==PDC_SERVER[%d]: %s - cannot find storage region of obj %" PRIu64 "\n",
+                   pdc_server_rank_g, __func__, in->obj_id);
+            args->out.ret = -1;
+            goto respond;
+        }
+        unit_size = PDC_get_var_type_size(dtype);
+    }
+    if (unit_size == 0) {
+        args->out.ret = -1;
+        goto respond;
+    }
+
+    // The client asks for no more than it can hold
+    cnt = nhits - in->offset;
+    if (cnt > in->cnt)
+        cnt = in->cnt;
+    if (cnt > HG_Bulk_get_size(in->bulk_handle) / unit_size)
+        cnt = HG_Bulk_get_size(in->bulk_handle) / unit_size;
+    if (cnt == 0)
+        goto respond;
+
+    coords = PDC_Server_query_cursor_coords(task, in->offset, cnt, &coords_alloc);
+    if (coords == NULL) {
+        printf("==PDC_SERVER[%d]: %s - error getting %" PRIu64 " hits at %" PRIu64 "\n", pdc_server_rank_g,
+               __func__, cnt, in->offset);
+        args->out.ret = -1;
+        goto respond;
+    }
+
+    if (in->obj_id == 0) {
+        buf       = coords;
+        args->buf = coords_alloc;
+    }
+    else {
+        buf = calloc(cnt, unit_size);
+        if (buf == NULL) {
+            if (coords_alloc)
+                free(coords_alloc);
+            args->out.ret = -1;
+            goto respond;
+        }
+        nfound = PDC_Server_read_coords_to_buf(storage_region_head, task->ndim, unit_size, coords, cnt, buf);
+        if (coords_alloc)
+            free(coords_alloc);
+        args->buf = buf;
+        // The hits were found in the storage regions of this server, all of them must be read
+        if (nfound != cnt) {
+            printf("==PDC_SERVER[%d]: %s - cannot read %" PRIu64 " hits of obj %" PRIu64 "\n",
+                   pdc_server_rank_g, __func__, cnt - nfound, in->obj_id);
+            args->out.ret = -1;
+            goto respond;
+        }
+    }
+
+    buf_size = cnt * unit_size;
+    ret      = HG_Bulk_create(hg_class_g, 1, &buf, &buf_size, HG_BULK_READ_ONLY, &args->bulk_handle);
+    if (ret != HG_SUCCESS) {
+        printf("==PDC_SERVER[%d]: %s - could not create bulk data handle\n", pdc_server_rank_g, __func__);
+        args->out.ret = -1;
+        goto respond;
+    }
+    args->out.cnt    = cnt;
+    args->out.nbytes = buf_size;
+
+    hg_info = HG_Get_info(handle);
+    ret     = HG_Bulk_transfer(hg_info->context, PDC_Server_query_cursor_fetch_cb, args, HG_BULK_PUSH,
+                           hg_info->addr, in->bulk_handle, 0, args->bulk_handle, 0, buf_size,
+                           HG_OP_ID_IGNORE);
+    if (ret != HG_SUCCESS) {
+        printf("==PDC_SERVER[%d]: %s - could not push bulk data\n", pdc_server_rank_g, __func__);
+        args->out.ret    = -1;
+        args->out.cnt    = 0;
+        args->out.nbytes = 0;
+        goto respond;
+    }
+    goto done;
+
+respond:
+    ret = HG_Respond(handle, NULL, NULL, &args->out);
+    if (args->bulk_handle != HG_BULK_NULL)
+        HG_Bulk_free(args->bulk_handle);
+    if (args->client_bulk != HG_BULK_NULL)
+        HG_Bulk_free(args->client_bulk);
+    HG_Destroy(handle);
+    if (args->buf)
+        free(args->buf);
+    free(args);
+
+done:
+    fflush(stdout);
+
+    return ret;
+}
@@ -0,0 +1,473 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pdc_utlist.h"
+#include "pdc_server_query_bitmap.h"
+#include "pdc_server_query_kernel.h"
+
+#define PDC_QUERY_BITMAP_READ_BATCH 1024
+
+/*
+ * Convert the byte start and count of a storage region to elements
+ */
+static void
+pdc_query_bitmap_region_elements(region_list_t *region, size_t unit_size, uint64_t *start, uint64_t *count)
+{
+    size_t d;
+
+    memset(start, 0, DIM_MAX * sizeof(uint64_t));
+    memset(count, 0, DIM_MAX * sizeof(uint64_t));
+    for (d = 0; d < region->ndim && d < DIM_MAX; d++) {
+        start[d] = region->start[d] / unit_size;
+        count[d] = region->count[d] / unit_size;
+    }
+}
+
+/*
+ * Index of the region of the selection with this start and count, -1 if there is none. Constraints on
+ * objects with the same layout visit the regions in the same order, so the one after the last match is
+ * tried first.
+ */
+static int
+pdc_query_bitmap_find(pdc_query_bitmap_sel_t *bsel, const uint64_t *start, const uint64_t *count)
+{
+    int i, idx;
+
+    for (i = 0; i < bsel->n_region; i++) {
+        idx = (bsel->hint + i) % bsel->n_region;
+        if (memcmp(bsel->regions[idx].start, start, DIM_MAX * sizeof(uint64_t)) == 0 &&
+            memcmp(bsel->regions[idx].count, count, DIM_MAX * sizeof(uint64_t)) == 0) {
+            bsel->hint = idx + 1;
+            return idx;
+        }
+    }
+    return -1;
+}
+
+static int
+pdc_query_bitmap_is_overlap(pdc_query_bitmap_region_t *entry, const uint64_t *start, const uint64_t *count,
+                            int ndim)
+{
+    int d;
+
+    for (d = 0; d < ndim; d++) {
+        if (entry->start[d] >= start[d] + count[d] || start[d] >= entry->start[d] + entry->count[d])
+            return 0;
+    }
+    return 1;
+}
+
+static pdc_query_bitmap_region_t *
+pdc_query_bitmap_add_region(pdc_query_bitmap_sel_t *bsel, const uint64_t *start, const uint64_t *count)
+{
+    pdc_query_bitmap_region_t *regions, *entry;
+    int                        alloc;
+
+    if (bsel->n_region == bsel->alloc) {
+        alloc = bsel->alloc == 0 ? 64 : bsel->alloc * 2;
+        regions =
+            (pdc_query_bitmap_region_t *)realloc(bsel->regions, alloc * sizeof(pdc_query_bitmap_region_t));
+        if (NULL == regions)
+            return NULL;
+        bsel->regions = regions;
+        bsel->alloc   = alloc;
+    }
+
+    entry = &bsel->regions[bsel->n_region];
+    memset(entry, 0, sizeof(pdc_query_bitmap_region_t));
+    memcpy(entry->start, start, DIM_MAX * sizeof(uint64_t));
+    memcpy(entry->count, count, DIM_MAX * sizeof(uint64_t));
+    entry->bits = pdc_roaring_new();
+    if (NULL == entry->bits)
+        return NULL;
+    bsel->n_region++;
+    return entry;
+}
+
+pdc_query_bitmap_sel_t *
+PDC_Server_query_bitmap_sel_create()
+{
+    return (pdc_query_bitmap_sel_t *)calloc(1, sizeof(pdc_query_bitmap_sel_t));
+}
+
+void
+PDC_Server_query_bitmap_sel_free(pdc_query_bitmap_sel_t *bsel)
+{
+    int i;
+
+    if (NULL == bsel)
+        return;
+    for (i = 0; i < bsel->n_region; i++)
+        pdc_roaring_free(bsel->regions[i].bits);
+    free(bsel->regions);
+    free(bsel);
+}
+
+int
+PDC_Server_query_bitmap_sel_is_aligned(pdc_query_bitmap_sel_t *bsel, region_list_t *region_list_head,
+                                       size_t unit_size)
+{
+    region_list_t *region_elt;
+    uint64_t       start[DIM_MAX], count[DIM_MAX];
+    int            i;
+
+    DL_FOREACH(region_list_head, region_elt)
+    {
+        pdc_query_bitmap_region_elements(region_elt, unit_size, start, count);
+        if (pdc_query_bitmap_find(bsel, start, count) >= 0)
+            continue;
+        for (i = 0; i < bsel->n_region; i++) {
+            if (pdc_query_bitmap_is_overlap(&bsel->regions[i], start, count, region_elt->ndim))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+void
+PDC_Server_query_bitmap_sel_begin(pdc_query_bitmap_sel_t *bsel)
+{
+    int i;
+
+    for (i = 0; i < bsel->n_region; i++)
+        bsel->regions[i].is_evaluated = 0;
+}
+
+/*
+ * Find the region of the selection and mark it evaluated. Return 0 if a constraint over the region cannot
+ * change the selection.
+ */
+static int
+pdc_query_bitmap_prepare(pdc_query_bitmap_sel_t *bsel, region_list_t *region, size_t unit_size, uint64_t n,
+                         pdc_query_combine_op_t combine_op, pdc_query_bitmap_region_t **entry)
+{
+    uint64_t start[DIM_MAX], count[DIM_MAX];
+    int      idx;
+
+    *entry = NULL;
+    pdc_query_bitmap_region_elements(region, unit_size, start, count);
+    idx = pdc_query_bitmap_find(bsel, start, count);
+    if (idx >= 0) {
+        *entry                 = &bsel->regions[idx];
+        (*entry)->is_evaluated = 1;
+    }
+    // Nothing can survive an AND in a region without hits
+    if (n == 0)
+        return 0;
+    if (combine_op == PDC_QUERY_AND && (*entry == NULL || pdc_roaring_cardinality((*entry)->bits) == 0))
+        return 0;
+    return 1;
+}
+
+/*
+ * Combine the match mask of a region with its bitmap, entry is the region as found by
+ * pdc_query_bitmap_prepare
+ */
+static perr_t
+pdc_query_bitmap_combine(pdc_query_bitmap_sel_t *bsel, pdc_query_bitmap_region_t *entry, uint64_t *mask,
+                         uint64_t n, uint64_t nmatch, region_list_t *region, size_t unit_size,
+                         region_list_t *region_constraint, pdc_query_combine_op_t combine_op)
+{
+    perr_t         ret_value = SUCCEED;
+    pdc_roaring_t *match     = NULL;
+    uint64_t       start[DIM_MAX], count[DIM_MAX];
+
+    FUNC_ENTER(NULL);
+
+    if (combine_op == PDC_QUERY_AND) {
+        if (nmatch == 0) {
+            pdc_roaring_clear(entry->bits);
+            goto done;
+        }
+        match = pdc_roaring_new();
+        if (NULL == match || pdc_roaring_add_mask(match, mask, n) != 0 ||
+            pdc_roaring_and(entry->bits, match) != 0) {
+            printf("==PDC_SERVER[%d]: %s - error with bitmap AND!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+        goto done;
+    }
+
+    // A query has one region constraint, the hits already in the selection are within it
+    if (region_constraint != NULL && nmatch > 0)
+        nmatch = PDC_Server_query_kernel_constrain(mask, n, region, unit_size, region_constraint);
+    if (nmatch == 0)
+        goto done;
+
+    if (NULL == entry) {
+        pdc_query_bitmap_region_elements(region, unit_size, start, count);
+        entry = pdc_query_bitmap_add_region(bsel, start, count);
+        if (NULL == entry) {
+            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+        entry->is_evaluated = 1;
+        if (bsel->ndim == 0)
+            bsel->ndim = region->ndim;
+    }
+    if (pdc_roaring_add_mask(entry->bits, mask, n) != 0) {
+        printf("==PDC_SERVER[%d]: %s - error with bitmap OR!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+done:
+    pdc_roaring_free(match);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_query_bitmap_sel_evaluate(pdc_var_type_t type, const void *data, uint64_t n, region_list_t *region,
+                                     size_t unit_size, pdc_query_op_t lo_op, const void *lo,
+                                     pdc_query_op_t hi_op, const void *hi, region_list_t *region_constraint,
+                                     pdc_query_combine_op_t combine_op, pdc_query_bitmap_sel_t *bsel)
+{
+    perr_t                     ret_value = SUCCEED;
+    pdc_query_bitmap_region_t *entry     = NULL;
+    uint64_t *                 mask      = NULL;
+    uint64_t                   nmatch;
+
+    FUNC_ENTER(NULL);
+
+    if (region->ndim == 0 || region->ndim > 3) {
+        printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    if (pdc_query_bitmap_prepare(bsel, region, unit_size, n, combine_op, &entry) == 0)
+        goto done;
+
+    mask = (uint64_t *)malloc((n + 63) / 64 * sizeof(uint64_t));
+    if (NULL == mask) {
+        printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    ret_value = PDC_Server_query_kernel_scan(type, data, n, lo_op, lo, hi_op, hi, mask, &nmatch);
+    if (ret_value != SUCCEED)
+        goto done;
+    ret_value = pdc_query_bitmap_combine(bsel, entry, mask, n, nmatch, region, unit_size, region_constraint,
+                                         combine_op);
+
+done:
+    free(mask);
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_query_bitmap_sel_combine(uint64_t *mask, uint64_t n, uint64_t nmatch, region_list_t *region,
+                                    size_t unit_size, region_list_t *region_constraint,
+                                    pdc_query_combine_op_t combine_op, pdc_query_bitmap_sel_t *bsel)
+{
+    perr_t                     ret_value = SUCCEED;
+    pdc_query_bitmap_region_t *entry     = NULL;
+
+    FUNC_ENTER(NULL);
+
+    if (region->ndim == 0 || region->ndim > 3) {
+        printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    if (pdc_query_bitmap_prepare(bsel, region, unit_size, n, combine_op, &entry) == 0)
+        goto done;
+
+    ret_value = pdc_query_bitmap_combine(bsel, entry, mask, n, nmatch, region, unit_size, region_constraint,
+                                         combine_op);
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDC_Server_query_bitmap_sel_end(pdc_query_bitmap_sel_t *bsel, pdc_query_combine_op_t combine_op)
+{
+    int i;
+
+    bsel->nhits = 0;
+    for (i = 0; i < bsel->n_region; i++) {
+        if (combine_op == PDC_QUERY_AND && bsel->regions[i].is_evaluated == 0)
+            pdc_roaring_clear(bsel->regions[i].bits);
+        bsel->nhits += pdc_roaring_cardinality(bsel->regions[i].bits);
+    }
+}
+
+/*
+ * Write the coordinates of n hits of a region, given by their linear index in the region
+ */
+static void
+pdc_query_bitmap_idx_to_coords(pdc_query_bitmap_region_t *entry, int ndim, const uint64_t *idx_buf, size_t n,
+                               uint64_t *coords)
+{
+    uint64_t idx, n0, n1;
+    size_t   k;
+
+    n0 = entry->count[0];
+    n1 = ndim > 1 ? entry->count[1] : 1;
+    for (k = 0; k < n; k++) {
+        idx = idx_buf[k];
+        if (ndim == 1) {
+            coords[0] = idx + entry->start[0];
+        }
+        else {
+            coords[0] = idx % n0 + entry->start[0];
+            idx /= n0;
+            if (ndim == 2) {
+                coords[1] = idx + entry->start[1];
+            }
+            else {
+                coords[1] = idx % n1 + entry->start[1];
+                coords[2] = idx / n1 + entry->start[2];
+            }
+        }
+        coords += ndim;
+    }
+}
+
+perr_t
+PDC_Server_query_bitmap_sel_to_coords(pdc_query_bitmap_sel_t *bsel, pdc_selection_t *sel)
+{
+    perr_t                     ret_value = SUCCEED;
+    pdc_query_bitmap_region_t *entry;
+    pdc_roaring_iter_t         iter;
+    uint64_t                   buf[PDC_QUERY_BITMAP_READ_BATCH], need, *coords;
+    size_t                     nread;
+    int                        i, ndim = bsel->ndim;
+
+    FUNC_ENTER(NULL);
+
+    sel->nhits = 0;
+    if (bsel->nhits == 0)
+        goto done;
+
+    if (ndim <= 0 || ndim > 3) {
+        printf("==PDC_SERVER[%d]: %s - error with ndim = %d!\n", pdc_server_rank_g, __func__, ndim);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    need = bsel->nhits * ndim;
+    if (need > sel->coords_alloc) {
+        coords = (uint64_t *)realloc(sel->coords, need * sizeof(uint64_t));
+        if (NULL == coords) {
+            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+        sel->coords       = coords;
+        sel->coords_alloc = need;
+    }
+
+    coords = sel->coords;
+    for (i = 0; i < bsel->n_region; i++) {
+        entry = &bsel->regions[i];
+        pdc_roaring_iter_init(entry->bits, &iter);
+        while ((nread = pdc_roaring_iter_read(&iter, buf, PDC_QUERY_BITMAP_READ_BATCH)) > 0) {
+            pdc_query_bitmap_idx_to_coords(entry, ndim, buf, nread, coords);
+            coords += nread * ndim;
+            sel->nhits += nread;
+        }
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDC_Server_query_bitmap_sel_seek(pdc_query_bitmap_sel_t *bsel, pdc_query_bitmap_cursor_t *cursor,
+                                 uint64_t pos)
+{
+    uint64_t card, left;
+
+    if (pos > bsel->nhits)
+        pos = bsel->nhits;
+
+    // Whole regions are skipped by their number of hits
+    left = pos;
+    for (cursor->region = 0; cursor->region < bsel->n_region; cursor->region++) {
+        card = pdc_roaring_cardinality(bsel->regions[cursor->region].bits);
+        if (card > left)
+            break;
+        left -= card;
+    }
+
+    if (cursor->region < bsel->n_region) {
+        pdc_roaring_iter_init(bsel->regions[cursor->region].bits, &cursor->iter);
+        pdc_roaring_iter_skip(&cursor->iter, left);
+    }
+    cursor->pos = pos;
+}
+
+uint64_t
+PDC_Server_query_bitmap_sel_read_coords(pdc_query_bitmap_sel_t *bsel, pdc_query_bitmap_cursor_t *cursor,
+                                        uint64_t n, uint64_t *coords)
+{
+    pdc_query_bitmap_region_t *entry;
+    uint64_t                   buf[PDC_QUERY_BITMAP_READ_BATCH], count = 0;
+    size_t                     nread, batch;
+    int                        ndim = bsel->ndim;
+
+    if (ndim <= 0 || ndim > 3)
+        return 0;
+
+    while (count < n && cursor->region < bsel->n_region) {
+        entry = &bsel->regions[cursor->region];
+        batch = n - count < PDC_QUERY_BITMAP_READ_BATCH ? n - count : PDC_QUERY_BITMAP_READ_BATCH;
+        nread = pdc_roaring_iter_read(&cursor->iter, buf, batch);
+        if (nread == 0) {
+            if (++cursor->region < bsel->n_region)
+                pdc_roaring_iter_init(bsel->regions[cursor->region].bits, &cursor->iter);
+            continue;
+        }
+        pdc_query_bitmap_idx_to_coords(entry, ndim, buf, nread, coords + count * ndim);
+        count += nread;
+    }
+    cursor->pos += count;
+
+    return count;
+}
+
+pdc_roaring_t *
+PDC_Server_query_bitmap_sel_region_bits(pdc_query_bitmap_sel_t *bsel, region_list_t *region, size_t unit_size)
+{
+    uint64_t start[DIM_MAX], count[DIM_MAX];
+    int      idx;
+
+    pdc_query_bitmap_region_elements(region, unit_size, start, count);
+    idx = pdc_query_bitmap_find(bsel, start, count);
+
+    return idx < 0 ? NULL : bsel->regions[idx].bits;
+}
+
+uint64_t
+PDC_Server_query_bitmap_gather(const pdc_roaring_t *bits, const void *data, size_t unit_size, void *out)
+{
+    pdc_roaring_iter_t iter;
+    uint64_t           buf[PDC_QUERY_BITMAP_READ_BATCH], count = 0;
+    size_t             nread, k;
+
+    pdc_roaring_iter_init(bits, &iter);
+    while ((nread = pdc_roaring_iter_read(&iter, buf, PDC_QUERY_BITMAP_READ_BATCH)) > 0) {
+        switch (unit_size) {
+            case 4:
+                for (k = 0; k < nread; k++)
+                    ((uint32_t *)out)[count + k] = ((const uint32_t *)data)[buf[k]];
+                break;
+            case 8:
+                for (k = 0; k < nread; k++)
+                    ((uint64_t *)out)[count + k] = ((const uint64_t *)data)[buf[k]];
+                break;
+            default:
+                for (k = 0; k < nread; k++)
+                    memcpy((char *)out + (count + k) * unit_size, (const char *)data + buf[k] * unit_size,
+                           unit_size);
+                break;
+        }
+        count += nread;
+    }
+
+    return count;
+}
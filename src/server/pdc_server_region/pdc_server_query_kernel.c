@@ -0,0 +1,566 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pdc_server_query_kernel.h"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/*
+ * Operator combinations a kernel is specialized for.
+ */
+typedef enum {
+    PDC_QUERY_KERNEL_GT = 0,
+    PDC_QUERY_KERNEL_GTE,
+    PDC_QUERY_KERNEL_LT,
+    PDC_QUERY_KERNEL_LTE,
+    PDC_QUERY_KERNEL_EQ,
+    PDC_QUERY_KERNEL_GT_LT,
+    PDC_QUERY_KERNEL_GT_LTE,
+    PDC_QUERY_KERNEL_GTE_LT,
+    PDC_QUERY_KERNEL_GTE_LTE,
+    PDC_QUERY_KERNEL_COUNT
+} pdc_query_kernel_id_t;
+
+typedef void (*pdc_query_kernel_func)(const void *data, uint64_t n, const void *lo, const void *hi,
+                                      uint64_t *mask);
+
+/*
+ * Scalar kernel, PRED is evaluated on the element x against lo and hi and must be 0 or 1.
+ */
+#define PDC_QUERY_KERNEL_SCALAR(TYPE, NAME, PRED)                                                            \
+    static void NAME(const void *_data, uint64_t n, const void *_lo, const void *_hi, uint64_t *mask)        \
+    {                                                                                                        \
+        const TYPE *data = (const TYPE *)_data;                                                              \
+        TYPE        lo = *((const TYPE *)_lo), hi = *((const TYPE *)_hi), x;                                 \
+        uint64_t    i, j, word;                                                                              \
+                                                                                                             \
+        (void)lo;                                                                                            \
+        (void)hi;                                                                                            \
+        for (i = 0; i + 64 <= n; i += 64) {                                                                  \
+            word = 0;                                                                                        \
+            for (j = 0; j < 64; j++) {                                                                       \
+                x = data[i + j];                                                                             \
+                word |= (uint64_t)(PRED) << j;                                                               \
+            }                                                                                                \
+            mask[i / 64] = word;                                                                             \
+        }                                                                                                    \
+        if (i < n) {                                                                                         \
+            word = 0;                                                                                        \
+            for (j = 0; i + j < n; j++) {                                                                    \
+                x = data[i + j];                                                                             \
+                word |= (uint64_t)(PRED) << j;                                                               \
+            }                                                                                                \
+            mask[i / 64] = word;                                                                             \
+        }                                                                                                    \
+    }
+
+#define PDC_QUERY_KERNEL_SCALAR_ALL(TYPE, SUFFIX)                                                            \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gt, x > lo)                                    \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gte, x >= lo)                                  \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_lt, x < lo)                                    \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_lte, x <= lo)                                  \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_eq, x == lo)                                   \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gt_lt, (x > lo) & (x < hi))                    \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gt_lte, (x > lo) & (x <= hi))                  \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gte_lt, (x >= lo) & (x < hi))                  \
+    PDC_QUERY_KERNEL_SCALAR(TYPE, pdc_query_kernel_##SUFFIX##_gte_lte, (x >= lo) & (x <= hi))                \
+    static const pdc_query_kernel_func pdc_query_kernel_##SUFFIX[PDC_QUERY_KERNEL_COUNT] = {                 \
+        pdc_query_kernel_##SUFFIX##_gt,     pdc_query_kernel_##SUFFIX##_gte,                                 \
+        pdc_query_kernel_##SUFFIX##_lt,     pdc_query_kernel_##SUFFIX##_lte,                                 \
+        pdc_query_kernel_##SUFFIX##_eq,     pdc_query_kernel_##SUFFIX##_gt_lt,                               \
+        pdc_query_kernel_##SUFFIX##_gt_lte, pdc_query_kernel_##SUFFIX##_gte_lt,                              \
+        pdc_query_kernel_##SUFFIX##_gte_lte};
+
+PDC_QUERY_KERNEL_SCALAR_ALL(float, float)
+PDC_QUERY_KERNEL_SCALAR_ALL(double, double)
+PDC_QUERY_KERNEL_SCALAR_ALL(int, int)
+PDC_QUERY_KERNEL_SCALAR_ALL(uint32_t, uint)
+PDC_QUERY_KERNEL_SCALAR_ALL(int64_t, int64)
+PDC_QUERY_KERNEL_SCALAR_ALL(uint64_t, uint64)
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#define PDC_QUERY_KERNEL_SIMD 1
+
+#if defined(__AVX512F__)
+#define PDC_QUERY_KERNEL_PS          __m512
+#define PDC_QUERY_KERNEL_PS_WIDTH    16
+#define PDC_QUERY_KERNEL_PS_LOAD     _mm512_loadu_ps
+#define PDC_QUERY_KERNEL_PS_SET1     _mm512_set1_ps
+#define PDC_QUERY_KERNEL_PS_CMP(x, v, op) _mm512_cmp_ps_mask(x, v, op)
+#define PDC_QUERY_KERNEL_PD          __m512d
+#define PDC_QUERY_KERNEL_PD_WIDTH    8
+#define PDC_QUERY_KERNEL_PD_LOAD     _mm512_loadu_pd
+#define PDC_QUERY_KERNEL_PD_SET1     _mm512_set1_pd
+#define PDC_QUERY_KERNEL_PD_CMP(x, v, op) _mm512_cmp_pd_mask(x, v, op)
+// Comparisons produce bit masks, no conversion needed
+#define PDC_QUERY_KERNEL_PS_AND(a, b) ((a) & (b))
+#define PDC_QUERY_KERNEL_PS_BITS(m)   (m)
+#define PDC_QUERY_KERNEL_PD_AND(a, b) ((a) & (b))
+#define PDC_QUERY_KERNEL_PD_BITS(m)   (m)
+#else
+#define PDC_QUERY_KERNEL_PS          __m256
+#define PDC_QUERY_KERNEL_PS_WIDTH    8
+#define PDC_QUERY_KERNEL_PS_LOAD     _mm256_loadu_ps
+#define PDC_QUERY_KERNEL_PS_SET1     _mm256_set1_ps
+#define PDC_QUERY_KERNEL_PS_CMP(x, v, op) _mm256_cmp_ps(x, v, op)
+#define PDC_QUERY_KERNEL_PD          __m256d
+#define PDC_QUERY_KERNEL_PD_WIDTH    4
+#define PDC_QUERY_KERNEL_PD_LOAD     _mm256_loadu_pd
+#define PDC_QUERY_KERNEL_PD_SET1     _mm256_set1_pd
+#define PDC_QUERY_KERNEL_PD_CMP(x, v, op) _mm256_cmp_pd(x, v, op)
+// Comparisons produce lane masks, movemask packs their sign bits
+#define PDC_QUERY_KERNEL_PS_AND(a, b) _mm256_and_ps(a, b)
+#define PDC_QUERY_KERNEL_PS_BITS(m)   _mm256_movemask_ps(m)
+#define PDC_QUERY_KERNEL_PD_AND(a, b) _mm256_and_pd(a, b)
+#define PDC_QUERY_KERNEL_PD_BITS(m)   _mm256_movemask_pd(m)
+#endif
+
+/*
+ * SIMD kernel, PRED is evaluated on the vector x against vlo and vhi and gives one bit per lane.
+ * The elements after the last full block of 64 are handled by the scalar kernel.
+ */
+#define PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, NAME, SCALAR, PRED)                            \
+    static void NAME(const void *_data, uint64_t n, const void *_lo, const void *_hi, uint64_t *mask)        \
+    {                                                                                                        \
+        const TYPE *data = (const TYPE *)_data;                                                              \
+        VEC         vlo = SET1(*((const TYPE *)_lo)), vhi = SET1(*((const TYPE *)_hi)), x;                   \
+        uint64_t    i, j, word, nfull = n / 64 * 64;                                                         \
+                                                                                                             \
+        (void)vlo;                                                                                           \
+        (void)vhi;                                                                                           \
+        for (i = 0; i < nfull; i += 64) {                                                                    \
+            word = 0;                                                                                        \
+            for (j = 0; j < 64; j += WIDTH) {                                                                \
+                x = LOAD(data + i + j);                                                                      \
+                word |= (uint64_t)(PRED) << j;                                                               \
+            }                                                                                                \
+            mask[i / 64] = word;                                                                             \
+        }                                                                                                    \
+        if (nfull < n)                                                                                       \
+            SCALAR(data + nfull, n - nfull, _lo, _hi, mask + nfull / 64);                                    \
+    }
+
+#define PDC_QUERY_KERNEL_VECTOR_ALL(TYPE, SUFFIX, VEC, WIDTH, LOAD, SET1, CMP, AND, BITS)                    \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gt,               \
+                            pdc_query_kernel_##SUFFIX##_gt, BITS(CMP(x, vlo, _CMP_GT_OQ)))                   \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gte,              \
+                            pdc_query_kernel_##SUFFIX##_gte, BITS(CMP(x, vlo, _CMP_GE_OQ)))                  \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_lt,               \
+                            pdc_query_kernel_##SUFFIX##_lt, BITS(CMP(x, vlo, _CMP_LT_OQ)))                   \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_lte,              \
+                            pdc_query_kernel_##SUFFIX##_lte, BITS(CMP(x, vlo, _CMP_LE_OQ)))                  \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_eq,               \
+                            pdc_query_kernel_##SUFFIX##_eq, BITS(CMP(x, vlo, _CMP_EQ_OQ)))                   \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gt_lt,            \
+                            pdc_query_kernel_##SUFFIX##_gt_lt,                                               \
+                            BITS(AND(CMP(x, vlo, _CMP_GT_OQ), CMP(x, vhi, _CMP_LT_OQ))))                     \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gt_lte,           \
+                            pdc_query_kernel_##SUFFIX##_gt_lte,                                              \
+                            BITS(AND(CMP(x, vlo, _CMP_GT_OQ), CMP(x, vhi, _CMP_LE_OQ))))                     \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gte_lt,           \
+                            pdc_query_kernel_##SUFFIX##_gte_lt,                                              \
+                            BITS(AND(CMP(x, vlo, _CMP_GE_OQ), CMP(x, vhi, _CMP_LT_OQ))))                     \
+    PDC_QUERY_KERNEL_VECTOR(TYPE, VEC, WIDTH, LOAD, SET1, pdc_query_kernel_##SUFFIX##_simd_gte_lte,          \
+                            pdc_query_kernel_##SUFFIX##_gte_lte,                                             \
+                            BITS(AND(CMP(x, vlo, _CMP_GE_OQ), CMP(x, vhi, _CMP_LE_OQ))))                     \
+    static const pdc_query_kernel_func pdc_query_kernel_##SUFFIX##_simd[PDC_QUERY_KERNEL_COUNT] = {          \
+        pdc_query_kernel_##SUFFIX##_simd_gt,     pdc_query_kernel_##SUFFIX##_simd_gte,                       \
+        pdc_query_kernel_##SUFFIX##_simd_lt,     pdc_query_kernel_##SUFFIX##_simd_lte,                       \
+        pdc_query_kernel_##SUFFIX##_simd_eq,     pdc_query_kernel_##SUFFIX##_simd_gt_lt,                     \
+        pdc_query_kernel_##SUFFIX##_simd_gt_lte, pdc_query_kernel_##SUFFIX##_simd_gte_lt,                    \
+        pdc_query_kernel_##SUFFIX##_simd_gte_lte};
+
+PDC_QUERY_KERNEL_VECTOR_ALL(float, float, PDC_QUERY_KERNEL_PS, PDC_QUERY_KERNEL_PS_WIDTH,
+                            PDC_QUERY_KERNEL_PS_LOAD, PDC_QUERY_KERNEL_PS_SET1, PDC_QUERY_KERNEL_PS_CMP,
+                            PDC_QUERY_KERNEL_PS_AND, PDC_QUERY_KERNEL_PS_BITS)
+PDC_QUERY_KERNEL_VECTOR_ALL(double, double, PDC_QUERY_KERNEL_PD, PDC_QUERY_KERNEL_PD_WIDTH,
+                            PDC_QUERY_KERNEL_PD_LOAD, PDC_QUERY_KERNEL_PD_SET1, PDC_QUERY_KERNEL_PD_CMP,
+                            PDC_QUERY_KERNEL_PD_AND, PDC_QUERY_KERNEL_PD_BITS)
+#endif
+
+/*
+ * Map an operator, or the two operators of a range ordered as lower and upper bound, to a kernel.
+ * Return -1 if the combination is not supported.
+ */
+static int
+pdc_query_kernel_id(pdc_query_op_t lo_op, pdc_query_op_t hi_op)
+{
+    if (hi_op == PDC_OP_NONE) {
+        switch (lo_op) {
+            case PDC_GT:
+                return PDC_QUERY_KERNEL_GT;
+            case PDC_GTE:
+                return PDC_QUERY_KERNEL_GTE;
+            case PDC_LT:
+                return PDC_QUERY_KERNEL_LT;
+            case PDC_LTE:
+                return PDC_QUERY_KERNEL_LTE;
+            case PDC_EQ:
+                return PDC_QUERY_KERNEL_EQ;
+            default:
+                return -1;
+        }
+    }
+
+    if (lo_op == PDC_GT && hi_op == PDC_LT)
+        return PDC_QUERY_KERNEL_GT_LT;
+    if (lo_op == PDC_GT && hi_op == PDC_LTE)
+        return PDC_QUERY_KERNEL_GT_LTE;
+    if (lo_op == PDC_GTE && hi_op == PDC_LT)
+        return PDC_QUERY_KERNEL_GTE_LT;
+    if (lo_op == PDC_GTE && hi_op == PDC_LTE)
+        return PDC_QUERY_KERNEL_GTE_LTE;
+    return -1;
+}
+
+static const pdc_query_kernel_func *
+pdc_query_kernel_table(pdc_var_type_t type)
+{
+    switch (type) {
+#ifdef PDC_QUERY_KERNEL_SIMD
+        case PDC_FLOAT:
+            return pdc_query_kernel_float_simd;
+        case PDC_DOUBLE:
+            return pdc_query_kernel_double_simd;
+#else
+        case PDC_FLOAT:
+            return pdc_query_kernel_float;
+        case PDC_DOUBLE:
+            return pdc_query_kernel_double;
+#endif
+        case PDC_INT:
+            return pdc_query_kernel_int;
+        case PDC_UINT:
+            return pdc_query_kernel_uint;
+        case PDC_INT64:
+            return pdc_query_kernel_int64;
+        case PDC_UINT64:
+            return pdc_query_kernel_uint64;
+        default:
+            return NULL;
+    }
+}
+
+perr_t
+PDC_Server_query_kernel_scan(pdc_var_type_t type, const void *data, uint64_t n, pdc_query_op_t lo_op,
+                             const void *lo, pdc_query_op_t hi_op, const void *hi, uint64_t *mask,
+                             uint64_t *nmatch)
+{
+    perr_t                       ret_value = SUCCEED;
+    const pdc_query_kernel_func *table;
+    const void *                 tmp;
+    pdc_query_op_t               tmp_op;
+    uint64_t                     i;
+    int                          id;
+
+    FUNC_ENTER(NULL);
+
+    *nmatch = 0;
+    if (n == 0)
+        goto done;
+
+    // The bounds of a range can come in either order
+    if (hi_op != PDC_OP_NONE && (lo_op == PDC_LT || lo_op == PDC_LTE)) {
+        tmp_op = lo_op;
+        lo_op  = hi_op;
+        hi_op  = tmp_op;
+        tmp    = lo;
+        lo     = hi;
+        hi     = tmp;
+    }
+
+    id = pdc_query_kernel_id(lo_op, hi_op);
+    if (id < 0) {
+        printf("==PDC_SERVER[%d]: %s - error with operator type!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    table = pdc_query_kernel_table(type);
+    if (table == NULL) {
+        printf("==PDC_SERVER[%d]: %s - error with data type %d!\n", pdc_server_rank_g, __func__, type);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    table[id](data, n, lo, hi_op == PDC_OP_NONE ? lo : hi, mask);
+    for (i = 0; i < (n + 63) / 64; i++)
+        *nmatch += __builtin_popcountll(mask[i]);
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Clear the bits [from, to) of a mask
+ */
+static void
+pdc_query_kernel_clear_bits(uint64_t *mask, uint64_t from, uint64_t to)
+{
+    uint64_t word;
+
+    while (from < to) {
+        word = from / 64;
+        if (from % 64 == 0 && to - from >= 64) {
+            mask[word] = 0;
+            from += 64;
+        }
+        else {
+            mask[word] &= ~(1ULL << (from % 64));
+            from++;
+        }
+    }
+}
+
+uint64_t
+PDC_Server_query_kernel_constrain(uint64_t *mask, uint64_t n, region_list_t *region, size_t unit_size,
+                                  region_list_t *constraint)
+{
+    uint64_t row_len, row, begin, end, lo, hi, c, coord, dim, nmatch = 0;
+    int      d, in_row;
+
+    // Elements of a row share their coordinates in dimensions 1 and 2, only dimension 0 varies
+    row_len = region->ndim > 1 ? region->count[0] / unit_size : n;
+    if (row_len == 0)
+        return 0;
+
+    if (constraint->start[0] <= region->start[0])
+        lo = 0;
+    else
+        lo = (constraint->start[0] - region->start[0] + unit_size - 1) / unit_size;
+    if (constraint->start[0] + constraint->count[0] < region->start[0])
+        hi = 0;
+    else
+        hi = (constraint->start[0] + constraint->count[0] - region->start[0]) / unit_size + 1;
+    if (hi > row_len)
+        hi = row_len;
+
+    for (row = 0; row * row_len < n; row++) {
+        in_row = 1;
+        c      = row;
+        for (d = 1; d < (int)region->ndim; d++) {
+            dim   = region->count[d] / unit_size;
+            coord = (c % dim) * unit_size + region->start[d];
+            c /= dim;
+            if (coord < constraint->start[d] || coord > constraint->start[d] + constraint->count[d])
+                in_row = 0;
+        }
+
+        begin = row * row_len;
+        end   = begin + row_len < n ? begin + row_len : n;
+        if (in_row == 0 || lo >= hi) {
+            pdc_query_kernel_clear_bits(mask, begin, end);
+        }
+        else {
+            pdc_query_kernel_clear_bits(mask, begin, begin + lo);
+            pdc_query_kernel_clear_bits(mask, begin + hi, end);
+        }
+    }
+
+    for (row = 0; row < (n + 63) / 64; row++)
+        nmatch += __builtin_popcountll(mask[row]);
+    return nmatch;
+}
+
+perr_t
+PDC_Server_query_kernel_scan_region(pdc_var_type_t type, const void *data, uint64_t n, region_list_t *region,
+                                    size_t unit_size, pdc_query_op_t lo_op, const void *lo,
+                                    pdc_query_op_t hi_op, const void *hi, region_list_t *region_constraint,
+                                    uint64_t *mask, uint64_t *nmatch)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    ret_value = PDC_Server_query_kernel_scan(type, data, n, lo_op, lo, hi_op, hi, mask, nmatch);
+    if (ret_value != SUCCEED)
+        goto done;
+
+    if (region_constraint != NULL && *nmatch > 0)
+        *nmatch = PDC_Server_query_kernel_constrain(mask, n, region, unit_size, region_constraint);
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+void
+PDC_Server_query_kernel_mask_to_coords(const uint64_t *mask, uint64_t nword, region_list_t *region,
+                                       size_t unit_size, uint64_t *coords)
+{
+    int      ndim = region->ndim;
+    uint64_t w, word, idx, n0, n1, start[3] = {0, 0, 0};
+    int      d;
+
+    for (d = 0; d < ndim; d++)
+        start[d] = region->start[d] / unit_size;
+    n0 = region->count[0] / unit_size;
+    n1 = ndim > 1 ? region->count[1] / unit_size : 1;
+
+    for (w = 0; w < nword; w++) {
+        word = mask[w];
+        while (word != 0) {
+            idx = w * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+            if (ndim == 1) {
+                coords[0] = idx + start[0];
+            }
+            else {
+                coords[0] = idx % n0 + start[0];
+                idx /= n0;
+                if (ndim == 2) {
+                    coords[1] = idx + start[1];
+                }
+                else {
+                    coords[1] = idx % n1 + start[1];
+                    coords[2] = idx / n1 + start[2];
+                }
+            }
+            coords += ndim;
+        }
+    }
+}
+
+perr_t
+PDC_Server_query_kernel_reserve_coords(pdc_selection_t *sel, uint64_t nhits, int ndim)
+{
+    perr_t    ret_value = SUCCEED;
+    uint64_t  need, alloc;
+    uint64_t *coords;
+
+    FUNC_ENTER(NULL);
+
+    need = nhits * ndim;
+    if (need > sel->coords_alloc) {
+        alloc  = sel->coords_alloc * 2 > need ? sel->coords_alloc * 2 : need;
+        coords = (uint64_t *)realloc(sel->coords, alloc * sizeof(uint64_t));
+        if (NULL == coords) {
+            printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+            ret_value = FAIL;
+            goto done;
+        }
+        sel->coords       = coords;
+        sel->coords_alloc = alloc;
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Append the coordinates of the nmatch set bits of a mask to the selection
+ */
+static perr_t
+pdc_query_kernel_append_coords(const uint64_t *mask, uint64_t nword, uint64_t nmatch, region_list_t *region,
+                               size_t unit_size, pdc_selection_t *sel)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    ret_value = PDC_Server_query_kernel_reserve_coords(sel, sel->nhits + nmatch, region->ndim);
+    if (ret_value != SUCCEED)
+        goto done;
+    PDC_Server_query_kernel_mask_to_coords(mask, nword, region, unit_size,
+                                           sel->coords + sel->nhits * region->ndim);
+    sel->nhits += nmatch;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Remove the coordinates of the selection that are in the region and whose bit is not set
+ */
+static void
+pdc_query_kernel_filter_coords(const uint64_t *mask, uint64_t n, region_list_t *region, size_t unit_size,
+                               pdc_selection_t *sel)
+{
+    int       ndim = region->ndim, d, keep;
+    uint64_t  i, kept = 0, idx, start, count;
+    uint64_t *coord;
+
+    for (i = 0; i < sel->nhits; i++) {
+        coord = sel->coords + i * ndim;
+        keep  = 1;
+        idx   = 0;
+        for (d = ndim - 1; d >= 0; d--) {
+            start = region->start[d] / unit_size;
+            count = region->count[d] / unit_size;
+            if (coord[d] < start || coord[d] >= start + count)
+                break;
+            idx = idx * count + coord[d] - start;
+        }
+        // Coordinates outside of this region are kept for the other regions to decide
+        if (d < 0 && idx < n)
+            keep = (mask[idx / 64] >> (idx % 64)) & 1;
+
+        if (keep) {
+            if (kept != i)
+                memmove(sel->coords + kept * ndim, coord, ndim * sizeof(uint64_t));
+            kept++;
+        }
+    }
+    sel->nhits = kept;
+}
+
+perr_t
+PDC_Server_query_kernel_combine(uint64_t *mask, uint64_t n, uint64_t nmatch, region_list_t *region,
+                                size_t unit_size, region_list_t *region_constraint,
+                                pdc_query_combine_op_t combine_op, pdc_selection_t *sel)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    if (combine_op == PDC_QUERY_NONE || combine_op == PDC_QUERY_OR) {
+        if (region_constraint != NULL && nmatch > 0)
+            nmatch = PDC_Server_query_kernel_constrain(mask, n, region, unit_size, region_constraint);
+        if (nmatch > 0)
+            ret_value = pdc_query_kernel_append_coords(mask, (n + 63) / 64, nmatch, region, unit_size, sel);
+    }
+    else if (combine_op == PDC_QUERY_AND) {
+        // No need to check for region constraint as a query has one region constraint only
+        pdc_query_kernel_filter_coords(mask, n, region, unit_size, sel);
+    }
+
+    FUNC_LEAVE(ret_value);
+}
+
+perr_t
+PDC_Server_query_kernel_evaluate(pdc_var_type_t type, const void *data, uint64_t n, region_list_t *region,
+                                 size_t unit_size, pdc_query_op_t lo_op, const void *lo, pdc_query_op_t hi_op,
+                                 const void *hi, region_list_t *region_constraint,
+                                 pdc_query_combine_op_t combine_op, pdc_selection_t *sel)
+{
+    perr_t    ret_value = SUCCEED;
+    uint64_t *mask      = NULL;
+    uint64_t  nmatch;
+
+    FUNC_ENTER(NULL);
+
+    if (region->ndim == 0 || region->ndim > 3) {
+        printf("==PDC_SERVER[%d]: %s - dimension > 3 not supported!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+    if (n == 0)
+        goto done;
+
+    mask = (uint64_t *)malloc((n + 63) / 64 * sizeof(uint64_t));
+    if (NULL == mask) {
+        printf("==PDC_SERVER[%d]: %s - error with malloc!\n", pdc_server_rank_g, __func__);
+        ret_value = FAIL;
+        goto done;
+    }
+
+    ret_value = PDC_Server_query_kernel_scan(type, data, n, lo_op, lo, hi_op, hi, mask, &nmatch);
+    if (ret_value != SUCCEED)
+        goto done;
+    ret_value = PDC_Server_query_kernel_combine(mask, n, nmatch, region, unit_size, region_constraint,
+                                                combine_op, sel);
+
+done:
+    free(mask);
+    FUNC_LEAVE(ret_value);
+}
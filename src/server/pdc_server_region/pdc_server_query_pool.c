@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pdc_server_query_pool.h"
+#include "thpool.h"
+
+static threadpool pdc_server_query_pool_g    = NULL;
+static int        pdc_server_query_nthread_g = 0;
+
+perr_t
+PDC_Server_query_pool_init()
+{
+    char *p;
+    int   nthread;
+
+    FUNC_ENTER(NULL);
+
+    nthread = PDC_SERVER_QUERY_NTHREAD;
+    p       = getenv("PDC_SERVER_QUERY_NTHREAD");
+    if (p != NULL)
+        nthread = atoi(p);
+
+    if (nthread > 0) {
+        pdc_server_query_pool_g = thpool_init(nthread);
+        if (pdc_server_query_pool_g == NULL) {
+            printf("==PDC_SERVER[%d]: %s - unable to start %d query workers, evaluating inline\n",
+                   pdc_server_rank_g, __func__, nthread);
+            nthread = 0;
+        }
+    }
+    pdc_server_query_nthread_g = nthread > 0 ? nthread : 0;
+
+    FUNC_LEAVE(SUCCEED);
+}
+
+perr_t
+PDC_Server_query_pool_finalize()
+{
+    FUNC_ENTER(NULL);
+
+    if (pdc_server_query_pool_g != NULL) {
+        thpool_wait(pdc_server_query_pool_g);
+        thpool_destroy(pdc_server_query_pool_g);
+        pdc_server_query_pool_g = NULL;
+    }
+    pdc_server_query_nthread_g = 0;
+
+    FUNC_LEAVE(SUCCEED);
+}
+
+int
+PDC_Server_query_pool_nthread()
+{
+    return pdc_server_query_nthread_g;
+}
+
+void
+PDC_Server_query_pool_run(pdc_server_query_job_func func, void *args, size_t n, size_t arg_size)
+{
+    size_t i;
+
+    // A single job gains nothing from a worker
+    if (pdc_server_query_pool_g == NULL || n < 2) {
+        for (i = 0; i < n; i++)
+            func((char *)args + i * arg_size);
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (thpool_add_work(pdc_server_query_pool_g, func, (char *)args + i * arg_size) != 0)
+            func((char *)args + i * arg_size);
+    }
+    thpool_wait(pdc_server_query_pool_g);
+}
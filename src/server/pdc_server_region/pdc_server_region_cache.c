@@ -1,5 +1,7 @@
 #include "pdc_server_region_cache.h"
 #include "pdc_timing.h"
+#include "pdc_hash-table.h"
+#include "pdc_region_index.h"
 
 #ifdef PDC_SERVER_CACHE
 
@@ -9,12 +11,27 @@
 #define MAX_CACHE_SIZE 34359738368
 #endif
 
+// Background write-back starts above the high watermark and stops below the low watermark, both are
+// percentages of the maximum cache size.
+#define PDC_CACHE_HIGH_WATERMARK 90
+#define PDC_CACHE_LOW_WATERMARK  70
+
 #ifdef PDC_SERVER_CACHE_FLUSH_TIME
 #define PDC_CACHE_FLUSH_TIME_INT PDC_SERVER_CACHE_FLUSH_TIME
 #else
 #define PDC_CACHE_FLUSH_TIME_INT 30
 #endif
 
+#define PDC_CACHE_NUM_SHARDS 64
+
+// Objects with cached data are linked into two lists: by last access for eviction, and by the time of their
+// last cached write for periodic flushing.
+#define PDC_CACHE_LRU_LIST   0
+#define PDC_CACHE_FLUSH_LIST 1
+#define PDC_CACHE_NUM_LISTS  2
+// A partial cache hit is served from at most this many uncovered subregions read from storage.
+#define PDC_CACHE_MAX_READ_HOLES 64
+
 typedef struct pdc_region_cache {
     struct pdc_region_info * region_cache_info;
     struct pdc_region_cache *next;
@@ -28,27 +45,267 @@ typedef struct pdc_obj_cache {
     pdc_region_cache *    region_cache;
     pdc_region_cache *    region_cache_end;
     int                   region_cache_size;
-    struct timeval        timestamp;
+    // Element type, PDC_UNKNOWN until a write request carries it, guarded by mutex.
+    pdc_var_type_t data_type;
+    // Bytes of region data cached for this object.
+    size_t cache_bytes;
+    // Position in the LRU and flush lists, guarded by pdc_cache_mutex.
+    struct pdc_obj_cache *list_prev[PDC_CACHE_NUM_LISTS];
+    struct pdc_obj_cache *list_next[PDC_CACHE_NUM_LISTS];
+    int                   in_list[PDC_CACHE_NUM_LISTS];
+    // Spatial index over region_cache, 1D uses an interval tree and N-D an R-tree.
+    pdc_region_index_t *region_index;
+    // Protects the region list and index of this object.
+    pthread_mutex_t mutex;
+    // Time of the last cached write, guarded by pdc_cache_mutex.
+    struct timeval timestamp;
 } pdc_obj_cache;
 
-static pdc_obj_cache *obj_cache_list, *obj_cache_list_end;
+/*
+ * Object caches are spread over shards by obj_id. The shard mutex only guards the hash table and the object
+ * list of the shard, so lookups of different objects do not serialize on a single lock. Object caches are
+ * never removed from a shard before PDC_region_server_cache_finalize, so a pointer obtained from a shard
+ * stays valid after the shard mutex is released.
+ */
+typedef struct pdc_obj_cache_shard {
+    pthread_mutex_t mutex;
+    HashTable *     obj_table;
+    pdc_obj_cache * obj_list;
+    pdc_obj_cache * obj_list_end;
+} pdc_obj_cache_shard;
+
+static pdc_obj_cache_shard obj_cache_shards[PDC_CACHE_NUM_SHARDS];
 
 static pthread_t       pdc_recycle_thread;
 static pthread_mutex_t pdc_cache_mutex;
+// Wakes up the flusher thread on new cached data, memory pressure and finalize.
+static pthread_cond_t  pdc_cache_cond;
+// Storage I/O issued by the cache goes through the region storage lists, which are not thread-safe.
+static pthread_mutex_t pdc_cache_io_mutex;
 static int             pdc_recycle_close_flag;
 static size_t          total_cache_size;
 static size_t          maximum_cache_size;
+static size_t          cache_high_watermark;
+static size_t          cache_low_watermark;
+// Heads hold the most recently used / written objects, tails the least recently used / written.
+static pdc_obj_cache *cache_list_head[PDC_CACHE_NUM_LISTS];
+static pdc_obj_cache *cache_list_tail[PDC_CACHE_NUM_LISTS];
+
+int PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache);
+
+static unsigned int
+pdc_obj_cache_hash(void *vlocation)
+{
+    uint64_t key = *((uint64_t *)vlocation);
+
+    return (unsigned int)(key ^ (key >> 32));
+}
+
+static int
+pdc_obj_cache_equal(void *vlocation1, void *vlocation2)
+{
+    return *((uint64_t *)vlocation1) == *((uint64_t *)vlocation2);
+}
+
+static pdc_obj_cache_shard *
+pdc_obj_cache_get_shard(uint64_t obj_id)
+{
+    return &obj_cache_shards[obj_id % PDC_CACHE_NUM_SHARDS];
+}
+
+/*
+ * Look up the cache of an object, create it if create_flag is set and the object is not cached yet.
+ * The returned object is not locked.
+ */
+static pdc_obj_cache *
+pdc_obj_cache_lookup(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims, int create_flag)
+{
+    pdc_obj_cache_shard *shard = pdc_obj_cache_get_shard(obj_id);
+    pdc_obj_cache *      obj_cache;
+
+    pthread_mutex_lock(&shard->mutex);
+    obj_cache = (pdc_obj_cache *)hash_table_lookup(shard->obj_table, &obj_id);
+    if (obj_cache == NULL && create_flag) {
+        obj_cache                    = (pdc_obj_cache *)calloc(1, sizeof(pdc_obj_cache));
+        obj_cache->obj_id            = obj_id;
+        obj_cache->ndim              = obj_ndim;
+        obj_cache->region_cache_size = 0;
+        obj_cache->region_cache      = NULL;
+        obj_cache->region_cache_end  = NULL;
+        obj_cache->region_index      = NULL;
+        obj_cache->data_type         = PDC_UNKNOWN;
+        if (obj_ndim) {
+            obj_cache->dims = (uint64_t *)malloc(sizeof(uint64_t) * obj_ndim);
+            memcpy(obj_cache->dims, obj_dims, sizeof(uint64_t) * obj_ndim);
+        }
+        pthread_mutex_init(&obj_cache->mutex, NULL);
+        gettimeofday(&(obj_cache->timestamp), NULL);
+
+        hash_table_insert(shard->obj_table, &obj_cache->obj_id, obj_cache);
+        if (shard->obj_list == NULL)
+            shard->obj_list = obj_cache;
+        else
+            shard->obj_list_end->next = obj_cache;
+        shard->obj_list_end = obj_cache;
+    }
+    pthread_mutex_unlock(&shard->mutex);
+
+    return obj_cache;
+}
+
+/*
+ * Advance an iteration over all cached objects. Pass NULL to get the first object of the shard.
+ */
+static pdc_obj_cache *
+pdc_obj_cache_next(pdc_obj_cache_shard *shard, pdc_obj_cache *obj_cache)
+{
+    pdc_obj_cache *ret_value;
+
+    pthread_mutex_lock(&shard->mutex);
+    ret_value = obj_cache == NULL ? shard->obj_list : obj_cache->next;
+    pthread_mutex_unlock(&shard->mutex);
+
+    return ret_value;
+}
+
+static void
+pdc_cache_list_unlink(pdc_obj_cache *obj_cache, int list)
+{
+    if (obj_cache->list_prev[list] != NULL)
+        obj_cache->list_prev[list]->list_next[list] = obj_cache->list_next[list];
+    else
+        cache_list_head[list] = obj_cache->list_next[list];
+    if (obj_cache->list_next[list] != NULL)
+        obj_cache->list_next[list]->list_prev[list] = obj_cache->list_prev[list];
+    else
+        cache_list_tail[list] = obj_cache->list_prev[list];
+    obj_cache->list_prev[list] = NULL;
+    obj_cache->list_next[list] = NULL;
+    obj_cache->in_list[list]   = 0;
+}
+
+static void
+pdc_cache_list_push_front(pdc_obj_cache *obj_cache, int list)
+{
+    if (cache_list_head[list] == obj_cache)
+        return;
+    if (obj_cache->in_list[list])
+        pdc_cache_list_unlink(obj_cache, list);
+    obj_cache->list_next[list] = cache_list_head[list];
+    if (cache_list_head[list] != NULL)
+        cache_list_head[list]->list_prev[list] = obj_cache;
+    else
+        cache_list_tail[list] = obj_cache;
+    cache_list_head[list]    = obj_cache;
+    obj_cache->in_list[list] = 1;
+}
+
+/*
+ * Account for add newly cached bytes of an object and move it to the most recently used end of the LRU list.
+ * If new bytes were cached, the object also moves to the most recently written end of the flush list.
+ * Caller holds the object mutex.
+ */
+static void
+pdc_cache_lru_touch(pdc_obj_cache *obj_cache, size_t add)
+{
+    pthread_mutex_lock(&pdc_cache_mutex);
+    total_cache_size += add;
+    obj_cache->cache_bytes += add;
+    if (obj_cache->cache_bytes > 0)
+        pdc_cache_list_push_front(obj_cache, PDC_CACHE_LRU_LIST);
+    if (add > 0) {
+        gettimeofday(&(obj_cache->timestamp), NULL);
+        // The flusher sleeps without a deadline when nothing is cached.
+        if (cache_list_head[PDC_CACHE_FLUSH_LIST] == NULL || total_cache_size > cache_high_watermark)
+            pthread_cond_signal(&pdc_cache_cond);
+        pdc_cache_list_push_front(obj_cache, PDC_CACHE_FLUSH_LIST);
+    }
+    pthread_mutex_unlock(&pdc_cache_mutex);
+}
+
+/*
+ * Release the cached bytes of an object that has been flushed and take it off both lists.
+ * Caller holds the object mutex.
+ */
+static void
+pdc_cache_lru_remove(pdc_obj_cache *obj_cache)
+{
+    int list;
+
+    pthread_mutex_lock(&pdc_cache_mutex);
+    total_cache_size -= obj_cache->cache_bytes;
+    obj_cache->cache_bytes = 0;
+    for (list = 0; list < PDC_CACHE_NUM_LISTS; ++list) {
+        if (obj_cache->in_list[list])
+            pdc_cache_list_unlink(obj_cache, list);
+    }
+    pthread_mutex_unlock(&pdc_cache_mutex);
+}
+
+/*
+ * Flush least recently used objects until the cache size is at most target_size, or until max_objs objects
+ * have been evicted if max_objs is positive.
+ * Return the number of evicted objects.
+ */
+static int
+pdc_region_cache_evict(size_t target_size, int max_objs)
+{
+    pdc_obj_cache *victim;
+    int            nevict = 0;
+#ifdef PDC_TIMING
+    double start;
+    size_t evict_bytes;
+#endif
+
+    while (max_objs <= 0 || nevict < max_objs) {
+        pthread_mutex_lock(&pdc_cache_mutex);
+        victim = total_cache_size > target_size ? cache_list_tail[PDC_CACHE_LRU_LIST] : NULL;
+        pthread_mutex_unlock(&pdc_cache_mutex);
+        if (victim == NULL)
+            break;
+#ifdef PDC_TIMING
+        start = MPI_Wtime();
+#endif
+        // The victim may have been flushed by another thread in the meantime, flushing it again is harmless.
+        pthread_mutex_lock(&victim->mutex);
+#ifdef PDC_TIMING
+        evict_bytes = victim->cache_bytes;
+#endif
+        PDC_region_cache_flush_by_pointer(victim->obj_id, victim);
+        pthread_mutex_unlock(&victim->mutex);
+        nevict++;
+#ifdef PDC_TIMING
+        pthread_mutex_lock(&pdc_cache_mutex);
+        pdc_server_timings->PDCcache_evict += MPI_Wtime() - start;
+        pdc_server_timings->PDCcache_evict_count += 1;
+        pdc_server_timings->PDCcache_evict_bytes += evict_bytes;
+        pthread_mutex_unlock(&pdc_cache_mutex);
+#endif
+    }
+    return nevict;
+}
 
 int
 PDC_region_server_cache_init()
 {
     char *p;
+    int   i, high, low;
 
     pdc_recycle_close_flag = 0;
-    pthread_mutex_init(&pdc_obj_cache_list_mutex, NULL);
+    for (i = 0; i < PDC_CACHE_NUM_SHARDS; ++i) {
+        pthread_mutex_init(&obj_cache_shards[i].mutex, NULL);
+        obj_cache_shards[i].obj_table    = hash_table_new(pdc_obj_cache_hash, pdc_obj_cache_equal);
+        obj_cache_shards[i].obj_list     = NULL;
+        obj_cache_shards[i].obj_list_end = NULL;
+    }
     pthread_mutex_init(&pdc_cache_mutex, NULL);
-    pthread_create(&pdc_recycle_thread, NULL, &PDC_region_cache_clock_cycle, NULL);
+    pthread_cond_init(&pdc_cache_cond, NULL);
+    pthread_mutex_init(&pdc_cache_io_mutex, NULL);
     total_cache_size = 0;
+    for (i = 0; i < PDC_CACHE_NUM_LISTS; ++i) {
+        cache_list_head[i] = NULL;
+        cache_list_tail[i] = NULL;
+    }
 
     p = getenv("PDC_SERVER_CACHE_MAX_SIZE");
     if (p != NULL) {
@@ -57,9 +314,22 @@ PDC_region_server_cache_init()
     else {
         maximum_cache_size = MAX_CACHE_SIZE;
     }
+    high = PDC_CACHE_HIGH_WATERMARK;
+    p    = getenv("PDC_SERVER_CACHE_HIGH_WATERMARK");
+    if (p != NULL)
+        high = atoi(p);
+    low = PDC_CACHE_LOW_WATERMARK;
+    p   = getenv("PDC_SERVER_CACHE_LOW_WATERMARK");
+    if (p != NULL)
+        low = atoi(p);
+    if (high <= 0 || high > 100)
+        high = PDC_CACHE_HIGH_WATERMARK;
+    if (low < 0 || low > high)
+        low = high;
+    cache_high_watermark = maximum_cache_size / 100 * high;
+    cache_low_watermark  = maximum_cache_size / 100 * low;
 
-    obj_cache_list     = NULL;
-    obj_cache_list_end = NULL;
+    pthread_create(&pdc_recycle_thread, NULL, &PDC_region_cache_clock_cycle, NULL);
     return 0;
 }
 
@@ -67,23 +337,43 @@ PDC_region_server_cache_init()
 int
 PDC_region_server_cache_finalize()
 {
+    int i;
 #ifdef PDC_TIMING
     double start = MPI_Wtime();
 #endif
     pthread_mutex_lock(&pdc_cache_mutex);
     pdc_recycle_close_flag = 1;
+    pthread_cond_signal(&pdc_cache_cond);
     pthread_mutex_unlock(&pdc_cache_mutex);
     pthread_join(pdc_recycle_thread, NULL);
 
     PDC_region_cache_flush_all();
-    pthread_mutex_destroy(&pdc_obj_cache_list_mutex);
+    PDC_region_cache_free();
+    for (i = 0; i < PDC_CACHE_NUM_SHARDS; ++i) {
+        pthread_mutex_destroy(&obj_cache_shards[i].mutex);
+    }
     pthread_mutex_destroy(&pdc_cache_mutex);
+    pthread_cond_destroy(&pdc_cache_cond);
+    pthread_mutex_destroy(&pdc_cache_io_mutex);
 #ifdef PDC_TIMING
     pdc_server_timings->PDCcache_clean += MPI_Wtime() - start;
 #endif
     return 0;
 }
 
+// Storage I/O of the cache waits while the caller holds the lock, see PDC_Server_wal_compact_progress.
+int
+PDC_region_cache_io_trylock()
+{
+    return pthread_mutex_trylock(&pdc_cache_io_mutex);
+}
+
+void
+PDC_region_cache_io_unlock()
+{
+    pthread_mutex_unlock(&pdc_cache_io_mutex);
+}
+
 /*
  * Check if the first region is contained inside the second region or the second region is contained inside
  * the first region or they have overlapping relation.
@@ -387,107 +677,95 @@ PDC_region_cache_copy(char *buf, char *buf2, const uint64_t *offset, const uint6
 }
 
 /*
- * This function cache metadata and data for a region write operation.
- * We store 1 object per element in the end of an array. Per object, there is a array of regions. The new
- * region is appended to the end of the region array after object searching by ID. This will result linear
- * search complexity for subregion search.
+ * Append a new cache region to an object, the object mutex must be held by the caller.
  */
-
-int
-PDC_region_cache_register(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims, const char *buf,
-                          size_t buf_size, const uint64_t *offset, const uint64_t *size, int ndim,
-                          size_t unit)
+static void
+pdc_region_cache_append(pdc_obj_cache *obj_cache, const char *buf, size_t buf_size, const uint64_t *offset,
+                        const uint64_t *size, int ndim, size_t unit)
 {
-    pdc_obj_cache *         obj_cache_iter, *obj_cache = NULL;
+    pdc_region_cache *      region_cache;
     struct pdc_region_info *region_cache_info;
-    if (obj_ndim != ndim && obj_ndim > 0) {
-        printf("PDC_region_cache_register reports obj_ndim != ndim, %d != %d\n", obj_ndim, ndim);
-        return FAIL;
-    }
-
-    pthread_mutex_lock(&pdc_obj_cache_list_mutex);
-
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        if (obj_cache_iter->obj_id == obj_id) {
-            obj_cache = obj_cache_iter;
-            break;
-        }
-        obj_cache_iter = obj_cache_iter->next;
-    }
-
-    if (obj_cache == NULL) {
-        if (obj_cache_list != NULL) {
-            obj_cache_list_end->next = (pdc_obj_cache *)malloc(sizeof(pdc_obj_cache));
-            obj_cache_list_end       = obj_cache_list_end->next;
-            obj_cache_list_end->next = NULL;
-
-            obj_cache_list_end->obj_id            = obj_id;
-            obj_cache_list_end->region_cache_size = 0;
-            obj_cache_list_end->region_cache      = NULL;
-            obj_cache_list_end->region_cache_end  = NULL;
-        }
-        else {
-            obj_cache_list     = (pdc_obj_cache *)malloc(sizeof(pdc_obj_cache));
-            obj_cache_list_end = obj_cache_list;
-
-            obj_cache_list_end->obj_id            = obj_id;
-            obj_cache_list_end->region_cache_size = 0;
-            obj_cache_list_end->region_cache      = NULL;
-            obj_cache_list_end->region_cache_end  = NULL;
-            obj_cache_list_end->next              = NULL;
-        }
-        obj_cache_list_end->ndim = obj_ndim;
-        if (obj_ndim) {
-            obj_cache_list_end->dims = (uint64_t *)malloc(sizeof(uint64_t) * obj_ndim);
-            memcpy(obj_cache_list_end->dims, obj_dims, sizeof(uint64_t) * obj_ndim);
-        }
-        obj_cache = obj_cache_list_end;
-    }
 
+    region_cache       = (pdc_region_cache *)malloc(sizeof(pdc_region_cache));
+    region_cache->next = NULL;
     if (obj_cache->region_cache == NULL) {
-        obj_cache->region_cache           = (pdc_region_cache *)malloc(sizeof(pdc_region_cache));
-        obj_cache->region_cache_end       = obj_cache->region_cache;
-        obj_cache->region_cache_end->next = NULL;
+        obj_cache->region_cache     = region_cache;
+        obj_cache->region_cache_end = region_cache;
     }
     else {
-        obj_cache->region_cache_end->next = (pdc_region_cache *)malloc(sizeof(pdc_region_cache));
-        obj_cache->region_cache_end       = obj_cache->region_cache_end->next;
-        obj_cache->region_cache_end->next = NULL;
+        obj_cache->region_cache_end->next = region_cache;
+        obj_cache->region_cache_end       = region_cache;
     }
     obj_cache->region_cache_size++;
 
-    /* printf("checkpoint region_obj_cache_size = %d\n", obj_cache->region_obj_cache_size); */
-    obj_cache->region_cache_end->region_cache_info =
-        (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
-    region_cache_info         = obj_cache->region_cache_end->region_cache_info;
-    region_cache_info->ndim   = ndim;
-    region_cache_info->offset = (uint64_t *)malloc(sizeof(uint64_t) * ndim * 2);
-    region_cache_info->size   = region_cache_info->offset + ndim;
-    region_cache_info->buf    = (char *)malloc(sizeof(char) * buf_size);
-    region_cache_info->unit   = unit;
+    region_cache->region_cache_info = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
+    region_cache_info               = region_cache->region_cache_info;
+    region_cache_info->ndim         = ndim;
+    region_cache_info->offset       = (uint64_t *)malloc(sizeof(uint64_t) * ndim * 2);
+    region_cache_info->size         = region_cache_info->offset + ndim;
+    region_cache_info->buf          = (char *)malloc(sizeof(char) * buf_size);
+    region_cache_info->unit         = unit;
 
     memcpy(region_cache_info->offset, offset, sizeof(uint64_t) * ndim);
     memcpy(region_cache_info->size, size, sizeof(uint64_t) * ndim);
     memcpy(region_cache_info->buf, buf, sizeof(char) * buf_size);
-    total_cache_size += buf_size;
 
-    pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
+    if (obj_cache->region_index == NULL)
+        obj_cache->region_index = pdc_region_index_new(ndim);
+    pdc_region_index_insert(obj_cache->region_index, region_cache_info->offset, region_cache_info->size,
+                            region_cache);
+}
 
-    if (total_cache_size > maximum_cache_size) {
-        int server_rank = 0;
+/*
+ * Check the cache size after new data is cached. Above the maximum size the caller evicts the least recently
+ * used object itself, so a single request pays for at most one object flush. Between the high watermark and
+ * the maximum, the background thread writes objects back until the cache is below the low watermark.
+ */
+static void
+pdc_region_cache_check_size()
+{
+    size_t cache_size;
+    int    server_rank = 0;
+
+    pthread_mutex_lock(&pdc_cache_mutex);
+    cache_size = total_cache_size;
+    pthread_mutex_unlock(&pdc_cache_mutex);
+
+    if (cache_size > maximum_cache_size) {
 #ifdef ENABLE_MPI
         MPI_Comm_rank(MPI_COMM_WORLD, &server_rank);
 #endif
-        printf("==PDC_SERVER[%d]: server cache full %.1f / %.1f MB, will flush to storage\n", server_rank,
-               total_cache_size / 1048576.0, maximum_cache_size / 1048576.0);
-        PDC_region_cache_flush_all();
+        printf("==PDC_SERVER[%d]: server cache full %.1f / %.1f MB, will evict to storage\n", server_rank,
+               cache_size / 1048576.0, maximum_cache_size / 1048576.0);
+        pdc_region_cache_evict(maximum_cache_size, 1);
+    }
+}
+
+/*
+ * This function cache metadata and data for a region write operation.
+ * Objects are found through the sharded hash table, the new region is appended to the region list of the
+ * object and inserted into its spatial index.
+ */
+
+int
+PDC_region_cache_register(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims, const char *buf,
+                          size_t buf_size, const uint64_t *offset, const uint64_t *size, int ndim,
+                          size_t unit)
+{
+    pdc_obj_cache *obj_cache;
+    if (obj_ndim != ndim && obj_ndim > 0) {
+        printf("PDC_region_cache_register reports obj_ndim != ndim, %d != %d\n", obj_ndim, ndim);
+        return FAIL;
     }
 
-    // printf("created cache region at offset %llu, buf size %llu, unit = %ld, ndim = %ld, obj_id = %llu\n",
-    //       offset[0], buf_size, unit, ndim, (long long unsigned)obj_cache->obj_id);
+    obj_cache = pdc_obj_cache_lookup(obj_id, obj_ndim, obj_dims, 1);
 
-    gettimeofday(&(obj_cache->timestamp), NULL);
+    pthread_mutex_lock(&obj_cache->mutex);
+    pdc_region_cache_append(obj_cache, buf, buf_size, offset, size, ndim, unit);
+    pdc_cache_lru_touch(obj_cache, buf_size);
+    pthread_mutex_unlock(&obj_cache->mutex);
+
+    pdc_region_cache_check_size();
 
     return 0;
 }
@@ -497,34 +775,82 @@ PDC_region_cache_free()
 {
     pdc_obj_cache *   obj_cache_iter, *obj_temp;
     pdc_region_cache *region_cache_iter, *region_temp;
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        region_cache_iter = obj_cache_iter->region_cache;
-        while (region_cache_iter != NULL) {
-            free(region_cache_iter->region_cache_info);
-            region_temp       = region_cache_iter;
-            region_cache_iter = region_cache_iter->next;
-            free(region_temp);
+    int               i;
+
+    for (i = 0; i < PDC_CACHE_NUM_SHARDS; ++i) {
+        pthread_mutex_lock(&obj_cache_shards[i].mutex);
+        obj_cache_iter = obj_cache_shards[i].obj_list;
+        while (obj_cache_iter != NULL) {
+            region_cache_iter = obj_cache_iter->region_cache;
+            while (region_cache_iter != NULL) {
+                free(region_cache_iter->region_cache_info->offset);
+                free(region_cache_iter->region_cache_info->buf);
+                free(region_cache_iter->region_cache_info);
+                region_temp       = region_cache_iter;
+                region_cache_iter = region_cache_iter->next;
+                free(region_temp);
+            }
+            pdc_region_index_free(obj_cache_iter->region_index);
+            pthread_mutex_destroy(&obj_cache_iter->mutex);
+            obj_temp       = obj_cache_iter;
+            obj_cache_iter = obj_cache_iter->next;
+            if (obj_temp->ndim)
+                free(obj_temp->dims);
+            free(obj_temp);
+        }
+        hash_table_free(obj_cache_shards[i].obj_table);
+        obj_cache_shards[i].obj_table    = NULL;
+        obj_cache_shards[i].obj_list     = NULL;
+        obj_cache_shards[i].obj_list_end = NULL;
+        pthread_mutex_unlock(&obj_cache_shards[i].mutex);
+    }
+    return 0;
+}
+
+typedef struct pdc_region_cache_write_arg {
+    struct pdc_region_info *region_info;
+    void *                  buf;
+    size_t                  unit;
+    // Whether the input region is fully contained in a cached region.
+    int contained;
+} pdc_region_cache_write_arg;
+
+/*
+ * Copy the part of a write request that overlaps a cached region into the cached buffer.
+ */
+static int
+pdc_region_cache_write_visit(void *data, void *arg)
+{
+    pdc_region_cache *          region_cache = (pdc_region_cache *)data;
+    pdc_region_cache_write_arg *write_arg    = (pdc_region_cache_write_arg *)arg;
+    struct pdc_region_info *    region_info  = write_arg->region_info;
+    uint64_t *                  overlap_offset, *overlap_size;
+
+    PDC_region_overlap_detect(region_info->ndim, region_info->offset, region_info->size,
+                              region_cache->region_cache_info->offset, region_cache->region_cache_info->size,
+                              &overlap_offset, &overlap_size);
+    if (overlap_offset) {
+        if (detect_region_contained(region_info->offset, region_info->size,
+                                    region_cache->region_cache_info->offset,
+                                    region_cache->region_cache_info->size, region_info->ndim)) {
+            write_arg->contained = 1;
         }
-        obj_temp       = obj_cache_iter;
-        obj_cache_iter = obj_cache_iter->next;
-        free(obj_temp);
+        memcpy_overlap_subregion(region_info->ndim, write_arg->unit, write_arg->buf, region_info->offset,
+                                 region_info->size, region_cache->region_cache_info->buf,
+                                 region_cache->region_cache_info->offset,
+                                 region_cache->region_cache_info->size, overlap_offset, overlap_size);
+        free(overlap_offset);
     }
     return 0;
 }
 
 perr_t
 PDC_transfer_request_data_write_out(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
-                                    struct pdc_region_info *region_info, void *buf, size_t unit)
+                                    struct pdc_region_info *region_info, void *buf, size_t unit,
+                                    pdc_var_type_t data_type)
 {
-    // flag indicates whether the input region is fully contained in another cached region.
-    int               flag;
-    pdc_obj_cache *   obj_cache, *obj_cache_iter;
-    pdc_region_cache *region_cache_iter;
-    uint64_t *        overlap_offset, *overlap_size;
-    // char *            buf_merged;
-    // uint64_t *        offset_merged, size_merged;
-    // int               merge_status;
+    pdc_obj_cache *            obj_cache;
+    pdc_region_cache_write_arg write_arg;
 
     perr_t ret_value = SUCCEED;
 
@@ -533,8 +859,6 @@ PDC_transfer_request_data_write_out(uint64_t obj_id, int obj_ndim, const uint64_
     double start = MPI_Wtime();
 #endif
 
-    // Write 1GB at a time
-
     uint64_t write_size = 0;
     if (region_info->ndim >= 1)
         write_size = unit * region_info->size[0];
@@ -543,66 +867,42 @@ PDC_transfer_request_data_write_out(uint64_t obj_id, int obj_ndim, const uint64_
     if (region_info->ndim >= 3)
         write_size *= region_info->size[2];
 
-    pthread_mutex_lock(&pdc_obj_cache_list_mutex);
-
-    obj_cache = NULL;
-    // Look up for the object in the cache list
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        if (obj_cache_iter->obj_id == obj_id) {
-            obj_cache = obj_cache_iter;
-        }
-        obj_cache_iter = obj_cache_iter->next;
+    if (obj_ndim != (int)region_info->ndim && obj_ndim > 0) {
+        printf("PDC_region_cache_register reports obj_ndim != ndim, %d != %d\n", obj_ndim,
+               (int)region_info->ndim);
+        PGOTO_DONE(FAIL);
     }
-    flag = 0;
-    if (obj_cache != NULL) {
-        // If we have region that is contained inside a cached region, we can directly modify the cache region
-        // data.
-        region_cache_iter = obj_cache->region_cache;
-        while (region_cache_iter != NULL) {
-            flag = 0;
-            PDC_region_overlap_detect(region_info->ndim, region_info->offset, region_info->size,
-                                      region_cache_iter->region_cache_info->offset,
-                                      region_cache_iter->region_cache_info->size, &overlap_offset,
-                                      &overlap_size);
-            if (overlap_offset) {
-                flag = detect_region_contained(region_info->offset, region_info->size,
-                                               region_cache_iter->region_cache_info->offset,
-                                               region_cache_iter->region_cache_info->size, region_info->ndim);
-                memcpy_overlap_subregion(
-                    region_info->ndim, unit, buf, region_info->offset, region_info->size,
-                    region_cache_iter->region_cache_info->buf, region_cache_iter->region_cache_info->offset,
-                    region_cache_iter->region_cache_info->size, overlap_offset, overlap_size);
-                free(overlap_offset);
-                if (flag) {
-                    break;
-                }
-            }
-            /*
-             else {
-                            merge_status = PDC_region_merge(buf, region_cache_iter->region_cache_info->buf,
-             region_info->offset, region_info->size, region_cache_iter->region_cache_info->offset,
-             region_cache_iter->region_cache_info->size, &buf_merged, &offset_merged, &size_merged, ndim,
-             unit); if ( merge_status == PDC_MERGE_SUCCESS ) {
-
-                            }
-                        }
-            */
-            region_cache_iter = region_cache_iter->next;
-        }
+
+    obj_cache = pdc_obj_cache_lookup(obj_id, obj_ndim, obj_dims, 1);
+
+    write_arg.region_info = region_info;
+    write_arg.buf         = buf;
+    write_arg.unit        = unit;
+    write_arg.contained   = 0;
+
+    pthread_mutex_lock(&obj_cache->mutex);
+    if (data_type != PDC_UNKNOWN)
+        obj_cache->data_type = data_type;
+    // Every cached region that overlaps the input region is updated, so all cached copies stay consistent.
+    if (obj_cache->region_index != NULL) {
+        pdc_region_index_search(obj_cache->region_index, region_info->offset, region_info->size,
+                                pdc_region_cache_write_visit, &write_arg);
     }
-    pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
-    if (!flag) {
-        PDC_region_cache_register(obj_id, obj_ndim, obj_dims, buf, write_size, region_info->offset,
-                                  region_info->size, region_info->ndim, unit);
+    if (!write_arg.contained) {
+        pdc_region_cache_append(obj_cache, (char *)buf, write_size, region_info->offset, region_info->size,
+                                region_info->ndim, unit);
     }
+    pdc_cache_lru_touch(obj_cache, write_arg.contained ? 0 : write_size);
+    pthread_mutex_unlock(&obj_cache->mutex);
+
+    if (!write_arg.contained)
+        pdc_region_cache_check_size();
 
-    // PDC_Server_data_write_out2(obj_id, region_info, buf, unit);
 #ifdef PDC_TIMING
     pdc_server_timings->PDCcache_write += MPI_Wtime() - start;
 #endif
 
-    // done:
+done:
     fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
@@ -678,6 +978,102 @@ sort_by_offset(const void *elem1, const void *elem2)
 #pragma GCC diagnostic pop
 }
 
+typedef struct pdc_region_merge_item {
+    // Offset and size of all dimensions but the merging one, followed by those of the merging dimension.
+    uint64_t                key[DIM_MAX * 2];
+    struct pdc_region_info *region;
+} pdc_region_merge_item;
+
+static int
+pdc_region_merge_item_compare(const void *elem1, const void *elem2)
+{
+    const pdc_region_merge_item *item1 = (const pdc_region_merge_item *)elem1;
+    const pdc_region_merge_item *item2 = (const pdc_region_merge_item *)elem2;
+    int                          i;
+
+    for (i = 0; i < DIM_MAX * 2; ++i) {
+        if (item1->key[i] != item2->key[i])
+            return item1->key[i] < item2->key[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/*
+ * Merge regions that have the same extent in every dimension except dim and that touch or overlap along dim.
+ * Merged regions replace their inputs in regions, which are freed. Overlapping cached regions hold the same
+ * data, so the order in which they are copied does not matter.
+ * Return the new number of regions.
+ */
+static int
+pdc_region_coalesce_dim(struct pdc_region_info **regions, int nregion, int ndim, int dim)
+{
+    pdc_region_merge_item * items;
+    struct pdc_region_info *region, *merged;
+    uint64_t                merged_end, buf_size;
+    int                     i, j, k, n;
+
+    items = (pdc_region_merge_item *)calloc(nregion, sizeof(pdc_region_merge_item));
+    for (i = 0; i < nregion; ++i) {
+        region          = regions[i];
+        items[i].region = region;
+        n               = 0;
+        for (j = 0; j < ndim; ++j) {
+            if (j == dim)
+                continue;
+            items[i].key[n++] = region->offset[j];
+            items[i].key[n++] = region->size[j];
+        }
+        items[i].key[n++] = region->offset[dim];
+        items[i].key[n++] = region->size[dim];
+    }
+    qsort(items, nregion, sizeof(pdc_region_merge_item), pdc_region_merge_item_compare);
+
+    n = 0;
+    i = 0;
+    while (i < nregion) {
+        region     = items[i].region;
+        merged_end = region->offset[dim] + region->size[dim];
+        for (j = i + 1; j < nregion; ++j) {
+            if (memcmp(items[j].key, items[i].key, sizeof(uint64_t) * (ndim - 1) * 2) ||
+                items[j].region->offset[dim] > merged_end)
+                break;
+            if (items[j].region->offset[dim] + items[j].region->size[dim] > merged_end)
+                merged_end = items[j].region->offset[dim] + items[j].region->size[dim];
+        }
+        if (j - i == 1) {
+            regions[n++] = region;
+            i            = j;
+            continue;
+        }
+
+        merged         = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
+        merged->ndim   = ndim;
+        merged->unit   = region->unit;
+        merged->offset = (uint64_t *)malloc(sizeof(uint64_t) * ndim * 2);
+        merged->size   = merged->offset + ndim;
+        memcpy(merged->offset, region->offset, sizeof(uint64_t) * ndim);
+        memcpy(merged->size, region->size, sizeof(uint64_t) * ndim);
+        merged->size[dim] = merged_end - region->offset[dim];
+        buf_size          = merged->unit;
+        for (k = 0; k < ndim; ++k)
+            buf_size *= merged->size[k];
+        merged->buf = (char *)malloc(buf_size);
+
+        for (k = i; k < j; ++k) {
+            region = items[k].region;
+            memcpy_overlap_subregion(ndim, region->unit, region->buf, region->offset, region->size,
+                                     merged->buf, merged->offset, merged->size, region->offset, region->size);
+            free(region->offset);
+            free(region->buf);
+            free(region);
+        }
+        regions[n++] = merged;
+        i            = j;
+    }
+    free(items);
+    return n;
+}
+
 int
 PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
 {
@@ -689,6 +1085,7 @@ PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
     uint64_t *               start, *end, *new_start, *new_end;
     int                      merged_request_size = 0;
     int                      server_rank         = 0;
+    int                      nregion;
     uint64_t                 unit;
     struct pdc_region_info **obj_regions;
 #ifdef PDC_TIMING
@@ -760,6 +1157,46 @@ PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
         }
         nflush += merged_request_size;
     }
+    else if (obj_cache->ndim >= 2 && obj_cache->ndim <= 3 && obj_cache->region_cache_size > 1) {
+        // Coalesce N-D regions into maximal boxes, merging along the slowest dimension first and then fusing
+        // rows. Repeat until nothing changes, so slabs of full rows fuse along the slowest dimension again.
+        obj_regions       = (struct pdc_region_info **)malloc(sizeof(struct pdc_region_info *) *
+                                                        obj_cache->region_cache_size);
+        region_cache_iter = obj_cache->region_cache;
+        i                 = 0;
+        while (region_cache_iter) {
+            obj_regions[i]    = region_cache_iter->region_cache_info;
+            region_cache_iter = region_cache_iter->next;
+            i++;
+        }
+        merged_request_size = obj_cache->region_cache_size;
+        do {
+            nregion = merged_request_size;
+            for (i = 0; i < obj_cache->ndim; ++i) {
+                merged_request_size =
+                    pdc_region_coalesce_dim(obj_regions, merged_request_size, obj_cache->ndim, i);
+            }
+        } while (merged_request_size < nregion);
+
+        // Keep the first merged_request_size list nodes for the merged regions and free the rest.
+        region_cache_iter = obj_cache->region_cache;
+        for (i = 0; i < obj_cache->region_cache_size; ++i) {
+            region_cache_temp = region_cache_iter->next;
+            if (i < merged_request_size) {
+                region_cache_iter->region_cache_info = obj_regions[i];
+                if (i == merged_request_size - 1) {
+                    region_cache_iter->next     = NULL;
+                    obj_cache->region_cache_end = region_cache_iter;
+                }
+            }
+            else {
+                free(region_cache_iter);
+            }
+            region_cache_iter = region_cache_temp;
+        }
+        free(obj_regions);
+        obj_cache->region_cache_size = merged_request_size;
+    }
 
 #ifdef ENABLE_MPI
     MPI_Comm_rank(MPI_COMM_WORLD, &server_rank);
@@ -768,8 +1205,11 @@ PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
     region_cache_iter = obj_cache->region_cache;
     while (region_cache_iter != NULL) {
         region_cache_info = region_cache_iter->region_cache_info;
+        pthread_mutex_lock(&pdc_cache_io_mutex);
         PDC_Server_transfer_request_io(obj_id, obj_cache->ndim, obj_cache->dims, region_cache_info,
-                                       region_cache_info->buf, region_cache_info->unit, 1);
+                                       region_cache_info->buf, region_cache_info->unit, obj_cache->data_type,
+                                       1);
+        pthread_mutex_unlock(&pdc_cache_io_mutex);
         if (obj_cache->ndim >= 1)
             write_size = region_cache_info->unit * region_cache_info->size[0];
         if (obj_cache->ndim >= 2)
@@ -780,7 +1220,6 @@ PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
         printf("==PDC_SERVER[%d]: server flushed %.1f / %.1f MB to storage\n", server_rank,
                write_size / 1048576.0, total_cache_size / 1048576.0);
 
-        total_cache_size -= write_size;
         free(region_cache_info->offset);
         if (obj_cache->ndim > 1) {
             free(region_cache_info->buf);
@@ -795,113 +1234,115 @@ PDC_region_cache_flush_by_pointer(uint64_t obj_id, pdc_obj_cache *obj_cache)
         free(buf_ptr);
     }
     obj_cache->region_cache      = NULL;
+    obj_cache->region_cache_end  = NULL;
     obj_cache->region_cache_size = 0;
-    gettimeofday(&(obj_cache->timestamp), NULL);
+    pdc_region_index_clear(obj_cache->region_index);
+    pdc_cache_lru_remove(obj_cache);
 #ifdef PDC_TIMING
     pdc_server_timings->PDCcache_flush += MPI_Wtime() - start_time;
 #endif
     return nflush;
 }
 
+/*
+ * Flush all cached regions of an object to storage.
+ */
 int
 PDC_region_cache_flush(uint64_t obj_id)
 {
-    pdc_obj_cache *obj_cache = NULL, *obj_cache_iter;
+    pdc_obj_cache *obj_cache;
 
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        if (obj_cache_iter->obj_id == obj_id) {
-            obj_cache = obj_cache_iter;
-            break;
-        }
-        obj_cache_iter = obj_cache_iter->next;
-    }
+    obj_cache = pdc_obj_cache_lookup(obj_id, 0, NULL, 0);
     if (obj_cache == NULL) {
         // printf("server error: flushing object that does not exist\n");
         return 1;
     }
+    pthread_mutex_lock(&obj_cache->mutex);
     PDC_region_cache_flush_by_pointer(obj_id, obj_cache);
+    pthread_mutex_unlock(&obj_cache->mutex);
     return 0;
 }
 
 int
 PDC_region_cache_flush_all()
 {
-    pdc_obj_cache *obj_cache_iter, *obj_cache_temp;
-    pthread_mutex_lock(&pdc_obj_cache_list_mutex);
-
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        PDC_region_cache_flush_by_pointer(obj_cache_iter->obj_id, obj_cache_iter);
-        obj_cache_temp = obj_cache_iter;
-        obj_cache_iter = obj_cache_iter->next;
-        if (obj_cache_temp->ndim) {
-            free(obj_cache_temp->dims);
+    pdc_obj_cache *obj_cache;
+    int            i;
+
+    for (i = 0; i < PDC_CACHE_NUM_SHARDS; ++i) {
+        obj_cache = pdc_obj_cache_next(&obj_cache_shards[i], NULL);
+        while (obj_cache != NULL) {
+            pthread_mutex_lock(&obj_cache->mutex);
+            PDC_region_cache_flush_by_pointer(obj_cache->obj_id, obj_cache);
+            pthread_mutex_unlock(&obj_cache->mutex);
+            obj_cache = pdc_obj_cache_next(&obj_cache_shards[i], obj_cache);
         }
-
-        free(obj_cache_temp);
     }
-    obj_cache_list = NULL;
-    pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
     return 0;
 }
 
+/*
+ * Background flusher. It sleeps until the object with the oldest cached write reaches its flush deadline, and
+ * is woken up early when data is cached while nothing else is, when the cache goes above the high watermark,
+ * and on finalize. Objects are flushed without holding pdc_cache_mutex.
+ */
 void *
 PDC_region_cache_clock_cycle(void *ptr)
 {
-    pdc_obj_cache *obj_cache, *obj_cache_iter;
-    struct timeval current_time;
-    struct timeval finish_time;
-    int            nflush            = 0;
-    double         flush_frequency_s = PDC_CACHE_FLUSH_TIME_INT, elapsed_time;
-    int            server_rank       = 0;
+    pdc_obj_cache * obj_cache;
+    struct timeval  current_time;
+    struct timeval  finish_time;
+    struct timespec deadline;
+    int             nflush            = 0;
+    double          flush_frequency_s = PDC_CACHE_FLUSH_TIME_INT, elapsed_time;
+    int             server_rank       = 0;
 
     char *p = getenv("PDC_SERVER_CACHE_FLUSH_FREQUENCY_S");
     if (p != NULL)
         flush_frequency_s = atoi(p);
 
-    if (ptr == NULL) {
-        obj_cache_iter = NULL;
-    }
-    while (1) {
-        nflush = 0;
-        pthread_mutex_lock(&pdc_cache_mutex);
-        if (!pdc_recycle_close_flag) {
-            pthread_mutex_lock(&pdc_obj_cache_list_mutex);
-            gettimeofday(&current_time, NULL);
-            obj_cache_iter = obj_cache_list;
-            nflush         = 0;
-            while (obj_cache_iter != NULL) {
-                obj_cache = obj_cache_iter;
-                // flush every *flush_frequency_s seconds
-                elapsed_time = current_time.tv_sec - obj_cache->timestamp.tv_sec +
-                               (current_time.tv_usec - obj_cache->timestamp.tv_usec) / 1000000.0;
-                /* if (current_time.tv_sec - obj_cache->timestamp.tv_sec > flush_frequency_s) { */
-                if (elapsed_time >= flush_frequency_s) {
-                    nflush += PDC_region_cache_flush_by_pointer(obj_cache->obj_id, obj_cache);
-                }
-                obj_cache_iter = obj_cache_iter->next;
-            }
-            if (nflush > 0) {
-#ifdef ENABLE_MPI
-                MPI_Comm_rank(MPI_COMM_WORLD, &server_rank);
-#endif
-                gettimeofday(&finish_time, NULL);
-                elapsed_time = finish_time.tv_sec - current_time.tv_sec +
-                               (finish_time.tv_usec - current_time.tv_usec) / 1000000.0;
-                fprintf(stderr,
-                        "==PDC_SERVER[%d]: flushed %d regions to storage (full/every %.0fs), took %.4fs\n",
-                        server_rank, nflush, flush_frequency_s, elapsed_time);
-            }
-            pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
-        }
-        else {
+    (void)ptr;
+    pthread_mutex_lock(&pdc_cache_mutex);
+    while (!pdc_recycle_close_flag) {
+        if (total_cache_size > cache_high_watermark && cache_list_tail[PDC_CACHE_LRU_LIST] != NULL) {
             pthread_mutex_unlock(&pdc_cache_mutex);
-            break;
+            pdc_region_cache_evict(cache_low_watermark, 0);
+            pthread_mutex_lock(&pdc_cache_mutex);
+            continue;
+        }
+        obj_cache = cache_list_tail[PDC_CACHE_FLUSH_LIST];
+        if (obj_cache == NULL) {
+            pthread_cond_wait(&pdc_cache_cond, &pdc_cache_mutex);
+            continue;
+        }
+        // flush every *flush_frequency_s seconds
+        gettimeofday(&current_time, NULL);
+        elapsed_time = current_time.tv_sec - obj_cache->timestamp.tv_sec +
+                       (current_time.tv_usec - obj_cache->timestamp.tv_usec) / 1000000.0;
+        if (elapsed_time < flush_frequency_s) {
+            deadline.tv_sec  = obj_cache->timestamp.tv_sec + (time_t)flush_frequency_s;
+            deadline.tv_nsec = obj_cache->timestamp.tv_usec * 1000;
+            pthread_cond_timedwait(&pdc_cache_cond, &pdc_cache_mutex, &deadline);
+            continue;
         }
         pthread_mutex_unlock(&pdc_cache_mutex);
-        usleep(500);
+
+        pthread_mutex_lock(&obj_cache->mutex);
+        nflush = PDC_region_cache_flush_by_pointer(obj_cache->obj_id, obj_cache);
+        pthread_mutex_unlock(&obj_cache->mutex);
+        if (nflush > 0) {
+#ifdef ENABLE_MPI
+            MPI_Comm_rank(MPI_COMM_WORLD, &server_rank);
+#endif
+            gettimeofday(&finish_time, NULL);
+            elapsed_time = finish_time.tv_sec - current_time.tv_sec +
+                           (finish_time.tv_usec - current_time.tv_usec) / 1000000.0;
+            fprintf(stderr, "==PDC_SERVER[%d]: flushed %d regions to storage (full/every %.0fs), took %.4fs\n",
+                    server_rank, nflush, flush_frequency_s, elapsed_time);
+        }
+        pthread_mutex_lock(&pdc_cache_mutex);
     }
+    pthread_mutex_unlock(&pdc_cache_mutex);
     return 0;
 }
 
@@ -915,9 +1356,7 @@ PDC_transfer_request_data_read_from(uint64_t obj_id, int obj_ndim, const uint64_
     double start = MPI_Wtime();
 #endif
     // PDC_Server_data_read_from2(obj_id, region_info, buf, unit);
-    pthread_mutex_lock(&pdc_obj_cache_list_mutex);
     PDC_region_fetch(obj_id, obj_ndim, obj_dims, region_info, buf, unit);
-    pthread_mutex_unlock(&pdc_obj_cache_list_mutex);
 
 #ifdef PDC_TIMING
     pdc_server_timings->PDCcache_read += MPI_Wtime() - start;
@@ -927,60 +1366,189 @@ PDC_transfer_request_data_read_from(uint64_t obj_id, int obj_ndim, const uint64_
     FUNC_LEAVE(ret_value);
 }
 
+typedef struct pdc_region_cache_read_arg {
+    struct pdc_region_info *region_info;
+    void *                  buf;
+    size_t                  unit;
+    // Parts of the input region not covered by any cached region yet.
+    int      nholes;
+    uint64_t hole_offset[PDC_CACHE_MAX_READ_HOLES][DIM_MAX];
+    uint64_t hole_size[PDC_CACHE_MAX_READ_HOLES][DIM_MAX];
+    // Set when the uncovered part cannot be described with PDC_CACHE_MAX_READ_HOLES regions.
+    int overflow;
+} pdc_region_cache_read_arg;
+
+/*
+ * Subtract a cached region from every hole of a read request. Each hole that overlaps the cached region is
+ * replaced by the slabs of it that lie outside, at most 2 * ndim of them.
+ * Return -1 if the result does not fit in PDC_CACHE_MAX_READ_HOLES holes.
+ */
+static int
+pdc_region_cache_holes_subtract(pdc_region_cache_read_arg *read_arg, int ndim, const uint64_t *offset,
+                                const uint64_t *size)
+{
+    uint64_t new_offset[PDC_CACHE_MAX_READ_HOLES][DIM_MAX];
+    uint64_t new_size[PDC_CACHE_MAX_READ_HOLES][DIM_MAX];
+    uint64_t lo[DIM_MAX], hi[DIM_MAX], cut_lo, cut_hi;
+    int      i, j, k, n = 0;
+
+    for (i = 0; i < read_arg->nholes; ++i) {
+        for (j = 0; j < ndim; ++j) {
+            lo[j] = read_arg->hole_offset[i][j];
+            hi[j] = lo[j] + read_arg->hole_size[i][j];
+            if (hi[j] <= offset[j] || lo[j] >= offset[j] + size[j])
+                break;
+        }
+        if (j < ndim) {
+            // No overlap, the hole is kept as it is.
+            if (n == PDC_CACHE_MAX_READ_HOLES)
+                return -1;
+            memcpy(new_offset[n], read_arg->hole_offset[i], sizeof(uint64_t) * ndim);
+            memcpy(new_size[n], read_arg->hole_size[i], sizeof(uint64_t) * ndim);
+            n++;
+            continue;
+        }
+        for (j = 0; j < ndim; ++j) {
+            cut_lo = lo[j] > offset[j] ? lo[j] : offset[j];
+            cut_hi = hi[j] < offset[j] + size[j] ? hi[j] : offset[j] + size[j];
+            // Slab below the cached region along dimension j
+            if (lo[j] < cut_lo) {
+                if (n == PDC_CACHE_MAX_READ_HOLES)
+                    return -1;
+                for (k = 0; k < ndim; ++k) {
+                    new_offset[n][k] = lo[k];
+                    new_size[n][k]   = hi[k] - lo[k];
+                }
+                new_size[n][j] = cut_lo - lo[j];
+                n++;
+            }
+            // Slab above the cached region along dimension j
+            if (cut_hi < hi[j]) {
+                if (n == PDC_CACHE_MAX_READ_HOLES)
+                    return -1;
+                for (k = 0; k < ndim; ++k) {
+                    new_offset[n][k] = lo[k];
+                    new_size[n][k]   = hi[k] - lo[k];
+                }
+                new_offset[n][j] = cut_hi;
+                new_size[n][j]   = hi[j] - cut_hi;
+                n++;
+            }
+            // The remaining slabs only cover the overlapping range of this dimension.
+            lo[j] = cut_lo;
+            hi[j] = cut_hi;
+        }
+    }
+    memcpy(read_arg->hole_offset, new_offset, sizeof(new_offset[0]) * n);
+    memcpy(read_arg->hole_size, new_size, sizeof(new_size[0]) * n);
+    read_arg->nholes = n;
+    return 0;
+}
+
 /*
- * This function search for an object cache by ID, then copy data from the region to buf if the request region
- * is fully contained inside the cache region.
+ * Copy the part of a read request that overlaps a cached region from the cached buffer and remove that part
+ * from the holes that still have to be read from storage.
+ */
+static int
+pdc_region_cache_read_visit(void *data, void *arg)
+{
+    pdc_region_cache *         region_cache = (pdc_region_cache *)data;
+    pdc_region_cache_read_arg *read_arg     = (pdc_region_cache_read_arg *)arg;
+    struct pdc_region_info *   region_info  = read_arg->region_info;
+    struct pdc_region_info *   cache_info   = region_cache->region_cache_info;
+    uint64_t *                 overlap_offset, *overlap_size;
+
+    PDC_region_overlap_detect(region_info->ndim, region_info->offset, region_info->size, cache_info->offset,
+                              cache_info->size, &overlap_offset, &overlap_size);
+    if (overlap_offset == NULL)
+        return 0;
+    // All cached regions that overlap hold the same copy of the overlapping data, see write_out.
+    memcpy_overlap_subregion(region_info->ndim, read_arg->unit, cache_info->buf, cache_info->offset,
+                             cache_info->size, read_arg->buf, region_info->offset, region_info->size,
+                             overlap_offset, overlap_size);
+    free(overlap_offset);
+
+    if (pdc_region_cache_holes_subtract(read_arg, region_info->ndim, cache_info->offset, cache_info->size) <
+        0) {
+        read_arg->overflow = 1;
+        return 1;
+    }
+    // Stop when the whole input region has been served from the cache.
+    return read_arg->nholes == 0;
+}
+
+/*
+ * This function search for an object cache by ID, then assembles the request region from all cached regions
+ * that overlap it. Only the parts not covered by the cache are read from storage, the cached regions are left
+ * in place. If the uncovered part is too fragmented, the object is flushed and the whole request is read from
+ * storage instead.
  */
 int
 PDC_region_fetch(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims, struct pdc_region_info *region_info,
                  void *buf, size_t unit)
 {
-    pdc_obj_cache *obj_cache = NULL, *obj_cache_iter;
-    int            flag      = 0;
-    // size_t                  j;
-    pdc_region_cache *region_cache_iter;
-    uint64_t *        overlap_offset, *overlap_size;
-
-    obj_cache_iter = obj_cache_list;
-    while (obj_cache_iter != NULL) {
-        if (obj_cache_iter->obj_id == obj_id) {
-            obj_cache = obj_cache_iter;
-        }
-        obj_cache_iter = obj_cache_iter->next;
-    }
+    pdc_obj_cache *            obj_cache;
+    pdc_region_cache_read_arg *read_arg;
+    struct pdc_region_info     hole_info;
+    uint64_t                   hole_buf_size;
+    char *                     hole_buf;
+    int                        i, j;
+
+    read_arg              = (pdc_region_cache_read_arg *)malloc(sizeof(pdc_region_cache_read_arg));
+    read_arg->region_info = region_info;
+    read_arg->buf         = buf;
+    read_arg->unit        = unit;
+    read_arg->nholes      = 1;
+    read_arg->overflow    = 0;
+    memcpy(read_arg->hole_offset[0], region_info->offset, sizeof(uint64_t) * region_info->ndim);
+    memcpy(read_arg->hole_size[0], region_info->size, sizeof(uint64_t) * region_info->ndim);
+
+    obj_cache = pdc_obj_cache_lookup(obj_id, obj_ndim, obj_dims, 0);
     if (obj_cache != NULL) {
-        // printf("region fetch for obj id %llu\n", obj_cache->obj_id);
-
-        // Check if the input region is contained inside any cache region.
-        region_cache_iter = obj_cache->region_cache;
-        while (region_cache_iter != NULL) {
-            flag = detect_region_contained(region_info->offset, region_info->size,
-                                           region_cache_iter->region_cache_info->offset,
-                                           region_cache_iter->region_cache_info->size, region_info->ndim);
-            if (flag) {
-                // flag = 1 means that the input region is fully contained in the cached region, so the return
-                // value of overlap_offset must not be NULL
-                PDC_region_overlap_detect(region_info->ndim, region_info->offset, region_info->size,
-                                          region_cache_iter->region_cache_info->offset,
-                                          region_cache_iter->region_cache_info->size, &overlap_offset,
-                                          &overlap_size);
-                memcpy_overlap_subregion(region_info->ndim, unit, region_cache_iter->region_cache_info->buf,
-                                         region_cache_iter->region_cache_info->offset,
-                                         region_cache_iter->region_cache_info->size, buf, region_info->offset,
-                                         region_info->size, overlap_offset, overlap_size);
-                free(overlap_offset);
-                // flag = 1 at here.
-                break;
-            }
-            region_cache_iter = region_cache_iter->next;
+        pthread_mutex_lock(&obj_cache->mutex);
+        if (obj_cache->region_index != NULL && region_info->ndim <= 3) {
+            pdc_region_index_search(obj_cache->region_index, region_info->offset, region_info->size,
+                                    pdc_region_cache_read_visit, read_arg);
+            pdc_cache_lru_touch(obj_cache, 0);
         }
-    }
-    if (!flag) {
-        if (obj_cache != NULL) {
+        if (read_arg->overflow || region_info->ndim > 3) {
             PDC_region_cache_flush_by_pointer(obj_id, obj_cache);
+            read_arg->nholes = 1;
+            memcpy(read_arg->hole_offset[0], region_info->offset, sizeof(uint64_t) * region_info->ndim);
+            memcpy(read_arg->hole_size[0], region_info->size, sizeof(uint64_t) * region_info->ndim);
         }
-        PDC_Server_transfer_request_io(obj_id, obj_ndim, obj_dims, region_info, buf, unit, 0);
+        pthread_mutex_unlock(&obj_cache->mutex);
+    }
+
+    if (read_arg->nholes == 1 && !memcmp(read_arg->hole_size[0], region_info->size,
+                                         sizeof(uint64_t) * region_info->ndim)) {
+        // Nothing is cached for this region, read it from storage directly into the output buffer.
+        pthread_mutex_lock(&pdc_cache_io_mutex);
+        PDC_Server_transfer_request_io(obj_id, obj_ndim, obj_dims, region_info, buf, unit, PDC_UNKNOWN, 0);
+        pthread_mutex_unlock(&pdc_cache_io_mutex);
+        read_arg->nholes = 0;
+    }
+
+    memset(&hole_info, 0, sizeof(struct pdc_region_info));
+    hole_info.ndim = region_info->ndim;
+    for (i = 0; i < read_arg->nholes; ++i) {
+        hole_buf_size = unit;
+        for (j = 0; j < (int)region_info->ndim; ++j)
+            hole_buf_size *= read_arg->hole_size[i][j];
+        hole_buf         = (char *)malloc(hole_buf_size);
+        hole_info.offset = read_arg->hole_offset[i];
+        hole_info.size   = read_arg->hole_size[i];
+
+        pthread_mutex_lock(&pdc_cache_io_mutex);
+        PDC_Server_transfer_request_io(obj_id, obj_ndim, obj_dims, &hole_info, hole_buf, unit, PDC_UNKNOWN,
+                                       0);
+        pthread_mutex_unlock(&pdc_cache_io_mutex);
+        memcpy_overlap_subregion(region_info->ndim, unit, hole_buf, hole_info.offset, hole_info.size, buf,
+                                 region_info->offset, region_info->size, hole_info.offset, hole_info.size);
+        free(hole_buf);
     }
+
+    free(read_arg);
     return 0;
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "pdc_server_region_io.h"
+#include "thpool.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+typedef struct pdc_server_io_fd_slot {
+    uint64_t obj_id;
+    int      fd;
+    // Number of callers currently using fd, the slot can only be reused when it drops to 0.
+    int nref;
+} pdc_server_io_fd_slot;
+
+typedef struct pdc_server_io_job {
+    pdc_server_io_job_func    run;
+    pdc_server_io_job_func    complete;
+    void *                    arg;
+    struct pdc_server_io_job *next;
+} pdc_server_io_job;
+
+static pdc_server_io_backend_t pdc_server_io_backend_g = PDC_SERVER_IO_VECTOR;
+static pdc_server_io_fd_slot   pdc_server_io_fd_cache[PDC_SERVER_IO_FD_CACHE_SIZE];
+static pthread_mutex_t         pdc_server_io_fd_mutex;
+
+// Worker pool and the queue of jobs whose completion has not been called yet.
+static threadpool         pdc_server_io_pool_g = NULL;
+static pthread_mutex_t    pdc_server_io_done_mutex;
+static pdc_server_io_job *pdc_server_io_done_head = NULL;
+static pdc_server_io_job *pdc_server_io_done_tail = NULL;
+static int                pdc_server_io_pending_g = 0;
+
+perr_t
+PDC_Server_io_init()
+{
+    char *p;
+    int   i, nthread;
+
+    FUNC_ENTER(NULL);
+
+    p = getenv("PDC_SERVER_IO_BACKEND");
+    if (p != NULL && strcmp(p, "posix") == 0)
+        pdc_server_io_backend_g = PDC_SERVER_IO_POSIX;
+    else
+        pdc_server_io_backend_g = PDC_SERVER_IO_VECTOR;
+
+    pthread_mutex_init(&pdc_server_io_fd_mutex, NULL);
+    for (i = 0; i < PDC_SERVER_IO_FD_CACHE_SIZE; ++i) {
+        pdc_server_io_fd_cache[i].fd   = -1;
+        pdc_server_io_fd_cache[i].nref = 0;
+    }
+
+    pthread_mutex_init(&pdc_server_io_done_mutex, NULL);
+    pdc_server_io_done_head = NULL;
+    pdc_server_io_done_tail = NULL;
+    pdc_server_io_pending_g = 0;
+#ifdef PDC_SERVER_CACHE
+    nthread = PDC_SERVER_IO_NTHREAD;
+    p       = getenv("PDC_SERVER_IO_NTHREAD");
+    if (p != NULL)
+        nthread = atoi(p);
+#else
+    // Without the server cache, storage I/O goes through region lists that are only safe on the progress
+    // thread.
+    nthread = 0;
+#endif
+    if (nthread > 0)
+        pdc_server_io_pool_g = thpool_init(nthread);
+
+    FUNC_LEAVE(SUCCEED);
+}
+
+perr_t
+PDC_Server_io_finalize()
+{
+    int i;
+
+    FUNC_ENTER(NULL);
+
+    if (pdc_server_io_pool_g != NULL) {
+        thpool_wait(pdc_server_io_pool_g);
+        thpool_destroy(pdc_server_io_pool_g);
+        pdc_server_io_pool_g = NULL;
+    }
+    PDC_Server_io_progress();
+    pthread_mutex_destroy(&pdc_server_io_done_mutex);
+
+    pthread_mutex_lock(&pdc_server_io_fd_mutex);
+    for (i = 0; i < PDC_SERVER_IO_FD_CACHE_SIZE; ++i) {
+        if (pdc_server_io_fd_cache[i].fd >= 0)
+            close(pdc_server_io_fd_cache[i].fd);
+        pdc_server_io_fd_cache[i].fd   = -1;
+        pdc_server_io_fd_cache[i].nref = 0;
+    }
+    pthread_mutex_unlock(&pdc_server_io_fd_mutex);
+    pthread_mutex_destroy(&pdc_server_io_fd_mutex);
+
+    FUNC_LEAVE(SUCCEED);
+}
+
+pdc_server_io_backend_t
+PDC_Server_io_backend()
+{
+    return pdc_server_io_backend_g;
+}
+
+static void
+pdc_server_io_worker(void *arg)
+{
+    pdc_server_io_job *job = (pdc_server_io_job *)arg;
+
+    job->run(job->arg);
+
+    pthread_mutex_lock(&pdc_server_io_done_mutex);
+    if (pdc_server_io_done_tail == NULL)
+        pdc_server_io_done_head = job;
+    else
+        pdc_server_io_done_tail->next = job;
+    pdc_server_io_done_tail = job;
+    pthread_mutex_unlock(&pdc_server_io_done_mutex);
+}
+
+perr_t
+PDC_Server_io_submit(pdc_server_io_job_func run, pdc_server_io_job_func complete, void *arg)
+{
+    pdc_server_io_job *job;
+    perr_t             ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+
+    if (pdc_server_io_pool_g == NULL) {
+        run(arg);
+        complete(arg);
+        goto done;
+    }
+
+    job           = (pdc_server_io_job *)malloc(sizeof(pdc_server_io_job));
+    job->run      = run;
+    job->complete = complete;
+    job->arg      = arg;
+    job->next     = NULL;
+
+    pthread_mutex_lock(&pdc_server_io_done_mutex);
+    pdc_server_io_pending_g++;
+    pthread_mutex_unlock(&pdc_server_io_done_mutex);
+
+    if (thpool_add_work(pdc_server_io_pool_g, pdc_server_io_worker, job) != 0) {
+        pthread_mutex_lock(&pdc_server_io_done_mutex);
+        pdc_server_io_pending_g--;
+        pthread_mutex_unlock(&pdc_server_io_done_mutex);
+        free(job);
+        run(arg);
+        complete(arg);
+    }
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+int
+PDC_Server_io_progress()
+{
+    pdc_server_io_job *job, *next;
+    int                ncomplete = 0;
+
+    pthread_mutex_lock(&pdc_server_io_done_mutex);
+    job                     = pdc_server_io_done_head;
+    pdc_server_io_done_head = NULL;
+    pdc_server_io_done_tail = NULL;
+    pthread_mutex_unlock(&pdc_server_io_done_mutex);
+
+    while (job != NULL) {
+        next = job->next;
+        job->complete(job->arg);
+        free(job);
+        job = next;
+        ncomplete++;
+    }
+
+    if (ncomplete > 0) {
+        pthread_mutex_lock(&pdc_server_io_done_mutex);
+        pdc_server_io_pending_g -= ncomplete;
+        pthread_mutex_unlock(&pdc_server_io_done_mutex);
+    }
+    return ncomplete;
+}
+
+int
+PDC_Server_io_pending()
+{
+    int pending;
+
+    pthread_mutex_lock(&pdc_server_io_done_mutex);
+    pending = pdc_server_io_pending_g;
+    pthread_mutex_unlock(&pdc_server_io_done_mutex);
+
+    return pending;
+}
+
+int
+PDC_Server_io_fd_get(uint64_t obj_id, const char *path)
+{
+    pdc_server_io_fd_slot *slot = &pdc_server_io_fd_cache[obj_id % PDC_SERVER_IO_FD_CACHE_SIZE];
+    int                    fd;
+
+    pthread_mutex_lock(&pdc_server_io_fd_mutex);
+    if (slot->fd >= 0 && slot->obj_id == obj_id) {
+        slot->nref++;
+        fd = slot->fd;
+    }
+    else if (slot->nref == 0) {
+        // The slot is free or holds an idle descriptor of another object, replace it.
+        if (slot->fd >= 0)
+            close(slot->fd);
+        fd           = open(path, O_RDWR | O_CREAT, 0666);
+        slot->fd     = fd;
+        slot->obj_id = obj_id;
+        slot->nref   = fd >= 0 ? 1 : 0;
+    }
+    else {
+        // Another object is using this slot, this descriptor is not cached.
+        fd = open(path, O_RDWR | O_CREAT, 0666);
+    }
+    pthread_mutex_unlock(&pdc_server_io_fd_mutex);
+
+    return fd;
+}
+
+void
+PDC_Server_io_fd_release(uint64_t obj_id, int fd)
+{
+    pdc_server_io_fd_slot *slot = &pdc_server_io_fd_cache[obj_id % PDC_SERVER_IO_FD_CACHE_SIZE];
+
+    pthread_mutex_lock(&pdc_server_io_fd_mutex);
+    if (slot->fd == fd && slot->obj_id == obj_id)
+        slot->nref--;
+    else
+        close(fd);
+    pthread_mutex_unlock(&pdc_server_io_fd_mutex);
+}
+
+size_t
+PDC_Server_io_box_extents(int ndim, uint64_t file_offset, const uint64_t *file_start,
+                          const uint64_t *file_count, char *buf, const uint64_t *buf_start,
+                          const uint64_t *buf_count, const uint64_t *box_offset, const uint64_t *box_size,
+                          size_t unit, pdc_server_io_extent **extents)
+{
+    int      i;
+    uint64_t index[DIM_MAX];
+    uint64_t row_size, coord, file_pos, buf_pos, nrows = 1;
+    size_t   n_extents = 0, max_extents = 16;
+    char *   row_buf;
+
+    *extents = (pdc_server_io_extent *)malloc(sizeof(pdc_server_io_extent) * max_extents);
+    row_size = box_size[ndim - 1] * unit;
+    for (i = 0; i < ndim - 1; ++i) {
+        nrows *= box_size[i];
+        index[i] = 0;
+    }
+
+    // Walk the rows of the box in row-major order, which is the order of both the file and buf.
+    while (nrows--) {
+        file_pos = 0;
+        buf_pos  = 0;
+        for (i = 0; i < ndim; ++i) {
+            coord    = box_offset[i] + (i < ndim - 1 ? index[i] : 0);
+            file_pos = file_pos * file_count[i] + coord - file_start[i];
+            buf_pos  = buf_pos * buf_count[i] + coord - buf_start[i];
+        }
+        file_pos = file_offset + file_pos * unit;
+        row_buf  = buf + buf_pos * unit;
+
+        if (n_extents > 0 &&
+            (*extents)[n_extents - 1].file_offset + (*extents)[n_extents - 1].length == file_pos &&
+            (*extents)[n_extents - 1].buf + (*extents)[n_extents - 1].length == row_buf) {
+            (*extents)[n_extents - 1].length += row_size;
+        }
+        else {
+            if (n_extents == max_extents) {
+                max_extents *= 2;
+                *extents =
+                    (pdc_server_io_extent *)realloc(*extents, sizeof(pdc_server_io_extent) * max_extents);
+            }
+            (*extents)[n_extents].file_offset = file_pos;
+            (*extents)[n_extents].length      = row_size;
+            (*extents)[n_extents].buf         = row_buf;
+            n_extents++;
+        }
+
+        for (i = ndim - 2; i >= 0; --i) {
+            if (++index[i] < box_size[i])
+                break;
+            index[i] = 0;
+        }
+    }
+    return n_extents;
+}
+
+size_t
+PDC_Server_io_region_extents(int obj_ndim, const uint64_t *obj_dims, struct pdc_region_info *region_info,
+                             char *buf, size_t unit, pdc_server_io_extent **extents)
+{
+    uint64_t origin[DIM_MAX] = {0};
+
+    return PDC_Server_io_box_extents(obj_ndim, 0, origin, obj_dims, buf, region_info->offset,
+                                     region_info->size, region_info->offset, region_info->size, unit,
+                                     extents);
+}
+
+/*
+ * Transfer iovcnt buffers to or from the file starting at offset, resubmitting after short transfers.
+ */
+static perr_t
+pdc_server_io_vector(int fd, struct iovec *iov, int iovcnt, off_t offset, int is_write)
+{
+    ssize_t io_size;
+
+    while (iovcnt > 0) {
+        if (is_write)
+            io_size = pwritev(fd, iov, iovcnt, offset);
+        else
+            io_size = preadv(fd, iov, iovcnt, offset);
+        if (io_size <= 0) {
+            printf("server POSIX %s failed\n", is_write ? "write" : "read");
+            return FAIL;
+        }
+        offset += io_size;
+        while (iovcnt > 0 && (size_t)io_size >= iov->iov_len) {
+            io_size -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + io_size;
+            iov->iov_len -= io_size;
+        }
+    }
+    return SUCCEED;
+}
+
+/*
+ * Read size bytes of the file at offset into buf, the bytes past the end of the file read as zeros.
+ */
+static perr_t
+pdc_server_io_fill(int fd, char *buf, uint64_t size, off_t offset)
+{
+    ssize_t io_size;
+
+    while (size > 0) {
+        io_size = pread(fd, buf, size, offset);
+        if (io_size < 0) {
+            printf("server POSIX read failed\n");
+            return FAIL;
+        }
+        if (io_size == 0) {
+            memset(buf, 0, size);
+            break;
+        }
+        buf += io_size;
+        offset += io_size;
+        size -= io_size;
+    }
+    return SUCCEED;
+}
+
+/*
+ * Transfer a run of extents with one preadv/pwritev call over the file range from the first to the last
+ * extent. The gaps between the extents are read into a scratch buffer, and written back with their current
+ * content. This is only safe because the storage I/O of a file is serialized by its callers.
+ */
+static perr_t
+pdc_server_io_run(int fd, pdc_server_io_extent *extents, size_t n_extents, struct iovec *iov, int is_write)
+{
+    perr_t   ret_value = SUCCEED;
+    uint64_t start_offset, gap, max_gap = 0, span;
+    char *   fill = NULL;
+    size_t   i;
+    int      iovcnt = 0;
+
+    start_offset = extents[0].file_offset;
+    span         = extents[n_extents - 1].file_offset + extents[n_extents - 1].length - start_offset;
+    for (i = 1; i < n_extents; ++i) {
+        gap = extents[i].file_offset - extents[i - 1].file_offset - extents[i - 1].length;
+        if (gap > max_gap)
+            max_gap = gap;
+    }
+    if (max_gap > 0) {
+        // Reads drop the gaps, writes need the current content of the whole range
+        fill = (char *)malloc(is_write ? span : max_gap);
+        if (is_write && pdc_server_io_fill(fd, fill, span, (off_t)start_offset) != SUCCEED) {
+            ret_value = FAIL;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < n_extents; ++i) {
+        if (i > 0) {
+            gap = extents[i].file_offset - extents[i - 1].file_offset - extents[i - 1].length;
+            if (gap > 0) {
+                iov[iovcnt].iov_base = is_write ? fill + extents[i].file_offset - gap - start_offset : fill;
+                iov[iovcnt].iov_len  = gap;
+                iovcnt++;
+            }
+        }
+        iov[iovcnt].iov_base = extents[i].buf;
+        iov[iovcnt].iov_len  = extents[i].length;
+        iovcnt++;
+    }
+    ret_value = pdc_server_io_vector(fd, iov, iovcnt, (off_t)start_offset, is_write);
+
+done:
+    free(fill);
+    return ret_value;
+}
+
+perr_t
+PDC_Server_io_extents(int fd, pdc_server_io_extent *extents, size_t n_extents, int is_write)
+{
+    perr_t        ret_value = SUCCEED;
+    struct iovec *iov;
+    uint64_t      end_offset, gap, span;
+    size_t        i, start;
+    int           iovcnt, has_gap;
+
+    FUNC_ENTER(NULL);
+
+    iov = (struct iovec *)malloc(sizeof(struct iovec) * (2 * n_extents < IOV_MAX ? 2 * n_extents : IOV_MAX));
+    i   = 0;
+    while (i < n_extents) {
+        // Extend the run while the next extent follows within a small gap, each gap takes one more iovec. A
+        // run with gaps is kept below PDC_SERVER_IO_SIEVE_SPAN, a write reads the whole range first.
+        start      = i;
+        end_offset = extents[i].file_offset + extents[i].length;
+        iovcnt     = 1;
+        has_gap    = 0;
+        for (i++; i < n_extents && extents[i].file_offset >= end_offset; i++) {
+            gap = extents[i].file_offset - end_offset;
+            if (gap > PDC_SERVER_IO_SIEVE_GAP || iovcnt + (gap > 0) + 1 > IOV_MAX)
+                break;
+            span = extents[i].file_offset + extents[i].length - extents[start].file_offset;
+            if ((has_gap || gap > 0) && span > PDC_SERVER_IO_SIEVE_SPAN)
+                break;
+            has_gap |= gap > 0;
+            iovcnt += (gap > 0) + 1;
+            end_offset = extents[i].file_offset + extents[i].length;
+        }
+
+        if (pdc_server_io_run(fd, extents + start, i - start, iov, is_write) != SUCCEED)
+            ret_value = FAIL;
+    }
+    free(iov);
+
+    FUNC_LEAVE(ret_value);
+}
@@ -34,109 +34,85 @@ transfer_request_all_bulk_transfer_read_cb2(const struct hg_cb_info *info)
     FUNC_LEAVE(ret);
 }
 
-hg_return_t
-transfer_request_all_bulk_transfer_read_cb(const struct hg_cb_info *info)
+/*
+ * Read all requested regions into the data buffer, called on an I/O worker thread.
+ */
+static void
+transfer_request_all_bulk_transfer_read_io(void *arg)
 {
-    struct transfer_request_all_local_bulk_args2 *local_bulk_args2;
-    struct transfer_request_all_local_bulk_args * local_bulk_args = info->arg;
-    const struct hg_info *                        handle_info;
-    transfer_request_all_data                     request_data;
-    hg_return_t                                   ret = HG_SUCCESS;
-    struct pdc_region_info *                      remote_reg_info;
+    struct transfer_request_all_local_bulk_args2 *local_bulk_args2 = arg;
+    transfer_request_all_data *                   request_data     = &(local_bulk_args2->request_data);
+    struct pdc_region_info                        remote_reg_info;
     int                                           i, j;
-    uint64_t                                      total_mem_size, mem_size;
+    uint64_t                                      mem_size;
     char *                                        ptr;
 
-    FUNC_ENTER(NULL);
-
-#ifdef PDC_TIMING
-    double end;
-#endif
-
-    // printf("entering transfer_request_all_bulk_transfer_read_cb\n");
-    handle_info         = HG_Get_info(local_bulk_args->handle);
-    request_data.n_objs = local_bulk_args->in.n_objs;
-    parse_bulk_data(local_bulk_args->data_buf, &request_data, PDC_READ);
-    // print_bulk_data(&request_data);
-
-    remote_reg_info = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
-    total_mem_size  = 0;
-    for (i = 0; i < request_data.n_objs; ++i) {
-        mem_size = request_data.unit[i];
-        for (j = 0; j < request_data.remote_ndim[i]; ++j) {
-            mem_size *= request_data.remote_length[i][j];
-        }
-        total_mem_size += mem_size;
-    }
-
-    local_bulk_args2 = (struct transfer_request_all_local_bulk_args2 *)malloc(
-        sizeof(struct transfer_request_all_local_bulk_args2));
-    local_bulk_args2->data_buf = (char *)malloc(total_mem_size);
-    ptr                        = local_bulk_args2->data_buf;
-
+    ptr = local_bulk_args2->data_buf;
 #ifndef PDC_SERVER_CACHE
     data_server_region_t **temp_ptrs =
-        (data_server_region_t **)malloc(sizeof(data_server_region_t *) * request_data.n_objs);
-    for (i = 0; i < request_data.n_objs; ++i) {
-        temp_ptrs[i] = PDC_Server_get_obj_region(request_data.obj_id[i]);
-        PDC_Server_register_obj_region_by_pointer(temp_ptrs + i, request_data.obj_id[i], 1);
+        (data_server_region_t **)malloc(sizeof(data_server_region_t *) * request_data->n_objs);
+    for (i = 0; i < request_data->n_objs; ++i) {
+        temp_ptrs[i] = PDC_Server_get_obj_region(request_data->obj_id[i]);
+        PDC_Server_register_obj_region_by_pointer(temp_ptrs + i, request_data->obj_id[i], 1);
     }
 #endif
-    for (i = 0; i < request_data.n_objs; ++i) {
-        remote_reg_info->ndim   = request_data.remote_ndim[i];
-        remote_reg_info->offset = request_data.remote_offset[i];
-        remote_reg_info->size   = request_data.remote_length[i];
-
-        mem_size = request_data.unit[i];
-        for (j = 0; j < request_data.remote_ndim[i]; ++j) {
-            mem_size *= request_data.remote_length[i][j];
+    for (i = 0; i < request_data->n_objs; ++i) {
+        remote_reg_info.ndim   = request_data->remote_ndim[i];
+        remote_reg_info.offset = request_data->remote_offset[i];
+        remote_reg_info.size   = request_data->remote_length[i];
+
+        mem_size = request_data->unit[i];
+        for (j = 0; j < request_data->remote_ndim[i]; ++j) {
+            mem_size *= request_data->remote_length[i][j];
         }
 
 #ifdef PDC_SERVER_CACHE
-        PDC_transfer_request_data_read_from(request_data.obj_id[i], request_data.obj_ndim[i],
-                                            request_data.obj_dims[i], remote_reg_info, (void *)ptr,
-                                            request_data.unit[i]);
+        PDC_transfer_request_data_read_from(request_data->obj_id[i], request_data->obj_ndim[i],
+                                            request_data->obj_dims[i], &remote_reg_info, (void *)ptr,
+                                            request_data->unit[i]);
 #else
-        PDC_Server_transfer_request_io(request_data.obj_id[i], request_data.obj_ndim[i],
-                                       request_data.obj_dims[i], remote_reg_info, (void *)ptr,
-                                       request_data.unit[i], 0);
-#endif
-#if 0
-        fprintf(stderr, "server read array, offset = %lu, size = %lu:", request_data.remote_offset[i][0], request_data.remote_length[i][0]); uint64_t k; 
-        for ( k = 0; k < remote_reg_info->size[0]; ++k ) {
-            fprintf(stderr, "%d,", *(int*)(ptr + sizeof(int) * k));
-        }
-        fprintf(stderr, "\n");
+        PDC_Server_transfer_request_io(request_data->obj_id[i], request_data->obj_ndim[i],
+                                       request_data->obj_dims[i], &remote_reg_info, (void *)ptr,
+                                       request_data->unit[i], request_data->obj_type[i], 0);
 #endif
         ptr += mem_size;
     }
 #ifndef PDC_SERVER_CACHE
-    for (i = 0; i < request_data.n_objs; ++i) {
+    for (i = 0; i < request_data->n_objs; ++i) {
         PDC_Server_unregister_obj_region_by_pointer(temp_ptrs[i], 1);
     }
     free(temp_ptrs);
 #endif
+}
+
+/*
+ * Push the data read by transfer_request_all_bulk_transfer_read_io to the client, called on the progress
+ * thread.
+ */
+static void
+transfer_request_all_bulk_transfer_read_done(void *arg)
+{
+    struct transfer_request_all_local_bulk_args2 *local_bulk_args2 = arg;
+    struct transfer_request_all_local_bulk_args * local_bulk_args  = local_bulk_args2->args;
+    const struct hg_info *                        handle_info;
+    hg_return_t                                   ret;
 
 #ifdef PDC_TIMING
     // PDCreg_transfer_request_wait_all_read_bulk includes the timing for transfering metadata and read I/O
     // time.
-    end = MPI_Wtime();
+    double end = MPI_Wtime();
     pdc_server_timings->PDCreg_transfer_request_start_all_read_bulk_rpc += end - local_bulk_args->start_time;
     pdc_timestamp_register(pdc_transfer_request_start_all_read_bulk_timestamps, local_bulk_args->start_time,
                            end);
 
     local_bulk_args2->start_time = end;
 #endif
-    local_bulk_args2->handle              = local_bulk_args->handle;
-    local_bulk_args2->transfer_request_id = local_bulk_args->transfer_request_id;
-    local_bulk_args2->request_data        = request_data;
-
-    ret = HG_Bulk_create(handle_info->hg_class, 1, &(local_bulk_args2->data_buf), &total_mem_size,
-                         HG_BULK_READWRITE, &(local_bulk_args2->bulk_handle));
+    handle_info = HG_Get_info(local_bulk_args->handle);
+    ret         = HG_Bulk_create(handle_info->hg_class, 1, &(local_bulk_args2->data_buf),
+                         &(local_bulk_args2->total_mem_size), HG_BULK_READWRITE,
+                         &(local_bulk_args2->bulk_handle));
     if (ret != HG_SUCCESS) {
-        printf("Error at transfer_request_all_bulk_transfer_read_cb(const struct hg_cb_info *info): @ line "
-               "%d \n",
-               __LINE__);
+        printf("Error at transfer_request_all_bulk_transfer_read_done(void *arg): @ line %d \n", __LINE__);
     }
 
     // This is the actual data transfer. When transfer is finished, we are heading our way to the function
@@ -144,107 +120,164 @@ transfer_request_all_bulk_transfer_read_cb(const struct hg_cb_info *info)
     ret =
         HG_Bulk_transfer(handle_info->context, transfer_request_all_bulk_transfer_read_cb2, local_bulk_args2,
                          HG_BULK_PUSH, handle_info->addr, local_bulk_args->in.local_bulk_handle, 0,
-                         local_bulk_args2->bulk_handle, 0, total_mem_size, HG_OP_ID_IGNORE);
+                         local_bulk_args2->bulk_handle, 0, local_bulk_args2->total_mem_size, HG_OP_ID_IGNORE);
     if (ret != HG_SUCCESS) {
-        printf("Error at transfer_request_all_bulk_transfer_read_cb(const struct hg_cb_info *info): @ line "
-               "%d \n",
-               __LINE__);
+        printf("Error at transfer_request_all_bulk_transfer_read_done(void *arg): @ line %d \n", __LINE__);
     }
     // pointers in request_data are freed in the next call back function
     free(local_bulk_args->data_buf);
-    free(remote_reg_info);
 
     HG_Bulk_free(local_bulk_args->bulk_handle);
 
     HG_Free_input(local_bulk_args->handle, &(local_bulk_args->in));
 
     free(local_bulk_args);
-
-    FUNC_LEAVE(ret);
 }
 
 hg_return_t
-transfer_request_all_bulk_transfer_write_cb(const struct hg_cb_info *info)
+transfer_request_all_bulk_transfer_read_cb(const struct hg_cb_info *info)
 {
-    struct transfer_request_all_local_bulk_args *local_bulk_args = info->arg;
-    transfer_request_all_data                    request_data;
-    hg_return_t                                  ret = HG_SUCCESS;
-    struct pdc_region_info *                     remote_reg_info;
-    int                                          i;
+    struct transfer_request_all_local_bulk_args2 *local_bulk_args2;
+    struct transfer_request_all_local_bulk_args * local_bulk_args = info->arg;
+    transfer_request_all_data                     request_data;
+    hg_return_t                                   ret = HG_SUCCESS;
+    int                                           i, j;
+    uint64_t                                      total_mem_size, mem_size;
 
     FUNC_ENTER(NULL);
 
-#ifdef PDC_TIMING
-    double end = MPI_Wtime(), start;
-    pdc_server_timings->PDCreg_transfer_request_start_all_write_bulk_rpc += end - local_bulk_args->start_time;
-    pdc_timestamp_register(pdc_transfer_request_start_all_write_bulk_timestamps, local_bulk_args->start_time,
-                           end);
-    start = MPI_Wtime();
-#endif
-
-    // printf("entering transfer_request_all_bulk_transfer_write_cb\n");
-    remote_reg_info     = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
+    // printf("entering transfer_request_all_bulk_transfer_read_cb\n");
     request_data.n_objs = local_bulk_args->in.n_objs;
-    parse_bulk_data(local_bulk_args->data_buf, &request_data, PDC_WRITE);
+    parse_bulk_data(local_bulk_args->data_buf, &request_data, PDC_READ);
     // print_bulk_data(&request_data);
+
+    total_mem_size = 0;
+    for (i = 0; i < request_data.n_objs; ++i) {
+        mem_size = request_data.unit[i];
+        for (j = 0; j < request_data.remote_ndim[i]; ++j) {
+            mem_size *= request_data.remote_length[i][j];
+        }
+        total_mem_size += mem_size;
+    }
+
+    local_bulk_args2 = (struct transfer_request_all_local_bulk_args2 *)malloc(
+        sizeof(struct transfer_request_all_local_bulk_args2));
+    local_bulk_args2->data_buf            = (char *)malloc(total_mem_size);
+    local_bulk_args2->total_mem_size      = total_mem_size;
+    local_bulk_args2->handle              = local_bulk_args->handle;
+    local_bulk_args2->transfer_request_id = local_bulk_args->transfer_request_id;
+    local_bulk_args2->request_data        = request_data;
+    local_bulk_args2->args                = local_bulk_args;
+
+    // Storage reads run on an I/O worker, the data is pushed to the client when they complete.
+    PDC_Server_io_submit(transfer_request_all_bulk_transfer_read_io,
+                         transfer_request_all_bulk_transfer_read_done, local_bulk_args2);
+
+    FUNC_LEAVE(ret);
+}
+
+/*
+ * Write all received regions, called on an I/O worker thread.
+ */
+static void
+transfer_request_all_bulk_transfer_write_io(void *arg)
+{
+    struct transfer_request_all_local_bulk_args *local_bulk_args = arg;
+    transfer_request_all_data *                  request_data    = &(local_bulk_args->request_data);
+    struct pdc_region_info                       remote_reg_info;
+    int                                          i;
+
 #ifndef PDC_SERVER_CACHE
     data_server_region_t **temp_ptrs =
-        (data_server_region_t **)malloc(sizeof(data_server_region_t *) * request_data.n_objs);
-    for (i = 0; i < request_data.n_objs; ++i) {
-        temp_ptrs[i] = PDC_Server_get_obj_region(request_data.obj_id[i]);
-        PDC_Server_register_obj_region_by_pointer(temp_ptrs + i, request_data.obj_id[i], 1);
+        (data_server_region_t **)malloc(sizeof(data_server_region_t *) * request_data->n_objs);
+    for (i = 0; i < request_data->n_objs; ++i) {
+        temp_ptrs[i] = PDC_Server_get_obj_region(request_data->obj_id[i]);
+        PDC_Server_register_obj_region_by_pointer(temp_ptrs + i, request_data->obj_id[i], 1);
     }
 #endif
-    for (i = 0; i < request_data.n_objs; ++i) {
-        remote_reg_info->ndim   = request_data.remote_ndim[i];
-        remote_reg_info->offset = request_data.remote_offset[i];
-        remote_reg_info->size   = request_data.remote_length[i];
+    for (i = 0; i < request_data->n_objs; ++i) {
+        remote_reg_info.ndim   = request_data->remote_ndim[i];
+        remote_reg_info.offset = request_data->remote_offset[i];
+        remote_reg_info.size   = request_data->remote_length[i];
 #ifdef PDC_SERVER_CACHE
-        PDC_transfer_request_data_write_out(request_data.obj_id[i], request_data.obj_ndim[i],
-                                            request_data.obj_dims[i], remote_reg_info,
-                                            (void *)request_data.data_buf[i], request_data.unit[i]);
+        PDC_transfer_request_data_write_out(request_data->obj_id[i], request_data->obj_ndim[i],
+                                            request_data->obj_dims[i], &remote_reg_info,
+                                            (void *)request_data->data_buf[i], request_data->unit[i],
+                                            request_data->obj_type[i]);
 #else
-        PDC_Server_transfer_request_io(request_data.obj_id[i], request_data.obj_ndim[i],
-                                       request_data.obj_dims[i], remote_reg_info,
-                                       (void *)request_data.data_buf[i], request_data.unit[i], 1);
-#endif
-#if 0
-        uint64_t j;
-        fprintf(stderr, "server write array, offset = %lu, size = %lu:", request_data.remote_offset[i][0], request_data.remote_length[i][0]);
-        for ( j = 0; j < remote_reg_info->size[0]; ++j ) {
-            fprintf(stderr, "%d,", *(int*)(request_data.data_buf[i] + sizeof(int) * j));
-        }
-        fprintf(stderr, "\n");
+        PDC_Server_transfer_request_io(request_data->obj_id[i], request_data->obj_ndim[i],
+                                       request_data->obj_dims[i], &remote_reg_info,
+                                       (void *)request_data->data_buf[i], request_data->unit[i],
+                                       request_data->obj_type[i], 1);
 #endif
-        pthread_mutex_lock(&transfer_request_status_mutex);
-        PDC_finish_request(local_bulk_args->transfer_request_id[i]);
-        pthread_mutex_unlock(&transfer_request_status_mutex);
     }
 #ifndef PDC_SERVER_CACHE
-    for (i = 0; i < request_data.n_objs; ++i) {
+    for (i = 0; i < request_data->n_objs; ++i) {
         PDC_Server_unregister_obj_region_by_pointer(temp_ptrs[i], 1);
     }
     free(temp_ptrs);
 #endif
+}
+
+/*
+ * Mark the requests of transfer_request_all_bulk_transfer_write_io as finished, called on the progress
+ * thread.
+ */
+static void
+transfer_request_all_bulk_transfer_write_done(void *arg)
+{
+    struct transfer_request_all_local_bulk_args *local_bulk_args = arg;
+    int                                          i;
+
+    pthread_mutex_lock(&transfer_request_status_mutex);
+    for (i = 0; i < local_bulk_args->request_data.n_objs; ++i) {
+        PDC_finish_request(local_bulk_args->transfer_request_id[i]);
+    }
+    pthread_mutex_unlock(&transfer_request_status_mutex);
 
-    clean_write_bulk_data(&request_data);
+    clean_write_bulk_data(&(local_bulk_args->request_data));
     free(local_bulk_args->transfer_request_id);
     free(local_bulk_args->data_buf);
-    free(remote_reg_info);
 
     HG_Bulk_free(local_bulk_args->bulk_handle);
 
     HG_Free_input(local_bulk_args->handle, &(local_bulk_args->in));
     HG_Destroy(local_bulk_args->handle);
 
+#ifdef PDC_TIMING
+    double end = MPI_Wtime();
+    pdc_server_timings->PDCreg_transfer_request_inner_write_all_bulk_rpc += end - local_bulk_args->start_time;
+    pdc_timestamp_register(pdc_transfer_request_inner_write_all_bulk_timestamps, local_bulk_args->start_time,
+                           end);
+#endif
+
     free(local_bulk_args);
+}
+
+hg_return_t
+transfer_request_all_bulk_transfer_write_cb(const struct hg_cb_info *info)
+{
+    struct transfer_request_all_local_bulk_args *local_bulk_args = info->arg;
+    hg_return_t                                  ret             = HG_SUCCESS;
+
+    FUNC_ENTER(NULL);
 
 #ifdef PDC_TIMING
-    end = MPI_Wtime();
-    pdc_server_timings->PDCreg_transfer_request_inner_write_all_bulk_rpc += end - start;
-    pdc_timestamp_register(pdc_transfer_request_inner_write_all_bulk_timestamps, start, end);
+    double end = MPI_Wtime();
+    pdc_server_timings->PDCreg_transfer_request_start_all_write_bulk_rpc += end - local_bulk_args->start_time;
+    pdc_timestamp_register(pdc_transfer_request_start_all_write_bulk_timestamps, local_bulk_args->start_time,
+                           end);
+    local_bulk_args->start_time = MPI_Wtime();
 #endif
 
+    // printf("entering transfer_request_all_bulk_transfer_write_cb\n");
+    local_bulk_args->request_data.n_objs = local_bulk_args->in.n_objs;
+    parse_bulk_data(local_bulk_args->data_buf, &(local_bulk_args->request_data), PDC_WRITE);
+    // print_bulk_data(&request_data);
+
+    PDC_Server_io_submit(transfer_request_all_bulk_transfer_write_io,
+                         transfer_request_all_bulk_transfer_write_done, local_bulk_args);
+
     FUNC_LEAVE(ret);
 }
 
@@ -315,25 +348,61 @@ transfer_request_wait_all_bulk_transfer_cb(const struct hg_cb_info *info)
     FUNC_LEAVE(ret);
 }
 
-hg_return_t
-transfer_request_bulk_transfer_write_cb(const struct hg_cb_info *info)
+/*
+ * Write a single region, called on an I/O worker thread.
+ */
+static void
+transfer_request_bulk_transfer_write_io(void *arg)
 {
-    struct transfer_request_local_bulk_args *local_bulk_args = info->arg;
-    hg_return_t                              ret             = HG_SUCCESS;
-    struct pdc_region_info *                 remote_reg_info;
-    uint64_t                                 obj_dims[3];
+    struct transfer_request_local_bulk_args *local_bulk_args = arg;
 
-    FUNC_ENTER(NULL);
+#ifdef PDC_SERVER_CACHE
+    PDC_transfer_request_data_write_out(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim,
+                                        local_bulk_args->obj_dims, local_bulk_args->remote_reg_info,
+                                        (void *)local_bulk_args->data_buf, local_bulk_args->in.remote_unit,
+                                        (pdc_var_type_t)local_bulk_args->in.obj_type);
+#else
+    PDC_Server_transfer_request_io(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim,
+                                   local_bulk_args->obj_dims, local_bulk_args->remote_reg_info,
+                                   (void *)local_bulk_args->data_buf, local_bulk_args->in.remote_unit,
+                                   (pdc_var_type_t)local_bulk_args->in.obj_type, 1);
+#endif
+}
+
+/*
+ * Mark the request of transfer_request_bulk_transfer_write_io as finished, called on the progress thread.
+ */
+static void
+transfer_request_bulk_transfer_write_done(void *arg)
+{
+    struct transfer_request_local_bulk_args *local_bulk_args = arg;
+
+    pthread_mutex_lock(&transfer_request_status_mutex);
+    PDC_finish_request(local_bulk_args->transfer_request_id);
+    pthread_mutex_unlock(&transfer_request_status_mutex);
+    free(local_bulk_args->data_buf);
+    free(local_bulk_args->remote_reg_info->offset);
+    free(local_bulk_args->remote_reg_info->size);
+    free(local_bulk_args->remote_reg_info);
+
+    HG_Bulk_free(local_bulk_args->bulk_handle);
 
 #ifdef PDC_TIMING
-    double end = MPI_Wtime(), start;
-    pdc_server_timings->PDCreg_transfer_request_start_write_bulk_rpc += end - local_bulk_args->start_time;
-    pdc_timestamp_register(pdc_transfer_request_start_write_bulk_timestamps, local_bulk_args->start_time,
+    double end = MPI_Wtime();
+    pdc_server_timings->PDCreg_transfer_request_inner_write_bulk_rpc += end - local_bulk_args->start_time;
+    pdc_timestamp_register(pdc_transfer_request_inner_write_bulk_timestamps, local_bulk_args->start_time,
                            end);
-    start = MPI_Wtime();
 #endif
+    free(local_bulk_args);
+}
 
-    // printf("entering transfer bulk callback\n");
+/*
+ * Copy the region of a transfer request from its RPC input into remote_reg_info and obj_dims.
+ */
+static void
+transfer_request_set_remote_region(struct transfer_request_local_bulk_args *local_bulk_args)
+{
+    struct pdc_region_info *remote_reg_info;
 
     remote_reg_info = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
 
@@ -343,45 +412,42 @@ transfer_request_bulk_transfer_write_cb(const struct hg_cb_info *info)
     if (remote_reg_info->ndim >= 1) {
         (remote_reg_info->offset)[0] = (local_bulk_args->in.remote_region).start_0;
         (remote_reg_info->size)[0]   = (local_bulk_args->in.remote_region).count_0;
-        obj_dims[0]                  = (local_bulk_args->in).obj_dim0;
+        local_bulk_args->obj_dims[0] = (local_bulk_args->in).obj_dim0;
     }
     if (remote_reg_info->ndim >= 2) {
         (remote_reg_info->offset)[1] = (local_bulk_args->in.remote_region).start_1;
         (remote_reg_info->size)[1]   = (local_bulk_args->in.remote_region).count_1;
-        obj_dims[1]                  = (local_bulk_args->in).obj_dim1;
+        local_bulk_args->obj_dims[1] = (local_bulk_args->in).obj_dim1;
     }
     if (remote_reg_info->ndim >= 3) {
         (remote_reg_info->offset)[2] = (local_bulk_args->in.remote_region).start_2;
         (remote_reg_info->size)[2]   = (local_bulk_args->in.remote_region).count_2;
-        obj_dims[2]                  = (local_bulk_args->in).obj_dim2;
+        local_bulk_args->obj_dims[2] = (local_bulk_args->in).obj_dim2;
     }
-/*
-    printf("Server transfer request at write branch, index 1 value = %d\n",
-           *((int *)(local_bulk_args->data_buf + sizeof(int))));
-*/
-#ifdef PDC_SERVER_CACHE
-    PDC_transfer_request_data_write_out(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim, obj_dims,
-                                        remote_reg_info, (void *)local_bulk_args->data_buf,
-                                        local_bulk_args->in.remote_unit);
-#else
-    PDC_Server_transfer_request_io(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim, obj_dims,
-                                   remote_reg_info, (void *)local_bulk_args->data_buf,
-                                   local_bulk_args->in.remote_unit, 1);
-#endif
-    pthread_mutex_lock(&transfer_request_status_mutex);
-    PDC_finish_request(local_bulk_args->transfer_request_id);
-    pthread_mutex_unlock(&transfer_request_status_mutex);
-    free(local_bulk_args->data_buf);
-    free(remote_reg_info);
+    local_bulk_args->remote_reg_info = remote_reg_info;
+}
 
-    HG_Bulk_free(local_bulk_args->bulk_handle);
+hg_return_t
+transfer_request_bulk_transfer_write_cb(const struct hg_cb_info *info)
+{
+    struct transfer_request_local_bulk_args *local_bulk_args = info->arg;
+    hg_return_t                              ret             = HG_SUCCESS;
+
+    FUNC_ENTER(NULL);
 
 #ifdef PDC_TIMING
-    end = MPI_Wtime();
-    pdc_server_timings->PDCreg_transfer_request_inner_write_bulk_rpc += end - start;
-    pdc_timestamp_register(pdc_transfer_request_inner_write_bulk_timestamps, start, end);
+    double end = MPI_Wtime();
+    pdc_server_timings->PDCreg_transfer_request_start_write_bulk_rpc += end - local_bulk_args->start_time;
+    pdc_timestamp_register(pdc_transfer_request_start_write_bulk_timestamps, local_bulk_args->start_time,
+                           end);
+    local_bulk_args->start_time = MPI_Wtime();
 #endif
 
+    // printf("entering transfer bulk callback\n");
+    transfer_request_set_remote_region(local_bulk_args);
+    PDC_Server_io_submit(transfer_request_bulk_transfer_write_io, transfer_request_bulk_transfer_write_done,
+                         local_bulk_args);
+
     FUNC_LEAVE(ret);
 }
 
@@ -415,6 +481,62 @@ transfer_request_bulk_transfer_read_cb(const struct hg_cb_info *info)
     FUNC_LEAVE(ret);
 }
 
+/*
+ * Read a single region, called on an I/O worker thread.
+ */
+static void
+transfer_request_bulk_transfer_read_io(void *arg)
+{
+    struct transfer_request_local_bulk_args *local_bulk_args = arg;
+
+#ifdef PDC_SERVER_CACHE
+    PDC_transfer_request_data_read_from(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim,
+                                        local_bulk_args->obj_dims, local_bulk_args->remote_reg_info,
+                                        (void *)local_bulk_args->data_buf, local_bulk_args->in.remote_unit);
+#else
+    PDC_Server_transfer_request_io(local_bulk_args->in.obj_id, local_bulk_args->in.obj_ndim,
+                                   local_bulk_args->obj_dims, local_bulk_args->remote_reg_info,
+                                   (void *)local_bulk_args->data_buf, local_bulk_args->in.remote_unit,
+                                   (pdc_var_type_t)local_bulk_args->in.obj_type, 0);
+#endif
+}
+
+/*
+ * Push the data read by transfer_request_bulk_transfer_read_io to the client, called on the progress thread.
+ */
+static void
+transfer_request_bulk_transfer_read_done(void *arg)
+{
+    struct transfer_request_local_bulk_args *local_bulk_args = arg;
+    const struct hg_info *                   info;
+    hg_return_t                              ret_value;
+
+    free(local_bulk_args->remote_reg_info->offset);
+    free(local_bulk_args->remote_reg_info->size);
+    free(local_bulk_args->remote_reg_info);
+
+    info      = HG_Get_info(local_bulk_args->handle);
+    ret_value = HG_Bulk_create(info->hg_class, 1, &(local_bulk_args->data_buf),
+                               (const hg_size_t *)&(local_bulk_args->total_mem_size), HG_BULK_READWRITE,
+                               &(local_bulk_args->bulk_handle));
+    if (ret_value != HG_SUCCESS) {
+        printf("Error at transfer_request_bulk_transfer_read_done(void *arg): @ line %d \n", __LINE__);
+    }
+
+    // This is the actual data transfer. When transfer is finished, we are heading our way to the function
+    // transfer_request_bulk_transfer_cb.
+    ret_value = HG_Bulk_transfer(info->context, transfer_request_bulk_transfer_read_cb, local_bulk_args,
+                                 HG_BULK_PUSH, info->addr, local_bulk_args->in.local_bulk_handle, 0,
+                                 local_bulk_args->bulk_handle, 0, local_bulk_args->total_mem_size,
+                                 HG_OP_ID_IGNORE);
+    if (ret_value != HG_SUCCESS) {
+        printf("Error at transfer_request_bulk_transfer_read_done(void *arg): @ line %d \n", __LINE__);
+    }
+
+    HG_Free_input(local_bulk_args->handle, &(local_bulk_args->in));
+    HG_Destroy(local_bulk_args->handle);
+}
+
 /* static hg_return_t */
 // transfer_request_status_cb(hg_handle_t handle)
 HG_TEST_RPC_CB(transfer_request_status, handle)
@@ -643,7 +765,8 @@ transfer_request_metadata_query_bulk_transfer_cb(const struct hg_cb_info *info)
     free(local_bulk_args->data_buf);
     // printf("transfer_request_metadata_query_bulk_transfer_cb: checkpoint %d\n", __LINE__);
 
-    out.ret = 1;
+    // No query is made when a region to write cannot be placed
+    out.ret = out.query_id == 0 ? -1 : 1;
     ret     = HG_Respond(local_bulk_args->handle, NULL, NULL, &out);
     HG_Bulk_free(local_bulk_args->bulk_handle);
     HG_Destroy(local_bulk_args->handle);
@@ -762,8 +885,6 @@ HG_TEST_RPC_CB(transfer_request, handle)
     struct transfer_request_local_bulk_args *local_bulk_args;
     size_t                                   total_mem_size;
     const struct hg_info *                   info;
-    struct pdc_region_info *                 remote_reg_info;
-    uint64_t                                 obj_dims[3];
 
     FUNC_ENTER(NULL);
 
@@ -825,81 +946,20 @@ HG_TEST_RPC_CB(transfer_request, handle)
     }
     else {
         // in.access_type == PDC_READ
-
-        remote_reg_info = (struct pdc_region_info *)malloc(sizeof(struct pdc_region_info));
-
-        remote_reg_info->ndim   = (in.remote_region).ndim;
-        remote_reg_info->offset = (uint64_t *)malloc(remote_reg_info->ndim * sizeof(uint64_t));
-        remote_reg_info->size   = (uint64_t *)malloc(remote_reg_info->ndim * sizeof(uint64_t));
-        if (remote_reg_info->ndim >= 1) {
-            (remote_reg_info->offset)[0] = (in.remote_region).start_0;
-            (remote_reg_info->size)[0]   = (in.remote_region).count_0;
-            obj_dims[0]                  = in.obj_dim0;
-        }
-        if (remote_reg_info->ndim >= 2) {
-            (remote_reg_info->offset)[1] = (in.remote_region).start_1;
-            (remote_reg_info->size)[1]   = (in.remote_region).count_1;
-            obj_dims[1]                  = in.obj_dim1;
-        }
-        if (remote_reg_info->ndim >= 3) {
-            (remote_reg_info->offset)[2] = (in.remote_region).start_2;
-            (remote_reg_info->size)[2]   = (in.remote_region).count_2;
-            obj_dims[2]                  = in.obj_dim2;
-        }
-#ifdef PDC_SERVER_CACHE
-        PDC_transfer_request_data_read_from(in.obj_id, in.obj_ndim, obj_dims, remote_reg_info,
-                                            (void *)local_bulk_args->data_buf, in.remote_unit);
-#else
-        PDC_Server_transfer_request_io(in.obj_id, in.obj_ndim, obj_dims, remote_reg_info,
-                                       (void *)local_bulk_args->data_buf, in.remote_unit, 0);
-#endif
-        /*
-                printf("ndim = %d\n", in.obj_ndim);
-                if (in.obj_ndim == 2) {
-                    printf("offset[0] = %" PRIu64 ", length[0] = %" PRIu64 ", offset[1] = %" PRIu64 ",
-           length[1] = %" PRIu64 "\n", (remote_reg_info->offset)[0], (remote_reg_info->size)[0],
-           (remote_reg_info->offset)[1], (remote_reg_info->size)[1]);
-                }
-                uint64_t total_data_size = (remote_reg_info->size)[0];
-                if (remote_reg_info->ndim >= 2) {
-                    total_data_size *= (remote_reg_info->size)[1];
-                }
-                if (remote_reg_info->ndim >= 3) {
-                    total_data_size *= (remote_reg_info->size)[2];
-                }
-                int *int_ptr = local_bulk_args->data_buf;
-                uint64_t i;
-                 printf("Read data print out\n");
-                for ( i = 0; i < total_data_size; ++i ) {
-                    printf("%d ", int_ptr[i]);
-                }
-                printf("\n");
-                printf("--------------------\n");
-        */
-        /*
-                printf("Server transfer request at read branch index 1 value is %d\n",
-                       *((int *)(local_bulk_args->data_buf + sizeof(int))));
-        */
-        ret_value = HG_Bulk_create(info->hg_class, 1, &(local_bulk_args->data_buf),
-                                   (const hg_size_t *)&(local_bulk_args->total_mem_size), HG_BULK_READWRITE,
-                                   &(local_bulk_args->bulk_handle));
-        if (ret_value != HG_SUCCESS) {
-            printf("Error at HG_TEST_RPC_CB(transfer_request, handle): @ line %d \n", __LINE__);
-        }
-
-        // This is the actual data transfer. When transfer is finished, we are heading our way to the function
-        // transfer_request_bulk_transfer_cb.
-        ret_value = HG_Bulk_transfer(info->context, transfer_request_bulk_transfer_read_cb, local_bulk_args,
-                                     HG_BULK_PUSH, info->addr, in.local_bulk_handle, 0,
-                                     local_bulk_args->bulk_handle, 0, total_mem_size, HG_OP_ID_IGNORE);
-        free(remote_reg_info);
+        // The read runs on an I/O worker, transfer_request_bulk_transfer_read_done pushes the data to the
+        // client and releases the handle.
+        transfer_request_set_remote_region(local_bulk_args);
+        PDC_Server_io_submit(transfer_request_bulk_transfer_read_io, transfer_request_bulk_transfer_read_done,
+                             local_bulk_args);
     }
     if (ret_value != HG_SUCCESS) {
         printf("Error at HG_TEST_RPC_CB(transfer_request, handle): @ line %d \n", __LINE__);
     }
 
-    HG_Free_input(handle, &in);
-    HG_Destroy(handle);
+    if (in.access_type == PDC_WRITE) {
+        HG_Free_input(handle, &in);
+        HG_Destroy(handle);
+    }
 
 #ifdef PDC_TIMING
     end = MPI_Wtime();
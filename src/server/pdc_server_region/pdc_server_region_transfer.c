@@ -1,5 +1,6 @@
 #include "pdc_client_server_common.h"
 #include "pdc_server_data.h"
+#include "pdc_server_region_io.h"
 static int io_by_region_g = 1;
 
 int
@@ -29,6 +30,7 @@ PDC_server_transfer_request_init()
     pthread_mutex_init(&transfer_request_status_mutex, NULL);
     pthread_mutex_init(&transfer_request_id_mutex, NULL);
     transfer_request_id_g = 1;
+    PDC_Server_io_init();
 
     FUNC_LEAVE(SUCCEED);
 }
@@ -40,6 +42,7 @@ PDC_server_transfer_request_finalize()
 
     pthread_mutex_destroy(&transfer_request_status_mutex);
     pthread_mutex_destroy(&transfer_request_id_mutex);
+    PDC_Server_io_finalize();
 
     FUNC_LEAVE(SUCCEED);
 }
@@ -268,7 +271,8 @@ PDC_transfer_request_id_register()
 
 perr_t
 PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *obj_dims,
-                               struct pdc_region_info *region_info, void *buf, size_t unit, int is_write)
+                               struct pdc_region_info *region_info, void *buf, size_t unit,
+                               pdc_var_type_t data_type, int is_write)
 {
     perr_t   ret_value = SUCCEED;
     int      fd;
@@ -278,6 +282,9 @@ PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *ob
     ssize_t  io_size;
     uint64_t i, j;
 
+    pdc_server_io_extent *extents;
+    size_t                n_extents;
+
     int server_rank = get_server_rank();
 
     FUNC_ENTER(NULL);
@@ -285,7 +292,7 @@ PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *ob
     if (io_by_region_g || obj_ndim == 0) {
         // PDC_Server_register_obj_region(obj_id);
         if (is_write) {
-            PDC_Server_data_write_out(obj_id, region_info, buf, unit);
+            PDC_Server_data_write_out(obj_id, region_info, buf, unit, data_type);
         }
         else {
             PDC_Server_data_read_from(obj_id, region_info, buf, unit);
@@ -312,6 +319,21 @@ PDC_Server_transfer_request_io(uint64_t obj_id, int obj_ndim, const uint64_t *ob
              server_rank, server_rank);
     PDC_mkdir(storage_location);
 
+    if (PDC_Server_io_backend() == PDC_SERVER_IO_VECTOR) {
+        fd = PDC_Server_io_fd_get(obj_id, storage_location);
+        if (fd < 0) {
+            printf("==PDC_SERVER[%d]: failed to open %s\n", server_rank, storage_location);
+            ret_value = FAIL;
+            goto done;
+        }
+        n_extents =
+            PDC_Server_io_region_extents(obj_ndim, obj_dims, region_info, (char *)buf, unit, &extents);
+        ret_value = PDC_Server_io_extents(fd, extents, n_extents, is_write);
+        free(extents);
+        PDC_Server_io_fd_release(obj_id, fd);
+        goto done;
+    }
+
     fd = open(storage_location, O_RDWR | O_CREAT, 0666);
     if (region_info->ndim == 1) {
         // printf("server I/O checkpoint 1D\n");
@@ -406,6 +428,7 @@ clean_write_bulk_data(transfer_request_all_data *request_data)
     free(request_data->remote_ndim);
     free(request_data->remote_offset);
     free(request_data->unit);
+    free(request_data->obj_type);
     free(request_data->data_buf);
     return 0;
 }
@@ -444,6 +467,7 @@ parse_bulk_data(void *buf, transfer_request_all_data *request_data, pdc_access_t
     request_data->remote_length = request_data->remote_offset + request_data->n_objs;
     request_data->obj_dims      = request_data->remote_length + request_data->n_objs;
     request_data->unit          = (size_t *)malloc(sizeof(size_t) * request_data->n_objs);
+    request_data->obj_type      = (pdc_var_type_t *)malloc(sizeof(pdc_var_type_t) * request_data->n_objs);
     request_data->data_buf      = (char **)malloc(sizeof(char *) * request_data->n_objs);
 
     /*
@@ -452,6 +476,7 @@ parse_bulk_data(void *buf, transfer_request_all_data *request_data, pdc_access_t
      *     obj_ndim: sizeof(int)
      *     remote remote_ndim: sizeof(int)
      *     unit: sizeof(size_t)
+     *     obj_type: sizeof(int)
      */
     for (i = 0; i < request_data->n_objs; ++i) {
         request_data->obj_id[i] = *((pdcid_t *)ptr);
@@ -462,6 +487,8 @@ parse_bulk_data(void *buf, transfer_request_all_data *request_data, pdc_access_t
         ptr += sizeof(int);
         request_data->unit[i] = *((pdcid_t *)ptr);
         ptr += sizeof(size_t);
+        request_data->obj_type[i] = (pdc_var_type_t) * ((int *)ptr);
+        ptr += sizeof(int);
     }
     /*
      * For each of objects
@@ -3,6 +3,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "pdc_region.h"
+#ifdef IS_PDC_SERVER
+#include "pdc_server_metadata_wal.h"
+#endif
 
 typedef struct pdc_region_metadata_pkg {
     uint64_t *                      reg_offset;
@@ -44,7 +47,7 @@ static pthread_mutex_t         metadata_query_mutex;
 static perr_t   transfer_request_metadata_reg_append(pdc_region_metadata_pkg *regions, int ndim,
                                                      uint64_t *reg_offset, uint64_t *reg_size, size_t unit,
                                                      uint32_t data_server_id, uint8_t region_partition);
-static uint64_t transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_offset,
+static perr_t   transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_offset,
                                                        uint64_t *reg_size, size_t unit,
                                                        uint32_t data_server_id, uint8_t region_partition);
 static uint64_t metadata_query_buf_create(pdc_obj_region_metadata *regions, int size,
@@ -110,7 +113,7 @@ transfer_request_metadata_query_init(int pdc_server_size_input, char *checkpoint
             ptr += sizeof(uint64_t) * metadata_server_objs_end->ndim * 2;
 
             for (j = 1; j < reg_count; ++j) {
-                metadata_server_objs_end->regions->next =
+                metadata_server_objs_end->regions_end->next =
                     (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
                 metadata_server_objs_end->regions_end = metadata_server_objs_end->regions_end->next;
 
@@ -238,6 +241,26 @@ transfer_request_metadata_query_checkpoint(char **checkpoint, uint64_t *checkpoi
     FUNC_LEAVE(ret_value);
 }
 
+/**
+ * Add a region whose data server was chosen before, when the metadata log is replayed.
+ * Nothing is added if the object already has a region that contains it.
+ */
+perr_t
+transfer_request_metadata_query_restore(uint64_t obj_id, int ndim, uint64_t *reg_offset, uint64_t *reg_size,
+                                        uint32_t data_server_id)
+{
+    perr_t ret_value = SUCCEED;
+
+    FUNC_ENTER(NULL);
+    pthread_mutex_lock(&metadata_query_mutex);
+
+    ret_value = transfer_request_metadata_query_append(obj_id, ndim, reg_offset, reg_size, 0, data_server_id,
+                                                       PDC_REGION_STATIC);
+
+    pthread_mutex_unlock(&metadata_query_mutex);
+    FUNC_LEAVE(ret_value);
+}
+
 /*
  * Wrap the overlapping portions for each of the regions into a contiguous buffer.
  * Output is an ID that can be used to trace this buffer.
@@ -406,7 +429,8 @@ done:
 /*
  * We generate a metadata_query ID for later referencing. Parse input buffer and scan local metadata.
  * Output: query ID, the query entry contains obj ID, data server ID and overlapping region (client can
- * directly use these information to forward its requests)
+ * directly use these information to forward its requests). The query ID is 0 if the placement of a region
+ * to write cannot be logged.
  */
 uint64_t
 transfer_request_metadata_query_parse(int32_t n_objs, char *buf, uint8_t is_write,
@@ -440,14 +464,20 @@ transfer_request_metadata_query_parse(int32_t n_objs, char *buf, uint8_t is_writ
         ptr += sizeof(uint64_t) * region_metadata[i].ndim;
         region_metadata[i].reg_size = (uint64_t *)ptr;
         ptr += sizeof(uint64_t) * region_metadata[i].ndim;
-        if (is_write) {
+        if (is_write &&
             transfer_request_metadata_query_append(region_metadata[i].obj_id, region_metadata[i].ndim,
                                                    region_metadata[i].reg_offset, region_metadata[i].reg_size,
-                                                   unit, data_server_id, region_partition);
+                                                   unit, data_server_id, region_partition) != SUCCEED) {
+            printf("==PDC_SERVER: %s - cannot log the placement of a region of obj %" PRIu64 "\n", __func__,
+                   region_metadata[i].obj_id);
+            *total_buf_size_ptr = 0;
+            goto done;
         }
     }
     // printf("transfer_request_metadata_query_parse: checkpoint %d\n", __LINE__);
     query_id = metadata_query_buf_create(region_metadata, n_objs, total_buf_size_ptr);
+
+done:
     free(region_metadata);
     // printf("transfer_request_metadata_query_parse: checkpoint %d\n", __LINE__);
 
@@ -505,16 +535,20 @@ transfer_request_metadata_reg_append(pdc_region_metadata_pkg *regions, int ndim,
     FUNC_LEAVE(ret_value);
 }
 
-static uint64_t
+/*
+ * Place a region on a data server, unless the object already has a region that contains it. The placement
+ * is only kept once it is in the metadata log.
+ */
+static perr_t
 transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_offset, uint64_t *reg_size,
                                        size_t unit, uint32_t data_server_id, uint8_t region_partition)
 {
+    perr_t                   ret_value = SUCCEED;
     pdc_obj_metadata_pkg *   temp;
     pdc_region_metadata_pkg *region_metadata;
     pdc_region_metadata_pkg *temp_region_metadata;
 
     FUNC_ENTER(NULL);
-    // printf("transfer_request_metadata_query_append: checkpoint %d\n", __LINE__);
     temp = metadata_server_objs;
     while (temp) {
         if (temp->obj_id == obj_id) {
@@ -522,7 +556,41 @@ transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_
         }
         temp = temp->next;
     }
-    // printf("transfer_request_metadata_query_append: checkpoint %d\n", __LINE__);
+    if (temp != NULL) {
+        region_metadata = temp->regions;
+        while (region_metadata) {
+            if (detect_region_contained(reg_offset, reg_size, region_metadata->reg_offset,
+                                        region_metadata->reg_size, ndim)) {
+                goto done;
+            }
+            region_metadata = region_metadata->next;
+        }
+    }
+
+    // Reaching this line means that we are creating a new region and append it to the end of the object list.
+    temp_region_metadata = (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
+    transfer_request_metadata_reg_append(temp_region_metadata, ndim, reg_offset, reg_size, unit,
+                                         data_server_id, region_partition);
+#ifdef IS_PDC_SERVER
+    // This file is also built into the client library, which has no metadata log
+    if (PDC_Server_wal_log_region_place(obj_id, temp_region_metadata->data_server_id, ndim, reg_offset,
+                                        reg_size) != SUCCEED) {
+        if (region_partition == PDC_REGION_DYNAMIC) {
+            uint64_t total_reg_size = unit;
+            int      i;
+
+            // The bytes placed on the server steer the later placements
+            for (i = 0; i < ndim; ++i)
+                total_reg_size *= reg_size[i];
+            data_server_bytes[temp_region_metadata->data_server_id] -= total_reg_size;
+        }
+        free(temp_region_metadata->reg_offset);
+        free(temp_region_metadata);
+        ret_value = FAIL;
+        goto done;
+    }
+#endif
+
     if (temp == NULL) {
         temp = (pdc_obj_metadata_pkg *)malloc(sizeof(pdc_obj_metadata_pkg));
         if (metadata_server_objs) {
@@ -539,21 +607,6 @@ transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_
         metadata_server_objs_end->obj_id      = obj_id;
         metadata_server_objs_end->ndim        = ndim;
     }
-    // printf("transfer_request_metadata_query_append: checkpoint %d\n", __LINE__);
-    region_metadata = temp->regions;
-    while (region_metadata) {
-        if (detect_region_contained(reg_offset, reg_size, region_metadata->reg_offset,
-                                    region_metadata->reg_size, ndim)) {
-            // printf("%lu, %lu, %lu ,%lu\n", reg_offset[0], reg_size[0], region_metadata->reg_offset[0],
-            //       region_metadata->reg_size[0]);
-            // printf("---------------transfer_request_metadata_query_append: detected repeated requests\n");
-            FUNC_LEAVE(region_metadata->data_server_id);
-        }
-        region_metadata = region_metadata->next;
-    }
-    // Reaching this line means that we are creating a new region and append it to the end of the object list.
-    // printf("transfer_request_metadata_query_append: checkpoint %d\n", __LINE__);
-    temp_region_metadata = (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
     if (temp->regions) {
         temp->regions_end->next = temp_region_metadata;
         temp->regions_end       = temp_region_metadata;
@@ -562,9 +615,8 @@ transfer_request_metadata_query_append(uint64_t obj_id, int ndim, uint64_t *reg_
         temp->regions     = temp_region_metadata;
         temp->regions_end = temp_region_metadata;
     }
-    transfer_request_metadata_reg_append(temp_region_metadata, ndim, reg_offset, reg_size, unit,
-                                         data_server_id, region_partition);
-    // printf("transfer_request_metadata_query_append: checkpoint %d\n", __LINE__);
+
+done:
     fflush(stdout);
-    FUNC_LEAVE(temp->regions_end->data_server_id);
+    FUNC_LEAVE(ret_value);
 }
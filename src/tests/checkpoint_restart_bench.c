@@ -0,0 +1,155 @@
+/*
+ * Copyright Notice for
+ * Proactive Data Containers (PDC) Software Library and Utilities
+ * -----------------------------------------------------------------------------
+
+ *** Copyright Notice ***
+
+ * Proactive Data Containers (PDC) Copyright (c) 2017, The Regents of the
+ * University of California, through Lawrence Berkeley National Laboratory,
+ * UChicago Argonne, LLC, operator of Argonne National Laboratory, and The HDF
+ * Group (subject to receipt of any required approvals from the U.S. Dept. of
+ * Energy).  All rights reserved.
+
+ * If you have questions about your rights to use or distribute this software,
+ * please contact Berkeley Lab's Innovation & Partnerships Office at  IPO@lbl.gov.
+
+ * NOTICE.  This Software was developed under funding from the U.S. Department of
+ * Energy and the U.S. Government consequently retains certain rights. As such, the
+ * U.S. Government has been granted for itself and others acting on its behalf a
+ * paid-up, nonexclusive, irrevocable, worldwide license in the Software to
+ * reproduce, distribute copies to the public, prepare derivative works, and
+ * perform publicly and display publicly, and to permit other to do so.
+ */
+
+/*
+ * Run in create mode to create objects with a kvtag, then in verify mode after the server restarted from its
+ * checkpoint to check and time that every object and kvtag came back. The server prints its own restart time.
+ *
+ * Usage: checkpoint_restart_bench create|verify [n_obj]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "pdc.h"
+#include "pdc_client_connect.h"
+
+#define CONT_NAME "checkpoint_restart_bench"
+
+static double
+elapsed(struct timeval *start)
+{
+    struct timeval end;
+
+    gettimeofday(&end, 0);
+    return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1e6;
+}
+
+static int
+create_objects(pdcid_t pdc, int n_obj)
+{
+    pdcid_t        cont_prop, cont, obj_prop, obj;
+    char           obj_name[64];
+    int            i;
+    struct timeval start;
+
+    cont_prop = PDCprop_create(PDC_CONT_CREATE, pdc);
+    cont      = PDCcont_create(CONT_NAME, cont_prop);
+    obj_prop  = PDCprop_create(PDC_OBJ_CREATE, pdc);
+    if (cont <= 0 || obj_prop <= 0) {
+        printf("Fail to create container @ line  %d!\n", __LINE__);
+        return 1;
+    }
+
+    gettimeofday(&start, 0);
+    for (i = 0; i < n_obj; i++) {
+        sprintf(obj_name, "ckpt_obj_%d", i);
+        obj = PDCobj_create(cont, obj_name, obj_prop);
+        if (obj <= 0) {
+            printf("Fail to create object %s @ line  %d!\n", obj_name, __LINE__);
+            return 1;
+        }
+        if (PDCobj_put_tag(obj, "ckpt_idx", &i, PDC_INT, sizeof(int)) < 0) {
+            printf("Fail to add a kvtag to %s\n", obj_name);
+            return 1;
+        }
+        PDCobj_close(obj);
+    }
+    printf("Created %d objects with a kvtag in %.3fs\n", n_obj, elapsed(&start));
+
+    PDCprop_close(obj_prop);
+    PDCcont_close(cont);
+    PDCprop_close(cont_prop);
+    return 0;
+}
+
+static int
+check_objects(pdcid_t pdc, pdcid_t cont, int n_obj)
+{
+    pdcid_t        obj;
+    char           obj_name[64];
+    void *         value;
+    pdc_var_type_t type;
+    psize_t        value_size;
+    int            i, n_bad = 0;
+    struct timeval start;
+
+    gettimeofday(&start, 0);
+    for (i = 0; i < n_obj; i++) {
+        sprintf(obj_name, "ckpt_obj_%d", i);
+        obj = PDCobj_open(obj_name, pdc);
+        if (obj <= 0) {
+            printf("Fail to open object %s after restart\n", obj_name);
+            n_bad++;
+            continue;
+        }
+        value = NULL;
+        if (PDCobj_get_tag(obj, "ckpt_idx", &value, &type, &value_size) < 0 || value == NULL ||
+            value_size != sizeof(int) || *(int *)value != i) {
+            printf("Wrong kvtag of object %s after restart\n", obj_name);
+            n_bad++;
+        }
+        free(value);
+        PDCobj_close(obj);
+    }
+    printf("Opened %d objects and their kvtag after restart in %.3fs, %d mismatches\n", n_obj,
+           elapsed(&start), n_bad);
+
+    PDCcont_close(cont);
+    return n_bad == 0 ? 0 : 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    pdcid_t pdc, cont;
+    int     n_obj = 10000, verify, ret;
+
+    if (argc < 2 || (strcmp(argv[1], "create") != 0 && strcmp(argv[1], "verify") != 0)) {
+        printf("Usage: %s create|verify [n_obj]\n", argv[0]);
+        return 1;
+    }
+    verify = strcmp(argv[1], "verify") == 0;
+    if (argc > 2)
+        n_obj = atoi(argv[2]);
+
+    pdc = PDCinit("pdc");
+
+    if (verify) {
+        // The container only exists if the server restarted from the checkpoint of the create run
+        cont = PDCcont_open(CONT_NAME, pdc);
+        if (cont <= 0) {
+            printf("Fail to open container %s after restart\n", CONT_NAME);
+            ret = 1;
+        }
+        else
+            ret = check_objects(pdc, cont, n_obj);
+    }
+    else
+        ret = create_objects(pdc, n_obj);
+
+    PDCclose(pdc);
+    return ret;
+}
@@ -89,6 +89,25 @@ main(int argc, char **argv)
 
     println("[Client_Side_Infix] Search '%s' and get %d results : %llu", infix_query, rest_count4, out4[0]);
 
+    // This is for testing batched insert and delete, one bulk transfer per server.
+    char *   batch_keys[3] = {"batchk1", "batchk2", "batchk2"};
+    char *   batch_vals[3] = {"batchv1", "batchv2", "batchv2"};
+    uint64_t batch_data[3] = {1001, 1002, 1003};
+    PDC_Client_insert_obj_ref_into_dart_batch(hash_algo, 3, batch_keys, batch_vals, ref_type, batch_data);
+
+    char *    batch_query = "batchk2=batchv2";
+    uint64_t *out5;
+    int       rest_count5 = 0;
+    PDC_Client_search_obj_ref_through_dart(hash_algo, batch_query, ref_type, &rest_count5, &out5);
+
+    println("[Client_Side_Batch_Insert] Search '%s' and get %d results", batch_query, rest_count5);
+
+    PDC_Client_delete_obj_ref_from_dart_batch(hash_algo, 3, batch_keys, batch_vals, ref_type, batch_data);
+    rest_count5 = 0;
+    PDC_Client_search_obj_ref_through_dart(hash_algo, batch_query, ref_type, &rest_count5, &out5);
+
+    println("[Client_Side_Batch_Delete] Search '%s' and get %d results", batch_query, rest_count5);
+
     // }
 
     // done:
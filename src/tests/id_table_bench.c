@@ -0,0 +1,122 @@
+/*
+ * Copyright Notice for
+ * Proactive Data Containers (PDC) Software Library and Utilities
+ * -----------------------------------------------------------------------------
+
+ *** Copyright Notice ***
+
+ * Proactive Data Containers (PDC) Copyright (c) 2017, The Regents of the
+ * University of California, through Lawrence Berkeley National Laboratory,
+ * UChicago Argonne, LLC, operator of Argonne National Laboratory, and The HDF
+ * Group (subject to receipt of any required approvals from the U.S. Dept. of
+ * Energy).  All rights reserved.
+
+ * If you have questions about your rights to use or distribute this software,
+ * please contact Berkeley Lab's Innovation & Partnerships Office at  IPO@lbl.gov.
+
+ * NOTICE.  This Software was developed under funding from the U.S. Department of
+ * Energy and the U.S. Government consequently retains certain rights. As such, the
+ * U.S. Government has been granted for itself and others acting on its behalf a
+ * paid-up, nonexclusive, irrevocable, worldwide license in the Software to
+ * reproduce, distribute copies to the public, prepare derivative works, and
+ * perform publicly and display publicly, and to permit other to do so.
+ */
+
+/*
+ * Time the registration, lookup and release of client IDs for an increasing number of live IDs, and compare
+ * the lookup with a search of the list of IDs of the type. No server is needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pdc_malloc.h"
+#include "pdc_interface.h"
+
+#define NLIST_FIND 1000
+
+static double
+elapsed_ns(struct timeval *start, struct timeval *end, uint64_t n)
+{
+    return ((end->tv_sec - start->tv_sec) * 1e9 + (end->tv_usec - start->tv_usec) * 1e3) / n;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint64_t             n, max_n = 1000000, i, j, tmp;
+    pdcid_t *            ids;
+    struct _pdc_id_info *id_ptr;
+    struct PDC_id_type * type_ptr;
+    struct timeval       t0, t1, t2, t3, t4;
+    int                  ret_value = 0;
+
+    if (argc > 1)
+        max_n = strtoull(argv[1], NULL, 10);
+
+    pdc_id_list_g = (struct pdc_id_list *)PDC_calloc(1, sizeof(struct pdc_id_list));
+    ids           = (pdcid_t *)malloc(max_n * sizeof(pdcid_t));
+    if (pdc_id_list_g == NULL || ids == NULL || PDC_register_type(PDC_REGION, NULL) < 0) {
+        printf("Failed to set up the ID type\n");
+        return 1;
+    }
+    type_ptr = pdc_id_list_g->PDC_id_type_list_g[PDC_REGION];
+
+    srand(11);
+    printf("%10s %12s %12s %12s %14s\n", "live IDs", "create (ns)", "find (ns)", "close (ns)",
+           "list find (ns)");
+    for (n = 1000; n <= max_n; n *= 10) {
+        gettimeofday(&t0, 0);
+        for (i = 0; i < n; i++)
+            ids[i] = PDC_id_register(PDC_REGION, &ids[i]);
+        gettimeofday(&t1, 0);
+
+        // Look up and release the IDs in random order
+        for (i = n - 1; i > 0; i--) {
+            j      = (uint64_t)rand() % (i + 1);
+            tmp    = ids[i];
+            ids[i] = ids[j];
+            ids[j] = tmp;
+        }
+        for (i = 0; i < n; i++) {
+            id_ptr = PDC_find_id(ids[i]);
+            if (id_ptr == NULL || id_ptr->id != ids[i]) {
+                printf("Failed to find ID %" PRIu64 "\n", ids[i]);
+                ret_value = 1;
+                goto done;
+            }
+        }
+        gettimeofday(&t2, 0);
+
+        for (i = 0; i < NLIST_FIND; i++) {
+            PDC_LIST_SEARCH(id_ptr, &type_ptr->ids, entry, id, ids[i % n]);
+            if (id_ptr == NULL) {
+                printf("Failed to find ID %" PRIu64 " in the list\n", ids[i % n]);
+                ret_value = 1;
+                goto done;
+            }
+        }
+        gettimeofday(&t3, 0);
+
+        for (i = 0; i < n; i++)
+            PDC_dec_ref(ids[i]);
+        gettimeofday(&t4, 0);
+
+        if (type_ptr->id_count != 0 || PDC_find_id(ids[0]) != NULL) {
+            printf("IDs left after release\n");
+            ret_value = 1;
+            goto done;
+        }
+
+        printf("%10" PRIu64 " %12.1f %12.1f %12.1f %14.1f\n", n, elapsed_ns(&t0, &t1, n),
+               elapsed_ns(&t1, &t2, n), elapsed_ns(&t3, &t4, n), elapsed_ns(&t2, &t3, NLIST_FIND));
+    }
+
+done:
+    PDC_destroy_type(PDC_REGION);
+    PDC_free(pdc_id_list_g);
+    free(ids);
+
+    return ret_value;
+}
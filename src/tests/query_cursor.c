@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "pdc.h"
+#include "pdc_client_connect.h"
+#include "pdc_client_server_common.h"
+
+#define NELEM_PER_RANK 100000
+#define FETCH_NHITS    1000
+
+void
+print_usage()
+{
+    printf("Usage: srun -n ./query_cursor obj_name\n");
+}
+
+// Fetch the hits of q through a cursor and compare them with the selection and the written values
+static int
+check_cursor(pdc_query_t *q, uint64_t obj_id, pdc_selection_t *sel)
+{
+    pdc_query_cursor_t cursor;
+    pdc_selection_t    sel_part;
+    uint64_t           i, nfetched, nbytes;
+    int *              data;
+    int                ret_value = 0;
+
+    memset(&sel_part, 0, sizeof(pdc_selection_t));
+    if (PDCquery_cursor_open(q, &cursor) < 0 || cursor.nhits != sel->nhits) {
+        printf("Fail to open query cursor @ line %d\n", __LINE__);
+        return 1;
+    }
+
+    nfetched = 0;
+    while (PDCquery_cursor_next_sel(&cursor, FETCH_NHITS, &sel_part) >= 0 && sel_part.nhits > 0) {
+        if (memcmp(sel_part.coords, sel->coords + nfetched * sel->ndim,
+                   sel_part.nhits * sel->ndim * sizeof(uint64_t)) != 0) {
+            printf("Cursor hits differ from the selection at hit %" PRIu64 "\n", nfetched);
+            ret_value = 1;
+            break;
+        }
+        nfetched += sel_part.nhits;
+    }
+    if (ret_value == 0 && nfetched != sel->nhits) {
+        printf("Cursor fetched %" PRIu64 " of %" PRIu64 " hits\n", nfetched, sel->nhits);
+        ret_value = 1;
+    }
+    PDCquery_cursor_close(&cursor);
+    PDCselection_free(&sel_part);
+    if (ret_value != 0)
+        return ret_value;
+
+    // The value written at each coordinate is the coordinate plus one, so no hit can read back as 0. Each
+    // server reads the hits it found, all of them can be fetched however many servers there are.
+    if (PDCquery_cursor_open(q, &cursor) < 0) {
+        printf("Fail to open query cursor @ line %d\n", __LINE__);
+        return 1;
+    }
+    data     = (int *)malloc(FETCH_NHITS * sizeof(int));
+    nfetched = 0;
+    while (1) {
+        if (PDCquery_cursor_next_data(&cursor, obj_id, FETCH_NHITS * sizeof(int), data, &nbytes) < 0) {
+            printf("Fail to fetch query data at hit %" PRIu64 " @ line %d\n", nfetched, __LINE__);
+            ret_value = 1;
+            break;
+        }
+        if (nbytes == 0)
+            break;
+        for (i = 0; i < nbytes / sizeof(int); i++) {
+            if ((uint64_t)data[i] != sel->coords[nfetched + i] + 1) {
+                printf("Cursor data %d at hit %" PRIu64 " differs from %" PRIu64 "\n", data[i], nfetched + i,
+                       sel->coords[nfetched + i] + 1);
+                ret_value = 1;
+                break;
+            }
+        }
+        if (ret_value != 0)
+            break;
+        nfetched += nbytes / sizeof(int);
+    }
+    if (ret_value == 0 && nfetched != sel->nhits) {
+        printf("Cursor fetched data of %" PRIu64 " of %" PRIu64 " hits\n", nfetched, sel->nhits);
+        ret_value = 1;
+    }
+    PDCquery_cursor_close(&cursor);
+    free(data);
+
+    return ret_value;
+}
+
+// Compare the aggregate of the values at the hits of q with the one computed from the selection
+static int
+check_aggregate(pdc_query_t *q, uint64_t obj_id, pdc_selection_t *sel)
+{
+    pdc_query_agg_t agg;
+    uint64_t        i;
+    double          sum = 0, min = 0, max = 0;
+    int             ret_value = 0;
+
+    if (PDCquery_get_aggregate(q, obj_id, &agg) < 0) {
+        // A server cannot reduce the hits whose values are stored on another one
+        if (pdc_server_num_g == 1) {
+            printf("Fail to get query aggregate @ line %d\n", __LINE__);
+            return 1;
+        }
+        printf("Query aggregate needs values from another server\n");
+        return 0;
+    }
+
+    for (i = 0; i < sel->nhits; i++) {
+        sum += sel->coords[i] + 1;
+        if (i == 0 || sel->coords[i] + 1 < min)
+            min = sel->coords[i] + 1;
+        if (i == 0 || sel->coords[i] + 1 > max)
+            max = sel->coords[i] + 1;
+    }
+    if (agg.count != sel->nhits || agg.sum != sum || (agg.count > 0 && (agg.min != min || agg.max != max))) {
+        printf("Aggregate count %" PRIu64 " sum %.1f min %.1f max %.1f differs from the selection\n",
+               agg.count, agg.sum, agg.min, agg.max);
+        ret_value = 1;
+    }
+    PDCquery_agg_free(&agg);
+
+    return ret_value;
+}
+
+int
+main(int argc, char **argv)
+{
+    int                    rank = 0, size = 1;
+    pdcid_t                pdc, cont_prop, cont, obj_prop, obj_id = 0;
+    struct pdc_region_info region;
+    uint64_t               i, dims[1];
+    pdc_selection_t        sel;
+    char *                 obj_name;
+    pdc_metadata_t *       metadata = NULL;
+    uint32_t               metadata_server_id;
+    int *                  mydata;
+    int                    lo0 = 1000;
+    int                    lo1 = 50000, hi1 = 60000;
+    pdc_query_t *          q0, *q1l, *q1h, *q1, *q;
+    int                    ret_value = 0;
+
+#ifdef ENABLE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+#endif
+
+    if (argc < 2) {
+        print_usage();
+#ifdef ENABLE_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+    obj_name = argv[1];
+
+    // create a pdc
+    pdc = PDCinit("pdc");
+
+    // create a container property
+    cont_prop = PDCprop_create(PDC_CONT_CREATE, pdc);
+    if (cont_prop <= 0) {
+        printf("Fail to create container property @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    // create a container
+    cont = PDCcont_create("c1", cont_prop);
+    if (cont <= 0) {
+        printf("Fail to create container @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    // create an object property
+    obj_prop = PDCprop_create(PDC_OBJ_CREATE, pdc);
+    if (obj_prop <= 0) {
+        printf("Fail to create object property @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    dims[0] = (uint64_t)NELEM_PER_RANK * size;
+    PDCprop_set_obj_dims(obj_prop, 1, dims);
+    PDCprop_set_obj_user_id(obj_prop, getuid());
+    PDCprop_set_obj_time_step(obj_prop, 0);
+    PDCprop_set_obj_app_name(obj_prop, "DataServerTest");
+    PDCprop_set_obj_tags(obj_prop, "tag0=1");
+    PDCprop_set_obj_type(obj_prop, PDC_INT);
+
+    // Create a object with only rank 0
+    if (rank == 0) {
+        obj_id = PDCobj_create(cont, obj_name, obj_prop);
+        if (obj_id <= 0) {
+            printf("Error getting an object id of %s from server, exit...\n", obj_name);
+            ret_value = 1;
+        }
+    }
+
+#ifdef ENABLE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+    PDC_Client_query_metadata_name_timestep(obj_name, 0, &metadata, &metadata_server_id);
+    if (metadata == NULL || metadata->obj_id == 0) {
+        printf("Error with metadata!\n");
+        ret_value = 1;
+        goto done;
+    }
+
+    // Each rank writes its own piece, in bytes, so the storage regions can land on different servers
+    region.ndim      = 1;
+    region.offset    = (uint64_t *)malloc(sizeof(uint64_t));
+    region.size      = (uint64_t *)malloc(sizeof(uint64_t));
+    region.offset[0] = (uint64_t)rank * NELEM_PER_RANK * sizeof(int);
+    region.size[0]   = NELEM_PER_RANK * sizeof(int);
+
+    mydata = (int *)malloc(NELEM_PER_RANK * sizeof(int));
+    for (i = 0; i < NELEM_PER_RANK; i++)
+        mydata[i] = rank * NELEM_PER_RANK + i + 1;
+
+    if (PDC_Client_write(metadata, &region, mydata) != SUCCEED) {
+        printf("Fail to write data @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+
+#ifdef ENABLE_MPI
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+
+    if (rank == 0) {
+        q0  = PDCquery_create(metadata->obj_id, PDC_LT, PDC_INT, &lo0);
+        q1l = PDCquery_create(metadata->obj_id, PDC_GTE, PDC_INT, &lo1);
+        q1h = PDCquery_create(metadata->obj_id, PDC_LT, PDC_INT, &hi1);
+        q1  = PDCquery_and(q1l, q1h);
+        q   = PDCquery_or(q0, q1);
+
+        memset(&sel, 0, sizeof(pdc_selection_t));
+        if (PDCquery_get_selection(q, &sel) < 0) {
+            printf("Fail to get query selection @ line %d\n", __LINE__);
+            ret_value = 1;
+        }
+        else {
+            if (check_cursor(q, metadata->obj_id, &sel) != 0)
+                ret_value = 1;
+            if (check_aggregate(q, metadata->obj_id, &sel) != 0)
+                ret_value = 1;
+        }
+
+        PDCquery_free_all(q);
+        PDCselection_free(&sel);
+    }
+
+    PDCregion_free(&region);
+    free(mydata);
+
+done:
+    // close a container
+    if (PDCcont_close(cont) < 0) {
+        printf("fail to close container c1\n");
+        ret_value = 1;
+    }
+    // close a container property
+    if (PDCprop_close(cont_prop) < 0) {
+        printf("Fail to close property @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    if (PDCclose(pdc) < 0) {
+        printf("fail to close PDC\n");
+        ret_value = 1;
+    }
+#ifdef ENABLE_MPI
+    MPI_Allreduce(MPI_IN_PLACE, &ret_value, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Finalize();
+#endif
+
+    return ret_value;
+}
@@ -12,7 +12,8 @@
 void
 print_usage()
 {
-    printf("Usage: srun -n ./query_data obj_name size_MB\n");
+    printf("Usage: srun -n ./query_data obj_name size_MB [sel_file]\n");
+    printf("       sel_file: write the coordinates of the hits there, to compare server configurations\n");
 }
 
 int
@@ -23,8 +24,12 @@ main(int argc, char **argv)
     pdcid_t                obj_id = -1;
     struct pdc_region_info region;
     uint64_t               i, dims[1];
-    pdc_selection_t        sel;
+    pdc_selection_t        sel, sel_part;
+    pdc_query_cursor_t     cursor;
+    pdc_query_agg_t        agg;
+    uint64_t               nfetched;
     char *                 obj_name;
+    FILE *                 sel_file;
     int                    my_data_count;
     pdc_metadata_t *       metadata;
     pdcid_t                pdc, cont_prop, cont, obj_prop;
@@ -166,6 +171,57 @@ main(int argc, char **argv)
 
     PDCselection_print(&sel);
 
+    if (argc > 3 && rank == 0) {
+        sel_file = fopen(argv[3], "w");
+        if (sel_file == NULL) {
+            printf("Fail to open %s @ line %d\n", argv[3], __LINE__);
+            ret_value = 1;
+        }
+        else {
+            fprintf(sel_file, "%" PRIu64 " hits\n", sel.nhits);
+            for (i = 0; i < sel.nhits * sel.ndim; i++)
+                fprintf(sel_file, "%" PRIu64 "\n", sel.coords[i]);
+            fclose(sel_file);
+        }
+    }
+
+    // The same hits fetched a piece at a time through a cursor
+    memset(&sel_part, 0, sizeof(pdc_selection_t));
+    if (PDCquery_cursor_open(q, &cursor) < 0 || cursor.nhits != sel.nhits) {
+        printf("Fail to open query cursor @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    else {
+        nfetched = 0;
+        while (PDCquery_cursor_next_sel(&cursor, 1000, &sel_part) >= 0 && sel_part.nhits > 0) {
+            if (memcmp(sel_part.coords, sel.coords + nfetched * sel.ndim,
+                       sel_part.nhits * sel.ndim * sizeof(uint64_t)) != 0) {
+                printf("Cursor hits differ from the selection at hit %" PRIu64 "\n", nfetched);
+                ret_value = 1;
+                break;
+            }
+            nfetched += sel_part.nhits;
+        }
+        if (ret_value == 0 && nfetched != sel.nhits) {
+            printf("Cursor fetched %" PRIu64 " of %" PRIu64 " hits\n", nfetched, sel.nhits);
+            ret_value = 1;
+        }
+        PDCquery_cursor_close(&cursor);
+    }
+    PDCselection_free(&sel_part);
+
+    // The values at the hits reduced on the servers
+    if (PDCquery_get_aggregate(q, obj_id, &agg) < 0 || agg.count != sel.nhits) {
+        printf("Fail to get query aggregate @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    else if (agg.count > 0 && (agg.max >= hi2 || agg.mean < agg.min || agg.mean > agg.max)) {
+        printf("Aggregate min %.1f max %.1f mean %.1f out of the queried ranges\n", agg.min, agg.max,
+               agg.mean);
+        ret_value = 1;
+    }
+    PDCquery_agg_free(&agg);
+
     PDCquery_free_all(q);
     PDCregion_free(&region);
     PDCselection_free(&sel);
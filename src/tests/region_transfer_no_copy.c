@@ -0,0 +1,234 @@
+/*
+ * Copyright Notice for
+ * Proactive Data Containers (PDC) Software Library and Utilities
+ * -----------------------------------------------------------------------------
+
+ *** Copyright Notice ***
+
+ * Proactive Data Containers (PDC) Copyright (c) 2017, The Regents of the
+ * University of California, through Lawrence Berkeley National Laboratory,
+ * UChicago Argonne, LLC, operator of Argonne National Laboratory, and The HDF
+ * Group (subject to receipt of any required approvals from the U.S. Dept. of
+ * Energy).  All rights reserved.
+
+ * If you have questions about your rights to use or distribute this software,
+ * please contact Berkeley Lab's Innovation & Partnerships Office at  IPO@lbl.gov.
+
+ * NOTICE.  This Software was developed under funding from the U.S. Department of
+ * Energy and the U.S. Government consequently retains certain rights. As such, the
+ * U.S. Government has been granted for itself and others acting on its behalf a
+ * paid-up, nonexclusive, irrevocable, worldwide license in the Software to
+ * reproduce, distribute copies to the public, prepare derivative works, and
+ * perform publicly and display publicly, and to permit other to do so.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "pdc.h"
+
+/*
+ * Write 2D and 3D objects and read them back, with local regions that are contiguous in the user buffer, so
+ * they are sent and received without being packed into a temporary buffer. Every object is a whole object
+ * region, either from the whole buffer or from a slab of rows in the middle of a buffer twice as large.
+ * Objects of at least 64 KiB and small ones are interleaved, so the batch of start_all is sent in several
+ * segments, some of them straight from the user buffers.
+ */
+
+#define OBJ_NUM 8
+
+typedef struct shape_t {
+    int      ndim;
+    uint64_t dims[3];
+    int      slab;
+} shape_t;
+
+static shape_t shapes[OBJ_NUM] = {
+    {2, {64, 512, 1}, 0},  // 128 KiB
+    {2, {8, 16, 1}, 0},    // 512 bytes
+    {3, {16, 16, 128}, 0}, // 128 KiB
+    {3, {4, 4, 4}, 0},     // 256 bytes
+    {2, {64, 512, 1}, 1},  // 128 KiB from a slab
+    {3, {4, 8, 8}, 1},     // 1 KiB from a slab
+    {3, {32, 16, 64}, 1},  // 128 KiB from a slab
+    {2, {128, 128, 1}, 0}  // 64 KiB
+};
+
+// Number of elements of the user buffer of an object, a slab is taken from a buffer with twice the rows
+static uint64_t
+buffer_len(shape_t *shape)
+{
+    uint64_t len = shape->dims[0] * shape->dims[1] * shape->dims[2];
+
+    return shape->slab ? 2 * len : len;
+}
+
+// Create the local region of an object in its buffer and the region of the whole object
+static void
+create_regions(shape_t *shape, pdcid_t *reg, pdcid_t *reg_global)
+{
+    uint64_t offset[3] = {0, 0, 0}, local_offset[3] = {0, 0, 0};
+
+    // A slab covers whole rows, it stays contiguous in the buffer
+    if (shape->slab)
+        local_offset[0] = shape->dims[0] / 2;
+    *reg        = PDCregion_create(shape->ndim, local_offset, shape->dims);
+    *reg_global = PDCregion_create(shape->ndim, offset, shape->dims);
+}
+
+// Start and wait for all requests of a batch
+static int
+run_batch(pdcid_t *transfer_request)
+{
+    int i, ret_value = 0;
+
+    if (PDCregion_transfer_start_all(transfer_request, OBJ_NUM) != SUCCEED) {
+        printf("Fail to region transfer start @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    if (PDCregion_transfer_wait_all(transfer_request, OBJ_NUM) != SUCCEED) {
+        printf("Fail to region transfer wait @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    for (i = 0; i < OBJ_NUM; ++i) {
+        if (PDCregion_transfer_close(transfer_request[i]) != SUCCEED) {
+            printf("Fail to region transfer close @ line %d\n", __LINE__);
+            ret_value = 1;
+        }
+    }
+    return ret_value;
+}
+
+int
+main(int argc, char **argv)
+{
+    pdcid_t  pdc, cont_prop, cont, obj_prop;
+    pdcid_t  obj[OBJ_NUM], reg[OBJ_NUM], reg_global[OBJ_NUM], transfer_request[OBJ_NUM];
+    char     cont_name[128], obj_name[128];
+    int *    data[OBJ_NUM], *data_read[OBJ_NUM];
+    uint64_t k, len, begin, end;
+    int      rank = 0, i, ret_value = 0;
+
+#ifdef ENABLE_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+
+    // create a pdc
+    pdc = PDCinit("pdc");
+
+    // create a container property
+    cont_prop = PDCprop_create(PDC_CONT_CREATE, pdc);
+    if (cont_prop <= 0) {
+        printf("Fail to create container property @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    // create a container
+    sprintf(cont_name, "c%d", rank);
+    cont = PDCcont_create(cont_name, cont_prop);
+    if (cont <= 0) {
+        printf("Fail to create container @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    // create an object property
+    obj_prop = PDCprop_create(PDC_OBJ_CREATE, pdc);
+    if (obj_prop <= 0) {
+        printf("Fail to create object property @ line  %d!\n", __LINE__);
+        ret_value = 1;
+    }
+    if (PDCprop_set_obj_type(obj_prop, PDC_INT) != SUCCEED) {
+        printf("Fail to set obj type @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    PDCprop_set_obj_user_id(obj_prop, getuid());
+    PDCprop_set_obj_time_step(obj_prop, 0);
+    PDCprop_set_obj_app_name(obj_prop, "DataServerTest");
+    PDCprop_set_obj_tags(obj_prop, "tag0=1");
+    PDCprop_set_obj_transfer_region_type(obj_prop, PDC_REGION_STATIC);
+
+    for (i = 0; i < OBJ_NUM; ++i) {
+        // The dimensions are copied when the object is created
+        PDCprop_set_obj_dims(obj_prop, shapes[i].ndim, shapes[i].dims);
+        sprintf(obj_name, "o%d_%d", i, rank);
+        obj[i] = PDCobj_create(cont, obj_name, obj_prop);
+        if (obj[i] <= 0) {
+            printf("Fail to create object @ line  %d!\n", __LINE__);
+            ret_value = 1;
+        }
+
+        len          = buffer_len(&shapes[i]);
+        data[i]      = (int *)malloc(sizeof(int) * len);
+        data_read[i] = (int *)malloc(sizeof(int) * len);
+        for (k = 0; k < len; ++k) {
+            data[i][k]      = i * 1000000 + (int)k;
+            data_read[i][k] = -1;
+        }
+    }
+
+    for (i = 0; i < OBJ_NUM; ++i) {
+        create_regions(&shapes[i], &reg[i], &reg_global[i]);
+        transfer_request[i] = PDCregion_transfer_create(data[i], PDC_WRITE, obj[i], reg[i], reg_global[i]);
+    }
+    if (run_batch(transfer_request) != 0)
+        ret_value = 1;
+
+    for (i = 0; i < OBJ_NUM; ++i)
+        transfer_request[i] =
+            PDCregion_transfer_create(data_read[i], PDC_READ, obj[i], reg[i], reg_global[i]);
+    if (run_batch(transfer_request) != 0)
+        ret_value = 1;
+
+    // The local region has the written values, the rest of the buffer is untouched
+    for (i = 0; i < OBJ_NUM; ++i) {
+        len   = buffer_len(&shapes[i]);
+        begin = shapes[i].slab ? len / 4 : 0;
+        end   = shapes[i].slab ? len / 4 * 3 : len;
+        for (k = 0; k < len; ++k) {
+            if (data_read[i][k] != (k >= begin && k < end ? data[i][k] : -1)) {
+                printf("wrong value %d at %" PRIu64 " of object %d @ line %d\n", data_read[i][k], k, i,
+                       __LINE__);
+                ret_value = 1;
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < OBJ_NUM; ++i) {
+        if (PDCregion_close(reg[i]) < 0 || PDCregion_close(reg_global[i]) < 0) {
+            printf("fail to close region @ line %d\n", __LINE__);
+            ret_value = 1;
+        }
+        if (PDCobj_close(obj[i]) < 0) {
+            printf("fail to close object @ line %d\n", __LINE__);
+            ret_value = 1;
+        }
+        free(data[i]);
+        free(data_read[i]);
+    }
+    // close a container
+    if (PDCcont_close(cont) < 0) {
+        printf("fail to close container c1 @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    // close a object property
+    if (PDCprop_close(obj_prop) < 0) {
+        printf("Fail to close property @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    // close a container property
+    if (PDCprop_close(cont_prop) < 0) {
+        printf("Fail to close property @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+    // close pdc
+    if (PDCclose(pdc) < 0) {
+        printf("fail to close PDC @ line %d\n", __LINE__);
+        ret_value = 1;
+    }
+#ifdef ENABLE_MPI
+    MPI_Finalize();
+#endif
+    return ret_value;
+}
@@ -13,13 +13,12 @@ if [ $# -lt 1 ]; then echo "missing test argument" && exit -1 ; fi
 # check the test to be run:
 # test_exe="$1"
 # shift
-# copy the remaining test input arguments (if any)
-test_args="$*"
+# each argument is one test command line, e.g. "./checkpoint_restart_bench create"
 rm -rf pdc_data pdc_tmp
 # if [ -x $test_exe ]; then echo "testing: $test_exe"; else echo "test: $test_exe not found or not and executable" && exit -2; fi
 # RUN the actual test(s)
 restart=" "
-for test_exe in $test_args
+for test_exe in "$@"
 do
     # START the server (in the background)
     echo "$run_cmd ./pdc_server.exe $restart &"
@@ -32,6 +31,8 @@ do
     # and shutdown the SERVER before exiting
     echo "$run_cmd ./close_server"
     $run_cmd ./close_server
+    # a failed run leaves nothing for the next one to check
+    if [ "$ret" -ne 0 ]; then exit $ret; fi
     restart="restart"
 done
 exit $ret
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Run a query test against a server without and then with bitmap indexes (PDC_GEN_BITMAP_IDX and
+# PDC_USE_BITMAP_IDX). The test writes the coordinates of its hits to the file given as its last argument,
+# both runs must find the same hits.
+
+# Cori CI needs srun even for serial tests
+run_cmd=""
+if [[ "$NERSC_HOST" == "perlmutter" ]]; then
+    run_cmd="srun -n 1 --mem=25600 --cpu_bind=cores --overlap"
+fi
+
+if [ $# -lt 1 ]; then echo "missing test argument" && exit -1 ; fi
+# check the test to be run:
+test_exe="$1"
+shift
+# copy the remaining test input arguments (if any)
+test_args="$*"
+if [ -x $test_exe ]; then echo "testing: $test_exe"; else echo "test: $test_exe not found or not and executable" && exit -2; fi
+ret=0
+for use_idx in 0 1
+do
+    rm -rf pdc_tmp pdc_data sel_idx$use_idx.txt
+    if [ $use_idx -eq 1 ]; then
+        export PDC_GEN_BITMAP_IDX=1
+        export PDC_USE_BITMAP_IDX=1
+    fi
+    # START the server (in the background)
+    echo "PDC_GEN_BITMAP_IDX=$PDC_GEN_BITMAP_IDX PDC_USE_BITMAP_IDX=$PDC_USE_BITMAP_IDX $run_cmd ./pdc_server.exe &"
+    $run_cmd ./pdc_server.exe &
+    # WAIT a bit...
+    sleep 1
+    echo "$run_cmd $test_exe $test_args sel_idx$use_idx.txt"
+    $run_cmd $test_exe $test_args sel_idx$use_idx.txt
+    if [ $? -ne 0 ]; then ret=1; fi
+    # and shutdown the SERVER
+    $run_cmd ./close_server
+done
+if [ $ret -eq 0 ] && ! cmp -s sel_idx0.txt sel_idx1.txt; then
+    echo "hits with and without bitmap indexes differ"
+    ret=1
+fi
+exit $ret
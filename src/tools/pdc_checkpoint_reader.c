@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pdc_checkpoint_reader.h"
+#include "../src/server/include/pdc_server_metadata.h"
+#include "../src/server/include/pdc_server_checkpoint.h"
+
+pdc_obj_metadata_pkg *
+do_transfer_request_metadata(int pdc_server_size_input, char *checkpoint)
+{
+    char *ptr;
+    int   n_objs, reg_count;
+    int   i, j;
+
+    pdc_obj_metadata_pkg *  metadata_server_objs     = NULL;
+    pdc_obj_metadata_pkg *  metadata_server_objs_end = NULL;
+    pdc_metadata_query_buf *metadata_query_buf_head  = NULL;
+    pdc_metadata_query_buf *metadata_query_buf_end   = NULL;
+    int                     pdc_server_size          = pdc_server_size_input;
+    uint64_t *              data_server_bytes        = (uint64_t *)calloc(pdc_server_size, sizeof(uint64_t));
+    uint64_t                query_id_g               = 100000;
+    ptr                                              = checkpoint;
+
+    if (checkpoint) {
+        n_objs = *(int *)ptr;
+        ptr += sizeof(int);
+        for (i = 0; i < n_objs; ++i) {
+            if (metadata_server_objs) {
+                metadata_server_objs_end->next =
+                    (pdc_obj_metadata_pkg *)malloc(sizeof(pdc_obj_region_metadata));
+                metadata_server_objs_end = metadata_server_objs_end->next;
+            }
+            else {
+                metadata_server_objs     = (pdc_obj_metadata_pkg *)malloc(sizeof(pdc_obj_region_metadata));
+                metadata_server_objs_end = metadata_server_objs;
+            }
+
+            metadata_server_objs_end->obj_id = *(uint64_t *)ptr;
+            ptr += sizeof(uint64_t);
+            metadata_server_objs_end->ndim = *(int *)ptr;
+            ptr += sizeof(int);
+            reg_count = *(int *)ptr;
+            ptr += sizeof(int);
+
+            metadata_server_objs_end->regions =
+                (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
+            metadata_server_objs_end->regions_end = metadata_server_objs_end->regions;
+
+            metadata_server_objs_end->regions_end->next = NULL;
+            metadata_server_objs_end->regions_end->reg_offset =
+                (uint64_t *)malloc(sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
+            metadata_server_objs_end->regions_end->reg_size =
+                metadata_server_objs_end->regions_end->reg_offset + metadata_server_objs_end->ndim;
+            metadata_server_objs_end->regions_end->data_server_id = *(uint32_t *)ptr;
+            ptr += sizeof(uint32_t);
+            memcpy(metadata_server_objs_end->regions_end->reg_offset, ptr,
+                   sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
+            ptr += sizeof(uint64_t) * metadata_server_objs_end->ndim * 2;
+
+            for (j = 1; j < reg_count; ++j) {
+                metadata_server_objs_end->regions_end->next =
+                    (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
+                metadata_server_objs_end->regions_end = metadata_server_objs_end->regions_end->next;
+
+                metadata_server_objs_end->regions_end->next = NULL;
+                metadata_server_objs_end->regions_end->reg_offset =
+                    (uint64_t *)malloc(sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
+                metadata_server_objs_end->regions_end->reg_size =
+                    metadata_server_objs_end->regions_end->reg_offset + metadata_server_objs_end->ndim;
+                metadata_server_objs_end->regions_end->data_server_id = *(uint32_t *)ptr;
+                ptr += sizeof(uint32_t);
+                memcpy(metadata_server_objs_end->regions_end->reg_offset, ptr,
+                       sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
+                ptr += sizeof(uint64_t) * metadata_server_objs_end->ndim * 2;
+            }
+        }
+    }
+    return metadata_server_objs;
+}
+
+MetadataNode *
+insert_metadata_node(MetadataNode *metadata_head, pdc_metadata_t *metadata)
+{
+    MetadataNode *new_node     = (MetadataNode *)malloc(sizeof(MetadataNode));
+    MetadataNode *cur_iter_node, *prev_node = NULL;
+
+    new_node->metadata_ptr     = metadata;
+    new_node->next             = NULL;
+    new_node->region_list_head = NULL;
+    new_node->obj_metadata_pkg = NULL;
+
+    cur_iter_node = metadata_head;
+    while (cur_iter_node != NULL && cur_iter_node->metadata_ptr->obj_id <= metadata->obj_id) {
+        prev_node     = cur_iter_node;
+        cur_iter_node = cur_iter_node->next;
+    }
+    new_node->next = cur_iter_node;
+    if (prev_node == NULL)
+        return new_node;
+    prev_node->next = new_node;
+    return metadata_head;
+}
+
+void
+attach_transfer_metadata(MetadataNode *metadata_head, char *checkpoint_buf)
+{
+    pdc_obj_metadata_pkg *metadata_server_objs =
+        do_transfer_request_metadata(pdc_server_size_g, checkpoint_buf);
+
+    pdc_obj_metadata_pkg *cur_pkg = metadata_server_objs;
+    while (cur_pkg != NULL) {
+        uint64_t      wanted_obj_id     = cur_pkg->obj_id;
+        MetadataNode *cur_metadata_node = metadata_head;
+        while (cur_metadata_node != NULL) {
+            if (cur_metadata_node->metadata_ptr->obj_id == wanted_obj_id) {
+                cur_metadata_node->obj_metadata_pkg = cur_pkg;
+                break;
+            }
+            cur_metadata_node = cur_metadata_node->next;
+        }
+        cur_pkg = cur_pkg->next;
+    }
+}
+
+/*
+ * Copy a string of the checkpoint pool to a fixed-size buffer
+ */
+static void
+copy_pool_str(const char *pool, uint64_t pool_size, uint64_t off, char *dst, size_t dst_size)
+{
+    size_t len = 0;
+
+    if (off < pool_size) {
+        len = strnlen(pool + off, pool_size - off);
+        if (len >= dst_size)
+            len = dst_size - 1;
+        memcpy(dst, pool + off, len);
+    }
+    dst[len] = '\0';
+}
+
+int
+read_versioned_checkpoint(const char *filename, MetadataNode **metadata_head, int *n_cont, int *n_obj,
+                          int *n_region)
+{
+    pdc_checkpoint_header_t    header;
+    pdc_checkpoint_obj_t *     obj;
+    pdc_checkpoint_region_t *  region;
+    pdc_checkpoint_data_obj_t *data_obj;
+    pdc_metadata_t *           metadata;
+    char *                     buf;
+    uint64_t                   i, j, k, size;
+    FILE *                     file;
+
+    *n_cont   = 0;
+    *n_obj    = 0;
+    *n_region = 0;
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+        return 0;
+    if (fread(&header, PDC_CHECKPOINT_HEADER_SIZE_V1, 1, file) != 1 ||
+        memcmp(header.magic, PDC_CHECKPOINT_MAGIC, sizeof(PDC_CHECKPOINT_MAGIC)) != 0) {
+        fclose(file);
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size = (uint64_t)ftell(file);
+    buf  = (char *)malloc(size);
+    rewind(file);
+    if (fread(buf, size, 1, file) != 1 || header.obj_off + header.n_obj * sizeof(*obj) > size ||
+        header.region_off + header.n_region * sizeof(*region) > size ||
+        header.data_obj_off + header.n_data_obj * sizeof(*data_obj) > size ||
+        header.pool_off + header.pool_size > size || header.transfer_off + header.transfer_size > size) {
+        printf("==PDC_SERVER[%d]: %s -  Checkpoint file [%s] is truncated!\n", pdc_server_rank_g, __func__,
+               filename);
+        fclose(file);
+        free(buf);
+        return 1;
+    }
+    fclose(file);
+
+    obj      = (pdc_checkpoint_obj_t *)(buf + header.obj_off);
+    region   = (pdc_checkpoint_region_t *)(buf + header.region_off);
+    data_obj = (pdc_checkpoint_data_obj_t *)(buf + header.data_obj_off);
+
+    metadata = (pdc_metadata_t *)calloc(header.n_obj, sizeof(pdc_metadata_t));
+    for (i = 0; i < header.n_obj; i++) {
+        metadata[i].obj_id             = obj[i].obj_id;
+        metadata[i].cont_id            = obj[i].cont_id;
+        metadata[i].create_time        = (time_t)obj[i].create_time;
+        metadata[i].last_modified_time = (time_t)obj[i].last_modified_time;
+        metadata[i].user_id            = obj[i].user_id;
+        metadata[i].time_step          = obj[i].time_step;
+        metadata[i].data_type          = (pdc_var_type_t)obj[i].data_type;
+        metadata[i].data_server_id     = obj[i].data_server_id;
+        metadata[i].region_partition   = obj[i].region_partition;
+        metadata[i].consistency        = obj[i].consistency;
+        metadata[i].transform_state    = obj[i].transform_state;
+        metadata[i].current_state      = obj[i].current_state;
+        metadata[i].ndim               = obj[i].ndim > DIM_MAX ? DIM_MAX : obj[i].ndim;
+        for (j = 0; j < metadata[i].ndim; j++)
+            metadata[i].dims[j] = obj[i].dims[j];
+        copy_pool_str(buf + header.pool_off, header.pool_size, obj[i].app_name, metadata[i].app_name,
+                      OBJ_NAME_MAX);
+        copy_pool_str(buf + header.pool_off, header.pool_size, obj[i].obj_name, metadata[i].obj_name,
+                      OBJ_NAME_MAX);
+        copy_pool_str(buf + header.pool_off, header.pool_size, obj[i].tags, metadata[i].tags, TAG_LEN_MAX);
+        copy_pool_str(buf + header.pool_off, header.pool_size, obj[i].data_location,
+                      metadata[i].data_location, ADDR_MAX);
+        *metadata_head = insert_metadata_node(*metadata_head, metadata + i);
+        *n_region += obj[i].n_region;
+    }
+    *n_obj  = (int)header.n_obj;
+    *n_cont = (int)header.n_cont;
+
+    for (i = 0; i < header.n_data_obj; i++) {
+        MetadataNode *wanted_node = *metadata_head;
+        while (wanted_node != NULL && wanted_node->metadata_ptr->obj_id != data_obj[i].obj_id)
+            wanted_node = wanted_node->next;
+        if (wanted_node == NULL || data_obj[i].first_region > header.n_region ||
+            data_obj[i].n_region > header.n_region - data_obj[i].first_region)
+            continue;
+
+        RegionNode *cur_region = wanted_node->region_list_head;
+        while (cur_region != NULL && cur_region->next != NULL)
+            cur_region = cur_region->next;
+        for (j = 0; j < data_obj[i].n_region; j++) {
+            pdc_checkpoint_region_t *rec             = region + data_obj[i].first_region + j;
+            region_list_t *          new_region_list = (region_list_t *)calloc(1, sizeof(region_list_t));
+            new_region_list->ndim                    = rec->ndim > DIM_MAX ? DIM_MAX : rec->ndim;
+            for (k = 0; k < new_region_list->ndim; k++) {
+                new_region_list->start[k] = rec->start[k];
+                new_region_list->count[k] = rec->count[k];
+            }
+            new_region_list->data_size     = rec->data_size;
+            new_region_list->unit_size     = rec->unit_size;
+            new_region_list->offset        = rec->offset;
+            new_region_list->obj_id        = data_obj[i].obj_id;
+            new_region_list->data_loc_type = (_pdc_data_loc_t)rec->data_loc_type;
+            copy_pool_str(buf + header.pool_off, header.pool_size, rec->storage_location,
+                          new_region_list->storage_location, ADDR_MAX);
+
+            RegionNode *new_node  = (RegionNode *)malloc(sizeof(RegionNode));
+            new_node->region_list = new_region_list;
+            new_node->next        = NULL;
+            if (cur_region == NULL)
+                wanted_node->region_list_head = new_node;
+            else
+                cur_region->next = new_node;
+            cur_region = new_node;
+        }
+    }
+
+    if (header.transfer_size > 0)
+        attach_transfer_metadata(*metadata_head, buf + header.transfer_off);
+
+    free(buf);
+    return 1;
+}
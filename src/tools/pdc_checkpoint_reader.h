@@ -0,0 +1,92 @@
+#ifndef PDC_CHECKPOINT_READER_H
+#define PDC_CHECKPOINT_READER_H
+
+#include "pdc_client_server_common.h"
+
+/*
+ * Reader of server checkpoint files shared by pdc_ls and pdc_export
+ */
+
+typedef struct pdc_region_metadata_pkg {
+    uint64_t *                      reg_offset;
+    uint64_t *                      reg_size;
+    uint32_t                        data_server_id;
+    struct pdc_region_metadata_pkg *next;
+} pdc_region_metadata_pkg;
+
+typedef struct pdc_obj_metadata_pkg {
+    int                          ndim;
+    uint64_t                     obj_id;
+    pdc_region_metadata_pkg *    regions;
+    pdc_region_metadata_pkg *    regions_end;
+    struct pdc_obj_metadata_pkg *next;
+} pdc_obj_metadata_pkg;
+
+typedef struct pdc_obj_region_metadata {
+    uint64_t  obj_id;
+    uint64_t *reg_offset;
+    uint64_t *reg_size;
+    int       ndim;
+} pdc_obj_region_metadata;
+
+typedef struct pdc_metadata_query_buf {
+    uint64_t                       id;
+    char *                         buf;
+    struct pdc_metadata_query_buf *next;
+} pdc_metadata_query_buf;
+
+typedef struct RegionNode {
+    region_list_t *    region_list;
+    struct RegionNode *next;
+} RegionNode;
+
+typedef struct MetadataNode {
+    pdc_metadata_t *      metadata_ptr;
+    struct MetadataNode * next;
+    RegionNode *          region_list_head;
+    pdc_obj_metadata_pkg *obj_metadata_pkg;
+} MetadataNode;
+
+/**
+ * Parse the region transfer metadata section of a checkpoint
+ *
+ * \param pdc_server_size_input [IN] Number of servers
+ * \param checkpoint [IN]            Start of the section
+ *
+ * \return List of the objects and their regions
+ */
+pdc_obj_metadata_pkg *do_transfer_request_metadata(int pdc_server_size_input, char *checkpoint);
+
+/**
+ * Insert an object in a list sorted by object ID
+ *
+ * \param metadata_head [IN]         Head of the list, may be NULL
+ * \param metadata [IN]              Object to insert, not copied
+ *
+ * \return New head of the list
+ */
+MetadataNode *insert_metadata_node(MetadataNode *metadata_head, pdc_metadata_t *metadata);
+
+/**
+ * Attach the region transfer metadata of a checkpoint to the objects of a list
+ *
+ * \param metadata_head [IN]         Head of the list
+ * \param checkpoint_buf [IN]        Start of the region transfer metadata section
+ */
+void attach_transfer_metadata(MetadataNode *metadata_head, char *checkpoint_buf);
+
+/**
+ * Read a checkpoint written with the versioned layout of pdc_server_checkpoint.h
+ *
+ * \param filename [IN]              Checkpoint file name
+ * \param metadata_head [IN/OUT]     Head of the list the objects are inserted in
+ * \param n_cont [OUT]               Number of containers
+ * \param n_obj [OUT]                Number of objects
+ * \param n_region [OUT]             Number of regions
+ *
+ * \return 1 if the file has the versioned layout, 0 if it has the legacy one
+ */
+int read_versioned_checkpoint(const char *filename, MetadataNode **metadata_head, int *n_cont, int *n_obj,
+                              int *n_region);
+
+#endif /* PDC_CHECKPOINT_READER_H */
@@ -10,51 +10,13 @@
 #include "pdc.h"
 #include "pdc_client_server_common.h"
 #include "../src/server/include/pdc_server_metadata.h"
+#include "../src/server/include/pdc_server_checkpoint.h"
 #include "cjson/cJSON.h"
+#include "pdc_checkpoint_reader.h"
 
 const char *avail_args[] = {"-n", "-i", "-json", "-ln", "-li", "-s"};
 const int   num_args     = 6;
 
-typedef struct pdc_region_metadata_pkg {
-    uint64_t *                      reg_offset;
-    uint64_t *                      reg_size;
-    uint32_t                        data_server_id;
-    struct pdc_region_metadata_pkg *next;
-} pdc_region_metadata_pkg;
-
-typedef struct pdc_obj_metadata_pkg {
-    int                          ndim;
-    uint64_t                     obj_id;
-    pdc_region_metadata_pkg *    regions;
-    pdc_region_metadata_pkg *    regions_end;
-    struct pdc_obj_metadata_pkg *next;
-} pdc_obj_metadata_pkg;
-
-typedef struct pdc_obj_region_metadata {
-    uint64_t  obj_id;
-    uint64_t *reg_offset;
-    uint64_t *reg_size;
-    int       ndim;
-} pdc_obj_region_metadata;
-
-typedef struct pdc_metadata_query_buf {
-    uint64_t                       id;
-    char *                         buf;
-    struct pdc_metadata_query_buf *next;
-} pdc_metadata_query_buf;
-
-typedef struct RegionNode {
-    region_list_t *    region_list;
-    struct RegionNode *next;
-} RegionNode;
-
-typedef struct MetadataNode {
-    pdc_metadata_t *      metadata_ptr;
-    struct MetadataNode * next;
-    RegionNode *          region_list_head;
-    pdc_obj_metadata_pkg *obj_metadata_pkg;
-} MetadataNode;
-
 typedef struct FileNameNode {
     char *               file_name;
     struct FileNameNode *next;
@@ -293,79 +255,6 @@ get_data_loc_type(int data_loc_type)
     }
 }
 
-pdc_obj_metadata_pkg *
-do_transfer_request_metadata(int pdc_server_size_input, char *checkpoint)
-{
-    char *ptr;
-    int   n_objs, reg_count;
-    int   i, j;
-
-    pdc_obj_metadata_pkg *  metadata_server_objs     = NULL;
-    pdc_obj_metadata_pkg *  metadata_server_objs_end = NULL;
-    pdc_metadata_query_buf *metadata_query_buf_head  = NULL;
-    pdc_metadata_query_buf *metadata_query_buf_end   = NULL;
-    int                     pdc_server_size          = pdc_server_size_input;
-    uint64_t *              data_server_bytes        = (uint64_t *)calloc(pdc_server_size, sizeof(uint64_t));
-    uint64_t                query_id_g               = 100000;
-    ptr                                              = checkpoint;
-
-    if (checkpoint) {
-        n_objs = *(int *)ptr;
-        ptr += sizeof(int);
-        for (i = 0; i < n_objs; ++i) {
-            if (metadata_server_objs) {
-                metadata_server_objs_end->next =
-                    (pdc_obj_metadata_pkg *)malloc(sizeof(pdc_obj_region_metadata));
-                metadata_server_objs_end = metadata_server_objs_end->next;
-            }
-            else {
-                metadata_server_objs     = (pdc_obj_metadata_pkg *)malloc(sizeof(pdc_obj_region_metadata));
-                metadata_server_objs_end = metadata_server_objs;
-            }
-
-            metadata_server_objs_end->obj_id = *(uint64_t *)ptr;
-            ptr += sizeof(uint64_t);
-            metadata_server_objs_end->ndim = *(int *)ptr;
-            ptr += sizeof(int);
-            reg_count = *(int *)ptr;
-            ptr += sizeof(int);
-
-            metadata_server_objs_end->regions =
-                (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
-            metadata_server_objs_end->regions_end = metadata_server_objs_end->regions;
-
-            metadata_server_objs_end->regions_end->next = NULL;
-            metadata_server_objs_end->regions_end->reg_offset =
-                (uint64_t *)malloc(sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
-            metadata_server_objs_end->regions_end->reg_size =
-                metadata_server_objs_end->regions_end->reg_offset + metadata_server_objs_end->ndim;
-            metadata_server_objs_end->regions_end->data_server_id = *(uint32_t *)ptr;
-            ptr += sizeof(uint32_t);
-            memcpy(metadata_server_objs_end->regions_end->reg_offset, ptr,
-                   sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
-            ptr += sizeof(uint64_t) * metadata_server_objs_end->ndim * 2;
-
-            for (j = 1; j < reg_count; ++j) {
-                metadata_server_objs_end->regions->next =
-                    (pdc_region_metadata_pkg *)malloc(sizeof(pdc_region_metadata_pkg));
-                metadata_server_objs_end->regions_end = metadata_server_objs_end->regions_end->next;
-
-                metadata_server_objs_end->regions_end->next = NULL;
-                metadata_server_objs_end->regions_end->reg_offset =
-                    (uint64_t *)malloc(sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
-                metadata_server_objs_end->regions_end->reg_size =
-                    metadata_server_objs_end->regions_end->reg_offset + metadata_server_objs_end->ndim;
-                metadata_server_objs_end->regions_end->data_server_id = *(uint32_t *)ptr;
-                ptr += sizeof(uint32_t);
-                memcpy(metadata_server_objs_end->regions_end->reg_offset, ptr,
-                       sizeof(uint64_t) * metadata_server_objs_end->ndim * 2);
-                ptr += sizeof(uint64_t) * metadata_server_objs_end->ndim * 2;
-            }
-        }
-    }
-    return metadata_server_objs;
-}
-
 void
 pdc_ls(FileNameNode *file_name_node, int argc, char *argv[])
 {
@@ -446,6 +335,14 @@ pdc_ls(FileNameNode *file_name_node, int argc, char *argv[])
         pdc_cont_hash_table_entry_t *cont_entry;
         pdc_hash_table_entry_head *  entry;
 
+        if (read_versioned_checkpoint(filename, &metadata_head, &all_cont, &nobj, &total_region)) {
+            all_cont_total += all_cont;
+            all_nobj_total += nobj;
+            all_n_region_total += total_region;
+            cur_file_node = cur_file_node->next;
+            continue;
+        }
+
         FILE *file = fopen(filename, "r");
         if (file == NULL) {
             printf("==PDC_SERVER[%d]: %s -  Checkpoint file open FAILED [%s]!", pdc_server_rank_g, __func__,
@@ -493,7 +390,6 @@ pdc_ls(FileNameNode *file_name_node, int argc, char *argv[])
             // Reconstruct hash table
             entry           = (pdc_hash_table_entry_head *)malloc(sizeof(pdc_hash_table_entry_head));
             entry->n_obj    = 0;
-            entry->bloom    = NULL;
             entry->metadata = NULL;
 
             /* fprintf(stderr, "size of metadata: %lu\n", sizeof(pdc_metadata_t)); */
@@ -502,39 +398,7 @@ pdc_ls(FileNameNode *file_name_node, int argc, char *argv[])
                 if (fread(metadata + i, sizeof(pdc_metadata_t), 1, file) != 1) {
                     printf("Read failed for metadata\n");
                 }
-                MetadataNode *new_node     = (MetadataNode *)malloc(sizeof(MetadataNode));
-                new_node->metadata_ptr     = (metadata + i);
-                new_node->next             = NULL;
-                new_node->region_list_head = NULL;
-                if (metadata_head == NULL) {
-                    metadata_head = new_node;
-                }
-                else {
-                    MetadataNode *cur_iter_node = metadata_head;
-                    MetadataNode *prev_node     = NULL;
-                    int           inserted      = 0;
-                    while (cur_iter_node != NULL) {
-                        if (cur_iter_node->metadata_ptr->obj_id > new_node->metadata_ptr->obj_id) {
-                            if (prev_node == NULL) {
-                                new_node->next = metadata_head;
-                                metadata_head  = new_node;
-                                inserted       = 1;
-                                break;
-                            }
-                            else {
-                                new_node->next  = cur_iter_node;
-                                prev_node->next = new_node;
-                                inserted        = 1;
-                                break;
-                            }
-                        }
-                        prev_node     = cur_iter_node;
-                        cur_iter_node = cur_iter_node->next;
-                    }
-                    if (inserted == 0) {
-                        prev_node->next = new_node;
-                    }
-                }
+                metadata_head = insert_metadata_node(metadata_head, metadata + i);
 
                 // Read kv tags
                 if (fread(&n_kvtag, sizeof(int), 1, file) != 1) {
@@ -680,22 +544,7 @@ pdc_ls(FileNameNode *file_name_node, int argc, char *argv[])
             printf("Read failed for checkpoint buf\n");
         }
 
-        pdc_obj_metadata_pkg *metadata_server_objs =
-            do_transfer_request_metadata(pdc_server_size_g, checkpoint_buf);
-
-        pdc_obj_metadata_pkg *cur_pkg = metadata_server_objs;
-        while (cur_pkg != NULL) {
-            uint64_t      wanted_obj_id     = cur_pkg->obj_id;
-            MetadataNode *cur_metadata_node = metadata_head;
-            while (cur_metadata_node != NULL) {
-                if (cur_metadata_node->metadata_ptr->obj_id == wanted_obj_id) {
-                    cur_metadata_node->obj_metadata_pkg = cur_pkg;
-                    break;
-                }
-                cur_metadata_node = cur_metadata_node->next;
-            }
-            cur_pkg = cur_pkg->next;
-        }
+        attach_transfer_metadata(metadata_head, checkpoint_buf);
 
         fclose(file);
         file = NULL;
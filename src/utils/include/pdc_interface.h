@@ -62,14 +62,35 @@ typedef enum {
 /***************************/
 /* Library Private Structs */
 /***************************/
+/*
+ * The IDs of a type are handed out in sequence, so they are indexed by their number in fixed size chunks of
+ * slots. A lookup reads the directory of chunks, the chunk and the slot without taking the lock of the type.
+ */
+#define PDC_ID_CHUNK_BITS 12
+#define PDC_ID_CHUNK_SIZE ((pdcid_t)1 << PDC_ID_CHUNK_BITS)
+
+/* Slots of PDC_ID_CHUNK_SIZE consecutive IDs */
+struct _pdc_id_chunk {
+    unsigned              nlive;                   /* # of IDs of the chunk still registered     */
+    struct _pdc_id_info * slot[PDC_ID_CHUNK_SIZE]; /* NULL for IDs not registered                */
+};
+
+/* Directory of the chunks of a type, replaced by a larger copy when the IDs outgrow it */
+struct _pdc_id_dir {
+    pdcid_t                nchunk; /* # of chunk pointers                        */
+    struct _pdc_id_dir *   prev;   /* Replaced directory, freed with the type    */
+    struct _pdc_id_chunk * chunk[];
+};
+
 /* ID type structure used */
 struct PDC_id_type {
     PDC_free_t free_func; /* Free function for object's of this type    */
     PDC_type_t type_id;   /* Class ID for the type                      */
     //    const                     PDCID_class_t *cls;/* Pointer to ID class                        */
-    unsigned init_count;             /* # of times this type has been initialized  */
-    unsigned id_count;               /* Current number of IDs held                 */
-    pdcid_t  nextid;                 /* ID to use for the next atom                */
+    unsigned            init_count;  /* # of times this type has been initialized  */
+    unsigned            id_count;    /* Current number of IDs held                 */
+    pdcid_t             nextid;      /* ID to use for the next atom                */
+    struct _pdc_id_dir *dir;         /* Index of the IDs by number                 */
     PDC_LIST_HEAD(_pdc_id_info) ids; /* Head of list of IDs                        */
 };
 
@@ -153,7 +174,8 @@ perr_t PDC_id_list_clear(PDC_type_t type);
 perr_t PDC_destroy_type(PDC_type_t type);
 
 /**
- * Given an object ID find the info struct that describes the object
+ * Given an object ID find the info struct that describes the object.
+ * The lookup takes constant time and no lock, the ID must not be released concurrently.
  *
  * \param idid [IN]             ID to look up
  *
@@ -162,7 +184,8 @@ perr_t PDC_destroy_type(PDC_type_t type);
 struct _pdc_id_info *PDC_find_id(pdcid_t idid);
 
 /**
- * Given an object ID find the info struct that describes the object
+ * Given an object ID find the info struct that describes the object.
+ * The lookup takes constant time and no lock, the ID must not be released concurrently.
  *
  * \param type [IN]             A enum type PDC_type_t, e.g. PDC_CONT, PDC_OBJ
  * \param byname [IN]           Name of the object to look up
@@ -28,6 +28,7 @@
 #include "pdc_cont_pkg.h"
 #include "pdc_cont.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 /* Combine a Type number and an atom index into an atom */
@@ -41,12 +42,96 @@
  * and/or increase size of pdcid_t */
 static PDC_type_t PDC_next_type = (PDC_type_t)PDC_NTYPES;
 
+/* Number of chunk pointers of the first directory of a type */
+#define PDC_ID_DIR_INIT_SIZE 16
+
+/*
+ * Set the slot of an ID in the index of its type, called with the lock of the type held.
+ *
+ * Readers do not take the lock, so a directory that is replaced is kept until the type is destroyed, and the
+ * new directory and chunks are published with release stores once they are filled.
+ */
+static perr_t
+PDC_id_index_insert(struct PDC_id_type *type_ptr, struct _pdc_id_info *id_ptr)
+{
+    perr_t                ret_value = SUCCEED;
+    pdcid_t               idx, ci, n;
+    struct _pdc_id_dir *  dir, *new_dir;
+    struct _pdc_id_chunk *chunk;
+
+    FUNC_ENTER(NULL);
+
+    idx = id_ptr->id & ID_MASK;
+    ci  = idx >> PDC_ID_CHUNK_BITS;
+    dir = type_ptr->dir;
+
+    if (dir == NULL || ci >= dir->nchunk) {
+        n = dir == NULL ? PDC_ID_DIR_INIT_SIZE : dir->nchunk;
+        while (n <= ci)
+            n *= 2;
+        new_dir = (struct _pdc_id_dir *)PDC_calloc(1, sizeof(struct _pdc_id_dir) +
+                                                          n * sizeof(struct _pdc_id_chunk *));
+        if (new_dir == NULL)
+            PGOTO_ERROR(FAIL, "ID directory allocation failed");
+        new_dir->nchunk = n;
+        new_dir->prev   = dir;
+        if (dir != NULL)
+            memcpy(new_dir->chunk, dir->chunk, dir->nchunk * sizeof(struct _pdc_id_chunk *));
+        __atomic_store_n(&type_ptr->dir, new_dir, __ATOMIC_RELEASE);
+        dir = new_dir;
+    }
+
+    chunk = dir->chunk[ci];
+    if (chunk == NULL) {
+        if (NULL == (chunk = (struct _pdc_id_chunk *)PDC_calloc(1, sizeof(struct _pdc_id_chunk))))
+            PGOTO_ERROR(FAIL, "ID chunk allocation failed");
+        __atomic_store_n(&dir->chunk[ci], chunk, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&chunk->slot[idx & (PDC_ID_CHUNK_SIZE - 1)], id_ptr, __ATOMIC_RELEASE);
+    chunk->nlive++;
+
+done:
+    FUNC_LEAVE(ret_value);
+}
+
+/*
+ * Clear the slot of an ID in the index of its type, called with the lock of the type held. IDs are never
+ * reused, so a chunk is freed once all of its IDs have been handed out and removed.
+ */
+static void
+PDC_id_index_remove(struct PDC_id_type *type_ptr, pdcid_t id)
+{
+    pdcid_t               idx, ci;
+    struct _pdc_id_dir *  dir;
+    struct _pdc_id_chunk *chunk;
+
+    idx = id & ID_MASK;
+    ci  = idx >> PDC_ID_CHUNK_BITS;
+    dir = type_ptr->dir;
+    if (dir == NULL || ci >= dir->nchunk || (chunk = dir->chunk[ci]) == NULL)
+        return;
+
+    __atomic_store_n(&chunk->slot[idx & (PDC_ID_CHUNK_SIZE - 1)], NULL, __ATOMIC_RELEASE);
+    if (--chunk->nlive == 0 && (ci + 1) * PDC_ID_CHUNK_SIZE <= type_ptr->nextid) {
+        // Older directories share the chunk pointers, clear them all
+        for (; dir != NULL; dir = dir->prev) {
+            if (ci < dir->nchunk)
+                __atomic_store_n(&dir->chunk[ci], NULL, __ATOMIC_RELEASE);
+        }
+        PDC_free(chunk);
+    }
+}
+
 struct _pdc_id_info *
 PDC_find_id(pdcid_t idid)
 {
-    struct _pdc_id_info *ret_value = NULL;
-    PDC_type_t           type;
-    struct PDC_id_type * type_ptr;
+    struct _pdc_id_info * ret_value = NULL;
+    PDC_type_t            type;
+    struct PDC_id_type *  type_ptr;
+    struct _pdc_id_dir *  dir;
+    struct _pdc_id_chunk *chunk;
+    pdcid_t               idx, ci;
 
     FUNC_ENTER(NULL);
 
@@ -60,10 +145,19 @@ PDC_find_id(pdcid_t idid)
         PGOTO_DONE(NULL);
 
     /* Locate the ID node for the ID */
-    PDC_LIST_SEARCH(ret_value, &type_ptr->ids, entry, id, idid);
+    idx = idid & ID_MASK;
+    ci  = idx >> PDC_ID_CHUNK_BITS;
+    dir = __atomic_load_n(&type_ptr->dir, __ATOMIC_ACQUIRE);
+    if (dir == NULL || ci >= dir->nchunk)
+        PGOTO_DONE(NULL);
+    chunk = __atomic_load_n(&dir->chunk[ci], __ATOMIC_ACQUIRE);
+    if (chunk == NULL)
+        PGOTO_DONE(NULL);
+    ret_value = __atomic_load_n(&chunk->slot[idx & (PDC_ID_CHUNK_SIZE - 1)], __ATOMIC_ACQUIRE);
+    if (ret_value != NULL && ret_value->id != idid)
+        ret_value = NULL;
 
 done:
-    fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
 
@@ -95,6 +189,7 @@ PDC_register_type(PDC_type_t type_id, PDC_free_t free_func)
         type_ptr->free_func = free_func;
         type_ptr->id_count  = 0;
         type_ptr->nextid    = 0;
+        type_ptr->dir       = NULL;
         PDC_LIST_INIT(&type_ptr->ids);
     }
     /* Increment the count of the times this type has been initialized */
@@ -131,6 +226,11 @@ PDC_id_register(PDC_type_t type, void *object)
     id_ptr->obj_ptr = object;
 
     /* Insert into the type */
+    if (PDC_id_index_insert(type_ptr, id_ptr) != SUCCEED) {
+        PDC_MUTEX_UNLOCK(type_ptr->ids);
+        PDC_free(id_ptr);
+        PGOTO_ERROR(0, "unable to index ID");
+    }
     PDC_LIST_INSERT_HEAD(&type_ptr->ids, id_ptr, entry);
     type_ptr->id_count++;
     type_ptr->nextid++;
@@ -171,6 +271,7 @@ PDC_dec_ref(pdcid_t id)
 
             PDC_MUTEX_LOCK(type_ptr->ids);
             /* Remove the node from the type */
+            PDC_id_index_remove(type_ptr, id_ptr->id);
             PDC_LIST_REMOVE(id_ptr, entry);
             id_ptr = (struct _pdc_id_info *)(intptr_t)PDC_free(id_ptr);
             /* Decrement the number of IDs in the type */
@@ -183,7 +284,6 @@ PDC_dec_ref(pdcid_t id)
     }
 
 done:
-    fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
 
@@ -227,7 +327,6 @@ PDC_inc_ref(pdcid_t id)
     ret_value = hg_atomic_incr32(&(id_ptr->count));
 
 done:
-    fflush(stdout);
     FUNC_LEAVE(ret_value);
 }
 
@@ -266,6 +365,7 @@ PDC_id_list_clear(PDC_type_t type)
         id_ptr = (&type_ptr->ids)->head;
         if (!type_ptr->free_func || (type_ptr->free_func)((void *)id_ptr->obj_ptr) >= 0) {
             PDC_MUTEX_LOCK(type_ptr->ids);
+            PDC_id_index_remove(type_ptr, id_ptr->id);
             PDC_LIST_REMOVE(id_ptr, entry);
             id_ptr = (struct _pdc_id_info *)(intptr_t)PDC_free(id_ptr);
             (type_ptr->id_count)--;
@@ -283,12 +383,24 @@ PDC_destroy_type(PDC_type_t type)
 {
     perr_t              ret_value = SUCCEED;
     struct PDC_id_type *type_ptr  = NULL;
+    struct _pdc_id_dir *dir, *prev;
+    pdcid_t             i;
 
     FUNC_ENTER(NULL);
 
     type_ptr = (pdc_id_list_g->PDC_id_type_list_g)[type];
     if (type_ptr == NULL)
         PGOTO_ERROR(FAIL, "type was not initialized correctly");
+
+    /* The newest directory holds all the chunks still allocated */
+    if ((dir = type_ptr->dir) != NULL) {
+        for (i = 0; i < dir->nchunk; i++)
+            PDC_free(dir->chunk[i]);
+    }
+    for (; dir != NULL; dir = prev) {
+        prev = dir->prev;
+        PDC_free(dir);
+    }
     type_ptr = (struct PDC_id_type *)(intptr_t)PDC_free(type_ptr);
 
 done: